@@ -28,12 +28,13 @@
 #include "ASyncSerial.h"
 #include "../main/Logger.h"
 #include "../main/Helper.h"
+#include "../main/IoContextPool.h"
+#include "../main/TrafficCapture.h"
 
 #include <string>
 #include <algorithm>
 #include <iostream>
 #include <boost/asio.hpp>
-#include <boost/thread.hpp>
 #include <boost/smart_ptr/shared_array.hpp>  // for shared_array
 #include <boost/system/error_code.hpp>       // for error_code
 #include <boost/system/system_error.hpp>     // for system_error
@@ -49,16 +50,20 @@ class AsyncSerialImpl
 {
 public:
   AsyncSerialImpl()
-	  : io()
-	  , port(io)
+	  : connection("AsyncSerial")
+	  , port(connection.GetIoContext())
+	  , writeDelayTimer(connection.GetIoContext())
   {
   }
 
-    boost::asio::io_service io; ///< Io service object
+    CIoConnection connection; ///< Strand on the shared io_service pool, runs read/write operations
     boost::asio::serial_port port; ///< Serial port object
-    boost::thread backgroundThread; ///< Thread that runs read/write operations
+    boost::asio::deadline_timer writeDelayTimer; ///< Pause after a write burst
+    bool writeDelay{ false };	    ///< True while pausing after a write burst
     bool open{ false };		    ///< True if port open
     bool error{ false };	    ///< Error flag
+    bool replay{ false };	    ///< True if fed by a traffic replay instead of the port
+    std::string source;		    ///< Device name, identifies the port in a capture
     mutable std::mutex errorMutex; ///< Mutex for access to error
 
     /// Data are queued here before they go in writeBuffer
@@ -101,6 +106,12 @@ void AsyncSerial::open(const std::string& devname, unsigned int baud_rate,
 	if (isOpen())
 		close();
 
+	if (m_trafficcapture.IsReplaying())
+	{
+		openReplay(devname);
+		return;
+	}
+
 	setErrorStatus(true); // If an exception is thrown, error_ remains true
 	pimpl->port.open(devname);
 	try {
@@ -117,15 +128,12 @@ void AsyncSerial::open(const std::string& devname, unsigned int baud_rate,
 		throw;
 	}
 
-	pimpl->io.reset();
-
-	// This gives some work to the io_service before it is started
-	pimpl->io.post([this] { return doRead(); });
-
-	boost::thread t([p = &pimpl->io] { p->run(); });
-	pimpl->backgroundThread.swap(t);
+	pimpl->connection.SetName("AsyncSerial " + devname);
+	pimpl->source = devname;
 	setErrorStatus(false); // If we get here, no error
 	pimpl->open = true;    // Port is now open
+
+	pimpl->connection.post([this] { doRead(); });
 }
 
 void AsyncSerial::openOnlyBaud(const std::string& devname, unsigned int baud_rate,
@@ -136,6 +144,12 @@ void AsyncSerial::openOnlyBaud(const std::string& devname, unsigned int baud_rat
 {
 	if(isOpen()) close();
 
+	if (m_trafficcapture.IsReplaying())
+	{
+		openReplay(devname);
+		return;
+	}
+
 	setErrorStatus(true);//If an exception is thrown, error_ remains true
 	pimpl->port.open(devname);
 
@@ -149,15 +163,33 @@ void AsyncSerial::openOnlyBaud(const std::string& devname, unsigned int baud_rat
 		throw;
 	}
 
-	pimpl->io.reset();
-
-	//This gives some work to the io_service before it is started
-	pimpl->io.post([this] { return doRead(); });
-
-	boost::thread t([p = &pimpl->io] { p->run(); });
-	pimpl->backgroundThread.swap(t);
+	pimpl->connection.SetName("AsyncSerial " + devname);
+	pimpl->source = devname;
 	setErrorStatus(false);//If we get here, no error
 	pimpl->open=true; //Port is now open
+
+	pimpl->connection.post([this] { doRead(); });
+}
+
+void AsyncSerial::openReplay(const std::string &devname)
+{
+	pimpl->connection.SetName("AsyncSerial " + devname + " (replay)");
+	pimpl->source = devname;
+	pimpl->replay = true;
+	setErrorStatus(false);
+	pimpl->open = true;
+
+	m_trafficcapture.RegisterReader(TRAFFIC_SERIAL, devname, this, [this](const std::string & /*topic*/, const std::string &data) {
+		auto origin = CTrafficCapture::GetOrigin();
+		pimpl->connection.post([this, data, origin] {
+			if (isOpen() && pimpl->callback)
+			{
+				CTrafficCapture::SetOrigin(origin);
+				pimpl->callback(data.c_str(), data.size());
+				CTrafficCapture::SetOrigin(std::chrono::steady_clock::time_point());
+			}
+		});
+	});
 }
 
 bool AsyncSerial::isOpen() const
@@ -176,9 +208,16 @@ void AsyncSerial::close()
     if(!isOpen()) return;
 
     pimpl->open = false;
-    pimpl->io.post([this] { doClose(); });
-    pimpl->backgroundThread.join();
-    pimpl->io.reset();
+    if (pimpl->replay)
+    {
+        m_trafficcapture.UnregisterReader(this);
+        pimpl->replay = false;
+        pimpl->connection.WaitIdle();
+        return;
+    }
+    pimpl->connection.post([this] { doClose(); });
+    //Wait for the cancelled read/write operations (returns at once when called from one of our handlers)
+    pimpl->connection.WaitIdle();
     if(errorStatus())
     {
         throw(boost::system::system_error(boost::system::error_code(),
@@ -192,7 +231,7 @@ void AsyncSerial::write(const char *data, size_t size)
         std::lock_guard<std::mutex> l(pimpl->writeQueueMutex);
         pimpl->writeQueue.insert(pimpl->writeQueue.end(),data,data+size);
     }
-    pimpl->io.post([this] { doWrite(); });
+    pimpl->connection.post([this] { doWrite(); });
 }
 
 void AsyncSerial::write(const std::string &data)
@@ -201,7 +240,7 @@ void AsyncSerial::write(const std::string &data)
 		std::lock_guard<std::mutex> l(pimpl->writeQueueMutex);
 		pimpl->writeQueue.insert(pimpl->writeQueue.end(), data.c_str(), data.c_str()+data.size());
 	}
-	pimpl->io.post([this] { doWrite(); });
+	pimpl->connection.post([this] { doWrite(); });
 }
 
 void AsyncSerial::write(const std::vector<char>& data)
@@ -211,7 +250,7 @@ void AsyncSerial::write(const std::vector<char>& data)
         pimpl->writeQueue.insert(pimpl->writeQueue.end(),data.begin(),
                 data.end());
     }
-    pimpl->io.post([this] { doWrite(); });
+    pimpl->connection.post([this] { doWrite(); });
 }
 
 void AsyncSerial::writeString(const std::string& s)
@@ -220,13 +259,13 @@ void AsyncSerial::writeString(const std::string& s)
         std::lock_guard<std::mutex> l(pimpl->writeQueueMutex);
         pimpl->writeQueue.insert(pimpl->writeQueue.end(),s.begin(),s.end());
     }
-    pimpl->io.post([this] { doWrite(); });
+    pimpl->connection.post([this] { doWrite(); });
 }
 
 void AsyncSerial::doRead()
 {
 	if(isOpen()==false) return;
-	pimpl->port.async_read_some(boost::asio::buffer(pimpl->readBuffer, sizeof(pimpl->readBuffer)), [this](auto &&err, auto bytes) { readEnd(err, bytes); });
+	pimpl->port.async_read_some(boost::asio::buffer(pimpl->readBuffer, sizeof(pimpl->readBuffer)), pimpl->connection.wrap([this](auto &&err, auto bytes) { readEnd(err, bytes); }));
 }
 
 void AsyncSerial::readEnd(const boost::system::error_code& error,
@@ -242,6 +281,8 @@ void AsyncSerial::readEnd(const boost::system::error_code& error,
         }
         terminate();
     } else {
+        if (m_trafficcapture.IsCapturing())
+            m_trafficcapture.Record(TRAFFIC_SERIAL, pimpl->source, "", (const uint8_t *)pimpl->readBuffer, bytes_transferred);
         if(pimpl->callback) pimpl->callback(pimpl->readBuffer,
                 bytes_transferred);
         doRead();
@@ -250,16 +291,25 @@ void AsyncSerial::readEnd(const boost::system::error_code& error,
 
 void AsyncSerial::doWrite()
 {
-    //If a write operation is already in progress, do nothing
-    if (pimpl->writeBuffer == nullptr)
+    //Nothing is sent during a replay
+    if (pimpl->replay)
+    {
+        std::lock_guard<std::mutex> l(pimpl->writeQueueMutex);
+        pimpl->writeQueue.clear();
+        return;
+    }
+    //If a write operation (or the pause after it) is already in progress, do nothing
+    if ((pimpl->writeBuffer == nullptr) && (!pimpl->writeDelay))
     {
 	    std::lock_guard<std::mutex> l(pimpl->writeQueueMutex);
+	    if (pimpl->writeQueue.empty())
+		    return;
 	    pimpl->writeBufferSize = pimpl->writeQueue.size();
 	    pimpl->writeBuffer.reset(new char[pimpl->writeQueue.size()]);
 
 	    copy(pimpl->writeQueue.begin(), pimpl->writeQueue.end(), pimpl->writeBuffer.get());
 	    pimpl->writeQueue.clear();
-	    async_write(pimpl->port, boost::asio::buffer(pimpl->writeBuffer.get(), pimpl->writeBufferSize), [this](auto &&err, auto) { writeEnd(err); });
+	    async_write(pimpl->port, boost::asio::buffer(pimpl->writeBuffer.get(), pimpl->writeBufferSize), pimpl->connection.wrap([this](auto &&err, auto) { writeEnd(err); }));
     }
 }
 
@@ -272,7 +322,14 @@ void AsyncSerial::writeEnd(const boost::system::error_code& error)
         {
             pimpl->writeBuffer.reset();
             pimpl->writeBufferSize=0;
-            sleep_milliseconds(75);
+            //Pause before the next write without blocking a pool thread
+            pimpl->writeDelay = true;
+            pimpl->writeDelayTimer.expires_from_now(boost::posix_time::milliseconds(75));
+            pimpl->writeDelayTimer.async_wait(pimpl->connection.wrap([this](auto &&) {
+                pimpl->writeDelay = false;
+                if (isOpen())
+                    doWrite();
+            }));
             return;
         }
         pimpl->writeBufferSize=pimpl->writeQueue.size();
@@ -280,7 +337,7 @@ void AsyncSerial::writeEnd(const boost::system::error_code& error)
         copy(pimpl->writeQueue.begin(),pimpl->writeQueue.end(),
                 pimpl->writeBuffer.get());
         pimpl->writeQueue.clear();
-	async_write(pimpl->port, boost::asio::buffer(pimpl->writeBuffer.get(), pimpl->writeBufferSize), [this](auto &&err, auto) { writeEnd(err); });
+	async_write(pimpl->port, boost::asio::buffer(pimpl->writeBuffer.get(), pimpl->writeBufferSize), pimpl->connection.wrap([this](auto &&err, auto) { writeEnd(err); }));
     } else {
 		try
 		{
@@ -297,6 +354,7 @@ void AsyncSerial::writeEnd(const boost::system::error_code& error)
 void AsyncSerial::doClose()
 {
     boost::system::error_code ec;
+    pimpl->writeDelayTimer.cancel(ec);
     pimpl->port.cancel(ec);
     if(ec) setErrorStatus(true);
     pimpl->port.close(ec);
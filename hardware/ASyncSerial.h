@@ -121,29 +121,34 @@ class AsyncSerial : private domoticz::noncopyable
 	 */
 	void doClose();
 
+	/**
+	 * Registers as reader of a traffic replay instead of opening the port
+	 */
+	void openReplay(const std::string &devname);
+
 	/**
 	 * Callback called to start an asynchronous read operation.
-	 * This callback is called by the io_service in the spawned thread.
+	 * This callback is called on the connection strand of the shared io_service pool.
 	 */
 	void doRead();
 
 	/**
 	 * Callback called at the end of the asynchronous operation.
-	 * This callback is called by the io_service in the spawned thread.
+	 * This callback is called on the connection strand of the shared io_service pool.
 	 */
 	void readEnd(const boost::system::error_code &error, size_t bytes_transferred);
 
 	/**
 	 * Callback called to start an asynchronous write operation.
 	 * If it is already in progress, does nothing.
-	 * This callback is called by the io_service in the spawned thread.
+	 * This callback is called on the connection strand of the shared io_service pool.
 	 */
 	void doWrite();
 
 	/**
 	 * Callback called at the end of an asynchronuous write operation,
 	 * if there is more data to write, restarts a new write operation.
-	 * This callback is called by the io_service in the spawned thread.
+	 * This callback is called on the connection strand of the shared io_service pool.
 	 */
 	void writeEnd(const boost::system::error_code &error);
 
@@ -2,7 +2,9 @@
 #include "ASyncTCP.h"
 #include <boost/asio.hpp>
 #include <boost/system/error_code.hpp>     // for error_code
+#include "../main/Helper.h"
 #include "../main/Logger.h"
+#include "../main/TrafficCapture.h"
 
 struct hostent;
 
@@ -28,18 +30,12 @@ ASyncTCP::ASyncTCP(const bool secure)
 
 ASyncTCP::~ASyncTCP()
 {
-	assert(mTcpthread == nullptr);
-	mIsTerminating = true;
-	if (mTcpthread)
+	assert(!mIsStarted);
+	if (mIsStarted)
 	{
 		//This should never happen. terminate() never called!!
-		_log.Log(LOG_ERROR, "ASyncTCP: Workerthread not closed. terminate() never called!!!");
-		mIos.stop();
-		if (mTcpthread)
-		{
-			mTcpthread->join();
-			mTcpthread.reset();
-		}
+		_log.Log(LOG_ERROR, "ASyncTCP: Connection not closed. terminate() never called!!!");
+		terminate();
 	}
 }
 
@@ -57,19 +53,45 @@ void ASyncTCP::connect(const std::string& ip, uint16_t port)
 		terminate();
 	}
 
-	// RK: We reset mIos here because it might have been stopped in terminate()
-	mIos.reset();
-	// RK: After the reset, we need to provide it work anew
-	mTcpwork = std::make_shared<boost::asio::io_service::work>(mIos);
-	if (!mTcpthread)
-		mTcpthread = std::make_shared<std::thread>([p = &mIos] { p->run(); });
-
+	mIsStarted = true;
 	mIp = ip;
 	mPort = port;
-	std::string port_str = std::to_string(port);
-	boost::asio::ip::tcp::resolver::query query(ip, port_str);
+	mConnection.SetName(std_format("ASyncTCP %s:%d", ip.c_str(), port));
+	if (m_trafficcapture.IsReplaying())
+	{
+		connect_replay();
+		return;
+	}
+	mConnection.post([this] { resolve_start(); });
+}
+
+void ASyncTCP::connect_replay()
+{
+	mIsReplaying = true;
+	m_trafficcapture.RegisterReader(TRAFFIC_TCP, std_format("%s:%d", mIp.c_str(), mPort), this, [this](const std::string & /*topic*/, const std::string &data) {
+		auto origin = CTrafficCapture::GetOrigin();
+		mConnection.post([this, data, origin] {
+			if (mIsTerminating || !mIsConnected)
+				return;
+			CTrafficCapture::SetOrigin(origin);
+			OnData((const uint8_t *)data.c_str(), data.size());
+			CTrafficCapture::SetOrigin(std::chrono::steady_clock::time_point());
+		});
+	});
+	mConnection.post([this] {
+		mIsConnected = true;
+		OnConnect();
+	});
+}
+
+void ASyncTCP::resolve_start()
+{
+	if (mIsTerminating) return;
+
+	std::string port_str = std::to_string(mPort);
+	boost::asio::ip::tcp::resolver::query query(mIp, port_str);
 	timeout_start_timer();
-	mResolver.async_resolve(query, [this](auto &&err, auto &&iter) { cb_resolve_done(err, iter); });
+	mResolver.async_resolve(query, mConnection.wrap([this](auto &&err, auto &&iter) { cb_resolve_done(err, iter); }));
 }
 
 void ASyncTCP::cb_resolve_done(const boost::system::error_code& error, boost::asio::ip::tcp::resolver::iterator endpoint_iterator)
@@ -98,12 +120,12 @@ void ASyncTCP::connect_start(boost::asio::ip::tcp::resolver::iterator& endpoint_
 	{
 		// we reset the ssl socket, because the ssl context needs to be reinitialized after a reconnect
 		mSslSocket.reset(new boost::asio::ssl::stream<boost::asio::ip::tcp::socket>(mIos, mContext));
-		mSslSocket->lowest_layer().async_connect(mEndPoint, [this, endpoint_iterator](auto &&err) mutable { cb_connect_done(err, endpoint_iterator); });
+		mSslSocket->lowest_layer().async_connect(mEndPoint, mConnection.wrap([this, endpoint_iterator](auto &&err) mutable { cb_connect_done(err, endpoint_iterator); }));
 	}
 	else
 #endif
 	{
-		mSocket.async_connect(mEndPoint, [this, endpoint_iterator](auto &&err) mutable { cb_connect_done(err, endpoint_iterator); });
+		mSocket.async_connect(mEndPoint, mConnection.wrap([this, endpoint_iterator](auto &&err) mutable { cb_connect_done(err, endpoint_iterator); }));
 	}
 }
 
@@ -117,7 +139,7 @@ void ASyncTCP::cb_connect_done(const boost::system::error_code& error, boost::as
 		if (mSecure) 
 		{
 			timeout_start_timer();
-			mSslSocket->async_handshake(boost::asio::ssl::stream_base::client, [this](auto &&err) { cb_handshake_done(err); });
+			mSslSocket->async_handshake(boost::asio::ssl::stream_base::client, mConnection.wrap([this](auto &&err) { cb_handshake_done(err); }));
 		}
 		else
 #endif
@@ -155,6 +177,7 @@ void ASyncTCP::cb_handshake_done(const boost::system::error_code& error)
 
 void ASyncTCP::reconnect_start_timer()
 {
+	if (mIsTerminating) return;
 	if (mIsReconnecting) return;
 
 	if (mReconnectDelay != 0)
@@ -162,7 +185,7 @@ void ASyncTCP::reconnect_start_timer()
 		mIsReconnecting = true;
 
 		mReconnectTimer.expires_from_now(boost::posix_time::seconds(mReconnectDelay));
-		mReconnectTimer.async_wait([this](auto &&err) { cb_reconnect_start(err); });
+		mReconnectTimer.async_wait(mConnection.wrap([this](auto &&err) { cb_reconnect_start(err); }));
 	}
 }
 
@@ -174,6 +197,7 @@ void ASyncTCP::cb_reconnect_start(const boost::system::error_code& error)
 
 	if (mIsConnected) return;
 	if (error) return; // timer was cancelled
+	if (mIsTerminating) return;
 
 	do_close();
 	connect(mIp, mPort);
@@ -183,14 +207,15 @@ void ASyncTCP::cb_reconnect_start(const boost::system::error_code& error)
 void ASyncTCP::terminate(const bool silent)
 {
 	mIsTerminating = true;
-	disconnect(silent);
-	mTcpwork.reset();
-	mIos.stop();
-	if (mTcpthread)
+	if (mIsReplaying)
 	{
-		mTcpthread->join();
-		mTcpthread.reset();
+		m_trafficcapture.UnregisterReader(this);
+		mIsReplaying = false;
 	}
+	disconnect(silent);
+	// wait until all pending handlers of this connection are done (or cancelled)
+	mConnection.WaitIdle();
+	mIsStarted = false;
 	mIsReconnecting = false;
 	mIsConnected = false;
 	mWriteQ.clear();
@@ -199,13 +224,16 @@ void ASyncTCP::terminate(const bool silent)
 
 void ASyncTCP::disconnect(const bool silent)
 {
-	mReconnectTimer.cancel();
-	mTimeoutTimer.cancel();
-	if (!mTcpthread) return;
+	if (!mIsStarted) return;
 
 	try
 	{
-		mIos.post([this] { do_close(); });
+		mConnection.post([this] {
+			mReconnectTimer.cancel();
+			mTimeoutTimer.cancel();
+			mResolver.cancel();
+			do_close();
+		});
 	}
 	catch (...)
 	{
@@ -252,12 +280,12 @@ void ASyncTCP::do_read_start()
 #ifdef WWW_ENABLE_SSL
 	if (mSecure)
 	{
-		mSslSocket->async_read_some(boost::asio::buffer(mRxBuffer, sizeof(mRxBuffer)), [this](auto &&err, auto bytes) { cb_read_done(err, bytes); });
+		mSslSocket->async_read_some(boost::asio::buffer(mRxBuffer, sizeof(mRxBuffer)), mConnection.wrap([this](auto &&err, auto bytes) { cb_read_done(err, bytes); }));
 	}
 	else
 #endif
 	{
-		mSocket.async_read_some(boost::asio::buffer(mRxBuffer, sizeof(mRxBuffer)), [this](auto &&err, auto bytes) { cb_read_done(err, bytes); });
+		mSocket.async_read_some(boost::asio::buffer(mRxBuffer, sizeof(mRxBuffer)), mConnection.wrap([this](auto &&err, auto bytes) { cb_read_done(err, bytes); }));
 	}
 }
 
@@ -267,6 +295,8 @@ void ASyncTCP::cb_read_done(const boost::system::error_code& error, size_t bytes
 
 	if (STATUS_OK(error))
 	{
+		if (m_trafficcapture.IsCapturing())
+			m_trafficcapture.Record(TRAFFIC_TCP, std_format("%s:%d", mIp.c_str(), mPort), "", mRxBuffer, bytes_transferred);
 		OnData(mRxBuffer, bytes_transferred);
 		do_read_start();
 	}
@@ -283,9 +313,9 @@ void ASyncTCP::write(const uint8_t* pData, size_t length)
 
 void ASyncTCP::write(const std::string& msg)
 {
-	if (!mTcpthread) return;
+	if (!mIsStarted) return;
 
-	mSendStrand.post([this, msg]() { cb_write_queue(msg); });
+	mConnection.post([this, msg]() { cb_write_queue(msg); });
 }
 
 void ASyncTCP::cb_write_queue(const std::string& msg)
@@ -300,6 +330,12 @@ void ASyncTCP::do_write_start()
 {
 	if (mIsTerminating) return;
 	if (!mIsConnected) return;
+	if (mIsReplaying)
+	{
+		// nothing is sent during a replay
+		mWriteQ.clear();
+		return;
+	}
 	if (mWriteQ.empty())
 		return;
 
@@ -307,12 +343,12 @@ void ASyncTCP::do_write_start()
 #ifdef WWW_ENABLE_SSL
 	if (mSecure) 
 	{
-		boost::asio::async_write(*mSslSocket, boost::asio::buffer(mWriteQ.front()), [this](auto &&err, auto) { cb_write_done(err); });
+		boost::asio::async_write(*mSslSocket, boost::asio::buffer(mWriteQ.front()), mConnection.wrap([this](auto &&err, auto) { cb_write_done(err); }));
 	}
 	else
 #endif
 	{
-		boost::asio::async_write(mSocket, boost::asio::buffer(mWriteQ.front()), [this](auto &&err, auto) { cb_write_done(err); });
+		boost::asio::async_write(mSocket, boost::asio::buffer(mWriteQ.front()), mConnection.wrap([this](auto &&err, auto) { cb_write_done(err); }));
 	}
 }
 
@@ -372,7 +408,7 @@ void ASyncTCP::timeout_start_timer()
 	}
 	timeout_cancel_timer();
 	mTimeoutTimer.expires_from_now(boost::posix_time::seconds(mTimeoutDelay));
-	mTimeoutTimer.async_wait([this](auto &&err) { timeout_handler(err); });
+	mTimeoutTimer.async_wait(mConnection.wrap([this](auto &&err) { timeout_handler(err); }));
 }
 
 void ASyncTCP::timeout_cancel_timer()
@@ -386,6 +422,7 @@ void ASyncTCP::timeout_handler(const boost::system::error_code& error)
 		// timer was cancelled on time
 		return;
 	}
+	if (mIsTerminating) return;
 	boost::system::error_code err = make_error_code(boost::system::errc::timed_out);
 	process_error(err);
 }
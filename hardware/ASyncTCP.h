@@ -9,6 +9,7 @@
 #include <boost/asio/ssl.hpp>		 // for secure sockets
 #include <boost/asio/ssl/stream.hpp>	 // for secure sockets
 #include <exception>			  // for exception
+#include "../main/IoContextPool.h"	 // for shared io_service
 
 #define ASYNCTCP_THREAD_NAME "ASyncTCP"
 #define DEFAULT_RECONNECT_TIME 30
@@ -46,9 +47,13 @@ class ASyncTCP
 	virtual void OnData(const uint8_t *pData, size_t length) = 0;
 	virtual void OnError(const boost::system::error_code &error) = 0;
 
-	boost::asio::io_service mIos; // protected to allow derived classes to attach timers etc.
+	// All handlers of this connection run on the strand of mConnection (shared io_service pool)
+	CIoConnection mConnection{ "ASyncTCP" };
+	boost::asio::io_service &mIos{ mConnection.GetIoContext() }; // protected to allow derived classes to attach timers etc. (wrap their handlers with mConnection.wrap)
 
       private:
+	void connect_replay();
+	void resolve_start();
 	void cb_resolve_done(const boost::system::error_code &err, boost::asio::ip::tcp::resolver::iterator endpoint_iterator);
 	void connect_start(boost::asio::ip::tcp::resolver::iterator &endpoint_iterator);
 	void cb_connect_done(const boost::system::error_code &error, boost::asio::ip::tcp::resolver::iterator &endpoint_iterator);
@@ -78,9 +83,10 @@ class ASyncTCP
 
 	bool mIsConnected = false;
 	bool mIsReconnecting = false;
-	bool mIsTerminating = false;
+	std::atomic<bool> mIsTerminating{ false };
+	bool mIsStarted = false;
+	bool mIsReplaying = false;
 
-	boost::asio::io_service::strand mSendStrand{ mIos };
 	std::deque<std::string> mWriteQ; // we need a write queue to allow concurrent writes
 
 	uint8_t mRxBuffer[1024];
@@ -90,9 +96,6 @@ class ASyncTCP
 	boost::asio::deadline_timer mReconnectTimer{ mIos };
 	boost::asio::deadline_timer mTimeoutTimer{ mIos };
 
-	std::shared_ptr<std::thread> mTcpthread;
-	std::shared_ptr<boost::asio::io_service::work> mTcpwork;
-
 #ifdef WWW_ENABLE_SSL
 	const bool mSecure;
 	boost::asio::ssl::context mContext{ boost::asio::ssl::context::sslv23 };
@@ -733,7 +733,7 @@ namespace http {
 			}
 
 			std::string hwid = request::findValue(&req, "idx");
-			CDomoticzHardwareBase* pBaseHardware = m_mainworker.GetHardwareByIDType(hwid, HTYPE_BleBox);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardwareByIDType(hwid, HTYPE_BleBox);
 			if (pBaseHardware == nullptr)
 				return;
 
@@ -759,7 +759,7 @@ namespace http {
 					root["result"][ii]["hv"] = "unknown";
 					root["result"][ii]["fv"] = "unknown";
 
-					BleBox* pHardware = dynamic_cast<BleBox*>(pBaseHardware);
+					BleBox* pHardware = dynamic_cast<BleBox*>(pBaseHardware.get());
 
 					int type = pHardware->GetDeviceType(ip);
 					if (type != -1)
@@ -798,10 +798,10 @@ namespace http {
 			std::string mode2 = request::findValue(&req, "mode2");
 			if ((hwid.empty()) || (mode1.empty()) || (mode2.empty()))
 				return;
-			CDomoticzHardwareBase * pBaseHardware = m_mainworker.GetHardwareByIDType(hwid, HTYPE_BleBox);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardwareByIDType(hwid, HTYPE_BleBox);
 			if (pBaseHardware == nullptr)
 				return;
-			BleBox * pHardware = dynamic_cast<BleBox*>(pBaseHardware);
+			BleBox * pHardware = dynamic_cast<BleBox*>(pBaseHardware.get());
 
 			root["status"] = "OK";
 			root["title"] = "BleBoxSetMode";
@@ -828,10 +828,10 @@ namespace http {
 			std::string ip = HTMLSanitizer::Sanitize(request::findValue(&req, "ip"));
 			if ((hwid.empty()) || (name.empty()) || (ip.empty()))
 				return;
-			CDomoticzHardwareBase * pBaseHardware = m_mainworker.GetHardwareByIDType(hwid, HTYPE_BleBox);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardwareByIDType(hwid, HTYPE_BleBox);
 			if (pBaseHardware == nullptr)
 				return;
-			BleBox * pHardware = dynamic_cast<BleBox*>(pBaseHardware);
+			BleBox * pHardware = dynamic_cast<BleBox*>(pBaseHardware.get());
 
 			root["status"] = "OK";
 			root["title"] = "BleBoxAddNode";
@@ -850,10 +850,10 @@ namespace http {
 			std::string nodeid = request::findValue(&req, "nodeid");
 			if ((hwid.empty()) || (nodeid.empty()))
 				return;
-			CDomoticzHardwareBase * pBaseHardware = m_mainworker.GetHardwareByIDType(hwid, HTYPE_BleBox);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardwareByIDType(hwid, HTYPE_BleBox);
 			if (pBaseHardware == nullptr)
 				return;
-			BleBox * pHardware = dynamic_cast<BleBox*>(pBaseHardware);
+			BleBox * pHardware = dynamic_cast<BleBox*>(pBaseHardware.get());
 
 			root["status"] = "OK";
 			root["title"] = "BleBoxRemoveNode";
@@ -870,10 +870,10 @@ namespace http {
 			}
 
 			std::string hwid = request::findValue(&req, "idx");
-			CDomoticzHardwareBase* pBaseHardware = m_mainworker.GetHardwareByIDType(hwid, HTYPE_BleBox);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardwareByIDType(hwid, HTYPE_BleBox);
 			if (pBaseHardware == nullptr)
 				return;
-			BleBox * pHardware = dynamic_cast<BleBox*>(pBaseHardware);
+			BleBox * pHardware = dynamic_cast<BleBox*>(pBaseHardware.get());
 
 			root["status"] = "OK";
 			root["title"] = "BleBoxClearNodes";
@@ -892,10 +892,10 @@ namespace http {
 			std::string ipmask = request::findValue(&req, "ipmask");
 			if ((hwid.empty()) || (ipmask.empty()))
 				return;
-			CDomoticzHardwareBase * pBaseHardware = m_mainworker.GetHardwareByIDType(hwid, HTYPE_BleBox);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardwareByIDType(hwid, HTYPE_BleBox);
 			if (pBaseHardware == nullptr)
 				return;
-			BleBox * pHardware = dynamic_cast<BleBox*>(pBaseHardware);
+			BleBox * pHardware = dynamic_cast<BleBox*>(pBaseHardware.get());
 
 			root["status"] = "OK";
 			root["title"] = "BleBoxAutoSearchingNodes";
@@ -911,10 +911,10 @@ namespace http {
 			}
 
 			std::string hwid = request::findValue(&req, "idx");
-			CDomoticzHardwareBase* pBaseHardware = m_mainworker.GetHardwareByIDType(hwid, HTYPE_BleBox);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardwareByIDType(hwid, HTYPE_BleBox);
 			if (pBaseHardware == nullptr)
 				return;
-			BleBox * pHardware = dynamic_cast<BleBox*>(pBaseHardware);
+			BleBox * pHardware = dynamic_cast<BleBox*>(pBaseHardware.get());
 
 			root["status"] = "OK";
 			root["title"] = "BleBoxUpdateFirmware";
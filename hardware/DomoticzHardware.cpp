@@ -464,15 +464,16 @@ float CDomoticzHardwareBase::GetRainSensorValue(const int NodeID, bool& bExists)
 	std::string sIdx = std_format("%d", NodeID & 0xFFFF);
 	int Unit = 0;
 
-	std::vector<std::vector<std::string> > results;
-	results = m_sql.safe_query("SELECT ID,sValue FROM DeviceStatus WHERE (HardwareID==%d) AND (DeviceID=='%q') AND (Unit == %d) AND (Type==%d) AND (Subtype==%d)", m_HwdID, sIdx.c_str(), Unit, int(pTypeRAIN), int(sTypeRAIN3));
-	if (results.empty())
+	int nValue;
+	std::string sValue;
+	struct tm LastUpdateTime;
+	if (!m_sql.GetLastValue(m_HwdID, sIdx.c_str(), Unit, pTypeRAIN, sTypeRAIN3, nValue, sValue, LastUpdateTime))
 	{
 		bExists = false;
 		return 0.0F;
 	}
 	std::vector<std::string> splitresults;
-	StringSplit(results[0][1], ";", splitresults);
+	StringSplit(sValue, ";", splitresults);
 	if (splitresults.size() != 2)
 	{
 		bExists = false;
@@ -487,20 +488,16 @@ bool CDomoticzHardwareBase::GetWindSensorValue(const int NodeID, int& WindDir, f
 	std::string sIdx = std_format("%d", NodeID & 0xFFFF);
 	int Unit = 0;
 
-	std::vector<std::vector<std::string> > results;
-	if (!bHaveWindTemp)
-		results = m_sql.safe_query("SELECT ID,sValue FROM DeviceStatus WHERE (HardwareID==%d) AND (DeviceID=='%q') AND (Unit == %d) AND (Type==%d) AND (Subtype==%d)", m_HwdID, sIdx.c_str(), Unit,
-					   int(pTypeWIND), int(sTypeWINDNoTemp));
-	else
-		results = m_sql.safe_query("SELECT ID,sValue FROM DeviceStatus WHERE (HardwareID==%d) AND (DeviceID=='%q') AND (Unit == %d) AND (Type==%d) AND (Subtype==%d)", m_HwdID, sIdx.c_str(), Unit,
-					   int(pTypeWIND), int(sTypeWIND4));
-	if (results.empty())
+	int nValue;
+	std::string sValue;
+	struct tm LastUpdateTime;
+	if (!m_sql.GetLastValue(m_HwdID, sIdx.c_str(), Unit, pTypeWIND, (!bHaveWindTemp) ? sTypeWINDNoTemp : sTypeWIND4, nValue, sValue, LastUpdateTime))
 	{
 		bExists = false;
 		return 0.0F;
 	}
 	std::vector<std::string> splitresults;
-	StringSplit(results[0][1], ";", splitresults);
+	StringSplit(sValue, ";", splitresults);
 
 	if (splitresults.size() != 6)
 	{
@@ -638,10 +635,8 @@ void CDomoticzHardwareBase::SendSwitchIfNotExists(const int NodeID, const uint8_
 
 	std::string sIdx = std_format("%X%02X%02X%02X", ID1, ID2, ID3, ID4);
 
-	std::vector<std::vector<std::string> > result;
-	result = m_sql.safe_query("SELECT Name,nValue,sValue FROM DeviceStatus WHERE (HardwareID==%d) AND (DeviceID=='%q') AND (Unit == %d) AND (Type==%d) AND (Subtype==%d)", m_HwdID, sIdx.c_str(), ChildID,
-				  int(pTypeLighting2), int(sTypeAC));
-	if (result.empty())
+	std::string devname;
+	if (m_sql.GetDeviceIndex(m_HwdID, sIdx, ChildID, pTypeLighting2, sTypeAC, devname) == (uint64_t)-1)
 	{
 		SendSwitch(NodeID, ChildID, BatteryLevel, bOn, Level, defaultname, userName);
 	}
@@ -701,19 +696,18 @@ void CDomoticzHardwareBase::SendSwitch(const int NodeID, const uint8_t ChildID,
 	unsigned char ID4 = (unsigned char)NodeID & 0xFF;
 
 	std::string sIdx = std_format("%X%02X%02X%02X", ID1, ID2, ID3, ID4);
-	std::vector<std::vector<std::string> > result;
-	result = m_sql.safe_query("SELECT Name,nValue,sValue FROM DeviceStatus WHERE (HardwareID==%d) AND (DeviceID=='%q') AND (Unit == %d) AND (Type==%d) AND (Subtype==%d)", m_HwdID, sIdx.c_str(), ChildID,
-				  int(pTypeLighting2), int(sTypeAC));
-	if (!result.empty())
+	int nvalue;
+	std::string sValue;
+	struct tm LastUpdateTime;
+	if (m_sql.GetLastValue(m_HwdID, sIdx.c_str(), ChildID, pTypeLighting2, sTypeAC, nvalue, sValue, LastUpdateTime))
 	{
 		//check if we have a change, if not do not update it
-		int nvalue = atoi(result[0][1].c_str());
 		if ((!bOn) && (nvalue == light2_sOff))
 			return;
 		if ((bOn && (nvalue != light2_sOff)))
 		{
 			//Check Level
-			int slevel = atoi(result[0][2].c_str());
+			int slevel = atoi(sValue.c_str());
 			if (slevel == level)
 				return;
 		}
@@ -2155,12 +2155,12 @@ namespace http {
 			std::string idx = request::findValue(&req, "idx");
 			std::string type = request::findValue(&req, "devtype");
 			int HwdID = atoi(idx.c_str());
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(HwdID);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(HwdID);
 			if (pHardware == nullptr)
 				return;
 			if (pHardware->HwdType != HTYPE_EVOHOME_SERIAL && pHardware->HwdType != HTYPE_EVOHOME_TCP)
 				return;
-			CEvohomeRadio* pEvoHW = dynamic_cast<CEvohomeRadio*>(pHardware);
+			CEvohomeRadio* pEvoHW = dynamic_cast<CEvohomeRadio*>(pHardware.get());
 
 			int nDevNo = 0;
 			int nID = 0;
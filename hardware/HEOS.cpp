@@ -813,12 +813,12 @@ namespace http {
 			if ((hwid.empty()) || (mode1.empty()) || (mode2.empty()))
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase *pBaseHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pBaseHardware == nullptr)
 				return;
 			if (pBaseHardware->HwdType != HTYPE_HEOS)
 				return;
-			CHEOS *pHardware = dynamic_cast<CHEOS*>(pBaseHardware);
+			CHEOS *pHardware = dynamic_cast<CHEOS*>(pBaseHardware.get());
 
 			root["status"] = "OK";
 			root["title"] = "HEOSSetMode";
@@ -855,10 +855,10 @@ namespace http {
 				{
 					switch (hType) {
 					case HTYPE_HEOS:
-						CDomoticzHardwareBase *pBaseHardware = m_mainworker.GetHardwareByIDType(result[0][3], HTYPE_HEOS);
+						std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardwareByIDType(result[0][3], HTYPE_HEOS);
 						if (pBaseHardware == nullptr)
 							return;
-						CHEOS *pHEOS = dynamic_cast<CHEOS*>(pBaseHardware);
+						CHEOS *pHEOS = dynamic_cast<CHEOS*>(pBaseHardware.get());
 
 						pHEOS->SendCommand(sAction, PlayerID);
 						break;
@@ -73,6 +73,7 @@ MQTT::MQTT(const int ID, const std::string &IPAddress, const unsigned short usIP
 
 MQTT::~MQTT()
 {
+	stop_replay();
 	mosqdz::lib_cleanup();
 }
 
@@ -111,6 +112,7 @@ bool MQTT::StopHardware()
 		m_thread->join();
 		m_thread.reset();
 	}
+	stop_replay();
 	m_IsConnected = false;
 	return true;
 }
@@ -4109,7 +4109,7 @@ namespace http {
 			if (hwid.empty())
 				return;
 
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(std::stoi(hwid));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(std::stoi(hwid));
 			if (pHardware == nullptr)
 				return;
 			if (pHardware->HwdType != HTYPE_MQTTAutoDiscovery)
@@ -4118,7 +4118,7 @@ namespace http {
 			root["status"] = "OK";
 			root["title"] = "GetMQTTConfig";
 
-			MQTTAutoDiscover* pMQTT = reinterpret_cast<MQTTAutoDiscover*>(pHardware);
+			MQTTAutoDiscover* pMQTT = reinterpret_cast<MQTTAutoDiscover*>(pHardware.get());
 			pMQTT->GetConfig(root);
 		}
 
@@ -4140,13 +4140,13 @@ namespace http {
 				)
 				return;
 
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(std::stoi(hwid));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(std::stoi(hwid));
 			if (pHardware == nullptr)
 				return;
 			if (pHardware->HwdType != HTYPE_MQTTAutoDiscovery)
 				return;
 
-			MQTTAutoDiscover* pMQTT = reinterpret_cast<MQTTAutoDiscover*>(pHardware);
+			MQTTAutoDiscover* pMQTT = reinterpret_cast<MQTTAutoDiscover*>(pHardware.get());
 			try
 			{
 				if (pMQTT->UpdateNumber(devid, value))
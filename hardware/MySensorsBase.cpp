@@ -2352,7 +2352,7 @@ namespace http {
 			if (hwid.empty())
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pHardware == nullptr)
 				return;
 			if (
@@ -2361,7 +2361,7 @@ namespace http {
 				(pHardware->HwdType != HTYPE_MySensorsMQTT)
 				)
 				return;
-			MySensorsBase* pMySensorsHardware = dynamic_cast<MySensorsBase*>(pHardware);
+			MySensorsBase* pMySensorsHardware = dynamic_cast<MySensorsBase*>(pHardware.get());
 
 			root["status"] = "OK";
 			root["title"] = "MySensorsGetNodes";
@@ -2425,7 +2425,7 @@ namespace http {
 			if ((hwid.empty()) || (nodeid.empty()))
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pHardware == nullptr)
 				return;
 			if (
@@ -2434,7 +2434,7 @@ namespace http {
 				(pHardware->HwdType != HTYPE_MySensorsMQTT)
 				)
 				return;
-			MySensorsBase* pMySensorsHardware = dynamic_cast<MySensorsBase*>(pHardware);
+			MySensorsBase* pMySensorsHardware = dynamic_cast<MySensorsBase*>(pHardware.get());
 
 			root["status"] = "OK";
 			root["title"] = "MySensorsGetChilds";
@@ -2503,7 +2503,7 @@ namespace http {
 			if ((hwid.empty()) || (nodeid.empty()) || (name.empty()))
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase* pBaseHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pBaseHardware == nullptr)
 				return;
 			if (
@@ -2512,7 +2512,7 @@ namespace http {
 				(pBaseHardware->HwdType != HTYPE_MySensorsMQTT)
 				)
 				return;
-			MySensorsBase* pMySensorsHardware = dynamic_cast<MySensorsBase*>(pBaseHardware);
+			MySensorsBase* pMySensorsHardware = dynamic_cast<MySensorsBase*>(pBaseHardware.get());
 			int NodeID = atoi(nodeid.c_str());
 			root["status"] = "OK";
 			root["title"] = "MySensorsUpdateNode";
@@ -2531,7 +2531,7 @@ namespace http {
 			if ((hwid.empty()) || (nodeid.empty()))
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase* pBaseHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pBaseHardware == nullptr)
 				return;
 			if (
@@ -2540,7 +2540,7 @@ namespace http {
 				(pBaseHardware->HwdType != HTYPE_MySensorsMQTT)
 				)
 				return;
-			MySensorsBase* pMySensorsHardware = dynamic_cast<MySensorsBase*>(pBaseHardware);
+			MySensorsBase* pMySensorsHardware = dynamic_cast<MySensorsBase*>(pBaseHardware.get());
 			int NodeID = atoi(nodeid.c_str());
 			root["status"] = "OK";
 			root["title"] = "MySensorsRemoveNode";
@@ -2560,7 +2560,7 @@ namespace http {
 			if ((hwid.empty()) || (nodeid.empty()) || (childid.empty()))
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase* pBaseHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pBaseHardware == nullptr)
 				return;
 			if (
@@ -2569,7 +2569,7 @@ namespace http {
 				(pBaseHardware->HwdType != HTYPE_MySensorsMQTT)
 				)
 				return;
-			MySensorsBase* pMySensorsHardware = dynamic_cast<MySensorsBase*>(pBaseHardware);
+			MySensorsBase* pMySensorsHardware = dynamic_cast<MySensorsBase*>(pBaseHardware.get());
 			int NodeID = atoi(nodeid.c_str());
 			int ChildID = atoi(childid.c_str());
 			root["status"] = "OK";
@@ -2598,7 +2598,7 @@ namespace http {
 				)
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase* pBaseHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pBaseHardware == nullptr)
 				return;
 			if (
@@ -2607,7 +2607,7 @@ namespace http {
 				(pBaseHardware->HwdType != HTYPE_MySensorsMQTT)
 				)
 				return;
-			MySensorsBase* pMySensorsHardware = dynamic_cast<MySensorsBase*>(pBaseHardware);
+			MySensorsBase* pMySensorsHardware = dynamic_cast<MySensorsBase*>(pBaseHardware.get());
 			int NodeID = atoi(nodeid.c_str());
 			int ChildID = atoi(childid.c_str());
 			root["status"] = "OK";
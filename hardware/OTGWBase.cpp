@@ -611,7 +611,7 @@ namespace http {
 			stdupper(rcmnd);
 			cmnd = rcmnd + rdata;
 
-			OTGWBase *pOTGW = dynamic_cast<OTGWBase*>(m_mainworker.GetHardware(atoi(idx.c_str())));
+			std::shared_ptr<OTGWBase> pOTGW = std::dynamic_pointer_cast<OTGWBase>(m_mainworker.GetHardware(atoi(idx.c_str())));
 			if (pOTGW == nullptr)
 				return;
 
@@ -71,6 +71,7 @@ COctoPrintMQTT::COctoPrintMQTT(const int ID, const std::string &IPAddress, const
 
 COctoPrintMQTT::~COctoPrintMQTT()
 {
+	stop_replay();
 	mosqdz::lib_cleanup();
 }
 
@@ -106,6 +107,7 @@ bool COctoPrintMQTT::StopHardware()
 		m_thread->join();
 		m_thread.reset();
 	}
+	stop_replay();
 	m_IsConnected = false;
 	return true;
 }
@@ -708,10 +708,10 @@ namespace http
 					// We allow raw EISCP commands to be sent on *any* of the logical devices
 					// associated with the hardware.
 					case HTYPE_OnkyoAVTCP:
-						CDomoticzHardwareBase *pBaseHardware = m_mainworker.GetHardwareByIDType(result[0][3], HTYPE_OnkyoAVTCP);
+						std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardwareByIDType(result[0][3], HTYPE_OnkyoAVTCP);
 						if (pBaseHardware == nullptr)
 							return;
-						OnkyoAVTCP *pOnkyoAVTCP = dynamic_cast<OnkyoAVTCP *>(pBaseHardware);
+						OnkyoAVTCP *pOnkyoAVTCP = dynamic_cast<OnkyoAVTCP *>(pBaseHardware.get());
 
 						pOnkyoAVTCP->SendPacket(sAction.c_str());
 						root["status"] = "OK";
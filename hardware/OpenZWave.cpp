@@ -5441,13 +5441,13 @@ namespace http {
 			if (hwid.empty())
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pHardware == nullptr)
 				return;
 			if (pHardware->HwdType != HTYPE_OpenZWave)
 				return;
 			m_ZW_Hwidx = iHardwareID;
-			COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+			COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 
 			root["status"] = "OK";
 			root["title"] = "OpenZWaveNodes";
@@ -5527,12 +5527,12 @@ namespace http {
 			int hwid = atoi(result[0][0].c_str());
 			unsigned int homeID = static_cast<unsigned int>(std::stoul(result[0][1]));
 			uint8_t nodeID = (uint8_t)atoi(result[0][2].c_str());
-			CDomoticzHardwareBase *pHardware = m_mainworker.GetHardware(hwid);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(hwid);
 			if (pHardware == nullptr)
 				return; //not found!?
 			if (pHardware->HwdType != HTYPE_OpenZWave)
 				return;
-			COpenZWave *pOZWHardware = (COpenZWave *)pHardware;
+			COpenZWave *pOZWHardware = (COpenZWave *)pHardware.get();
 
 			m_sql.safe_query("UPDATE ZWaveNodes SET Name='%q', PollTime=%d WHERE (ID=='%q')", name.c_str(), (senablepolling == "true") ? 1 : 0, idx.c_str());
 			pOZWHardware->SetNodeName(homeID, nodeID, name);
@@ -5557,7 +5557,7 @@ namespace http {
 			int hwid = atoi(result[0][0].c_str());
 			//unsigned int homeID = static_cast<unsigned int>(std::stoul(result[0][1]));
 			uint8_t nodeID = (uint8_t)atoi(result[0][2].c_str());
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(hwid);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(hwid);
 			if (pHardware == nullptr)
 				return;
 			if (pHardware->HwdType != HTYPE_OpenZWave)
@@ -5565,7 +5565,7 @@ namespace http {
 			root["status"] = "OK";
 			root["title"] = "DeleteZWaveNode";
 
-			COpenZWave *pOZWHardware = (COpenZWave *)pHardware;
+			COpenZWave *pOZWHardware = (COpenZWave *)pHardware.get();
 			pOZWHardware->RemoveFailedDevice(nodeID);
 			result = m_sql.safe_query("DELETE FROM ZWaveNodes WHERE (ID=='%q')", idx.c_str());
 		}
@@ -5583,7 +5583,7 @@ namespace http {
 				return;
 			std::string ssecure = request::findValue(&req, "secure");
 			bool bSecure = (ssecure == "true");
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware == nullptr)
 				return;
 			if (pHardware->HwdType != HTYPE_OpenZWave)
@@ -5591,7 +5591,7 @@ namespace http {
 			root["status"] = "OK";
 			root["title"] = "ZWaveInclude";
 
-			COpenZWave *pOZWHardware = (COpenZWave *)pHardware;
+			COpenZWave *pOZWHardware = (COpenZWave *)pHardware.get();
 			m_sql.AllowNewHardwareTimer(5);
 			pOZWHardware->IncludeDevice(bSecure);
 		}
@@ -5607,7 +5607,7 @@ namespace http {
 			std::string idx = request::findValue(&req, "idx");
 			if (idx.empty())
 				return;
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware == nullptr)
 				return;
 			if (pHardware->HwdType != HTYPE_OpenZWave)
@@ -5615,7 +5615,7 @@ namespace http {
 			root["status"] = "OK";
 			root["title"] = "ZWaveExclude";
 
-			COpenZWave *pOZWHardware = (COpenZWave *)pHardware;
+			COpenZWave *pOZWHardware = (COpenZWave *)pHardware.get();
 			pOZWHardware->ExcludeDevice(1);
 		}
 
@@ -5624,7 +5624,7 @@ namespace http {
 			std::string idx = request::findValue(&req, "idx");
 			if (idx.empty())
 				return;
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware == nullptr)
 				return;
 			if (pHardware->HwdType != HTYPE_OpenZWave)
@@ -5632,7 +5632,7 @@ namespace http {
 			root["status"] = "OK";
 			root["title"] = "ZWaveIsHasNodeFailedDone";
 
-			COpenZWave *pOZWHardware = (COpenZWave *)pHardware;
+			COpenZWave *pOZWHardware = (COpenZWave *)pHardware.get();
 			bool bIsHasNodeFailedDone = pOZWHardware->IsHasNodeFailedDone();
 			root["result"] = bIsHasNodeFailedDone;
 			if (bIsHasNodeFailedDone)
@@ -5647,7 +5647,7 @@ namespace http {
 			std::string idx = request::findValue(&req, "idx");
 			if (idx.empty())
 				return;
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware == nullptr)
 				return;
 			if (pHardware->HwdType != HTYPE_OpenZWave)
@@ -5655,7 +5655,7 @@ namespace http {
 			root["status"] = "OK";
 			root["title"] = "ZWaveIsNodeReplaced";
 
-			COpenZWave *pOZWHardware = (COpenZWave *)pHardware;
+			COpenZWave *pOZWHardware = (COpenZWave *)pHardware.get();
 			bool bIsReplaced = pOZWHardware->IsNodeReplaced();
 			root["result"] = bIsReplaced;
 			if (bIsReplaced)
@@ -5669,7 +5669,7 @@ namespace http {
 			std::string idx = request::findValue(&req, "idx");
 			if (idx.empty())
 				return;
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware == nullptr)
 				return;
 			if (pHardware->HwdType != HTYPE_OpenZWave)
@@ -5677,7 +5677,7 @@ namespace http {
 			root["status"] = "OK";
 			root["title"] = "ZWaveIsNodeIncluded";
 
-			COpenZWave *pOZWHardware = (COpenZWave *)pHardware;
+			COpenZWave *pOZWHardware = (COpenZWave *)pHardware.get();
 			bool bIsIncluded = pOZWHardware->IsNodeIncluded();
 			root["result"] = bIsIncluded;
 			if (bIsIncluded)
@@ -5699,7 +5699,7 @@ namespace http {
 			std::string idx = request::findValue(&req, "idx");
 			if (idx.empty())
 				return;
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware == nullptr)
 				return;
 			if (pHardware->HwdType != HTYPE_OpenZWave)
@@ -5707,7 +5707,7 @@ namespace http {
 			root["status"] = "OK";
 			root["title"] = "ZWaveIsNodeExcluded";
 
-			COpenZWave *pOZWHardware = (COpenZWave *)pHardware;
+			COpenZWave *pOZWHardware = (COpenZWave *)pHardware.get();
 			root["result"] = pOZWHardware->IsNodeExcluded();
 			root["node_id"] = (pOZWHardware->m_LastRemovedNode >0) ? std::to_string(pOZWHardware->m_LastRemovedNode) : "Failed!";
 		}
@@ -5723,14 +5723,14 @@ namespace http {
 			std::string idx = request::findValue(&req, "idx");
 			if (idx.empty())
 				return;
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware == nullptr)
 				return;
 			if (pHardware->HwdType != HTYPE_OpenZWave)
 				return;
 			root["status"] = "OK";
 			root["title"] = "ZWaveSoftReset";
-			COpenZWave *pOZWHardware = (COpenZWave *)pHardware;
+			COpenZWave *pOZWHardware = (COpenZWave *)pHardware.get();
 			pOZWHardware->SoftResetDevice();
 		}
 
@@ -5745,14 +5745,14 @@ namespace http {
 			std::string idx = request::findValue(&req, "idx");
 			if (idx.empty())
 				return;
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware == nullptr)
 				return;
 			if (pHardware->HwdType != HTYPE_OpenZWave)
 				return;
 			root["status"] = "OK";
 			root["title"] = "ZWaveHardReset";
-			COpenZWave *pOZWHardware = (COpenZWave *)pHardware;
+			COpenZWave *pOZWHardware = (COpenZWave *)pHardware.get();
 			pOZWHardware->HardResetDevice();
 		}
 
@@ -5761,14 +5761,14 @@ namespace http {
 			std::string idx = request::findValue(&req, "idx");
 			if (idx.empty())
 				return;
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware == nullptr)
 				return;
 			if (pHardware->HwdType != HTYPE_OpenZWave)
 				return;
 			root["title"] = "ZWaveStateCheck";
 			root["status"] = "OK";
-			COpenZWave *pOZWHardware = (COpenZWave *)pHardware;
+			COpenZWave *pOZWHardware = (COpenZWave *)pHardware.get();
 			if (!pOZWHardware->GetFailedState()) {
 			}
 		}
@@ -5784,7 +5784,7 @@ namespace http {
 			std::string idx = request::findValue(&req, "idx");
 			if (idx.empty())
 				return;
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware == nullptr)
 				return;
 			if (pHardware->HwdType != HTYPE_OpenZWave)
@@ -5792,7 +5792,7 @@ namespace http {
 			root["status"] = "OK";
 			root["title"] = "ZWaveHealNetwork";
 
-			COpenZWave *pOZWHardware = (COpenZWave *)pHardware;
+			COpenZWave *pOZWHardware = (COpenZWave *)pHardware.get();
 			pOZWHardware->HealNetwork();
 		}
 
@@ -5810,14 +5810,14 @@ namespace http {
 			std::string node = request::findValue(&req, "node");
 			if (node.empty())
 				return;
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware == nullptr)
 				return;
 			if (pHardware->HwdType != HTYPE_OpenZWave)
 				return;
 			root["status"] = "OK";
 			root["title"] = "ZWaveHealNode";
-			COpenZWave *pOZWHardware = (COpenZWave *)pHardware;
+			COpenZWave *pOZWHardware = (COpenZWave *)pHardware.get();
 			pOZWHardware->HealNode((uint8_t)atoi(node.c_str()));
 		}
 
@@ -5835,12 +5835,12 @@ namespace http {
 			if (idx.empty())
 				return;
 			int hwID = atoi(idx.c_str());
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(hwID);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(hwID);
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 				std::vector< std::vector< int > > nodevectors;
 
 				if (pOZWHardware->NetworkInfo(hwID, nodevectors))
@@ -5904,12 +5904,12 @@ namespace http {
 			std::string removenode = request::findValue(&req, "removenode");
 			if (removenode.empty())
 				return;
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 				int nodeId = 0, instance = 0;
 				sscanf(removenode.c_str(), "%d.%d", &nodeId, &instance);
 				pOZWHardware->RemoveNodeFromGroup((uint8_t)atoi(node.c_str()), (uint8_t)atoi(group.c_str()), (uint8_t)nodeId, (uint8_t)instance);
@@ -5938,12 +5938,12 @@ namespace http {
 			std::string addnode = request::findValue(&req, "addnode");
 			if (addnode.empty())
 				return;
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 				int nodeId = 0, instance = 0;
 				sscanf(addnode.c_str(), "%d.%d", &nodeId, &instance);
 				pOZWHardware->AddNodeToGroup((uint8_t)atoi(node.c_str()), (uint8_t)atoi(group.c_str()), (uint8_t)nodeId, (uint8_t)instance);
@@ -5959,12 +5959,12 @@ namespace http {
 				return;
 			int iHardwareID = atoi(idx.c_str());
 
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 
 				std::vector<std::vector<std::string> > result;
 				result = m_sql.safe_query("SELECT ID,HomeID,NodeID,Name FROM ZWaveNodes WHERE (HardwareID==%d)",
@@ -6023,12 +6023,12 @@ namespace http {
 			std::string idx = request::findValue(&req, "idx");
 			if (idx.empty())
 				return;
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 				pOZWHardware->CancelControllerCommand(true);
 				root["status"] = "OK";
 				root["title"] = "ZWaveCancel";
@@ -6054,12 +6054,12 @@ namespace http {
 				int hwid = atoi(result[0][0].c_str());
 				unsigned int homeID = static_cast<unsigned int>(std::stoul(result[0][1]));
 				uint8_t nodeID = (uint8_t)atoi(result[0][2].c_str());
-				CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(hwid);
+				std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(hwid);
 				if (pHardware != nullptr)
 				{
 					if (pHardware->HwdType != HTYPE_OpenZWave)
 						return;
-					COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+					COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 					if (!pOZWHardware->ApplyNodeConfig(homeID, nodeID, svaluelist))
 						return;
 					root["status"] = "OK";
@@ -6080,12 +6080,12 @@ namespace http {
 				int hwid = atoi(result[0][0].c_str());
 				unsigned int homeID = static_cast<unsigned int>(std::stoul(result[0][1]));
 				uint8_t nodeID = (uint8_t)atoi(result[0][2].c_str());
-				CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(hwid);
+				std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(hwid);
 				if (pHardware != nullptr)
 				{
 					if (pHardware->HwdType != HTYPE_OpenZWave)
 						return;
-					COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+					COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 					pOZWHardware->RequestNodeConfig(homeID, nodeID);
 					root["status"] = "OK";
 					root["title"] = "RequestZWaveNodeConfig";
@@ -6105,12 +6105,12 @@ namespace http {
 				int hwid = atoi(result[0][0].c_str());
 				unsigned int homeID = static_cast<unsigned int>(std::stoul(result[0][1]));
 				uint8_t nodeID = (uint8_t)atoi(result[0][2].c_str());
-				CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(hwid);
+				std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(hwid);
 				if (pHardware != nullptr)
 				{
 					if (pHardware->HwdType != HTYPE_OpenZWave)
 						return;
-					COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+					COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 					pOZWHardware->RequestNodeInfo(homeID, nodeID);
 					root["status"] = "OK";
 					root["title"] = "RequestZWaveNodeInfo";
@@ -6130,12 +6130,12 @@ namespace http {
 				int hwid = atoi(result[0][0].c_str());
 				unsigned int homeID = static_cast<unsigned int>(std::stoul(result[0][1]));
 				uint8_t nodeID = (uint8_t)atoi(result[0][2].c_str());
-				CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(hwid);
+				std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(hwid);
 				if (pHardware != nullptr)
 				{
 					if (pHardware->HwdType != HTYPE_OpenZWave)
 						return;
-					COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+					COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 					pOZWHardware->HasNodeFailed(homeID, nodeID);
 					root["status"] = "OK";
 					root["title"] = "ZWaveHasNodeFailed";
@@ -6155,12 +6155,12 @@ namespace http {
 				int hwid = atoi(result[0][0].c_str());
 				unsigned int homeID = static_cast<unsigned int>(std::stoul(result[0][1]));
 				uint8_t nodeID = (uint8_t)atoi(result[0][2].c_str());
-				CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(hwid);
+				std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(hwid);
 				if (pHardware != nullptr)
 				{
 					if (pHardware->HwdType != HTYPE_OpenZWave)
 						return;
-					COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+					COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 					pOZWHardware->ReplaceFailedNode(homeID, nodeID);
 					root["status"] = "OK";
 					root["title"] = "ZWaveReplaceFailedNode";
@@ -6179,12 +6179,12 @@ namespace http {
 			std::string idx = request::findValue(&req, "idx");
 			if (idx.empty())
 				return;
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 				pOZWHardware->ReceiveConfigurationFromOtherController();
 				root["status"] = "OK";
 				root["title"] = "ZWaveReceiveConfigurationFromOtherController";
@@ -6202,12 +6202,12 @@ namespace http {
 			std::string idx = request::findValue(&req, "idx");
 			if (idx.empty())
 				return;
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 				pOZWHardware->SendConfigurationToSecondaryController();
 				root["status"] = "OK";
 				root["title"] = "ZWaveSendConfigToSecond";
@@ -6225,12 +6225,12 @@ namespace http {
 			std::string idx = request::findValue(&req, "idx");
 			if (idx.empty())
 				return;
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 				pOZWHardware->TransferPrimaryRole();
 				root["status"] = "OK";
 				root["title"] = "ZWaveTransferPrimaryRole";
@@ -6242,12 +6242,12 @@ namespace http {
 			if (idx.empty())
 				return;
 
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 				std::string configFilePath;
 				pOZWHardware->GetConfigFile(configFilePath, rep.content);
 				if (!configFilePath.empty() && !rep.content.empty()) {
@@ -6265,12 +6265,12 @@ namespace http {
 		}
 		void CWebServer::ZWaveCPIndex(WebEmSession& /*session*/, const request& /*req*/, reply& rep)
 		{
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 				pOZWHardware->m_ozwcp.SetAllNodesChanged();
 				std::string wwwFile = szWWWFolder + "/ozwcp/cp.html";
 				reply::set_content_from_file(&rep, wwwFile);
@@ -6278,12 +6278,12 @@ namespace http {
 		}
 		void CWebServer::ZWaveCPPollXml(WebEmSession& /*session*/, const request& /*req*/, reply& rep)
 		{
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 				std::lock_guard<std::mutex> l(pOZWHardware->m_NotificationMutex);
 
 				reply::set_content(&rep, pOZWHardware->m_ozwcp.SendPollResponse());
@@ -6300,12 +6300,12 @@ namespace http {
 			if (sNode.empty())
 				return;
 			int iNode = atoi(sNode.c_str());
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 				std::lock_guard<std::mutex> l(pOZWHardware->m_NotificationMutex);
 				reply::set_content(&rep, pOZWHardware->m_ozwcp.SendNodeConfResponse(iNode));
 			}
@@ -6320,12 +6320,12 @@ namespace http {
 			if (sNode.empty())
 				return;
 			int iNode = atoi(sNode.c_str());
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 				std::lock_guard<std::mutex> l(pOZWHardware->m_NotificationMutex);
 				reply::set_content(&rep, pOZWHardware->m_ozwcp.SendNodeValuesResponse(iNode));
 			}
@@ -6337,12 +6337,12 @@ namespace http {
 			if (strarray.size() != 2)
 				return;
 
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 				std::lock_guard<std::mutex> l(pOZWHardware->m_NotificationMutex);
 				reply::set_content(&rep, pOZWHardware->m_ozwcp.SetNodeValue(strarray[0], strarray[1]));
 			}
@@ -6354,12 +6354,12 @@ namespace http {
 			if (strarray.size() != 2)
 				return;
 
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 				std::lock_guard<std::mutex> l(pOZWHardware->m_NotificationMutex);
 				reply::set_content(&rep, pOZWHardware->m_ozwcp.SetNodeButton(strarray[0], strarray[1]));
 			}
@@ -6379,12 +6379,12 @@ namespace http {
 				sNode = sNode.substr(4);
 			}
 
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 				std::lock_guard<std::mutex> l(pOZWHardware->m_NotificationMutex);
 				reply::set_content(&rep, pOZWHardware->m_ozwcp.DoAdminCommand(sFun, atoi(sNode.c_str()), atoi(sButton.c_str())));
 			}
@@ -6402,12 +6402,12 @@ namespace http {
 			if (sNode.size() > 4)
 				sNode = sNode.substr(4);
 
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 				std::lock_guard<std::mutex> l(pOZWHardware->m_NotificationMutex);
 				reply::set_content(&rep, pOZWHardware->m_ozwcp.DoNodeChange(sFun, atoi(sNode.c_str()), sValue));
 			}
@@ -6428,10 +6428,10 @@ namespace http {
 
 			if (!sNode.empty() && !sGroup.empty() && !glist.empty())
 			{
-				CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
+				std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
 				if (pHardware != nullptr)
 				{
-					COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+					COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 					std::lock_guard<std::mutex> l(pOZWHardware->m_NotificationMutex);
 					reply::set_content(&rep, pOZWHardware->m_ozwcp.UpdateGroup(sFun, atoi(sNode.c_str()), atoi(sGroup.c_str()), glist));
 				}
@@ -6439,12 +6439,12 @@ namespace http {
 		}
 		void CWebServer::ZWaveCPGetTopo(WebEmSession& /*session*/, const request& /*req*/, reply& rep)
 		{
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 				std::lock_guard<std::mutex> l(pOZWHardware->m_NotificationMutex);
 				reply::set_content(&rep, pOZWHardware->m_ozwcp.GetCPTopo());
 				reply::add_header_attachment(&rep, "topo.xml");
@@ -6452,12 +6452,12 @@ namespace http {
 		}
 		void CWebServer::ZWaveCPGetStats(WebEmSession& /*session*/, const request& /*req*/, reply& rep)
 		{
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 				std::lock_guard<std::mutex> l(pOZWHardware->m_NotificationMutex);
 				reply::set_content(&rep, pOZWHardware->m_ozwcp.GetCPStats());
 				reply::add_header_attachment(&rep, "stats.xml");
@@ -6478,12 +6478,12 @@ namespace http {
 			request::makeValuesFromPostContent(&req, values);
 			std::string sFun = request::findValue(&values, "fun");
 
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(m_ZW_Hwidx);
 			if (pHardware == nullptr)
 				return;
 			if (pHardware->HwdType != HTYPE_OpenZWave)
 				return;
-			COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+			COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 			std::lock_guard<std::mutex> l(pOZWHardware->m_NotificationMutex);
 
 			if (sFun == "test")
@@ -6521,12 +6521,12 @@ namespace http {
 			std::string idx = request::findValue(&req, "idx");
 			if (idx.empty())
 				return;
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 				root["status"] = "OK";
 				root["title"] = "SetUserCodeEnrollmentMode";
 				pOZWHardware->SetUserCodeEnrollmentMode();
@@ -6554,12 +6554,12 @@ namespace http {
 				int hwid = atoi(result[0][0].c_str());
 				unsigned int homeID = static_cast<unsigned int>(std::stoul(result[0][1]));
 				uint8_t nodeID = (uint8_t)atoi(result[0][2].c_str());
-				CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(hwid);
+				std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(hwid);
 				if (pHardware != nullptr)
 				{
 					if (pHardware->HwdType != HTYPE_OpenZWave)
 						return;
-					COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+					COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 					if (!pOZWHardware->RemoveUserCode(homeID, nodeID, iCodeIndex))
 						return;
 					root["status"] = "OK";
@@ -6581,12 +6581,12 @@ namespace http {
 				int hwid = atoi(result[0][0].c_str());
 				unsigned int homeID = static_cast<unsigned int>(std::stoul(result[0][1]));
 				uint8_t nodeID = (uint8_t)atoi(result[0][2].c_str());
-				CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(hwid);
+				std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(hwid);
 				if (pHardware != nullptr)
 				{
 					if (pHardware->HwdType != HTYPE_OpenZWave)
 						return;
-					COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+					COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 					if (!pOZWHardware->GetNodeUserCodes(homeID, nodeID, root))
 						return;
 					root["status"] = "OK";
@@ -6601,12 +6601,12 @@ namespace http {
 			if (idx.empty())
 				return;
 
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_OpenZWave)
 					return;
-				COpenZWave* pOZWHardware = (COpenZWave*)pHardware;
+				COpenZWave* pOZWHardware = (COpenZWave*)pHardware.get();
 				if (!pOZWHardware->GetBatteryLevels(root))
 					return;
 				root["status"] = "OK";
@@ -87,10 +87,12 @@ public:
 		deviceType_WasteWater = 0x28
 	};
 
+protected:
+	void ParseP1Data(const uint8_t *pDataIn, int LenIn, bool disable_crc, int ratelimit);
+
 private:
 	void Init();
 	bool MatchLine();
-	void ParseP1Data(const uint8_t *pDataIn, int LenIn, bool disable_crc, int ratelimit);
 
 	bool CheckCRC();
 	void SendTextSensorWhenDifferent(const int ID, const int value, int &cmp_value, const std::string &Name);
@@ -614,12 +614,12 @@ void CPanasonicNode::SendCommand(const std::string& command)
 
 	if (m_CurrentStatus.Status() == MSTAT_OFF && !m_PowerOnSupported)
 	{
-		CDomoticzHardwareBase* pBaseHardware = m_mainworker.GetHardware(m_HwdID);
+		std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(m_HwdID);
 		if (pBaseHardware == nullptr)
 			return;
 		if (pBaseHardware->HwdType != HTYPE_PanasonicTV)
 			return;
-		CPanasonic* pHardware = dynamic_cast<CPanasonic*>(pBaseHardware);
+		CPanasonic* pHardware = dynamic_cast<CPanasonic*>(pBaseHardware.get());
 		if (pHardware->m_bTryIfOff) {
 			_log.Log(LOG_STATUS, "Panasonic Plugin: (%s) Device is Off, but with TryIfOff option, so trying anyway.", m_Name.c_str());
 		}
@@ -764,12 +764,12 @@ void CPanasonicNode::SendCommand(const std::string& command)
 		}
 	}
 	else {
-		CDomoticzHardwareBase* pBaseHardware = m_mainworker.GetHardware(m_HwdID);
+		std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(m_HwdID);
 		if (pBaseHardware == nullptr)
 			return;
 		if (pBaseHardware->HwdType != HTYPE_PanasonicTV)
 			return;
-		CPanasonic* pHardware = dynamic_cast<CPanasonic*>(pBaseHardware);
+		CPanasonic* pHardware = dynamic_cast<CPanasonic*>(pBaseHardware.get());
 		if (pHardware->m_bUnknownCommandAllowed) {
 			// Sanitize command : keep only alphanumeric characters
 			std::string sanityze = command;
@@ -1152,7 +1152,7 @@ namespace http {
 			if (hwid.empty())
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pHardware == nullptr)
 				return;
 			if (pHardware->HwdType != HTYPE_PanasonicTV)
@@ -1193,12 +1193,12 @@ namespace http {
 			if ((hwid.empty()) || (mode1.empty()) || (mode2.empty()))
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase* pBaseHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pBaseHardware == nullptr)
 				return;
 			if (pBaseHardware->HwdType != HTYPE_PanasonicTV)
 				return;
-			CPanasonic* pHardware = dynamic_cast<CPanasonic*>(pBaseHardware);
+			CPanasonic* pHardware = dynamic_cast<CPanasonic*>(pBaseHardware.get());
 
 			root["status"] = "OK";
 			root["title"] = "PanasonicSetMode";
@@ -1229,12 +1229,12 @@ namespace http {
 			if ((hwid.empty()) || (name.empty()) || (ip.empty()) || (Port == 0))
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase* pBaseHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pBaseHardware == nullptr)
 				return;
 			if (pBaseHardware->HwdType != HTYPE_PanasonicTV)
 				return;
-			CPanasonic* pHardware = dynamic_cast<CPanasonic*>(pBaseHardware);
+			CPanasonic* pHardware = dynamic_cast<CPanasonic*>(pBaseHardware.get());
 
 			root["status"] = "OK";
 			root["title"] = "PanasonicAddNode";
@@ -1257,12 +1257,12 @@ namespace http {
 			if ((hwid.empty()) || (nodeid.empty()) || (name.empty()) || (ip.empty()) || (Port == 0))
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase* pBaseHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pBaseHardware == nullptr)
 				return;
 			if (pBaseHardware->HwdType != HTYPE_PanasonicTV)
 				return;
-			CPanasonic* pHardware = dynamic_cast<CPanasonic*>(pBaseHardware);
+			CPanasonic* pHardware = dynamic_cast<CPanasonic*>(pBaseHardware.get());
 
 			int NodeID = atoi(nodeid.c_str());
 			root["status"] = "OK";
@@ -1283,12 +1283,12 @@ namespace http {
 			if ((hwid.empty()) || (nodeid.empty()))
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase* pBaseHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pBaseHardware == nullptr)
 				return;
 			if (pBaseHardware->HwdType != HTYPE_PanasonicTV)
 				return;
-			CPanasonic* pHardware = dynamic_cast<CPanasonic*>(pBaseHardware);
+			CPanasonic* pHardware = dynamic_cast<CPanasonic*>(pBaseHardware.get());
 
 			int NodeID = atoi(nodeid.c_str());
 			root["status"] = "OK";
@@ -1308,12 +1308,12 @@ namespace http {
 			if (hwid.empty())
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase* pBaseHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pBaseHardware == nullptr)
 				return;
 			if (pBaseHardware->HwdType != HTYPE_PanasonicTV)
 				return;
-			CPanasonic* pHardware = dynamic_cast<CPanasonic*>(pBaseHardware);
+			CPanasonic* pHardware = dynamic_cast<CPanasonic*>(pBaseHardware.get());
 
 			root["status"] = "OK";
 			root["title"] = "PanasonicClearNodes";
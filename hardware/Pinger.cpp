@@ -461,7 +461,7 @@ namespace http {
 			if (hwid.empty())
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase *pHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pHardware == nullptr)
 				return;
 			if (pHardware->HwdType != HTYPE_Pinger)
@@ -500,12 +500,12 @@ namespace http {
 			if ((hwid.empty()) || (mode1.empty()) || (mode2.empty()))
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase *pBaseHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pBaseHardware == nullptr)
 				return;
 			if (pBaseHardware->HwdType != HTYPE_Pinger)
 				return;
-			CPinger *pHardware = dynamic_cast<CPinger*>(pBaseHardware);
+			CPinger *pHardware = dynamic_cast<CPinger*>(pBaseHardware.get());
 
 			root["status"] = "OK";
 			root["title"] = "PingerSetMode";
@@ -538,12 +538,12 @@ namespace http {
 			if ((hwid.empty()) || (name.empty()) || (ip.empty()) || (Timeout == 0))
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase *pBaseHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pBaseHardware == nullptr)
 				return;
 			if (pBaseHardware->HwdType != HTYPE_Pinger)
 				return;
-			CPinger *pHardware = dynamic_cast<CPinger*>(pBaseHardware);
+			CPinger *pHardware = dynamic_cast<CPinger*>(pBaseHardware.get());
 
 			root["status"] = "OK";
 			root["title"] = "PingerAddNode";
@@ -566,12 +566,12 @@ namespace http {
 			if ((hwid.empty()) || (nodeid.empty()) || (name.empty()) || (ip.empty()) || (Timeout == 0))
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase *pBaseHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pBaseHardware == nullptr)
 				return;
 			if (pBaseHardware->HwdType != HTYPE_Pinger)
 				return;
-			CPinger *pHardware = dynamic_cast<CPinger*>(pBaseHardware);
+			CPinger *pHardware = dynamic_cast<CPinger*>(pBaseHardware.get());
 
 			int NodeID = atoi(nodeid.c_str());
 			root["status"] = "OK";
@@ -592,12 +592,12 @@ namespace http {
 			if ((hwid.empty()) || (nodeid.empty()))
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase *pBaseHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pBaseHardware == nullptr)
 				return;
 			if (pBaseHardware->HwdType != HTYPE_Pinger)
 				return;
-			CPinger *pHardware = dynamic_cast<CPinger*>(pBaseHardware);
+			CPinger *pHardware = dynamic_cast<CPinger*>(pBaseHardware.get());
 
 			int NodeID = atoi(nodeid.c_str());
 			root["status"] = "OK";
@@ -617,12 +617,12 @@ namespace http {
 			if (hwid.empty())
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase *pBaseHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pBaseHardware == nullptr)
 				return;
 			if (pBaseHardware->HwdType != HTYPE_Pinger)
 				return;
-			CPinger *pHardware = dynamic_cast<CPinger*>(pBaseHardware);
+			CPinger *pHardware = dynamic_cast<CPinger*>(pBaseHardware.get());
 
 			root["status"] = "OK";
 			root["title"] = "PingerClearNodes";
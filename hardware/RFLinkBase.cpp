@@ -1185,7 +1185,7 @@ namespace http {
 			#endif
 
 			bool bCreated = false;						// flag to know if the command was a success
-			CRFLinkBase *pRFLINK = dynamic_cast<CRFLinkBase*>(m_mainworker.GetHardware(atoi(idx.c_str())));
+			std::shared_ptr<CRFLinkBase> pRFLINK = std::dynamic_pointer_cast<CRFLinkBase>(m_mainworker.GetHardware(atoi(idx.c_str())));
 			if (pRFLINK == nullptr)
 				return;
 
@@ -111,6 +111,7 @@ CRFLinkMQTT::CRFLinkMQTT(const int ID, const std::string &IPAddress, const unsig
 
 CRFLinkMQTT::~CRFLinkMQTT(void)
 {
+	stop_replay();
 	mosqdz::lib_cleanup();
 }
 
@@ -192,6 +193,7 @@ bool CRFLinkMQTT::StopHardware()
 		//Don't throw from a Stop command
 		_log.Log(LOG_ERROR, ">>> RFLINK MQTT: Something awkward is happened...");
 	}
+	stop_replay();
 
 	if (m_sDeviceReceivedConnection.connected())
 		m_sDeviceReceivedConnection.disconnect();
@@ -875,7 +875,7 @@ namespace http {
 				return;
 			}
 
-			CDomoticzHardwareBase *pHardware = nullptr;
+			std::shared_ptr<CDomoticzHardwareBase> pHardware;
 			if ((!hardwareid.empty()) && (hardwareid != "undefined"))
 			{
 				pHardware = m_mainworker.GetHardware(atoi(hardwareid.c_str()));
@@ -912,7 +912,7 @@ namespace http {
 				(pHardware->HwdType == HTYPE_RFXtrx868)
 				)
 			{
-				RFXComSerial *pRFXComSerial = dynamic_cast<RFXComSerial *>(pHardware);
+				RFXComSerial *pRFXComSerial = dynamic_cast<RFXComSerial *>(pHardware.get());
 				pRFXComSerial->UploadFirmware(outputfile);
 			}
 		}
@@ -984,10 +984,10 @@ namespace http {
 				Response.IRESPONSE.KEELOQenabled = (request::findValue(&req, "Keeloq") == "on") ? 1 : 0;
 				Response.IRESPONSE.HCEnabled = (request::findValue(&req, "HC") == "on") ? 1 : 0;
 
-				CDomoticzHardwareBase *pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
+				std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(idx.c_str()));
 				if (pHardware)
 				{
-					CRFXBase *pBase = dynamic_cast<CRFXBase *>(pHardware);
+					CRFXBase *pBase = dynamic_cast<CRFXBase *>(pHardware.get());
 					pBase->SetRFXCOMHardwaremodes(Response.ICMND.freqsel, Response.ICMND.xmitpwr, Response.ICMND.msg3, Response.ICMND.msg4, Response.ICMND.msg5, Response.ICMND.msg6);
 
 					if (pBase->m_Version.find("Pro XL") != std::string::npos)
@@ -1012,7 +1012,7 @@ namespace http {
 			root["title"] = "GetFirmwareUpgradePercentage";
 			std::string hardwareid = request::findValue(&req, "hardwareid");
 
-			CDomoticzHardwareBase *pHardware = nullptr;
+			std::shared_ptr<CDomoticzHardwareBase> pHardware;
 			if ((!hardwareid.empty()) && (hardwareid != "undefined"))
 			{
 				pHardware = m_mainworker.GetHardware(atoi(hardwareid.c_str()));
@@ -1034,7 +1034,7 @@ namespace http {
 					(pHardware->HwdType == HTYPE_RFXtrx868)
 					)
 				{
-					RFXComSerial *pRFXComSerial = dynamic_cast<RFXComSerial *>(pHardware);
+					RFXComSerial *pRFXComSerial = dynamic_cast<RFXComSerial *>(pHardware.get());
 					root["status"] = "OK";
 					root["percentage"] = pRFXComSerial->GetUploadPercentage();
 					root["message"] = pRFXComSerial->GetUploadMessage();
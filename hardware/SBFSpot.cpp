@@ -645,12 +645,12 @@ namespace http {
 				return;
 			}
 			int hardwareID = atoi(idx.c_str());
-			CDomoticzHardwareBase *pHardware = m_mainworker.GetHardware(hardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(hardwareID);
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType == HTYPE_SBFSpot)
 				{
-					CSBFSpot *pSBFSpot = dynamic_cast<CSBFSpot *>(pHardware);
+					CSBFSpot *pSBFSpot = dynamic_cast<CSBFSpot *>(pHardware.get());
 					pSBFSpot->ImportOldMonthData();
 				}
 			}
@@ -75,6 +75,7 @@ CTTNMQTT::CTTNMQTT(const int ID, const std::string &IPAddress, const unsigned sh
 
 CTTNMQTT::~CTTNMQTT()
 {
+	stop_replay();
 	mosqdz::lib_cleanup();
 }
 
@@ -196,6 +197,7 @@ bool CTTNMQTT::StopHardware()
 		m_thread->join();
 		m_thread.reset();
 	}
+	stop_replay();
 	m_IsConnected = false;
 	return true;
 }
@@ -340,12 +340,12 @@ namespace http {
             m_sql.safe_query("UPDATE Hardware SET Mode1=%d, Mode2=%d WHERE (ID == %d)",
                              repeats, repeatInterval, hwID);
 
-            CDomoticzHardwareBase *pBaseHardware = m_mainworker.GetHardware(hwID);
+            std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(hwID);
 	    if (pBaseHardware == nullptr)
 		    return;
 	    if (pBaseHardware->HwdType != HTYPE_Tellstick)
 		    return;
-	    CTellstick *pTellstick = reinterpret_cast<CTellstick *>(pBaseHardware);
+	    CTellstick *pTellstick = reinterpret_cast<CTellstick *>(pBaseHardware.get());
 	    pTellstick->SetSettings(repeats, repeatInterval);
 	}
     } // namespace server
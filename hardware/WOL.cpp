@@ -255,7 +255,7 @@ namespace http {
 			if (hwid.empty())
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase *pHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pHardware == nullptr)
 				return;
 			if (pHardware->HwdType != HTYPE_WOL)
@@ -294,12 +294,12 @@ namespace http {
 			if ((hwid.empty()) || (name.empty()) || (mac.empty()))
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase *pBaseHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pBaseHardware == nullptr)
 				return;
 			if (pBaseHardware->HwdType != HTYPE_WOL)
 				return;
-			CWOL *pHardware = dynamic_cast<CWOL*>(pBaseHardware);
+			CWOL *pHardware = dynamic_cast<CWOL*>(pBaseHardware.get());
 
 			root["status"] = "OK";
 			root["title"] = "WOLAddNode";
@@ -321,12 +321,12 @@ namespace http {
 			if ((hwid.empty()) || (nodeid.empty()) || (name.empty()) || (mac.empty()))
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase *pBaseHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pBaseHardware == nullptr)
 				return;
 			if (pBaseHardware->HwdType != HTYPE_WOL)
 				return;
-			CWOL *pHardware = dynamic_cast<CWOL*>(pBaseHardware);
+			CWOL *pHardware = dynamic_cast<CWOL*>(pBaseHardware.get());
 
 			int NodeID = atoi(nodeid.c_str());
 			root["status"] = "OK";
@@ -347,12 +347,12 @@ namespace http {
 			if ((hwid.empty()) || (nodeid.empty()))
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase *pBaseHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pBaseHardware == nullptr)
 				return;
 			if (pBaseHardware->HwdType != HTYPE_WOL)
 				return;
-			CWOL *pHardware = dynamic_cast<CWOL*>(pBaseHardware);
+			CWOL *pHardware = dynamic_cast<CWOL*>(pBaseHardware.get());
 
 			int NodeID = atoi(nodeid.c_str());
 			root["status"] = "OK";
@@ -372,12 +372,12 @@ namespace http {
 			if (hwid.empty())
 				return;
 			int iHardwareID = atoi(hwid.c_str());
-			CDomoticzHardwareBase *pBaseHardware = m_mainworker.GetHardware(iHardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(iHardwareID);
 			if (pBaseHardware == nullptr)
 				return;
 			if (pBaseHardware->HwdType != HTYPE_WOL)
 				return;
-			CWOL *pHardware = dynamic_cast<CWOL*>(pBaseHardware);
+			CWOL *pHardware = dynamic_cast<CWOL*>(pBaseHardware.get());
 
 			root["status"] = "OK";
 			root["title"] = "WOLClearNodes";
@@ -65,7 +65,6 @@ namespace Plugins {
 	// PyMODINIT_FUNC PyInit_DomoticzEvents(void);
 
 	std::mutex PluginMutex;	// controls accessto the message queue and m_pPlugins map
-	boost::asio::io_service ios;
 
 	std::map<int, CDomoticzHardwareBase*>	CPluginSystem::m_pPlugins;
 	std::map<std::string, std::string>		CPluginSystem::m_PluginXml;
@@ -295,12 +294,6 @@ namespace Plugins {
 		}
 	}
 
-	void BoostWorkers()
-	{
-		
-		ios.run();
-	}
-
 	void CPluginSystem::Do_Work()
 	{
 		while (!m_bAllPluginsStarted && !IsStopRequested(500))
@@ -313,25 +306,11 @@ namespace Plugins {
 			_log.Log(LOG_STATUS, "PluginSystem: %d plugins started.", (int)m_pPlugins.size());
 		}
 
-		// Create initial IO Service thread
-		ios.restart();
-		// Create some work to keep IO Service alive
-		auto work = boost::asio::io_service::work(ios);
-		boost::thread_group BoostThreads;
-		for (int i = 0; i < 1; i++)
-		{
-			boost::thread*	bt = BoostThreads.create_thread(BoostWorkers);
-			SetThreadName(bt->native_handle(), "Plugin_ASIO");
-		}
-
+		// Transport IO runs on the shared io_service pool (m_iopool)
 		while (!IsStopRequested(500))
 		{
 		}
 
-		// Shutdown IO workers
-		ios.stop();
-		BoostThreads.join_all();
-
 		_log.Log(LOG_STATUS, "PluginSystem: Exited work loop.");
 	}
 
@@ -344,13 +323,13 @@ namespace Plugins {
 		std::vector<std::string> sd = result[0];
 		std::string sHwdID = sd[0];
 		std::string Unit = sd[2];
-		CDomoticzHardwareBase *pHardware = m_mainworker.GetHardwareByIDType(sHwdID, HTYPE_PythonPlugin);
+		std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardwareByIDType(sHwdID, HTYPE_PythonPlugin);
 		if (pHardware == nullptr)
 			return;
 		//std::vector<std::string> sd = result[0];
 		//GizMoCuz: Why does this work with UNIT ? Why not use the device idx which is always unique ?
 		_log.Debug(DEBUG_NORM, "CPluginSystem::DeviceModified: Notifying plugin %u about modification of device %u", atoi(sHwdID.c_str()), atoi(Unit.c_str()));
-		Plugins::CPlugin *pPlugin = (Plugins::CPlugin*)pHardware;
+		Plugins::CPlugin *pPlugin = (Plugins::CPlugin*)pHardware.get();
 		pPlugin->DeviceModified(sd[1], atoi(Unit.c_str()));
 	}
 } // namespace Plugins
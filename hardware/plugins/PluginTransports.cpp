@@ -24,10 +24,10 @@ namespace Plugins {
 			// Set up timeout if one was requested
 			if (!m_Timer)
 			{
-				m_Timer = new boost::asio::deadline_timer(ios);
+				m_Timer = new boost::asio::deadline_timer(m_Connection.GetIoContext());
 			}
 			m_Timer->expires_from_now(boost::posix_time::milliseconds(m_pConnection->Timeout));
-			m_Timer->async_wait([this](const boost::system::error_code &ec) { handleTimeout(ec); });
+			m_Timer->async_wait(m_Connection.wrap([this](const boost::system::error_code &ec) { handleTimeout(ec); }));
 		}
 		else
 		{
@@ -114,7 +114,7 @@ namespace Plugins {
 			{
 				m_bConnecting = false;
 				m_bConnected = false;
-				m_Socket = new boost::asio::ip::tcp::socket(ios);
+				m_Socket = new boost::asio::ip::tcp::socket(m_Connection.GetIoContext());
 
 				boost::system::error_code ec;
 				boost::asio::ip::tcp::resolver::query query(m_IP, m_Port);
@@ -124,7 +124,7 @@ namespace Plugins {
 				//
 				//	Async resolve/connect based on http://www.boost.org/doc/libs/1_45_0/doc/html/boost_asio/example/http/client/async_client.cpp
 				//
-				m_Resolver.async_resolve(query, [this](auto &&err, auto end) { handleAsyncResolve(err, end); });
+				m_Resolver.async_resolve(query, m_Connection.wrap([this](auto &&err, auto end) { handleAsyncResolve(err, end); }));
 			}
 		}
 		catch (std::exception& e)
@@ -147,7 +147,7 @@ namespace Plugins {
 		if (!err)
 		{
 			boost::asio::ip::tcp::endpoint endpoint = *endpoint_iterator;
-			m_Socket->async_connect(endpoint, [this, endpoint_iterator](auto &&err) mutable { handleAsyncConnect(err, ++endpoint_iterator); });
+			m_Socket->async_connect(endpoint, m_Connection.wrap([this, endpoint_iterator](auto &&err) mutable { handleAsyncConnect(err, ++endpoint_iterator); }));
 		}
 		else
 		{
@@ -182,7 +182,7 @@ namespace Plugins {
 		{
 			m_bConnected = true;
 			m_tLastSeen = time(nullptr);
-			m_Socket->async_read_some(boost::asio::buffer(m_Buffer, sizeof m_Buffer), [this](auto &&err, auto bytes) { handleRead(err, bytes); });
+			m_Socket->async_read_some(boost::asio::buffer(m_Buffer, sizeof m_Buffer), m_Connection.wrap([this](auto &&err, auto bytes) { handleRead(err, bytes); }));
 			configureTimeout();
 		}
 		else
@@ -204,15 +204,15 @@ namespace Plugins {
 			{
 				if (!m_Acceptor)
 				{
-					m_Acceptor = new boost::asio::ip::tcp::acceptor(ios, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), atoi(m_Port.c_str())));
+					m_Acceptor = new boost::asio::ip::tcp::acceptor(m_Connection.GetIoContext(), boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), atoi(m_Port.c_str())));
 				}
 				boost::system::error_code ec;
 
 				//
 				//	Acceptor based on http://www.boost.org/doc/libs/1_62_0/doc/html/boost_asio/tutorial/tutdaytime3/src.html
 				//
-				auto pSocket = new boost::asio::ip::tcp::socket(ios);
-				m_Acceptor->async_accept(*pSocket, [this, pSocket](auto &&err) { handleAsyncAccept(pSocket, err); });
+				auto pSocket = new boost::asio::ip::tcp::socket(m_Connection.GetIoContext());
+				m_Acceptor->async_accept(*pSocket, m_Connection.wrap([this, pSocket](auto &&err) { handleAsyncAccept(pSocket, err); }));
 				m_bConnecting = true;
 			}
 		}
@@ -285,7 +285,7 @@ namespace Plugins {
 			}
 
 			pTcpTransport->m_Socket->async_read_some(boost::asio::buffer(pTcpTransport->m_Buffer, sizeof pTcpTransport->m_Buffer),
-								 [pTcpTransport](auto &&err, auto bytes) { pTcpTransport->handleRead(err, bytes); });
+								 pTcpTransport->m_Connection.wrap([pTcpTransport](auto &&err, auto bytes) { pTcpTransport->handleRead(err, bytes); }));
 
 			// Requeue listener
 			if (m_Acceptor)
@@ -322,7 +322,7 @@ namespace Plugins {
 			//ready for next read
 			if (m_Socket)
 			{
-				m_Socket->async_read_some(boost::asio::buffer(m_Buffer, sizeof m_Buffer), [this](auto &&err, auto bytes) { handleRead(err, bytes); });
+				m_Socket->async_read_some(boost::asio::buffer(m_Buffer, sizeof m_Buffer), m_Connection.wrap([this](auto &&err, auto bytes) { handleRead(err, bytes); }));
 				configureTimeout();
 			}
 		}
@@ -511,7 +511,7 @@ namespace Plugins {
 				pPlugin->MessagePlugin(new onConnectCallback(m_pConnection, err.value(), err.message()));
 
 				m_tLastSeen = time(nullptr);
-				m_TLSSock->async_read_some(boost::asio::buffer(m_Buffer, sizeof m_Buffer), [this](auto &&err, auto bytes) { handleRead(err, bytes); });
+				m_TLSSock->async_read_some(boost::asio::buffer(m_Buffer, sizeof m_Buffer), m_Connection.wrap([this](auto &&err, auto bytes) { handleRead(err, bytes); }));
 				configureTimeout();
 			}
 			catch (boost::system::system_error se)
@@ -575,7 +575,7 @@ namespace Plugins {
 			//ready for next read
 			if (m_TLSSock)
 			{
-				m_TLSSock->async_read_some(boost::asio::buffer(m_Buffer, sizeof m_Buffer), [this](auto &&err, auto bytes) { handleRead(err, bytes); });
+				m_TLSSock->async_read_some(boost::asio::buffer(m_Buffer, sizeof m_Buffer), m_Connection.wrap([this](auto &&err, auto bytes) { handleRead(err, bytes); }));
 				configureTimeout();
 			}
 		}
@@ -637,13 +637,13 @@ namespace Plugins {
 				// Handle broadcast messages
 				if (m_IP == "255.255.255.255")
 				{
-					m_Socket = new boost::asio::ip::udp::socket(ios, boost::asio::ip::udp::endpoint(boost::asio::ip::address_v4::any(), iPort));
+					m_Socket = new boost::asio::ip::udp::socket(m_Connection.GetIoContext(), boost::asio::ip::udp::endpoint(boost::asio::ip::address_v4::any(), iPort));
 					m_Socket->set_option(boost::asio::ip::udp::socket::socket_base::broadcast(true));
 					m_Socket->set_option(boost::asio::ip::udp::socket::reuse_address(true));
 				}
 				else
 				{
-					m_Socket = new boost::asio::ip::udp::socket(ios, boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), iPort));
+					m_Socket = new boost::asio::ip::udp::socket(m_Connection.GetIoContext(), boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), iPort));
 					m_Socket->set_option(boost::asio::ip::udp::socket::reuse_address(true));
 					// Hanlde multicast
 					if (((m_IP.substr(0, 4) >= "224.") && (m_IP.substr(0, 4) <= "239.")) || (m_IP.substr(0, 4) == "255."))
@@ -654,7 +654,7 @@ namespace Plugins {
 				}
 			}
 
-			m_Socket->async_receive_from(boost::asio::buffer(m_Buffer, sizeof m_Buffer), m_remote_endpoint, [this](auto &&err, auto bytes) { handleRead(err, bytes); });
+			m_Socket->async_receive_from(boost::asio::buffer(m_Buffer, sizeof m_Buffer), m_remote_endpoint, m_Connection.wrap([this](auto &&err, auto bytes) { handleRead(err, bytes); }));
 
 			m_bConnected = true;
 		}
@@ -750,7 +750,7 @@ namespace Plugins {
 			if (!m_Socket)
 			{
 				boost::system::error_code  err;
-				m_Socket = new boost::asio::ip::udp::socket(ios);
+				m_Socket = new boost::asio::ip::udp::socket(m_Connection.GetIoContext());
 				m_Socket->open(boost::asio::ip::udp::v4(), err);
 				m_Socket->set_option(boost::asio::ip::udp::socket::reuse_address(true));
 			}
@@ -837,7 +837,7 @@ namespace Plugins {
 			std::vector<byte>	vBody(&body[0], &body[body.length()]);
 			handleWrite(vBody);
 
-			m_Socket->async_receive_from(boost::asio::buffer(m_Buffer, sizeof m_Buffer), m_Endpoint, [this](auto &&err, auto bytes) { handleRead(err, bytes); });
+			m_Socket->async_receive_from(boost::asio::buffer(m_Buffer, sizeof m_Buffer), m_Endpoint, m_Connection.wrap([this](auto &&err, auto bytes) { handleRead(err, bytes); }));
 		}
 		else
 		{
@@ -855,7 +855,7 @@ namespace Plugins {
 			if (!m_bConnected)
 			{
 				m_bConnecting = true;
-				m_Socket = new boost::asio::ip::icmp::socket(ios, boost::asio::ip::icmp::v4());
+				m_Socket = new boost::asio::ip::icmp::socket(m_Connection.GetIoContext(), boost::asio::ip::icmp::v4());
 
 				boost::system::error_code ec;
 				boost::asio::ip::icmp::resolver::query query(boost::asio::ip::icmp::v4(), m_IP, "");
@@ -865,11 +865,11 @@ namespace Plugins {
 				//
 				//	Async resolve/connect based on http://www.boost.org/doc/libs/1_51_0/doc/html/boost_asio/example/icmp/ping.cpp
 				//
-				m_Resolver.async_resolve(query, [this](auto &&err, auto i) { handleAsyncResolve(err, i); });
+				m_Resolver.async_resolve(query, m_Connection.wrap([this](auto &&err, auto i) { handleAsyncResolve(err, i); }));
 			}
 			else
 			{
-				m_Socket->async_receive_from(boost::asio::buffer(m_Buffer, sizeof m_Buffer), m_Endpoint, [this](auto &&err, auto bytes) { handleRead(err, bytes); });
+				m_Socket->async_receive_from(boost::asio::buffer(m_Buffer, sizeof m_Buffer), m_Endpoint, m_Connection.wrap([this](auto &&err, auto bytes) { handleRead(err, bytes); }));
 			}
 
 			m_pConnection->pPlugin->MessagePlugin(new ProtocolDirective(m_pConnection));
@@ -993,10 +993,10 @@ namespace Plugins {
 		// Reset timeout if one is set or set one
 		if (!m_Timer)
 		{
-			m_Timer = new boost::asio::deadline_timer(ios);
+			m_Timer = new boost::asio::deadline_timer(m_Connection.GetIoContext());
 		}
 		m_Timer->expires_from_now(boost::posix_time::seconds(5));
-		m_Timer->async_wait([this](auto &&err) { handleTimeout(err); });
+		m_Timer->async_wait(m_Connection.wrap([this](auto &&err) { handleTimeout(err); }));
 
 		// Create an ICMP header for an echo request.
 		icmp_header echo_request;
@@ -1,13 +1,12 @@
 #pragma once
 
 #include "../ASyncSerial.h"
+#include "../../main/IoContextPool.h"
 #include <boost/asio.hpp>
 #include <ctime>
 
 namespace Plugins {
 
-	extern boost::asio::io_service ios;
-
 	class CPluginTransport
 	{
 	protected:
@@ -24,12 +23,14 @@ namespace Plugins {
 
 		CConnection *	m_pConnection;
 
+		CIoConnection	m_Connection; // handlers run on this strand of the shared io_service pool
+
 	protected:
 		boost::asio::deadline_timer *m_Timer;
 		virtual void configureTimeout();
 
 	      public:
-		CPluginTransport(int HwdID, CConnection *pConnection) : m_HwdID(HwdID), m_pConnection(pConnection), m_bDisconnectQueued(false), m_bConnecting(false), m_bConnected(false), m_iTotalBytes(0), m_tLastSeen(0), m_Timer(NULL)
+		CPluginTransport(int HwdID, CConnection *pConnection) : m_HwdID(HwdID), m_pConnection(pConnection), m_Connection("Plugin " + std::to_string(HwdID)), m_bDisconnectQueued(false), m_bConnecting(false), m_bConnected(false), m_iTotalBytes(0), m_tLastSeen(0), m_Timer(NULL)
 	  {
 		  Py_INCREF(m_pConnection);
 	  };
@@ -68,6 +69,7 @@ namespace Plugins {
 			, m_IP(Address)
 		{
 			m_Port = Port;
+			m_Connection.SetName("Plugin " + std::to_string(HwdID) + " " + Address + ":" + Port);
 		};
 		bool AsyncDisconnect() override
 		{
@@ -80,7 +82,7 @@ namespace Plugins {
 	public:
 		CPluginTransportTCP(int HwdID, CConnection *pConnection, const std::string &Address, const std::string &Port)
 		  : CPluginTransportIP(HwdID, pConnection, Address, Port)
-		  , m_Resolver(ios)
+		  , m_Resolver(m_Connection.GetIoContext())
 		  , m_Acceptor(nullptr)
 		  , m_Socket(nullptr){};
 	  bool handleConnect() override;
@@ -128,7 +130,7 @@ namespace Plugins {
 	public:
 		CPluginTransportUDP(int HwdID, CConnection *pConnection, const std::string &Address, const std::string &Port)
 		  : CPluginTransportIP(HwdID, pConnection, Address, Port)
-		  , m_Resolver(ios)
+		  , m_Resolver(m_Connection.GetIoContext())
 		  , m_Socket(nullptr){};
 	  bool handleListen() override;
 	  void handleRead(const boost::system::error_code &e, std::size_t bytes_transferred) override;
@@ -147,7 +149,7 @@ namespace Plugins {
 	public:
 		CPluginTransportICMP(int HwdID, CConnection *pConnection, const std::string &Address, const std::string &Port)
 		  : CPluginTransportIP(HwdID, pConnection, Address, Port)
-		  , m_Resolver(ios)
+		  , m_Resolver(m_Connection.GetIoContext())
 		  , m_Socket(nullptr)
 		  , m_Timer(nullptr)
 		  , m_SequenceNo(-1){};
@@ -2,9 +2,12 @@
 #include "HTTPClient.h"
 #include <curl/curl.h>
 #include "../main/Logger.h"
+#include "../main/Helper.h"
 
 #include <algorithm>
+#include <condition_variable>
 #include <iostream>
+#include <set>
 #include <fstream>
 
 #ifndef O_LARGEFILE
@@ -20,6 +23,53 @@ long		HTTPClient::m_iConnectionTimeout = 10;
 long		HTTPClient::m_iTimeout = 90; //max, time that a download has to be finished?
 std::string	HTTPClient::m_sUserAgent = "domoticz/1.0";
 
+//Easy handles are reused, curl_easy_reset keeps their open connections. All handles
+//share the DNS, TLS session, connection and cookie caches.
+#define HTTPCLIENT_MAX_IDLE_HANDLES 8
+
+namespace
+{
+	std::mutex m_curl_init_mutex;
+	CURLSH *m_curl_share = nullptr;
+	std::mutex m_curl_share_mutex[CURL_LOCK_DATA_LAST];
+
+	std::mutex m_curl_handles_mutex;
+	std::vector<CURL *> m_curl_idle_handles;
+
+	struct _tHTTPAsyncRequest
+	{
+		uint64_t id = 0;
+		HTTPClient::_eHTTPmethod method = HTTPClient::HTTP_METHOD_GET;
+		CURL *curl = nullptr;
+		struct curl_slist *headers = nullptr;
+		std::string url;
+		std::string data;
+		std::vector<unsigned char> response;
+		std::vector<std::string> vHeaderData;
+		HTTPClient::THTTPCallback callback;
+	};
+
+	std::mutex m_async_mutex;
+	std::condition_variable m_async_cond;
+	std::vector<_tHTTPAsyncRequest *> m_async_queue;
+	std::set<uint64_t> m_async_pending; // queued or running, the callback is still to be called
+	std::vector<uint64_t> m_async_cancelled; // running requests the engine has to remove
+	uint64_t m_async_next_id = 1;
+	std::shared_ptr<std::thread> m_async_thread;
+	CURLM *m_async_multi = nullptr;
+	bool m_bAsyncStop = false;
+
+	void curl_share_lock(CURL * /*handle*/, curl_lock_data data, curl_lock_access /*access*/, void * /*userptr*/)
+	{
+		m_curl_share_mutex[data].lock();
+	}
+
+	void curl_share_unlock(CURL * /*handle*/, curl_lock_data data, void * /*userptr*/)
+	{
+		m_curl_share_mutex[data].unlock();
+	}
+} // namespace
+
 
 /************************************************************************
  *									*
@@ -76,24 +126,86 @@ size_t write_curl_data_single_line(void *contents, size_t size, size_t nmemb, vo
 
 bool HTTPClient::CheckIfGlobalInitDone()
 {
+	std::lock_guard<std::mutex> l(m_curl_init_mutex);
 	if (!m_bCurlGlobalInitialized)
 	{
 		CURLcode res = curl_global_init(CURL_GLOBAL_ALL);
 		if (res != CURLE_OK)
 			return false;
 		m_bCurlGlobalInitialized = true;
+
+		m_curl_share = curl_share_init();
+		if (m_curl_share != nullptr)
+		{
+			curl_share_setopt(m_curl_share, CURLSHOPT_LOCKFUNC, curl_share_lock);
+			curl_share_setopt(m_curl_share, CURLSHOPT_UNLOCKFUNC, curl_share_unlock);
+			curl_share_setopt(m_curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+			curl_share_setopt(m_curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+			curl_share_setopt(m_curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_COOKIE);
+#if LIBCURL_VERSION_NUM >= 0x073900
+			curl_share_setopt(m_curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+		}
 	}
 	return true;
 }
 
 void HTTPClient::Cleanup()
 {
+	StopAsync();
+
+	std::lock_guard<std::mutex> l(m_curl_init_mutex);
 	if (m_bCurlGlobalInitialized)
 	{
+		{
+			std::lock_guard<std::mutex> l2(m_curl_handles_mutex);
+			for (auto curl : m_curl_idle_handles)
+				curl_easy_cleanup(curl);
+			m_curl_idle_handles.clear();
+		}
+		if (m_curl_share != nullptr)
+		{
+			if (curl_share_cleanup(m_curl_share) == CURLSHE_OK)
+				m_curl_share = nullptr;
+		}
 		curl_global_cleanup();
 	}
 }
 
+void *HTTPClient::GetHandle()
+{
+	{
+		std::lock_guard<std::mutex> l(m_curl_handles_mutex);
+		if (!m_curl_idle_handles.empty())
+		{
+			CURL *curl = m_curl_idle_handles.back();
+			m_curl_idle_handles.pop_back();
+			return curl;
+		}
+	}
+	CURL *curl = curl_easy_init();
+	if ((curl != nullptr) && (m_curl_share != nullptr))
+		curl_easy_setopt(curl, CURLOPT_SHARE, m_curl_share);
+	return curl;
+}
+
+void HTTPClient::ReleaseHandle(void *curlobj)
+{
+	CURL *curl = (CURL *)curlobj;
+	//write the cookie jar, this used to happen when the handle was cleaned up
+	curl_easy_setopt(curl, CURLOPT_COOKIELIST, "FLUSH");
+	curl_easy_reset(curl);
+	{
+		std::lock_guard<std::mutex> l(m_curl_handles_mutex);
+		if (m_curl_idle_handles.size() < HTTPCLIENT_MAX_IDLE_HANDLES)
+		{
+			m_curl_idle_handles.push_back(curl);
+			return;
+		}
+	}
+	curl_easy_cleanup(curl);
+}
+
 void HTTPClient::SetGlobalOptions(void *curlobj)
 {
 	CURL *curl=(CURL *)curlobj;
@@ -235,7 +347,7 @@ bool HTTPClient::GETBinary(const std::string &url, const std::vector<std::string
 	{
 		if (!CheckIfGlobalInitDone())
 			return false;
-		CURL *curl = curl_easy_init();
+		CURL *curl = (CURL *)GetHandle();
 		if (!curl)
 			return false;
 
@@ -283,7 +395,7 @@ bool HTTPClient::GETBinary(const std::string &url, const std::vector<std::string
 			}
 		}
 
-		curl_easy_cleanup(curl);
+		ReleaseHandle(curl);
 
 		if (headers != nullptr)
 		{
@@ -306,7 +418,7 @@ bool HTTPClient::POSTBinary(const std::string &url, const std::string &postdata,
 	{
 		if (!CheckIfGlobalInitDone())
 			return false;
-		CURL *curl = curl_easy_init();
+		CURL *curl = (CURL *)GetHandle();
 		if (!curl)
 			return false;
 
@@ -333,6 +445,7 @@ bool HTTPClient::POSTBinary(const std::string &url, const std::string &postdata,
 			curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
 		}
 
+		curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(postdata.size())); // postdata can be binary (gzip)
 		curl_easy_setopt(curl, CURLOPT_POSTFIELDS, postdata.c_str());
 		res = curl_easy_perform(curl);
 
@@ -354,7 +467,7 @@ bool HTTPClient::POSTBinary(const std::string &url, const std::string &postdata,
 			}
 		}
 
-		curl_easy_cleanup(curl);
+		ReleaseHandle(curl);
 
 		if (headers != nullptr)
 		{
@@ -376,7 +489,7 @@ std::vector<std::string> &vHeaderData, const long TimeOut)
 	{
 		if (!CheckIfGlobalInitDone())
 			return false;
-		CURL *curl = curl_easy_init();
+		CURL *curl = (CURL *)GetHandle();
 		if (!curl)
 			return false;
 
@@ -423,7 +536,7 @@ std::vector<std::string> &vHeaderData, const long TimeOut)
 			}
 		}
 
-		curl_easy_cleanup(curl);
+		ReleaseHandle(curl);
 
 		if (headers != nullptr)
 		{
@@ -445,7 +558,7 @@ std::vector<std::string> &vHeaderData, const long TimeOut)
 	{
 		if (!CheckIfGlobalInitDone())
 			return false;
-		CURL *curl = curl_easy_init();
+		CURL *curl = (CURL *)GetHandle();
 		if (!curl)
 			return false;
 
@@ -492,7 +605,7 @@ std::vector<std::string> &vHeaderData, const long TimeOut)
 			}
 		}
 
-		curl_easy_cleanup(curl);
+		ReleaseHandle(curl);
 
 		if (headers != nullptr)
 		{
@@ -514,7 +627,7 @@ bool HTTPClient::PatchBinary(const std::string& url, const std::string& putdata,
 	{
 		if (!CheckIfGlobalInitDone())
 			return false;
-		CURL* curl = curl_easy_init();
+		CURL* curl = (CURL*)GetHandle();
 		if (!curl)
 			return false;
 
@@ -561,7 +674,7 @@ bool HTTPClient::PatchBinary(const std::string& url, const std::string& putdata,
 			}
 		}
 
-		curl_easy_cleanup(curl);
+		ReleaseHandle(curl);
 
 		if (headers != nullptr)
 		{
@@ -595,7 +708,7 @@ bool HTTPClient::GETBinarySingleLine(const std::string &url, const std::vector<s
 	{
 		if (!CheckIfGlobalInitDone())
 			return false;
-		CURL *curl = curl_easy_init();
+		CURL *curl = (CURL *)GetHandle();
 		if (!curl)
 			return false;
 
@@ -642,7 +755,7 @@ bool HTTPClient::GETBinarySingleLine(const std::string &url, const std::vector<s
 			}
 		}
 
-		curl_easy_cleanup(curl);
+		ReleaseHandle(curl);
 
 		if (headers != nullptr)
 		{
@@ -817,7 +930,7 @@ bool HTTPClient::GETBinaryToFile(const std::string &url, const std::string &outp
 		if (!outfile.is_open())
 			return false;
 
-		CURL *curl = curl_easy_init();
+		CURL *curl = (CURL *)GetHandle();
 		if (!curl)
 			return false;
 
@@ -827,7 +940,7 @@ bool HTTPClient::GETBinaryToFile(const std::string &url, const std::string &outp
 		curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&outfile);
 		curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
 		res = curl_easy_perform(curl);
-		curl_easy_cleanup(curl);
+		ReleaseHandle(curl);
 
 		outfile.close();
 
@@ -838,3 +951,287 @@ bool HTTPClient::GETBinaryToFile(const std::string &url, const std::string &outp
 		return false;
 	}
 }
+
+
+/************************************************************************
+ *									*
+ * asynchronous requests						*
+ *									*
+ ************************************************************************/
+
+uint64_t HTTPClient::AsyncRequest(const _eHTTPmethod method, const std::string &url, const std::string &data, const std::vector<std::string> &ExtraHeaders, const THTTPCallback &callback,
+				  const long TimeOut)
+{
+	if (!CheckIfGlobalInitDone())
+		return 0;
+	CURL *curl = (CURL *)GetHandle();
+	if (!curl)
+		return 0;
+
+	auto pRequest = new _tHTTPAsyncRequest;
+	pRequest->method = method;
+	pRequest->curl = curl;
+	pRequest->url = url;
+	pRequest->data = data;
+	pRequest->callback = callback;
+
+	SetGlobalOptions(curl);
+	if (TimeOut != -1)
+		curl_easy_setopt(curl, CURLOPT_TIMEOUT, TimeOut);
+	curl_easy_setopt(curl, CURLOPT_PRIVATE, pRequest);
+	curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, write_curl_headerdata);
+	curl_easy_setopt(curl, CURLOPT_HEADERDATA, &pRequest->vHeaderData);
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&pRequest->response);
+	curl_easy_setopt(curl, CURLOPT_URL, pRequest->url.c_str());
+	for (const auto &header : ExtraHeaders)
+		pRequest->headers = curl_slist_append(pRequest->headers, header.c_str());
+	if (pRequest->headers != nullptr)
+		curl_easy_setopt(curl, CURLOPT_HTTPHEADER, pRequest->headers);
+
+	switch (method)
+	{
+	case HTTP_METHOD_GET:
+		break;
+	case HTTP_METHOD_POST:
+		curl_easy_setopt(curl, CURLOPT_POST, 1);
+		break;
+	case HTTP_METHOD_PUT:
+		curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
+		break;
+	case HTTP_METHOD_DELETE:
+		curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
+		break;
+	case HTTP_METHOD_PATCH:
+		curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PATCH");
+		break;
+	}
+	if (method != HTTP_METHOD_GET)
+	{
+		curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(pRequest->data.size()));
+		curl_easy_setopt(curl, CURLOPT_POSTFIELDS, pRequest->data.c_str());
+	}
+
+	{
+		std::lock_guard<std::mutex> l(m_async_mutex);
+		if (!m_bAsyncStop)
+		{
+			if (!m_async_thread)
+			{
+				m_async_multi = curl_multi_init();
+				if (m_async_multi != nullptr)
+				{
+					m_async_thread = std::make_shared<std::thread>([] { Do_AsyncWork(); });
+					SetThreadName(m_async_thread->native_handle(), "HTTPClient");
+				}
+			}
+			if (m_async_thread)
+			{
+				pRequest->id = m_async_next_id++;
+				m_async_pending.insert(pRequest->id);
+				m_async_queue.push_back(pRequest);
+				m_async_cond.notify_one();
+#if LIBCURL_VERSION_NUM >= 0x074400
+				curl_multi_wakeup(m_async_multi);
+#endif
+				return pRequest->id;
+			}
+		}
+	}
+	if (pRequest->headers != nullptr)
+		curl_slist_free_all(pRequest->headers);
+	ReleaseHandle(curl);
+	delete pRequest;
+	return 0;
+}
+
+bool HTTPClient::Cancel(const uint64_t id)
+{
+	_tHTTPAsyncRequest *pRequest = nullptr;
+	{
+		std::lock_guard<std::mutex> l(m_async_mutex);
+		if (m_async_pending.erase(id) == 0)
+			return false; // unknown, completed or its callback is running
+		auto itt = std::find_if(m_async_queue.begin(), m_async_queue.end(), [id](const _tHTTPAsyncRequest *pQueued) { return (pQueued->id == id); });
+		if (itt != m_async_queue.end())
+		{
+			pRequest = *itt;
+			m_async_queue.erase(itt);
+		}
+		else
+		{
+			// running, the engine removes it
+			m_async_cancelled.push_back(id);
+			m_async_cond.notify_one();
+#if LIBCURL_VERSION_NUM >= 0x074400
+			if (m_async_multi != nullptr)
+				curl_multi_wakeup(m_async_multi);
+#endif
+		}
+	}
+	if (pRequest != nullptr)
+	{
+		if (pRequest->headers != nullptr)
+			curl_slist_free_all(pRequest->headers);
+		ReleaseHandle(pRequest->curl);
+		delete pRequest;
+	}
+	return true;
+}
+
+void HTTPClient::Do_AsyncWork()
+{
+	std::vector<_tHTTPAsyncRequest *> active;
+
+	auto release = [](_tHTTPAsyncRequest *pRequest) {
+		ReleaseHandle(pRequest->curl);
+		if (pRequest->headers != nullptr)
+			curl_slist_free_all(pRequest->headers);
+		delete pRequest;
+	};
+
+	//called without lock, the callback may start a new request
+	//the result matches the blocking functions: a GET fails on a HTTP error status, the
+	//other methods (like POSTBinary, no CURLOPT_FAILONERROR) only on a transfer error
+	auto complete = [&release](_tHTTPAsyncRequest *pRequest, const CURLcode res) {
+		bool bOK = false;
+		if (res == CURLE_OK)
+		{
+			if (pRequest->method == HTTP_METHOD_GET)
+			{
+				long http_code = 0;
+				curl_easy_getinfo(pRequest->curl, CURLINFO_RESPONSE_CODE, &http_code);
+				bOK = ((http_code) && (http_code < 400));
+				if (!bOK)
+					LogError(http_code);
+			}
+			else
+				bOK = true;
+		}
+		else if (res == CURLE_HTTP_RETURNED_ERROR)
+		{
+			//HTTP status code is already inside the header
+			long http_code = 0;
+			curl_easy_getinfo(pRequest->curl, CURLINFO_RESPONSE_CODE, &http_code);
+			LogError(http_code);
+		}
+		else
+		{
+			//Need to generate a header
+			std::stringstream ss;
+			ss << "HTTP/1.1 " << res << " " << curl_easy_strerror(res);
+			pRequest->vHeaderData.push_back(ss.str());
+		}
+		bool bCancelled;
+		{
+			std::lock_guard<std::mutex> l(m_async_mutex);
+			bCancelled = (m_async_pending.erase(pRequest->id) == 0);
+		}
+		try
+		{
+			if ((!bCancelled) && (pRequest->callback))
+				pRequest->callback(bOK, pRequest->response, pRequest->vHeaderData);
+		}
+		catch (...)
+		{
+		}
+		release(pRequest);
+	};
+
+	while (true)
+	{
+		std::vector<_tHTTPAsyncRequest *> queue;
+		std::vector<uint64_t> cancelled;
+		{
+			std::unique_lock<std::mutex> l(m_async_mutex);
+			if ((active.empty()) && (!m_bAsyncStop))
+				m_async_cond.wait(l, [] { return (m_bAsyncStop || !m_async_queue.empty() || !m_async_cancelled.empty()); });
+			if (m_bAsyncStop)
+				break;
+			queue.swap(m_async_queue);
+			cancelled.swap(m_async_cancelled);
+		}
+		for (const auto id : cancelled)
+		{
+			auto itt = std::find_if(active.begin(), active.end(), [id](const _tHTTPAsyncRequest *pActive) { return (pActive->id == id); });
+			if (itt == active.end())
+				continue; // completed meanwhile, its callback was skipped
+			_tHTTPAsyncRequest *pRequest = *itt;
+			active.erase(itt);
+			curl_multi_remove_handle(m_async_multi, pRequest->curl);
+			release(pRequest);
+		}
+		for (auto pRequest : queue)
+		{
+			if (curl_multi_add_handle(m_async_multi, pRequest->curl) == CURLM_OK)
+				active.push_back(pRequest);
+			else
+				complete(pRequest, CURLE_FAILED_INIT);
+		}
+
+		int running = 0;
+		curl_multi_perform(m_async_multi, &running);
+
+		CURLMsg *msg;
+		int msgs_left = 0;
+		while ((msg = curl_multi_info_read(m_async_multi, &msgs_left)) != nullptr)
+		{
+			if (msg->msg != CURLMSG_DONE)
+				continue;
+			CURL *curl = msg->easy_handle;
+			const CURLcode res = msg->data.result;
+			_tHTTPAsyncRequest *pRequest = nullptr;
+			curl_easy_getinfo(curl, CURLINFO_PRIVATE, &pRequest);
+			curl_multi_remove_handle(m_async_multi, curl);
+			active.erase(std::remove(active.begin(), active.end(), pRequest), active.end());
+			complete(pRequest, res);
+		}
+
+		if (!active.empty())
+		{
+#if LIBCURL_VERSION_NUM >= 0x074400
+			curl_multi_poll(m_async_multi, nullptr, 0, 1000, nullptr);
+#else
+			curl_multi_wait(m_async_multi, nullptr, 0, 100, nullptr);
+#endif
+		}
+	}
+
+	//Stopped, the requests that did not complete fail
+	std::vector<_tHTTPAsyncRequest *> queue;
+	{
+		std::lock_guard<std::mutex> l(m_async_mutex);
+		queue.swap(m_async_queue);
+		m_async_cancelled.clear();
+	}
+	for (auto pRequest : active)
+	{
+		curl_multi_remove_handle(m_async_multi, pRequest->curl);
+		complete(pRequest, CURLE_ABORTED_BY_CALLBACK);
+	}
+	for (auto pRequest : queue)
+		complete(pRequest, CURLE_ABORTED_BY_CALLBACK);
+}
+
+void HTTPClient::StopAsync()
+{
+	std::shared_ptr<std::thread> thread;
+	{
+		std::lock_guard<std::mutex> l(m_async_mutex);
+		m_bAsyncStop = true;
+		thread = m_async_thread;
+		m_async_cond.notify_one();
+#if LIBCURL_VERSION_NUM >= 0x074400
+		if (m_async_multi != nullptr)
+			curl_multi_wakeup(m_async_multi);
+#endif
+	}
+	if (thread)
+		thread->join();
+	std::lock_guard<std::mutex> l(m_async_mutex);
+	m_async_thread.reset();
+	if (m_async_multi != nullptr)
+	{
+		curl_multi_cleanup(m_async_multi);
+		m_async_multi = nullptr;
+	}
+}
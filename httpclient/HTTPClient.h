@@ -1,9 +1,12 @@
 #pragma once
+#include <functional>
 
 class HTTPClient
 {
 	// give MainWorker acces to the protected Cleanup() function
 	friend class MainWorker;
+	// and the benchmark, it stops the requests that are still running
+	friend class CBenchmark;
 
       public:
 	enum _eHTTPmethod
@@ -111,10 +114,34 @@ class HTTPClient
 	static bool PatchBinary(const std::string& url, const std::string& putdata, const std::vector<std::string>& ExtraHeaders, std::vector<unsigned char>& response,
 		std::vector<std::string>& vHeaderData, long TimeOut = -1);
 
+	/************************************************************************
+	 *									*
+	 * asynchronous requests						*
+	 *   - performed by one shared curl multi engine, no thread per	*
+	 *     request. The callback is called from the engine thread when	*
+	 *     the request completes, keep it short				*
+	 *									*
+	 ************************************************************************/
+
+	typedef std::function<void(bool bSuccess, const std::vector<unsigned char> &response, const std::vector<std::string> &vHeaderData)> THTTPCallback;
+
+	// bSuccess matches the blocking functions: a GET fails on a HTTP error status (>= 400),
+	// POST/PUT/DELETE/PATCH only fail when the transfer failed
+	// Returns the id of the request, 0 when it could not be started
+	static uint64_t AsyncRequest(_eHTTPmethod method, const std::string &url, const std::string &data, const std::vector<std::string> &ExtraHeaders, const THTTPCallback &callback,
+				     long TimeOut = -1);
+	// Returns true when the request was cancelled before its callback was called, the callback is not called anymore
+	static bool Cancel(uint64_t id);
+
       private:
 	static void SetGlobalOptions(void *curlobj);
 	static bool CheckIfGlobalInitDone();
 	static void LogError(long response_code);
+	// easy handles are kept (with their connections) for the next request
+	static void *GetHandle();
+	static void ReleaseHandle(void *curlobj);
+	static void Do_AsyncWork();
+	static void StopAsync();
 
       private:
 	static bool m_bCurlGlobalInitialized;
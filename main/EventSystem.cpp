@@ -24,6 +24,7 @@
 #include "../main/LuaTable.h"
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
+#include <sys/stat.h>
 
 extern "C" {
 #include <lua.h>
@@ -125,6 +126,13 @@ const CEventSystem::_tJsonMap CEventSystem::JsonMap[] = {
 CEventSystem::CEventSystem()
 {
 	m_bEnabled = false;
+	m_luaStatePool.SetInitializer([](lua_State *lua_state) {
+		lua_pushcfunction(lua_state, l_domoticz_applyJsonPath);
+		lua_setglobal(lua_state, "domoticz_applyJsonPath");
+
+		lua_pushcfunction(lua_state, l_domoticz_applyXPath);
+		lua_setglobal(lua_state, "domoticz_applyXPath");
+	});
 }
 
 CEventSystem::~CEventSystem()
@@ -153,6 +161,8 @@ void CEventSystem::StartEventSystem()
 	Plugins::PythonEventsInitialize(szUserDataFolder);
 #endif
 
+	m_luaStatePool.Prewarm();
+
 	m_thread = std::make_shared<std::thread>([this] { Do_Work(); });
 	SetThreadName(m_thread->native_handle(), "EventSystem");
 	m_eventqueuethread = std::make_shared<std::thread>([this] { EventQueueThread(); });
@@ -181,6 +191,7 @@ void CEventSystem::StopEventSystem()
 #ifdef ENABLE_PYTHON
 	Plugins::PythonEventsStop();
 #endif
+	m_luaStatePool.Clear();
 }
 
 void CEventSystem::SetEnabled(const bool bEnabled)
@@ -210,6 +221,7 @@ void CEventSystem::LoadEvents()
 	dzvents->m_scriptsDir = szUserDataFolder + "scripts/dzVents/scripts/";
 	dzvents->m_runtimeDir = szStartupFolder + "dzVents/runtime/";
 #endif
+	m_luaStatePool.SetResidentPath(dzvents->m_runtimeDir);
 	if (!mkdir_deep(m_lua_Dir.c_str(), 0755))
 	{
 		_log.Log(LOG_NORM, "%s: Created directory %s", __func__, m_lua_Dir.c_str());
@@ -298,12 +310,118 @@ void CEventSystem::LoadEvents()
 			}
 		}
 	}
+	BuildEventTriggerIndex();
 	m_mainworker.m_notificationsystem.Notify(Notification::DZ_ALLEVENTRESET, Notification::STATUS_INFO);
 #ifdef _DEBUG
 	_log.Log(LOG_STATUS, "EventSystem: Events (re)loaded");
 #endif
 }
 
+// Call with m_eventsMutex locked
+void CEventSystem::BuildEventTriggerIndex()
+{
+	m_blocklyDeviceEvents.clear();
+	m_blocklyVariableEvents.clear();
+	m_blocklySecurityEvents.clear();
+	m_blocklyTimeEvents.clear();
+	m_scriptEvents.clear();
+
+	for (size_t ii = 0; ii < m_events.size(); ii++)
+	{
+		const _tEventItem &event = m_events[ii];
+		if ((event.Interpreter == "Lua") || (event.Interpreter == "Python"))
+		{
+			m_scriptEvents.push_back(ii);
+			continue;
+		}
+		if (event.Interpreter != "Blockly")
+			continue;
+
+		// every [idx] refers to a device, variable[idx] to a user variable as well
+		std::set<uint64_t> devices, variables;
+		size_t pos = event.Conditions.find('[');
+		while (pos != std::string::npos)
+		{
+			size_t epos = event.Conditions.find_first_not_of("0123456789", pos + 1);
+			size_t len = (epos != std::string::npos) ? epos - pos - 1 : 0;
+			if ((len > 0) && (len < 20) && (event.Conditions[epos] == ']') && ((len == 1) || (event.Conditions[pos + 1] != '0')))
+			{
+				uint64_t idx = std::stoull(event.Conditions.substr(pos + 1, len));
+				devices.insert(idx);
+				if ((pos >= 8) && (event.Conditions.compare(pos - 8, 8, "variable") == 0))
+					variables.insert(idx);
+			}
+			pos = event.Conditions.find('[', pos + 1);
+		}
+		for (const auto idx : devices)
+			m_blocklyDeviceEvents[idx].push_back(ii);
+		for (const auto idx : variables)
+			m_blocklyVariableEvents[idx].push_back(ii);
+
+		if (event.Conditions.find("securitystatus") != std::string::npos)
+			m_blocklySecurityEvents.push_back(ii);
+		// time rules will only run when time or date based criteria are found
+		if ((event.Conditions.find("timeofday") != std::string::npos) || (event.Conditions.find("weekday") != std::string::npos))
+			m_blocklyTimeEvents.push_back(ii);
+	}
+}
+
+// Returns the script files of dir, the listing is only read again when the directory changed
+std::shared_ptr<const CEventSystem::_tScriptIndex> CEventSystem::GetScriptIndex(std::shared_ptr<const _tScriptIndex> &index, const std::string &dir, const std::string &extension)
+{
+	std::lock_guard<std::mutex> l(m_scriptIndexMutex);
+
+	struct stat st;
+	time_t mtime = (stat(dir.c_str(), &st) == 0) ? st.st_mtime : 0;
+	// the directory time has a one second resolution, do not trust a listing taken in the same second
+	if ((index != nullptr) && (index->dir == dir) && (index->mtime == mtime) && (index->scanned > mtime + 1))
+		return index;
+
+	auto newIndex = std::make_shared<_tScriptIndex>();
+	newIndex->dir = dir;
+	newIndex->mtime = mtime;
+	newIndex->scanned = mytime(nullptr);
+
+	std::vector<std::string> FileEntries;
+	DirectoryListing(FileEntries, dir, false, true);
+	for (const auto &filename : FileEntries)
+	{
+		if ((filename.length() <= extension.length()) || (filename.compare(filename.length() - extension.length(), extension.length(), extension) != 0))
+			continue;
+		newIndex->bHaveScripts = true;
+		if (filename.find("_demo" + extension) != std::string::npos)
+			continue;
+
+		if (filename.find("_device_") != std::string::npos)
+		{
+			_tScriptFile file;
+			file.filename = filename;
+			size_t pos = filename.find("_device_");
+			while (pos != std::string::npos)
+			{
+				size_t epos = filename.find(extension, pos + 8);
+				while (epos != std::string::npos)
+				{
+					file.deviceNames.push_back(filename.substr(pos + 8, epos - pos - 8));
+					epos = filename.find(extension, epos + 1);
+				}
+				pos = filename.find("_device_", pos + 1);
+			}
+			newIndex->device.push_back(file);
+		}
+		if (filename.find("_time_") != std::string::npos)
+			newIndex->time.push_back(filename);
+		if (filename.find("_security_") != std::string::npos)
+			newIndex->security.push_back(filename);
+		if (filename.find("_notification_") != std::string::npos)
+			newIndex->notification.push_back(filename);
+		if (filename.find("_variable_") != std::string::npos)
+			newIndex->variable.push_back(filename);
+	}
+	index = newIndex;
+	return index;
+}
+
 void CEventSystem::Do_Work()
 {
 #ifdef ENABLE_PYTHON
@@ -376,52 +494,91 @@ std::string CEventSystem::LowerCase(std::string sResult)
 	return sResult;
 }
 
-void CEventSystem::UpdateJsonMap(_tDeviceStatus &item, const uint64_t ulDevID)
+// Fills the JSON maps of item from the device as rendered by CWebServer::GetJSonDevices
+void CEventSystem::UpdateJsonMap(_tDeviceStatus &item, const Json::Value &device)
 {
 	item.JsonMapString.clear();
 	item.JsonMapFloat.clear();
 	item.JsonMapInt.clear();
 	item.JsonMapBool.clear();
 
-	Json::Value tempjson;
-	m_webservers.GetJSonDevices(tempjson, "", "", "", std::to_string(ulDevID), "", "", true, false, false, 0, "");
-	Json::ArrayIndex rsize = tempjson["result"].size();
+	uint8_t index = 0;
+	std::string l_JsonValueString;
+	l_JsonValueString.reserve(50);
 
-	if (rsize > 0)
+	while (JsonMap[index].szOriginal != nullptr)
 	{
-		uint8_t index = 0;
-		std::string l_JsonValueString;
-		l_JsonValueString.reserve(50);
-
-		while (JsonMap[index].szOriginal != nullptr)
+		const Json::Value &jValue = device[JsonMap[index].szOriginal];
+		if (!jValue.isNull())
 		{
-			if (tempjson["result"][0][JsonMap[index].szOriginal] != Json::Value::null)
-			{
-				std::string value = tempjson["result"][0][JsonMap[index].szOriginal].asString();
+			std::string value = jValue.asString();
 
-				switch (JsonMap[index].eType)
-				{
-				case JTYPE_STRING:
-					item.JsonMapString[index] = l_JsonValueString.assign(value);
-					break;
-				case JTYPE_FLOAT:
-					item.JsonMapFloat[index] = (float)atof(value.c_str());
-					break;
-				case JTYPE_INT:
-					item.JsonMapInt[index] = atoi(value.c_str());
-					break;
-				case JTYPE_BOOL:
-					if (value == "true")
-						item.JsonMapBool[index] = true;
-					else
-						item.JsonMapBool[index] = false;
-					break;
-				default:
-					item.JsonMapString[index] = l_JsonValueString.assign("unknown_type");
-				}
+			switch (JsonMap[index].eType)
+			{
+			case JTYPE_STRING:
+				item.JsonMapString[index] = l_JsonValueString.assign(value);
+				break;
+			case JTYPE_FLOAT:
+				item.JsonMapFloat[index] = (float)atof(value.c_str());
+				break;
+			case JTYPE_INT:
+				item.JsonMapInt[index] = atoi(value.c_str());
+				break;
+			case JTYPE_BOOL:
+				if (value == "true")
+					item.JsonMapBool[index] = true;
+				else
+					item.JsonMapBool[index] = false;
+				break;
+			default:
+				item.JsonMapString[index] = l_JsonValueString.assign("unknown_type");
 			}
-			index++;
 		}
+		index++;
+	}
+}
+
+// The JSON maps are only needed by dzVents, devices that changed are marked stale and
+// read back in one go right before dzVents exports its data.
+void CEventSystem::RefreshJsonMaps()
+{
+	std::set<uint64_t> stale;
+	{
+		boost::unique_lock<boost::shared_mutex> devicestatesMutexLock(m_devicestatesMutex);
+		stale.swap(m_jsonMapsStale);
+	}
+	if (stale.empty())
+		return;
+
+	Json::Value tempjson;
+	if (stale.size() == 1)
+		m_webservers.GetJSonDevices(tempjson, "", "", "", std::to_string(*stale.begin()), "", "", true, false, false, 0, "");
+	else
+		m_webservers.GetJSonDevices(tempjson, "", "", "", "", "", "", true, false, false, 0, "", "", &stale);
+
+	boost::unique_lock<boost::shared_mutex> devicestatesMutexLock(m_devicestatesMutex);
+	for (const auto &device : tempjson["result"])
+	{
+		uint64_t ulDevID = std::stoull(device["idx"].asString());
+		if (stale.erase(ulDevID) == 0)
+			continue;
+		auto itt = m_devicestates.find(ulDevID);
+		if (itt == m_devicestates.end())
+			continue;
+		UpdateJsonMap(itt->second, device);
+		itt->second.version = ++m_stateVersion;
+	}
+	// Devices that were not returned (no longer used, or removed) have no JSON values
+	for (const auto ulDevID : stale)
+	{
+		auto itt = m_devicestates.find(ulDevID);
+		if (itt == m_devicestates.end())
+			continue;
+		itt->second.JsonMapString.clear();
+		itt->second.JsonMapFloat.clear();
+		itt->second.JsonMapInt.clear();
+		itt->second.JsonMapBool.clear();
+		itt->second.version = ++m_stateVersion;
 	}
 }
 
@@ -433,8 +590,10 @@ void CEventSystem::GetCurrentStates()
 
 	_log.Log(LOG_STATUS, "EventSystem: reset all device statuses...");
 	m_devicestates.clear();
+	m_deviceNames.clear();
+	m_jsonMapsStale.clear();
 
-	result = m_sql.safe_query(
+	result = m_sql.safe_query_readonly(
 		"SELECT A.HardwareID, A.ID, A.Name, A.nValue, A.sValue, A.Type, A.SubType, A.SwitchType, A.LastUpdate, A.LastLevel, A.Options, A.Description, A.BatteryLevel, A.SignalLevel, A.Unit, A.DeviceID, A.Protected, A.AddjValue, A.AddjMulti, A.AddjValue2, A.AddjMulti2 "
 		"FROM DeviceStatus AS A, Hardware AS B "
 		"WHERE (A.Used = '1') AND (B.ID == A.HardwareID) AND (B.Enabled == 1)");
@@ -467,15 +626,14 @@ void CEventSystem::GetCurrentStates()
 				uint64_t total_min, total_max, total_real;
 				std::vector<std::vector<std::string> > result2;
 
-				result2 = m_sql.safe_query("SELECT sValue FROM DeviceStatus WHERE (ID=%" PRIu64 ")", sitem.ID);
+				result2 = m_sql.safe_query_readonly("SELECT sValue FROM DeviceStatus WHERE (ID=%" PRIu64 ")", sitem.ID);
 				total_max = std::stoull(result2[0][0]);
 
 				//get value of today
-				std::string szDate = TimeToString(nullptr, TF_Date);
-				result2 = m_sql.safe_query("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", sitem.ID, szDate.c_str());
-				if (!result2.empty())
+				_tTodayCounter counter;
+				if (m_sql.GetTodayCounter("Meter", sitem.ID, counter))
 				{
-					total_min = std::stoull(result2[0][0]);
+					total_min = static_cast<uint64_t>(counter.Min[0]);
 					total_real = total_max - total_min;
 
 					sd[4] = std::to_string(total_real); //sitem.sValue = l_sValue.assign(sd[4]);
@@ -504,9 +662,11 @@ void CEventSystem::GetCurrentStates()
 
 			if (!m_sql.m_bDisableDzVentsSystem)
 			{
-				UpdateJsonMap(sitem, sitem.ID);
+				m_jsonMapsStale.insert(sitem.ID);
 			}
+			sitem.version = ++m_stateVersion;
 			m_devicestates_temp[sitem.ID] = sitem;
+			UpdateDeviceName("", sitem.deviceName);
 		}
 		m_devicestates = m_devicestates_temp;
 	}
@@ -521,7 +681,7 @@ void CEventSystem::GetCurrentUserVariables()
 	m_uservariables.clear();
 
 	std::vector<std::vector<std::string> > result;
-	result = m_sql.safe_query("SELECT ID,Name,Value, ValueType, LastUpdate FROM UserVariables");
+	result = m_sql.safe_query_readonly("SELECT ID,Name,Value, ValueType, LastUpdate FROM UserVariables");
 	if (!result.empty())
 	{
 		for (const auto &sd : result)
@@ -532,6 +692,7 @@ void CEventSystem::GetCurrentUserVariables()
 			uvitem.variableValue = sd[2];
 			uvitem.variableType = atoi(sd[3].c_str());
 			uvitem.lastUpdate = sd[4];
+			uvitem.version = ++m_stateVersion;
 			m_uservariables[uvitem.ID] = uvitem;
 		}
 	}
@@ -544,7 +705,7 @@ void CEventSystem::GetCurrentScenesGroups()
 	m_scenesgroups.clear();
 
 	std::vector<std::vector<std::string> > result;
-	result = m_sql.safe_query("SELECT ID, Name, nValue, SceneType, LastUpdate, Protected, Description FROM Scenes");
+	result = m_sql.safe_query_readonly("SELECT ID, Name, nValue, SceneType, LastUpdate, Protected, Description FROM Scenes");
 	if (!result.empty())
 	{
 		for (const auto &sd : result)
@@ -566,7 +727,7 @@ void CEventSystem::GetCurrentScenesGroups()
 			sgitem.lastUpdate = sd[4];
 			sgitem.protection = atoi(sd[5].c_str());
 			sgitem.description = sd[6];
-			result2 = m_sql.safe_query("SELECT DISTINCT A.DeviceRowID FROM SceneDevices AS A, DeviceStatus AS B WHERE (A.SceneRowID == %" PRIu64 ") AND (A.DeviceRowID == B.ID)", sgitem.ID);
+			result2 = m_sql.safe_query_readonly("SELECT DISTINCT A.DeviceRowID FROM SceneDevices AS A, DeviceStatus AS B WHERE (A.SceneRowID == %" PRIu64 ") AND (A.DeviceRowID == B.ID)", sgitem.ID);
 			if (!result2.empty())
 			{
 				for (const auto &sd2 : result2)
@@ -574,6 +735,7 @@ void CEventSystem::GetCurrentScenesGroups()
 					sgitem.memberID.push_back(std::stoull(sd2[0]));
 				}
 			}
+			sgitem.version = ++m_stateVersion;
 			m_scenesgroups[sgitem.ID] = sgitem;
 		}
 	}
@@ -891,12 +1053,10 @@ void CEventSystem::GetCurrentMeasurementStates()
 					total_max = std::stoull(result2[0][0]);
 
 					//get value of today
-					std::string szDate = TimeToString(nullptr, TF_Date);
-					result2 = m_sql.safe_query("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')",
-						sitem.ID, szDate.c_str());
-					if (!result2.empty())
+					_tTodayCounter counter;
+					if (m_sql.GetTodayCounter("Meter", sitem.ID, counter))
 					{
-						total_min = std::stoull(result2[0][0]);
+						total_min = static_cast<uint64_t>(counter.Min[0]);
 						total_real = total_max - total_min;
 
 						utilityval = float(total_real) / divider;
@@ -935,30 +1095,30 @@ void CEventSystem::GetCurrentMeasurementStates()
 
 				std::string szDate = TimeToString(nullptr, TF_Date);
 				std::vector<std::vector<std::string> > result2;
+				_tTodayCounter counter;
+				bool bHaveToday;
 
 				if (sitem.subType == sTypeRAINWU || sitem.subType == sTypeRAINByRate)
 				{
 					result2 = m_sql.safe_query(
 						"SELECT Total, Total FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q') ORDER BY ROWID DESC LIMIT 1",
 						sitem.ID, szDate.c_str());
+					bHaveToday = !result2.empty();
 				}
 				else
 				{
-					result2 = m_sql.safe_query(
-						"SELECT MIN(Total), MAX(Total) FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')",
-						sitem.ID, szDate.c_str());
+					bHaveToday = m_sql.GetTodayCounter("Rain", sitem.ID, counter);
 				}
-				if (!result2.empty())
+				if (bHaveToday)
 				{
 					double total_real = 0;
-					std::vector<std::string> sd2 = result2[0];
 					if (sitem.subType == sTypeRAINWU || sitem.subType == sTypeRAINByRate)
 					{
-						total_real = atof(sd2[1].c_str());
+						total_real = atof(result2[0][1].c_str());
 					}
 					else
 					{
-						float total_min = static_cast<float>(atof(sd2[0].c_str()));
+						float total_min = static_cast<float>(counter.Min[0]);
 						float total_max = static_cast<float>(atof(splitresults[1].c_str()));
 						total_real = total_max - total_min;
 					}
@@ -970,18 +1130,13 @@ void CEventSystem::GetCurrentMeasurementStates()
 		{
 			float GasDivider = 1000.0F;
 			//get lowest value of today
-			std::string szDate = TimeToString(nullptr, TF_Date);
-			std::vector<std::vector<std::string> > result2;
-			result2 = m_sql.safe_query("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')",
-				sitem.ID, szDate.c_str());
-			if (!result2.empty())
+			_tTodayCounter counter;
+			if (m_sql.GetTodayCounter("Meter", sitem.ID, counter))
 			{
-				std::vector<std::string> sd2 = result2[0];
-
 				uint64_t total_min_gas, total_real_gas;
 				uint64_t gasactual;
 
-				total_min_gas = std::stoull(sd2[0]);
+				total_min_gas = static_cast<uint64_t>(counter.Min[0]);
 				gasactual = std::stoull(sitem.sValue);
 				total_real_gas = gasactual - total_min_gas;
 				utilityval = float(total_real_gas) / GasDivider;
@@ -996,18 +1151,13 @@ void CEventSystem::GetCurrentMeasurementStates()
 				float divider = m_sql.GetCounterDivider(int(metertype), int(sitem.devType), float(sitem.AddjValue2));
 
 				//get value of today
-				std::string szDate = TimeToString(nullptr, TF_Date);
-				std::vector<std::vector<std::string> > result2;
-				result2 = m_sql.safe_query("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')",
-					sitem.ID, szDate.c_str());
-				if (!result2.empty())
+				_tTodayCounter counter;
+				if (m_sql.GetTodayCounter("Meter", sitem.ID, counter))
 				{
-					std::vector<std::string> sd2 = result2[0];
-
 					uint64_t total_min, total_max, total_real;
 
-					total_min = std::stoull(sd2[0]);
-					total_max = std::stoull(sd2[1]);
+					total_min = static_cast<uint64_t>(counter.Min[0]);
+					total_max = static_cast<uint64_t>(counter.Max[0]);
 					total_real = total_max - total_min;
 
 					utilityval = float(total_real) / divider;
@@ -1084,7 +1234,12 @@ void CEventSystem::RemoveSingleState(const uint64_t ulDevID, const _eReason reas
 	if (reason == REASON_DEVICE)
 	{
 		boost::unique_lock<boost::shared_mutex> devicestatesMutexLock(m_devicestatesMutex);
-		m_devicestates.erase(ulDevID);
+		auto itt = m_devicestates.find(ulDevID);
+		if (itt != m_devicestates.end())
+		{
+			UpdateDeviceName(itt->second.deviceName, "");
+			m_devicestates.erase(itt);
+		}
 	}
 	else if (reason == REASON_SCENEGROUP)
 	{
@@ -1108,7 +1263,9 @@ void CEventSystem::WWWUpdateSingleState(const uint64_t ulDevID, const std::strin
 		if (itt != m_devicestates.end())
 		{
 			_tDeviceStatus replaceitem = itt->second;
+			UpdateDeviceName(replaceitem.deviceName, l_deviceName);
 			replaceitem.deviceName = l_deviceName;
+			replaceitem.version = ++m_stateVersion;
 			itt->second = replaceitem;
 		}
 	}
@@ -1120,6 +1277,7 @@ void CEventSystem::WWWUpdateSingleState(const uint64_t ulDevID, const std::strin
 		{
 			_tScenesGroups replaceitem = itt->second;
 			replaceitem.scenesgroupName = l_deviceName;
+			replaceitem.version = ++m_stateVersion;
 			itt->second = replaceitem;
 		}
 	}
@@ -1135,7 +1293,7 @@ void CEventSystem::WWWUpdateSecurityState(int securityStatus)
 	item.reason = REASON_SECURITY;
 	item.id = 0;
 	item.nValue = m_SecStatus;
-	m_eventqueue.push(item);
+	m_eventqueue.push(std::move(item));
 }
 
 bool CEventSystem::GetEventTrigger(const uint64_t ulDevID, const _eReason reason, const bool bEventTrigger)
@@ -1172,7 +1330,7 @@ bool CEventSystem::Update(const Notification::_eType type, const Notification::_
 	item.sValue = eventdata;
 	item.lastLevel = static_cast<uint8_t>(status);
 	if (type != Notification::DZ_STOP)
-		m_eventqueue.push(item);
+		m_eventqueue.push(std::move(item));
 	else // blocking call on application shutdown
 	{
 		std::vector<_tEventQueue> items;
@@ -1190,7 +1348,7 @@ void CEventSystem::TriggerURL(const std::string &result, const std::vector<std::
 	item.sValue = result;
 	item.nValueWording = callback;
 	item.vData = headerData;
-	m_eventqueue.push(item);
+	m_eventqueue.push(std::move(item));
 }
 
 void CEventSystem::TriggerShellCommand(const std::string &result, const std::string &scriptstderr, const std::string &callback, int exitcode, bool timeoutOccurred)
@@ -1203,7 +1361,7 @@ void CEventSystem::TriggerShellCommand(const std::string &result, const std::str
 	item.nValueWording = callback;
 	item.errorText = scriptstderr;
 	item.timeoutOccurred = timeoutOccurred;
-	m_eventqueue.push(item);
+	m_eventqueue.push(std::move(item));
 }
 
 void CEventSystem::SetEventTrigger(const uint64_t ulDevID, const _eReason reason, const float fDelayTime)
@@ -1258,9 +1416,10 @@ bool CEventSystem::UpdateSceneGroup(const uint64_t ulDevID, const int nValue, co
 			item.devname = replaceitem.scenesgroupName;
 			item.sValue = replaceitem.scenesgroupValue;
 			item.lastUpdate = itt->second.lastUpdate;
-			m_eventqueue.push(item);
+			m_eventqueue.push(std::move(item));
 		}
 		replaceitem.lastUpdate = lastUpdate;
+		replaceitem.version = ++m_stateVersion;
 		itt->second = replaceitem;
 	}
 	return bEventTrigger;
@@ -1288,9 +1447,10 @@ void CEventSystem::UpdateUserVariable(const uint64_t ulDevID, const std::string
 		item.id = ulDevID;
 		item.sValue = varValue;
 		item.lastUpdate = itt->second.lastUpdate;
-		m_eventqueue.push(item);
+		m_eventqueue.push(std::move(item));
 	}
 	replaceitem.lastUpdate = lastUpdate;
+	replaceitem.version = ++m_stateVersion;
 	itt->second = replaceitem;
 }
 
@@ -1306,6 +1466,7 @@ void CEventSystem::UpdateBatteryLevel(const uint64_t ulDevID, const unsigned cha
 	{
 		_tDeviceStatus replaceitem = itt->second;
 		replaceitem.batteryLevel = batteryLevel;
+		replaceitem.version = ++m_stateVersion;
 		itt->second = replaceitem;
 	}
 }
@@ -1338,6 +1499,7 @@ std::string CEventSystem::UpdateSingleState(
 	{
 		//_log.Log(LOG_STATUS,"EventSystem: update device %" PRIu64 "",ulDevID);
 		_tDeviceStatus replaceitem = itt->second;
+		UpdateDeviceName(replaceitem.deviceName, l_deviceName);
 		replaceitem.deviceName = l_deviceName;
 		//replaceitem.batteryLevel = batteryLevel;
 		if (nValue != -1)
@@ -1353,8 +1515,9 @@ std::string CEventSystem::UpdateSingleState(
 
 		if (!m_sql.m_bDisableDzVentsSystem)
 		{
-			UpdateJsonMap(replaceitem, ulDevID);
+			m_jsonMapsStale.insert(ulDevID);
 		}
+		replaceitem.version = ++m_stateVersion;
 		itt->second = replaceitem;
 	}
 	else
@@ -1375,49 +1538,89 @@ std::string CEventSystem::UpdateSingleState(
 
 		if (!m_sql.m_bDisableDzVentsSystem)
 		{
-			UpdateJsonMap(newitem, ulDevID);
+			m_jsonMapsStale.insert(ulDevID);
 		}
+		newitem.version = ++m_stateVersion;
 		m_devicestates[newitem.ID] = newitem;
+		UpdateDeviceName("", l_deviceName);
 	}
 	return nValueWording;
 }
 
+// Call with m_devicestatesMutex locked, an empty name means no device
+void CEventSystem::UpdateDeviceName(const std::string &oldName, const std::string &newName)
+{
+	if (oldName == newName)
+		return;
+	if (!oldName.empty())
+	{
+		auto itt = m_deviceNames.find(SpaceToUnderscore(LowerCase(oldName)));
+		if ((itt != m_deviceNames.end()) && (--itt->second <= 0))
+			m_deviceNames.erase(itt);
+	}
+	if (!newName.empty())
+		m_deviceNames[SpaceToUnderscore(LowerCase(newName))]++;
+}
+
 void CEventSystem::UnlockEventQueueThread()
 {
 	// Push dummy message to unlock queue
 	_tEventQueue item;
 	item.id = -1;
-	m_eventqueue.push(item);
+	m_eventqueue.push(std::move(item));
+}
+
+queue_stats CEventSystem::GetQueueStats()
+{
+	return m_eventqueue.get_stats();
+}
+
+void CEventSystem::SetQueueOverflowPolicy(const queue_overflow_policy policy)
+{
+	m_eventqueue.set_overflow_policy(policy);
 }
 
 void CEventSystem::EventQueueThread()
 {
 	_log.Log(LOG_STATUS, "EventSystem: Queue thread started...");
-	_tEventQueue item;
+	std::vector<_tEventQueue> queued;
 	std::vector<_tEventQueue> items;
+	uint64_t dropped = 0;
 
 	while (!m_TaskQueue.IsStopRequested(0))
 	{
-		bool hasPopped = m_eventqueue.timed_wait_and_pop<std::chrono::duration<int> >(item, std::chrono::duration<int>(5)); // timeout after 5 sec
-		if (!hasPopped)
+		queued.clear();
+		size_t nPopped = m_eventqueue.timed_wait_and_pop_all<std::chrono::duration<int> >(queued, std::chrono::duration<int>(5)); // timeout after 5 sec
+		if (nPopped == 0)
 			continue;
 
 		if (m_TaskQueue.IsStopRequested(0))
 			break;
+
+		queue_stats stats = m_eventqueue.get_stats();
+		if (stats.dropped != dropped)
+		{
+			_log.Log(LOG_ERROR, "EventSystem: Queue full, %" PRIu64 " events dropped (capacity: %d, high water mark: %d)", stats.dropped - dropped, (int)stats.capacity, (int)stats.high_water_mark);
+			dropped = stats.dropped;
+		}
+
+		for (auto &item : queued)
+		{
 #ifdef _DEBUG
-		//_log.Log(LOG_STATUS, "EventSystem: \n reason => %d\n id => %" PRIu64 "\n devname => %s\n nValue => %d\n sValue => %s\n nValueWording => %s\n lastUpdate => %s\n lastLevel => %d\n",
-			//item.reason, item.id, item.devname.c_str(), item.nValue, item.sValue.c_str(), item.nValueWording.c_str(), item.lastUpdate.c_str(), item.lastLevel);
+			//_log.Log(LOG_STATUS, "EventSystem: \n reason => %d\n id => %" PRIu64 "\n devname => %s\n nValue => %d\n sValue => %s\n nValueWording => %s\n lastUpdate => %s\n lastLevel => %d\n",
+				//item.reason, item.id, item.devname.c_str(), item.nValue, item.sValue.c_str(), item.nValueWording.c_str(), item.lastUpdate.c_str(), item.lastLevel);
 #endif
-		for (const auto &i : items)
-		{
-			if (i.id == item.id && i.reason <= REASON_SCENEGROUP && i.reason == item.reason)
+			for (const auto &i : items)
 			{
-				EvaluateEvent(items);
-				items.clear();
-				break;
+				if (i.id == item.id && i.reason <= REASON_SCENEGROUP && i.reason == item.reason)
+				{
+					EvaluateEvent(items);
+					items.clear();
+					break;
+				}
 			}
+			items.push_back(std::move(item));
 		}
-		items.push_back(item);
 		if (!m_eventqueue.empty())
 			continue;
 
@@ -1443,22 +1646,31 @@ void CEventSystem::ProcessDevice(
 	if (!m_bEnabled)
 		return;
 
-	std::vector<std::vector<std::string> > result;
-	result = m_sql.safe_query("SELECT SwitchType, LastUpdate, LastLevel, Options, Name FROM DeviceStatus WHERE (ID==%" PRIu64 ")", ulDevID);
-	if (result.empty())
+	bool bFound = false;
+	_eSwitchType switchType = STYPE_OnOff;
+	std::string lastUpdate;
+	uint8_t lastLevel = 0;
+	std::string dev_options;
+	std::string devname;
+	m_sql.prepared_query(
+		"SELECT SwitchType, LastUpdate, LastLevel, Options, Name FROM DeviceStatus WHERE (ID==?)",
+		[&](const CSQLRow &row) {
+			switchType = (_eSwitchType)row.GetInt(0);
+			lastUpdate = row.GetText(1);
+			lastLevel = (uint8_t)row.GetInt(2);
+			dev_options = row.GetText(3);
+			devname = row.GetText(4);
+			bFound = true;
+			return false;
+		},
+		ulDevID);
+	if (!bFound)
 	{
 		//impossible as we just updated it
 		_log.Log(LOG_ERROR, "EventSystem: Could not find device in system: (idx %" PRIu64 ")",  ulDevID);
 		return; 
 	}
-
-	std::vector<std::string> sd = result[0];
-
-	_eSwitchType switchType = (_eSwitchType)std::stoi(sd[0]);
-	std::string lastUpdate = sd[1];
-	uint8_t lastLevel = (uint8_t)std::stoi(sd[2]);
-	std::string dev_options = sd[3];
-	std::string devname = sd[4];
+	m_sql.GetPendingDeviceLastUpdate(ulDevID, lastUpdate);
 
 	std::map<std::string, std::string> options = m_sql.BuildDeviceOptions(dev_options);
 
@@ -1471,12 +1683,10 @@ void CEventSystem::ProcessDevice(
 		//get value of today
 		uint64_t total_max = std::stoull(osValue);
 
-		std::string szDate = TimeToString(nullptr, TF_Date);
-		std::vector<std::vector<std::string> > result2;
-		result2 = m_sql.safe_query("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", ulDevID, szDate.c_str());
-		if (!result2.empty())
+		_tTodayCounter counter;
+		if (m_sql.GetTodayCounter("Meter", ulDevID, counter))
 		{
-			uint64_t total_min = std::stoull(result2[0][0]);
+			uint64_t total_min = static_cast<uint64_t>(counter.Min[0]);
 			uint64_t total_real = total_max - total_min;
 
 			osValue = std::to_string(total_real); //sitem.sValue = l_sValue.assign(dev_options);
@@ -1499,19 +1709,13 @@ void CEventSystem::ProcessDevice(
 		{
 			item.lastLevel = itt->second.lastLevel;
 			item.lastUpdate = itt->second.lastUpdate;
-			if (!m_sql.m_bDisableDzVentsSystem)
-			{
-				item.JsonMapString = itt->second.JsonMapString;
-				item.JsonMapInt = itt->second.JsonMapInt;
-				item.JsonMapFloat = itt->second.JsonMapFloat;
-				item.JsonMapBool = itt->second.JsonMapBool;
-			}
 			_tDeviceStatus replaceitem = itt->second;
 			replaceitem.lastUpdate = lastUpdate;
 			replaceitem.lastLevel = lastLevel;
+			replaceitem.version = ++m_stateVersion;
 			itt->second = replaceitem;
 		}
-		m_eventqueue.push(item);
+		m_eventqueue.push(std::move(item));
 	}
 	else
 		UpdateSingleState(ulDevID, devname, nValue, osValue, devType, subType, switchType, lastUpdate, lastLevel, batterylevel, options);
@@ -1522,7 +1726,7 @@ void CEventSystem::ProcessMinute()
 	_tEventQueue item;
 	item.reason = REASON_TIME;
 	item.id = 0;
-	m_eventqueue.push(item);
+	m_eventqueue.push(std::move(item));
 }
 
 void CEventSystem::EvaluateEvent(const std::vector<_tEventQueue> &items)
@@ -1530,98 +1734,84 @@ void CEventSystem::EvaluateEvent(const std::vector<_tEventQueue> &items)
 	if (!m_bEnabled)
 		return;
 
-	std::vector<std::string> FileEntries;
-	std::string filename;
 #ifdef ENABLE_PYTHON
-	std::vector<std::string> FileEntriesPython;
-	DirectoryListing(FileEntriesPython, m_python_Dir, false, true);
+	std::shared_ptr<const _tScriptIndex> pythonScripts = GetScriptIndex(m_pythonScriptIndex, m_python_Dir, ".py");
 #endif
 
 	if (!m_sql.m_bDisableDzVentsSystem)
 	{
 		CdzVents* dzvents = CdzVents::GetInstance();
-		if (dzvents->m_bdzVentsExist)
+		if ((dzvents->m_bdzVentsExist) || (GetScriptIndex(m_dzVentsScriptIndex, dzvents->m_scriptsDir, ".lua")->bHaveScripts))
 			EvaluateLua(items, dzvents->m_runtimeDir + "dzVents.lua", "");
-		else
-		{
-			DirectoryListing(FileEntries, dzvents->m_scriptsDir, false, true);
-			for (const auto &filename : FileEntries)
-			{
-				if (filename.length() > 4 &&
-					filename.compare(filename.length() - 4, 4, ".lua") == 0)
-				{
-					EvaluateLua(items, dzvents->m_runtimeDir + "dzVents.lua", "");
-					break;
-				}
-			}
-			FileEntries.clear();
-		}
 	}
 
-	bool bDeviceFileFound = false;
-	DirectoryListing(FileEntries, m_lua_Dir, false, true);
+	std::shared_ptr<const _tScriptIndex> luaScripts = GetScriptIndex(m_luaScriptIndex, m_lua_Dir, ".lua");
 	for (const auto &item : items)
 	{
-		for (const auto &filename : FileEntries)
+		if (item.reason == REASON_DEVICE)
 		{
-			if (filename.length() > 4 &&
-				filename.compare(filename.length() - 4, 4, ".lua") == 0 &&
-				filename.find("_demo.lua") == std::string::npos)
+			// a _device_<name> script only runs for that device, unless no device has that name
+			std::string deviceName = SpaceToUnderscore(LowerCase(item.devname));
+			for (const auto &file : luaScripts->device)
 			{
-				if (item.reason == REASON_DEVICE && filename.find("_device_") != std::string::npos)
+				bool bDeviceFileFound = false;
+				bool bDeviceMatch = false;
 				{
-					bDeviceFileFound = false;
 					boost::shared_lock<boost::shared_mutex> devicestatesMutexLock(m_devicestatesMutex);
-					for (const auto &state : m_devicestates)
-					{
-						std::string deviceName = SpaceToUnderscore(LowerCase(state.second.deviceName));
-						if (filename.find("_device_" + deviceName + ".lua") != std::string::npos)
-						{
-							bDeviceFileFound = true;
-							if (deviceName == SpaceToUnderscore(LowerCase(item.devname)))
-							{
-								devicestatesMutexLock.unlock();
-								EvaluateLua(item, m_lua_Dir + filename, "");
-								break;
-							}
-						}
-					}
-					if (!bDeviceFileFound)
+					for (const auto &name : file.deviceNames)
 					{
-						devicestatesMutexLock.unlock();
-						EvaluateLua(item, m_lua_Dir + filename, "");
+						if (m_deviceNames.find(name) == m_deviceNames.end())
+							continue;
+						bDeviceFileFound = true;
+						if (name == deviceName)
+							bDeviceMatch = true;
 					}
 				}
-				else if ((item.reason == REASON_TIME && filename.find("_time_") != std::string::npos)
-					 || (item.reason == REASON_SECURITY && filename.find("_security_") != std::string::npos)
-					 || (item.reason == REASON_NOTIFICATION && filename.find("_notification_") != std::string::npos)
-					 || (item.reason == REASON_USERVARIABLE && filename.find("_variable_") != std::string::npos))
-				{
+				if ((bDeviceMatch) || (!bDeviceFileFound))
+					EvaluateLua(item, m_lua_Dir + file.filename, "");
+			}
+		}
+		else
+		{
+			const std::vector<std::string> *pFiles = nullptr;
+			if (item.reason == REASON_TIME)
+				pFiles = &luaScripts->time;
+			else if (item.reason == REASON_SECURITY)
+				pFiles = &luaScripts->security;
+			else if (item.reason == REASON_NOTIFICATION)
+				pFiles = &luaScripts->notification;
+			else if (item.reason == REASON_USERVARIABLE)
+				pFiles = &luaScripts->variable;
+			if (pFiles != nullptr)
+			{
+				for (const auto &filename : *pFiles)
 					EvaluateLua(item, m_lua_Dir + filename, "");
-				}
 			}
-			// else _log.Log(LOG_STATUS,"EventSystem: ignore file not .lua or is demo file: %s", filename.c_str());
 		}
 
 #ifdef ENABLE_PYTHON
 		boost::unique_lock<boost::shared_mutex> uservariablesMutexLock(m_uservariablesMutex);
 		try
 		{
-			for (const auto &filename : FileEntriesPython)
+			if (item.reason == REASON_DEVICE)
 			{
-				if (filename.length() > 3 &&
-					filename.compare(filename.length() - 3, 3, ".py") == 0 &&
-					filename.find("_demo.py") == std::string::npos)
+				for (const auto &file : pythonScripts->device)
+					EvaluatePython(item, m_python_Dir + file.filename, "");
+			}
+			else
+			{
+				const std::vector<std::string> *pFiles = nullptr;
+				if (item.reason == REASON_TIME)
+					pFiles = &pythonScripts->time;
+				else if (item.reason == REASON_SECURITY)
+					pFiles = &pythonScripts->security;
+				else if (item.reason == REASON_USERVARIABLE)
+					pFiles = &pythonScripts->variable;
+				if (pFiles != nullptr)
 				{
-					if ((item.reason == REASON_DEVICE && filename.find("_device_") != std::string::npos)
-					    || (item.reason == REASON_TIME && filename.find("_time_") != std::string::npos)
-					    || (item.reason == REASON_SECURITY && filename.find("_security_") != std::string::npos)
-					    || (item.reason == REASON_USERVARIABLE && filename.find("_variable_") != std::string::npos))
-					{
+					for (const auto &filename : *pFiles)
 						EvaluatePython(item, m_python_Dir + filename, "");
-					}
 				}
-				// else _log.Log(LOG_STATUS,"EventSystem: ignore file not .py or is demo file: %s", filename.c_str());
 			}
 		}
 		catch (...)
@@ -1640,7 +1830,7 @@ void CEventSystem::EvaluateEvent(const std::vector<_tEventQueue> &items)
 			if (!result.empty())
 			{
 				std::vector<std::string> sd = result[0];
-				Plugins::CPlugin* pPlugin = (Plugins::CPlugin*)m_mainworker.GetHardware(atoi(sd[0].c_str()));
+				std::shared_ptr<Plugins::CPlugin> pPlugin = std::static_pointer_cast<Plugins::CPlugin>(m_mainworker.GetHardware(atoi(sd[0].c_str())));
 				if (pPlugin)
 					pPlugin->MessagePlugin(new Plugins::onSecurityEventCallback(sd[2].c_str(), atoi(sd[3].c_str()), item.nValue, m_szSecStatus[item.nValue]));
 			}
@@ -1883,46 +2073,40 @@ void CEventSystem::EvaluateDatabaseEvents(const _tEventQueue &item)
 	boost::shared_lock<boost::shared_mutex> eventsMutexLock(m_eventsMutex);
 	try
 	{
-		for (const auto &event : m_events)
+		// Blockly events only run when their conditions refer to the trigger
+		const std::vector<size_t> *pBlocklyEvents = nullptr;
+		if ((item.reason == REASON_DEVICE) && (item.id > 0))
+		{
+			auto itt = m_blocklyDeviceEvents.find(item.id);
+			if (itt != m_blocklyDeviceEvents.end())
+				pBlocklyEvents = &itt->second;
+		}
+		else if (item.reason == REASON_SECURITY)
+			pBlocklyEvents = &m_blocklySecurityEvents;
+		else if (item.reason == REASON_TIME)
+			pBlocklyEvents = &m_blocklyTimeEvents;
+		else if ((item.reason == REASON_USERVARIABLE) && (item.id > 0))
+		{
+			auto itt = m_blocklyVariableEvents.find(item.id);
+			if (itt != m_blocklyVariableEvents.end())
+				pBlocklyEvents = &itt->second;
+		}
+
+		std::vector<size_t> eventIndexes;
+		if (pBlocklyEvents != nullptr)
+			std::merge(m_scriptEvents.begin(), m_scriptEvents.end(), pBlocklyEvents->begin(), pBlocklyEvents->end(), std::back_inserter(eventIndexes));
+		const std::vector<size_t> &events = (pBlocklyEvents != nullptr) ? eventIndexes : m_scriptEvents;
+
+		for (const auto ii : events)
 		{
+			const _tEventItem &event = m_events[ii];
 			bool eventInScope = ((event.Type == "all") || (event.Type == m_szReason[item.reason]));
 			bool eventActive = (event.EventStatus == 1);
 
 			if (eventInScope && eventActive)
 			{
 				if (event.Interpreter == "Blockly")
-				{
-					std::size_t found = std::string::npos;
-					if ((item.reason == REASON_DEVICE) && (item.id > 0))
-					{
-						std::stringstream sstr;
-						sstr << "[" << item.id << "]";
-						found = event.Conditions.find(sstr.str());
-					}
-					else if (item.reason == REASON_SECURITY)
-					{
-						// security status change
-						std::stringstream sstr;
-						sstr << "securitystatus";
-						found = event.Conditions.find(sstr.str());
-					}
-					else if (item.reason == REASON_TIME)
-					{
-						// time rules will only run when time or date based criteria are found
-						found = event.Conditions.find("timeofday");
-						if (found == std::string::npos)
-							found = event.Conditions.find("weekday");
-					}
-					else if ((item.reason == REASON_USERVARIABLE) && (item.id > 0))
-					{
-						std::stringstream sstr;
-						sstr << "variable[" << item.id << "]";
-						found = event.Conditions.find(sstr.str());
-					}
-
-					if (found != std::string::npos)
-						lua_state = ParseBlocklyLua(lua_state, event);
-				}
+					lua_state = ParseBlocklyLua(lua_state, event);
 				else if (event.Interpreter == "Lua")
 					EvaluateLua(item, event.Name, event.Actions);
 
@@ -2667,7 +2851,6 @@ void CEventSystem::ExportDeviceStatesToLua(lua_State *lua_state, const _tEventQu
 void CEventSystem::EvaluateLuaClassic(lua_State *lua_state, const _tEventQueue &item, const int secStatus)
 {
 	// reroute print library to Domoticz logger
-	luaL_openlibs(lua_state);
 	lua_pushcfunction(lua_state, l_domoticz_print);
 	lua_setglobal(lua_state, "print");
 
@@ -3019,28 +3202,13 @@ void CEventSystem::EvaluateLua(const std::vector<_tEventQueue> &items, const std
 {
 	std::lock_guard<std::mutex> l(luaMutex);
 
-	lua_State *lua_state;
-	lua_state = luaL_newstate();
-
-	// load Lua libraries
-	static const luaL_Reg lualibs[] = {
-		{ "base", luaopen_base },     { "io", luaopen_io },	{ "table", luaopen_table },
-		{ "string", luaopen_string }, { "math", luaopen_math }, { nullptr, nullptr },
-	};
-
-	const luaL_Reg *lib = lualibs;
-	for (; lib->func != nullptr; lib++)
+	lua_State *lua_state = m_luaStatePool.Acquire();
+	if (lua_state == nullptr)
 	{
-		lib->func(lua_state);
-		lua_settop(lua_state, 0);
+		_log.Log(LOG_ERROR, "EventSystem: Could not create a Lua state for script %s", filename.c_str());
+		return;
 	}
 
-	lua_pushcfunction(lua_state, l_domoticz_applyJsonPath);
-	lua_setglobal(lua_state, "domoticz_applyJsonPath");
-
-	lua_pushcfunction(lua_state, l_domoticz_applyXPath);
-	lua_setglobal(lua_state, "domoticz_applyXPath");
-
 #ifdef _DEBUG
 	_log.Log(LOG_STATUS, "EventSystem: script %s trigger (%s)", m_szReason[items[0].reason].c_str(), filename.c_str());
 #endif
@@ -3107,11 +3275,7 @@ void CEventSystem::EvaluateLua(const std::vector<_tEventQueue> &items, const std
 	else
 		EvaluateLuaClassic(lua_state, items[0], secstatus);
 
-	int status = 0;
-	if (LuaString.length() == 0)
-		status = luaL_loadfile(lua_state, filename.c_str());
-	else
-		status = luaL_loadstring(lua_state, LuaString.c_str());
+	int status = m_luaStatePool.LoadScript(lua_state, filename, LuaString);
 
 	if (status == 0)
 	{
@@ -3132,7 +3296,7 @@ void CEventSystem::EvaluateLua(const std::vector<_tEventQueue> &items, const std
 	else
 	{
 		report_errors(lua_state, status, filename);
-		lua_close(lua_state);
+		m_luaStatePool.Release(lua_state);
 		return;
 	}
 
@@ -3170,8 +3334,15 @@ void CEventSystem::EvaluateLua(const std::vector<_tEventQueue> &items, const std
 
 void CEventSystem::luaThread(lua_State *lua_state, const std::string &filename)
 {
+	uint64_t allocated = m_luaStatePool.GetAllocatedBytes(lua_state);
+	auto start = std::chrono::steady_clock::now();
+
 	int status;
 	status = lua_pcall(lua_state, 0, LUA_MULTRET, 0);
+
+	uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	m_luaStatePool.AddScriptStats(filename, us, m_luaStatePool.GetAllocatedBytes(lua_state) - allocated);
+
 	report_errors(lua_state, status, filename);
 
 	bool scriptTrue = false;
@@ -3195,8 +3366,17 @@ void CEventSystem::luaThread(lua_State *lua_state, const std::string &filename)
 			_log.Log(LOG_STATUS, "EventSystem: Script event triggered: %s", filename.c_str());
 	}
 
-	lua_close(lua_state);
+	m_luaStatePool.Release(lua_state);
+}
 
+std::vector<_tLuaScriptStats> CEventSystem::GetLuaScriptStats()
+{
+	return m_luaStatePool.GetScriptStats();
+}
+
+_tLuaStatePoolStats CEventSystem::GetLuaStatePoolStats()
+{
+	return m_luaStatePool.GetPoolStats();
 }
 
 void CEventSystem::luaStop(lua_State *L, lua_Debug *ar)
@@ -3206,7 +3386,6 @@ void CEventSystem::luaStop(lua_State *L, lua_Debug *ar)
 		(void)ar;  /* unused arg. */
 		lua_sethook(L, nullptr, 0, 0);
 		luaL_error(L, "Lua script execution exceeds maximum number of lines");
-		lua_close(L);
 	}
 }
 
@@ -3451,7 +3630,7 @@ bool CEventSystem::CustomCommand(const uint64_t idx, const std::string &sCommand
 		return false;
 
 	int HardwareID = atoi(result[0][0].c_str());
-	CDomoticzHardwareBase *pHardware = m_mainworker.GetHardware(HardwareID);
+	std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(HardwareID);
 	if (!pHardware)
 		return false;
 
@@ -3604,10 +3783,10 @@ bool CEventSystem::ScheduleEvent(int deviceID, const std::string &Action, bool i
 		}
 		std::string	sParams = oParseResults.sCommand.substr(14);
 
-		CDomoticzHardwareBase *pBaseHardware = m_mainworker.GetHardwareByType(HTYPE_Kodi);
+		std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardwareByType(HTYPE_Kodi);
 		if (pBaseHardware != nullptr)
 		{
-			CKodi			*pHardware = dynamic_cast<CKodi*>(pBaseHardware);
+			CKodi			*pHardware = dynamic_cast<CKodi*>(pBaseHardware.get());
 			std::string		sPlayList = sParams;
 			size_t			iLastSpace = sParams.find_last_of(' ', sParams.length());
 
@@ -3627,7 +3806,7 @@ bool CEventSystem::ScheduleEvent(int deviceID, const std::string &Action, bool i
 			pBaseHardware = m_mainworker.GetHardwareByType(HTYPE_LogitechMediaServer);
 			if (pBaseHardware == nullptr)
 				return false;
-			CLogitechMediaServer *pHardware = dynamic_cast<CLogitechMediaServer*>(pBaseHardware);
+			CLogitechMediaServer *pHardware = dynamic_cast<CLogitechMediaServer*>(pBaseHardware.get());
 
 			int iPlaylistID = pHardware->GetPlaylistRefID(oParseResults.sCommand.substr(14));
 			if (iPlaylistID == 0) return false;
@@ -3643,10 +3822,10 @@ bool CEventSystem::ScheduleEvent(int deviceID, const std::string &Action, bool i
 			return false;
 		}
 		std::string	sParams = oParseResults.sCommand.substr(15);
-		CDomoticzHardwareBase *pBaseHardware = m_mainworker.GetHardwareByType(HTYPE_Kodi);
+		std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardwareByType(HTYPE_Kodi);
 		if (pBaseHardware != nullptr)
 		{
-			//CKodi			*pHardware = dynamic_cast<CKodi*>(pBaseHardware);
+			//CKodi			*pHardware = dynamic_cast<CKodi*>(pBaseHardware.get());
 			if (sParams.length() > 0)
 			{
 				level = atoi(sParams.c_str());
@@ -3661,10 +3840,10 @@ bool CEventSystem::ScheduleEvent(int deviceID, const std::string &Action, bool i
 			return false;
 		}
 		std::string	sParams = oParseResults.sCommand.substr(8);
-		CDomoticzHardwareBase *pBaseHardware = m_mainworker.GetHardwareByType(HTYPE_Kodi);
+		std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardwareByType(HTYPE_Kodi);
 		if (pBaseHardware != nullptr)
 		{
-			CKodi	*pHardware = dynamic_cast<CKodi*>(pBaseHardware);
+			CKodi	*pHardware = dynamic_cast<CKodi*>(pBaseHardware.get());
 			pHardware->SetExecuteCommand(deviceID, sParams);
 		}
 	}
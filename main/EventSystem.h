@@ -1,15 +1,23 @@
 #pragma once
 
+#include <set>
 #include <string>
 #include <boost/thread/shared_mutex.hpp>
 
 #include "../httpclient/HTTPClient.h"
 
 #include "LuaCommon.h"
+#include "LuaStatePool.h"
 #include "concurrent_queue.h"
+#include "mpsc_ring_queue.h"
 #include "StoppableTask.h"
 #include "NotificationObserver.h"
 
+namespace Json
+{
+	class Value;
+} // namespace Json
+
 class CEventSystem : public CLuaCommon, StoppableTask, CNotificationObserver
 {
 	friend class CdzVents;
@@ -39,6 +47,26 @@ class CEventSystem : public CLuaCommon, StoppableTask, CNotificationObserver
 		float fRepeatSec = 0;
 		bool bEventTrigger = false;
 	};
+
+	struct _tScriptFile
+	{
+		std::string filename;
+		std::vector<std::string> deviceNames; // names that can follow _device_ in the filename
+	};
+
+	// Script files of a directory, grouped by the reason they trigger on
+	struct _tScriptIndex
+	{
+		std::string dir;
+		time_t mtime = 0;
+		time_t scanned = 0;
+		bool bHaveScripts = false;
+		std::vector<_tScriptFile> device;
+		std::vector<std::string> time;
+		std::vector<std::string> security;
+		std::vector<std::string> notification;
+		std::vector<std::string> variable;
+	};
 public:
 	enum _eReason
 	{
@@ -52,6 +80,22 @@ public:
 		REASON_SHELLCOMMAND  // 7
 	};
 
+	struct _tEventQueue
+	{
+		_eReason reason;
+		uint64_t id;
+		std::string devname;
+		int nValue;
+		std::string sValue;
+		std::string nValueWording;
+		std::string lastUpdate;
+		std::string errorText;
+		bool timeoutOccurred;
+		uint8_t lastLevel;
+		std::vector<std::string> vData;
+		queue_element_trigger* trigger = nullptr;
+	};
+
 	struct _tDeviceStatus
 	{
 		uint64_t ID;
@@ -81,6 +125,7 @@ public:
 		std::map<uint8_t, float> JsonMapFloat;
 		std::map<uint8_t, bool> JsonMapBool;
 		std::map<uint8_t, std::string> JsonMapString;
+		uint64_t version = 0; // changes whenever the entry changes
 	};
 
 	struct _tUserVariable
@@ -90,6 +135,7 @@ public:
 		std::string variableValue;
 		int variableType;
 		std::string lastUpdate;
+		uint64_t version = 0;
 	};
 
 	struct _tScenesGroups
@@ -102,6 +148,7 @@ public:
 		std::string lastUpdate;
 		std::string description;
 		std::vector<uint64_t> memberID;
+		uint64_t version = 0;
 	};
 
 	struct _tHardwareListInt {
@@ -134,12 +181,16 @@ public:
 	void UpdateUserVariable(uint64_t ulDevID, const std::string &varValue, const std::string &lastUpdate);
 	bool PythonScheduleEvent(const std::string &ID, const std::string &Action, const std::string &eventName);
 	bool GetEventTrigger(uint64_t ulDevID, _eReason reason, bool bEventTrigger);
+	queue_stats GetQueueStats();
+	void SetQueueOverflowPolicy(queue_overflow_policy policy);
 	void SetEventTrigger(uint64_t ulDevID, _eReason reason, float fDelayTime);
 	bool CustomCommand(uint64_t idx, const std::string &sCommand);
 
 	void TriggerURL(const std::string &result, const std::vector<std::string> &headerData, const std::string &callback);
 	void TriggerShellCommand(const std::string &result, const std::string &scriptstderr, const std::string &callback, int exitcode, bool timeoutOccurred);
 
+	std::vector<_tLuaScriptStats> GetLuaScriptStats();
+	_tLuaStatePoolStats GetLuaStatePoolStats();
 
 private:
 	enum _eJsonType
@@ -164,26 +215,7 @@ private:
 		time_t timestamp;
 	};
 
-	struct _tEventQueue
-	{
-		_eReason reason;
-		uint64_t id;
-		std::string devname;
-		int nValue;
-		std::string sValue;
-		std::string nValueWording;
-		std::string lastUpdate;
-		std::string errorText;
-		bool timeoutOccurred;
-		uint8_t lastLevel;
-		std::vector<std::string> vData;
-		std::map<uint8_t, int> JsonMapInt;
-		std::map<uint8_t, float> JsonMapFloat;
-		std::map<uint8_t, bool> JsonMapBool;
-		std::map<uint8_t, std::string> JsonMapString;
-		queue_element_trigger* trigger = nullptr;
-	};
-	concurrent_queue<_tEventQueue> m_eventqueue;
+	mpsc_ring_queue<_tEventQueue> m_eventqueue{ 2048 };
 
 	std::vector<_tEventTrigger> m_eventtrigger;
 	bool m_bEnabled;
@@ -194,6 +226,9 @@ private:
 	boost::shared_mutex m_eventtriggerMutex;
 	std::mutex m_measurementStatesMutex;
 	std::mutex luaMutex;
+	// Devices whose JSON maps have to be read again, guarded by m_devicestatesMutex
+	std::set<uint64_t> m_jsonMapsStale;
+	CLuaStatePool m_luaStatePool;
 	std::shared_ptr<std::thread> m_thread;
 	std::shared_ptr<std::thread> m_eventqueuethread;
 	StoppableTask m_TaskQueue;
@@ -233,7 +268,8 @@ private:
 
 	std::string ParseBlocklyString(const std::string &oString);
 	void ParseActionString( const std::string &oAction_, _tActionParseResults &oResults_ );
-	void UpdateJsonMap(_tDeviceStatus &item, uint64_t ulDevID);
+	void UpdateJsonMap(_tDeviceStatus &item, const Json::Value &device);
+	void RefreshJsonMaps();
 	void EventQueueThread();
 	void UnlockEventQueueThread();
 	void ExportDeviceStatesToLua(lua_State *lua_state, const _tEventQueue &item);
@@ -242,6 +278,27 @@ private:
 	//std::string reciprocalAction (std::string Action);
 	std::vector<_tEventItem> m_events;
 
+	// Indexes into m_events, built by LoadEvents
+	std::map<uint64_t, std::vector<size_t>> m_blocklyDeviceEvents;
+	std::map<uint64_t, std::vector<size_t>> m_blocklyVariableEvents;
+	std::vector<size_t> m_blocklySecurityEvents;
+	std::vector<size_t> m_blocklyTimeEvents;
+	std::vector<size_t> m_scriptEvents;
+	void BuildEventTriggerIndex();
+
+	std::mutex m_scriptIndexMutex;
+	std::shared_ptr<const _tScriptIndex> m_luaScriptIndex;
+	std::shared_ptr<const _tScriptIndex> m_pythonScriptIndex;
+	std::shared_ptr<const _tScriptIndex> m_dzVentsScriptIndex;
+	std::shared_ptr<const _tScriptIndex> GetScriptIndex(std::shared_ptr<const _tScriptIndex> &index, const std::string &dir, const std::string &extension);
+
+	// Normalized device names (lower case, spaces as underscores) with their use count
+	std::map<std::string, int> m_deviceNames;
+
+	// Source of the version of device, scene/group and user variable entries
+	std::atomic<uint64_t> m_stateVersion{ 0 };
+	void UpdateDeviceName(const std::string &oldName, const std::string &newName);
+
 
 	std::map<uint64_t, _tDeviceStatus> m_devicestates;
 	std::map<uint64_t, _tUserVariable> m_uservariables;
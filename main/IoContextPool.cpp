@@ -0,0 +1,155 @@
+#include "stdafx.h"
+#include "IoContextPool.h"
+#include "Helper.h"
+#include "Logger.h"
+
+#define IOCONNECTION_IDLE_TIMEOUT 30
+
+CIoContextPool::~CIoContextPool()
+{
+	Stop();
+}
+
+void CIoContextPool::SetThreadCount(const int threads)
+{
+	std::unique_lock<std::mutex> lock(m_threads_mutex);
+	m_thread_count = (threads < 1) ? 1 : threads;
+}
+
+void CIoContextPool::Start()
+{
+	std::unique_lock<std::mutex> lock(m_threads_mutex);
+	if (!m_threads.empty())
+		return;
+	m_stopped = false;
+	m_ios.restart();
+	m_work = std::make_shared<boost::asio::io_service::work>(m_ios);
+	for (int ii = 0; ii < m_thread_count; ii++)
+	{
+		auto pThread = std::make_shared<std::thread>([this] {
+			for (;;)
+			{
+				try
+				{
+					m_ios.run();
+					break;
+				}
+				catch (std::exception &e)
+				{
+					_log.Log(LOG_ERROR, "IoPool: Exception in handler: %s", e.what());
+				}
+				catch (...)
+				{
+					_log.Log(LOG_ERROR, "IoPool: Unknown exception in handler");
+				}
+			}
+		});
+		SetThreadName(pThread->native_handle(), "IoPool");
+		m_threads.push_back(pThread);
+	}
+	_log.Log(LOG_STATUS, "IoPool: Started with %d thread(s)", m_thread_count);
+}
+
+void CIoContextPool::Stop()
+{
+	std::unique_lock<std::mutex> lock(m_threads_mutex);
+	if (m_threads.empty())
+		return;
+	m_work.reset();
+	m_ios.stop();
+	for (auto &pThread : m_threads)
+		pThread->join();
+	m_threads.clear();
+	m_stopped = true;
+}
+
+boost::asio::io_service &CIoContextPool::GetIoContext()
+{
+	std::unique_lock<std::mutex> lock(m_threads_mutex);
+	if (m_stopped)
+		_log.Log(LOG_ERROR, "IoPool: Connection created after the pool was stopped, its handlers will not run!");
+	return m_ios;
+}
+
+int CIoContextPool::GetThreadCount()
+{
+	std::unique_lock<std::mutex> lock(m_threads_mutex);
+	return (int)m_threads.size();
+}
+
+std::vector<_tIoConnectionStats> CIoContextPool::GetConnectionStats()
+{
+	std::vector<_tIoConnectionStats> ret;
+	std::unique_lock<std::mutex> lock(m_connections_mutex);
+	for (auto pConnection : m_connections)
+		ret.push_back(pConnection->GetStats());
+	return ret;
+}
+
+void CIoContextPool::RegisterConnection(CIoConnection *pConnection)
+{
+	std::unique_lock<std::mutex> lock(m_connections_mutex);
+	m_connections.insert(pConnection);
+}
+
+void CIoContextPool::UnregisterConnection(CIoConnection *pConnection)
+{
+	std::unique_lock<std::mutex> lock(m_connections_mutex);
+	m_connections.erase(pConnection);
+}
+
+CIoConnection::CIoConnection(const std::string &name)
+	: m_strand(m_iopool.GetIoContext())
+	, m_name(name)
+{
+	m_iopool.RegisterConnection(this);
+}
+
+CIoConnection::~CIoConnection()
+{
+	m_iopool.UnregisterConnection(this);
+}
+
+void CIoConnection::SetName(const std::string &name)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_name = name;
+}
+
+void CIoConnection::HandlerDone(const std::chrono::steady_clock::time_point &tStart)
+{
+	uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - tStart).count();
+	m_handlers++;
+	m_total_us += us;
+	uint64_t max_us = m_max_us.load();
+	while ((us > max_us) && (!m_max_us.compare_exchange_weak(max_us, us)))
+		;
+}
+
+void CIoConnection::WaitIdle()
+{
+	//A handler can not wait for itself (and the ones queued behind it)
+	if (RunningInThisThread())
+		return;
+	std::unique_lock<std::mutex> lock(m_pending->mutex);
+	if (!m_pending->idle.wait_for(lock, std::chrono::seconds(IOCONNECTION_IDLE_TIMEOUT), [this] { return m_pending->count == 0; }))
+	{
+		lock.unlock();
+		std::unique_lock<std::mutex> lock2(m_mutex);
+		_log.Log(LOG_ERROR, "IoPool: %s still has %d pending handler(s)!", m_name.c_str(), (int)m_pending->count);
+	}
+}
+
+_tIoConnectionStats CIoConnection::GetStats()
+{
+	_tIoConnectionStats stats;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		stats.name = m_name;
+	}
+	stats.handlers = m_handlers;
+	stats.total_us = m_total_us;
+	stats.max_us = m_max_us;
+	stats.pending = m_pending->count;
+	return stats;
+}
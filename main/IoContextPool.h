@@ -0,0 +1,161 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/strand.hpp>
+
+#define IOPOOL_DEFAULT_THREADS 2
+
+struct _tIoConnectionStats
+{
+	std::string name;
+	uint64_t handlers;
+	uint64_t total_us;
+	uint64_t max_us;
+	int pending;
+};
+
+class CIoConnection;
+
+//Process wide io_service run by a small set of threads.
+//Connections (ASyncTCP, AsyncSerial, plugin transports) run their handlers
+//through their own CIoConnection strand, so they are never executed concurrently
+class CIoContextPool
+{
+      public:
+	CIoContextPool() = default;
+	~CIoContextPool();
+
+	void SetThreadCount(int threads);
+	void Start();
+	void Stop();
+
+	//The pool is started by main, handlers posted before Start run once it is started,
+	//handlers posted after Stop never run
+	boost::asio::io_service &GetIoContext();
+	int GetThreadCount();
+	std::vector<_tIoConnectionStats> GetConnectionStats();
+
+      private:
+	friend class CIoConnection;
+	void RegisterConnection(CIoConnection *pConnection);
+	void UnregisterConnection(CIoConnection *pConnection);
+
+	boost::asio::io_service m_ios;
+	std::shared_ptr<boost::asio::io_service::work> m_work;
+	std::vector<std::shared_ptr<std::thread>> m_threads;
+	int m_thread_count = IOPOOL_DEFAULT_THREADS;
+	bool m_stopped = false;
+	std::mutex m_threads_mutex;
+
+	std::mutex m_connections_mutex;
+	std::set<CIoConnection *> m_connections;
+};
+
+extern CIoContextPool m_iopool;
+
+//Strand on the shared pool plus the bookkeeping needed to wait for all
+//outstanding handlers of a connection, and per connection handler timings
+class CIoConnection
+{
+      public:
+	explicit CIoConnection(const std::string &name);
+	~CIoConnection();
+
+	CIoConnection(const CIoConnection &) = delete;
+	CIoConnection &operator=(const CIoConnection &) = delete;
+
+	void SetName(const std::string &name);
+	boost::asio::io_service &GetIoContext()
+	{
+		return m_strand.context();
+	};
+	boost::asio::io_service::strand &GetStrand()
+	{
+		return m_strand;
+	};
+	bool RunningInThisThread() const
+	{
+		return m_strand.running_in_this_thread();
+	};
+
+	//Wraps a completion handler so it runs on the strand and is accounted for.
+	//It stays pending until the wrapped handler is destroyed, also when it is never invoked
+	template <typename Handler> auto wrap(Handler &&handler)
+	{
+		return boost::asio::bind_executor(m_strand, [this, pending = CPendingHandler(m_pending), h = std::forward<Handler>(handler)](auto &&... args) mutable {
+			auto tStart = std::chrono::steady_clock::now();
+			try
+			{
+				h(std::forward<decltype(args)>(args)...);
+			}
+			catch (...)
+			{
+				HandlerDone(tStart);
+				throw;
+			}
+			HandlerDone(tStart);
+		});
+	}
+
+	template <typename Handler> void post(Handler &&handler)
+	{
+		boost::asio::post(wrap(std::forward<Handler>(handler)));
+	}
+
+	//Blocks until every wrapped handler has run (or was cancelled and ran)
+	void WaitIdle();
+	_tIoConnectionStats GetStats();
+
+      private:
+	//Outlives the connection, a handler can be destroyed by the io_service after that
+	struct _tPendingState
+	{
+		std::mutex mutex;
+		std::condition_variable idle;
+		std::atomic<int> count{ 0 };
+	};
+	//Counts a wrapped handler as pending for as long as it exists (move only)
+	class CPendingHandler
+	{
+	      public:
+		explicit CPendingHandler(const std::shared_ptr<_tPendingState> &state)
+			: m_state(state)
+		{
+			m_state->count++;
+		}
+		CPendingHandler(CPendingHandler &&) = default;
+		CPendingHandler(const CPendingHandler &) = delete;
+		CPendingHandler &operator=(const CPendingHandler &) = delete;
+		~CPendingHandler()
+		{
+			if ((m_state) && (--m_state->count == 0))
+			{
+				std::unique_lock<std::mutex> lock(m_state->mutex);
+				m_state->idle.notify_all();
+			}
+		}
+
+	      private:
+		std::shared_ptr<_tPendingState> m_state;
+	};
+
+	void HandlerDone(const std::chrono::steady_clock::time_point &tStart);
+
+	boost::asio::io_service::strand m_strand;
+	std::string m_name;
+	std::mutex m_mutex;
+	std::shared_ptr<_tPendingState> m_pending = std::make_shared<_tPendingState>();
+	std::atomic<uint64_t> m_handlers{ 0 };
+	std::atomic<uint64_t> m_total_us{ 0 };
+	std::atomic<uint64_t> m_max_us{ 0 };
+};
@@ -15,7 +15,6 @@
 
 #include "SQLHelper.h"
 
-#define MAX_LOG_LINE_BUFFER 100
 #define MAX_LOG_LINE_LENGTH (2048 * 3)
 
 #define MAX_ACLFLOG_LINES 100000
@@ -32,7 +31,6 @@ CLogger::_tLogLineStruct::_tLogLineStruct(const _eLogLevel nlevel, const std::st
 
 CLogger::CLogger()
 {
-	m_bInSequenceMode = false;
 	m_bEnableLogThreadIDs = false;
 	m_bEnableLogTimestamps = true;
 	m_bEnableErrorsToNotificationSystem = false;
@@ -43,10 +41,27 @@ CLogger::CLogger()
 
 CLogger::~CLogger()
 {
+	StopWriter();
 	if (m_outputfile.is_open())
 		m_outputfile.close();
 }
 
+// Index of the last log ring of a level
+static size_t LogLevelIndex(const _eLogLevel level)
+{
+	switch (level)
+	{
+	case LOG_STATUS:
+		return 1;
+	case LOG_ERROR:
+		return 2;
+	case LOG_DEBUG_INT:
+		return 3;
+	default:
+		return 0;
+	}
+}
+
 // Supported flags: all,normal,status,error,debug
 bool CLogger::SetLogFlags(const std::string &sFlags)
 {
@@ -197,6 +212,142 @@ void CLogger::SetOutputFile(const char *OutputFile)
 	}
 }
 
+void CLogger::SetFlushInterval(const int iMilliseconds)
+{
+	m_flush_interval = (iMilliseconds > 0) ? iMilliseconds : 0;
+}
+
+void CLogger::StartWriter()
+{
+	if (m_thread)
+		return;
+	m_bStopWriter = false;
+	m_thread = std::make_shared<std::thread>([this] { Do_Work(); });
+	SetThreadName(m_thread->native_handle(), "Logger");
+	m_bWriterRunning = true;
+}
+
+void CLogger::StopWriter()
+{
+	if (!m_thread)
+		return;
+	m_bWriterRunning = false;
+	// a thread that still saw the writer running queues its line, wait for it so the line is not left behind
+	while (m_pushing.load() != 0)
+		std::this_thread::yield();
+	m_bStopWriter = true;
+	m_thread->join();
+	m_thread.reset();
+}
+
+void CLogger::WriteDirect()
+{
+	m_bWriterRunning = false;
+}
+
+void CLogger::Do_Work()
+{
+	std::vector<_tLogLineStruct> lines;
+	size_t pending = 0; // lines written but not flushed yet
+	auto lastflush = std::chrono::steady_clock::now();
+
+	while (!m_bStopWriter)
+	{
+		int interval = m_flush_interval;
+		lines.clear();
+		m_logqueue.timed_wait_and_pop_all(lines, std::chrono::milliseconds((pending != 0) ? interval : 500));
+		pending += lines.size();
+		bool bFlush = WriteLines(lines); // flush errors right away
+
+		// the queue has room again, mark the gap after the lines that were queued before it
+		uint64_t dropped = m_dropped_lines;
+		if (dropped != m_reported_drops)
+		{
+			// written directly when the queue is full again, the writer never waits for its own queue
+			Log(LOG_ERROR, "Logger: log queue full, %lu log lines dropped", (unsigned long)(dropped - m_reported_drops));
+			m_reported_drops = dropped;
+			bFlush = true;
+		}
+		auto now = std::chrono::steady_clock::now();
+		if ((!bFlush) && ((pending == 0) || (now - lastflush < std::chrono::milliseconds(interval))))
+			continue;
+		if (pending != 0)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			FlushOutput();
+		}
+		lastflush = now;
+		pending = 0;
+	}
+
+	// StopWriter made sure nothing is queued anymore
+	lines.clear();
+	m_logqueue.pop_all(lines);
+	WriteLines(lines);
+	std::unique_lock<std::mutex> lock(m_mutex);
+	FlushOutput();
+}
+
+bool CLogger::WriteLines(std::vector<_tLogLineStruct> &lines)
+{
+	if (lines.empty())
+		return false;
+	bool bHaveError = false;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		for (const auto &line : lines)
+		{
+			WriteLine(line);
+			if (line.level & LOG_ERROR)
+				bHaveError = true;
+		}
+	}
+	std::unique_lock<std::mutex> lock(m_lastlog_mutex);
+	for (auto &line : lines)
+		AddToLastLog(std::move(line));
+	return bHaveError;
+}
+
+// Called with m_mutex locked
+void CLogger::WriteLine(const _tLogLineStruct &line)
+{
+	if (!g_bRunAsDaemon)
+	{
+		// output to console
+#ifndef WIN32
+		if (line.level != LOG_ERROR)
+#endif
+			std::cout << line.logmessage << '\n';
+#ifndef WIN32
+		else // print text in red color
+			std::cout << line.logmessage.substr(0, 25) << "\033[1;31m" << line.logmessage.substr(25) << "\033[0;0m" << '\n';
+#endif
+	}
+
+	if (m_outputfile.is_open())
+	{
+		// output to file
+		m_outputfile << line.logmessage << '\n';
+	}
+}
+
+// Called with m_mutex locked
+void CLogger::FlushOutput()
+{
+	if (!g_bRunAsDaemon)
+		std::cout.flush();
+	if (m_outputfile.is_open())
+		m_outputfile.flush();
+}
+
+// Called with m_lastlog_mutex locked
+void CLogger::AddToLastLog(_tLogLineStruct &&line)
+{
+	_tLogRing &ring = m_lastlog[LogLevelIndex(line.level)];
+	ring.lines[ring.count % MAX_LOG_LINE_BUFFER] = std::move(line);
+	ring.count++;
+}
+
 void CLogger::SetACLFOutputFile(const char *OutputFile)
 {
 	std::string sLogFile = OutputFile;
@@ -243,7 +394,10 @@ void CLogger::ForwardErrorsToNotificationSystem(const bool bDoForward)
 {
 	m_bEnableErrorsToNotificationSystem = bDoForward;
 	if (!bDoForward)
+	{
+		std::unique_lock<std::mutex> lock(m_notification_mutex);
 		m_notification_log.clear();
+	}
 }
 
 void CLogger::Log(const _eLogLevel level, const std::string &sLogline)
@@ -274,74 +428,73 @@ void CLogger::Log(const _eLogLevel level, const char *logline, ...)
 	}
 #endif
 
-	std::stringstream sstr;
+	std::string szIntLog;
+	szIntLog.reserve(64 + strlen(cbuffer));
 
 	if (m_bEnableLogTimestamps)
-		sstr << TimeToString(nullptr, TF_DateTimeMs) << "  ";
+	{
+		szIntLog = TimeToString(nullptr, TF_DateTimeMs);
+		szIntLog += "  ";
+	}
 
 	if ((m_log_flags & LOG_DEBUG_INT) && (m_debug_flags & DEBUG_THREADIDS))
 	{
+		std::stringstream sstr;
 #ifdef WIN32
 		sstr << "[" << std::setfill('0') << std::setw(4) << std::hex << ::GetCurrentThreadId() << "] ";
 #else
 		sstr << "[" << std::setfill('0') << std::setw(4) << std::hex << pthread_self() << "] ";
 #endif
+		szIntLog += sstr.str();
 	}
 
 	if (level & LOG_STATUS)
-		sstr << "Status: " << cbuffer;
+		szIntLog += "Status: ";
 	else if (level & LOG_ERROR)
-		sstr << "Error: " << cbuffer;
+		szIntLog += "Error: ";
 	else if (level & LOG_DEBUG_INT)
-		sstr << "Debug: " << cbuffer;
-	else
-		sstr << cbuffer;
-
-	std::string szIntLog = sstr.str();
+		szIntLog += "Debug: ";
+	szIntLog += cbuffer;
 
+	if ((level & LOG_ERROR) && (m_bEnableErrorsToNotificationSystem))
 	{
-		// Locked region to allow multiple threads to print at the same time
-		std::unique_lock<std::mutex> lock(m_mutex);
-
-		if ((level & LOG_ERROR) && (m_bEnableErrorsToNotificationSystem))
+		std::unique_lock<std::mutex> lock(m_notification_mutex);
+		if (m_notification_log.size() >= MAX_LOG_LINE_BUFFER)
+			m_notification_log.erase(m_notification_log.begin());
+		m_notification_log.push_back(_tLogLineStruct(level, szIntLog));
+		if ((m_notification_log.size() == 1) && (mytime(nullptr) - m_LastLogNotificationsSend >= 5))
 		{
-			if (m_notification_log.size() >= MAX_LOG_LINE_BUFFER)
-				m_notification_log.erase(m_notification_log.begin());
-			m_notification_log.push_back(_tLogLineStruct(level, szIntLog));
-			if ((m_notification_log.size() == 1) && (mytime(nullptr) - m_LastLogNotificationsSend >= 5))
-			{
-				m_mainworker.ForceLogNotificationCheck();
-			}
-		}
-
-		if (!g_bRunAsDaemon)
-		{
-			// output to console
-#ifndef WIN32
-			if (level != LOG_ERROR)
-#endif
-				std::cout << szIntLog << std::endl;
-#ifndef WIN32
-			else // print text in red color
-				std::cout << szIntLog.substr(0, 25) << "\033[1;31m" << szIntLog.substr(25) << "\033[0;0m" << std::endl;
-#endif
+			m_mainworker.ForceLogNotificationCheck();
 		}
+	}
 
-		if (m_outputfile.is_open())
+	_tLogLineStruct line(level, szIntLog);
+	m_pushing++;
+	if (m_bWriterRunning)
+	{
+		bool bQueued = m_logqueue.push(std::move(line));
+		m_pushing--;
+		if (bQueued)
+			return;
+		if (!(level & LOG_ERROR))
 		{
-			// output to file
-			m_outputfile << szIntLog << std::endl;
-			m_outputfile.flush();
+			m_dropped_lines++; // reported by the writer
+			return;
 		}
+		// errors are never dropped, a full queue is bypassed
+	}
+	else
+		m_pushing--;
 
-		auto itt = m_lastlog.find(level);
-		if (itt != m_lastlog.end())
-		{
-			if (m_lastlog[level].size() >= MAX_LOG_LINE_BUFFER)
-				m_lastlog[level].erase(m_lastlog[level].begin());
-		}
-		m_lastlog[level].push_back(_tLogLineStruct(level, szIntLog));
+	// No writer thread (yet) or the queue is full, write it ourself
+	{
+		// Locked region to allow multiple threads to print at the same time
+		std::unique_lock<std::mutex> lock(m_mutex);
+		WriteLine(line);
+		FlushOutput();
 	}
+	std::unique_lock<std::mutex> lock(m_lastlog_mutex);
+	AddToLastLog(std::move(line));
 }
 
 void CLogger::Debug(const _eDebugLevel level, const char *logline, ...)
@@ -409,45 +562,49 @@ bool strhasEnding(std::string const &fullString, std::string const &ending)
 	return fullString.size() >= ending.size() && !fullString.compare(fullString.size() - ending.size(), ending.size(), ending);
 }
 
+// A sequence belongs to the thread that started it, decoders run on several threads
+static thread_local bool bInLogSequence = false;
+static thread_local std::stringstream logsequencestring;
+
 void CLogger::LogSequenceStart()
 {
-	m_bInSequenceMode = true;
-	m_sequencestring.clear();
-	m_sequencestring.str("");
+	bInLogSequence = true;
+	logsequencestring.clear();
+	logsequencestring.str("");
 }
 
 void CLogger::LogSequenceEnd(const _eLogLevel level)
 {
-	if (!m_bInSequenceMode)
+	if (!bInLogSequence)
 		return;
 
-	std::string message = m_sequencestring.str();
+	std::string message = logsequencestring.str();
 	if (strhasEnding(message, "\n"))
 	{
 		message = message.substr(0, message.size() - 1);
 	}
 
 	Log(level, message);
-	m_sequencestring.clear();
-	m_sequencestring.str("");
+	logsequencestring.clear();
+	logsequencestring.str("");
 
-	m_bInSequenceMode = false;
+	bInLogSequence = false;
 }
 
 void CLogger::LogSequenceAdd(const char *logline)
 {
-	if (!m_bInSequenceMode)
+	if (!bInLogSequence)
 		return;
 
-	m_sequencestring << logline << std::endl;
+	logsequencestring << logline << std::endl;
 }
 
 void CLogger::LogSequenceAddNoLF(const char *logline)
 {
-	if (!m_bInSequenceMode)
+	if (!bInLogSequence)
 		return;
 
-	m_sequencestring << logline;
+	logsequencestring << logline;
 }
 
 void CLogger::EnableLogTimestamps(const bool bEnableTimestamps)
@@ -467,19 +624,24 @@ bool compareLogByTime(const CLogger::_tLogLineStruct &a, CLogger::_tLogLineStruc
 
 std::list<CLogger::_tLogLineStruct> CLogger::GetLog(const _eLogLevel level, const time_t lastlogtime)
 {
-	std::unique_lock<std::mutex> lock(m_mutex);
 	std::list<_tLogLineStruct> mlist;
-
-	if (level != LOG_ALL)
 	{
-		if (m_lastlog.find(level) == m_lastlog.end())
-			return mlist;
-
-		std::copy_if(std::begin(m_lastlog[level]), std::end(m_lastlog[level]), std::back_inserter(mlist), [lastlogtime](const _tLogLineStruct &l) { return l.logtime > lastlogtime; });
+		// only the writer contends for this lock, never the threads that log
+		std::unique_lock<std::mutex> lock(m_lastlog_mutex);
+		for (size_t ii = 0; ii < m_lastlog.size(); ii++)
+		{
+			if ((level != LOG_ALL) && (ii != LogLevelIndex(level)))
+				continue;
+			const _tLogRing &ring = m_lastlog[ii];
+			size_t first = (ring.count > MAX_LOG_LINE_BUFFER) ? ring.count - MAX_LOG_LINE_BUFFER : 0;
+			for (size_t pos = first; pos < ring.count; pos++)
+			{
+				const _tLogLineStruct &l = ring.lines[pos % MAX_LOG_LINE_BUFFER];
+				if (l.logtime > lastlogtime)
+					mlist.push_back(l);
+			}
+		}
 	}
-	else
-		for (const auto &l : m_lastlog)
-			std::copy_if(l.second.begin(), l.second.end(), std::back_inserter(mlist), [lastlogtime](const _tLogLineStruct &l2) { return l2.logtime > lastlogtime; });
 
 	// Sort by time
 	mlist.sort(compareLogByTime);
@@ -488,13 +650,18 @@ std::list<CLogger::_tLogLineStruct> CLogger::GetLog(const _eLogLevel level, cons
 
 void CLogger::ClearLog()
 {
-	std::unique_lock<std::mutex> lock(m_mutex);
-	m_lastlog.clear();
+	std::unique_lock<std::mutex> lock(m_lastlog_mutex);
+	for (auto &ring : m_lastlog)
+	{
+		for (auto &l : ring.lines)
+			l = _tLogLineStruct();
+		ring.count = 0;
+	}
 }
 
 std::list<CLogger::_tLogLineStruct> CLogger::GetNotificationLogs()
 {
-	std::unique_lock<std::mutex> lock(m_mutex);
+	std::unique_lock<std::mutex> lock(m_notification_mutex);
 	std::list<_tLogLineStruct> mlist;
 	std::copy(m_notification_log.begin(), m_notification_log.end(), std::back_inserter(mlist));
 	m_notification_log.clear();
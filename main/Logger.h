@@ -1,9 +1,17 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <deque>
 #include <list>
 #include <string>
 #include <fstream>
+#include <thread>
+#include "mpsc_ring_queue.h"
+
+#define MAX_LOG_LINE_BUFFER 100
+#define LOG_QUEUE_SIZE 4096
+#define LOG_FLUSH_INTERVAL 250 // ms
 
 enum _eLogLevel : uint32_t
 {
@@ -40,9 +48,10 @@ class CLogger
       public:
 	struct _tLogLineStruct
 	{
-		time_t logtime;
-		_eLogLevel level;
+		time_t logtime = 0;
+		_eLogLevel level = LOG_NORM;
 		std::string logmessage;
+		_tLogLineStruct() = default;
 		_tLogLineStruct(_eLogLevel nlevel, const std::string &nlogmessage);
 	};
 
@@ -61,6 +70,15 @@ class CLogger
 	bool IsACLFlogEnabled();
 
 	void SetOutputFile(const char *OutputFile);
+	void SetFlushInterval(int iMilliseconds);
+
+	// Lines are written by a background thread once it is started,
+	// before that (and after stopping it) they are written directly
+	void StartWriter();
+	void StopWriter();
+	// Used by the fatal signal handlers, following lines are written directly instead of
+	// being queued for a writer that might not get to them. Only stores an atomic flag
+	void WriteDirect();
 	void SetACLFOutputFile(const char *OutputFile);
 	void OpenACLFOutputFile();
 
@@ -99,6 +117,20 @@ class CLogger
 	bool NotificationLogsEnabled();
 
       private:
+	// Last lines of a log level, slots are reused once the ring is full
+	struct _tLogRing
+	{
+		std::array<_tLogLineStruct, MAX_LOG_LINE_BUFFER> lines;
+		size_t count = 0; // lines added since the last clear
+	};
+
+	void Do_Work();
+	// Writes the lines and moves them to the last log, returns true when an error was written
+	bool WriteLines(std::vector<_tLogLineStruct> &lines);
+	void WriteLine(const _tLogLineStruct &line);
+	void FlushOutput();
+	void AddToLastLog(_tLogLineStruct &&line);
+
 	uint32_t m_log_flags;
 	uint32_t m_debug_flags;
 	uint8_t m_aclf_flags;
@@ -108,13 +140,27 @@ class CLogger
 	std::ofstream m_outputfile;
 	const char *m_aclflogfile;
 	std::ofstream m_aclfoutputfile;
-	std::map<_eLogLevel, std::deque<_tLogLineStruct>> m_lastlog;
+
+	std::mutex m_lastlog_mutex;
+	std::array<_tLogRing, 4> m_lastlog;
+
+	std::mutex m_notification_mutex;
 	std::deque<_tLogLineStruct> m_notification_log;
-	bool m_bInSequenceMode;
+
+	// A full queue drops the line (and counts it) instead of blocking the thread that logs,
+	// errors are written by the logging thread itself then
+	mpsc_ring_queue<_tLogLineStruct> m_logqueue{ LOG_QUEUE_SIZE, queue_overflow_policy::drop_newest };
+	std::shared_ptr<std::thread> m_thread;
+	std::atomic<bool> m_bWriterRunning{ false };
+	std::atomic<bool> m_bStopWriter{ false };
+	std::atomic<int> m_pushing{ 0 }; // threads between checking m_bWriterRunning and queueing their line
+	std::atomic<int> m_flush_interval{ LOG_FLUSH_INTERVAL };
+	uint64_t m_reported_drops = 0; // writer only
+	std::atomic<uint64_t> m_dropped_lines{ 0 }; // not counting the errors, they are written directly
+
 	bool m_bEnableLogTimestamps;
 	bool m_bEnableLogThreadIDs;
 	bool m_bEnableErrorsToNotificationSystem;
 	time_t m_LastLogNotificationsSend;
-	std::stringstream m_sequencestring;
 };
 extern CLogger _log;
@@ -0,0 +1,419 @@
+#include "stdafx.h"
+#include "LuaStatePool.h"
+#include "Logger.h"
+#include <sys/stat.h>
+
+extern "C" {
+#include <lua.h>
+#include <lualib.h>
+#include <lauxlib.h>
+}
+
+namespace
+{
+	// Records everything that is reachable from the globals and the registry of a freshly
+	// initialized state (table fields, metatables and the upvalues of Lua functions) and
+	// returns the function that puts it back after an evaluation.
+	// Modules loaded from the resident path (the argument) stay loaded, they are recorded
+	// when they are loaded and reset like the globals. Other modules are unloaded again.
+	// Registry fields with an integer key (luaL_ref references of the host) are kept.
+	constexpr const char *szLuaSandboxSnapshot = R"(
+local residentPath = ...
+local G, registry, loaded = _G, debug.getregistry(), package.loaded
+local next, type, rawget, rawset = next, type, rawget, rawset
+local dgetmetatable, dsetmetatable = debug.getmetatable, debug.setmetatable
+local dgetupvalue, dsetupvalue, dgetinfo = debug.getupvalue, debug.setupvalue, debug.getinfo
+local tables, upvalues, modules, resident, regfields = {}, {}, {}, {}, {}
+local skip = { [loaded] = true, [registry] = true }
+if registry._CLIBS then skip[registry._CLIBS] = true end
+
+local function record(v)
+	local t = type(v)
+	if t == 'table' then
+		if skip[v] or tables[v] then return end
+		local fields = {}
+		local meta = dgetmetatable(v)
+		tables[v] = { fields = fields, meta = meta }
+		for k, v2 in next, v do
+			fields[k] = v2
+			record(k)
+			record(v2)
+		end
+		record(meta)
+	elseif t == 'function' then
+		if skip[v] or upvalues[v] or dgetinfo(v, 'S').what == 'C' then return end
+		local values = {}
+		upvalues[v] = values
+		local i = 1
+		while true do
+			local name, uv = dgetupvalue(v, i)
+			if name == nil then break end
+			values[i] = uv
+			record(uv)
+			i = i + 1
+		end
+		values.n = i - 1
+	end
+end
+
+if residentPath ~= '' then
+	local luasearcher = package.searchers[2]
+	local searcher = function(name)
+		local loader, filename = luasearcher(name)
+		if type(loader) ~= 'function' or filename:sub(1, #residentPath) ~= residentPath then
+			return loader, filename
+		end
+		return function(...)
+			local m = loader(...)
+			if m == nil then m = rawget(loaded, name) end
+			if m == nil then m = true end
+			resident[name] = m
+			record(m)
+			return m
+		end, filename
+	end
+	skip[searcher] = true
+	package.searchers[2] = searcher
+end
+
+record(G)
+record(dgetmetatable(''))
+for k, v in next, loaded do
+	modules[k] = v
+	record(v)
+end
+for k, v in next, registry do
+	if type(k) ~= 'number' then
+		regfields[k] = v
+		record(v)
+	end
+end
+return function()
+	for k in next, loaded do
+		if modules[k] == nil and resident[k] == nil then rawset(loaded, k, nil) end
+	end
+	for k, v in next, modules do rawset(loaded, k, v) end
+	for k, v in next, resident do rawset(loaded, k, v) end
+	for k in next, registry do
+		if type(k) ~= 'number' and regfields[k] == nil then rawset(registry, k, nil) end
+	end
+	for k, v in next, regfields do rawset(registry, k, v) end
+	for t, rec in next, tables do
+		local fields = rec.fields
+		for k in next, t do
+			if fields[k] == nil then rawset(t, k, nil) end
+		end
+		for k, v in next, fields do rawset(t, k, v) end
+		dsetmetatable(t, rec.meta)
+	end
+	for f, values in next, upvalues do
+		for i = 1, values.n do dsetupvalue(f, i, values[i]) end
+	end
+end
+)";
+} // namespace
+
+CLuaStatePool::~CLuaStatePool()
+{
+	Clear();
+}
+
+void CLuaStatePool::SetInitializer(const TLuaStateInit &init)
+{
+	std::lock_guard<std::mutex> l(m_mutex);
+	m_init = init;
+}
+
+void CLuaStatePool::SetResidentPath(const std::string &path)
+{
+	std::vector<_tLuaStateInfo *> idle;
+	{
+		std::lock_guard<std::mutex> l(m_mutex);
+		if (path == m_resident_path)
+			return;
+		m_resident_path = path;
+		m_generation++;
+		idle.swap(m_idle);
+	}
+	for (auto pInfo : idle)
+		CloseState(pInfo);
+}
+
+void *CLuaStatePool::LuaAlloc(void *ud, void *ptr, size_t osize, size_t nsize)
+{
+	if (nsize == 0)
+	{
+		free(ptr);
+		return nullptr;
+	}
+	// osize is the object type when ptr is null
+	size_t oldsize = (ptr != nullptr) ? osize : 0;
+	if (nsize > oldsize)
+		static_cast<_tLuaStateInfo *>(ud)->allocated += nsize - oldsize;
+	return realloc(ptr, nsize);
+}
+
+int CLuaStatePool::LuaPanic(lua_State *lua_state)
+{
+	const char *msg = lua_tostring(lua_state, -1);
+	_log.Log(LOG_ERROR, "EventSystem: Lua panic: %s", (msg != nullptr) ? msg : "unknown error");
+	return 0;
+}
+
+CLuaStatePool::_tLuaStateInfo *CLuaStatePool::GetStateInfo(lua_State *lua_state)
+{
+	void *ud = nullptr;
+	lua_getallocf(lua_state, &ud);
+	return static_cast<_tLuaStateInfo *>(ud);
+}
+
+CLuaStatePool::_tLuaStateInfo *CLuaStatePool::CreateState()
+{
+	TLuaStateInit init;
+	std::string residentPath;
+	auto pInfo = new _tLuaStateInfo;
+	{
+		std::lock_guard<std::mutex> l(m_mutex);
+		init = m_init;
+		residentPath = m_resident_path;
+		pInfo->generation = m_generation;
+		m_created++;
+	}
+
+	lua_State *lua_state = lua_newstate(LuaAlloc, pInfo);
+	if (lua_state == nullptr)
+	{
+		delete pInfo;
+		return nullptr;
+	}
+	lua_atpanic(lua_state, LuaPanic);
+	pInfo->lua_state = lua_state;
+
+	luaL_openlibs(lua_state);
+	if (init)
+		init(lua_state);
+	lua_settop(lua_state, 0);
+
+	int status = luaL_loadstring(lua_state, szLuaSandboxSnapshot);
+	if (status == 0)
+	{
+		lua_pushstring(lua_state, residentPath.c_str());
+		status = lua_pcall(lua_state, 1, 1, 0);
+	}
+	if ((status != 0) || (!lua_isfunction(lua_state, -1)))
+	{
+		const char *msg = lua_tostring(lua_state, -1);
+		_log.Log(LOG_ERROR, "EventSystem: Could not record the Lua sandbox: %s", (msg != nullptr) ? msg : "unknown error");
+		CloseState(pInfo);
+		return nullptr;
+	}
+	pInfo->resetRef = luaL_ref(lua_state, LUA_REGISTRYINDEX);
+	lua_gc(lua_state, LUA_GCCOLLECT, 0);
+	return pInfo;
+}
+
+void CLuaStatePool::CloseState(_tLuaStateInfo *pInfo)
+{
+	if (pInfo->lua_state != nullptr)
+		lua_close(pInfo->lua_state);
+	delete pInfo;
+}
+
+lua_State *CLuaStatePool::Acquire()
+{
+	{
+		std::lock_guard<std::mutex> l(m_mutex);
+		if (!m_idle.empty())
+		{
+			_tLuaStateInfo *pInfo = m_idle.back();
+			m_idle.pop_back();
+			m_reused++;
+			return pInfo->lua_state;
+		}
+	}
+	_tLuaStateInfo *pInfo = CreateState();
+	return (pInfo != nullptr) ? pInfo->lua_state : nullptr;
+}
+
+void CLuaStatePool::Release(lua_State *lua_state)
+{
+	if (lua_state == nullptr)
+		return;
+	_tLuaStateInfo *pInfo = GetStateInfo(lua_state);
+
+	lua_sethook(lua_state, nullptr, 0, 0);
+	lua_settop(lua_state, 0);
+	lua_rawgeti(lua_state, LUA_REGISTRYINDEX, pInfo->resetRef);
+	int status = lua_pcall(lua_state, 0, 0, 0);
+	if (status != 0)
+	{
+		const char *msg = lua_tostring(lua_state, -1);
+		_log.Log(LOG_ERROR, "EventSystem: Could not reset the Lua sandbox: %s", (msg != nullptr) ? msg : "unknown error");
+		CloseState(pInfo);
+		return;
+	}
+	lua_settop(lua_state, 0);
+	lua_gc(lua_state, LUA_GCCOLLECT, 0);
+
+	{
+		std::lock_guard<std::mutex> l(m_mutex);
+		if ((pInfo->generation == m_generation) && (m_idle.size() < LUASTATEPOOL_MAX_IDLE))
+		{
+			m_idle.push_back(pInfo);
+			return;
+		}
+	}
+	CloseState(pInfo);
+}
+
+void CLuaStatePool::Clear()
+{
+	std::vector<_tLuaStateInfo *> idle;
+	{
+		std::lock_guard<std::mutex> l(m_mutex);
+		m_generation++;
+		idle.swap(m_idle);
+	}
+	for (auto pInfo : idle)
+		CloseState(pInfo);
+}
+
+void CLuaStatePool::Prewarm()
+{
+	{
+		std::lock_guard<std::mutex> l(m_mutex);
+		if (!m_idle.empty())
+			return;
+	}
+	_tLuaStateInfo *pInfo = CreateState();
+	if (pInfo == nullptr)
+		return;
+	std::lock_guard<std::mutex> l(m_mutex);
+	if (pInfo->generation == m_generation)
+		m_idle.push_back(pInfo);
+	else
+		CloseState(pInfo);
+}
+
+int CLuaStatePool::LoadScript(lua_State *lua_state, const std::string &filename, const std::string &LuaString)
+{
+	_tLuaStateInfo *pInfo = GetStateInfo(lua_state);
+
+	time_t mtime = 0;
+	size_t hash = 0;
+	if (LuaString.empty())
+	{
+		struct stat st;
+		if (stat(filename.c_str(), &st) == 0)
+			mtime = st.st_mtime;
+	}
+	else
+		hash = std::hash<std::string>()(LuaString);
+
+	auto itt = pInfo->chunks.find(filename);
+	if (itt != pInfo->chunks.end())
+	{
+		if ((itt->second.mtime == mtime) && (itt->second.hash == hash))
+		{
+			lua_rawgeti(lua_state, LUA_REGISTRYINDEX, itt->second.ref);
+			return 0;
+		}
+		luaL_unref(lua_state, LUA_REGISTRYINDEX, itt->second.ref);
+		pInfo->chunks.erase(itt);
+	}
+
+	int status;
+	if (LuaString.empty())
+		status = luaL_loadfile(lua_state, filename.c_str());
+	else
+		status = luaL_loadstring(lua_state, LuaString.c_str());
+	if (status != 0)
+		return status;
+
+	if (pInfo->chunks.size() >= LUASTATEPOOL_MAX_CHUNKS)
+	{
+		for (const auto &chunk : pInfo->chunks)
+			luaL_unref(lua_state, LUA_REGISTRYINDEX, chunk.second.ref);
+		pInfo->chunks.clear();
+	}
+	// keep a reference, the chunk stays on the stack for the caller
+	lua_pushvalue(lua_state, -1);
+	_tLuaChunk chunk;
+	chunk.ref = luaL_ref(lua_state, LUA_REGISTRYINDEX);
+	chunk.mtime = mtime;
+	chunk.hash = hash;
+	pInfo->chunks[filename] = chunk;
+	return 0;
+}
+
+void CLuaStatePool::SetHostValue(lua_State *lua_state, const std::string &name)
+{
+	_tLuaStateInfo *pInfo = GetStateInfo(lua_state);
+	auto itt = pInfo->values.find(name);
+	if (itt != pInfo->values.end())
+	{
+		luaL_unref(lua_state, LUA_REGISTRYINDEX, itt->second);
+		pInfo->values.erase(itt);
+	}
+	if (lua_isnil(lua_state, -1))
+	{
+		lua_pop(lua_state, 1);
+		return;
+	}
+	pInfo->values[name] = luaL_ref(lua_state, LUA_REGISTRYINDEX);
+}
+
+void CLuaStatePool::PushHostValue(lua_State *lua_state, const std::string &name)
+{
+	_tLuaStateInfo *pInfo = GetStateInfo(lua_state);
+	auto itt = pInfo->values.find(name);
+	if (itt == pInfo->values.end())
+	{
+		lua_pushnil(lua_state);
+		return;
+	}
+	lua_rawgeti(lua_state, LUA_REGISTRYINDEX, itt->second);
+}
+
+uint64_t CLuaStatePool::GetAllocatedBytes(lua_State *lua_state)
+{
+	return GetStateInfo(lua_state)->allocated;
+}
+
+void CLuaStatePool::AddScriptStats(const std::string &name, const uint64_t us, const uint64_t bytes)
+{
+	std::lock_guard<std::mutex> l(m_stats_mutex);
+	auto itt = m_script_stats.find(name);
+	if (itt == m_script_stats.end())
+	{
+		_tLuaScriptStats stats = { name, 0, 0, 0, 0, 0 };
+		itt = m_script_stats.insert(std::make_pair(name, stats)).first;
+	}
+	_tLuaScriptStats &stats = itt->second;
+	stats.runs++;
+	stats.total_us += us;
+	stats.total_bytes += bytes;
+	if (us > stats.max_us)
+		stats.max_us = us;
+	if (bytes > stats.max_bytes)
+		stats.max_bytes = bytes;
+}
+
+std::vector<_tLuaScriptStats> CLuaStatePool::GetScriptStats()
+{
+	std::vector<_tLuaScriptStats> ret;
+	std::lock_guard<std::mutex> l(m_stats_mutex);
+	for (const auto &stats : m_script_stats)
+		ret.push_back(stats.second);
+	return ret;
+}
+
+_tLuaStatePoolStats CLuaStatePool::GetPoolStats()
+{
+	_tLuaStatePoolStats stats;
+	std::lock_guard<std::mutex> l(m_mutex);
+	stats.created = m_created;
+	stats.reused = m_reused;
+	stats.idle = m_idle.size();
+	return stats;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct lua_State;
+
+#define LUASTATEPOOL_MAX_IDLE 4
+#define LUASTATEPOOL_MAX_CHUNKS 256
+
+struct _tLuaScriptStats
+{
+	std::string name;
+	uint64_t runs;
+	uint64_t total_us;
+	uint64_t max_us;
+	uint64_t total_bytes;
+	uint64_t max_bytes;
+};
+
+struct _tLuaStatePoolStats
+{
+	uint64_t created;
+	uint64_t reused;
+	size_t idle;
+};
+
+//Pre-warmed Lua states for the event system.
+//A state is created once (libraries, C functions) and handed out again after its
+//globals, the tables and upvalues reachable from them, the registry and the loaded
+//modules were reset to what they were after the initializer ran, so every evaluation
+//starts from the same sandbox.
+//Modules loaded from the resident path (the dzVents runtime) stay loaded, their tables
+//and upvalues are reset to what they were right after the module was loaded.
+//Compiled script chunks and the host values are kept per state, under integer
+//registry references (luaL_ref) that the reset leaves alone.
+class CLuaStatePool
+{
+      public:
+	typedef std::function<void(lua_State *lua_state)> TLuaStateInit;
+
+	CLuaStatePool() = default;
+	~CLuaStatePool();
+
+	CLuaStatePool(const CLuaStatePool &) = delete;
+	CLuaStatePool &operator=(const CLuaStatePool &) = delete;
+
+	//Called once for every new state, before its sandbox is recorded
+	void SetInitializer(const TLuaStateInit &init);
+	//Lua modules loaded from files below this path are kept between evaluations
+	void SetResidentPath(const std::string &path);
+
+	lua_State *Acquire();
+	//Resets the sandbox and makes the state available again
+	void Release(lua_State *lua_state);
+	//Closes all idle states, states in use are closed when released
+	void Clear();
+	void Prewarm();
+
+	//Pushes the compiled chunk of a script file (LuaString empty) or string, returns the luaL_load* status
+	int LoadScript(lua_State *lua_state, const std::string &filename, const std::string &LuaString);
+
+	//Values the host keeps with a pooled state between evaluations, the sandbox reset does not touch them.
+	//Set pops the value from the stack (nil removes it), Push pushes it (or nil)
+	static void SetHostValue(lua_State *lua_state, const std::string &name);
+	static void PushHostValue(lua_State *lua_state, const std::string &name);
+
+	//Bytes allocated by the state since it was created
+	uint64_t GetAllocatedBytes(lua_State *lua_state);
+	void AddScriptStats(const std::string &name, uint64_t us, uint64_t bytes);
+	std::vector<_tLuaScriptStats> GetScriptStats();
+	_tLuaStatePoolStats GetPoolStats();
+
+      private:
+	struct _tLuaChunk
+	{
+		int ref;
+		time_t mtime;
+		size_t hash;
+	};
+	struct _tLuaStateInfo
+	{
+		lua_State *lua_state = nullptr;
+		uint64_t generation = 0;
+		int resetRef = -1;
+		std::atomic<uint64_t> allocated{ 0 };
+		std::map<std::string, _tLuaChunk> chunks;
+		std::map<std::string, int> values;
+	};
+
+	static void *LuaAlloc(void *ud, void *ptr, size_t osize, size_t nsize);
+	static int LuaPanic(lua_State *lua_state);
+	static _tLuaStateInfo *GetStateInfo(lua_State *lua_state);
+	_tLuaStateInfo *CreateState();
+	static void CloseState(_tLuaStateInfo *pInfo);
+
+	std::mutex m_mutex;
+	TLuaStateInit m_init;
+	std::string m_resident_path;
+	uint64_t m_generation = 0;
+	std::vector<_tLuaStateInfo *> m_idle;
+	uint64_t m_created = 0;
+	uint64_t m_reused = 0;
+
+	std::mutex m_stats_mutex;
+	std::map<std::string, _tLuaScriptStats> m_script_stats;
+};
@@ -177,7 +177,7 @@ void CLuaTable::PushRow(std::vector<_tEntry>::iterator itt)
 	lua_rawset(m_lua_state, -3);
 }
 
-void CLuaTable::Publish()
+bool CLuaTable::PushTable()
 {
 	if ((m_subtable_level == 0) && (!m_luatable.empty()))
 	{
@@ -207,11 +207,21 @@ void CLuaTable::Publish()
 				_log.Log(LOG_ERROR, "Unsupported label type in LuaTable!");
 			}
 		}
-		lua_setglobal(m_lua_state, m_name.c_str());
 		m_luatable.clear();
+		return true;
 	}
-	else
-		_log.Log(LOG_ERROR, "Lua table %s is not published. Not all sub tables are closed!", m_name.c_str());	
+	_log.Log(LOG_ERROR, "Lua table %s is not published. Not all sub tables are closed!", m_name.c_str());
+	return false;
 }
 
+void CLuaTable::Publish()
+{
+	if (PushTable())
+		lua_setglobal(m_lua_state, m_name.c_str());
+}
 
+void CLuaTable::Push()
+{
+	if (!PushTable())
+		lua_pushnil(m_lua_state);
+}
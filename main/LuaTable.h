@@ -8,6 +8,8 @@ class CLuaTable
 public:
 
 	void Publish();
+	// leaves the table on the stack instead of setting it as a global
+	void Push();
 	
 	// constructors
 	CLuaTable(lua_State *lua_state, const std::string &Name, int NrCols, int NrRows);
@@ -73,4 +75,5 @@ public:
 	int m_subtable_level;
 
 	void PushRow(std::vector<_tEntry>::iterator table_entry);
+	bool PushTable();
 };
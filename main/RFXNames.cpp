@@ -48,13 +48,148 @@ const char* findTableID1ID2(const _STR_TABLE_ID1_ID2* t, const unsigned long id1
 	return "Unknown";
 }
 
+//The tables below are searched through an index that is built at compile time,
+//a dense array from the id to the table position (for two ids: the table order sorted
+//on id1, id2, and the range of every id1). A table with a duplicate id does not compile.
+#define TABLE_NO_ENTRY 0xFFFF
+
+template <size_t N> struct _tTableIndex
+{
+	bool valid;
+	uint16_t str2_end; // position of the first entry without a second description
+	uint16_t pos[N];
+};
+
+template <size_t N, size_t S> struct _tTableID1ID2Index
+{
+	bool valid;
+	uint16_t first[N + 1]; // the entries of id1 are order[first[id1]] up to order[first[id1 + 1]]
+	uint16_t order[S];
+};
+
+template <size_t S> constexpr unsigned long TableMaxID(const STR_TABLE_SINGLE (&t)[S])
+{
+	unsigned long maxid = 0;
+	for (size_t ii = 0; ii < S - 1; ii++)
+	{
+		if (t[ii].id > maxid)
+			maxid = t[ii].id;
+	}
+	return maxid;
+}
+
+template <size_t S> constexpr unsigned long TableMaxID1(const STR_TABLE_ID1_ID2 (&t)[S])
+{
+	unsigned long maxid = 0;
+	for (size_t ii = 0; ii < S - 1; ii++)
+	{
+		if (t[ii].id1 > maxid)
+			maxid = t[ii].id1;
+	}
+	return maxid;
+}
+
+template <size_t N, size_t S> constexpr _tTableIndex<N> BuildTableIndex(const STR_TABLE_SINGLE (&t)[S])
+{
+	_tTableIndex<N> index{};
+	index.valid = (S < TABLE_NO_ENTRY) && (t[S - 1].str1 == nullptr);
+	index.str2_end = S - 1;
+	for (size_t ii = 0; ii < N; ii++)
+		index.pos[ii] = TABLE_NO_ENTRY;
+	for (size_t ii = 0; ii < S - 1; ii++)
+	{
+		if (t[ii].str1 == nullptr)
+			index.valid = false;
+		if ((t[ii].str2 == nullptr) && (index.str2_end == S - 1))
+			index.str2_end = uint16_t(ii);
+		if (index.pos[t[ii].id] != TABLE_NO_ENTRY)
+			index.valid = false;
+		index.pos[t[ii].id] = uint16_t(ii);
+	}
+	return index;
+}
+
+template <size_t N, size_t S> constexpr _tTableID1ID2Index<N, S> BuildTableIndex(const STR_TABLE_ID1_ID2 (&t)[S])
+{
+	_tTableID1ID2Index<N, S> index{};
+	index.valid = (S < TABLE_NO_ENTRY) && (t[S - 1].str1 == nullptr);
+	//count the entries of every id1, the ranges follow each other
+	for (size_t ii = 0; ii < S - 1; ii++)
+		index.first[t[ii].id1 + 1]++;
+	for (size_t ii = 0; ii < N; ii++)
+		index.first[ii + 1] += index.first[ii];
+	uint16_t next[N] = {};
+	for (size_t ii = 0; ii < S - 1; ii++)
+	{
+		if (t[ii].str1 == nullptr)
+			index.valid = false;
+		const unsigned long id1 = t[ii].id1;
+		index.order[index.first[id1] + next[id1]++] = uint16_t(ii);
+	}
+	index.order[S - 1] = uint16_t(S - 1);
+	//sort every range on id2
+	for (size_t id1 = 0; id1 < N; id1++)
+	{
+		for (size_t ii = index.first[id1] + 1; ii < index.first[id1 + 1]; ii++)
+		{
+			const uint16_t pos = index.order[ii];
+			size_t jj = ii;
+			while ((jj > index.first[id1]) && (t[index.order[jj - 1]].id2 > t[pos].id2))
+			{
+				index.order[jj] = index.order[jj - 1];
+				jj--;
+			}
+			index.order[jj] = pos;
+			if ((jj > index.first[id1]) && (t[index.order[jj - 1]].id2 == t[pos].id2))
+				index.valid = false;
+		}
+	}
+	return index;
+}
+
+template <size_t N> const char* findTableIDSingle1(const STR_TABLE_SINGLE* t, const _tTableIndex<N>& index, const unsigned long id)
+{
+	if ((id >= N) || (index.pos[id] == TABLE_NO_ENTRY))
+		return "Unknown";
+	return t[index.pos[id]].str1;
+}
+
+template <size_t N> const char* findTableIDSingle2(const STR_TABLE_SINGLE* t, const _tTableIndex<N>& index, const unsigned long id)
+{
+	if ((id >= N) || (index.pos[id] >= index.str2_end))
+		return "Unknown";
+	return t[index.pos[id]].str2;
+}
+
+template <size_t N, size_t S> const char* findTableID1ID2(const STR_TABLE_ID1_ID2* t, const _tTableID1ID2Index<N, S>& index, const unsigned long id1, const unsigned long id2)
+{
+	if (id1 >= N)
+		return "Unknown";
+	size_t lo = index.first[id1];
+	size_t hi = index.first[id1 + 1];
+	while (lo < hi)
+	{
+		const size_t mid = (lo + hi) / 2;
+		const STR_TABLE_ID1_ID2& entry = t[index.order[mid]];
+		if (entry.id2 == id2)
+			return entry.str1;
+		if (entry.id2 < id2)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return "Unknown";
+}
+
 const char* RFX_Humidity_Status_Desc(const unsigned char status)
 {
-	static const STR_TABLE_SINGLE Table[] = {
+	static constexpr STR_TABLE_SINGLE Table[] = {
 		{ humstat_normal, "Normal" }, { humstat_comfort, "Comfortable" }, { humstat_dry, "Dry" }, { humstat_wet, "Wet" },
 		{ 0, nullptr, nullptr },
 	};
-	return findTableIDSingle1(Table, status);
+	static constexpr auto Index = BuildTableIndex<TableMaxID(Table) + 1>(Table);
+	static_assert(Index.valid, "Duplicate id in description table");
+	return findTableIDSingle1(Table, Index, status);
 }
 
 unsigned char Get_Humidity_Level(const unsigned char hlevel)
@@ -70,7 +205,7 @@ unsigned char Get_Humidity_Level(const unsigned char hlevel)
 
 const char* Security_Status_Desc(const unsigned char status)
 {
-	static const STR_TABLE_SINGLE Table[] = {
+	static constexpr STR_TABLE_SINGLE Table[] = {
 		{ sStatusNormal, "Normal" },
 		{ sStatusNormalDelayed, "Normal Delayed" },
 		{ sStatusAlarm, "Alarm" },
@@ -100,12 +235,14 @@ const char* Security_Status_Desc(const unsigned char status)
 		{ sStatusNoMotionTamper, "No Motion + Tamper" },
 		{ 0, nullptr },
 	};
-	return findTableIDSingle1(Table, status);
+	static constexpr auto Index = BuildTableIndex<TableMaxID(Table) + 1>(Table);
+	static_assert(Index.valid, "Duplicate id in description table");
+	return findTableIDSingle1(Table, Index, status);
 }
 
 const char* Timer_Type_Desc(const int tType)
 {
-	static const STR_TABLE_SINGLE Table[] = {
+	static constexpr STR_TABLE_SINGLE Table[] = {
 		{ TTYPE_BEFORESUNRISE, "Before Sunrise" },
 		{ TTYPE_AFTERSUNRISE, "After Sunrise" },
 		{ TTYPE_ONTIME, "On Time" },
@@ -136,21 +273,25 @@ const char* Timer_Type_Desc(const int tType)
 		{ TTYPE_AFTERASTTWEND, "After Astronomical Twilight End" },
 		{ 0, nullptr, nullptr },
 	};
-	return findTableIDSingle1(Table, tType);
+	static constexpr auto Index = BuildTableIndex<TableMaxID(Table) + 1>(Table);
+	static_assert(Index.valid, "Duplicate id in description table");
+	return findTableIDSingle1(Table, Index, tType);
 }
 
 const char* Timer_Cmd_Desc(const int tType)
 {
-	static const STR_TABLE_SINGLE Table[] = {
+	static constexpr STR_TABLE_SINGLE Table[] = {
 		{ TCMD_ON, "On" },
 		{ TCMD_OFF, "Off" },
 		{ 0, nullptr, nullptr },
 	};
-	return findTableIDSingle1(Table, tType);
+	static constexpr auto Index = BuildTableIndex<TableMaxID(Table) + 1>(Table);
+	static_assert(Index.valid, "Duplicate id in description table");
+	return findTableIDSingle1(Table, Index, tType);
 }
 
 //ID, Long description, short description
-static const STR_TABLE_SINGLE HardwareTypeTable[] = {
+static constexpr STR_TABLE_SINGLE HardwareTypeTable[] = {
 	{ HTYPE_RFXtrx315, "RFXCOM - RFXtrx315 USB 315MHz Transceiver", "RFXCOM" },
 	{ HTYPE_RFXtrx433, "RFXCOM - RFXtrx433 USB 433.92MHz Transceiver", "RFXCOM" },
 	{ HTYPE_RFXLAN, "RFXCOM - RFXtrx shared over LAN interface", "RFXCOM" },
@@ -281,20 +422,22 @@ static const STR_TABLE_SINGLE HardwareTypeTable[] = {
 	{ HTYPE_RFLINKMQTT, "RFLink Gateway MQTT",	"RFLink" },
 	{ 0, nullptr, nullptr },
 };
+static constexpr auto HardwareTypeIndex = BuildTableIndex<TableMaxID(HardwareTypeTable) + 1>(HardwareTypeTable);
+static_assert(HardwareTypeIndex.valid, "Duplicate id in description table");
 
 const char* Hardware_Type_Desc(int hType)
 {
-	return findTableIDSingle1(HardwareTypeTable, hType);
+	return findTableIDSingle1(HardwareTypeTable, HardwareTypeIndex, hType);
 }
 
 const char* Hardware_Short_Desc(int hType)
 {
-	return findTableIDSingle2(HardwareTypeTable, hType);
+	return findTableIDSingle2(HardwareTypeTable, HardwareTypeIndex, hType);
 }
 
 const char* Switch_Type_Desc(const _eSwitchType sType)
 {
-	static const STR_TABLE_SINGLE Table[] = {
+	static constexpr STR_TABLE_SINGLE Table[] = {
 		{ STYPE_OnOff, "On/Off" },
 		{ STYPE_Doorbell, "Doorbell" },
 		{ STYPE_Contact, "Contact" },
@@ -317,12 +460,14 @@ const char* Switch_Type_Desc(const _eSwitchType sType)
 		{ STYPE_BlindsPercentageWithStop, "Blinds + Stop" },
 		{ 0, nullptr, nullptr },
 	};
-	return findTableIDSingle1(Table, sType);
+	static constexpr auto Index = BuildTableIndex<TableMaxID(Table) + 1>(Table);
+	static_assert(Index.valid, "Duplicate id in description table");
+	return findTableIDSingle1(Table, Index, sType);
 }
 
 const char* Meter_Type_Desc(const _eMeterType sType)
 {
-	static const STR_TABLE_SINGLE Table[] = {
+	static constexpr STR_TABLE_SINGLE Table[] = {
 		{ MTYPE_ENERGY, "Energy" },
 		{ MTYPE_GAS, "Gas" },
 		{ MTYPE_WATER, "Water" },
@@ -331,12 +476,14 @@ const char* Meter_Type_Desc(const _eMeterType sType)
 		{ MTYPE_TIME, "Time" },
 		{ 0, nullptr, nullptr },
 	};
-	return findTableIDSingle1(Table, sType);
+	static constexpr auto Index = BuildTableIndex<TableMaxID(Table) + 1>(Table);
+	static_assert(Index.valid, "Duplicate id in description table");
+	return findTableIDSingle1(Table, Index, sType);
 }
 
 const char* Notification_Type_Desc(const int nType, const unsigned char snum)
 {
-	static const STR_TABLE_SINGLE Table[] = {
+	static constexpr STR_TABLE_SINGLE Table[] = {
 		{ NTYPE_TEMPERATURE, "Temperature", "T" },
 		{ NTYPE_HUMIDITY, "Humidity", "H" },
 		{ NTYPE_RAIN, "Rain", "R" },
@@ -367,14 +514,16 @@ const char* Notification_Type_Desc(const int nType, const unsigned char snum)
 		{ NTYPE_LASTUPDATE, "Last Update", "J" },
 		{ 0, nullptr, nullptr },
 	};
+	static constexpr auto Index = BuildTableIndex<TableMaxID(Table) + 1>(Table);
+	static_assert(Index.valid, "Duplicate id in description table");
 	if (snum == 0)
-		return findTableIDSingle1(Table, nType);
-	return findTableIDSingle2(Table, nType);
+		return findTableIDSingle1(Table, Index, nType);
+	return findTableIDSingle2(Table, Index, nType);
 }
 
 const char* Notification_Type_Label(const int nType)
 {
-	static const STR_TABLE_SINGLE Table[] = {
+	static constexpr STR_TABLE_SINGLE Table[] = {
 		{ NTYPE_TEMPERATURE, "degrees" },
 		{ NTYPE_HUMIDITY, "%" },
 		{ NTYPE_RAIN, "mm" },
@@ -405,21 +554,25 @@ const char* Notification_Type_Label(const int nType)
 		{ NTYPE_LASTUPDATE, "minutes" },
 		{ 0, nullptr, nullptr },
 	};
-	return findTableIDSingle1(Table, nType);
+	static constexpr auto Index = BuildTableIndex<TableMaxID(Table) + 1>(Table);
+	static_assert(Index.valid, "Duplicate id in description table");
+	return findTableIDSingle1(Table, Index, nType);
 }
 
 const char* RFX_Forecast_Desc(const unsigned char Forecast)
 {
-	static const STR_TABLE_SINGLE Table[] = {
+	static constexpr STR_TABLE_SINGLE Table[] = {
 		{ baroForecastNoInfo, "No Info" }, { baroForecastSunny, "Sunny" }, { baroForecastPartlyCloudy, "Partly Cloudy" },
 		{ baroForecastCloudy, "Cloudy" },  { baroForecastRain, "Rain" },   { 0, nullptr, nullptr },
 	};
-	return findTableIDSingle1(Table, Forecast);
+	static constexpr auto Index = BuildTableIndex<TableMaxID(Table) + 1>(Table);
+	static_assert(Index.valid, "Duplicate id in description table");
+	return findTableIDSingle1(Table, Index, Forecast);
 }
 
 const char* RFX_WSForecast_Desc(const unsigned char Forecast)
 {
-	static const STR_TABLE_SINGLE Table[] = {
+	static constexpr STR_TABLE_SINGLE Table[] = {
 		{ wsbaroforecast_heavy_snow, "Heavy Snow" },
 		{ wsbaroforecast_snow, "Snow" },
 		{ wsbaroforecast_heavy_rain, "Heavy Rain" },
@@ -432,12 +585,14 @@ const char* RFX_WSForecast_Desc(const unsigned char Forecast)
 		{ wsbaroforecast_stable, "Stable" },
 		{ 0, nullptr, nullptr },
 	};
-	return findTableIDSingle1(Table, Forecast);
+	static constexpr auto Index = BuildTableIndex<TableMaxID(Table) + 1>(Table);
+	static_assert(Index.valid, "Duplicate id in description table");
+	return findTableIDSingle1(Table, Index, Forecast);
 }
 
 const char* BMP_Forecast_Desc(const unsigned char Forecast)
 {
-	static const STR_TABLE_SINGLE Table[] = {
+	static constexpr STR_TABLE_SINGLE Table[] = {
 		{ bmpbaroforecast_stable, "Stable" },
 		{ bmpbaroforecast_sunny, "Sunny" },
 		{ bmpbaroforecast_cloudy, "Cloudy" },
@@ -447,12 +602,14 @@ const char* BMP_Forecast_Desc(const unsigned char Forecast)
 		{ bmpbaroforecast_rain, "Cloudy/Rain" },
 		{ 0, nullptr, nullptr },
 	};
-	return findTableIDSingle1(Table, Forecast);
+	static constexpr auto Index = BuildTableIndex<TableMaxID(Table) + 1>(Table);
+	static_assert(Index.valid, "Duplicate id in description table");
+	return findTableIDSingle1(Table, Index, Forecast);
 }
 
 const char* RFX_Type_Desc(const unsigned char i, const unsigned char snum)
 {
-	static const STR_TABLE_SINGLE Table[] = {
+	static constexpr STR_TABLE_SINGLE Table[] = {
 		{ pTypeInterfaceControl, "Interface Control", "unknown" },
 		{ pTypeInterfaceMessage, "Interface Message", "unknown" },
 		{ pTypeRecXmitMessage, "Receiver/Transmitter Message", "unknown" },
@@ -545,15 +702,17 @@ const char* RFX_Type_Desc(const unsigned char i, const unsigned char snum)
 		{ pTypeHunter, "Hunter", "Hunter" },
 		{ 0, nullptr, nullptr },
 	};
+	static constexpr auto Index = BuildTableIndex<TableMaxID(Table) + 1>(Table);
+	static_assert(Index.valid, "Duplicate id in description table");
 	if (snum == 1)
-		return findTableIDSingle1(Table, i);
+		return findTableIDSingle1(Table, Index, i);
 
-	return findTableIDSingle2(Table, i);
+	return findTableIDSingle2(Table, Index, i);
 }
 
 const char* RFX_Type_SubType_Desc(const unsigned char dType, const unsigned char sType)
 {
-	static const STR_TABLE_ID1_ID2 Table[] = {
+	static constexpr STR_TABLE_ID1_ID2 Table[] = {
 		{ pTypeTEMP, sTypeTEMP1, "THR128/138, THC138" },
 		{ pTypeTEMP, sTypeTEMP2, "THC238/268, THN132, THWR288, THRN122, THN122, AW129/131" },
 		{ pTypeTEMP, sTypeTEMP3, "THWR800" },
@@ -968,27 +1127,33 @@ const char* RFX_Type_SubType_Desc(const unsigned char dType, const unsigned char
 		{ pTypeGeneralSwitch, sSwitchTypeV2Phoenix, "V2Phoenix" },
 		{ 0, 0, nullptr },
 	};
-	return findTableID1ID2(Table, dType, sType);
+	static constexpr auto Index = BuildTableIndex<TableMaxID1(Table) + 1>(Table);
+	static_assert(Index.valid, "Duplicate id in description table");
+	return findTableID1ID2(Table, Index, dType, sType);
 }
 
 const char* Media_Player_States(const _eMediaStatus Status)
 {
-	static const STR_TABLE_SINGLE Table[] = {
+	static constexpr STR_TABLE_SINGLE Table[] = {
 		{ MSTAT_OFF, "Off" },		{ MSTAT_ON, "On" },	      { MSTAT_PAUSED, "Paused" },
 		{ MSTAT_STOPPED, "Stopped" },	{ MSTAT_VIDEO, "Video" },     { MSTAT_AUDIO, "Audio" },
 		{ MSTAT_PHOTO, "Photo" },	{ MSTAT_PLAYING, "Playing" }, { MSTAT_DISCONNECTED, "Disconnected" },
 		{ MSTAT_SLEEPING, "Sleeping" }, { MSTAT_UNKNOWN, "Unknown" }, { 0, nullptr, nullptr },
 	};
-	return findTableIDSingle1(Table, Status);
+	static constexpr auto Index = BuildTableIndex<TableMaxID(Table) + 1>(Table);
+	static_assert(Index.valid, "Duplicate id in description table");
+	return findTableIDSingle1(Table, Index, Status);
 }
 
 const char* ZWave_Clock_Days(const unsigned char Day)
 {
-	static const STR_TABLE_SINGLE Table[] = {
+	static constexpr STR_TABLE_SINGLE Table[] = {
 		{ 0, "Monday" }, { 1, "Tuesday" },  { 2, "Wednesday" }, { 3, "Thursday" },
 		{ 4, "Friday" }, { 5, "Saturday" }, { 6, "Sunday" },	{ 0, nullptr, nullptr },
 	};
-	return findTableIDSingle1(Table, Day);
+	static constexpr auto Index = BuildTableIndex<TableMaxID(Table) + 1>(Table);
+	static_assert(Index.valid, "Duplicate id in description table");
+	return findTableIDSingle1(Table, Index, Day);
 }
 /*
 const char *ZWave_Thermostat_Modes[] =
@@ -40,7 +40,7 @@
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
 
-#define DB_VERSION 162
+#define DB_VERSION 163
 
 #define DEFAULT_ADMINUSER "admin"
 #define DEFAULT_ADMINPWD "domoticz"
@@ -492,6 +492,35 @@ constexpr auto sqlCreateFan_Calendar =
 "[Speed_Avg] INTEGER DEFAULT 0, "
 "[Date] DATE NOT NULL);";
 
+//Running day totals of the short log tables, maintained by triggers and used by the AddCalendar* functions
+constexpr auto sqlCreateShortLogRollup =
+"CREATE TABLE IF NOT EXISTS [ShortLogRollup] ("
+"[Source] VARCHAR(20) NOT NULL, "
+"[DeviceRowID] BIGINT(10) NOT NULL, "
+"[Date] DATE NOT NULL, "
+"[Dirty] INTEGER DEFAULT 0, "
+"[Count] INTEGER DEFAULT 0, "
+"[Min1] FLOAT, [Min2] FLOAT, [Min3] FLOAT, [Min4] FLOAT, [Min5] FLOAT, [Min6] FLOAT, "
+"[Max1] FLOAT, [Max2] FLOAT, [Max3] FLOAT, [Max4] FLOAT, [Max5] FLOAT, [Max6] FLOAT, "
+"[Sum1] FLOAT DEFAULT 0, [Sum2] FLOAT DEFAULT 0, [Sum3] FLOAT DEFAULT 0, [Sum4] FLOAT DEFAULT 0, [Sum5] FLOAT DEFAULT 0, [Sum6] FLOAT DEFAULT 0, "
+"[First1] FLOAT, "
+"[FirstDate] DATETIME, "
+"[Last1] FLOAT, "
+"[Last2] FLOAT, "
+"[LastDate] DATETIME);";
+
+//Short log tables and their value columns as accumulated in ShortLogRollup
+static const std::vector<std::pair<std::string, std::vector<std::string>>> ShortLogRollupTables = {
+	{ "Temperature", { "Temperature", "Chill", "Humidity", "Barometer", "DewPoint", "SetPoint" } },
+	{ "Rain", { "Total", "Rate" } },
+	{ "Wind", { "Direction", "Speed", "Gust" } },
+	{ "UV", { "Level" } },
+	{ "Meter", { "Value", "Usage" } },
+	{ "MultiMeter", { "Value1", "Value2", "Value3", "Value4", "Value5", "Value6" } },
+	{ "Percentage", { "Percentage" } },
+	{ "Fan", { "Speed" } },
+};
+
 constexpr auto sqlCreateBackupLog =
 "CREATE TABLE IF NOT EXISTS [BackupLog] ("
 "[Key] VARCHAR(50) NOT NULL, "
@@ -679,6 +708,45 @@ CSQLStatement::~CSQLStatement()
 	}
 }
 
+int CSQLRow::ColumnCount() const
+{
+	return sqlite3_column_count(m_Statement);
+}
+
+bool CSQLRow::IsNull(const int col) const
+{
+	return (sqlite3_column_type(m_Statement, col) == SQLITE_NULL);
+}
+
+int CSQLRow::GetInt(const int col) const
+{
+	return sqlite3_column_int(m_Statement, col);
+}
+
+int64_t CSQLRow::GetInt64(const int col) const
+{
+	return sqlite3_column_int64(m_Statement, col);
+}
+
+double CSQLRow::GetDouble(const int col) const
+{
+	return sqlite3_column_double(m_Statement, col);
+}
+
+const char *CSQLRow::GetText(const int col) const
+{
+	const char *value = (const char *)sqlite3_column_text(m_Statement, col);
+	return (value != nullptr) ? value : "";
+}
+
+std::string CSQLRow::GetString(const int col) const
+{
+	const char *value = (const char *)sqlite3_column_text(m_Statement, col);
+	if (value == nullptr)
+		return std::string();
+	return std::string(value, sqlite3_column_bytes(m_Statement, col));
+}
+
 CSQLHelper::CSQLHelper()
 {
 	m_LastSwitchRowID = 0;
@@ -700,6 +768,11 @@ CSQLHelper::CSQLHelper()
 	m_bShortLogAddOnlyNewValues = false;
 	m_bPreviousAcceptNewHardware = false;
 	m_bLogEventScriptTrigger = false;
+	m_nReadConnections = 2;
+	m_bDeviceStatusWriteBehind = false;
+	m_iWriteBehindIntervalMs = 0;
+	m_iWriteBehindMaxRows = 0;
+	m_device_index_generation = 0;
 
 	SetDatabaseName("domoticz.db");
 }
@@ -725,6 +798,7 @@ bool CSQLHelper::OpenDatabase()
 	sqlite3_exec(m_dbase, "PRAGMA synchronous = NORMAL", nullptr, nullptr, nullptr);
 	sqlite3_exec(m_dbase, "PRAGMA foreign_keys = ON", nullptr, nullptr, nullptr);
 	sqlite3_exec(m_dbase, "PRAGMA busy_timeout = 1000", nullptr, nullptr, nullptr);
+	sqlite3_update_hook(m_dbase, UpdateHook, this);
 
 	std::vector<std::vector<std::string> > result = query("SELECT name FROM sqlite_master WHERE type='table' AND name='DeviceStatus'");
 	bool bNewInstall = (result.empty());
@@ -737,6 +811,7 @@ bool CSQLHelper::OpenDatabase()
 			//User is using a newer database on a old Domoticz version
 			//This is very dangerous and should not be allowed
 			_log.Log(LOG_ERROR, "Database incompatible with this Domoticz version. (You cannot downgrade to an old Domoticz version!)");
+			ClearStatementCache();
 			sqlite3_close(m_dbase);
 			m_dbase = nullptr;
 			return false;
@@ -792,6 +867,8 @@ bool CSQLHelper::OpenDatabase()
 	query(sqlCreateFan);
 	query(sqlCreateFan_Calendar);
 	query(sqlCreateBackupLog);
+	query(sqlCreateShortLogRollup);
+	CreateShortLogRollupTriggers();
 	query(sqlCreateEnOceanNodes);
 	query(sqlCreatePushLink);
 	query(sqlCreateUserVariables);
@@ -843,6 +920,7 @@ bool CSQLHelper::OpenDatabase()
 	query("create index if not exists w_id_date_idx   on Wind(DeviceRowID, Date);");
 	query("create index if not exists wc_id_idx	   on Wind_Calendar(DeviceRowID);");
 	query("create index if not exists wc_id_date_idx  on Wind_Calendar(DeviceRowID, Date);");
+	query("create unique index if not exists slr_src_id_date_idx on ShortLogRollup(Source, DeviceRowID, Date);");
 	sqlite3_exec(m_dbase, "END TRANSACTION;", nullptr, nullptr, nullptr);
 
 	if ((!bNewInstall) && (dbversion < DB_VERSION))
@@ -3149,6 +3227,18 @@ bool CSQLHelper::OpenDatabase()
 				}
 			}
 		}
+		if (dbversion < 163)
+		{
+			//Rows logged before the rollup triggers existed are not accumulated,
+			//mark these days so they are aggregated from the short log tables
+			for (const auto& itt : ShortLogRollupTables)
+			{
+				safe_query(
+					"INSERT OR IGNORE INTO ShortLogRollup (Source, DeviceRowID, Date, Dirty) "
+					"SELECT DISTINCT '%q', DeviceRowID, date(Date), 1 FROM %s WHERE (Date >= date('now','localtime','-1 day'))",
+					itt.first.c_str(), itt.first.c_str());
+			}
+		}
 	}
 	else if (bNewInstall)
 	{
@@ -3626,6 +3716,11 @@ bool CSQLHelper::OpenDatabase()
 	//Update version in database
 	UpdatePreferencesVar("Domoticz_Version", szAppVersion);
 
+	//Load the preferences now, the upgrades above could have dropped them
+	GetPreferences();
+	ClearDeviceIndex();
+	OpenReadConnections();
+
 	//Start background thread
 	if (!StartThread())
 		return false;
@@ -3634,9 +3729,14 @@ bool CSQLHelper::OpenDatabase()
 
 void CSQLHelper::CloseDatabase()
 {
+	FlushDeviceStatusJournal();
+	ClearPreferences();
 	std::lock_guard<std::mutex> l(m_sqlQueryMutex);
 	if (m_dbase != nullptr)
 	{
+		CloseReadConnections();
+		ClearStatementCache();
+		ClearDeviceIndex();
 		OptimizeDatabase(m_dbase);
 		sqlite3_close(m_dbase);
 		m_dbase = nullptr;
@@ -3678,7 +3778,7 @@ bool CSQLHelper::SwitchLightFromTasker(uint64_t idx, const std::string& switchcm
 	std::vector<std::string> sd = result[0];
 	int HardwareID = atoi(sd[0].c_str());
 	_eSwitchType switchtype = (_eSwitchType)atoi(sd[5].c_str());
-	CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(HardwareID);
+	std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(HardwareID);
 	if (pHardware == nullptr)
 		return false;
 
@@ -4061,6 +4161,18 @@ void CSQLHelper::Do_Work()
 	{
 		std::vector<_tTaskItem> _items2do;
 
+		if (m_bDeviceStatusWriteBehind)
+		{
+			std::lock_guard<std::mutex> l(m_device_status_journal_mutex);
+			if (
+				(!m_device_status_journal.empty())
+				&& (std::chrono::steady_clock::now() - m_device_status_journal_start >= std::chrono::milliseconds(m_iWriteBehindIntervalMs))
+				)
+			{
+				FlushDeviceStatusJournalInt();
+			}
+		}
+
 		if (m_bAcceptHardwareTimerActive)
 		{
 			m_iAcceptHardwareTimerCounter -= static_cast<float>(1. / timer_resolution_hz);
@@ -4303,6 +4415,459 @@ void CSQLHelper::SetJournalMode(const std::string& mode)
 	m_journal_mode = mode;
 }
 
+void CSQLHelper::SetReadConnections(const int nConnections)
+{
+	m_nReadConnections = std::max(nConnections, 0);
+}
+
+void CSQLHelper::SetDeviceStatusWriteBehind(const int iIntervalMs, const int iMaxRows)
+{
+	m_iWriteBehindIntervalMs = std::max(iIntervalMs, 0);
+	m_iWriteBehindMaxRows = std::max(iMaxRows, 1);
+	m_bDeviceStatusWriteBehind = (m_iWriteBehindIntervalMs > 0);
+}
+
+void CSQLHelper::QueueDeviceStatusUpdate(const uint64_t ulID, const int signallevel, const int batterylevel, const int nValue, const char* sValue, const std::string& sLastUpdate)
+{
+	std::lock_guard<std::mutex> l(m_device_status_journal_mutex);
+	if (m_device_status_journal.empty())
+		m_device_status_journal_start = std::chrono::steady_clock::now();
+	_tDeviceStatusUpdate& item = m_device_status_journal[ulID];
+	item.signallevel = signallevel;
+	item.batterylevel = batterylevel;
+	item.nValue = nValue;
+	item.sValue = sValue;
+	item.sLastUpdate = sLastUpdate;
+	if (static_cast<int>(m_device_status_journal.size()) >= m_iWriteBehindMaxRows)
+		FlushDeviceStatusJournalInt();
+}
+
+bool CSQLHelper::GetPendingDeviceStatus(const uint64_t ulID, int& nValue, std::string& sValue, std::string& sLastUpdate)
+{
+	if (!m_bDeviceStatusWriteBehind)
+		return false;
+	std::lock_guard<std::mutex> l(m_device_status_journal_mutex);
+	auto itt = m_device_status_journal.find(ulID);
+	if (itt == m_device_status_journal.end())
+		return false;
+	nValue = itt->second.nValue;
+	sValue = itt->second.sValue;
+	sLastUpdate = itt->second.sLastUpdate;
+	return true;
+}
+
+bool CSQLHelper::GetPendingDeviceLastUpdate(const uint64_t ulID, std::string& sLastUpdate)
+{
+	if (!m_bDeviceStatusWriteBehind)
+		return false;
+	std::lock_guard<std::mutex> l(m_device_status_journal_mutex);
+	auto itt = m_device_status_journal.find(ulID);
+	if (itt == m_device_status_journal.end())
+		return false;
+	sLastUpdate = itt->second.sLastUpdate;
+	return true;
+}
+
+void CSQLHelper::FlushDeviceStatusJournal()
+{
+	if (!m_bDeviceStatusWriteBehind)
+		return;
+	std::lock_guard<std::mutex> l(m_device_status_journal_mutex);
+	FlushDeviceStatusJournalInt();
+}
+
+//Called by SQLite while a statement is prepared, for every column it reads or writes
+static int DeviceStatusJournalAuthorizer(void* pUser, const int iAction, const char* szTable, const char* szColumn, const char* /*szDatabase*/, const char* /*szTrigger*/)
+{
+	if (((iAction != SQLITE_READ) && (iAction != SQLITE_UPDATE)) || (szTable == nullptr) || (szColumn == nullptr))
+		return SQLITE_OK;
+	if (!boost::iequals(szTable, "DeviceStatus"))
+		return SQLITE_OK;
+	if (
+		(boost::iequals(szColumn, "nValue"))
+		|| (boost::iequals(szColumn, "sValue"))
+		|| (boost::iequals(szColumn, "LastUpdate"))
+		|| (boost::iequals(szColumn, "SignalLevel"))
+		|| (boost::iequals(szColumn, "BatteryLevel"))
+		)
+		*static_cast<bool*>(pUser) = true;
+	return SQLITE_OK;
+}
+
+//Prepares (but does not run) the statements of szSQL, SQLite reports the deferred DeviceStatus columns they use.
+//m_sqlQueryMutex has to be locked by the caller
+bool CSQLHelper::UsesDeviceStatusJournal(const char* szSQL)
+{
+	bool bUses = false;
+	sqlite3_set_authorizer(m_dbase, DeviceStatusJournalAuthorizer, &bUses);
+	const char* zSQL = szSQL;
+	while ((!bUses) && (zSQL != nullptr) && (*zSQL != 0))
+	{
+		sqlite3_stmt* pStatement = nullptr;
+		if (sqlite3_prepare_v2(m_dbase, zSQL, -1, &pStatement, &zSQL) != SQLITE_OK)
+			break; //the query itself reports the error
+		sqlite3_finalize(pStatement);
+	}
+	sqlite3_set_authorizer(m_dbase, nullptr, nullptr);
+	return bUses;
+}
+
+void CSQLHelper::FlushDeviceStatusJournalIfNeeded(const char* szQuery, const bool bPrepared)
+{
+	//Any statement that touches the deferred DeviceStatus columns has to see the pending values
+	if (!m_bDeviceStatusWriteBehind)
+		return;
+	{
+		std::lock_guard<std::mutex> l(m_device_status_journal_mutex);
+		if (m_device_status_journal.empty())
+			return;
+	}
+	bool bUses;
+	{
+		std::lock_guard<std::mutex> l(m_sqlQueryMutex);
+		if (bPrepared)
+		{
+			//prepared statements are checked once
+			auto itt = m_statement_uses_journal.find(szQuery);
+			if (itt == m_statement_uses_journal.end())
+				itt = m_statement_uses_journal.insert(std::make_pair(szQuery, UsesDeviceStatusJournal(szQuery))).first;
+			bUses = itt->second;
+		}
+		else
+			bUses = UsesDeviceStatusJournal(szQuery);
+	}
+	if (bUses)
+		FlushDeviceStatusJournal();
+}
+
+//m_device_status_journal_mutex has to be locked by the caller
+void CSQLHelper::FlushDeviceStatusJournalInt()
+{
+	if (m_device_status_journal.empty() || !m_dbase)
+		return;
+
+	constexpr auto szUpdateSQL = "UPDATE DeviceStatus SET SignalLevel=?, BatteryLevel=?, nValue=?, sValue=?, LastUpdate=? WHERE (ID = ?)";
+
+	std::unique_lock<std::mutex> l(m_sqlQueryMutex, std::defer_lock);
+	LockWriter(l);
+	sqlite3_stmt* pStatement = GetCachedStatement(szUpdateSQL);
+	if (pStatement == nullptr)
+		return;
+	_log.Debug(DEBUG_SQL, "Flushing %d DeviceStatus updates", static_cast<int>(m_device_status_journal.size()));
+	bool bOK = (sqlite3_exec(m_dbase, "BEGIN TRANSACTION", nullptr, nullptr, nullptr) == SQLITE_OK);
+	for (const auto& itt : m_device_status_journal)
+	{
+		if (!bOK)
+			break;
+		const _tDeviceStatusUpdate& item = itt.second;
+		BindParameters(pStatement, 1, item.signallevel, item.batterylevel, item.nValue, item.sValue, item.sLastUpdate, itt.first);
+		bOK = StepCachedStatement(pStatement, szUpdateSQL);
+	}
+	if (bOK)
+		bOK = (sqlite3_exec(m_dbase, "COMMIT TRANSACTION", nullptr, nullptr, nullptr) == SQLITE_OK);
+	if (bOK)
+		m_device_status_journal.clear();
+	else
+	{
+		//keep the pending values, they are written again after the next interval
+		_log.Log(LOG_ERROR, "SQLHelper: Could not write %d DeviceStatus updates: %s", static_cast<int>(m_device_status_journal.size()), sqlite3_errmsg(m_dbase));
+		sqlite3_exec(m_dbase, "ROLLBACK TRANSACTION", nullptr, nullptr, nullptr);
+		m_device_status_journal_start = std::chrono::steady_clock::now();
+	}
+
+	//the device index and the device list were updated when the values were queued
+	_tDataChanges changes;
+	TakeDataChanges(changes);
+	changes.DeviceIDs.clear();
+	l.unlock();
+	ApplyDataChanges(changes);
+}
+
+bool CSQLHelper::LookupDevice(const int HardwareID, const char* ID, const unsigned char unit, const unsigned char devType, const unsigned char subType, _tDeviceIndexItem& item)
+{
+	_tDeviceKey key{ HardwareID, ID, unit, devType, subType };
+	uint64_t generation;
+	{
+		std::lock_guard<std::mutex> l(m_device_index_mutex);
+		auto itt = m_device_index.find(key);
+		if (itt != m_device_index.end())
+		{
+			m_device_index_hits++;
+			item = itt->second;
+			return true;
+		}
+		generation = m_device_index_generation;
+	}
+	m_device_index_misses++;
+
+	bool bFound = false;
+	prepared_query(
+		"SELECT ID, Name, Used, SwitchType, Options, AddjValue, AddjMulti, AddjValue2, AddjMulti2, nValue, sValue, LastUpdate FROM DeviceStatus "
+		"WHERE (HardwareID=? AND DeviceID=? AND Unit=? AND Type=? AND SubType=?)",
+		[&](const CSQLRow& row) {
+			item.ID = static_cast<uint64_t>(row.GetInt64(0));
+			item.Name = row.GetText(1);
+			item.bUsed = (row.GetInt(2) != 0);
+			item.switchType = (_eSwitchType)row.GetInt(3);
+			item.Options = row.GetText(4);
+			item.AddjValue = static_cast<float>(row.GetDouble(5));
+			item.AddjMulti = static_cast<float>(row.GetDouble(6));
+			item.AddjValue2 = static_cast<float>(row.GetDouble(7));
+			item.AddjMulti2 = static_cast<float>(row.GetDouble(8));
+			item.nValue = row.GetInt(9);
+			item.sValue = row.GetText(10);
+			item.sLastUpdate = row.GetText(11);
+			bFound = true;
+			return false;
+		},
+		HardwareID, ID, unit, devType, subType);
+	if (!bFound)
+		return false;
+	GetPendingDeviceStatus(item.ID, item.nValue, item.sValue, item.sLastUpdate);
+
+	std::lock_guard<std::mutex> l(m_device_index_mutex);
+	//Only add it when nothing was changed in the meantime
+	if (generation == m_device_index_generation)
+	{
+		m_device_index[key] = item;
+		m_device_index_ids[item.ID] = key;
+	}
+	return true;
+}
+
+void CSQLHelper::UpdateDeviceIndexValue(const uint64_t ulID, const int nValue, const char* sValue, const std::string& sLastUpdate)
+{
+	NoteDeviceChanged(ulID);
+	std::lock_guard<std::mutex> l(m_device_index_mutex);
+	//A lookup that is still reading the old row must not add it anymore
+	m_device_index_generation++;
+	auto itt = m_device_index_ids.find(ulID);
+	if (itt == m_device_index_ids.end())
+		return;
+	auto itt2 = m_device_index.find(itt->second);
+	if (itt2 == m_device_index.end())
+		return;
+	itt2->second.nValue = nValue;
+	itt2->second.sValue = sValue;
+	itt2->second.sLastUpdate = sLastUpdate;
+}
+
+void CSQLHelper::InvalidateDeviceIndex(const uint64_t ulID)
+{
+	NoteDeviceChanged(ulID);
+	std::lock_guard<std::mutex> l(m_device_index_mutex);
+	m_device_index_generation++;
+	m_device_index_invalidations++;
+	auto itt = m_device_index_ids.find(ulID);
+	if (itt == m_device_index_ids.end())
+		return;
+	m_device_index.erase(itt->second);
+	m_device_index_ids.erase(itt);
+}
+
+void CSQLHelper::ClearDeviceIndex()
+{
+	NoteAllDevicesChanged();
+	std::lock_guard<std::mutex> l(m_device_index_mutex);
+	m_device_index_generation++;
+	m_device_index_invalidations++;
+	m_device_index.clear();
+	m_device_index_ids.clear();
+}
+
+void CSQLHelper::NoteDeviceChanged(const uint64_t ulID)
+{
+	std::lock_guard<std::mutex> l(m_device_changes_mutex);
+	m_device_changes[ulID] = ++m_device_changes_version;
+}
+
+void CSQLHelper::NoteAllDevicesChanged()
+{
+	std::lock_guard<std::mutex> l(m_device_changes_mutex);
+	m_device_changes_reset_version = ++m_device_changes_version;
+	m_device_changes.clear();
+}
+
+//Called by sqlite for every row that is inserted, updated or deleted on the writer connection, while the
+//statement is running. The changes are applied to the caches by ApplyDataChanges once it has finished
+void CSQLHelper::UpdateHook(void* pUser, const int iOperation, const char* /*szDatabase*/, const char* szTable, const long long iRowID)
+{
+	static const char* szDeviceListTables[] = {
+		"Scenes", "Hardware", "SharedDevices", "DeviceToPlansMap", "Plans", "LightSubDevices", "Users", "Timers", "Cameras", "CustomImages",
+	};
+	CSQLHelper* pHelper = static_cast<CSQLHelper*>(pUser);
+	std::lock_guard<std::mutex> l(pHelper->m_data_changes_mutex);
+	_tDataChanges& changes = pHelper->m_data_changes;
+	if (strcmp(szTable, "DeviceStatus") == 0)
+	{
+		//an INSERT OR REPLACE reports the row it replaced as inserted
+		changes.DeviceIDs.push_back(static_cast<uint64_t>(iRowID));
+		if (iOperation == SQLITE_INSERT)
+			changes.bNewDevices = true;
+	}
+	else if ((strcmp(szTable, "Meter") == 0) || (strcmp(szTable, "Rain") == 0) || (strcmp(szTable, "MultiMeter") == 0))
+		changes.bShortLog = true;
+	else if (strcmp(szTable, "Preferences") == 0)
+		changes.bPreferences = true;
+	else if (!changes.bDeviceList)
+	{
+		for (const auto szListTable : szDeviceListTables)
+		{
+			if (strcmp(szTable, szListTable) == 0)
+			{
+				changes.bDeviceList = true;
+				break;
+			}
+		}
+	}
+}
+
+void CSQLHelper::TakeDataChanges(_tDataChanges& changes)
+{
+	std::lock_guard<std::mutex> l(m_data_changes_mutex);
+	std::swap(changes, m_data_changes);
+}
+
+//Not to be called while holding m_sqlQueryMutex
+void CSQLHelper::ApplyDataChanges(const _tDataChanges& changes)
+{
+	for (const auto ulID : changes.DeviceIDs)
+		InvalidateDeviceIndex(ulID);
+	if (changes.bPreferences)
+		InvalidatePreferences();
+	if (changes.bShortLog)
+		ClearTodayCounters();
+	//the device list shows preferences and today's counters as well
+	if (changes.bNewDevices || changes.bDeviceList || changes.bShortLog || changes.bPreferences)
+		NoteAllDevicesChanged();
+}
+
+//Today's counter rows are added by WriteShortLog, which updates the counters itself, and
+//CleanupShortLog only deletes old rows. Any other change of these tables drops all counters
+void CSQLHelper::ClearTodayCounters()
+{
+	std::lock_guard<std::mutex> l(m_today_counters_mutex);
+	m_today_counters_generation++;
+	m_today_counters.clear();
+}
+
+//Called with m_today_counters_mutex held, the counters start over at midnight
+void CSQLHelper::CheckTodayCountersDate(const std::string& szDate)
+{
+	if (szDate == m_today_counters_date)
+		return;
+	m_today_counters_date = szDate;
+	m_today_counters_generation++;
+	m_today_counters.clear();
+}
+
+uint64_t CSQLHelper::GetDeviceListVersion()
+{
+	std::lock_guard<std::mutex> l(m_device_changes_mutex);
+	return m_device_changes_version;
+}
+
+bool CSQLHelper::GetChangedDevices(const uint64_t Version, std::vector<uint64_t>& ulIDs)
+{
+	std::lock_guard<std::mutex> l(m_device_changes_mutex);
+	if (m_device_changes_reset_version > Version)
+		return false;
+	for (const auto& itt : m_device_changes)
+	{
+		if (itt.second > Version)
+			ulIDs.push_back(itt.first);
+	}
+	return true;
+}
+
+_tDeviceIndexStats CSQLHelper::GetDeviceIndexStats()
+{
+	_tDeviceIndexStats stats;
+	stats.hits = m_device_index_hits;
+	stats.misses = m_device_index_misses;
+	stats.invalidations = m_device_index_invalidations;
+	std::lock_guard<std::mutex> l(m_device_index_mutex);
+	stats.size = m_device_index.size();
+	return stats;
+}
+
+void CSQLHelper::OpenReadConnections()
+{
+	//Concurrent readers next to a writer are only possible in WAL mode, and not for in-memory databases
+	if ((m_nReadConnections < 1) || (!boost::iequals(m_journal_mode, "WAL")) || (m_dbase_name == ":memory:"))
+		return;
+
+	//The pool is only created once, on a database restore the connections are reopened
+	if (m_read_connections.empty())
+	{
+		for (int ii = 0; ii < m_nReadConnections; ii++)
+			m_read_connections.push_back(std::make_unique<_tSQLReadConnection>());
+	}
+	int nOpened = 0;
+	for (auto& conn : m_read_connections)
+	{
+		std::lock_guard<std::mutex> l(conn->mutex);
+		if (conn->dbase != nullptr)
+			continue;
+		if (sqlite3_open_v2(m_dbase_name.c_str(), &conn->dbase, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK)
+		{
+			_log.Log(LOG_ERROR, "SQLHelper: Could not open read-only database connection: %s", sqlite3_errmsg(conn->dbase));
+			sqlite3_close(conn->dbase);
+			conn->dbase = nullptr;
+			continue;
+		}
+		sqlite3_exec(conn->dbase, "PRAGMA busy_timeout = 1000", nullptr, nullptr, nullptr);
+		nOpened++;
+	}
+	_log.Debug(DEBUG_SQL, "Opened %d read-only database connections", nOpened);
+}
+
+void CSQLHelper::CloseReadConnections()
+{
+	for (auto& conn : m_read_connections)
+	{
+		std::lock_guard<std::mutex> l(conn->mutex);
+		if (conn->dbase == nullptr)
+			continue;
+		sqlite3_close(conn->dbase);
+		conn->dbase = nullptr;
+	}
+}
+
+std::vector<_tSQLConnectionStats> CSQLHelper::GetConnectionStats()
+{
+	std::vector<_tSQLConnectionStats> ret;
+	_tSQLConnectionStats writer;
+	writer.name = "writer";
+	writer.queries = m_writer_queries;
+	writer.waits = m_writer_waits;
+	ret.push_back(writer);
+
+	int ii = 0;
+	for (auto& conn : m_read_connections)
+	{
+		_tSQLConnectionStats reader;
+		reader.name = "reader" + std::to_string(ii++);
+		{
+			std::lock_guard<std::mutex> l(conn->mutex);
+			reader.queries = conn->queries;
+		}
+		reader.waits = conn->waits;
+		ret.push_back(reader);
+	}
+	return ret;
+}
+
+void CSQLHelper::LockWriter(std::unique_lock<std::mutex>& lock)
+{
+	if (!lock.try_lock())
+	{
+		m_writer_waits++;
+		lock.lock();
+	}
+	m_writer_queries++;
+}
+
 bool CSQLHelper::DoesColumnExistsInTable(const std::string& columnname, const std::string& tablename)
 {
 	if (!m_dbase)
@@ -4322,6 +4887,8 @@ bool CSQLHelper::DoesColumnExistsInTable(const std::string& columnname, const st
 	return columnExists;
 }
 
+//Does not lock the database, the caller holds m_sqlQueryMutex and applies the data changes after releasing it.
+//The DeviceStatus journal is not flushed here, as that needs the lock
 void CSQLHelper::safe_exec_no_return(const char* fmt, ...)
 {
 	if (!m_dbase)
@@ -4380,7 +4947,14 @@ int CSQLHelper::execute_sql(const std::string &sSQL, std::vector<std::string> *p
 
 	if (!sqlStatement.Error())
 	{
-		sqlStatement.Execute();
+		_tDataChanges changes;
+		{
+			std::unique_lock<std::mutex> l(m_sqlQueryMutex, std::defer_lock);
+			LockWriter(l);
+			sqlStatement.Execute();
+			TakeDataChanges(changes);
+		}
+		ApplyDataChanges(changes);
 	}
 
 	if (!sqlStatement.Error())
@@ -4439,12 +5013,67 @@ std::vector<std::vector<std::string> > CSQLHelper::query(const std::string& szQu
 		std::vector<std::vector<std::string> > results;
 		return results;
 	}
-	std::lock_guard<std::mutex> l(m_sqlQueryMutex);
+	FlushDeviceStatusJournalIfNeeded(szQuery.c_str(), false);
+
+	std::unique_lock<std::mutex> l(m_sqlQueryMutex, std::defer_lock);
+	LockWriter(l);
 
-	sqlite3_stmt* statement;
 	std::vector<std::vector<std::string> > results;
-    _log.Debug(DEBUG_SQL, "Query:%s", szQuery.c_str());
-	if (sqlite3_prepare_v2(m_dbase, szQuery.c_str(), -1, &statement, nullptr) == SQLITE_OK)
+	fetch_rows(m_dbase, szQuery, results);
+	_tDataChanges changes;
+	TakeDataChanges(changes);
+	l.unlock();
+	ApplyDataChanges(changes);
+	return results;
+}
+
+std::vector<std::vector<std::string> > CSQLHelper::query_readonly(const std::string& szQuery)
+{
+	size_t nConnections = m_read_connections.size();
+	if (nConnections == 0)
+		return query(szQuery);
+
+	FlushDeviceStatusJournalIfNeeded(szQuery.c_str(), false);
+
+	//Round robin over the pool, prefer a connection that is not in use
+	size_t iStart = m_next_read_connection++;
+	_tSQLReadConnection* pConn = nullptr;
+	std::unique_lock<std::mutex> l;
+	for (size_t ii = 0; ii < nConnections; ii++)
+	{
+		_tSQLReadConnection* pTry = m_read_connections[(iStart + ii) % nConnections].get();
+		std::unique_lock<std::mutex> tl(pTry->mutex, std::try_to_lock);
+		if (tl.owns_lock())
+		{
+			pConn = pTry;
+			l = std::move(tl);
+			break;
+		}
+	}
+	if (pConn == nullptr)
+	{
+		pConn = m_read_connections[iStart % nConnections].get();
+		pConn->waits++;
+		l = std::unique_lock<std::mutex>(pConn->mutex);
+	}
+	if (pConn->dbase == nullptr)
+	{
+		//pool not (yet) open, use the writer connection
+		l.unlock();
+		return query(szQuery);
+	}
+	pConn->queries++;
+
+	std::vector<std::vector<std::string> > results;
+	fetch_rows(pConn->dbase, szQuery, results);
+	return results;
+}
+
+void CSQLHelper::fetch_rows(sqlite3* dbase, const std::string& szQuery, std::vector<std::vector<std::string>>& results)
+{
+	sqlite3_stmt* statement;
+	_log.Debug(DEBUG_SQL, "Query:%s", szQuery.c_str());
+	if (sqlite3_prepare_v2(dbase, szQuery.c_str(), -1, &statement, nullptr) == SQLITE_OK)
 	{
 		int cols = sqlite3_column_count(statement);
 		while (true)
@@ -4474,51 +5103,181 @@ std::vector<std::vector<std::string> > CSQLHelper::query(const std::string& szQu
 		sqlite3_finalize(statement);
 	}
 
-	std::string error = sqlite3_errmsg(m_dbase);
+	std::string error = sqlite3_errmsg(dbase);
 	if (error != "not an error")
 		_log.Log(LOG_ERROR, "SQL Query(\"%s\") : %s", szQuery.c_str(), error.c_str());
-	return results;
 }
 
-std::vector<std::vector<std::string> > CSQLHelper::safe_queryBlob(const char* fmt, ...)
+std::vector<std::vector<std::string> > CSQLHelper::safe_query_readonly(const char* fmt, ...)
 {
-	va_list args;
 	std::vector<std::vector<std::string> > results;
+	va_list args;
 	va_start(args, fmt);
 	char* zQuery = sqlite3_vmprintf(fmt, args);
 	va_end(args);
 	if (!zQuery)
 	{
 		_log.Log(LOG_ERROR, "SQL: Out of memory, or invalid printf!....");
-		std::vector<std::vector<std::string> > results;
 		return results;
 	}
-	results = queryBlob(zQuery);
+	results = query_readonly(zQuery);
 	sqlite3_free(zQuery);
 	return results;
 }
 
-std::vector<std::vector<std::string> > CSQLHelper::queryBlob(const std::string& szQuery)
+sqlite3_stmt* CSQLHelper::GetCachedStatement(const char* szSQL)
 {
-	if (!m_dbase)
+	auto itt = m_statement_cache.find(szSQL);
+	if (itt != m_statement_cache.end())
+		return itt->second;
+
+	sqlite3_stmt* statement = nullptr;
+	if (sqlite3_prepare_v3(m_dbase, szSQL, -1, SQLITE_PREPARE_PERSISTENT, &statement, nullptr) != SQLITE_OK)
 	{
-		_log.Log(LOG_ERROR, "Database not open!!...Check your user rights!..");
-		std::vector<std::vector<std::string> > results;
-		return results;
+		_log.Log(LOG_ERROR, "SQL Prepare(\"%s\") : %s", szSQL, sqlite3_errmsg(m_dbase));
+		return nullptr;
 	}
-	std::lock_guard<std::mutex> l(m_sqlQueryMutex);
+	m_statement_cache[szSQL] = statement;
+	return statement;
+}
 
-	sqlite3_stmt* statement;
-	std::vector<std::vector<std::string> > results;
+sqlite3_stmt* CSQLHelper::TakeCachedStatement(const char* szSQL)
+{
+	auto itt = m_statement_cache.find(szSQL);
+	if (itt != m_statement_cache.end())
+	{
+		sqlite3_stmt* statement = itt->second;
+		m_statement_cache.erase(itt);
+		return statement;
+	}
 
-	if (sqlite3_prepare_v2(m_dbase, szQuery.c_str(), -1, &statement, nullptr) == SQLITE_OK)
+	sqlite3_stmt* statement = nullptr;
+	if (sqlite3_prepare_v3(m_dbase, szSQL, -1, SQLITE_PREPARE_PERSISTENT, &statement, nullptr) != SQLITE_OK)
 	{
-		int cols = sqlite3_column_count(statement);
-		while (true)
-		{
-			int result = sqlite3_step(statement);
-			if (result == SQLITE_ROW)
-			{
+		_log.Log(LOG_ERROR, "SQL Prepare(\"%s\") : %s", szSQL, sqlite3_errmsg(m_dbase));
+		return nullptr;
+	}
+	return statement;
+}
+
+void CSQLHelper::ReturnCachedStatement(sqlite3_stmt* pStatement, const char* szSQL)
+{
+	//the database could have been reopened, or the same query was cached by someone else meanwhile
+	if ((sqlite3_db_handle(pStatement) != m_dbase) || (!m_statement_cache.insert(std::make_pair(szSQL, pStatement)).second))
+		sqlite3_finalize(pStatement);
+}
+
+//m_sqlQueryMutex has to be locked by the caller (through pLock when there is a callback)
+//The callback runs without the lock, so it may issue SQL itself. A taken statement is not
+//used by others meanwhile, and the columns are read directly from it.
+bool CSQLHelper::StepCachedStatement(sqlite3_stmt* pStatement, const char* szSQL, const TSqlRowCallback& callback, std::unique_lock<std::mutex>* pLock)
+{
+	_log.Debug(DEBUG_SQL, "Prepared Query:%s", szSQL);
+	const CSQLRow row(pStatement);
+	int result;
+	while ((result = sqlite3_step(pStatement)) == SQLITE_ROW)
+	{
+		if (!callback)
+			continue;
+		pLock->unlock();
+		const bool bContinue = callback(row);
+		pLock->lock();
+		if (!bContinue)
+		{
+			result = SQLITE_DONE;
+			break;
+		}
+	}
+	if (result != SQLITE_DONE)
+		_log.Log(LOG_ERROR, "SQL Query(\"%s\") : %s", szSQL, sqlite3_errmsg(m_dbase));
+	sqlite3_reset(pStatement);
+	sqlite3_clear_bindings(pStatement);
+	return (result == SQLITE_DONE);
+}
+
+void CSQLHelper::ClearStatementCache()
+{
+	for (auto& itt : m_statement_cache)
+		sqlite3_finalize(itt.second);
+	m_statement_cache.clear();
+	m_statement_uses_journal.clear();
+}
+
+void CSQLHelper::BindParameter(sqlite3_stmt* pStatement, const int iParam, const int value)
+{
+	sqlite3_bind_int(pStatement, iParam, value);
+}
+
+void CSQLHelper::BindParameter(sqlite3_stmt* pStatement, const int iParam, const int64_t value)
+{
+	sqlite3_bind_int64(pStatement, iParam, value);
+}
+
+void CSQLHelper::BindParameter(sqlite3_stmt* pStatement, const int iParam, const uint64_t value)
+{
+	sqlite3_bind_int64(pStatement, iParam, static_cast<sqlite3_int64>(value));
+}
+
+void CSQLHelper::BindParameter(sqlite3_stmt* pStatement, const int iParam, const double value)
+{
+	sqlite3_bind_double(pStatement, iParam, value);
+}
+
+void CSQLHelper::BindParameter(sqlite3_stmt* pStatement, const int iParam, const char* value)
+{
+	if (value == nullptr)
+		sqlite3_bind_null(pStatement, iParam);
+	else
+		sqlite3_bind_text(pStatement, iParam, value, -1, SQLITE_TRANSIENT);
+}
+
+void CSQLHelper::BindParameter(sqlite3_stmt* pStatement, const int iParam, const std::string& value)
+{
+	sqlite3_bind_text(pStatement, iParam, value.c_str(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
+}
+
+std::vector<std::vector<std::string> > CSQLHelper::safe_queryBlob(const char* fmt, ...)
+{
+	va_list args;
+	std::vector<std::vector<std::string> > results;
+	va_start(args, fmt);
+	char* zQuery = sqlite3_vmprintf(fmt, args);
+	va_end(args);
+	if (!zQuery)
+	{
+		_log.Log(LOG_ERROR, "SQL: Out of memory, or invalid printf!....");
+		std::vector<std::vector<std::string> > results;
+		return results;
+	}
+	results = queryBlob(zQuery);
+	sqlite3_free(zQuery);
+	return results;
+}
+
+std::vector<std::vector<std::string> > CSQLHelper::queryBlob(const std::string& szQuery)
+{
+	if (!m_dbase)
+	{
+		_log.Log(LOG_ERROR, "Database not open!!...Check your user rights!..");
+		std::vector<std::vector<std::string> > results;
+		return results;
+	}
+	FlushDeviceStatusJournalIfNeeded(szQuery.c_str(), false);
+
+	std::unique_lock<std::mutex> l(m_sqlQueryMutex, std::defer_lock);
+	LockWriter(l);
+
+	sqlite3_stmt* statement;
+	std::vector<std::vector<std::string> > results;
+
+	if (sqlite3_prepare_v2(m_dbase, szQuery.c_str(), -1, &statement, nullptr) == SQLITE_OK)
+	{
+		int cols = sqlite3_column_count(statement);
+		while (true)
+		{
+			int result = sqlite3_step(statement);
+			if (result == SQLITE_ROW)
+			{
 				std::vector<std::string> values;
 				for (int col = 0; col < cols; col++)
 				{
@@ -5100,12 +5859,11 @@ uint64_t CSQLHelper::InsertDevice(const int HardwareID, const char* ID, const un
 }
 
 uint64_t CSQLHelper::GetDeviceIndex(const int HardwareID, const std::string& ID, const unsigned char unit, const unsigned char devType, const unsigned char subType, std::string& devname) {
-	std::vector<std::vector<std::string> > result;
-	result = safe_query("SELECT ID, Name FROM DeviceStatus WHERE (HardwareID=%d AND DeviceID='%q' AND Unit=%d AND Type=%d AND SubType=%d)", HardwareID, ID.c_str(), unit, devType, subType);
-	if (result.empty())
+	_tDeviceIndexItem device;
+	if (!LookupDevice(HardwareID, ID.c_str(), unit, devType, subType, device))
 		return -1;
-	devname = result[0].at(1);
-	return std::stoull(result[0].at(0));
+	devname = device.Name;
+	return device.ID;
 }
 
 uint64_t CSQLHelper::UpdateValueInt(
@@ -5126,8 +5884,22 @@ uint64_t CSQLHelper::UpdateValueInt(
 	_eSwitchType stype = STYPE_OnOff;
 
 	std::vector<std::vector<std::string> > result;
-	result = safe_query("SELECT ID, Name, Used, SwitchType, nValue, sValue, LastUpdate, Options FROM DeviceStatus WHERE (HardwareID=%d AND DeviceID='%q' AND Unit=%d AND Type=%d AND SubType=%d)", HardwareID, ID, unit, devType, subType);
-	if (result.empty())
+	std::string sLastUpdateBeforeUpdate;
+	std::string sOption;
+	_tDeviceIndexItem device;
+	bool bDeviceFound = LookupDevice(HardwareID, ID, unit, devType, subType, device);
+	if (bDeviceFound)
+	{
+		ulID = device.ID;
+		devname = device.Name;
+		bDeviceUsed = device.bUsed;
+		stype = device.switchType;
+		nValueBeforeUpdate = device.nValue;
+		sValueBeforeUpdate = device.sValue;
+		sLastUpdateBeforeUpdate = device.sLastUpdate;
+		sOption = device.Options;
+	}
+	if (!bDeviceFound)
 	{
 		//Insert
 		ulID = InsertDevice(HardwareID, ID, unit, devType, subType, 0, nValue, sValue, devname, signallevel, batterylevel);
@@ -5139,11 +5911,11 @@ uint64_t CSQLHelper::UpdateValueInt(
 
 #ifdef ENABLE_PYTHON
 		//TODO: Plugins should perhaps be blocked from implicitly adding a device by update? It's most likely a bug due to updating a removed device..
-		CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(HardwareID);
+		std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(HardwareID);
 		if (pHardware != nullptr && pHardware->HwdType == HTYPE_PythonPlugin)
 		{
 			_log.Debug(DEBUG_NORM, "CSQLHelper::UpdateValueInt: Notifying plugin %u about creation of device %u", HardwareID, unit);
-			Plugins::CPlugin* pPlugin = (Plugins::CPlugin*)pHardware;
+			Plugins::CPlugin* pPlugin = (Plugins::CPlugin*)pHardware.get();
 			pPlugin->DeviceAdded(ID, unit);
 		}
 #endif
@@ -5151,14 +5923,7 @@ uint64_t CSQLHelper::UpdateValueInt(
 	else
 	{
 		//Update
-		ulID = std::stoull(result[0][0]);
-		std::string sOption = result[0][7];
 		auto options = BuildDeviceOptions(sOption);
-		devname = result[0][1];
-		bDeviceUsed = atoi(result[0][2].c_str()) != 0;
-		stype = (_eSwitchType)atoi(result[0][3].c_str());
-		nValueBeforeUpdate = atoi(result[0][4].c_str());
-		sValueBeforeUpdate = result[0][5];
 
 		std::string sLastUpdate = TimeToString(nullptr, TF_DateTime);
 
@@ -5168,7 +5933,7 @@ uint64_t CSQLHelper::UpdateValueInt(
 		{
             double intervalSeconds;
             struct tm ntime;
-			std::string sLastUpdate = result[0][6];
+			std::string sLastUpdate = sLastUpdateBeforeUpdate;
 
 			time_t now = time(nullptr);
 			struct tm ltime;
@@ -5209,12 +5974,12 @@ uint64_t CSQLHelper::UpdateValueInt(
 		//~ use different update queries based on the device type
 		if (devType == pTypeGeneral && subType == sTypeCounterIncremental)
 		{
-			result = safe_query(
-				"UPDATE DeviceStatus SET SignalLevel=%d, BatteryLevel=%d, nValue= nValue + %d, sValue= sValue + '%q', LastUpdate='%q' "
-				"WHERE (ID = %" PRIu64 ")",
+			prepared_exec(
+				"UPDATE DeviceStatus SET SignalLevel=?, BatteryLevel=?, nValue= nValue + ?, sValue= sValue + ?, LastUpdate=? "
+				"WHERE (ID = ?)",
 				signallevel, batterylevel,
 				nValue, sValue,
-				sLastUpdate.c_str(),
+				sLastUpdate,
 				ulID);
 		}
 		else
@@ -5315,13 +6080,26 @@ uint64_t CSQLHelper::UpdateValueInt(
 				}
 			}
 
-			result = safe_query(
-				"UPDATE DeviceStatus SET SignalLevel=%d, BatteryLevel=%d, nValue=%d, sValue='%q', LastUpdate='%q' "
-				"WHERE (ID = %" PRIu64 ")",
-				signallevel, batterylevel,
-				nValue, sValue,
-				sLastUpdate.c_str(),
-				ulID);
+			if (m_bDeviceStatusWriteBehind)
+			{
+				QueueDeviceStatusUpdate(ulID, signallevel, batterylevel, nValue, sValue, sLastUpdate);
+			}
+			else
+			{
+				_tDataChanges changes;
+				prepared_query_int(changes,
+					"UPDATE DeviceStatus SET SignalLevel=?, BatteryLevel=?, nValue=?, sValue=?, LastUpdate=? "
+					"WHERE (ID = ?)",
+					nullptr,
+					signallevel, batterylevel,
+					nValue, sValue,
+					sLastUpdate,
+					ulID);
+				//the index entry is updated below instead of being dropped
+				changes.DeviceIDs.erase(std::remove(changes.DeviceIDs.begin(), changes.DeviceIDs.end(), ulID), changes.DeviceIDs.end());
+				ApplyDataChanges(changes);
+			}
+			UpdateDeviceIndexValue(ulID, nValue, sValue, sLastUpdate);
 		}
 	}
 
@@ -5411,7 +6189,7 @@ uint64_t CSQLHelper::UpdateValueInt(
 			std::string slevel = sd[6];
 
 			_eHardwareTypes HWtype = HTYPE_Domoticz; //just a value
-			CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(HardwareID);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(HardwareID);
 			if (pHardware != nullptr)
 				HWtype = pHardware->HwdType;
 
@@ -5645,55 +6423,37 @@ uint64_t CSQLHelper::UpdateValueInt(
 
 bool CSQLHelper::GetLastValue(const int HardwareID, const char* DeviceID, const unsigned char unit, const unsigned char devType, const unsigned char subType, int& nValue, std::string& sValue, struct tm& LastUpdateTime)
 {
-	bool result = false;
-	std::vector<std::vector<std::string> > sqlresult;
-	std::string sLastUpdate;
-	//std::string sValue;
-	//struct tm LastUpdateTime;
-	sqlresult = safe_query(
-		"SELECT nValue,sValue,LastUpdate FROM DeviceStatus WHERE (HardwareID=%d AND DeviceID='%q' AND Unit=%d AND Type=%d AND SubType=%d) order by LastUpdate desc limit 1",
-		HardwareID, DeviceID, unit, devType, subType);
-
-	if (!sqlresult.empty())
-	{
-		nValue = (int)atoi(sqlresult[0][0].c_str());
-		sValue = sqlresult[0][1];
-		sLastUpdate = sqlresult[0][2];
-
-		time_t lutime;
-		ParseSQLdatetime(lutime, LastUpdateTime, sLastUpdate);
+	_tDeviceIndexItem device;
+	if (!LookupDevice(HardwareID, DeviceID, unit, devType, subType, device))
+		return false;
 
-		result = true;
-	}
+	nValue = device.nValue;
+	sValue = device.sValue;
 
-	return result;
+	time_t lutime;
+	ParseSQLdatetime(lutime, LastUpdateTime, device.sLastUpdate);
+	return true;
 }
 
 void CSQLHelper::GetAddjustment(const int HardwareID, const char* ID, const unsigned char unit, const unsigned char devType, const unsigned char subType, float& AddjValue, float& AddjMulti)
 {
 	AddjValue = 0.0F;
 	AddjMulti = 1.0F;
-	std::vector<std::vector<std::string> > result;
-	result = safe_query(
-		"SELECT AddjValue,AddjMulti FROM DeviceStatus WHERE (HardwareID=%d AND DeviceID='%q' AND Unit=%d AND Type=%d AND SubType=%d)",
-		HardwareID, ID, unit, devType, subType);
-	if (!result.empty())
+	_tDeviceIndexItem device;
+	if (LookupDevice(HardwareID, ID, unit, devType, subType, device))
 	{
-		AddjValue = static_cast<float>(atof(result[0][0].c_str()));
-		AddjMulti = static_cast<float>(atof(result[0][1].c_str()));
+		AddjValue = device.AddjValue;
+		AddjMulti = device.AddjMulti;
 	}
 }
 
 void CSQLHelper::GetMeterType(const int HardwareID, const char* ID, const unsigned char unit, const unsigned char devType, const unsigned char subType, int& meterType)
 {
 	meterType = 0;
-	std::vector<std::vector<std::string> > result;
-	result = safe_query(
-		"SELECT SwitchType FROM DeviceStatus WHERE (HardwareID=%d AND DeviceID='%q' AND Unit=%d AND Type=%d AND SubType=%d)",
-		HardwareID, ID, unit, devType, subType);
-	if (!result.empty())
+	_tDeviceIndexItem device;
+	if (LookupDevice(HardwareID, ID, unit, devType, subType, device))
 	{
-		meterType = atoi(result[0][0].c_str());
+		meterType = device.switchType;
 	}
 }
 
@@ -5701,14 +6461,11 @@ void CSQLHelper::GetAddjustment2(const int HardwareID, const char* ID, const uns
 {
 	AddjValue = 0.0F;
 	AddjMulti = 1.0F;
-	std::vector<std::vector<std::string> > result;
-	result = safe_query(
-		"SELECT AddjValue2,AddjMulti2 FROM DeviceStatus WHERE (HardwareID=%d AND DeviceID='%q' AND Unit=%d AND Type=%d AND SubType=%d)",
-		HardwareID, ID, unit, devType, subType);
-	if (!result.empty())
+	_tDeviceIndexItem device;
+	if (LookupDevice(HardwareID, ID, unit, devType, subType, device))
 	{
-		AddjValue = static_cast<float>(atof(result[0][0].c_str()));
-		AddjMulti = static_cast<float>(atof(result[0][1].c_str()));
+		AddjValue = device.AddjValue2;
+		AddjMulti = device.AddjMulti2;
 	}
 }
 
@@ -5729,24 +6486,70 @@ void CSQLHelper::UpdatePreferencesVar(const std::string& Key, const int nValue)
 
 void CSQLHelper::UpdatePreferencesVar(const std::string& Key, const int nValue, const std::string& sValue)
 {
-	if (!m_dbase)
+	UpdatePreferencesVars({ { Key, nValue, sValue } });
+}
+
+void CSQLHelper::UpdatePreferencesVars(const std::vector<_tPreferenceValue>& values)
+{
+	if ((!m_dbase) || (values.empty()))
 		return;
 
-	std::vector<std::vector<std::string> > result;
-	result = safe_query("SELECT ROWID FROM Preferences WHERE (Key='%q')",
-		Key.c_str());
-	if (result.empty())
-	{
-		//Insert
-		result = safe_query("INSERT INTO Preferences (Key, nValue, sValue) VALUES ('%q', %d,'%q')",
-			Key.c_str(), nValue, sValue.c_str());
-	}
-	else
+	bool bOK = true;
+	_tDataChanges changes;
 	{
-		//Update
-		result = safe_query("UPDATE Preferences SET Key='%q', nValue=%d, sValue='%q' WHERE (ROWID = '%q')",
-			Key.c_str(), nValue, sValue.c_str(), result[0][0].c_str());
-	}
+		std::lock_guard<std::mutex> l(m_preferences_mutex);
+		std::shared_ptr<const _tPreferences> pPreferences = std::atomic_load(&m_preferences);
+		if (!pPreferences)
+			pPreferences = LoadPreferences();
+		auto pNew = std::make_shared<_tPreferences>(*pPreferences);
+		{
+			std::unique_lock<std::mutex> lq(m_sqlQueryMutex, std::defer_lock);
+			LockWriter(lq);
+			const bool bTransaction = (values.size() > 1);
+			if (bTransaction)
+				bOK = (sqlite3_exec(m_dbase, "BEGIN TRANSACTION", nullptr, nullptr, nullptr) == SQLITE_OK);
+			for (const auto& value : values)
+			{
+				if (!bOK)
+					break;
+				const char* szSQL = (pNew->find(value.Key) == pNew->end())
+					? "INSERT INTO Preferences (nValue, sValue, Key) VALUES (?, ?, ?)"
+					: "UPDATE Preferences SET nValue=?, sValue=? WHERE (Key=?)";
+				sqlite3_stmt* pStatement = GetCachedStatement(szSQL);
+				if (pStatement == nullptr)
+				{
+					bOK = false;
+					break;
+				}
+				BindParameters(pStatement, 1, value.nValue, value.sValue, value.Key);
+				bOK = StepCachedStatement(pStatement, szSQL);
+				_tPreference& pref = (*pNew)[value.Key];
+				pref.nValue = value.nValue;
+				pref.sValue = value.sValue;
+				pref.bHasSValue = true;
+			}
+			if ((bTransaction) && (bOK))
+				bOK = (sqlite3_exec(m_dbase, "COMMIT TRANSACTION", nullptr, nullptr, nullptr) == SQLITE_OK);
+			if (!bOK)
+			{
+				_log.Log(LOG_ERROR, "SQLHelper: Could not store the preferences: %s", sqlite3_errmsg(m_dbase));
+				if (bTransaction)
+					sqlite3_exec(m_dbase, "ROLLBACK TRANSACTION", nullptr, nullptr, nullptr);
+			}
+			TakeDataChanges(changes);
+		}
+		//the snapshot is updated here, on an error it still matches the table
+		if (bOK)
+			std::atomic_store(&m_preferences, std::shared_ptr<const _tPreferences>(pNew));
+	}
+	changes.bPreferences = false;
+	ApplyDataChanges(changes);
+	if (!bOK)
+		return;
+	//preferences are used when building the device list
+	NoteAllDevicesChanged();
+	for (const auto& value : values)
+		NotifyPreferenceSubscribers(value.Key, value.nValue, value.sValue);
 }
 
 bool CSQLHelper::GetPreferencesVar(const std::string& Key, std::string& sValue)
@@ -5754,13 +6557,11 @@ bool CSQLHelper::GetPreferencesVar(const std::string& Key, std::string& sValue)
 	if (!m_dbase)
 		return false;
 
-	std::vector<std::vector<std::string> > result;
-	result = safe_query("SELECT sValue FROM Preferences WHERE (Key='%q')",
-		Key.c_str());
-	if (result.empty())
+	std::shared_ptr<const _tPreferences> pPreferences = GetPreferences();
+	auto itt = pPreferences->find(Key);
+	if ((itt == pPreferences->end()) || (!itt->second.bHasSValue))
 		return false;
-	std::vector<std::string> sd = result[0];
-	sValue = sd[0];
+	sValue = itt->second.sValue;
 	return true;
 }
 
@@ -5780,14 +6581,12 @@ bool CSQLHelper::GetPreferencesVar(const std::string& Key, int& nValue, std::str
 	if (!m_dbase)
 		return false;
 
-	std::vector<std::vector<std::string> > result;
-	result = safe_query("SELECT nValue, sValue FROM Preferences WHERE (Key='%q')",
-		Key.c_str());
-	if (result.empty())
+	std::shared_ptr<const _tPreferences> pPreferences = GetPreferences();
+	auto itt = pPreferences->find(Key);
+	if (itt == pPreferences->end())
 		return false;
-	std::vector<std::string> sd = result[0];
-	nValue = atoi(sd[0].c_str());
-	sValue = sd[1];
+	nValue = itt->second.nValue;
+	sValue = itt->second.sValue;
 	return true;
 }
 
@@ -5797,17 +6596,133 @@ bool CSQLHelper::GetPreferencesVar(const std::string& Key, int& nValue)
 	return GetPreferencesVar(Key, nValue, sValue);
 }
 
-void CSQLHelper::DeletePreferencesVar(const std::string& Key)
+int CSQLHelper::GetPreferencesInt(const std::string& Key, const int Default)
+{
+	int nValue = Default;
+	GetPreferencesVar(Key, nValue);
+	return nValue;
+}
+
+double CSQLHelper::GetPreferencesDouble(const std::string& Key, const double Default)
+{
+	double Value = Default;
+	if (!GetPreferencesVar(Key, Value))
+		return Default;
+	return Value;
+}
+
+std::string CSQLHelper::GetPreferencesString(const std::string& Key, const std::string& Default)
 {
 	std::string sValue;
+	if (!GetPreferencesVar(Key, sValue))
+		return Default;
+	return sValue;
+}
+
+void CSQLHelper::DeletePreferencesVar(const std::string& Key)
+{
 	if (!m_dbase)
 		return;
 
-	//if found, delete
-	if (GetPreferencesVar(Key, sValue) == true)
+	_tDataChanges changes;
+	{
+		std::lock_guard<std::mutex> l(m_preferences_mutex);
+		std::shared_ptr<const _tPreferences> pPreferences = std::atomic_load(&m_preferences);
+		if (!pPreferences)
+			pPreferences = LoadPreferences();
+		//if found, delete
+		if (pPreferences->find(Key) == pPreferences->end())
+			return;
+		prepared_query_int(changes, "DELETE FROM Preferences WHERE (Key=?)", nullptr, Key);
+		auto pNew = std::make_shared<_tPreferences>(*pPreferences);
+		pNew->erase(Key);
+		std::atomic_store(&m_preferences, std::shared_ptr<const _tPreferences>(pNew));
+	}
+	changes.bPreferences = false;
+	ApplyDataChanges(changes);
+	NoteAllDevicesChanged();
+}
+
+//Returns the published copy of the Preferences table, it is loaded when needed.
+//Writers replace the snapshot, readers never wait for them
+std::shared_ptr<const CSQLHelper::_tPreferences> CSQLHelper::GetPreferences()
+{
+	std::shared_ptr<const _tPreferences> pPreferences = std::atomic_load(&m_preferences);
+	if (pPreferences)
+		return pPreferences;
+	std::lock_guard<std::mutex> l(m_preferences_mutex);
+	pPreferences = std::atomic_load(&m_preferences);
+	if (!pPreferences)
+		pPreferences = LoadPreferences();
+	return pPreferences;
+}
+
+//Called with m_preferences_mutex held
+std::shared_ptr<const CSQLHelper::_tPreferences> CSQLHelper::LoadPreferences()
+{
+	const uint64_t generation = m_preferences_generation;
+	auto pPreferences = std::make_shared<_tPreferences>();
+	prepared_query("SELECT Key, nValue, sValue FROM Preferences",
+		[&](const CSQLRow& row) {
+			_tPreference pref;
+			pref.nValue = row.GetInt(1);
+			pref.bHasSValue = !row.IsNull(2);
+			if (pref.bHasSValue)
+				pref.sValue = row.GetText(2);
+			pPreferences->emplace(row.GetText(0), pref);
+			return true;
+		});
+	std::shared_ptr<const _tPreferences> pConst(pPreferences);
+	//a change made while reading would be missing
+	if (generation == m_preferences_generation)
+		std::atomic_store(&m_preferences, pConst);
+	return pConst;
+}
+
+//Not to be called while holding m_sqlQueryMutex
+void CSQLHelper::ClearPreferences()
+{
+	std::lock_guard<std::mutex> l(m_preferences_mutex);
+	std::atomic_store(&m_preferences, std::shared_ptr<const _tPreferences>());
+}
+
+//Preferences are written through UpdatePreferencesVar, other statements that change
+//the table (database upgrades) drop the snapshot, subscribers are not called for these.
+//Does not lock m_preferences_mutex, a statement might be executed while holding it
+void CSQLHelper::InvalidatePreferences()
+{
+	m_preferences_generation++;
+	std::atomic_store(&m_preferences, std::shared_ptr<const _tPreferences>());
+}
+
+int CSQLHelper::SubscribePreferences(const std::string& Key, const TPreferenceCallback& callback)
+{
+	std::lock_guard<std::mutex> l(m_preference_subscribers_mutex);
+	int id = ++m_preference_subscriber_id;
+	m_preference_subscribers[id] = std::make_pair(Key, callback);
+	return id;
+}
+
+void CSQLHelper::UnsubscribePreferences(const int id)
+{
+	std::lock_guard<std::mutex> l(m_preference_subscribers_mutex);
+	m_preference_subscribers.erase(id);
+}
+
+void CSQLHelper::NotifyPreferenceSubscribers(const std::string& Key, const int nValue, const std::string& sValue)
+{
+	std::vector<TPreferenceCallback> callbacks;
 	{
-		safe_query("DELETE FROM Preferences WHERE (Key='%q')", Key.c_str());
+		std::lock_guard<std::mutex> l(m_preference_subscribers_mutex);
+		for (const auto& subscriber : m_preference_subscribers)
+		{
+			if ((subscriber.second.first.empty()) || (subscriber.second.first == Key))
+				callbacks.push_back(subscriber.second.second);
+		}
 	}
+	//called without locks, a subscriber may read or write preferences
+	for (const auto& callback : callbacks)
+		callback(Key, nValue, sValue);
 }
 
 int CSQLHelper::GetLastBackupNo(const char* Key, int& nValue)
@@ -5925,17 +6840,49 @@ void CSQLHelper::ScheduleShortlog()
 		//Force WAL flush
 		sqlite3_wal_checkpoint(m_dbase, nullptr);
 
-		UpdateTemperatureLog();
-		UpdateRainLog();
-		UpdateWindLog();
-		UpdateUVLog();
-		UpdateMeter();
-		UpdateMultiMeter();
-		UpdatePercentageLog();
-		UpdateFanLog();
+		time_t now = mytime(nullptr);
+		if (now == 0)
+			return;
+
+		//Pending write-behind values have to be in the table we read from
+		FlushDeviceStatusJournal();
+
+		//Read all logged devices once, decode them into per table buffers and write these in one transaction
+		auto tStart = std::chrono::steady_clock::now();
+		std::vector<_tShortLogDevice> devices;
+		ReadShortLogDevices(now, devices);
+		auto tRead = std::chrono::steady_clock::now();
+
+		_tShortLogBatch batch;
+		batch.SensorTimeOut = 60;
+		GetPreferencesVar("SensorTimeout", batch.SensorTimeOut);
+		for (const auto& sd : devices)
+		{
+			DecodeTemperatureLog(sd, batch);
+			DecodeRainLog(sd, batch);
+			DecodeWindLog(sd, batch);
+			DecodeUVLog(sd, batch);
+			DecodeMeterLog(sd, batch);
+			DecodeMultiMeterLog(sd, batch);
+			DecodePercentageLog(sd, batch);
+			DecodeFanLog(sd, batch);
+		}
+		auto tDecode = std::chrono::steady_clock::now();
+
+		size_t nRows = WriteShortLog(batch);
+		auto tWrite = std::chrono::steady_clock::now();
+
 		//Removing the line below could cause a very large database,
 		//and slow(large) data transfer (specially when working remote!!)
 		CleanupShortLog();
+		auto tCleanup = std::chrono::steady_clock::now();
+
+		_log.Debug(DEBUG_SQL, "Shortlog: %d devices, %d rows, read: %d ms, decode: %d ms, write: %d ms, cleanup: %d ms",
+			static_cast<int>(devices.size()), static_cast<int>(nRows),
+			static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(tRead - tStart).count()),
+			static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(tDecode - tRead).count()),
+			static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(tWrite - tDecode).count()),
+			static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(tCleanup - tWrite).count()));
 	}
 	catch (boost::exception& e)
 	{
@@ -5967,6 +6914,8 @@ void CSQLHelper::ScheduleDay()
 		AddCalendarUpdateMultiMeter();
 		AddCalendarUpdatePercentage();
 		AddCalendarUpdateFan();
+		//All days before today have been written to the calendar tables
+		query("DELETE FROM ShortLogRollup WHERE (Date < date('now','localtime'))");
 		CleanupLightSceneLog();
 	}
 	catch (boost::exception& e)
@@ -5981,380 +6930,769 @@ void CSQLHelper::ScheduleDay()
 	}
 }
 
-void CSQLHelper::UpdateTemperatureLog()
+//Round to two decimals, as the former '%.2f' text inserts did
+static double RoundShortLogValue(const float value)
 {
-	time_t now = mytime(nullptr);
-	if (now == 0)
-		return;
-	struct tm tm1;
-	localtime_r(&now, &tm1);
+	return std::round(static_cast<double>(value) * 100.0) / 100.0;
+}
 
-	int SensorTimeOut = 60;
-	GetPreferencesVar("SensorTimeout", SensorTimeOut);
+//The value as it was stored from its '%g' text, without the float conversion noise
+static double ShortLogLevelValue(const float value)
+{
+	char szTmp[32];
+	snprintf(szTmp, sizeof(szTmp), "%g", value);
+	return strtod(szTmp, nullptr);
+}
 
-	std::vector<std::vector<std::string> > result;
-	result = safe_query("SELECT ID,Type,SubType,nValue,sValue,LastUpdate FROM DeviceStatus WHERE (Type=%d OR Type=%d OR Type=%d OR Type=%d OR Type=%d OR Type=%d OR Type=%d OR Type=%d OR Type=%d OR Type=%d OR Type=%d OR Type=%d OR Type=%d OR (Type=%d AND SubType=%d) OR (Type=%d AND SubType=%d) OR (Type=%d AND SubType=%d))",
-		pTypeTEMP,
-		pTypeHUM,
-		pTypeTEMP_HUM,
-		pTypeTEMP_HUM_BARO,
-		pTypeTEMP_BARO,
-		pTypeUV,
-		pTypeWIND,
-		pTypeThermostat1,
-		pTypeRFXSensor,
-		pTypeRego6XXTemp,
-		pTypeEvohomeZone,
-		pTypeEvohomeWater,
-		pTypeRadiator1,
-		pTypeGeneral, sTypeSystemTemp,
-		pTypeThermostat, sTypeThermSetpoint,
-		pTypeGeneral, sTypeBaro
-	);
-	if (!result.empty())
-	{
-		for (const auto &sd : result)
-		{
-			uint64_t ID = std::stoull(sd[0]);
-			unsigned char dType = atoi(sd[1].c_str());
-			unsigned char dSubType = atoi(sd[2].c_str());
-			int nValue = atoi(sd[3].c_str());
-			std::string sValue = sd[4];
+//Same rounding as the former "%.0f" conversion, throws on values that do not fit a counter
+static int64_t RoundMeterValue(const double fValue)
+{
+	if ((!std::isfinite(fValue)) || (std::fabs(fValue) >= 9.2e18))
+		throw std::out_of_range("meter value");
+	return static_cast<int64_t>(std::nearbyint(fValue));
+}
 
-			if (dType != pTypeRadiator1)
-			{
-				//do not include sensors that have no reading within an hour (except for devices that do not provide feedback, like the smartware radiator)
-				std::string sLastUpdate = sd[5];
-				struct tm ntime;
-				time_t checktime;
-				ParseSQLdatetime(checktime, ntime, sLastUpdate, tm1.tm_isdst);
+void CSQLHelper::ReadShortLogDevices(const time_t now, std::vector<_tShortLogDevice>& devices)
+{
+	//All types handled by the Decode*Log functions, sub types are checked while decoding
+	static const std::string szReadSQL = std_format(
+		"SELECT ID, Name, HardwareID, DeviceID, Unit, Type, SubType, nValue, sValue, LastUpdate, Options FROM DeviceStatus WHERE Type IN ("
+		"%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d," //temperature, rain, wind and uv
+		"%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d)", //general, meters and multi meters
+		pTypeTEMP, pTypeHUM, pTypeTEMP_HUM, pTypeTEMP_HUM_BARO, pTypeTEMP_BARO, pTypeUV, pTypeWIND, pTypeThermostat1, pTypeRFXSensor, pTypeRego6XXTemp,
+		pTypeEvohomeZone, pTypeEvohomeWater, pTypeRadiator1, pTypeThermostat, pTypeRAIN,
+		pTypeGeneral, pTypeRFXMeter, pTypeP1Gas, pTypeYouLess, pTypeENERGY, pTypePOWER, pTypeAirQuality, pTypeUsage, pTypeLux, pTypeWEIGHT, pTypeRego6XXValue,
+		pTypeP1Power, pTypeCURRENT, pTypeCURRENTENERGY);
 
-				if (difftime(now, checktime) >= SensorTimeOut * 60)
-					continue;
-				if (m_bShortLogAddOnlyNewValues)
-				{
-					if (difftime(now, checktime) > m_ShortLogInterval * 60)
-						continue;
-				}
-			}
+	struct tm tm1;
+	localtime_r(&now, &tm1);
 
-			std::vector<std::string> splitresults;
-			StringSplit(sValue, ";", splitresults);
-			if (splitresults.empty())
-				continue; //impossible
+	prepared_query(
+		szReadSQL.c_str(),
+		[&](const CSQLRow& row) {
+			_tShortLogDevice sd;
+			sd.ID = static_cast<uint64_t>(row.GetInt64(0));
+			sd.Name = row.GetText(1);
+			sd.HardwareID = row.GetInt(2);
+			sd.DeviceID = row.GetText(3);
+			sd.Unit = static_cast<unsigned char>(row.GetInt(4));
+			sd.dType = static_cast<unsigned char>(row.GetInt(5));
+			sd.dSubType = static_cast<unsigned char>(row.GetInt(6));
+			sd.nValue = row.GetInt(7);
+			sd.sValue = row.GetText(8);
+			sd.sOptions = row.GetText(10);
 
-			float temp = 0;
-			float chill = 0;
-			unsigned char humidity = 0;
-			int barometer = 0;
-			float dewpoint = 0;
-			float setpoint = 0;
+			struct tm ntime;
+			time_t checktime;
+			ParseSQLdatetime(checktime, ntime, row.GetText(9), tm1.tm_isdst);
+			sd.Age = difftime(now, checktime);
 
-			switch (dType)
-			{
-			case pTypeRego6XXTemp:
-			case pTypeTEMP:
-			case pTypeThermostat:
-				temp = static_cast<float>(atof(splitresults[0].c_str()));
-				break;
-			case pTypeThermostat1:
-				temp = static_cast<float>(atof(splitresults[0].c_str()));
-				break;
-			case pTypeRadiator1:
-				temp = static_cast<float>(atof(splitresults[0].c_str()));
-				break;
-			case pTypeEvohomeWater:
-				if (splitresults.size() >= 2)
-				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
-					if (splitresults[1] == "On")
-						setpoint = 60;
-					else if (splitresults[1] == "Off")
-						setpoint = 0;
-					else
-						setpoint = static_cast<float>(atof(splitresults[1].c_str()));
-				}
-				break;
-			case pTypeEvohomeZone:
-				if (splitresults.size() >= 2)
-				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
-					setpoint = static_cast<float>(atof(splitresults[1].c_str()));
-				}
-				break;
-			case pTypeHUM:
-				humidity = nValue;
-				break;
-			case pTypeTEMP_HUM:
-				if (splitresults.size() >= 2)
-				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
-					humidity = atoi(splitresults[1].c_str());
-					dewpoint = (float)CalculateDewPoint(temp, humidity);
-				}
-				break;
-			case pTypeTEMP_HUM_BARO:
-				if (splitresults.size() == 5)
-				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
-					humidity = atoi(splitresults[1].c_str());
-					if (dSubType == sTypeTHBFloat)
-						barometer = int(atof(splitresults[3].c_str()) * 10.0F);
-					else
-						barometer = atoi(splitresults[3].c_str());
-					dewpoint = (float)CalculateDewPoint(temp, humidity);
-				}
-				break;
-			case pTypeTEMP_BARO:
-				if (splitresults.size() >= 2)
-				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
-					barometer = int(atof(splitresults[1].c_str()) * 10.0F);
-				}
-				break;
-			case pTypeUV:
-				if (dSubType != sTypeUV3)
-					continue;
-				if (splitresults.size() >= 2)
-				{
-					temp = static_cast<float>(atof(splitresults[1].c_str()));
-				}
-				break;
-			case pTypeWIND:
-				if (dSubType == sTypeWINDNoTempNoChill)
-					continue;
-				if (splitresults.size() >= 6)
-				{
-					if (dSubType != sTypeWINDNoTemp)
-					{
-						temp = static_cast<float>(atof(splitresults[4].c_str()));
-					}
-					chill = static_cast<float>(atof(splitresults[5].c_str()));
-				}
-				break;
-			case pTypeRFXSensor:
-				if (dSubType != sTypeRFXSensorTemp)
-					continue;
-				temp = static_cast<float>(atof(splitresults[0].c_str()));
-				break;
-			case pTypeGeneral:
-				if (dSubType == sTypeSystemTemp)
-				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
-				}
-				else if (dSubType == sTypeBaro)
-				{
-					if (splitresults.size() != 2)
-						continue;
-					barometer = int(atof(splitresults[0].c_str()) * 10.0F);
-				}
-				break;
-			}
-			//insert record
-			safe_query(
-				"INSERT INTO Temperature (DeviceRowID, Temperature, Chill, Humidity, Barometer, DewPoint, SetPoint) "
-				"VALUES ('%" PRIu64 "', '%.2f', '%.2f', '%d', '%d', '%.2f', '%.2f')",
-				ID,
-				temp,
-				chill,
-				humidity,
-				barometer,
-				dewpoint,
-				setpoint
-			);
-		}
-	}
+			devices.push_back(std::move(sd));
+			return true;
+		});
 }
 
-void CSQLHelper::UpdateRainLog()
+//Do not include sensors that have no reading within the sensor timeout
+bool CSQLHelper::IsShortLogValueStale(const _tShortLogDevice& sd, const int SensorTimeOut)
 {
-	time_t now = mytime(nullptr);
-	if (now == 0)
-		return;
-	struct tm tm1;
-	localtime_r(&now, &tm1);
-
-	int SensorTimeOut = 60;
-	GetPreferencesVar("SensorTimeout", SensorTimeOut);
+	if (sd.Age >= SensorTimeOut * 60)
+		return true;
+	if (m_bShortLogAddOnlyNewValues)
+	{
+		if (sd.Age > m_ShortLogInterval * 60)
+			return true;
+	}
+	return false;
+}
 
-	std::vector<std::vector<std::string> > result;
-	result = safe_query("SELECT ID,Type,SubType,nValue,sValue,LastUpdate FROM DeviceStatus WHERE (Type=%d)", pTypeRAIN);
-	if (!result.empty())
+void CSQLHelper::DecodeTemperatureLog(const _tShortLogDevice& sd, _tShortLogBatch& batch)
+{
+	const unsigned char dType = sd.dType;
+	const unsigned char dSubType = sd.dSubType;
+	switch (dType)
 	{
-		for (const auto &sd : result)
-		{
-			uint64_t ID = std::stoull(sd[0]);
-			//unsigned char dType=atoi(sd[1].c_str());
-			//unsigned char dSubType=atoi(sd[2].c_str());
-			//int nValue=atoi(sd[3].c_str());
-			std::string sValue = sd[4];
+	case pTypeTEMP:
+	case pTypeHUM:
+	case pTypeTEMP_HUM:
+	case pTypeTEMP_HUM_BARO:
+	case pTypeTEMP_BARO:
+	case pTypeUV:
+	case pTypeWIND:
+	case pTypeThermostat1:
+	case pTypeRFXSensor:
+	case pTypeRego6XXTemp:
+	case pTypeEvohomeZone:
+	case pTypeEvohomeWater:
+	case pTypeRadiator1:
+		break;
+	case pTypeGeneral:
+		if ((dSubType != sTypeSystemTemp) && (dSubType != sTypeBaro))
+			return;
+		break;
+	case pTypeThermostat:
+		if (dSubType != sTypeThermSetpoint)
+			return;
+		break;
+	default:
+		return;
+	}
 
-			//do not include sensors that have no reading within an hour
-			std::string sLastUpdate = sd[5];
-			struct tm ntime;
-			time_t checktime;
-			ParseSQLdatetime(checktime, ntime, sLastUpdate, tm1.tm_isdst);
+	//Devices that do not provide feedback (like the smartware radiator) are always logged
+	if ((dType != pTypeRadiator1) && IsShortLogValueStale(sd, batch.SensorTimeOut))
+		return;
 
-			if (difftime(now, checktime) >= SensorTimeOut * 60)
-				continue;
-			if (m_bShortLogAddOnlyNewValues)
+	std::vector<std::string> splitresults;
+	StringSplit(sd.sValue, ";", splitresults);
+	if (splitresults.empty())
+		return; //impossible
+
+	float temp = 0;
+	float chill = 0;
+	unsigned char humidity = 0;
+	int barometer = 0;
+	float dewpoint = 0;
+	float setpoint = 0;
+
+	switch (dType)
+	{
+	case pTypeRego6XXTemp:
+	case pTypeTEMP:
+	case pTypeThermostat:
+	case pTypeThermostat1:
+	case pTypeRadiator1:
+		temp = static_cast<float>(atof(splitresults[0].c_str()));
+		break;
+	case pTypeEvohomeWater:
+		if (splitresults.size() >= 2)
+		{
+			temp = static_cast<float>(atof(splitresults[0].c_str()));
+			if (splitresults[1] == "On")
+				setpoint = 60;
+			else if (splitresults[1] == "Off")
+				setpoint = 0;
+			else
+				setpoint = static_cast<float>(atof(splitresults[1].c_str()));
+		}
+		break;
+	case pTypeEvohomeZone:
+		if (splitresults.size() >= 2)
+		{
+			temp = static_cast<float>(atof(splitresults[0].c_str()));
+			setpoint = static_cast<float>(atof(splitresults[1].c_str()));
+		}
+		break;
+	case pTypeHUM:
+		humidity = sd.nValue;
+		break;
+	case pTypeTEMP_HUM:
+		if (splitresults.size() >= 2)
+		{
+			temp = static_cast<float>(atof(splitresults[0].c_str()));
+			humidity = atoi(splitresults[1].c_str());
+			dewpoint = (float)CalculateDewPoint(temp, humidity);
+		}
+		break;
+	case pTypeTEMP_HUM_BARO:
+		if (splitresults.size() == 5)
+		{
+			temp = static_cast<float>(atof(splitresults[0].c_str()));
+			humidity = atoi(splitresults[1].c_str());
+			if (dSubType == sTypeTHBFloat)
+				barometer = int(atof(splitresults[3].c_str()) * 10.0F);
+			else
+				barometer = atoi(splitresults[3].c_str());
+			dewpoint = (float)CalculateDewPoint(temp, humidity);
+		}
+		break;
+	case pTypeTEMP_BARO:
+		if (splitresults.size() >= 2)
+		{
+			temp = static_cast<float>(atof(splitresults[0].c_str()));
+			barometer = int(atof(splitresults[1].c_str()) * 10.0F);
+		}
+		break;
+	case pTypeUV:
+		if (dSubType != sTypeUV3)
+			return;
+		if (splitresults.size() >= 2)
+		{
+			temp = static_cast<float>(atof(splitresults[1].c_str()));
+		}
+		break;
+	case pTypeWIND:
+		if (dSubType == sTypeWINDNoTempNoChill)
+			return;
+		if (splitresults.size() >= 6)
+		{
+			if (dSubType != sTypeWINDNoTemp)
 			{
-				if (difftime(now, checktime) > m_ShortLogInterval * 60)
-					continue;
+				temp = static_cast<float>(atof(splitresults[4].c_str()));
 			}
+			chill = static_cast<float>(atof(splitresults[5].c_str()));
+		}
+		break;
+	case pTypeRFXSensor:
+		if (dSubType != sTypeRFXSensorTemp)
+			return;
+		temp = static_cast<float>(atof(splitresults[0].c_str()));
+		break;
+	case pTypeGeneral:
+		if (dSubType == sTypeSystemTemp)
+		{
+			temp = static_cast<float>(atof(splitresults[0].c_str()));
+		}
+		else if (dSubType == sTypeBaro)
+		{
+			if (splitresults.size() != 2)
+				return;
+			barometer = int(atof(splitresults[0].c_str()) * 10.0F);
+		}
+		break;
+	}
+	batch.temperature.push_back({ sd.ID, temp, chill, humidity, barometer, dewpoint, setpoint });
+}
 
-			std::vector<std::string> splitresults;
-			StringSplit(sValue, ";", splitresults);
-			if (splitresults.size() < 2)
-				continue; //impossible
+void CSQLHelper::DecodeRainLog(const _tShortLogDevice& sd, _tShortLogBatch& batch)
+{
+	if (sd.dType != pTypeRAIN)
+		return;
+	if (IsShortLogValueStale(sd, batch.SensorTimeOut))
+		return;
 
-			int rate = atoi(splitresults[0].c_str());
-			float total = static_cast<float>(atof(splitresults[1].c_str()));
+	std::vector<std::string> splitresults;
+	StringSplit(sd.sValue, ";", splitresults);
+	if (splitresults.size() < 2)
+		return; //impossible
 
-			//insert record
-			safe_query(
-				"INSERT INTO Rain (DeviceRowID, Total, Rate) "
-				"VALUES ('%" PRIu64 "', '%.2f', '%d')",
-				ID,
-				total,
-				rate
-			);
+	int rate = atoi(splitresults[0].c_str());
+	float total = static_cast<float>(atof(splitresults[1].c_str()));
+	batch.rain.push_back({ sd.ID, total, rate });
+}
+
+void CSQLHelper::DecodeWindLog(const _tShortLogDevice& sd, _tShortLogBatch& batch)
+{
+	if (sd.dType != pTypeWIND)
+		return;
+	if (IsShortLogValueStale(sd, batch.SensorTimeOut))
+		return;
+
+	std::vector<std::string> splitresults;
+	StringSplit(sd.sValue, ";", splitresults);
+	if (splitresults.size() < 4)
+		return; //impossible
+
+	float direction = static_cast<float>(atof(splitresults[0].c_str()));
+
+	int speed = atoi(splitresults[2].c_str());
+	int gust = atoi(splitresults[3].c_str());
+
+	unsigned short DeviceID = 0;
+	std::stringstream s_str2(sd.DeviceID);
+	s_str2 >> DeviceID;
+
+	std::lock_guard<std::mutex> l(m_mainworker.m_calculator_mutex);
+	auto ittWC = m_mainworker.m_wind_calculator.find(DeviceID);
+	if (ittWC != m_mainworker.m_wind_calculator.end())
+	{
+		int speed_max, gust_max, speed_min, gust_min;
+		ittWC->second.GetMMSpeedGust(speed_min, speed_max, gust_min, gust_max);
+		if (speed_max != -1)
+			speed = speed_max;
+		if (gust_max != -1)
+			gust = gust_max;
+	}
+	batch.wind.push_back({ sd.ID, direction, speed, gust });
+}
+
+void CSQLHelper::DecodeUVLog(const _tShortLogDevice& sd, _tShortLogBatch& batch)
+{
+	if ((sd.dType != pTypeUV) && ((sd.dType != pTypeGeneral) || (sd.dSubType != sTypeUV)))
+		return;
+	if (IsShortLogValueStale(sd, batch.SensorTimeOut))
+		return;
+
+	std::vector<std::string> splitresults;
+	StringSplit(sd.sValue, ";", splitresults);
+	if (splitresults.empty())
+		return; //impossible
+
+	float level = static_cast<float>(atof(splitresults[0].c_str()));
+	batch.uv.push_back({ sd.ID, level });
+}
+
+void CSQLHelper::DecodeMeterLog(const _tShortLogDevice& sd, _tShortLogBatch& batch)
+{
+	const unsigned char dType = sd.dType;
+	const unsigned char dSubType = sd.dSubType;
+	switch (dType)
+	{
+	case pTypeRFXMeter:
+	case pTypeP1Gas:
+	case pTypeYouLess:
+	case pTypeENERGY:
+	case pTypePOWER:
+	case pTypeAirQuality:
+	case pTypeUsage:
+	case pTypeLux:
+	case pTypeWEIGHT:
+		break;
+	case pTypeRego6XXValue:
+		if (dSubType != sTypeRego6XXCounter)
+			return;
+		break;
+	case pTypeRFXSensor:
+		if ((dSubType != sTypeRFXSensorAD) && (dSubType != sTypeRFXSensorVolt))
+			return;
+		break;
+	case pTypeGeneral:
+		switch (dSubType)
+		{
+		case sTypeVisibility:
+		case sTypeSolarRadiation:
+		case sTypeSoilMoisture:
+		case sTypeLeafWetness:
+		case sTypeVoltage:
+		case sTypeCurrent:
+		case sTypeSoundLevel:
+		case sTypeDistance:
+		case sTypePressure:
+		case sTypeCounterIncremental:
+		case sTypeKwh:
+			break;
+		default:
+			return;
 		}
+		break;
+	default:
+		return;
+	}
+
+	// We don't want to update meter if externally managed
+	std::map<std::string, std::string> options = BuildDeviceOptions(sd.sOptions);
+	if (options["DisableLogAutoUpdate"] == "true")
+		return;
+
+	//Check for timeout, if timeout then dont add value
+	if (dType != pTypeP1Gas)
+	{
+		if (IsShortLogValueStale(sd, batch.SensorTimeOut))
+			return;
+	}
+	else
+	{
+		//P1 Gas meter transmits results every 1 a 2 hours
+		if (sd.Age >= 3 * 3600)
+			return;
+	}
+
+	//Counters that are stored as is, others are scaled to an integer below
+	std::string sValue = sd.sValue;
+	std::string sUsage;
+	bool bRawValue = false;
+	double fValue = 0;
+	double fUsage = 0;
+
+	std::vector<std::string> splitresults;
+	if (dType == pTypeYouLess)
+	{
+		StringSplit(sd.sValue, ";", splitresults);
+		if (splitresults.size() < 2)
+			return;
+		sValue = splitresults[0];
+		sUsage = splitresults[1];
+		bRawValue = true;
+	}
+	else if ((dType == pTypeENERGY) || (dType == pTypePOWER))
+	{
+		StringSplit(sd.sValue, ";", splitresults);
+		if (splitresults.size() < 2)
+			return;
+		sUsage = splitresults[0];
+		fValue = atof(splitresults[1].c_str()) * 100;
+	}
+	else if (dType == pTypeAirQuality)
+	{
+		fValue = sd.nValue;
+		m_notifications.CheckAndHandleNotification(sd.ID, sd.HardwareID, sd.DeviceID, sd.Name, sd.Unit, dType, dSubType, (int)sd.nValue);
+	}
+	else if ((dType == pTypeGeneral) && ((dSubType == sTypeSoilMoisture) || (dSubType == sTypeLeafWetness)))
+	{
+		fValue = sd.nValue;
+	}
+	else if ((dType == pTypeGeneral) && (dSubType == sTypeKwh))
+	{
+		StringSplit(sd.sValue, ";", splitresults);
+		if (splitresults.size() < 2)
+			return;
+		fUsage = atof(splitresults[0].c_str()) * 10.0F;
+		fValue = atof(splitresults[1].c_str());
+	}
+	else if (
+		((dType == pTypeGeneral) && ((dSubType == sTypeVisibility) || (dSubType == sTypeDistance) || (dSubType == sTypeSolarRadiation) || (dSubType == sTypeSoundLevel) || (dSubType == sTypePressure)))
+		|| (dType == pTypeWEIGHT)
+		|| (dType == pTypeUsage)
+		)
+	{
+		fValue = atof(sValue.c_str()) * 10.0F;
+	}
+	else if ((dType == pTypeLux) || (dType == pTypeRFXSensor) || ((dType == pTypeGeneral) && (dSubType == sTypeCounterIncremental)))
+	{
+		fValue = atof(sValue.c_str());
+	}
+	else if ((dType == pTypeGeneral) && ((dSubType == sTypeVoltage) || (dSubType == sTypeCurrent)))
+	{
+		fValue = atof(sValue.c_str()) * 1000.0F;
+	}
+	else
+	{
+		//RFXMeter, P1 Gas and Rego counters
+		bRawValue = true;
 	}
+
+	int64_t MeterValue = 0;
+	int64_t MeterUsage = 0;
+
+	try
+	{
+		MeterUsage = (!sUsage.empty()) ? std::stoll(sUsage) : RoundMeterValue(fUsage);
+		MeterValue = (bRawValue) ? std::stoll(sValue) : RoundMeterValue(fValue);
+	}
+	catch (const std::exception&)
+	{
+		_log.Log(LOG_ERROR, "UpdateMeter: Error converting sValue/sUsage! (IDX: %" PRIu64 ", sValue: '%s', sUsage: '%s', dType: %d, sType: %d)", sd.ID, sd.sValue.c_str(), sUsage.c_str(), dType, dSubType);
+		return;
+	}
+	batch.meter.push_back({ sd.ID, MeterValue, MeterUsage });
 }
 
-void CSQLHelper::UpdateWindLog()
+void CSQLHelper::DecodeMultiMeterLog(const _tShortLogDevice& sd, _tShortLogBatch& batch)
 {
-	time_t now = mytime(nullptr);
-	if (now == 0)
+	const unsigned char dType = sd.dType;
+	const unsigned char dSubType = sd.dSubType;
+	if ((dType != pTypeP1Power) && (dType != pTypeCURRENT) && (dType != pTypeCURRENTENERGY))
 		return;
-	struct tm tm1;
-	localtime_r(&now, &tm1);
 
-	int SensorTimeOut = 60;
-	GetPreferencesVar("SensorTimeout", SensorTimeOut);
+	// We don't want to update meter if externally managed
+	std::map<std::string, std::string> options = BuildDeviceOptions(sd.sOptions);
+	if (options["DisableLogAutoUpdate"] == "true")
+		return;
 
-	std::vector<std::vector<std::string> > result;
-	result = safe_query("SELECT ID,DeviceID, Type,SubType,nValue,sValue,LastUpdate FROM DeviceStatus WHERE (Type=%d)", pTypeWIND);
-	if (!result.empty())
+	if (IsShortLogValueStale(sd, batch.SensorTimeOut))
+		return;
+
+	std::vector<std::string> splitresults;
+	StringSplit(sd.sValue, ";", splitresults);
+
+	_tShortLogMultiMeter item;
+	item.ID = sd.ID;
+
+	if (dType == pTypeP1Power)
 	{
-		for (const auto &sd : result)
+		if (splitresults.size() != 6)
+			return; //impossible
+
+		try
 		{
-			uint64_t ID = std::stoull(sd[0]);
+			item.value1 = std::stoull(splitresults[0]); //powerusage1
+			item.value5 = std::stoull(splitresults[1]); //powerusage2
+			item.value2 = std::stoull(splitresults[2]); //powerdeliv1
+			item.value6 = std::stoull(splitresults[3]); //powerdeliv2
+			item.value3 = std::stoull(splitresults[4]); //usagecurrent
+			item.value4 = std::stoull(splitresults[5]); //delivcurrent
+		}
+		catch (const std::exception &)
+		{
+			_log.Log(LOG_ERROR, "UpdateMultiMeter: Error converting sValue values! (IDX: %" PRIu64 ", sValue: '%s', dType: %d, sType: %d)", sd.ID, sd.sValue.c_str(), dType, dSubType);
+			return;
+		}
+	}
+	else if ((dType == pTypeCURRENT) && (dSubType == sTypeELEC1))
+	{
+		if (splitresults.size() != 3)
+			return; //impossible
 
-			unsigned short DeviceID;
-			std::stringstream s_str2(sd[1]);
-			s_str2 >> DeviceID;
+		item.value1 = (unsigned long)(atof(splitresults[0].c_str()) * 10.0F);
+		item.value2 = (unsigned long)(atof(splitresults[1].c_str()) * 10.0F);
+		item.value3 = (unsigned long)(atof(splitresults[2].c_str()) * 10.0F);
+	}
+	else if ((dType == pTypeCURRENTENERGY) && (dSubType == sTypeELEC4))
+	{
+		if (splitresults.size() != 4)
+			return; //impossible
 
-			//unsigned char dType=atoi(sd[2].c_str());
-			//unsigned char dSubType=atoi(sd[3].c_str());
-			//int nValue=atoi(sd[4].c_str());
-			std::string sValue = sd[5];
+		item.value1 = (unsigned long)(atof(splitresults[0].c_str()) * 10.0F);
+		item.value2 = (unsigned long)(atof(splitresults[1].c_str()) * 10.0F);
+		item.value3 = (unsigned long)(atof(splitresults[2].c_str()) * 10.0F);
+		item.value4 = (uint64_t)(atof(splitresults[3].c_str()) * 1000.0F);
+	}
+	else
+		return;//don't know you (yet)
 
-			//do not include sensors that have no reading within an hour
-			std::string sLastUpdate = sd[6];
-			struct tm ntime;
-			time_t checktime;
-			ParseSQLdatetime(checktime, ntime, sLastUpdate, tm1.tm_isdst);
+	batch.multimeter.push_back(item);
+}
 
-			if (difftime(now, checktime) >= SensorTimeOut * 60)
-				continue;
-			if (m_bShortLogAddOnlyNewValues)
-			{
-				if (difftime(now, checktime) > m_ShortLogInterval * 60)
-					continue;
-			}
+void CSQLHelper::DecodePercentageLog(const _tShortLogDevice& sd, _tShortLogBatch& batch)
+{
+	if ((sd.dType != pTypeGeneral) || ((sd.dSubType != sTypePercentage) && (sd.dSubType != sTypeWaterflow) && (sd.dSubType != sTypeCustom)))
+		return;
+	if (IsShortLogValueStale(sd, batch.SensorTimeOut))
+		return;
+	if (sd.sValue.empty())
+		return; //impossible
 
-			std::vector<std::string> splitresults;
-			StringSplit(sValue, ";", splitresults);
-			if (splitresults.size() < 4)
-				continue; //impossible
+	float percentage = static_cast<float>(atof(sd.sValue.c_str()));
+	batch.percentage.push_back({ sd.ID, percentage });
+}
 
-			float direction = static_cast<float>(atof(splitresults[0].c_str()));
+void CSQLHelper::DecodeFanLog(const _tShortLogDevice& sd, _tShortLogBatch& batch)
+{
+	if ((sd.dType != pTypeGeneral) || (sd.dSubType != sTypeFan))
+		return;
+	if (IsShortLogValueStale(sd, batch.SensorTimeOut))
+		return;
+	if (sd.sValue.empty())
+		return; //impossible
 
-			int speed = atoi(splitresults[2].c_str());
-			int gust = atoi(splitresults[3].c_str());
+	int speed = (int)atoi(sd.sValue.c_str());
+	batch.fan.push_back({ sd.ID, speed });
+}
 
-			auto ittWC = m_mainworker.m_wind_calculator.find(DeviceID);
-			if (ittWC != m_mainworker.m_wind_calculator.end())
-			{
-				int speed_max, gust_max, speed_min, gust_min;
-				ittWC->second.GetMMSpeedGust(speed_min, speed_max, gust_min, gust_max);
-				if (speed_max != -1)
-					speed = speed_max;
-				if (gust_max != -1)
-					gust = gust_max;
-			}
+//Writes all decoded rows in one transaction, returns the number of inserted rows
+size_t CSQLHelper::WriteShortLog(const _tShortLogBatch& batch)
+{
+	constexpr auto szTemperatureSQL = "INSERT INTO Temperature (DeviceRowID, Temperature, Chill, Humidity, Barometer, DewPoint, SetPoint) VALUES (?, ?, ?, ?, ?, ?, ?)";
+	constexpr auto szRainSQL = "INSERT INTO Rain (DeviceRowID, Total, Rate) VALUES (?, ?, ?)";
+	constexpr auto szWindSQL = "INSERT INTO Wind (DeviceRowID, Direction, Speed, Gust) VALUES (?, ?, ?, ?)";
+	constexpr auto szUVSQL = "INSERT INTO UV (DeviceRowID, Level) VALUES (?, ?)";
+	constexpr auto szMeterSQL = "INSERT INTO Meter (DeviceRowID, Value, [Usage]) VALUES (?, ?, ?)";
+	constexpr auto szMultiMeterSQL = "INSERT INTO MultiMeter (DeviceRowID, Value1, Value2, Value3, Value4, Value5, Value6) VALUES (?, ?, ?, ?, ?, ?, ?)";
+	constexpr auto szPercentageSQL = "INSERT INTO Percentage (DeviceRowID, Percentage) VALUES (?, ?)";
+	constexpr auto szFanSQL = "INSERT INTO Fan (DeviceRowID, Speed) VALUES (?, ?)";
 
-			//insert record
-			safe_query(
-				"INSERT INTO Wind (DeviceRowID, Direction, Speed, Gust) "
-				"VALUES ('%" PRIu64 "', '%.2f', '%d', '%d')",
-				ID,
-				direction,
-				speed,
-				gust
-			);
+	size_t nRows = 0;
+	std::unique_lock<std::mutex> l(m_sqlQueryMutex, std::defer_lock);
+	LockWriter(l);
+	if (!m_dbase)
+		return nRows;
+
+	if (sqlite3_exec(m_dbase, "BEGIN TRANSACTION", nullptr, nullptr, nullptr) != SQLITE_OK)
+	{
+		_log.Log(LOG_ERROR, "SQLHelper: Could not write the short log: %s", sqlite3_errmsg(m_dbase));
+		return nRows;
+	}
+
+	sqlite3_stmt* pStatement = GetCachedStatement(szTemperatureSQL);
+	if (pStatement != nullptr)
+	{
+		for (const auto& item : batch.temperature)
+		{
+			BindParameters(pStatement, 1, item.ID, RoundShortLogValue(item.temp), RoundShortLogValue(item.chill), item.humidity, item.barometer, RoundShortLogValue(item.dewpoint), RoundShortLogValue(item.setpoint));
+			nRows += StepCachedStatement(pStatement, szTemperatureSQL);
+		}
+	}
+	pStatement = GetCachedStatement(szRainSQL);
+	if (pStatement != nullptr)
+	{
+		for (const auto& item : batch.rain)
+		{
+			BindParameters(pStatement, 1, item.ID, RoundShortLogValue(item.total), item.rate);
+			nRows += StepCachedStatement(pStatement, szRainSQL);
+		}
+	}
+	pStatement = GetCachedStatement(szWindSQL);
+	if (pStatement != nullptr)
+	{
+		for (const auto& item : batch.wind)
+		{
+			BindParameters(pStatement, 1, item.ID, RoundShortLogValue(item.direction), item.speed, item.gust);
+			nRows += StepCachedStatement(pStatement, szWindSQL);
+		}
+	}
+	pStatement = GetCachedStatement(szUVSQL);
+	if (pStatement != nullptr)
+	{
+		for (const auto& item : batch.uv)
+		{
+			BindParameters(pStatement, 1, item.ID, ShortLogLevelValue(item.value));
+			nRows += StepCachedStatement(pStatement, szUVSQL);
+		}
+	}
+	pStatement = GetCachedStatement(szMeterSQL);
+	if (pStatement != nullptr)
+	{
+		for (const auto& item : batch.meter)
+		{
+			BindParameters(pStatement, 1, item.ID, item.value, item.usage);
+			nRows += StepCachedStatement(pStatement, szMeterSQL);
 		}
 	}
+	pStatement = GetCachedStatement(szMultiMeterSQL);
+	if (pStatement != nullptr)
+	{
+		for (const auto& item : batch.multimeter)
+		{
+			BindParameters(pStatement, 1, item.ID, item.value1, item.value2, item.value3, item.value4, item.value5, item.value6);
+			nRows += StepCachedStatement(pStatement, szMultiMeterSQL);
+		}
+	}
+	pStatement = GetCachedStatement(szPercentageSQL);
+	if (pStatement != nullptr)
+	{
+		for (const auto& item : batch.percentage)
+		{
+			BindParameters(pStatement, 1, item.ID, ShortLogLevelValue(item.value));
+			nRows += StepCachedStatement(pStatement, szPercentageSQL);
+		}
+	}
+	pStatement = GetCachedStatement(szFanSQL);
+	if (pStatement != nullptr)
+	{
+		for (const auto& item : batch.fan)
+		{
+			BindParameters(pStatement, 1, item.ID, item.speed);
+			nRows += StepCachedStatement(pStatement, szFanSQL);
+		}
+	}
+
+	_tDataChanges changes;
+	if (sqlite3_exec(m_dbase, "COMMIT TRANSACTION", nullptr, nullptr, nullptr) != SQLITE_OK)
+	{
+		_log.Log(LOG_ERROR, "SQLHelper: Could not write the short log: %s", sqlite3_errmsg(m_dbase));
+		sqlite3_exec(m_dbase, "ROLLBACK TRANSACTION", nullptr, nullptr, nullptr);
+		//the rows that were rolled back leave bShortLog set, today's counters are read again from the tables
+		TakeDataChanges(changes);
+		l.unlock();
+		ApplyDataChanges(changes);
+		return 0;
+	}
+	TakeDataChanges(changes);
+	changes.bShortLog = false;
+	UpdateTodayCounters(batch);
+	l.unlock();
+	ApplyDataChanges(changes);
+	//the device list shows today's usage of these devices, which is read from the rows just written
+	for (const auto& item : batch.rain)
+		NoteDeviceChanged(item.ID);
+	for (const auto& item : batch.meter)
+		NoteDeviceChanged(item.ID);
+	for (const auto& item : batch.multimeter)
+		NoteDeviceChanged(item.ID);
+	return nRows;
 }
 
-void CSQLHelper::UpdateUVLog()
+static void AddTodayCounterValues(_tTodayCounter& counter, const std::initializer_list<double>& values)
 {
-	time_t now = mytime(nullptr);
-	if (now == 0)
-		return;
-	struct tm tm1;
-	localtime_r(&now, &tm1);
+	int ii = 0;
+	for (const double value : values)
+	{
+		if ((counter.Count == 0) || (value < counter.Min[ii]))
+			counter.Min[ii] = value;
+		if ((counter.Count == 0) || (value > counter.Max[ii]))
+			counter.Max[ii] = value;
+		ii++;
+	}
+	counter.Count++;
+}
 
-	int SensorTimeOut = 60;
-	GetPreferencesVar("SensorTimeout", SensorTimeOut);
+//Adds the rows just written by WriteShortLog to the counters that are already known,
+//unknown devices are read from the tables when they are asked for
+void CSQLHelper::UpdateTodayCounters(const _tShortLogBatch& batch)
+{
+	std::lock_guard<std::mutex> l(m_today_counters_mutex);
+	CheckTodayCountersDate(TimeToString(nullptr, TF_Date));
+	m_today_counters_generation++;
 
-	std::vector<std::vector<std::string> > result;
-	result = safe_query("SELECT ID,Type,SubType,nValue,sValue,LastUpdate FROM DeviceStatus WHERE (Type=%d) OR (Type=%d AND SubType=%d)",
-		pTypeUV,
-		pTypeGeneral, sTypeUV
-	);
-	if (!result.empty())
+	auto& rain = m_today_counters["Rain"];
+	for (const auto& item : batch.rain)
 	{
-		for (const auto &sd : result)
+		auto itt = rain.find(item.ID);
+		if (itt != rain.end())
+			AddTodayCounterValues(itt->second, { RoundShortLogValue(item.total), static_cast<double>(item.rate) });
+	}
+	auto& meter = m_today_counters["Meter"];
+	for (const auto& item : batch.meter)
+	{
+		auto itt = meter.find(item.ID);
+		if (itt != meter.end())
+			AddTodayCounterValues(itt->second, { static_cast<double>(item.value), static_cast<double>(item.usage) });
+	}
+	auto& multimeter = m_today_counters["MultiMeter"];
+	for (const auto& item : batch.multimeter)
+	{
+		auto itt = multimeter.find(item.ID);
+		if (itt != multimeter.end())
+			AddTodayCounterValues(itt->second, { static_cast<double>(item.value1), static_cast<double>(item.value2), static_cast<double>(item.value3),
+				static_cast<double>(item.value4), static_cast<double>(item.value5), static_cast<double>(item.value6) });
+	}
+}
+
+bool CSQLHelper::GetTodayCounter(const char* szTable, const uint64_t DeviceRowID, _tTodayCounter& counter)
+{
+	const std::string szDate = TimeToString(nullptr, TF_Date);
+	uint64_t generation;
+	{
+		std::lock_guard<std::mutex> l(m_today_counters_mutex);
+		CheckTodayCountersDate(szDate);
+		const auto& counters = m_today_counters[szTable];
+		auto itt = counters.find(DeviceRowID);
+		if (itt != counters.end())
 		{
-			uint64_t ID = std::stoull(sd[0]);
-			//unsigned char dType=atoi(sd[1].c_str());
-			//unsigned char dSubType=atoi(sd[2].c_str());
-			//int nValue=atoi(sd[3].c_str());
-			std::string sValue = sd[4];
+			counter = itt->second;
+			return (counter.Count > 0);
+		}
+		generation = m_today_counters_generation;
+	}
 
-			//do not include sensors that have no reading within an hour
-			std::string sLastUpdate = sd[5];
-			struct tm ntime;
-			time_t checktime;
-			ParseSQLdatetime(checktime, ntime, sLastUpdate, tm1.tm_isdst);
+	auto ittTable = std::find_if(ShortLogRollupTables.begin(), ShortLogRollupTables.end(),
+		[szTable](const std::pair<std::string, std::vector<std::string>>& table) { return table.first == szTable; });
+	if (ittTable == ShortLogRollupTables.end())
+		return false;
 
-			if (difftime(now, checktime) >= SensorTimeOut * 60)
-				continue;
-			if (m_bShortLogAddOnlyNewValues)
+	//The day totals kept by the rollup triggers are used when no row of today was changed afterwards
+	_tTodayCounter fresh;
+	bool bHaveRollup = false;
+	prepared_query(
+		"SELECT [Count], Min1, Min2, Min3, Min4, Min5, Min6, Max1, Max2, Max3, Max4, Max5, Max6 "
+		"FROM ShortLogRollup WHERE (Source=?) AND (DeviceRowID=?) AND (Date=?) AND (Dirty=0)",
+		[&](const CSQLRow& row) {
+			fresh.Count = row.GetInt(0);
+			for (size_t ii = 0; (ii < ittTable->second.size()) && (fresh.Count > 0); ii++)
 			{
-				if (difftime(now, checktime) > m_ShortLogInterval * 60)
-					continue;
+				fresh.Min[ii] = row.GetDouble(1 + static_cast<int>(ii));
+				fresh.Max[ii] = row.GetDouble(7 + static_cast<int>(ii));
 			}
+			bHaveRollup = true;
+			return false;
+		},
+		szTable, DeviceRowID, szDate);
 
-			std::vector<std::string> splitresults;
-			StringSplit(sValue, ";", splitresults);
-			if (splitresults.empty())
-				continue; //impossible
-
-			float level = static_cast<float>(atof(splitresults[0].c_str()));
+	if (!bHaveRollup)
+	{
+		std::string szColumns = "COUNT(*)";
+		for (const auto& column : ittTable->second)
+			szColumns += ", MIN([" + column + "]), MAX([" + column + "])";
 
-			//insert record
-			safe_query(
-				"INSERT INTO UV (DeviceRowID, Level) "
-				"VALUES ('%" PRIu64 "', '%g')",
-				ID,
-				level
-			);
+		auto result = safe_query_readonly("SELECT %s FROM %s WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", szColumns.c_str(), szTable, DeviceRowID, szDate.c_str());
+		if (!result.empty())
+		{
+			const std::vector<std::string>& sd = result[0];
+			fresh.Count = atoi(sd[0].c_str());
+			for (size_t ii = 0; (ii < ittTable->second.size()) && (fresh.Count > 0); ii++)
+			{
+				fresh.Min[ii] = atof(sd[1 + (ii * 2)].c_str());
+				fresh.Max[ii] = atof(sd[2 + (ii * 2)].c_str());
+			}
 		}
 	}
+
+	{
+		//rows written meanwhile might be missing from what we just read
+		std::lock_guard<std::mutex> l(m_today_counters_mutex);
+		if (generation == m_today_counters_generation)
+			m_today_counters[szTable][DeviceRowID] = fresh;
+	}
+	counter = fresh;
+	return (fresh.Count > 0);
 }
 
 bool CSQLHelper::UpdateCalendarMeter(
@@ -6468,594 +7806,147 @@ bool CSQLHelper::UpdateCalendarMeter(
 		if (multiMeter) {
 			result = safe_query(
 				"SELECT DeviceRowID FROM MultiMeter_Calendar "
-				"WHERE (DeviceRowID=='%" PRIu64 "') AND (Date=='%q')",
-				DeviceRowID, date
-			);
-			if (result.empty())
-			{
-				safe_query(
-					"INSERT INTO MultiMeter_Calendar (DeviceRowID, Value1, Value2, Value3, Value4, Value5, Value6, Counter1, Counter2, Counter3, Counter4, Date) "
-					"VALUES ('%" PRIu64 "', '%" PRId64 "', '%" PRId64 "', '%" PRId64 "', '%" PRId64 "', '%" PRId64 "', '%" PRId64 "', '%" PRId64 "', '%" PRId64 "', '%" PRId64 "', '%" PRId64 "', '%q')",
-					DeviceRowID,
-					(value1 < 0) ? 0 : value1,
-					(value2 < 0) ? 0 : value2,
-					(value3 < 0) ? 0 : value3,
-					(value4 < 0) ? 0 : value4,
-					(value5 < 0) ? 0 : value5,
-					(value6 < 0) ? 0 : value6,
-					(counter1 < 0) ? 0 : counter1,
-					(counter2 < 0) ? 0 : counter2,
-					(counter3 < 0) ? 0 : counter3,
-					(counter4 < 0) ? 0 : counter4,
-					date
-				);
-			}
-			else
-			{
-				safe_query(
-					"UPDATE MultiMeter_Calendar SET Value1='%" PRId64 "', Value2='%" PRId64 "', Value3='%" PRId64 "', Value4='%" PRId64 "', Value5='%" PRId64 "', Value6='%" PRId64 "' , Counter1='%" PRId64 "' , Counter2='%" PRId64 "' , Counter3='%" PRId64 "' , Counter4='%" PRId64 "' "
-					"WHERE ((DeviceRowID=='%" PRIu64 "') AND (Date=='%q'))",
-					(value1 < 0) ? 0 : value1,
-					(value2 < 0) ? 0 : value2,
-					(value3 < 0) ? 0 : value3,
-					(value4 < 0) ? 0 : value4,
-					(value5 < 0) ? 0 : value5,
-					(value6 < 0) ? 0 : value6,
-					(counter1 < 0) ? 0 : counter1,
-					(counter2 < 0) ? 0 : counter2,
-					(counter3 < 0) ? 0 : counter3,
-					(counter4 < 0) ? 0 : counter4,
-					DeviceRowID,
-					date
-				);
-			}
-		}
-		else {
-			result = safe_query(
-				"SELECT DeviceRowID FROM Meter_Calendar "
-				"WHERE (DeviceRowID=='%" PRIu64 "') AND (Date=='%q')",
-				DeviceRowID, date
-			);
-			if (result.empty())
-			{
-				safe_query(
-					"INSERT INTO Meter_Calendar (DeviceRowID, Counter, Value, Date) "
-					"VALUES ('%" PRIu64 "', '%" PRId64 "', '%" PRId64 "', '%q')",
-					DeviceRowID, (value1 < 0) ? 0 : value1, (value2 < 0) ? 0 : value2, date
-				);
-			}
-			else
-			{
-				safe_query(
-					"UPDATE Meter_Calendar SET DeviceRowID='%" PRIu64 "', Counter='%" PRId64 "', Value='%" PRId64 "', Date='%q' "
-					"WHERE (DeviceRowID=='%" PRIu64 "') AND (Date=='%q')",
-					DeviceRowID, (value1 < 0) ? 0 : value1, (value2 < 0) ? 0 : value2, date,
-					DeviceRowID, date
-				);
-			}
-		}
-	}
-	return true;
-}
-
-void CSQLHelper::UpdateMeter()
-{
-	time_t now = mytime(nullptr);
-	if (now == 0)
-		return;
-	struct tm tm1;
-	localtime_r(&now, &tm1);
-
-	int SensorTimeOut = 60;
-	GetPreferencesVar("SensorTimeout", SensorTimeOut);
-
-	std::vector<std::vector<std::string> > result;
-	std::vector<std::vector<std::string> > result2;
-
-	result = safe_query(
-		"SELECT ID,Name,HardwareID,DeviceID,Unit,Type,SubType,nValue,sValue,LastUpdate,Options FROM DeviceStatus WHERE ("
-		"Type=%d OR " //pTypeRFXMeter
-		"Type=%d OR " //pTypeP1Gas
-		"Type=%d OR " //pTypeYouLess
-		"Type=%d OR " //pTypeENERGY
-		"Type=%d OR " //pTypePOWER
-		"Type=%d OR " //pTypeAirQuality
-		"Type=%d OR " //pTypeUsage
-		"Type=%d OR " //pTypeLux
-		"Type=%d OR " //pTypeWEIGHT
-		"(Type=%d AND SubType=%d) OR " //pTypeRego6XXValue,sTypeRego6XXCounter
-		"(Type=%d AND SubType=%d) OR " //pTypeGeneral,sTypeVisibility
-		"(Type=%d AND SubType=%d) OR " //pTypeGeneral,sTypeSolarRadiation
-		"(Type=%d AND SubType=%d) OR " //pTypeGeneral,sTypeSoilMoisture
-		"(Type=%d AND SubType=%d) OR " //pTypeGeneral,sTypeLeafWetness
-		"(Type=%d AND SubType=%d) OR " //pTypeRFXSensor,sTypeRFXSensorAD
-		"(Type=%d AND SubType=%d) OR" //pTypeRFXSensor,sTypeRFXSensorVolt
-		"(Type=%d AND SubType=%d) OR"  //pTypeGeneral,sTypeVoltage
-		"(Type=%d AND SubType=%d) OR"  //pTypeGeneral,sTypeCurrent
-		"(Type=%d AND SubType=%d) OR"  //pTypeGeneral,sTypeSoundLevel
-		"(Type=%d AND SubType=%d) OR " //pTypeGeneral,sTypeDistance
-		"(Type=%d AND SubType=%d) OR " //pTypeGeneral,sTypePressure
-		"(Type=%d AND SubType=%d) OR " //pTypeGeneral,sTypeCounterIncremental
-		"(Type=%d AND SubType=%d)"	 //pTypeGeneral,sTypeKwh
-		")",
-		pTypeRFXMeter,
-		pTypeP1Gas,
-		pTypeYouLess,
-		pTypeENERGY,
-		pTypePOWER,
-		pTypeAirQuality,
-		pTypeUsage,
-		pTypeLux,
-		pTypeWEIGHT,
-		pTypeRego6XXValue, sTypeRego6XXCounter,
-		pTypeGeneral, sTypeVisibility,
-		pTypeGeneral, sTypeSolarRadiation,
-		pTypeGeneral, sTypeSoilMoisture,
-		pTypeGeneral, sTypeLeafWetness,
-		pTypeRFXSensor, sTypeRFXSensorAD,
-		pTypeRFXSensor, sTypeRFXSensorVolt,
-		pTypeGeneral, sTypeVoltage,
-		pTypeGeneral, sTypeCurrent,
-		pTypeGeneral, sTypeSoundLevel,
-		pTypeGeneral, sTypeDistance,
-		pTypeGeneral, sTypePressure,
-		pTypeGeneral, sTypeCounterIncremental,
-		pTypeGeneral, sTypeKwh
-	);
-	if (!result.empty())
-	{
-		for (const auto &sd : result)
-		{
-			char szTmp[200];
-
-			std::string sOptions = sd[10];
-			std::map<std::string, std::string> options = BuildDeviceOptions(sOptions);
-			// We don't want to update meter if externally managed
-			if (options["DisableLogAutoUpdate"] == "true")
-			{
-				continue;
-			}
-
-			uint64_t ID = std::stoull(sd[0]);
-			std::string devname = sd[1];
-			int hardwareID = atoi(sd[2].c_str());
-			std::string DeviceID = sd[3];
-			unsigned char Unit = atoi(sd[4].c_str());
-
-			unsigned char dType = atoi(sd[5].c_str());
-			unsigned char dSubType = atoi(sd[6].c_str());
-			int nValue = atoi(sd[7].c_str());
-			std::string sValue = sd[8];
-			std::string sLastUpdate = sd[9];
-
-			std::string sUsage = "0";
-
-			//do not include sensors that have no reading within an hour
-			struct tm ntime;
-			time_t checktime;
-			ParseSQLdatetime(checktime, ntime, sLastUpdate, tm1.tm_isdst);
-
-			//Check for timeout, if timeout then dont add value
-			if (dType != pTypeP1Gas)
-			{
-				if (difftime(now, checktime) >= SensorTimeOut * 60)
-					continue;
-				if (m_bShortLogAddOnlyNewValues)
-				{
-					if (difftime(now, checktime) > m_ShortLogInterval * 60)
-						continue;
-				}
-			}
-			else
-			{
-				//P1 Gas meter transmits results every 1 a 2 hours
-				if (difftime(now, checktime) >= 3 * 3600)
-					continue;
-			}
-
-			if (dType == pTypeYouLess)
-			{
-				std::vector<std::string> splitresults;
-				StringSplit(sValue, ";", splitresults);
-				if (splitresults.size() < 2)
-					continue;
-				sValue = splitresults[0];
-				sUsage = splitresults[1];
-			}
-			else if (dType == pTypeENERGY)
-			{
-				std::vector<std::string> splitresults;
-				StringSplit(sValue, ";", splitresults);
-				if (splitresults.size() < 2)
-					continue;
-				sUsage = splitresults[0];
-				double fValue = atof(splitresults[1].c_str()) * 100;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if (dType == pTypePOWER)
-			{
-				std::vector<std::string> splitresults;
-				StringSplit(sValue, ";", splitresults);
-				if (splitresults.size() < 2)
-					continue;
-				sUsage = splitresults[0];
-				double fValue = atof(splitresults[1].c_str()) * 100;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if (dType == pTypeAirQuality)
-			{
-				sprintf(szTmp, "%d", nValue);
-				sValue = szTmp;
-				m_notifications.CheckAndHandleNotification(ID, hardwareID, DeviceID, devname, Unit, dType, dSubType, (int)nValue);
-			}
-			else if ((dType == pTypeGeneral) && ((dSubType == sTypeSoilMoisture) || (dSubType == sTypeLeafWetness)))
-			{
-				sprintf(szTmp, "%d", nValue);
-				sValue = szTmp;
-			}
-			else if ((dType == pTypeGeneral) && (dSubType == sTypeVisibility))
-			{
-				double fValue = atof(sValue.c_str()) * 10.0F;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if ((dType == pTypeGeneral) && (dSubType == sTypeDistance))
-			{
-				double fValue = atof(sValue.c_str()) * 10.0F;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if ((dType == pTypeGeneral) && (dSubType == sTypeSolarRadiation))
-			{
-				double fValue = atof(sValue.c_str()) * 10.0F;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if ((dType == pTypeGeneral) && (dSubType == sTypeSoundLevel))
-			{
-				double fValue = atof(sValue.c_str()) * 10.0F;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if ((dType == pTypeGeneral) && (dSubType == sTypeKwh))
-			{
-				std::vector<std::string> splitresults;
-				StringSplit(sValue, ";", splitresults);
-				if (splitresults.size() < 2)
-					continue;
-
-				double fValue = atof(splitresults[0].c_str()) * 10.0F;
-				sprintf(szTmp, "%.0f", fValue);
-				sUsage = szTmp;
-
-				fValue = atof(splitresults[1].c_str());
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if (dType == pTypeLux)
-			{
-				double fValue = atof(sValue.c_str());
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if (dType == pTypeWEIGHT)
-			{
-				double fValue = atof(sValue.c_str()) * 10.0F;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if (dType == pTypeRFXSensor)
-			{
-				double fValue = atof(sValue.c_str());
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if ((dType == pTypeGeneral) && (dSubType == sTypeCounterIncremental))
-			{
-				double fValue = atof(sValue.c_str());
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if ((dType == pTypeGeneral) && (dSubType == sTypeVoltage))
-			{
-				double fValue = atof(sValue.c_str()) * 1000.0F;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if ((dType == pTypeGeneral) && (dSubType == sTypeCurrent))
-			{
-				double fValue = atof(sValue.c_str()) * 1000.0F;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if ((dType == pTypeGeneral) && (dSubType == sTypePressure))
-			{
-				double fValue = atof(sValue.c_str()) * 10.0F;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if (dType == pTypeUsage)
-			{
-				double fValue = atof(sValue.c_str()) * 10.0F;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-
-			int64_t MeterValue = 0;
-			int64_t MeterUsage = 0;
-
-			try
-			{
-				MeterUsage = std::stoll(sUsage);
-				MeterValue = std::stoll(sValue);
-			}
-			catch (const std::exception&)
-			{
-				_log.Log(LOG_ERROR, "UpdateMeter: Error converting sValue/sUsage! (IDX: %s, sValue: '%s', sUsage: '%s', dType: %d, sType: %d)", sd[0].c_str(), sValue.c_str(), sUsage.c_str(), dType, dSubType);
-				continue;
-			}
-
-			//insert record
-			safe_query(
-				"INSERT INTO Meter (DeviceRowID, Value, [Usage]) "
-				"VALUES ('%" PRIu64 "', '%" PRId64 "', '%" PRId64 "')",
-				ID,
-				MeterValue,
-				MeterUsage
-			);
-		}
-	}
-}
-
-void CSQLHelper::UpdateMultiMeter()
-{
-	time_t now = mytime(nullptr);
-	if (now == 0)
-		return;
-	struct tm tm1;
-	localtime_r(&now, &tm1);
-
-	int SensorTimeOut = 60;
-	GetPreferencesVar("SensorTimeout", SensorTimeOut);
-
-	std::vector<std::vector<std::string> > result;
-	result = safe_query("SELECT ID,Type,SubType,nValue,sValue,LastUpdate,Options FROM DeviceStatus WHERE (Type=%d OR Type=%d OR Type=%d)",
-		pTypeP1Power,
-		pTypeCURRENT,
-		pTypeCURRENTENERGY
-	);
-	if (!result.empty())
-	{
-		for (const auto &sd : result)
-		{
-			std::string sOptions = sd[6];
-			std::map<std::string, std::string> options = BuildDeviceOptions(sOptions);
-			// We don't want to update meter if externally managed
-			if (options["DisableLogAutoUpdate"] == "true")
-			{
-				continue;
-			}
-
-			uint64_t ID = std::stoull(sd[0]);
-			unsigned char dType = atoi(sd[1].c_str());
-			unsigned char dSubType = atoi(sd[2].c_str());
-			//int nValue=atoi(sd[3].c_str());
-			std::string sValue = sd[4];
-
-			//do not include sensors that have no reading within an hour
-			std::string sLastUpdate = sd[5];
-			struct tm ntime;
-			time_t checktime;
-			ParseSQLdatetime(checktime, ntime, sLastUpdate, tm1.tm_isdst);
-
-			if (difftime(now, checktime) >= SensorTimeOut * 60)
-				continue;
-			if (m_bShortLogAddOnlyNewValues)
+				"WHERE (DeviceRowID=='%" PRIu64 "') AND (Date=='%q')",
+				DeviceRowID, date
+			);
+			if (result.empty())
 			{
-				if (difftime(now, checktime) > m_ShortLogInterval * 60)
-					continue;
+				safe_query(
+					"INSERT INTO MultiMeter_Calendar (DeviceRowID, Value1, Value2, Value3, Value4, Value5, Value6, Counter1, Counter2, Counter3, Counter4, Date) "
+					"VALUES ('%" PRIu64 "', '%" PRId64 "', '%" PRId64 "', '%" PRId64 "', '%" PRId64 "', '%" PRId64 "', '%" PRId64 "', '%" PRId64 "', '%" PRId64 "', '%" PRId64 "', '%" PRId64 "', '%q')",
+					DeviceRowID,
+					(value1 < 0) ? 0 : value1,
+					(value2 < 0) ? 0 : value2,
+					(value3 < 0) ? 0 : value3,
+					(value4 < 0) ? 0 : value4,
+					(value5 < 0) ? 0 : value5,
+					(value6 < 0) ? 0 : value6,
+					(counter1 < 0) ? 0 : counter1,
+					(counter2 < 0) ? 0 : counter2,
+					(counter3 < 0) ? 0 : counter3,
+					(counter4 < 0) ? 0 : counter4,
+					date
+				);
 			}
-
-			std::vector<std::string> splitresults;
-			StringSplit(sValue, ";", splitresults);
-
-			uint64_t value1 = 0;
-			uint64_t value2 = 0;
-			uint64_t value3 = 0;
-			uint64_t value4 = 0;
-			uint64_t value5 = 0;
-			uint64_t value6 = 0;
-
-			if (dType == pTypeP1Power)
+			else
 			{
-				if (splitresults.size() != 6)
-					continue; //impossible
-
-				uint64_t powerusage1 = 0;
-				uint64_t powerusage2 = 0;
-				uint64_t powerdeliv1 = 0;
-				uint64_t powerdeliv2 = 0;
-				uint64_t usagecurrent = 0;
-				uint64_t delivcurrent = 0;
-
-				try
-				{
-					powerusage1 = std::stoull(splitresults[0]);
-					powerusage2 = std::stoull(splitresults[1]);
-					powerdeliv1 = std::stoull(splitresults[2]);
-					powerdeliv2 = std::stoull(splitresults[3]);
-					usagecurrent = std::stoull(splitresults[4]);
-					delivcurrent = std::stoull(splitresults[5]);
-				}
-				catch (const std::exception &)
-				{
-					_log.Log(LOG_ERROR, "UpdateMultiMeter: Error converting sValue values! (IDX: %s, sValue: '%s', dType: %d, sType: %d)", sd[0].c_str(), sValue.c_str(), dType, dSubType);
-					continue;
-				}
-
-				value1 = powerusage1;
-				value2 = powerdeliv1;
-				value5 = powerusage2;
-				value6 = powerdeliv2;
-				value3 = usagecurrent;
-				value4 = delivcurrent;
+				safe_query(
+					"UPDATE MultiMeter_Calendar SET Value1='%" PRId64 "', Value2='%" PRId64 "', Value3='%" PRId64 "', Value4='%" PRId64 "', Value5='%" PRId64 "', Value6='%" PRId64 "' , Counter1='%" PRId64 "' , Counter2='%" PRId64 "' , Counter3='%" PRId64 "' , Counter4='%" PRId64 "' "
+					"WHERE ((DeviceRowID=='%" PRIu64 "') AND (Date=='%q'))",
+					(value1 < 0) ? 0 : value1,
+					(value2 < 0) ? 0 : value2,
+					(value3 < 0) ? 0 : value3,
+					(value4 < 0) ? 0 : value4,
+					(value5 < 0) ? 0 : value5,
+					(value6 < 0) ? 0 : value6,
+					(counter1 < 0) ? 0 : counter1,
+					(counter2 < 0) ? 0 : counter2,
+					(counter3 < 0) ? 0 : counter3,
+					(counter4 < 0) ? 0 : counter4,
+					DeviceRowID,
+					date
+				);
 			}
-			else if ((dType == pTypeCURRENT) && (dSubType == sTypeELEC1))
+		}
+		else {
+			result = safe_query(
+				"SELECT DeviceRowID FROM Meter_Calendar "
+				"WHERE (DeviceRowID=='%" PRIu64 "') AND (Date=='%q')",
+				DeviceRowID, date
+			);
+			if (result.empty())
 			{
-				if (splitresults.size() != 3)
-					continue; //impossible
-
-				value1 = (unsigned long)(atof(splitresults[0].c_str()) * 10.0F);
-				value2 = (unsigned long)(atof(splitresults[1].c_str()) * 10.0F);
-				value3 = (unsigned long)(atof(splitresults[2].c_str()) * 10.0F);
+				safe_query(
+					"INSERT INTO Meter_Calendar (DeviceRowID, Counter, Value, Date) "
+					"VALUES ('%" PRIu64 "', '%" PRId64 "', '%" PRId64 "', '%q')",
+					DeviceRowID, (value1 < 0) ? 0 : value1, (value2 < 0) ? 0 : value2, date
+				);
 			}
-			else if ((dType == pTypeCURRENTENERGY) && (dSubType == sTypeELEC4))
+			else
 			{
-				if (splitresults.size() != 4)
-					continue; //impossible
-
-				value1 = (unsigned long)(atof(splitresults[0].c_str()) * 10.0F);
-				value2 = (unsigned long)(atof(splitresults[1].c_str()) * 10.0F);
-				value3 = (unsigned long)(atof(splitresults[2].c_str()) * 10.0F);
-				value4 = (uint64_t)(atof(splitresults[3].c_str()) * 1000.0F);
+				safe_query(
+					"UPDATE Meter_Calendar SET DeviceRowID='%" PRIu64 "', Counter='%" PRId64 "', Value='%" PRId64 "', Date='%q' "
+					"WHERE (DeviceRowID=='%" PRIu64 "') AND (Date=='%q')",
+					DeviceRowID, (value1 < 0) ? 0 : value1, (value2 < 0) ? 0 : value2, date,
+					DeviceRowID, date
+				);
 			}
-			else
-				continue;//don't know you (yet)
-
-			//insert record
-			safe_query(
-				"INSERT INTO MultiMeter (DeviceRowID, Value1, Value2, Value3, Value4, Value5, Value6) "
-				"VALUES ('%" PRIu64 "', '%" PRIu64 "', '%" PRIu64 "', '%" PRIu64 "', '%" PRIu64 "', '%" PRIu64 "', '%" PRIu64 "')",
-				ID,
-				value1,
-				value2,
-				value3,
-				value4,
-				value5,
-				value6
-			);
 		}
 	}
+	return true;
 }
 
-void CSQLHelper::UpdatePercentageLog()
-{
-	time_t now = mytime(nullptr);
-	if (now == 0)
-		return;
-	struct tm tm1;
-	localtime_r(&now, &tm1);
-
-	int SensorTimeOut = 60;
-	GetPreferencesVar("SensorTimeout", SensorTimeOut);
-
-	std::vector<std::vector<std::string> > result;
-	result = safe_query("SELECT ID,Type,SubType,nValue,sValue,LastUpdate FROM DeviceStatus WHERE (Type=%d AND SubType=%d) OR (Type=%d AND SubType=%d) OR (Type=%d AND SubType=%d)",
-		pTypeGeneral, sTypePercentage,
-		pTypeGeneral, sTypeWaterflow,
-		pTypeGeneral, sTypeCustom
-	);
-	if (!result.empty())
-	{
-		for (const auto &sd : result)
-		{
-			uint64_t ID = std::stoull(sd[0]);
-
-			//unsigned char dType=atoi(sd[1].c_str());
-			//unsigned char dSubType=atoi(sd[2].c_str());
-			//int nValue=atoi(sd[3].c_str());
-			std::string sValue = sd[4];
-
-			//do not include sensors that have no reading within an hour
-			std::string sLastUpdate = sd[5];
-			struct tm ntime;
-			time_t checktime;
-			ParseSQLdatetime(checktime, ntime, sLastUpdate, tm1.tm_isdst);
-
-			if (difftime(now, checktime) >= SensorTimeOut * 60)
-				continue;
-			if (m_bShortLogAddOnlyNewValues)
-			{
-				if (difftime(now, checktime) > m_ShortLogInterval * 60)
-					continue;
-			}
-
-			std::vector<std::string> splitresults;
-			StringSplit(sValue, ";", splitresults);
-			if (splitresults.empty())
-				continue; //impossible
-
-			float percentage = static_cast<float>(atof(sValue.c_str()));
-
-			//insert record
-			safe_query(
-				"INSERT INTO Percentage (DeviceRowID, Percentage) "
-				"VALUES ('%" PRIu64 "', '%g')",
-				ID,
-				percentage
-			);
-		}
-	}
+//The triggers keep ShortLogRollup in sync with every row written to a short log table,
+//rows that are changed or deleted afterwards mark that day as dirty
+void CSQLHelper::CreateShortLogRollupTriggers()
+{
+	for (const auto& itt : ShortLogRollupTables)
+	{
+		const std::string& szTable = itt.first;
+		const std::string szWhere = "WHERE (Source='" + szTable + "') AND (DeviceRowID=%s.DeviceRowID) AND (Date=date(%s.Date));\n";
+
+		std::string szSet = "[Count]=[Count]+1";
+		for (size_t ii = 0; ii < itt.second.size(); ii++)
+		{
+			const std::string szNew = "NEW.[" + itt.second[ii] + "]";
+			const int iSlot = static_cast<int>(ii) + 1;
+			szSet += std_format(", Min%d=min(ifnull(Min%d, %s), %s)", iSlot, iSlot, szNew.c_str(), szNew.c_str());
+			szSet += std_format(", Max%d=max(ifnull(Max%d, %s), %s)", iSlot, iSlot, szNew.c_str(), szNew.c_str());
+			szSet += std_format(", Sum%d=Sum%d+%s", iSlot, iSlot, szNew.c_str());
+			if (ii < 2)
+				szSet += std_format(", Last%d=CASE WHEN (LastDate IS NULL) OR (NEW.Date >= LastDate) THEN %s ELSE Last%d END", iSlot, szNew.c_str(), iSlot);
+		}
+		szSet += ", First1=CASE WHEN (FirstDate IS NULL) OR (NEW.Date < FirstDate) THEN NEW.[" + itt.second[0] + "] ELSE First1 END";
+		szSet += ", FirstDate=CASE WHEN (FirstDate IS NULL) OR (NEW.Date < FirstDate) THEN NEW.Date ELSE FirstDate END";
+		szSet += ", LastDate=CASE WHEN (LastDate IS NULL) OR (NEW.Date >= LastDate) THEN NEW.Date ELSE LastDate END";
+
+		query(
+			"CREATE TRIGGER IF NOT EXISTS " + szTable + "_rollup_insert AFTER INSERT ON " + szTable + "\n"
+			"BEGIN\n"
+			"	INSERT OR IGNORE INTO ShortLogRollup (Source, DeviceRowID, Date) VALUES ('" + szTable + "', NEW.DeviceRowID, date(NEW.Date));\n"
+			"	UPDATE ShortLogRollup SET " + szSet + " " + std_format(szWhere.c_str(), "NEW", "NEW") +
+			"END;\n");
+		query(
+			"CREATE TRIGGER IF NOT EXISTS " + szTable + "_rollup_update AFTER UPDATE ON " + szTable + "\n"
+			"BEGIN\n"
+			"	UPDATE ShortLogRollup SET Dirty=1 " + std_format(szWhere.c_str(), "OLD", "OLD") +
+			"	UPDATE ShortLogRollup SET Dirty=1 " + std_format(szWhere.c_str(), "NEW", "NEW") +
+			"END;\n");
+		query(
+			"CREATE TRIGGER IF NOT EXISTS " + szTable + "_rollup_delete AFTER DELETE ON " + szTable + "\n"
+			"BEGIN\n"
+			"	UPDATE ShortLogRollup SET Dirty=1 " + std_format(szWhere.c_str(), "OLD", "OLD") +
+			"END;\n");
+	}
+}
+
+//Returns the usable day totals of one short log table, devices that are missing need to be aggregated from the table itself
+void CSQLHelper::GetShortLogRollups(const char* szSource, const char* szDate, std::map<uint64_t, _tShortLogRollup>& rollups)
+{
+	prepared_query(
+		"SELECT DeviceRowID, [Count], Min1, Min2, Min3, Min4, Min5, Min6, Max1, Max2, Max3, Max4, Max5, Max6, Sum1, Sum2, Sum3, Sum4, Sum5, Sum6, First1, Last1, Last2 "
+		"FROM ShortLogRollup WHERE (Source=?) AND (Date=?) AND (Dirty=0) AND ([Count]>0)",
+		[&](const CSQLRow& row) {
+			_tShortLogRollup& rollup = rollups[static_cast<uint64_t>(row.GetInt64(0))];
+			rollup.Count = row.GetInt(1);
+			for (int ii = 0; ii < 6; ii++)
+			{
+				rollup.Min[ii] = row.GetDouble(2 + ii);
+				rollup.Max[ii] = row.GetDouble(8 + ii);
+				rollup.Sum[ii] = row.GetDouble(14 + ii);
+			}
+			rollup.First1 = row.GetDouble(20);
+			rollup.Last1 = row.GetDouble(21);
+			rollup.Last2 = row.GetDouble(22);
+			return true;
+		},
+		szSource, szDate);
 }
 
-void CSQLHelper::UpdateFanLog()
+//Formats an accumulated value like the aggregate query results it replaces
+static std::string RollupValue(const double value)
 {
-	time_t now = mytime(nullptr);
-	if (now == 0)
-		return;
-	struct tm tm1;
-	localtime_r(&now, &tm1);
-
-	int SensorTimeOut = 60;
-	GetPreferencesVar("SensorTimeout", SensorTimeOut);
-
-	std::vector<std::vector<std::string> > result;
-	result = safe_query("SELECT ID,Type,SubType,nValue,sValue,LastUpdate FROM DeviceStatus WHERE (Type=%d AND SubType=%d)",
-		pTypeGeneral, sTypeFan
-	);
-	if (!result.empty())
-	{
-		for (const auto &sd : result)
-		{
-			uint64_t ID = std::stoull(sd[0]);
-
-			//unsigned char dType=atoi(sd[1].c_str());
-			//unsigned char dSubType=atoi(sd[2].c_str());
-			//int nValue=atoi(sd[3].c_str());
-			std::string sValue = sd[4];
-
-			//do not include sensors that have no reading within an hour
-			std::string sLastUpdate = sd[5];
-			struct tm ntime;
-			time_t checktime;
-			ParseSQLdatetime(checktime, ntime, sLastUpdate, tm1.tm_isdst);
-
-			if (difftime(now, checktime) >= SensorTimeOut * 60)
-				continue;
-			if (m_bShortLogAddOnlyNewValues)
-			{
-				if (difftime(now, checktime) > m_ShortLogInterval * 60)
-					continue;
-			}
-
-			std::vector<std::string> splitresults;
-			StringSplit(sValue, ";", splitresults);
-			if (splitresults.empty())
-				continue; //impossible
-
-			int speed = (int)atoi(sValue.c_str());
-
-			//insert record
-			safe_query(
-				"INSERT INTO Fan (DeviceRowID, Speed) "
-				"VALUES ('%" PRIu64 "', '%d')",
-				ID,
-				speed
-			);
-		}
-	}
+	return std_format("%.15g", value);
 }
 
 void CSQLHelper::AddCalendarTemperature()
@@ -7081,15 +7972,27 @@ void CSQLHelper::AddCalendarTemperature()
 
 	std::vector<std::vector<std::string> > result;
 
+	std::map<uint64_t, _tShortLogRollup> rollups;
+	GetShortLogRollups("Temperature", szDateStart, rollups);
+
 	for (const auto &sddev : resultdevices)
 	{
 		uint64_t ID = std::stoull(sddev[0]);
 
-		result = safe_query("SELECT MIN(Temperature), MAX(Temperature), AVG(Temperature), MIN(Chill), MAX(Chill), AVG(Humidity), AVG(Barometer), MIN(DewPoint), MIN(SetPoint), MAX(SetPoint), AVG(SetPoint) FROM Temperature WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00')",
-			ID,
-			szDateStart,
-			szDateEnd
-		);
+		auto ittRollup = rollups.find(ID);
+		if (ittRollup != rollups.end())
+		{
+			const _tShortLogRollup& rollup = ittRollup->second;
+			result = { { RollupValue(rollup.Min[0]), RollupValue(rollup.Max[0]), RollupValue(rollup.Sum[0] / rollup.Count), RollupValue(rollup.Min[1]), RollupValue(rollup.Max[1]), RollupValue(rollup.Sum[2] / rollup.Count), RollupValue(rollup.Sum[3] / rollup.Count), RollupValue(rollup.Min[4]), RollupValue(rollup.Min[5]), RollupValue(rollup.Max[5]), RollupValue(rollup.Sum[5] / rollup.Count) } };
+		}
+		else
+		{
+			result = safe_query("SELECT MIN(Temperature), MAX(Temperature), AVG(Temperature), MIN(Chill), MAX(Chill), AVG(Humidity), AVG(Barometer), MIN(DewPoint), MIN(SetPoint), MAX(SetPoint), AVG(SetPoint) FROM Temperature WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00')",
+				ID,
+				szDateStart,
+				szDateEnd
+			);
+		}
 		if (!result.empty())
 		{
 			std::vector<std::string> sd = result[0];
@@ -7149,6 +8052,9 @@ void CSQLHelper::AddCalendarUpdateRain()
 
 	std::vector<std::vector<std::string> > result;
 
+	std::map<uint64_t, _tShortLogRollup> rollups;
+	GetShortLogRollups("Rain", szDateStart, rollups);
+
 	for (const auto &sddev : resultdevices)
 	{
 		uint64_t ID = std::stoull(sddev[0]);
@@ -7161,7 +8067,16 @@ void CSQLHelper::AddCalendarUpdateRain()
 
 		unsigned char subType = atoi(sd[0].c_str());
 
-		if (subType == sTypeRAINWU || subType == sTypeRAINByRate)
+		auto ittRollup = rollups.find(ID);
+		if (ittRollup != rollups.end())
+		{
+			const _tShortLogRollup& rollup = ittRollup->second;
+			if (subType == sTypeRAINWU || subType == sTypeRAINByRate)
+				result = { { RollupValue(rollup.Last1), RollupValue(rollup.Last1), RollupValue(rollup.Last2) } };
+			else
+				result = { { RollupValue(rollup.Min[0]), RollupValue(rollup.Max[0]), RollupValue(rollup.Max[1]) } };
+		}
+		else if (subType == sTypeRAINWU || subType == sTypeRAINByRate)
 		{
 			result = safe_query("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00') ORDER BY ROWID DESC LIMIT 1",
 				ID,
@@ -7252,6 +8167,9 @@ void CSQLHelper::AddCalendarUpdateMeter()
 
 	std::vector<std::vector<std::string> > result;
 
+	std::map<uint64_t, _tShortLogRollup> rollups;
+	GetShortLogRollups("Meter", szDateStart, rollups);
+
 	for (const auto &sddev : resultdevices)
 	{
 		uint64_t ID = std::stoull(sddev[0]);
@@ -7294,11 +8212,20 @@ void CSQLHelper::AddCalendarUpdateMeter()
 			metertype = MTYPE_COUNTER;
 		}
 
-		result = safe_query("SELECT MIN(Value), MAX(Value), AVG(Value) FROM Meter WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00')",
-			ID,
-			szDateStart,
-			szDateEnd
-		);
+		auto ittRollup = rollups.find(ID);
+		if (ittRollup != rollups.end())
+		{
+			const _tShortLogRollup& rollup = ittRollup->second;
+			result = { { RollupValue(rollup.Min[0]), RollupValue(rollup.Max[0]), RollupValue(rollup.Sum[0] / rollup.Count) } };
+		}
+		else
+		{
+			result = safe_query("SELECT MIN(Value), MAX(Value), AVG(Value) FROM Meter WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00')",
+				ID,
+				szDateStart,
+				szDateEnd
+			);
+		}
 
 		if (!result.empty())
 		{
@@ -7312,20 +8239,28 @@ void CSQLHelper::AddCalendarUpdateMeter()
 			// because last value can be lower than first value when consumed energy is negative (e.g. photovoltaic produces more than building usage)
 			if (((devType == pTypeGeneral) && ((subType == sTypeKwh) || (subType == sTypeCounterIncremental))) || ((devType == pTypeRFXMeter) && (subType == sTypeRFXMeterCount)))
 			{
-				result = safe_query("SELECT Value FROM Meter WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00') ORDER BY Date ASC LIMIT 1",
-						ID, szDateStart, szDateEnd );
-				if (!result.empty())
+				if (ittRollup != rollups.end())
 				{
-					std::vector<std::string> sd = result[0];
-					total_min = (double)atof(sd[0].c_str());
-					total_max = total_min;
+					total_min = ittRollup->second.First1;
+					total_max = ittRollup->second.Last1;
 				}
-				result = safe_query("SELECT Value FROM Meter WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00') ORDER BY Date DESC LIMIT 1",
-						ID, szDateStart, szDateEnd );
-				if (!result.empty())
+				else
 				{
-					std::vector<std::string> sd = result[0];
-					total_max = (double)atof(sd[0].c_str());
+					result = safe_query("SELECT Value FROM Meter WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00') ORDER BY Date ASC LIMIT 1",
+							ID, szDateStart, szDateEnd );
+					if (!result.empty())
+					{
+						std::vector<std::string> sd = result[0];
+						total_min = (double)atof(sd[0].c_str());
+						total_max = total_min;
+					}
+					result = safe_query("SELECT Value FROM Meter WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00') ORDER BY Date DESC LIMIT 1",
+							ID, szDateStart, szDateEnd );
+					if (!result.empty())
+					{
+						std::vector<std::string> sd = result[0];
+						total_max = (double)atof(sd[0].c_str());
+					}
 				}
 			}
 
@@ -7464,6 +8399,9 @@ void CSQLHelper::AddCalendarUpdateMultiMeter()
 
 	std::vector<std::vector<std::string> > result;
 
+	std::map<uint64_t, _tShortLogRollup> rollups;
+	GetShortLogRollups("MultiMeter", szDateStart, rollups);
+
 	for (const auto &sddev : resultdevices)
 	{
 		uint64_t ID = std::stoull(sddev[0]);
@@ -7491,12 +8429,21 @@ void CSQLHelper::AddCalendarUpdateMultiMeter()
 		//_eSwitchType switchtype=(_eSwitchType) atoi(sd[6].c_str());
 		//_eMeterType metertype=(_eMeterType)switchtype;
 
-		result = safe_query(
-			"SELECT MIN(Value1), MAX(Value1), MIN(Value2), MAX(Value2), MIN(Value3), MAX(Value3), MIN(Value4), MAX(Value4), MIN(Value5), MAX(Value5), MIN(Value6), MAX(Value6) FROM MultiMeter WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00')",
-			ID,
-			szDateStart,
-			szDateEnd
-		);
+		auto ittRollup = rollups.find(ID);
+		if (ittRollup != rollups.end())
+		{
+			const _tShortLogRollup& rollup = ittRollup->second;
+			result = { { RollupValue(rollup.Min[0]), RollupValue(rollup.Max[0]), RollupValue(rollup.Min[1]), RollupValue(rollup.Max[1]), RollupValue(rollup.Min[2]), RollupValue(rollup.Max[2]), RollupValue(rollup.Min[3]), RollupValue(rollup.Max[3]), RollupValue(rollup.Min[4]), RollupValue(rollup.Max[4]), RollupValue(rollup.Min[5]), RollupValue(rollup.Max[5]) } };
+		}
+		else
+		{
+			result = safe_query(
+				"SELECT MIN(Value1), MAX(Value1), MIN(Value2), MAX(Value2), MIN(Value3), MAX(Value3), MIN(Value4), MAX(Value4), MIN(Value5), MAX(Value5), MIN(Value6), MAX(Value6) FROM MultiMeter WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00')",
+				ID,
+				szDateStart,
+				szDateEnd
+			);
+		}
 		if (!result.empty())
 		{
 			std::vector<std::string> sd = result[0];
@@ -7595,15 +8542,27 @@ void CSQLHelper::AddCalendarUpdateWind()
 
 	std::vector<std::vector<std::string> > result;
 
+	std::map<uint64_t, _tShortLogRollup> rollups;
+	GetShortLogRollups("Wind", szDateStart, rollups);
+
 	for (const auto &sddev : resultdevices)
 	{
 		uint64_t ID = std::stoull(sddev[0]);
 
-		result = safe_query("SELECT AVG(Direction), MIN(Speed), MAX(Speed), MIN(Gust), MAX(Gust) FROM Wind WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00')",
-			ID,
-			szDateStart,
-			szDateEnd
-		);
+		auto ittRollup = rollups.find(ID);
+		if (ittRollup != rollups.end())
+		{
+			const _tShortLogRollup& rollup = ittRollup->second;
+			result = { { RollupValue(rollup.Sum[0] / rollup.Count), RollupValue(rollup.Min[1]), RollupValue(rollup.Max[1]), RollupValue(rollup.Min[2]), RollupValue(rollup.Max[2]) } };
+		}
+		else
+		{
+			result = safe_query("SELECT AVG(Direction), MIN(Speed), MAX(Speed), MIN(Gust), MAX(Gust) FROM Wind WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00')",
+				ID,
+				szDateStart,
+				szDateEnd
+			);
+		}
 		if (!result.empty())
 		{
 			std::vector<std::string> sd = result[0];
@@ -7652,15 +8611,27 @@ void CSQLHelper::AddCalendarUpdateUV()
 
 	std::vector<std::vector<std::string> > result;
 
+	std::map<uint64_t, _tShortLogRollup> rollups;
+	GetShortLogRollups("UV", szDateStart, rollups);
+
 	for (const auto &sddev : resultdevices)
 	{
 		uint64_t ID = std::stoull(sddev[0]);
 
-		result = safe_query("SELECT MAX(Level) FROM UV WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00')",
-			ID,
-			szDateStart,
-			szDateEnd
-		);
+		auto ittRollup = rollups.find(ID);
+		if (ittRollup != rollups.end())
+		{
+			const _tShortLogRollup& rollup = ittRollup->second;
+			result = { { RollupValue(rollup.Max[0]) } };
+		}
+		else
+		{
+			result = safe_query("SELECT MAX(Level) FROM UV WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00')",
+				ID,
+				szDateStart,
+				szDateEnd
+			);
+		}
 		if (!result.empty())
 		{
 			std::vector<std::string> sd = result[0];
@@ -7701,15 +8672,27 @@ void CSQLHelper::AddCalendarUpdatePercentage()
 
 	std::vector<std::vector<std::string> > result;
 
+	std::map<uint64_t, _tShortLogRollup> rollups;
+	GetShortLogRollups("Percentage", szDateStart, rollups);
+
 	for (const auto &sddev : resultdevices)
 	{
 		uint64_t ID = std::stoull(sddev[0]);
 
-		result = safe_query("SELECT MIN(Percentage), MAX(Percentage), AVG(Percentage) FROM Percentage WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00')",
-			ID,
-			szDateStart,
-			szDateEnd
-		);
+		auto ittRollup = rollups.find(ID);
+		if (ittRollup != rollups.end())
+		{
+			const _tShortLogRollup& rollup = ittRollup->second;
+			result = { { RollupValue(rollup.Min[0]), RollupValue(rollup.Max[0]), RollupValue(rollup.Sum[0] / rollup.Count) } };
+		}
+		else
+		{
+			result = safe_query("SELECT MIN(Percentage), MAX(Percentage), AVG(Percentage) FROM Percentage WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00')",
+				ID,
+				szDateStart,
+				szDateEnd
+			);
+		}
 		if (!result.empty())
 		{
 			std::vector<std::string> sd = result[0];
@@ -7753,15 +8736,27 @@ void CSQLHelper::AddCalendarUpdateFan()
 
 	std::vector<std::vector<std::string> > result;
 
+	std::map<uint64_t, _tShortLogRollup> rollups;
+	GetShortLogRollups("Fan", szDateStart, rollups);
+
 	for (const auto &sddev : resultdevices)
 	{
 		uint64_t ID = std::stoull(sddev[0]);
 
-		result = safe_query("SELECT MIN(Speed), MAX(Speed), AVG(Speed) FROM Fan WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00')",
-			ID,
-			szDateStart,
-			szDateEnd
-		);
+		auto ittRollup = rollups.find(ID);
+		if (ittRollup != rollups.end())
+		{
+			const _tShortLogRollup& rollup = ittRollup->second;
+			result = { { RollupValue(rollup.Min[0]), RollupValue(rollup.Max[0]), RollupValue(rollup.Sum[0] / rollup.Count) } };
+		}
+		else
+		{
+			result = safe_query("SELECT MIN(Speed), MAX(Speed), AVG(Speed) FROM Fan WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00')",
+				ID,
+				szDateStart,
+				szDateEnd
+			);
+		}
 		if (!result.empty())
 		{
 			std::vector<std::string> sd = result[0];
@@ -7802,32 +8797,23 @@ void CSQLHelper::CleanupShortLog()
 		_log.Log(LOG_STATUS, "Cleaning up shortlog older than %s", szDateStr);
 #endif
 
-		char szQuery[250];
 		std::string szQueryFilter = "strftime('%s',datetime('now','localtime')) - strftime('%s',Date) > (SELECT p.nValue * 86400 From Preferences AS p WHERE p.Key='5MinuteHistoryDays')";
 
-		sprintf(szQuery, "DELETE FROM Temperature WHERE %s", szQueryFilter.c_str());
-		query(szQuery);
-
-		sprintf(szQuery, "DELETE FROM Rain WHERE %s", szQueryFilter.c_str());
-		query(szQuery);
-
-		sprintf(szQuery, "DELETE FROM Wind WHERE %s", szQueryFilter.c_str());
-		query(szQuery);
-
-		sprintf(szQuery, "DELETE FROM UV WHERE %s", szQueryFilter.c_str());
-		query(szQuery);
-
-		sprintf(szQuery, "DELETE FROM Meter WHERE %s", szQueryFilter.c_str());
-		query(szQuery);
-
-		sprintf(szQuery, "DELETE FROM MultiMeter WHERE %s", szQueryFilter.c_str());
-		query(szQuery);
-
-		sprintf(szQuery, "DELETE FROM Percentage WHERE %s", szQueryFilter.c_str());
-		query(szQuery);
-
-		sprintf(szQuery, "DELETE FROM Fan WHERE %s", szQueryFilter.c_str());
-		query(szQuery);
+		static const char* szShortLogTables[] = { "Temperature", "Rain", "Wind", "UV", "Meter", "MultiMeter", "Percentage", "Fan" };
+		for (const auto szTable : szShortLogTables)
+		{
+			std::string szQuery = std_format("DELETE FROM %s WHERE %s", szTable, szQueryFilter.c_str());
+			std::unique_lock<std::mutex> l(m_sqlQueryMutex, std::defer_lock);
+			LockWriter(l);
+			std::vector<std::vector<std::string> > result;
+			fetch_rows(m_dbase, szQuery, result);
+			//Only rows of at least a day old are deleted, these are not part of today's counters or the device list
+			_tDataChanges changes;
+			TakeDataChanges(changes);
+			changes.bShortLog = false;
+			l.unlock();
+			ApplyDataChanges(changes);
+		}
 	}
 }
 
@@ -7918,7 +8904,7 @@ void CSQLHelper::DeleteDevices(const std::string& idx)
 			std::string HwID = sd[0];
 			std::string DeviceID = sd[1];
 			std::string Unit = sd[2];
-			CDomoticzHardwareBase *pHardware = m_mainworker.GetHardwareByIDType(HwID, HTYPE_PythonPlugin);
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardwareByIDType(HwID, HTYPE_PythonPlugin);
 			if (pHardware != nullptr)
 			{
 				removeddevices.insert(std::make_tuple(HwID, DeviceID, Unit));
@@ -7926,6 +8912,7 @@ void CSQLHelper::DeleteDevices(const std::string& idx)
 		}
 	}
 #endif
+	_tDataChanges changes;
 	{
 		//Avoid mutex deadlock here
 		std::lock_guard<std::mutex> l(m_sqlQueryMutex);
@@ -7970,7 +8957,9 @@ void CSQLHelper::DeleteDevices(const std::string& idx)
 			safe_exec_no_return("DELETE FROM DeviceStatus WHERE (ID == '%q')", str.c_str());
 		}
 		sqlite3_exec(m_dbase, "COMMIT TRANSACTION", nullptr, nullptr, &errorMessage);
+		TakeDataChanges(changes);
 	}
+	ApplyDataChanges(changes);
 #ifdef ENABLE_PYTHON
 	for (const auto& it : removeddevices)
 	{
@@ -7978,11 +8967,11 @@ void CSQLHelper::DeleteDevices(const std::string& idx)
 		std::string DeviceID = std::get<1>(it);
 		int Unit = atoi(std::get<2>(it).c_str());
 		// Notify plugin to sync plugins' device list
-		CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(HwID);
+		std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(HwID);
 		if (pHardware != nullptr && pHardware->HwdType == HTYPE_PythonPlugin)
 		{
 			_log.Debug(DEBUG_NORM, "CSQLHelper::DeleteDevices: Notifying plugin %u about deletion of device %u", HwID, Unit);
-			Plugins::CPlugin* pPlugin = (Plugins::CPlugin*)pHardware;
+			Plugins::CPlugin* pPlugin = (Plugins::CPlugin*)pHardware.get();
 			pPlugin->DeviceRemoved(DeviceID, Unit);
 		}
 	}
@@ -7998,6 +8987,7 @@ void CSQLHelper::DeleteScenes(const std::string& idx)
 	StringSplit(idx, ";", _idx);
 	if (_idx.empty())
 		return;
+	_tDataChanges changes;
 	{
 		//Avoid mutex deadlock here
 		std::lock_guard<std::mutex> l(m_sqlQueryMutex);
@@ -8016,7 +9006,9 @@ void CSQLHelper::DeleteScenes(const std::string& idx)
 		}
 
 		sqlite3_exec(m_dbase, "COMMIT TRANSACTION", nullptr, nullptr, &errorMessage);
+		TakeDataChanges(changes);
 	}
+	ApplyDataChanges(changes);
 
 	m_notifications.ReloadNotifications();
 }
@@ -8320,10 +9312,22 @@ bool CSQLHelper::RestoreDatabase(const std::string& dbase)
 	std::remove(outputfile.c_str());
 
 	StopThread();
+	//pending updates belong to the old database
+	{
+		std::lock_guard<std::mutex> l(m_device_status_journal_mutex);
+		m_device_status_journal.clear();
+	}
 
 	//stop database
-	sqlite3_close(m_dbase);
+	{
+		std::lock_guard<std::mutex> l(m_sqlQueryMutex);
+		CloseReadConnections();
+		ClearStatementCache();
+		ClearDeviceIndex();
+		sqlite3_close(m_dbase);
+	}
 	m_dbase = nullptr;
+	ClearPreferences();
 	std::ofstream outfile2;
 	outfile2.open(m_dbase_name.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
 	if (!outfile2.is_open())
@@ -8363,6 +9367,9 @@ bool CSQLHelper::BackupDatabase(const std::string& OutputFile)
 	if (!m_dbase)
 		return false; //database not open!
 
+	//Make sure all pending updates are in the backup
+	FlushDeviceStatusJournal();
+
 	//First cleanup the database
 	OptimizeDatabase(m_dbase);
 	VacuumDatabase();
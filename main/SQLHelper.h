@@ -1,6 +1,12 @@
 #pragma once
 
 #include <string>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <boost/functional/hash.hpp>
 #include "RFXNames.h"
 #include "../hardware/hardwaretypes.h"
 #include "Helper.h"
@@ -342,6 +348,62 @@ class CSQLStatement
 	~CSQLStatement();
 };
 
+// typed accessor for the current row of a (cached) prepared statement
+// values are read directly from sqlite, nothing is copied unless asked for
+class CSQLRow
+{
+      public:
+	explicit CSQLRow(sqlite3_stmt *pStatement)
+		: m_Statement(pStatement)
+	{
+	}
+	int ColumnCount() const;
+	bool IsNull(int col) const;
+	int GetInt(int col) const;
+	int64_t GetInt64(int col) const;
+	double GetDouble(int col) const;
+	// returned pointer is only valid until the next row is fetched
+	const char *GetText(int col) const;
+	std::string GetString(int col) const;
+
+      private:
+	sqlite3_stmt *m_Statement;
+};
+
+// return false to stop fetching further rows
+typedef std::function<bool(const CSQLRow &row)> TSqlRowCallback;
+typedef std::function<void(const std::string &Key, int nValue, const std::string &sValue)> TPreferenceCallback;
+
+struct _tDeviceIndexStats
+{
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t invalidations;
+	size_t size;
+};
+
+struct _tSQLConnectionStats
+{
+	std::string name;
+	uint64_t queries;
+	uint64_t waits; // number of queries that had to wait for the connection
+};
+
+// Lowest and highest values logged today for a Meter, Rain or MultiMeter device, in the column order of the table
+struct _tPreferenceValue
+{
+	std::string Key;
+	int nValue;
+	std::string sValue;
+};
+
+struct _tTodayCounter
+{
+	int Count = 0; // rows logged today
+	double Min[6] = {};
+	double Max[6] = {};
+};
+
 class CSQLHelper : public StoppableTask
 {
       public:
@@ -350,11 +412,14 @@ class CSQLHelper : public StoppableTask
 
 	void SetDatabaseName(const std::string &DBName);
 	void SetJournalMode(const std::string &mode);
+	void SetReadConnections(int nConnections);
+	void SetDeviceStatusWriteBehind(int iIntervalMs, int iMaxRows);
 
 	bool OpenDatabase();
 	void CloseDatabase();
 
 	bool BackupDatabase(const std::string &OutputFile);
+	void FlushDeviceStatusJournal();
 	bool RestoreDatabase(const std::string &dbase);
 
 	// Returns DeviceRowID
@@ -393,9 +458,19 @@ class CSQLHelper : public StoppableTask
 	void UpdatePreferencesVar(const std::string &Key, const std::string &sValue);
 	void UpdatePreferencesVar(const std::string &Key, int nValue);
 	void UpdatePreferencesVar(const std::string &Key, int nValue, const std::string &sValue);
+	// Writes several preferences in one transaction, they are published to the readers at once
+	void UpdatePreferencesVars(const std::vector<_tPreferenceValue> &values);
 	bool GetPreferencesVar(const std::string &Key, int &nValue, std::string &sValue);
 	bool GetPreferencesVar(const std::string &Key, int &nValue);
 	bool GetPreferencesVar(const std::string &Key, std::string &sValue);
+	// Typed preference reads, Default is returned when the key does not exist
+	int GetPreferencesInt(const std::string &Key, int Default);
+	double GetPreferencesDouble(const std::string &Key, double Default);
+	std::string GetPreferencesString(const std::string &Key, const std::string &Default);
+	// Calls the callback after a preference (Key empty: any preference) is written through UpdatePreferencesVar(s),
+	// returns the id to pass to UnsubscribePreferences
+	int SubscribePreferences(const std::string &Key, const TPreferenceCallback &callback);
+	void UnsubscribePreferences(int id);
 
 	int GetLastBackupNo(const char *Key, int &nValue);
 	void SetLastBackupNo(const char *Key, int nValue);
@@ -443,10 +518,43 @@ class CSQLHelper : public StoppableTask
 	int execute_sql(const std::string &sSQL, std::vector<std::string> *pValues, bool bLogError);
 	std::vector<std::vector<std::string>> safe_query(const char *fmt, ...);
 	std::vector<std::vector<std::string>> safe_queryBlob(const char *fmt, ...);
+	// SELECT only, executed on one of the read-only connections (WAL mode) so it does not wait for writers
+	std::vector<std::vector<std::string>> safe_query_readonly(const char *fmt, ...);
+	std::vector<_tSQLConnectionStats> GetConnectionStats();
+	// Returns the DeviceStatus LastUpdate that is not yet written to the database (write-behind mode)
+	bool GetPendingDeviceLastUpdate(uint64_t ulID, std::string &sLastUpdate);
+
+	_tDeviceIndexStats GetDeviceIndexStats();
+	void ClearDeviceIndex();
+
+	// Device list change tracking, increases on every change that can alter the JSon device list
+	uint64_t GetDeviceListVersion();
+	// Fills ulIDs with the DeviceStatus rows changed after Version,
+	// returns false when a change since then could not be attributed to single devices
+	bool GetChangedDevices(uint64_t Version, std::vector<uint64_t> &ulIDs);
+	// Today's values of a device in the Meter, Rain or MultiMeter table (szTable), read once and then kept
+	// up to date by the short log writes, returns false when nothing was logged today
+	bool GetTodayCounter(const char *szTable, uint64_t DeviceRowID, _tTodayCounter &counter);
 	void safe_exec_no_return(const char *fmt, ...);
 	bool safe_UpdateBlobInTableWithID(const std::string &Table, const std::string &Column, const std::string &sID, const std::string &BlobData);
 	bool DoesColumnExistsInTable(const std::string &columnname, const std::string &tablename);
 
+	// Prepared statement variants, the statement is prepared once and cached by its SQL text.
+	// Use '?' placeholders, parameters are bound in order (int, int64_t, uint64_t, double, const char*, std::string)
+	// Pending DeviceStatus write-behind values are written first when the statement uses them
+	// The callback is called after the database has been released, so it may issue queries itself
+	template <typename... Args> bool prepared_query(const char *szSQL, const TSqlRowCallback &callback, const Args &...args)
+	{
+		_tDataChanges changes;
+		bool bResult = prepared_query_int(changes, szSQL, callback, args...);
+		ApplyDataChanges(changes);
+		return bResult;
+	}
+	template <typename... Args> bool prepared_exec(const char *szSQL, const Args &...args)
+	{
+		return prepared_query(szSQL, nullptr, args...);
+	}
+
 	bool AddUserVariable(const std::string &varname, _eUsrVariableType eVartype, const std::string &varvalue, std::string &errorMessage);
 	bool UpdateUserVariable(const std::string &idx, const std::string &varname, _eUsrVariableType eVartype, const std::string &varvalue, bool eventtrigger, std::string &errorMessage);
 	void DeleteUserVariable(const std::string &idx);
@@ -500,11 +608,133 @@ class CSQLHelper : public StoppableTask
 	double m_max_kwh_usage;
 
       private:
+	struct _tDeviceStatusUpdate
+	{
+		int signallevel;
+		int batterylevel;
+		int nValue;
+		std::string sValue;
+		std::string sLastUpdate;
+	};
+
+	// (HardwareID, DeviceID, Unit, Type, SubType) -> DeviceStatus row
+	struct _tDeviceKey
+	{
+		int HardwareID;
+		std::string DeviceID;
+		unsigned char unit;
+		unsigned char devType;
+		unsigned char subType;
+		bool operator==(const _tDeviceKey &other) const
+		{
+			return (HardwareID == other.HardwareID) && (unit == other.unit) && (devType == other.devType) && (subType == other.subType) && (DeviceID == other.DeviceID);
+		}
+	};
+	struct _tDeviceKeyHash
+	{
+		size_t operator()(const _tDeviceKey &key) const
+		{
+			size_t hash = 0;
+			boost::hash_combine(hash, key.HardwareID);
+			boost::hash_combine(hash, key.DeviceID);
+			boost::hash_combine(hash, key.unit);
+			boost::hash_combine(hash, key.devType);
+			boost::hash_combine(hash, key.subType);
+			return hash;
+		}
+	};
+	struct _tDeviceIndexItem
+	{
+		uint64_t ID = 0;
+		std::string Name;
+		bool bUsed = false;
+		_eSwitchType switchType = STYPE_OnOff;
+		std::string Options;
+		float AddjValue = 0.0F;
+		float AddjMulti = 1.0F;
+		float AddjValue2 = 0.0F;
+		float AddjMulti2 = 1.0F;
+		int nValue = 0;
+		std::string sValue;
+		std::string sLastUpdate;
+	};
+
+	// Rows changed on the writer connection, reported by the sqlite update hook (see UpdateHook)
+	struct _tDataChanges
+	{
+		std::vector<uint64_t> DeviceIDs; // updated or deleted DeviceStatus rows
+		bool bNewDevices = false;
+		bool bDeviceList = false; // other tables that are shown in the device list
+		bool bShortLog = false;	  // Meter, Rain or MultiMeter rows (today's counters)
+		bool bPreferences = false;
+	};
+
+	struct _tSQLReadConnection
+	{
+		std::mutex mutex;
+		sqlite3 *dbase = nullptr;
+		uint64_t queries = 0;
+		std::atomic<uint64_t> waits{ 0 };
+	};
+
 	std::mutex m_executeThreadMutex;
 	std::mutex m_sqlQueryMutex;
 	sqlite3 *m_dbase;
 	std::string m_dbase_name;
 	std::string m_journal_mode;
+	int m_nReadConnections;
+	std::vector<std::unique_ptr<_tSQLReadConnection>> m_read_connections;
+	std::atomic<size_t> m_next_read_connection{ 0 };
+	std::atomic<uint64_t> m_writer_queries{ 0 };
+	std::atomic<uint64_t> m_writer_waits{ 0 };
+
+	// write-behind journal for DeviceStatus value updates
+	bool m_bDeviceStatusWriteBehind;
+	int m_iWriteBehindIntervalMs;
+	int m_iWriteBehindMaxRows;
+	std::mutex m_device_status_journal_mutex;
+	std::map<uint64_t, _tDeviceStatusUpdate> m_device_status_journal;
+	std::chrono::steady_clock::time_point m_device_status_journal_start;
+
+	// collected by UpdateHook until the statement that caused them has finished
+	std::mutex m_data_changes_mutex;
+	_tDataChanges m_data_changes;
+
+	// device lookup index, see LookupDevice
+	std::mutex m_device_index_mutex;
+	std::unordered_map<_tDeviceKey, _tDeviceIndexItem, _tDeviceKeyHash> m_device_index;
+	std::unordered_map<uint64_t, _tDeviceKey> m_device_index_ids;
+	uint64_t m_device_index_generation;
+	std::atomic<uint64_t> m_device_index_hits{ 0 };
+	std::atomic<uint64_t> m_device_index_misses{ 0 };
+	std::atomic<uint64_t> m_device_index_invalidations{ 0 };
+
+	// device list change tracking, see GetChangedDevices
+	std::mutex m_device_changes_mutex;
+	uint64_t m_device_changes_version = 0;
+	uint64_t m_device_changes_reset_version = 0;
+	std::unordered_map<uint64_t, uint64_t> m_device_changes;
+
+	// today's counter values per table and device, see GetTodayCounter
+	std::mutex m_today_counters_mutex;
+	std::string m_today_counters_date;
+	uint64_t m_today_counters_generation = 0;
+	std::unordered_map<std::string, std::unordered_map<uint64_t, _tTodayCounter>> m_today_counters;
+
+	// Preferences table, read without locking from the published snapshot, see GetPreferences
+	struct _tPreference
+	{
+		int nValue = 0;
+		std::string sValue;
+		bool bHasSValue = false;
+	};
+	typedef std::unordered_map<std::string, _tPreference> _tPreferences;
+	std::mutex m_preferences_mutex;
+	std::shared_ptr<const _tPreferences> m_preferences;
+	std::atomic<uint64_t> m_preferences_generation{ 0 };
+	std::mutex m_preference_subscribers_mutex;
+	std::map<int, std::pair<std::string, TPreferenceCallback>> m_preference_subscribers;
+	int m_preference_subscriber_id = 0;
 	unsigned char m_sensortimeoutcounter;
 	std::map<uint64_t, int> m_timeoutlastsend;
 	std::map<uint64_t, int> m_batterylowlastsend;
@@ -541,14 +771,107 @@ class CSQLHelper : public StoppableTask
 
 	void CleanupLightSceneLog();
 
-	void UpdateTemperatureLog();
-	void UpdateRainLog();
-	void UpdateWindLog();
-	void UpdateUVLog();
-	void UpdateMeter();
-	void UpdateMultiMeter();
-	void UpdatePercentageLog();
-	void UpdateFanLog();
+	// 5-minute short log, see ScheduleShortlog
+	struct _tShortLogDevice
+	{
+		uint64_t ID;
+		std::string Name;
+		int HardwareID;
+		std::string DeviceID;
+		unsigned char Unit;
+		unsigned char dType;
+		unsigned char dSubType;
+		int nValue;
+		std::string sValue;
+		std::string sOptions;
+		double Age; // seconds since LastUpdate
+	};
+	struct _tShortLogTemperature
+	{
+		uint64_t ID;
+		float temp;
+		float chill;
+		unsigned char humidity;
+		int barometer;
+		float dewpoint;
+		float setpoint;
+	};
+	struct _tShortLogRain
+	{
+		uint64_t ID;
+		float total;
+		int rate;
+	};
+	struct _tShortLogWind
+	{
+		uint64_t ID;
+		float direction;
+		int speed;
+		int gust;
+	};
+	struct _tShortLogLevel
+	{
+		uint64_t ID;
+		float value;
+	};
+	struct _tShortLogMeter
+	{
+		uint64_t ID;
+		int64_t value;
+		int64_t usage;
+	};
+	struct _tShortLogMultiMeter
+	{
+		uint64_t ID = 0;
+		uint64_t value1 = 0;
+		uint64_t value2 = 0;
+		uint64_t value3 = 0;
+		uint64_t value4 = 0;
+		uint64_t value5 = 0;
+		uint64_t value6 = 0;
+	};
+	struct _tShortLogFan
+	{
+		uint64_t ID;
+		int speed;
+	};
+	struct _tShortLogBatch
+	{
+		int SensorTimeOut = 60;
+		std::vector<_tShortLogTemperature> temperature;
+		std::vector<_tShortLogRain> rain;
+		std::vector<_tShortLogWind> wind;
+		std::vector<_tShortLogLevel> uv;
+		std::vector<_tShortLogMeter> meter;
+		std::vector<_tShortLogMultiMeter> multimeter;
+		std::vector<_tShortLogLevel> percentage;
+		std::vector<_tShortLogFan> fan;
+	};
+	void ReadShortLogDevices(time_t now, std::vector<_tShortLogDevice> &devices);
+	bool IsShortLogValueStale(const _tShortLogDevice &sd, int SensorTimeOut);
+	void DecodeTemperatureLog(const _tShortLogDevice &sd, _tShortLogBatch &batch);
+	void DecodeRainLog(const _tShortLogDevice &sd, _tShortLogBatch &batch);
+	void DecodeWindLog(const _tShortLogDevice &sd, _tShortLogBatch &batch);
+	void DecodeUVLog(const _tShortLogDevice &sd, _tShortLogBatch &batch);
+	void DecodeMeterLog(const _tShortLogDevice &sd, _tShortLogBatch &batch);
+	void DecodeMultiMeterLog(const _tShortLogDevice &sd, _tShortLogBatch &batch);
+	void DecodePercentageLog(const _tShortLogDevice &sd, _tShortLogBatch &batch);
+	void DecodeFanLog(const _tShortLogDevice &sd, _tShortLogBatch &batch);
+	size_t WriteShortLog(const _tShortLogBatch &batch);
+	void UpdateTodayCounters(const _tShortLogBatch &batch);
+	// running day totals of the short log tables, see CreateShortLogRollupTriggers
+	struct _tShortLogRollup
+	{
+		int Count = 0;
+		double Min[6] = {};
+		double Max[6] = {};
+		double Sum[6] = {};
+		double First1 = 0;
+		double Last1 = 0;
+		double Last2 = 0;
+	};
+	void CreateShortLogRollupTriggers();
+	void GetShortLogRollups(const char *szSource, const char *szDate, std::map<uint64_t, _tShortLogRollup> &rollups);
 	void AddCalendarTemperature();
 	void AddCalendarUpdateRain();
 	void AddCalendarUpdateWind();
@@ -566,6 +889,80 @@ class CSQLHelper : public StoppableTask
 
 	std::vector<std::vector<std::string>> query(const std::string &szQuery);
 	std::vector<std::vector<std::string>> queryBlob(const std::string &szQuery);
+	std::vector<std::vector<std::string>> query_readonly(const std::string &szQuery);
+	static void fetch_rows(sqlite3 *dbase, const std::string &szQuery, std::vector<std::vector<std::string>> &results);
+	void LockWriter(std::unique_lock<std::mutex> &lock);
+
+	void OpenReadConnections();
+	void CloseReadConnections();
+
+	void QueueDeviceStatusUpdate(uint64_t ulID, int signallevel, int batterylevel, int nValue, const char *sValue, const std::string &sLastUpdate);
+	bool GetPendingDeviceStatus(uint64_t ulID, int &nValue, std::string &sValue, std::string &sLastUpdate);
+	bool UsesDeviceStatusJournal(const char *szSQL);
+	void FlushDeviceStatusJournalIfNeeded(const char *szQuery, bool bPrepared);
+	void FlushDeviceStatusJournalInt();
+
+	bool LookupDevice(int HardwareID, const char *ID, unsigned char unit, unsigned char devType, unsigned char subType, _tDeviceIndexItem &item);
+	void UpdateDeviceIndexValue(uint64_t ulID, int nValue, const char *sValue, const std::string &sLastUpdate);
+	void InvalidateDeviceIndex(uint64_t ulID);
+	void NoteDeviceChanged(uint64_t ulID);
+	void NoteAllDevicesChanged();
+	void ClearTodayCounters();
+	void CheckTodayCountersDate(const std::string &szDate);
+	std::shared_ptr<const _tPreferences> GetPreferences();
+	std::shared_ptr<const _tPreferences> LoadPreferences();
+	void ClearPreferences();
+	void InvalidatePreferences();
+
+	static void UpdateHook(void *pUser, int iOperation, const char *szDatabase, const char *szTable, long long iRowID); // iRowID is a sqlite3_int64
+	// TakeDataChanges is called before m_sqlQueryMutex is released, ApplyDataChanges after that
+	void TakeDataChanges(_tDataChanges &changes);
+	void ApplyDataChanges(const _tDataChanges &changes);
+
+	// prepared_query without applying the changes, for callers that update the caches themselves
+	template <typename... Args> bool prepared_query_int(_tDataChanges &changes, const char *szSQL, const TSqlRowCallback &callback, const Args &...args)
+	{
+		if (!m_dbase)
+			return false;
+		FlushDeviceStatusJournalIfNeeded(szSQL, true);
+		std::unique_lock<std::mutex> l(m_sqlQueryMutex, std::defer_lock);
+		LockWriter(l);
+		sqlite3_stmt *pStatement = TakeCachedStatement(szSQL);
+		if (pStatement == nullptr)
+			return false;
+		BindParameters(pStatement, 1, args...);
+		bool bResult = StepCachedStatement(pStatement, szSQL, callback, &l);
+		ReturnCachedStatement(pStatement, szSQL);
+		TakeDataChanges(changes);
+		return bResult;
+	}
+	void NotifyPreferenceSubscribers(const std::string &Key, int nValue, const std::string &sValue);
+
+	// prepared statement cache, only to be used while holding m_sqlQueryMutex
+	sqlite3_stmt *GetCachedStatement(const char *szSQL);
+	// a taken statement is not used by others until it is returned
+	sqlite3_stmt *TakeCachedStatement(const char *szSQL);
+	void ReturnCachedStatement(sqlite3_stmt *pStatement, const char *szSQL);
+	// with a callback the lock is released while the callback runs, the statement has to be taken
+	bool StepCachedStatement(sqlite3_stmt *pStatement, const char *szSQL, const TSqlRowCallback &callback = nullptr, std::unique_lock<std::mutex> *pLock = nullptr);
+	void ClearStatementCache();
+	static void BindParameters(sqlite3_stmt * /*pStatement*/, int /*iParam*/)
+	{
+	}
+	template <typename T, typename... Args> static void BindParameters(sqlite3_stmt *pStatement, const int iParam, const T &value, const Args &...args)
+	{
+		BindParameter(pStatement, iParam, value);
+		BindParameters(pStatement, iParam + 1, args...);
+	}
+	static void BindParameter(sqlite3_stmt *pStatement, int iParam, int value);
+	static void BindParameter(sqlite3_stmt *pStatement, int iParam, int64_t value);
+	static void BindParameter(sqlite3_stmt *pStatement, int iParam, uint64_t value);
+	static void BindParameter(sqlite3_stmt *pStatement, int iParam, double value);
+	static void BindParameter(sqlite3_stmt *pStatement, int iParam, const char *value);
+	static void BindParameter(sqlite3_stmt *pStatement, int iParam, const std::string &value);
+
+	std::unordered_map<std::string, sqlite3_stmt *> m_statement_cache;
+	std::unordered_map<std::string, bool> m_statement_uses_journal; // prepared SQL that uses the deferred DeviceStatus columns
 };
 
 extern CSQLHelper m_sql;
@@ -25,6 +25,7 @@ CScheduler::CScheduler()
 	m_tNautTwEnd = 0;
 	m_tAstTwStart = 0;
 	m_tAstTwEnd = 0;
+	m_bWakeup = false;
 	srand((int)mytime(nullptr));
 }
 
@@ -39,6 +40,11 @@ void CScheduler::StopScheduler()
 	if (m_thread)
 	{
 		RequestStop();
+		{
+			std::lock_guard<std::mutex> l(m_mutex);
+			m_bWakeup = true;
+		}
+		m_cond.notify_all();
 		m_thread->join();
 		m_thread.reset();
 	}
@@ -334,6 +340,7 @@ void CScheduler::ReloadSchedules()
 				m_scheduleitems.push_back(titem);
 		}
 	}
+	RebuildScheduleQueue();
 }
 
 void CScheduler::SetSunRiseSetTimers(const std::string &sSunRise, const std::string &sSunSet, const std::string &sSunAtSouth, const std::string &sCivTwStart, const std::string &sCivTwEnd, const std::string &sNautTwStart, const std::string &sNautTwEnd, const std::string &sAstTwStart, const std::string &sAstTwEnd)
@@ -395,25 +402,7 @@ bool CScheduler::AdjustScheduleItem(tScheduleItem *pItem, bool bForceAddDay)
 	int roffset = 0;
 	if (pItem->bUseRandomness)
 	{
-		if ((pItem->timerType == TTYPE_BEFORESUNRISE) ||
-			(pItem->timerType == TTYPE_AFTERSUNRISE) ||
-			(pItem->timerType == TTYPE_BEFORESUNSET) ||
-			(pItem->timerType == TTYPE_AFTERSUNSET) ||
-
-			(pItem->timerType == TTYPE_BEFORESUNATSOUTH) ||
-			(pItem->timerType == TTYPE_AFTERSUNATSOUTH) ||
-			(pItem->timerType == TTYPE_BEFORECIVTWSTART) ||
-			(pItem->timerType == TTYPE_AFTERCIVTWSTART) ||
-			(pItem->timerType == TTYPE_BEFORECIVTWEND) ||
-			(pItem->timerType == TTYPE_AFTERCIVTWEND) ||
-			(pItem->timerType == TTYPE_BEFORENAUTTWSTART) ||
-			(pItem->timerType == TTYPE_AFTERNAUTTWSTART) ||
-			(pItem->timerType == TTYPE_BEFORENAUTTWEND) ||
-			(pItem->timerType == TTYPE_AFTERNAUTTWEND) ||
-			(pItem->timerType == TTYPE_BEFOREASTTWSTART) ||
-			(pItem->timerType == TTYPE_AFTERASTTWSTART) ||
-			(pItem->timerType == TTYPE_BEFOREASTTWEND) ||
-			(pItem->timerType == TTYPE_AFTERASTTWEND))
+		if (IsSunTimer(*pItem))
 			roffset = rand() % (nRandomTimerFrame);
 		else
 			roffset = rand() % (nRandomTimerFrame * 2) - nRandomTimerFrame;
@@ -686,255 +675,360 @@ bool CScheduler::AdjustScheduleItem(tScheduleItem *pItem, bool bForceAddDay)
 
 void CScheduler::Do_Work()
 {
-	while (!IsStopRequested(1000))
+	time_t tLastHeartbeat = 0;
+	time_t tLastMinute = 0;
+	while (!IsStopRequested(0))
 	{
 		time_t atime = mytime(nullptr);
-		struct tm ltime;
-		localtime_r(&atime, &ltime);
-
 
-		if (ltime.tm_sec % 12 == 0) {
+		if (atime - tLastHeartbeat >= SCHEDULER_HEARTBEAT_INTERVAL)
+		{
 			m_mainworker.HeartbeatUpdate("Scheduler");
+			tLastHeartbeat = atime;
 		}
 
 		CheckSchedules();
 
-		if (ltime.tm_sec == 0) {
+		if (atime / 60 != tLastMinute)
+		{
 			DeleteExpiredTimers();
+			tLastMinute = atime / 60;
 		}
+
+		//sleep until the first schedule item is due, the next heartbeat or the next minute
+		std::unique_lock<std::mutex> l(m_mutex);
+		time_t tWakeup = std::min(tLastHeartbeat + SCHEDULER_HEARTBEAT_INTERVAL, (tLastMinute + 1) * 60);
+		if (!m_schedulequeue.empty())
+			tWakeup = std::min(tWakeup, m_schedulequeue.front().first + 1);
+		m_cond.wait_until(l, std::chrono::system_clock::from_time_t(tWakeup), [this] { return m_bWakeup; });
+		m_bWakeup = false;
 	}
 	_log.Log(LOG_STATUS, "Scheduler stopped...");
 }
 
-void CScheduler::CheckSchedules()
+void CScheduler::RebuildScheduleQueue()
 {
+	m_schedulequeue.clear();
+	m_schedulequeue.reserve(m_scheduleitems.size());
+	for (size_t ii = 0; ii < m_scheduleitems.size(); ii++)
+	{
+		if (m_scheduleitems[ii].bEnabled)
+			m_schedulequeue.emplace_back(GetScheduleQueueTime(m_scheduleitems[ii]), ii);
+	}
+	std::make_heap(m_schedulequeue.begin(), m_schedulequeue.end(), std::greater<_tScheduleQueueItem>());
+	m_bWakeup = true;
+	m_cond.notify_all();
+}
+
+bool CScheduler::IsSunTimer(const tScheduleItem &item)
+{
+	return ((item.timerType == TTYPE_BEFORESUNRISE) ||
+		(item.timerType == TTYPE_AFTERSUNRISE) ||
+		(item.timerType == TTYPE_BEFORESUNSET) ||
+		(item.timerType == TTYPE_AFTERSUNSET) ||
+		((item.timerType >= TTYPE_BEFORESUNATSOUTH) && (item.timerType <= TTYPE_AFTERASTTWEND)));
+}
+
+time_t CScheduler::GetScheduleQueueTime(const tScheduleItem &item)
+{
+	if (item.timerType == TTYPE_FIXEDDATETIME)
+		return item.startTime;
+	//the sun times of a later day are not known yet, a sun timer is queued for its next day
+	//and moved to the following day (with the sun times of then) when it is not allowed to fire
+	if (IsSunTimer(item))
+		return item.startTime;
+	//the odd/even weeks are checked on the start time of the item itself
+	tScheduleItem titem = item;
+	struct tm ltime;
+	localtime_r(&item.startTime, &ltime);
+	//four weeks covers every day and week rule, also around the turn of the year
+	for (int ii = 0; ii < 28; ii++)
+	{
+		struct tm tm1 = ltime;
+		tm1.tm_mday += ii;
+		tm1.tm_isdst = -1;
+		titem.startTime = (ii == 0) ? item.startTime : mktime(&tm1);
+		localtime_r(&titem.startTime, &tm1);
+		if (IsValidScheduleDay(titem, tm1))
+			return titem.startTime;
+	}
+	//never fires, it is checked again once the start time passed
+	return item.startTime;
+}
+
+std::vector<tScheduleItem> CScheduler::GetUpcomingScheduleItems(const size_t maxItems)
+{
+	std::vector<tScheduleItem> ret;
 	std::lock_guard<std::mutex> l(m_mutex);
+	std::vector<_tScheduleQueueItem> queue = m_schedulequeue;
+	while ((!queue.empty()) && (ret.size() < maxItems))
+	{
+		ret.push_back(m_scheduleitems[queue.front().second]);
+		ret.back().startTime = queue.front().first;
+		std::pop_heap(queue.begin(), queue.end(), std::greater<_tScheduleQueueItem>());
+		queue.pop_back();
+	}
+	return ret;
+}
+
+bool CScheduler::IsValidScheduleDay(const tScheduleItem &item, const struct tm &ltime)
+{
+	bool bOkToFire = false;
+	if (item.timerType == TTYPE_FIXEDDATETIME)
+	{
+		bOkToFire = true;
+	}
+	else if (item.timerType == TTYPE_DAYSODD)
+	{
+		bOkToFire = (ltime.tm_mday % 2 != 0);
+	}
+	else if (item.timerType == TTYPE_DAYSEVEN)
+	{
+		bOkToFire = (ltime.tm_mday % 2 == 0);
+	}
+	else
+	{
+		if (item.Days & 0x80)
+		{
+			//everyday
+			bOkToFire = true;
+		}
+		else if (item.Days & 0x100)
+		{
+			//weekdays
+			if ((ltime.tm_wday > 0) && (ltime.tm_wday < 6))
+				bOkToFire = true;
+		}
+		else if (item.Days & 0x200)
+		{
+			//weekends
+			if ((ltime.tm_wday == 0) || (ltime.tm_wday == 6))
+				bOkToFire = true;
+		}
+		else
+		{
+			//custom days
+			if ((item.Days & 0x01) && (ltime.tm_wday == 1))
+				bOkToFire = true;//Monday
+			if ((item.Days & 0x02) && (ltime.tm_wday == 2))
+				bOkToFire = true;//Tuesday
+			if ((item.Days & 0x04) && (ltime.tm_wday == 3))
+				bOkToFire = true;//Wednesday
+			if ((item.Days & 0x08) && (ltime.tm_wday == 4))
+				bOkToFire = true;//Thursday
+			if ((item.Days & 0x10) && (ltime.tm_wday == 5))
+				bOkToFire = true;//Friday
+			if ((item.Days & 0x20) && (ltime.tm_wday == 6))
+				bOkToFire = true;//Saturday
+			if ((item.Days & 0x40) && (ltime.tm_wday == 0))
+				bOkToFire = true;//Sunday
+		}
+		if (bOkToFire)
+		{
+			if ((item.timerType == TTYPE_WEEKSODD) || (item.timerType == TTYPE_WEEKSEVEN))
+			{
+				struct tm timeinfo;
+				localtime_r(&item.startTime, &timeinfo);
+
+				boost::gregorian::date d = boost::gregorian::date(
+					timeinfo.tm_year + 1900,
+					timeinfo.tm_mon + 1,
+					timeinfo.tm_mday);
+				int w = d.week_number();
+
+				if (item.timerType == TTYPE_WEEKSODD)
+					bOkToFire = (w % 2 != 0);
+				else
+					bOkToFire = (w % 2 == 0);
+			}
+		}
+	}
+	return bOkToFire;
+}
 
+void CScheduler::CheckSchedules()
+{
 	time_t atime = mytime(nullptr);
 	struct tm ltime;
 	localtime_r(&atime, &ltime);
 
-	for (auto &item : m_scheduleitems)
+	std::vector<tScheduleItem> fireitems;
 	{
-		if ((item.bEnabled) && (atime > item.startTime))
+		std::lock_guard<std::mutex> l(m_mutex);
+
+		//take the due items off the queue first, an item is checked once per call
+		std::vector<_tScheduleQueueItem> dueitems;
+		while ((!m_schedulequeue.empty()) && (atime > m_schedulequeue.front().first))
 		{
-			//check if we are on a valid day
-			bool bOkToFire = false;
-			if (item.timerType == TTYPE_FIXEDDATETIME)
+			dueitems.push_back(m_schedulequeue.front());
+			std::pop_heap(m_schedulequeue.begin(), m_schedulequeue.end(), std::greater<_tScheduleQueueItem>());
+			m_schedulequeue.pop_back();
+		}
+
+		for (const auto &due : dueitems)
+		{
+			const size_t idx = due.second;
+			tScheduleItem &item = m_scheduleitems[idx];
+			//the day it was queued for, not the start time it had when it was queued
+			item.startTime = due.first;
+			if (IsValidScheduleDay(item, ltime))
+				fireitems.push_back(item);
+			if (!AdjustScheduleItem(&item, true))
 			{
-				bOkToFire = true;
+				//something is wrong, probably no sunset/rise
+				if (item.timerType != TTYPE_FIXEDDATETIME)
+				{
+					item.startTime += atime + (24 * 3600);
+				}
+				else
+				{
+					//Disable timer
+					item.bEnabled = false;
+				}
 			}
-			else if (item.timerType == TTYPE_DAYSODD)
+			if (item.bEnabled)
 			{
-				bOkToFire = (ltime.tm_mday % 2 != 0);
+				m_schedulequeue.emplace_back(GetScheduleQueueTime(item), idx);
+				std::push_heap(m_schedulequeue.begin(), m_schedulequeue.end(), std::greater<_tScheduleQueueItem>());
 			}
-			else if (item.timerType == TTYPE_DAYSEVEN)
+		}
+	}
+
+	//switch outside the lock, so the web interface can read the schedules meanwhile
+	for (const auto &item : fireitems)
+		FireScheduleItem(item, ltime);
+}
+
+void CScheduler::FireScheduleItem(const tScheduleItem &item, const struct tm &ltime)
+{
+	char ltimeBuf[30];
+	strftime(ltimeBuf, sizeof(ltimeBuf), "%Y-%m-%d %H:%M:%S", &ltime);
+
+	if (item.bIsScene == true)
+		_log.Log(LOG_STATUS, "Schedule item started! Name: %s, Type: %s, SceneID: %" PRIu64 ", Time: %s",
+			 item.DeviceName.c_str(), Timer_Type_Desc(item.timerType), item.RowID, ltimeBuf);
+	else if (item.bIsThermostat == true)
+		_log.Log(LOG_STATUS,
+			 "Schedule item started! Name: %s, Type: %s, ThermostatID: %" PRIu64 ", Time: %s",
+			 item.DeviceName.c_str(), Timer_Type_Desc(item.timerType), item.RowID, ltimeBuf);
+	else
+		_log.Log(LOG_STATUS, "Schedule item started! Name: %s, Type: %s, DevID: %" PRIu64 ", Time: %s",
+			 item.DeviceName.c_str(), Timer_Type_Desc(item.timerType), item.RowID, ltimeBuf);
+	std::string switchcmd;
+	if (item.timerCmd == TCMD_ON)
+		switchcmd = "On";
+	else if (item.timerCmd == TCMD_OFF)
+		switchcmd = "Off";
+	if (switchcmd.empty())
+	{
+		_log.Log(LOG_ERROR, "Unknown switch command in timer!!....");
+	}
+	else
+	{
+		if (item.bIsScene == true)
+		{
+			/*
+									if (
+										(item.timerType ==
+			   TTYPE_BEFORESUNRISE) || (item.timerType == TTYPE_AFTERSUNRISE) || (item.timerType ==
+			   TTYPE_BEFORESUNSET) || (item.timerType == TTYPE_AFTERSUNSET)
+										)
+									{
+
+									}
+			*/
+			if (!m_mainworker.SwitchScene(item.RowID, switchcmd, "timer"))
 			{
-				bOkToFire = (ltime.tm_mday % 2 == 0);
+				_log.Log(LOG_ERROR, "Error switching Scene command, SceneID: %" PRIu64 ", Time: %s",
+					 item.RowID, ltimeBuf);
 			}
-			else
+		}
+		else if (item.bIsThermostat == true)
+		{
+			std::stringstream sstr;
+			sstr << item.RowID;
+			if (!m_mainworker.SetSetPoint(sstr.str(), item.Temperature))
 			{
-				if (item.Days & 0x80)
-				{
-					//everyday
-					bOkToFire = true;
-				}
-				else if (item.Days & 0x100)
-				{
-					//weekdays
-					if ((ltime.tm_wday > 0) && (ltime.tm_wday < 6))
-						bOkToFire = true;
-				}
-				else if (item.Days & 0x200)
-				{
-					//weekends
-					if ((ltime.tm_wday == 0) || (ltime.tm_wday == 6))
-						bOkToFire = true;
-				}
-				else
+				_log.Log(LOG_ERROR,
+					 "Error setting thermostat setpoint, ThermostatID: %" PRIu64 ", Time: %s",
+					 item.RowID, ltimeBuf);
+			}
+		}
+		else
+		{
+			//Get SwitchType
+			std::vector<std::vector<std::string> > result;
+			result = m_sql.safe_query(
+				"SELECT Type,SubType,SwitchType FROM DeviceStatus WHERE (ID == %" PRIu64 ")",
+				item.RowID);
+			if (!result.empty())
+			{
+				std::vector<std::string> sd = result[0];
+
+				unsigned char dType = atoi(sd[0].c_str());
+				unsigned char dSubType = atoi(sd[1].c_str());
+				_eSwitchType switchtype = (_eSwitchType)atoi(sd[2].c_str());
+				std::string lstatus;
+				int llevel = 0;
+				bool bHaveDimmer = false;
+				bool bHaveGroupCmd = false;
+				int maxDimLevel = 0;
+
+				GetLightStatus(dType, dSubType, switchtype, 0, "", lstatus, llevel, bHaveDimmer, maxDimLevel, bHaveGroupCmd);
+				int ilevel = maxDimLevel;
+				if (switchtype == STYPE_Blinds)
 				{
-					//custom days
-					if ((item.Days & 0x01) && (ltime.tm_wday == 1))
-						bOkToFire = true;//Monday
-					if ((item.Days & 0x02) && (ltime.tm_wday == 2))
-						bOkToFire = true;//Tuesday
-					if ((item.Days & 0x04) && (ltime.tm_wday == 3))
-						bOkToFire = true;//Wednesday
-					if ((item.Days & 0x08) && (ltime.tm_wday == 4))
-						bOkToFire = true;//Thursday
-					if ((item.Days & 0x10) && (ltime.tm_wday == 5))
-						bOkToFire = true;//Friday
-					if ((item.Days & 0x20) && (ltime.tm_wday == 6))
-						bOkToFire = true;//Saturday
-					if ((item.Days & 0x40) && (ltime.tm_wday == 0))
-						bOkToFire = true;//Sunday
+					if (item.timerCmd == TCMD_ON)
+						switchcmd = "Open";
+					else if (item.timerCmd == TCMD_OFF)
+						switchcmd = "Close";
 				}
-				if (bOkToFire)
+				else if (
+					(switchtype == STYPE_BlindsPercentage)
+					|| (switchtype == STYPE_BlindsPercentageWithStop)
+					)
 				{
-					if ((item.timerType == TTYPE_WEEKSODD) || (item.timerType == TTYPE_WEEKSEVEN))
+					if (item.timerCmd == TCMD_ON)
 					{
-						struct tm timeinfo;
-						localtime_r(&item.startTime, &timeinfo);
-
-						boost::gregorian::date d = boost::gregorian::date(
-							timeinfo.tm_year + 1900,
-							timeinfo.tm_mon + 1,
-							timeinfo.tm_mday);
-						int w = d.week_number();
-
-						if (item.timerType == TTYPE_WEEKSODD)
-							bOkToFire = (w % 2 != 0);
-						else
-							bOkToFire = (w % 2 == 0);
+						switchcmd = "Set Level";
+						float fLevel = (maxDimLevel / 100.0F) * item.Level;
+						if (fLevel > 100)
+							fLevel = 100;
+						ilevel = int(fLevel);
+					}
+					else if (item.timerCmd == TCMD_OFF)
+					{
+						switchcmd = "Close";
+						ilevel = 0;
 					}
 				}
-			}
-			if (bOkToFire)
-			{
-				char ltimeBuf[30];
-				strftime(ltimeBuf, sizeof(ltimeBuf), "%Y-%m-%d %H:%M:%S", &ltime);
-
-				if (item.bIsScene == true)
-					_log.Log(LOG_STATUS, "Schedule item started! Name: %s, Type: %s, SceneID: %" PRIu64 ", Time: %s",
-						 item.DeviceName.c_str(), Timer_Type_Desc(item.timerType), item.RowID, ltimeBuf);
-				else if (item.bIsThermostat == true)
-					_log.Log(LOG_STATUS,
-						 "Schedule item started! Name: %s, Type: %s, ThermostatID: %" PRIu64 ", Time: %s",
-						 item.DeviceName.c_str(), Timer_Type_Desc(item.timerType), item.RowID, ltimeBuf);
-				else
-					_log.Log(LOG_STATUS, "Schedule item started! Name: %s, Type: %s, DevID: %" PRIu64 ", Time: %s",
-						 item.DeviceName.c_str(), Timer_Type_Desc(item.timerType), item.RowID, ltimeBuf);
-				std::string switchcmd;
-				if (item.timerCmd == TCMD_ON)
-					switchcmd = "On";
-				else if (item.timerCmd == TCMD_OFF)
-					switchcmd = "Off";
-				if (switchcmd.empty())
-				{
-					_log.Log(LOG_ERROR, "Unknown switch command in timer!!....");
-				}
-				else
+				else if ((switchtype == STYPE_Dimmer) && (maxDimLevel != 0))
 				{
-					if (item.bIsScene == true)
+					if (item.timerCmd == TCMD_ON)
 					{
-						/*
-												if (
-													(item.timerType ==
-						   TTYPE_BEFORESUNRISE) || (item.timerType == TTYPE_AFTERSUNRISE) || (item.timerType ==
-						   TTYPE_BEFORESUNSET) || (item.timerType == TTYPE_AFTERSUNSET)
-													)
-												{
-
-												}
-						*/
-						if (!m_mainworker.SwitchScene(item.RowID, switchcmd, "timer"))
-						{
-							_log.Log(LOG_ERROR, "Error switching Scene command, SceneID: %" PRIu64 ", Time: %s",
-								 item.RowID, ltimeBuf);
-						}
+						switchcmd = "Set Level";
+						float fLevel = (maxDimLevel / 100.0F) * item.Level;
+						if (fLevel > 100)
+							fLevel = 100;
+						ilevel = int(fLevel);
 					}
-					else if (item.bIsThermostat == true)
+				} else if (switchtype == STYPE_Selector) {
+					if (item.timerCmd == TCMD_ON)
 					{
-						std::stringstream sstr;
-						sstr << item.RowID;
-						if (!m_mainworker.SetSetPoint(sstr.str(), item.Temperature))
-						{
-							_log.Log(LOG_ERROR,
-								 "Error setting thermostat setpoint, ThermostatID: %" PRIu64 ", Time: %s",
-								 item.RowID, ltimeBuf);
-						}
+						switchcmd = "Set Level";
+						ilevel = item.Level;
 					}
-					else
+					else if (item.timerCmd == TCMD_OFF)
 					{
-						//Get SwitchType
-						std::vector<std::vector<std::string> > result;
-						result = m_sql.safe_query(
-							"SELECT Type,SubType,SwitchType FROM DeviceStatus WHERE (ID == %" PRIu64 ")",
-							item.RowID);
-						if (!result.empty())
-						{
-							std::vector<std::string> sd = result[0];
-
-							unsigned char dType = atoi(sd[0].c_str());
-							unsigned char dSubType = atoi(sd[1].c_str());
-							_eSwitchType switchtype = (_eSwitchType)atoi(sd[2].c_str());
-							std::string lstatus;
-							int llevel = 0;
-							bool bHaveDimmer = false;
-							bool bHaveGroupCmd = false;
-							int maxDimLevel = 0;
-
-							GetLightStatus(dType, dSubType, switchtype, 0, "", lstatus, llevel, bHaveDimmer, maxDimLevel, bHaveGroupCmd);
-							int ilevel = maxDimLevel;
-							if (switchtype == STYPE_Blinds)
-							{
-								if (item.timerCmd == TCMD_ON)
-									switchcmd = "Open";
-								else if (item.timerCmd == TCMD_OFF)
-									switchcmd = "Close";
-							}
-							else if (
-								(switchtype == STYPE_BlindsPercentage)
-								|| (switchtype == STYPE_BlindsPercentageWithStop)
-								)
-							{
-								if (item.timerCmd == TCMD_ON)
-								{
-									switchcmd = "Set Level";
-									float fLevel = (maxDimLevel / 100.0F) * item.Level;
-									if (fLevel > 100)
-										fLevel = 100;
-									ilevel = int(fLevel);
-								}
-								else if (item.timerCmd == TCMD_OFF)
-								{
-									switchcmd = "Close";
-									ilevel = 0;
-								}
-							}
-							else if ((switchtype == STYPE_Dimmer) && (maxDimLevel != 0))
-							{
-								if (item.timerCmd == TCMD_ON)
-								{
-									switchcmd = "Set Level";
-									float fLevel = (maxDimLevel / 100.0F) * item.Level;
-									if (fLevel > 100)
-										fLevel = 100;
-									ilevel = int(fLevel);
-								}
-							} else if (switchtype == STYPE_Selector) {
-								if (item.timerCmd == TCMD_ON)
-								{
-									switchcmd = "Set Level";
-									ilevel = item.Level;
-								}
-								else if (item.timerCmd == TCMD_OFF)
-								{
-									ilevel = 0; // force level to a valid value for Selector
-								}
-							}
-							if (!m_mainworker.SwitchLight(item.RowID, switchcmd, ilevel, item.Color, false, 0,
-										      "timer"))
-							{
-								_log.Log(LOG_ERROR,
-									 "Error sending switch command, DevID: %" PRIu64 ", Time: %s",
-									 item.RowID, ltimeBuf);
-							}
-						}
+						ilevel = 0; // force level to a valid value for Selector
 					}
 				}
-			}
-			if (!AdjustScheduleItem(&item, true))
-			{
-				//something is wrong, probably no sunset/rise
-				if (item.timerType != TTYPE_FIXEDDATETIME)
-				{
-					item.startTime += atime + (24 * 3600);
-				}
-				else
+				if (!m_mainworker.SwitchLight(item.RowID, switchcmd, ilevel, item.Color, false, 0,
+							      "timer"))
 				{
-					//Disable timer
-					item.bEnabled = false;
+					_log.Log(LOG_ERROR,
+						 "Error sending switch command, DevID: %" PRIu64 ", Time: %s",
+						 item.RowID, ltimeBuf);
 				}
 			}
 		}
@@ -2172,6 +2266,45 @@ namespace http {
 			}
 		}
 
+		void CWebServer::Cmd_GetUpcomingTimers(WebEmSession & session, const request& req, Json::Value &root)
+		{
+			if (session.rights != 2)
+			{
+				session.reply_status = reply::forbidden;
+				return; //Only admin user allowed
+			}
+			std::string scount = request::findValue(&req, "count");
+			int count = (scount.empty()) ? 10 : atoi(scount.c_str());
+			root["title"] = "GetUpcomingTimers";
+			if (count < 1)
+			{
+				root["status"] = "ERR";
+				root["message"] = "Invalid count";
+				return;
+			}
+			root["status"] = "OK";
+
+			std::vector<tScheduleItem> schedules = m_mainworker.m_scheduler.GetUpcomingScheduleItems(count);
+			int ii = 0;
+			for (const auto &item : schedules)
+			{
+				char ltimeBuf[30];
+				struct tm timeinfo;
+				localtime_r(&item.startTime, &timeinfo);
+				strftime(ltimeBuf, sizeof(ltimeBuf), "%Y-%m-%d %H:%M:%S", &timeinfo);
+
+				root["result"][ii]["TimerID"] = (Json::Value::UInt64)item.TimerID;
+				root["result"][ii]["Type"] = item.bIsScene ? "Scene" : "Device";
+				root["result"][ii]["IsThermostat"] = item.bIsThermostat ? "true" : "false";
+				root["result"][ii]["DevName"] = item.DeviceName;
+				root["result"][ii]["DeviceRowID"] = (Json::Value::UInt64)item.RowID;
+				root["result"][ii]["TimerType"] = item.timerType;
+				root["result"][ii]["TimerTypeStr"] = Timer_Type_Desc(item.timerType);
+				root["result"][ii]["ScheduleDate"] = ltimeBuf;
+				ii++;
+			}
+		}
+
 		void CWebServer::Cmd_AddTimerPlan(WebEmSession & session, const request& req, Json::Value &root)
 		{
 			if (session.rights != 2)
@@ -2,9 +2,12 @@
 
 #include "RFXNames.h"
 #include "../hardware/hardwaretypes.h"
+#include <condition_variable>
 #include <string>
 #include "StoppableTask.h"
 
+#define SCHEDULER_HEARTBEAT_INTERVAL 12
+
 struct tScheduleItem
 {
 	bool bEnabled;
@@ -77,6 +80,8 @@ public:
 			   const std::string &sNautTwStart, const std::string &sNauTtwEnd, const std::string &sAstTwStart, const std::string &sAstTwEnd);
 
   std::vector<tScheduleItem> GetScheduleItems();
+  //enabled schedule items in the order they will fire
+  std::vector<tScheduleItem> GetUpcomingScheduleItems(size_t maxItems);
 
 private:
 	time_t m_tSunRise;
@@ -92,14 +97,28 @@ private:
 	std::shared_ptr<std::thread> m_thread;
 	std::vector<tScheduleItem> m_scheduleitems;
 
+	//min-heap on the next start time of the enabled items (index in m_scheduleitems)
+	typedef std::pair<time_t, size_t> _tScheduleQueueItem;
+	std::vector<_tScheduleQueueItem> m_schedulequeue;
+	std::condition_variable m_cond;
+	bool m_bWakeup;
+
 	//our thread
 	void Do_Work();
 
 	//will set the new/next startTime
 	//returns false if timer is invalid (like no sunset/sunrise known yet)
 	bool AdjustScheduleItem(tScheduleItem *pItem, bool bForceAddDay);
-	//will check if anything needs to be scheduled
+	//rebuilds the queue after the schedule items were (re)loaded and wakes up our thread
+	void RebuildScheduleQueue();
+	//start time of the item moved to the first day it is allowed to fire on (day mask, odd/even days and weeks)
+	time_t GetScheduleQueueTime(const tScheduleItem &item);
+	//start time follows the sun (sunrise/sunset, sun at south and twilight timers)
+	static bool IsSunTimer(const tScheduleItem &item);
+	//will check if the items that are due can fire today, and set their next startTime
 	void CheckSchedules();
+	bool IsValidScheduleDay(const tScheduleItem &item, const struct tm &ltime);
+	void FireScheduleItem(const tScheduleItem &item, const struct tm &ltime);
 	void DeleteExpiredTimers();
 };
 
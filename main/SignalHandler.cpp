@@ -427,6 +427,7 @@ void signal_handler(int sig_num
 #endif
 		tid = syscall(__NR_gettid);
 #endif
+		_log.WriteDirect();
 		if (fatal_handling) {
 #if defined(__GLIBC__)
 			_log.Log(LOG_ERROR, "Domoticz(pid:%d, tid:%ld('%s')) received fatal signal %d (%s) while backtracing", getpid(), tid, thread_name, sig_num
@@ -477,6 +478,7 @@ void signal_handler(int sig_num
 	case SIGUSR1:
 		fatal_handling = 1;
 		fatal_handling_thread = pthread_self();
+		_log.WriteDirect();
 		_log.Log(LOG_ERROR, "Domoticz(%d) is exiting due to watchdog triggered...", getpid());
 		// Print call stack of all threads to aid debugging of deadlock
 		dumpstack_gdb(true);
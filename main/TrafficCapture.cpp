@@ -0,0 +1,365 @@
+#include "stdafx.h"
+#include "TrafficCapture.h"
+#include "Helper.h"
+#include "Logger.h"
+#include "SQLHelper.h"
+#include "mainworker.h"
+#include "json_helper.h"
+#include <json/json.h>
+#include <inttypes.h>
+
+extern bool g_bStopApplication;
+
+namespace
+{
+	std::string ToHex(const uint8_t *pData, const size_t length)
+	{
+		static const char szHexDigits[] = "0123456789ABCDEF";
+		std::string ret;
+		ret.reserve(length * 2);
+		for (size_t ii = 0; ii < length; ii++)
+		{
+			ret += szHexDigits[pData[ii] >> 4];
+			ret += szHexDigits[pData[ii] & 0x0F];
+		}
+		return ret;
+	}
+
+	uint64_t GetSQLStatementCount()
+	{
+		uint64_t total = 0;
+		for (const auto &stat : m_sql.GetConnectionStats())
+			total += stat.queries;
+		return total;
+	}
+
+	thread_local std::chrono::steady_clock::time_point t_origin;
+} // namespace
+
+CTrafficCapture::~CTrafficCapture()
+{
+	Stop();
+}
+
+bool CTrafficCapture::StartCapture(const std::string &filename)
+{
+	std::lock_guard<std::mutex> l(m_capture_mutex);
+	m_capturefile.open(filename.c_str(), std::ios::out | std::ios::trunc);
+	if (!m_capturefile.is_open())
+	{
+		_log.Log(LOG_ERROR, "Capture: could not create: %s", filename.c_str());
+		return false;
+	}
+	m_capturefile << "#domoticz-capture 1\n";
+	m_capture_start = std::chrono::steady_clock::now();
+	m_bCapturing = true;
+	_log.Log(LOG_STATUS, "Capture: recording received serial/TCP/MQTT data to: %s", filename.c_str());
+	return true;
+}
+
+void CTrafficCapture::Record(const char kind, const std::string &source, const std::string &topic, const uint8_t *pData, const size_t length)
+{
+	if (!m_bCapturing)
+		return;
+	uint64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_capture_start).count();
+	std::string line = std::to_string(ms) + '\t' + kind + '\t' + source + '\t' + topic + '\t' + ToHex(pData, length) + '\n';
+
+	std::lock_guard<std::mutex> l(m_capture_mutex);
+	if (m_capturefile.is_open())
+		m_capturefile << line;
+}
+
+void CTrafficCapture::RecordHardware()
+{
+	if (!m_bCapturing)
+		return;
+	auto result = m_sql.safe_query(
+		"SELECT ID, Name, Type, LogLevel, Address, Port, SerialPort, Mode1, Mode2, Mode3, Mode4, Mode5, Mode6, DataTimeout FROM Hardware WHERE (Enabled==1) ORDER BY ID ASC");
+	std::lock_guard<std::mutex> l(m_capture_mutex);
+	for (const auto &sd : result)
+	{
+		// user names, passwords, Extra and Configuration (API keys, tokens, certificates) are kept out of the file
+		Json::Value hw;
+		hw["ID"] = atoi(sd[0].c_str());
+		hw["Name"] = sd[1];
+		hw["Type"] = atoi(sd[2].c_str());
+		hw["LogLevel"] = atoi(sd[3].c_str());
+		hw["Address"] = sd[4];
+		hw["Port"] = atoi(sd[5].c_str());
+		hw["SerialPort"] = sd[6];
+		for (int ii = 0; ii < 6; ii++)
+			hw["Mode" + std::to_string(ii + 1)] = atoi(sd[7 + ii].c_str());
+		hw["DataTimeout"] = atoi(sd[13].c_str());
+		m_capturefile << "#hardware\t" << JSonToRawString(hw) << '\n';
+	}
+	m_capturefile.flush();
+}
+
+bool CTrafficCapture::LoadReplay(const std::string &filename, const double speed)
+{
+	std::ifstream infile(filename.c_str());
+	if (!infile.is_open())
+	{
+		_log.Log(LOG_ERROR, "Replay: could not open: %s", filename.c_str());
+		return false;
+	}
+	m_hardware.clear();
+	m_records.clear();
+	m_sources.clear();
+
+	std::string sLine;
+	while (std::getline(infile, sLine))
+	{
+		if (sLine.empty())
+			continue;
+		if (sLine[0] == '#')
+		{
+			if (sLine.find("#hardware\t") == 0)
+				m_hardware.push_back(sLine.substr(10));
+			continue;
+		}
+		std::vector<std::string> fields;
+		size_t pos = 0;
+		while (fields.size() < 4)
+		{
+			size_t tpos = sLine.find('\t', pos);
+			if (tpos == std::string::npos)
+				break;
+			fields.push_back(sLine.substr(pos, tpos - pos));
+			pos = tpos + 1;
+		}
+		if ((fields.size() != 4) || (fields[1].size() != 1))
+			continue;
+		std::vector<char> data = HexToBytes(sLine.substr(pos));
+
+		_tTrafficRecord record;
+		record.ms = std::stoull(fields[0]);
+		record.kind = fields[1][0];
+		record.source = fields[2];
+		record.topic = fields[3];
+		record.data.assign(data.begin(), data.end());
+		m_sources.insert(ReaderKey(record.kind, record.source));
+		m_records.push_back(std::move(record));
+	}
+	if (m_records.empty())
+	{
+		_log.Log(LOG_ERROR, "Replay: no recorded data in: %s", filename.c_str());
+		return false;
+	}
+	m_speed = (speed > 0) ? speed : 0;
+	m_bReplaying = true;
+	_log.Log(LOG_STATUS, "Replay: loaded %d messages from %d connections (%s)", (int)m_records.size(), (int)m_sources.size(), filename.c_str());
+	return true;
+}
+
+void CTrafficCapture::RestoreHardware()
+{
+	if (!m_bReplaying)
+		return;
+	// the database is empty, only the hardware that received the recorded data is added
+	for (const auto &szHardware : m_hardware)
+	{
+		Json::Value hw;
+		if (!ParseJSon(szHardware, hw) || !hw.isObject())
+			continue;
+		std::string address = hw["Address"].asString() + ":" + std::to_string(hw["Port"].asInt());
+		std::string serialport = hw["SerialPort"].asString();
+		if ((!m_sources.count(ReaderKey(TRAFFIC_SERIAL, serialport))) && (!m_sources.count(ReaderKey(TRAFFIC_TCP, address))) &&
+		    (!m_sources.count(ReaderKey(TRAFFIC_MQTT, address))))
+			continue;
+		m_sql.safe_query("INSERT OR REPLACE INTO Hardware (ID, Name, Enabled, Type, LogLevel, Address, Port, SerialPort, Username, Password, Extra, Mode1, Mode2, Mode3, Mode4, Mode5, "
+				 "Mode6, DataTimeout) VALUES (%d, '%q', 1, %d, %d, '%q', %d, '%q', '', '', '', %d, %d, %d, %d, %d, %d, %d)",
+				 hw["ID"].asInt(), hw["Name"].asString().c_str(), hw["Type"].asInt(), hw["LogLevel"].asInt(), hw["Address"].asString().c_str(), hw["Port"].asInt(),
+				 serialport.c_str(), hw["Mode1"].asInt(), hw["Mode2"].asInt(), hw["Mode3"].asInt(), hw["Mode4"].asInt(),
+				 hw["Mode5"].asInt(), hw["Mode6"].asInt(), hw["DataTimeout"].asInt());
+		_log.Log(LOG_STATUS, "Replay: added hardware '%s'", hw["Name"].asString().c_str());
+	}
+}
+
+void CTrafficCapture::StartPlayback()
+{
+	if ((!m_bReplaying) || (m_thread))
+		return;
+	m_bStopPlayback = false;
+	m_sDeviceReceivedConnection = m_mainworker.sOnDeviceReceived.connect([this](auto, auto, const auto &, auto) { OnDeviceReceived(); });
+	m_thread = std::make_shared<std::thread>([this] { Do_Playback(); });
+	SetThreadName(m_thread->native_handle(), "TrafficReplay");
+}
+
+void CTrafficCapture::Stop()
+{
+	if (m_thread)
+	{
+		m_bStopPlayback = true;
+		m_thread->join();
+		m_thread.reset();
+	}
+	if (m_sDeviceReceivedConnection.connected())
+		m_sDeviceReceivedConnection.disconnect();
+	if (m_bCapturing)
+	{
+		std::lock_guard<std::mutex> l(m_capture_mutex);
+		m_bCapturing = false;
+		m_capturefile.close();
+	}
+}
+
+std::string CTrafficCapture::ReaderKey(const char kind, const std::string &source)
+{
+	return kind + source;
+}
+
+void CTrafficCapture::RegisterReader(const char kind, const std::string &source, const void *owner, const TTrafficReader &reader)
+{
+	std::lock_guard<std::mutex> l(m_readers_mutex);
+	_tTrafficReader treader;
+	treader.kind = kind;
+	treader.source = source;
+	treader.reader = reader;
+	m_readers[owner] = treader;
+}
+
+void CTrafficCapture::UnregisterReader(const void *owner)
+{
+	// waits for a delivery in progress, the owner can be destroyed afterwards
+	std::lock_guard<std::mutex> l(m_readers_mutex);
+	m_readers.erase(owner);
+}
+
+std::chrono::steady_clock::time_point CTrafficCapture::GetOrigin()
+{
+	return t_origin;
+}
+
+void CTrafficCapture::SetOrigin(const std::chrono::steady_clock::time_point origin)
+{
+	t_origin = origin;
+}
+
+void CTrafficCapture::OnDeviceReceived()
+{
+	if (t_origin == std::chrono::steady_clock::time_point())
+		return; // not caused by the replayed data
+	uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t_origin).count();
+	m_updates++;
+	m_total_latency_us += us;
+	uint64_t max_us = m_max_latency_us.load();
+	while ((us > max_us) && (!m_max_latency_us.compare_exchange_weak(max_us, us)))
+		;
+}
+
+bool CTrafficCapture::WaitForReaders()
+{
+	auto tstart = std::chrono::steady_clock::now();
+	while (!m_bStopPlayback)
+	{
+		size_t registered = 0;
+		{
+			std::lock_guard<std::mutex> l(m_readers_mutex);
+			for (const auto &source : m_sources)
+			{
+				for (const auto &itt : m_readers)
+				{
+					if (ReaderKey(itt.second.kind, itt.second.source) == source)
+					{
+						registered++;
+						break;
+					}
+				}
+			}
+		}
+		if (registered == m_sources.size())
+			return true;
+		if (std::chrono::steady_clock::now() - tstart > std::chrono::seconds(TRAFFIC_REPLAY_CONNECT_TIMEOUT))
+			return false;
+		sleep_milliseconds(100);
+	}
+	return false;
+}
+
+bool CTrafficCapture::Deliver(const _tTrafficRecord &record)
+{
+	std::lock_guard<std::mutex> l(m_readers_mutex);
+	for (const auto &itt : m_readers)
+	{
+		if ((itt.second.kind == record.kind) && (itt.second.source == record.source))
+		{
+			t_origin = std::chrono::steady_clock::now();
+			itt.second.reader(record.topic, record.data);
+			t_origin = std::chrono::steady_clock::time_point();
+			return true;
+		}
+	}
+	return false;
+}
+
+void CTrafficCapture::Do_Playback()
+{
+	if (!WaitForReaders())
+	{
+		if (m_bStopPlayback)
+			return;
+		_log.Log(LOG_ERROR, "Replay: not all recorded connections were opened, their data is skipped");
+	}
+	_log.Log(LOG_STATUS, "Replay: started (speed: %s)", (m_speed > 0) ? std_format("%gx", m_speed).c_str() : "max");
+
+	uint64_t sql_start = GetSQLStatementCount();
+	uint64_t processed_start = 0;
+	for (const auto &stats : m_mainworker.GetRxLaneStats())
+		processed_start += stats.processed;
+
+	auto tstart = std::chrono::steady_clock::now();
+	uint64_t delivered = 0;
+	uint64_t skipped = 0;
+	for (const auto &record : m_records)
+	{
+		if (m_bStopPlayback)
+			return;
+		if (m_speed > 0)
+		{
+			auto tdue = tstart + std::chrono::microseconds(static_cast<uint64_t>(double(record.ms) * 1000.0 / m_speed));
+			while ((!m_bStopPlayback) && (std::chrono::steady_clock::now() < tdue))
+				std::this_thread::sleep_until(std::min(tdue, std::chrono::steady_clock::now() + std::chrono::milliseconds(100)));
+		}
+		if (Deliver(record))
+			delivered++;
+		else
+			skipped++;
+	}
+
+	// wait until the decoded messages went through the database
+	auto tend = std::chrono::steady_clock::now();
+	uint64_t processed = processed_start;
+	while (!m_bStopPlayback)
+	{
+		sleep_milliseconds(200);
+		size_t depth = 0;
+		uint64_t now_processed = 0;
+		for (const auto &stats : m_mainworker.GetRxLaneStats())
+		{
+			depth += stats.depth;
+			now_processed += stats.processed;
+		}
+		if ((depth == 0) && (now_processed == processed))
+			break;
+		if (now_processed != processed)
+			tend = std::chrono::steady_clock::now();
+		processed = now_processed;
+		if (std::chrono::steady_clock::now() - tend > std::chrono::seconds(TRAFFIC_REPLAY_DRAIN_TIMEOUT))
+			break;
+	}
+	if (m_bStopPlayback)
+		return;
+
+	double seconds = std::chrono::duration<double>(tend - tstart).count();
+	uint64_t updates = m_updates;
+	uint64_t statements = GetSQLStatementCount() - sql_start;
+	_log.Log(LOG_STATUS, "Replay: %" PRIu64 " messages (%" PRIu64 " skipped) in %.3f sec, %.1f messages/s", delivered, skipped, seconds,
+		 (seconds > 0) ? (double(delivered) / seconds) : 0.0);
+	_log.Log(LOG_STATUS, "Replay: %" PRIu64 " device updates, latency avg: %.3f ms, max: %.3f ms", updates,
+		 (updates > 0) ? (double(m_total_latency_us) / double(updates) / 1000.0) : 0.0, double(m_max_latency_us) / 1000.0);
+	_log.Log(LOG_STATUS, "Replay: %" PRIu64 " SQL statements, %.2f per message", statements, (delivered > 0) ? (double(statements) / double(delivered)) : 0.0);
+
+	// the replay is a one shot run
+	g_bStopApplication = true;
+}
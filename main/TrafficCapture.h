@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/signals2.hpp>
+
+#define TRAFFIC_SERIAL 'S'
+#define TRAFFIC_TCP 'T'
+#define TRAFFIC_MQTT 'M'
+
+//Waits this long for the hardware to open its connections before the replay starts
+#define TRAFFIC_REPLAY_CONNECT_TIMEOUT 30
+//Waits this long for the received messages to be processed after the last one was replayed
+#define TRAFFIC_REPLAY_DRAIN_TIMEOUT 60
+
+//Records the raw data received by serial (AsyncSerial), TCP (ASyncTCP) and MQTT
+//connections to a capture file, and plays such a file back into the same readers.
+//
+//The capture file is plain text, one line per received chunk:
+//	<ms since start> <tab> <S|T|M> <tab> <source> <tab> <mqtt topic> <tab> <data in hex>
+//The source is the serial port, or address:port for TCP and MQTT. The enabled
+//hardware is stored as '#hardware' lines (without user names, passwords, Extra and
+//Configuration) so a replay can recreate it in an empty database.
+//
+//During a replay the connections do not open a port or socket, they register here
+//and get the recorded data (at the recorded pace times the speed, or as fast as possible),
+//data written to the hardware is dropped.
+class CTrafficCapture
+{
+      public:
+	typedef std::function<void(const std::string &topic, const std::string &data)> TTrafficReader;
+
+	CTrafficCapture() = default;
+	~CTrafficCapture();
+
+	CTrafficCapture(const CTrafficCapture &) = delete;
+	CTrafficCapture &operator=(const CTrafficCapture &) = delete;
+
+	bool StartCapture(const std::string &filename);
+	//speed: 1 = as recorded, 10 = ten times faster, 0 = as fast as possible
+	bool LoadReplay(const std::string &filename, double speed);
+	void Stop();
+
+	bool IsCapturing() const
+	{
+		return m_bCapturing;
+	};
+	bool IsReplaying() const
+	{
+		return m_bReplaying;
+	};
+
+	//Capture
+	void Record(char kind, const std::string &source, const std::string &topic, const uint8_t *pData, size_t length);
+	void RecordHardware();
+
+	//Replay
+	void RestoreHardware();
+	void StartPlayback();
+	void RegisterReader(char kind, const std::string &source, const void *owner, const TTrafficReader &reader);
+	void UnregisterReader(const void *owner);
+	//When the replayed data handled by this thread was delivered (zero if none). A reader
+	//that hands the data to another thread passes it along, the rx queue carries it to the
+	//device update, where the latency is taken
+	static std::chrono::steady_clock::time_point GetOrigin();
+	static void SetOrigin(std::chrono::steady_clock::time_point origin);
+
+      private:
+	struct _tTrafficRecord
+	{
+		uint64_t ms;
+		char kind;
+		std::string source;
+		std::string topic;
+		std::string data;
+	};
+	struct _tTrafficReader
+	{
+		char kind;
+		std::string source;
+		TTrafficReader reader;
+	};
+
+	void Do_Playback();
+	bool WaitForReaders();
+	bool Deliver(const _tTrafficRecord &record);
+	static std::string ReaderKey(char kind, const std::string &source);
+	void OnDeviceReceived();
+
+	std::atomic<bool> m_bCapturing{ false };
+	std::atomic<bool> m_bReplaying{ false };
+
+	std::mutex m_capture_mutex;
+	std::ofstream m_capturefile;
+	std::chrono::steady_clock::time_point m_capture_start;
+
+	double m_speed = 1.0;
+	std::vector<std::string> m_hardware;
+	std::vector<_tTrafficRecord> m_records;
+	std::set<std::string> m_sources;
+
+	std::mutex m_readers_mutex;
+	std::map<const void *, _tTrafficReader> m_readers;
+
+	std::shared_ptr<std::thread> m_thread;
+	std::atomic<bool> m_bStopPlayback{ false };
+
+	//device updates caused by the replay, delivery until sOnDeviceReceived
+	boost::signals2::connection m_sDeviceReceivedConnection;
+	std::atomic<uint64_t> m_updates{ 0 };
+	std::atomic<uint64_t> m_total_latency_us{ 0 };
+	std::atomic<uint64_t> m_max_latency_us{ 0 };
+};
+
+extern CTrafficCapture m_trafficcapture;
@@ -10,6 +10,7 @@
 #include "EventSystem.h"
 #include "HTMLSanitizer.h"
 #include "dzVents.h"
+#include "IoContextPool.h"
 #include "../httpclient/HTTPClient.h"
 #include "../hardware/hardwaretypes.h"
 
@@ -104,10 +105,19 @@ namespace
 		{ "pl", "Polish" }, { "pt", "Portuguese" }, { "ro", "Romanian" }, { "ru", "Russian" }, { "sr", "Serbian" }, { "sk", "Slovak" },
 		{ "sl", "Slovenian" }, { "es", "Spanish" }, { "sv", "Swedish" }, { "zh_TW", "Taiwanese" }, { "tr", "Turkish" }, { "uk", "Ukrainian" },
 		} };
+
+	// A cached device list is rebuilt after this many seconds (sensor timeouts, today counters)
+	constexpr time_t DEVICE_LIST_CACHE_MAX_AGE = 10;
+	constexpr size_t DEVICE_LIST_CACHE_MAX_ENTRIES = 32;
+	// lastupdate polls older than this are answered without the change tracking
+	constexpr time_t DEVICE_LIST_VERSION_HISTORY = 600;
 } // namespace
 
 extern http::server::CWebServerHelper m_webservers;
 
+//Set while the current thread is handling a JSon request (and holds a shared m_webStateMutex lock)
+static thread_local bool g_bInJSonHandler = false;
+
 namespace http
 {
 	namespace server
@@ -165,6 +175,13 @@ namespace http
 
 		void CWebServer::ReloadCustomSwitchIcons()
 		{
+			if (g_bInJSonHandler)
+			{
+				m_bReloadIconsPending = true;
+				return;
+			}
+			boost::unique_lock<boost::shared_mutex> lock(m_webStateMutex);
+			ClearDeviceListCache();
 			m_custom_light_icons.clear();
 			m_custom_light_icons_lookup.clear();
 			std::string sLine;
@@ -199,7 +216,7 @@ namespace http
 			}
 			// Now get them from the database (idx 100+)
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT ID,Base,Name,Description FROM CustomImages");
+			result = m_sql.safe_query_readonly("SELECT ID,Base,Name,Description FROM CustomImages");
 			if (!result.empty())
 			{
 				int ii = 0;
@@ -412,6 +429,11 @@ namespace http
 			RegisterCommandCode(
 				"getuptime", [this](auto&& session, auto&& req, auto&& root) { Cmd_GetUptime(session, req, root); }, true);
 
+			RegisterCommandCode("getsqlstats", [this](auto&& session, auto&& req, auto&& root) { Cmd_GetSQLStats(session, req, root); });
+			RegisterCommandCode("getiopoolstats", [this](auto&& session, auto&& req, auto&& root) { Cmd_GetIoPoolStats(session, req, root); });
+			RegisterCommandCode("getluascriptstats", [this](auto&& session, auto&& req, auto&& root) { Cmd_GetLuaScriptStats(session, req, root); });
+			RegisterCommandCode("getrxqueuestats", [this](auto&& session, auto&& req, auto&& root) { Cmd_GetRxQueueStats(session, req, root); });
+
 			RegisterCommandCode("storesettings", [this](auto&& session, auto&& req, auto&& root) { Cmd_PostSettings(session, req, root); });
 			RegisterCommandCode("getlog", [this](auto&& session, auto&& req, auto&& root) { Cmd_GetLog(session, req, root); });
 			RegisterCommandCode("clearlog", [this](auto&& session, auto&& req, auto&& root) { Cmd_ClearLog(session, req, root); });
@@ -488,6 +510,7 @@ namespace http
 			RegisterCommandCode("saveinfluxlinkconfig", [this](auto&& session, auto&& req, auto&& root) { Cmd_SaveInfluxLinkConfig(session, req, root); });
 			RegisterCommandCode("getinfluxlinkconfig", [this](auto&& session, auto&& req, auto&& root) { Cmd_GetInfluxLinkConfig(session, req, root); });
 			RegisterCommandCode("getinfluxlinks", [this](auto&& session, auto&& req, auto&& root) { Cmd_GetInfluxLinks(session, req, root); });
+			RegisterCommandCode("getinfluxlinkstats", [this](auto&& session, auto&& req, auto&& root) { Cmd_GetInfluxLinkStats(session, req, root); });
 			RegisterCommandCode("saveinfluxlink", [this](auto&& session, auto&& req, auto&& root) { Cmd_SaveInfluxLink(session, req, root); });
 			RegisterCommandCode("deleteinfluxlink", [this](auto&& session, auto&& req, auto&& root) { Cmd_DeleteInfluxLink(session, req, root); });
 
@@ -527,6 +550,7 @@ namespace http
 			RegisterCommandCode("changeplandeviceorder", [this](auto&& session, auto&& req, auto&& root) { Cmd_ChangePlanDeviceOrder(session, req, root); });
 
 			RegisterCommandCode("gettimerplans", [this](auto&& session, auto&& req, auto&& root) { Cmd_GetTimerPlans(session, req, root); });
+			RegisterCommandCode("getupcomingtimers", [this](auto&& session, auto&& req, auto&& root) { Cmd_GetUpcomingTimers(session, req, root); });
 			RegisterCommandCode("addtimerplan", [this](auto&& session, auto&& req, auto&& root) { Cmd_AddTimerPlan(session, req, root); });
 			RegisterCommandCode("updatetimerplan", [this](auto&& session, auto&& req, auto&& root) { Cmd_UpdateTimerPlan(session, req, root); });
 			RegisterCommandCode("deletetimerplan", [this](auto&& session, auto&& req, auto&& root) { Cmd_DeleteTimerPlan(session, req, root); });
@@ -619,7 +643,6 @@ namespace http
 			RegisterRType("events", [this](auto&& session, auto&& req, auto&& root) { RType_Events(session, req, root); });
 
 			RegisterRType("hardware", [this](auto&& session, auto&& req, auto&& root) { RType_Hardware(session, req, root); });
-			RegisterRType("devices", [this](auto&& session, auto&& req, auto&& root) { RType_Devices(session, req, root); });
 			RegisterRType("deletedevice", [this](auto&& session, auto&& req, auto&& root) { RType_DeleteDevice(session, req, root); });
 			RegisterRType("cameras", [this](auto&& session, auto&& req, auto&& root) { RType_Cameras(session, req, root); });
 			RegisterRType("cameras_user", [this](auto&& session, auto&& req, auto&& root) { RType_CamerasUser(session, req, root); });
@@ -821,21 +844,49 @@ namespace http
 		{
 			Json::Value root;
 			root["status"] = "ERR";
+			bool bHaveContent = false;
 
-			std::string rtype = request::findValue(&req, "type");
-			if (rtype == "command")
+			RunPendingReloads();
 			{
-				std::string cparam = request::findValue(&req, "param");
-				if (!cparam.empty())
+				boost::shared_lock<boost::shared_mutex> lock(m_webStateMutex);
+				g_bInJSonHandler = true;
+				try
 				{
-					_log.Debug(DEBUG_WEBSERVER, "CWebServer::GetJSonPage() :%s :%s ", cparam.c_str(), req.uri.c_str());
-					HandleCommand(cparam, session, req, root);
+					std::string rtype = request::findValue(&req, "type");
+					if (rtype == "command")
+					{
+						std::string cparam = request::findValue(&req, "param");
+						if (cparam == "getdevices")
+						{
+							GetJSonDevicesPage(session, req, rep);
+							bHaveContent = true;
+						}
+						else if (!cparam.empty())
+						{
+							_log.Debug(DEBUG_WEBSERVER, "CWebServer::GetJSonPage() :%s :%s ", cparam.c_str(), req.uri.c_str());
+							HandleCommand(cparam, session, req, root);
+						}
+					} //(rtype=="command")
+					else if (rtype == "devices")
+					{
+						GetJSonDevicesPage(session, req, rep);
+						bHaveContent = true;
+					}
+					else
+					{
+						HandleRType(rtype, session, req, root);
+					}
 				}
-			} //(rtype=="command")
-			else
-			{
-				HandleRType(rtype, session, req, root);
+				catch (...)
+				{
+					g_bInJSonHandler = false;
+					throw;
+				}
+				g_bInJSonHandler = false;
 			}
+			RunPendingReloads();
+			if (bHaveContent)
+				return;
 
 			std::string jcallback = request::findValue(&req, "jsoncallback");
 			if (!jcallback.empty())
@@ -846,6 +897,14 @@ namespace http
 			reply::set_content(&rep, root.toStyledString());
 		}
 
+		void CWebServer::RunPendingReloads()
+		{
+			if (m_bLoadUsersPending.exchange(false))
+				LoadUsers();
+			if (m_bReloadIconsPending.exchange(false))
+				ReloadCustomSwitchIcons();
+		}
+
 		void CWebServer::Cmd_GetLanguage(WebEmSession& session, const request& req, Json::Value& root)
 		{
 			std::string sValue;
@@ -1149,7 +1208,7 @@ namespace http
 			{
 				// There should be only one
 				std::vector<std::vector<std::string>> result;
-				result = m_sql.safe_query("SELECT ID FROM Hardware WHERE (Type==%d)", HTYPE_System);
+				result = m_sql.safe_query_readonly("SELECT ID FROM Hardware WHERE (Type==%d)", HTYPE_System);
 				if (!result.empty())
 					return;
 			}
@@ -1516,7 +1575,7 @@ namespace http
 			{
 				// There should be only one, and with this ID
 				std::vector<std::vector<std::string>> result;
-				result = m_sql.safe_query("SELECT ID FROM Hardware WHERE (Type==%d)", HTYPE_System);
+				result = m_sql.safe_query_readonly("SELECT ID FROM Hardware WHERE (Type==%d)", HTYPE_System);
 				if (!result.empty())
 				{
 					int hID = atoi(result[0][0].c_str());
@@ -1771,7 +1830,7 @@ namespace http
 						name.c_str(), (bEnabled == true) ? 1 : 0, htype, iLogLevelEnabled, address.c_str(), port, sport.c_str(), username.c_str(), password.c_str(),
 						mode1, mode2, mode3, mode4, mode5, mode6, iDataTimeout, idx.c_str());
 					std::vector<std::vector<std::string>> result;
-					result = m_sql.safe_query("SELECT Extra FROM Hardware WHERE ID=%q", idx.c_str());
+					result = m_sql.safe_query_readonly("SELECT Extra FROM Hardware WHERE ID=%q", idx.c_str());
 					if (!result.empty())
 						extra = result[0][0];
 				}
@@ -1801,7 +1860,7 @@ namespace http
 			if (idx.empty())
 				return;
 			std::vector<std::vector<std::string>> devresult;
-			devresult = m_sql.safe_query("SELECT Type, SubType FROM DeviceStatus WHERE (ID=='%q')", idx.c_str());
+			devresult = m_sql.safe_query_readonly("SELECT Type, SubType FROM DeviceStatus WHERE (ID=='%q')", idx.c_str());
 			if (!devresult.empty())
 			{
 				int devType = std::stoi(devresult[0][0]);
@@ -1833,7 +1892,7 @@ namespace http
 				return;
 			std::string wording;
 			std::vector<std::vector<std::string>> devresult;
-			devresult = m_sql.safe_query("SELECT Type, SubType FROM DeviceStatus WHERE (ID=='%q')", idx.c_str());
+			devresult = m_sql.safe_query_readonly("SELECT Type, SubType FROM DeviceStatus WHERE (ID=='%q')", idx.c_str());
 			if (!devresult.empty())
 			{
 				int devType = std::stoi(devresult[0][0]);
@@ -1964,7 +2023,7 @@ namespace http
 			std::vector<std::vector<std::string>> result;
 			if (idx.empty())
 			{
-				result = m_sql.safe_query("SELECT ID FROM UserVariables WHERE Name='%q'", variablename.c_str());
+				result = m_sql.safe_query_readonly("SELECT ID FROM UserVariables WHERE Name='%q'", variablename.c_str());
 				if (result.empty())
 				{
 					root["message"] = "Uservariable " + variablename + " does not exist";
@@ -1973,7 +2032,7 @@ namespace http
 				idx = result[0][0];
 			}
 
-			result = m_sql.safe_query("SELECT Name, ValueType FROM UserVariables WHERE ID='%q'", idx.c_str());
+			result = m_sql.safe_query_readonly("SELECT Name, ValueType FROM UserVariables WHERE ID='%q'", idx.c_str());
 			if (result.empty())
 			{
 				root["message"] = "Uservariable " + variablename + " does not exist";
@@ -2005,7 +2064,7 @@ namespace http
 		void CWebServer::Cmd_GetUserVariables(WebEmSession& session, const request& req, Json::Value& root)
 		{
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT ID, Name, ValueType, Value, LastUpdate FROM UserVariables");
+			result = m_sql.safe_query_readonly("SELECT ID, Name, ValueType, Value, LastUpdate FROM UserVariables");
 			int ii = 0;
 			for (const auto& sd : result)
 			{
@@ -2029,7 +2088,7 @@ namespace http
 			int iVarID = atoi(idx.c_str());
 
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT ID, Name, ValueType, Value, LastUpdate FROM UserVariables WHERE (ID==%d)", iVarID);
+			result = m_sql.safe_query_readonly("SELECT ID, Name, ValueType, Value, LastUpdate FROM UserVariables WHERE (ID==%d)", iVarID);
 			int ii = 0;
 			for (const auto& sd : result)
 			{
@@ -2073,7 +2132,7 @@ namespace http
 				return;
 			int hwID = atoi(idx.c_str());
 
-			CDomoticzHardwareBase* pBaseHardware = m_mainworker.GetHardware(hwID);
+			std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(hwID);
 			if ((pBaseHardware != nullptr) && (pBaseHardware->HwdType == HTYPE_DomoticzInternal))
 			{
 				// DomoticzInternal cannot be removed
@@ -2212,7 +2271,7 @@ namespace http
 
 			std::vector<std::vector<std::string>> result;
 			std::vector<std::vector<std::string>> result2;
-			result = m_sql.safe_query("SELECT T1.[ID], T1.[Name], T1.[Type], T1.[SubType], T2.[Name] AS HardwareName FROM DeviceStatus as T1, Hardware as T2 WHERE (T1.[Used]==1) AND "
+			result = m_sql.safe_query_readonly("SELECT T1.[ID], T1.[Name], T1.[Type], T1.[SubType], T2.[Name] AS HardwareName FROM DeviceStatus as T1, Hardware as T2 WHERE (T1.[Used]==1) AND "
 				"(T2.[ID]==T1.[HardwareID]) ORDER BY T2.[Name], T1.[Name]");
 			if (!result.empty())
 			{
@@ -2221,7 +2280,7 @@ namespace http
 					bool bDoAdd = true;
 					if (iUnique)
 					{
-						result2 = m_sql.safe_query("SELECT ID FROM DeviceToPlansMap WHERE (DeviceRowID=='%q') AND (DevSceneType==0)", sd[0].c_str());
+						result2 = m_sql.safe_query_readonly("SELECT ID FROM DeviceToPlansMap WHERE (DeviceRowID=='%q') AND (DevSceneType==0)", sd[0].c_str());
 						bDoAdd = (result2.empty());
 					}
 					if (bDoAdd)
@@ -2236,7 +2295,7 @@ namespace http
 				}
 			}
 			// Add Scenes
-			result = m_sql.safe_query("SELECT ID, Name FROM Scenes ORDER BY Name COLLATE NOCASE ASC");
+			result = m_sql.safe_query_readonly("SELECT ID, Name FROM Scenes ORDER BY Name COLLATE NOCASE ASC");
 			if (!result.empty())
 			{
 				for (const auto& sd : result)
@@ -2244,7 +2303,7 @@ namespace http
 					bool bDoAdd = true;
 					if (iUnique)
 					{
-						result2 = m_sql.safe_query("SELECT ID FROM DeviceToPlansMap WHERE (DeviceRowID=='%q') AND (DevSceneType==1)", sd[0].c_str());
+						result2 = m_sql.safe_query_readonly("SELECT ID FROM DeviceToPlansMap WHERE (DeviceRowID=='%q') AND (DevSceneType==1)", sd[0].c_str());
 						bDoAdd = (result2.empty());
 					}
 					if (bDoAdd)
@@ -2279,7 +2338,7 @@ namespace http
 
 			// check if it is not already there
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT ID FROM DeviceToPlansMap WHERE (DeviceRowID=='%q') AND (DevSceneType==%d) AND (PlanID=='%q')", activeidx.c_str(), activetype, idx.c_str());
+			result = m_sql.safe_query_readonly("SELECT ID FROM DeviceToPlansMap WHERE (DeviceRowID=='%q') AND (DevSceneType==%d) AND (PlanID=='%q')", activeidx.c_str(), activetype, idx.c_str());
 			if (result.empty())
 			{
 				m_sql.safe_query("INSERT INTO DeviceToPlansMap (DevSceneType,DeviceRowID, PlanID) VALUES (%d,'%q','%q')", activetype, activeidx.c_str(), idx.c_str());
@@ -2295,7 +2354,7 @@ namespace http
 			root["title"] = "GetPlanDevices";
 
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT ID, DevSceneType, DeviceRowID, [Order] FROM DeviceToPlansMap WHERE (PlanID=='%q') ORDER BY [Order]", idx.c_str());
+			result = m_sql.safe_query_readonly("SELECT ID, DevSceneType, DeviceRowID, [Order] FROM DeviceToPlansMap WHERE (PlanID=='%q') ORDER BY [Order]", idx.c_str());
 			if (!result.empty())
 			{
 				int ii = 0;
@@ -2309,7 +2368,7 @@ namespace http
 					if (DevSceneType == 0)
 					{
 						std::vector<std::vector<std::string>> result2;
-						result2 = m_sql.safe_query("SELECT Name FROM DeviceStatus WHERE (ID=='%q')", DevSceneRowID.c_str());
+						result2 = m_sql.safe_query_readonly("SELECT Name FROM DeviceStatus WHERE (ID=='%q')", DevSceneRowID.c_str());
 						if (!result2.empty())
 						{
 							Name = result2[0][0];
@@ -2318,7 +2377,7 @@ namespace http
 					else
 					{
 						std::vector<std::vector<std::string>> result2;
-						result2 = m_sql.safe_query("SELECT Name FROM Scenes WHERE (ID=='%q')", DevSceneRowID.c_str());
+						result2 = m_sql.safe_query_readonly("SELECT Name FROM Scenes WHERE (ID=='%q')", DevSceneRowID.c_str());
 						if (!result2.empty())
 						{
 							Name = "[Scene] " + result2[0][0];
@@ -2399,7 +2458,7 @@ namespace http
 			std::string aOrder, oID, oOrder;
 
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT [Order] FROM Plans WHERE (ID=='%q')", idx.c_str());
+			result = m_sql.safe_query_readonly("SELECT [Order] FROM Plans WHERE (ID=='%q')", idx.c_str());
 			if (result.empty())
 				return;
 			aOrder = result[0][0];
@@ -2407,7 +2466,7 @@ namespace http
 			if (!bGoUp)
 			{
 				// Get next device order
-				result = m_sql.safe_query("SELECT ID, [Order] FROM Plans WHERE ([Order]>'%q') ORDER BY [Order] ASC", aOrder.c_str());
+				result = m_sql.safe_query_readonly("SELECT ID, [Order] FROM Plans WHERE ([Order]>'%q') ORDER BY [Order] ASC", aOrder.c_str());
 				if (result.empty())
 					return;
 				oID = result[0][0];
@@ -2416,7 +2475,7 @@ namespace http
 			else
 			{
 				// Get previous device order
-				result = m_sql.safe_query("SELECT ID, [Order] FROM Plans WHERE ([Order]<'%q') ORDER BY [Order] DESC", aOrder.c_str());
+				result = m_sql.safe_query_readonly("SELECT ID, [Order] FROM Plans WHERE ([Order]<'%q') ORDER BY [Order] DESC", aOrder.c_str());
 				if (result.empty())
 					return;
 				oID = result[0][0];
@@ -2442,7 +2501,7 @@ namespace http
 			std::string aOrder, oID, oOrder;
 
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT [Order] FROM DeviceToPlansMap WHERE ((ID=='%q') AND (PlanID=='%q'))", idx.c_str(), planid.c_str());
+			result = m_sql.safe_query_readonly("SELECT [Order] FROM DeviceToPlansMap WHERE ((ID=='%q') AND (PlanID=='%q'))", idx.c_str(), planid.c_str());
 			if (result.empty())
 				return;
 			aOrder = result[0][0];
@@ -2450,7 +2509,7 @@ namespace http
 			if (!bGoUp)
 			{
 				// Get next device order
-				result = m_sql.safe_query("SELECT ID, [Order] FROM DeviceToPlansMap WHERE (([Order]>'%q') AND (PlanID=='%q')) ORDER BY [Order] ASC", aOrder.c_str(), planid.c_str());
+				result = m_sql.safe_query_readonly("SELECT ID, [Order] FROM DeviceToPlansMap WHERE (([Order]>'%q') AND (PlanID=='%q')) ORDER BY [Order] ASC", aOrder.c_str(), planid.c_str());
 				if (result.empty())
 					return;
 				oID = result[0][0];
@@ -2459,7 +2518,7 @@ namespace http
 			else
 			{
 				// Get previous device order
-				result = m_sql.safe_query("SELECT ID, [Order] FROM DeviceToPlansMap WHERE (([Order]<'%q') AND (PlanID=='%q')) ORDER BY [Order] DESC", aOrder.c_str(), planid.c_str());
+				result = m_sql.safe_query_readonly("SELECT ID, [Order] FROM DeviceToPlansMap WHERE (([Order]<'%q') AND (PlanID=='%q')) ORDER BY [Order] DESC", aOrder.c_str(), planid.c_str());
 				if (result.empty())
 					return;
 				oID = result[0][0];
@@ -2531,6 +2590,115 @@ namespace http
 			root["seconds"] = seconds;
 		}
 
+		void CWebServer::Cmd_GetSQLStats(WebEmSession& session, const request& req, Json::Value& root)
+		{
+			if (session.rights != 2)
+			{
+				session.reply_status = reply::forbidden;
+				return; // Only admin user allowed
+			}
+			root["status"] = "OK";
+			root["title"] = "GetSQLStats";
+
+			int ii = 0;
+			for (const auto& stat : m_sql.GetConnectionStats())
+			{
+				root["connections"][ii]["name"] = stat.name;
+				root["connections"][ii]["queries"] = (Json::Value::UInt64)stat.queries;
+				root["connections"][ii]["waits"] = (Json::Value::UInt64)stat.waits;
+				ii++;
+			}
+
+			_tDeviceIndexStats indexStats = m_sql.GetDeviceIndexStats();
+			root["deviceindex"]["hits"] = (Json::Value::UInt64)indexStats.hits;
+			root["deviceindex"]["misses"] = (Json::Value::UInt64)indexStats.misses;
+			root["deviceindex"]["invalidations"] = (Json::Value::UInt64)indexStats.invalidations;
+			root["deviceindex"]["size"] = (Json::Value::UInt64)indexStats.size;
+		}
+
+		void CWebServer::Cmd_GetIoPoolStats(WebEmSession& session, const request& req, Json::Value& root)
+		{
+			if (session.rights != 2)
+			{
+				session.reply_status = reply::forbidden;
+				return; // Only admin user allowed
+			}
+			root["status"] = "OK";
+			root["title"] = "GetIoPoolStats";
+			root["threads"] = m_iopool.GetThreadCount();
+
+			int ii = 0;
+			for (const auto& stat : m_iopool.GetConnectionStats())
+			{
+				root["connections"][ii]["name"] = stat.name;
+				root["connections"][ii]["handlers"] = (Json::Value::UInt64)stat.handlers;
+				root["connections"][ii]["pending"] = stat.pending;
+				root["connections"][ii]["avg_us"] = (Json::Value::UInt64)((stat.handlers != 0) ? stat.total_us / stat.handlers : 0);
+				root["connections"][ii]["max_us"] = (Json::Value::UInt64)stat.max_us;
+				ii++;
+			}
+		}
+
+		void CWebServer::Cmd_GetLuaScriptStats(WebEmSession& session, const request& req, Json::Value& root)
+		{
+			if (session.rights != 2)
+			{
+				session.reply_status = reply::forbidden;
+				return; // Only admin user allowed
+			}
+			root["status"] = "OK";
+			root["title"] = "GetLuaScriptStats";
+
+			_tLuaStatePoolStats pstats = m_mainworker.m_eventsystem.GetLuaStatePoolStats();
+			root["states_created"] = (Json::Value::UInt64)pstats.created;
+			root["states_reused"] = (Json::Value::UInt64)pstats.reused;
+			root["states_idle"] = (Json::Value::UInt64)pstats.idle;
+
+			int ii = 0;
+			for (const auto& stat : m_mainworker.m_eventsystem.GetLuaScriptStats())
+			{
+				root["result"][ii]["name"] = stat.name;
+				root["result"][ii]["runs"] = (Json::Value::UInt64)stat.runs;
+				root["result"][ii]["avg_us"] = (Json::Value::UInt64)((stat.runs != 0) ? stat.total_us / stat.runs : 0);
+				root["result"][ii]["max_us"] = (Json::Value::UInt64)stat.max_us;
+				root["result"][ii]["avg_bytes"] = (Json::Value::UInt64)((stat.runs != 0) ? stat.total_bytes / stat.runs : 0);
+				root["result"][ii]["max_bytes"] = (Json::Value::UInt64)stat.max_bytes;
+				ii++;
+			}
+		}
+
+		void CWebServer::Cmd_GetRxQueueStats(WebEmSession& session, const request& req, Json::Value& root)
+		{
+			if (session.rights != 2)
+			{
+				session.reply_status = reply::forbidden;
+				return; // Only admin user allowed
+			}
+			root["status"] = "OK";
+			root["title"] = "GetRxQueueStats";
+
+			int ii = 0;
+			for (const auto& stat : m_mainworker.GetRxLaneStats())
+			{
+				root["result"][ii]["lane"] = ii;
+				root["result"][ii]["depth"] = (Json::Value::UInt64)stat.depth;
+				root["result"][ii]["high_water_mark"] = (Json::Value::UInt64)stat.high_water_mark;
+				root["result"][ii]["processed"] = (Json::Value::UInt64)stat.processed;
+				root["result"][ii]["dropped"] = (Json::Value::UInt64)stat.dropped;
+				root["result"][ii]["avg_wait_us"] = (Json::Value::UInt64)((stat.processed != 0) ? stat.total_wait_us / stat.processed : 0);
+				root["result"][ii]["avg_us"] = (Json::Value::UInt64)((stat.processed != 0) ? stat.total_us / stat.processed : 0);
+				root["result"][ii]["max_us"] = (Json::Value::UInt64)stat.max_us;
+				ii++;
+			}
+
+			queue_stats estats = m_mainworker.m_eventsystem.GetQueueStats();
+			root["eventqueue"]["capacity"] = (Json::Value::UInt64)estats.capacity;
+			root["eventqueue"]["depth"] = (Json::Value::UInt64)estats.depth;
+			root["eventqueue"]["high_water_mark"] = (Json::Value::UInt64)estats.high_water_mark;
+			root["eventqueue"]["pushed"] = (Json::Value::UInt64)estats.pushed;
+			root["eventqueue"]["dropped"] = (Json::Value::UInt64)estats.dropped;
+		}
+
 		void CWebServer::Cmd_GetActualHistory(WebEmSession& session, const request& req, Json::Value& root)
 		{
 			root["status"] = "OK";
@@ -2677,7 +2845,7 @@ namespace http
 			if (UserID != -1)
 			{
 				std::vector<std::vector<std::string>> result;
-				result = m_sql.safe_query("SELECT TabsEnabled FROM Users WHERE (ID==%lu)", UserID);
+				result = m_sql.safe_query_readonly("SELECT TabsEnabled FROM Users WHERE (ID==%lu)", UserID);
 				if (!result.empty())
 				{
 					int TabsEnabled = atoi(result[0][0].c_str());
@@ -2820,13 +2988,13 @@ namespace http
 			if (root["Forecasthardware"] > 0)
 			{
 				int iHardwareID = root["Forecasthardware"].asInt();
-				CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(iHardwareID);
+				std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(iHardwareID);
 				if (pHardware != nullptr)
 				{
 					if (pHardware->HwdType == HTYPE_OpenWeatherMap)
 					{
 						root["Forecasthardwaretype"] = HTYPE_OpenWeatherMap;
-						COpenWeatherMap* pWHardware = dynamic_cast<COpenWeatherMap*>(pHardware);
+						COpenWeatherMap* pWHardware = dynamic_cast<COpenWeatherMap*>(pHardware.get());
 						forecast_url = pWHardware->GetForecastURL();
 						if (!forecast_url.empty())
 						{
@@ -2842,7 +3010,7 @@ namespace http
 					else if (pHardware->HwdType == HTYPE_BuienRadar)
 					{
 						root["Forecasthardwaretype"] = HTYPE_BuienRadar;
-						CBuienRadar* pWHardware = dynamic_cast<CBuienRadar*>(pHardware);
+						CBuienRadar* pWHardware = dynamic_cast<CBuienRadar*>(pHardware.get());
 						forecast_url = pWHardware->GetForecastURL();
 						if (!forecast_url.empty())
 						{
@@ -2852,7 +3020,7 @@ namespace http
 					else if (pHardware->HwdType == HTYPE_VisualCrossing)
 					{
 						root["Forecasthardwaretype"] = HTYPE_VisualCrossing;
-						CVisualCrossing* pWHardware = dynamic_cast<CVisualCrossing*>(pHardware);
+						CVisualCrossing* pWHardware = dynamic_cast<CVisualCrossing*>(pHardware.get());
 						forecast_url = pWHardware->GetForecastURL();
 						if (!forecast_url.empty())
 						{
@@ -2969,7 +3137,7 @@ namespace http
 			{
 				// Get the raw device parameters
 				std::vector<std::vector<std::string>> result;
-				result = m_sql.safe_query("SELECT HardwareID, DeviceID, Unit, Type, SubType FROM DeviceStatus WHERE (ID=='%q')", idx.c_str());
+				result = m_sql.safe_query_readonly("SELECT HardwareID, DeviceID, Unit, Type, SubType FROM DeviceStatus WHERE (ID=='%q')", idx.c_str());
 				if (result.empty())
 					return;
 				hid = result[0][0];
@@ -3246,7 +3414,7 @@ namespace http
 
 			char szTmp[100];
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT Type, SubType, nValue, sValue FROM DeviceStatus WHERE (ID=='%q')", idx.c_str());
+			result = m_sql.safe_query_readonly("SELECT Type, SubType, nValue, sValue FROM DeviceStatus WHERE (ID=='%q')", idx.c_str());
 			if (!result.empty())
 			{
 				root["status"] = "OK";
@@ -3397,7 +3565,7 @@ namespace http
 				return true; // all sensors
 
 			std::vector<std::vector<std::string>> result =
-				m_sql.safe_query("SELECT DeviceRowID FROM SharedDevices WHERE (SharedUserID == '%d') AND (DeviceRowID == '%d')", m_users[iUser].ID, Idx);
+				m_sql.safe_query_readonly("SELECT DeviceRowID FROM SharedDevices WHERE (SharedUserID == '%d') AND (DeviceRowID == '%d')", m_users[iUser].ID, Idx);
 			return (!result.empty());
 		}
 
@@ -3467,7 +3635,7 @@ namespace http
 					return;
 
 				// first check if it is not already a sub device
-				result = m_sql.safe_query("SELECT ID FROM LightSubDevices WHERE (DeviceRowID=='%q') AND (ParentID =='%q')", subidx.c_str(), idx.c_str());
+				result = m_sql.safe_query_readonly("SELECT ID FROM LightSubDevices WHERE (DeviceRowID=='%q') AND (ParentID =='%q')", subidx.c_str(), idx.c_str());
 				if (result.empty())
 				{
 					root["status"] = "OK";
@@ -3499,7 +3667,7 @@ namespace http
 				std::string color = _tColor(request::findValue(&req, "color")).toJSONString(); // Parse the color to detect incorrectly formatted color data
 
 				unsigned char command = 0;
-				result = m_sql.safe_query("SELECT HardwareID, DeviceID, Unit, Type, SubType, SwitchType, Options FROM DeviceStatus WHERE (ID=='%q')", devidx.c_str());
+				result = m_sql.safe_query_readonly("SELECT HardwareID, DeviceID, Unit, Type, SubType, SwitchType, Options FROM DeviceStatus WHERE (ID=='%q')", devidx.c_str());
 				if (!result.empty())
 				{
 					int dType = atoi(result[0][3].c_str());
@@ -3510,7 +3678,7 @@ namespace http
 				}
 
 				// first check if this device is not the scene code!
-				result = m_sql.safe_query("SELECT Activators, SceneType FROM Scenes WHERE (ID=='%q')", idx.c_str());
+				result = m_sql.safe_query_readonly("SELECT Activators, SceneType FROM Scenes WHERE (ID=='%q')", idx.c_str());
 				if (!result.empty())
 				{
 					// int SceneType = atoi(result[0][1].c_str());
@@ -3538,13 +3706,13 @@ namespace http
 				// first check if it is not already a part of this scene/group (with the same OnDelay)
 				if (isscene == "true")
 				{
-					result = m_sql.safe_query(
+					result = m_sql.safe_query_readonly(
 						"SELECT ID FROM SceneDevices WHERE (DeviceRowID=='%q') AND (SceneRowID =='%q') AND (OnDelay == %d) AND (OffDelay == %d) AND (Cmd == %d)",
 						devidx.c_str(), idx.c_str(), ondelay, offdelay, command);
 				}
 				else
 				{
-					result = m_sql.safe_query("SELECT ID FROM SceneDevices WHERE (DeviceRowID=='%q') AND (SceneRowID =='%q') AND (OnDelay == %d)", devidx.c_str(), idx.c_str(),
+					result = m_sql.safe_query_readonly("SELECT ID FROM SceneDevices WHERE (DeviceRowID=='%q') AND (SceneRowID =='%q') AND (OnDelay == %d)", devidx.c_str(), idx.c_str(),
 						ondelay);
 				}
 				if (result.empty())
@@ -3585,7 +3753,7 @@ namespace http
 
 				unsigned char command = 0;
 
-				result = m_sql.safe_query("SELECT HardwareID, DeviceID, Unit, Type, SubType, SwitchType, Options FROM DeviceStatus WHERE (ID=='%q')", devidx.c_str());
+				result = m_sql.safe_query_readonly("SELECT HardwareID, DeviceID, Unit, Type, SubType, SwitchType, Options FROM DeviceStatus WHERE (ID=='%q')", devidx.c_str());
 				if (!result.empty())
 				{
 					int dType = atoi(result[0][3].c_str());
@@ -3629,7 +3797,7 @@ namespace http
 
 				root["status"] = "OK";
 				root["title"] = "GetSubDevices";
-				result = m_sql.safe_query("SELECT a.ID, b.Name FROM LightSubDevices a, DeviceStatus b WHERE (a.ParentID=='%q') AND (b.ID == a.DeviceRowID)", idx.c_str());
+				result = m_sql.safe_query_readonly("SELECT a.ID, b.Name FROM LightSubDevices a, DeviceStatus b WHERE (a.ParentID=='%q') AND (b.ID == a.DeviceRowID)", idx.c_str());
 				if (!result.empty())
 				{
 					int ii = 0;
@@ -3652,7 +3820,7 @@ namespace http
 				root["status"] = "OK";
 				root["title"] = "GetSceneDevices";
 
-				result = m_sql.safe_query("SELECT a.ID, b.Name, a.DeviceRowID, b.Type, b.SubType, b.nValue, b.sValue, a.Cmd, a.Level, b.ID, a.[Order], a.Color, a.OnDelay, a.OffDelay, "
+				result = m_sql.safe_query_readonly("SELECT a.ID, b.Name, a.DeviceRowID, b.Type, b.SubType, b.nValue, b.sValue, a.Cmd, a.Level, b.ID, a.[Order], a.Color, a.OnDelay, a.OffDelay, "
 					"b.SwitchType FROM SceneDevices a, DeviceStatus b WHERE (a.SceneRowID=='%q') AND (b.ID == a.DeviceRowID) ORDER BY a.[Order]",
 					idx.c_str());
 				if (!result.empty())
@@ -3733,7 +3901,7 @@ namespace http
 				std::string aScene, aOrder, oID, oOrder;
 
 				// Get actual device order
-				result = m_sql.safe_query("SELECT SceneRowID, [Order] FROM SceneDevices WHERE (ID=='%q')", idx.c_str());
+				result = m_sql.safe_query_readonly("SELECT SceneRowID, [Order] FROM SceneDevices WHERE (ID=='%q')", idx.c_str());
 				if (result.empty())
 					return;
 				aScene = result[0][0];
@@ -3743,7 +3911,7 @@ namespace http
 				{
 					// Get next device order
 					result =
-						m_sql.safe_query("SELECT ID, [Order] FROM SceneDevices WHERE (SceneRowID=='%q' AND [Order]>'%q') ORDER BY [Order] ASC", aScene.c_str(), aOrder.c_str());
+						m_sql.safe_query_readonly("SELECT ID, [Order] FROM SceneDevices WHERE (SceneRowID=='%q' AND [Order]>'%q') ORDER BY [Order] ASC", aScene.c_str(), aOrder.c_str());
 					if (result.empty())
 						return;
 					oID = result[0][0];
@@ -3752,7 +3920,7 @@ namespace http
 				else
 				{
 					// Get previous device order
-					result = m_sql.safe_query("SELECT ID, [Order] FROM SceneDevices WHERE (SceneRowID=='%q' AND [Order]<'%q') ORDER BY [Order] DESC", aScene.c_str(),
+					result = m_sql.safe_query_readonly("SELECT ID, [Order] FROM SceneDevices WHERE (SceneRowID=='%q' AND [Order]<'%q') ORDER BY [Order] DESC", aScene.c_str(),
 						aOrder.c_str());
 					if (result.empty())
 						return;
@@ -3786,7 +3954,7 @@ namespace http
 				// used by Add Manual Light/Switch dialog
 				root["status"] = "OK";
 				root["title"] = "GetManualHardware";
-				result = m_sql.safe_query("SELECT ID, Name, Type, Enabled FROM Hardware ORDER BY ID ASC");
+				result = m_sql.safe_query_readonly("SELECT ID, Name, Type, Enabled FROM Hardware ORDER BY ID ASC");
 				if (!result.empty())
 				{
 					int ii = 0;
@@ -3805,7 +3973,7 @@ namespace http
 
 						if (isEnabled)
 						{
-							CDomoticzHardwareBase* pBaseHardware = dynamic_cast<CDomoticzHardwareBase*>(m_mainworker.GetHardware(ID));
+							std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(ID);
 							if (pBaseHardware != nullptr)
 							{
 								std::string jsonConfiguration;
@@ -3896,7 +4064,7 @@ namespace http
 			{
 				root["status"] = "OK";
 				root["title"] = "GetLightSwitches";
-				result = m_sql.safe_query("SELECT ID, Name, Type, SubType, Used, SwitchType, Options FROM DeviceStatus ORDER BY Name COLLATE NOCASE ASC");
+				result = m_sql.safe_query_readonly("SELECT ID, Name, Type, SubType, Used, SwitchType, Options FROM DeviceStatus ORDER BY Name COLLATE NOCASE ASC");
 				if (!result.empty())
 				{
 					int ii = 0;
@@ -3943,7 +4111,7 @@ namespace http
 								bdoAdd = false;
 								// bool bIsSubDevice = false;
 								std::vector<std::vector<std::string>> resultSD;
-								resultSD = m_sql.safe_query("SELECT ID FROM LightSubDevices WHERE (DeviceRowID=='%q')", sd[0].c_str());
+								resultSD = m_sql.safe_query_readonly("SELECT ID FROM LightSubDevices WHERE (DeviceRowID=='%q')", sd[0].c_str());
 								if (!resultSD.empty())
 									bdoAdd = true;
 							}
@@ -4029,7 +4197,7 @@ namespace http
 				int ii = 0;
 
 				// First List/Switch Devices
-				result = m_sql.safe_query("SELECT ID, Name, Type, SubType, Used FROM DeviceStatus ORDER BY Name COLLATE NOCASE ASC");
+				result = m_sql.safe_query_readonly("SELECT ID, Name, Type, SubType, Used FROM DeviceStatus ORDER BY Name COLLATE NOCASE ASC");
 				if (!result.empty())
 				{
 					for (const auto& sd : result)
@@ -4087,7 +4255,7 @@ namespace http
 				} // end light/switches
 
 				// Add Scenes
-				result = m_sql.safe_query("SELECT ID, Name FROM Scenes ORDER BY Name COLLATE NOCASE ASC");
+				result = m_sql.safe_query_readonly("SELECT ID, Name FROM Scenes ORDER BY Name COLLATE NOCASE ASC");
 				if (!result.empty())
 				{
 					for (const auto& sd : result)
@@ -4110,7 +4278,7 @@ namespace http
 				root["status"] = "OK";
 				root["title"] = "GetCameraActiveDevices";
 				// First List/Switch Devices
-				result = m_sql.safe_query("SELECT ID, DevSceneType, DevSceneRowID, DevSceneWhen, DevSceneDelay FROM CamerasActiveDevices WHERE (CameraRowID=='%q') ORDER BY ID",
+				result = m_sql.safe_query_readonly("SELECT ID, DevSceneType, DevSceneRowID, DevSceneWhen, DevSceneDelay FROM CamerasActiveDevices WHERE (CameraRowID=='%q') ORDER BY ID",
 					idx.c_str());
 				if (!result.empty())
 				{
@@ -4127,7 +4295,7 @@ namespace http
 						if (DevSceneType == 0)
 						{
 							std::vector<std::vector<std::string>> result2;
-							result2 = m_sql.safe_query("SELECT Name FROM DeviceStatus WHERE (ID=='%q')", DevSceneRowID.c_str());
+							result2 = m_sql.safe_query_readonly("SELECT Name FROM DeviceStatus WHERE (ID=='%q')", DevSceneRowID.c_str());
 							if (!result2.empty())
 							{
 								Name = "[Light/Switches] " + result2[0][0];
@@ -4136,7 +4304,7 @@ namespace http
 						else
 						{
 							std::vector<std::vector<std::string>> result2;
-							result2 = m_sql.safe_query("SELECT Name FROM Scenes WHERE (ID=='%q')", DevSceneRowID.c_str());
+							result2 = m_sql.safe_query_readonly("SELECT Name FROM Scenes WHERE (ID=='%q')", DevSceneRowID.c_str());
 							if (!result2.empty())
 							{
 								Name = "[Scene] " + result2[0][0];
@@ -4179,7 +4347,7 @@ namespace http
 				int activedelay = atoi(sactivedelay.c_str());
 
 				// first check if it is not already a Active Device
-				result = m_sql.safe_query("SELECT ID FROM CamerasActiveDevices WHERE (CameraRowID=='%q')"
+				result = m_sql.safe_query_readonly("SELECT ID FROM CamerasActiveDevices WHERE (CameraRowID=='%q')"
 					" AND (DevSceneType==%d) AND (DevSceneRowID=='%q')"
 					" AND (DevSceneWhen==%d)",
 					idx.c_str(), activetype, activeidx.c_str(), activewhen);
@@ -4273,7 +4441,7 @@ namespace http
 				std::string sunitcode;
 				std::string devid;
 
-				CDomoticzHardwareBase* pBaseHardware = m_mainworker.GetHardware(atoi(hwdid.c_str()));
+				std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(atoi(hwdid.c_str()));
 				if (pBaseHardware != nullptr && !pBaseHardware->GetManualSwitchesJsonConfiguration().empty())
 				{
 					pBaseHardware->GetManualSwitchParameters(req.parameters, switchtype, lighttype, dtype, subtype, devid, sunitcode);
@@ -4327,7 +4495,7 @@ namespace http
 						root["message"] = "No GPIO number given";
 						return;
 					}
-					CGpio* pGpio = dynamic_cast<CGpio*>(m_mainworker.GetHardware(atoi(hwdid.c_str())));
+					std::shared_ptr<CGpio> pGpio = std::dynamic_pointer_cast<CGpio>(m_mainworker.GetHardware(atoi(hwdid.c_str())));
 					if (pGpio == nullptr)
 					{
 						root["status"] = "ERROR";
@@ -4384,7 +4552,7 @@ namespace http
 						return;
 					}
 
-					CSysfsGpio* pSysfsGpio = dynamic_cast<CSysfsGpio*>(m_mainworker.GetHardware(atoi(hwdid.c_str())));
+					std::shared_ptr<CSysfsGpio> pSysfsGpio = std::dynamic_pointer_cast<CSysfsGpio>(m_mainworker.GetHardware(atoi(hwdid.c_str())));
 					if (pSysfsGpio == nullptr)
 					{
 						root["status"] = "ERROR";
@@ -4429,17 +4597,17 @@ namespace http
 					unsigned long rID = 0;
 					if (pBaseHardware->HwdType == HTYPE_EnOceanESP2)
 					{
-						CEnOceanESP2* pEnoceanHardware = dynamic_cast<CEnOceanESP2*>(pBaseHardware);
+						CEnOceanESP2* pEnoceanHardware = dynamic_cast<CEnOceanESP2*>(pBaseHardware.get());
 						rID = pEnoceanHardware->m_id_base + iUnitTest;
 					}
 					else if (pBaseHardware->HwdType == HTYPE_EnOceanESP3)
 					{
-						CEnOceanESP3* pEnoceanHardware = dynamic_cast<CEnOceanESP3*>(pBaseHardware);
+						CEnOceanESP3* pEnoceanHardware = dynamic_cast<CEnOceanESP3*>(pBaseHardware.get());
 						rID = pEnoceanHardware->m_id_base + iUnitTest;
 					}
 					else if (pBaseHardware->HwdType == HTYPE_USBtinGateway) // Like EnOcean (Lighting2 with Base_ID offset)
 					{
-						USBtin* pUSBtinHardware = dynamic_cast<USBtin*>(pBaseHardware);
+						USBtin* pUSBtinHardware = dynamic_cast<USBtin*>(pBaseHardware.get());
 						// base ID calculate in the USBtinharwade dependant of the CAN Layer !
 						// for exemple see MultiblocV8 layer...
 						rID = pUSBtinHardware->switch_id_base;
@@ -4910,12 +5078,12 @@ namespace http
 				std::string devid;
 				std::string StrParam1;
 
-				CDomoticzHardwareBase* pBaseHardware = m_mainworker.GetHardware(atoi(hwdid.c_str()));
+				std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(atoi(hwdid.c_str()));
 				if ((pBaseHardware != nullptr) && (!pBaseHardware->GetManualSwitchesJsonConfiguration().empty()))
 				{
 					pBaseHardware->GetManualSwitchParameters(req.parameters, switchtype, lighttype, dtype, subtype, devid, sunitcode);
 					// check if switch is unique
-					result = m_sql.safe_query("SELECT Name FROM DeviceStatus WHERE (HardwareID=='%q' AND DeviceID=='%q' AND Unit=='%q' AND Type==%d AND SubType==%d)",
+					result = m_sql.safe_query_readonly("SELECT Name FROM DeviceStatus WHERE (HardwareID=='%q' AND DeviceID=='%q' AND Unit=='%q' AND Type==%d AND SubType==%d)",
 						hwdid.c_str(), devid.c_str(), sunitcode.c_str(), dtype, subtype);
 					if (!result.empty())
 					{
@@ -4930,7 +5098,7 @@ namespace http
 					m_sql.m_bAcceptNewHardware = bActEnabledState;
 
 					// set name and switchtype
-					result = m_sql.safe_query("SELECT ID FROM DeviceStatus WHERE (HardwareID=='%q' AND DeviceID=='%q' AND Unit=='%q' AND Type==%d AND SubType==%d)", hwdid.c_str(),
+					result = m_sql.safe_query_readonly("SELECT ID FROM DeviceStatus WHERE (HardwareID=='%q' AND DeviceID=='%q' AND Unit=='%q' AND Type==%d AND SubType==%d)", hwdid.c_str(),
 						devid.c_str(), sunitcode.c_str(), dtype, subtype);
 					if (result.empty())
 					{
@@ -4958,7 +5126,7 @@ namespace http
 						{
 							// this is a sub device for another light/switch
 							// first check if it is not already a sub device
-							result = m_sql.safe_query("SELECT ID FROM LightSubDevices WHERE (DeviceRowID=='%q') AND (ParentID =='%q')", ID.c_str(), maindeviceidx.c_str());
+							result = m_sql.safe_query_readonly("SELECT ID FROM LightSubDevices WHERE (DeviceRowID=='%q') AND (ParentID =='%q')", ID.c_str(), maindeviceidx.c_str());
 							if (result.empty())
 							{
 								// no it is not, add it
@@ -4974,7 +5142,7 @@ namespace http
 #ifdef ENABLE_PYTHON
 				// check if HW is plugin
 				{
-					result = m_sql.safe_query("SELECT Type FROM Hardware WHERE (ID == '%q')", hwdid.c_str());
+					result = m_sql.safe_query_readonly("SELECT Type FROM Hardware WHERE (ID == '%q')", hwdid.c_str());
 					if (!result.empty())
 					{
 						std::vector<std::string> sd = result[0];
@@ -5038,7 +5206,7 @@ namespace http
 					{
 						return;
 					}
-					CGpio* pGpio = dynamic_cast<CGpio*>(m_mainworker.GetHardware(atoi(hwdid.c_str())));
+					std::shared_ptr<CGpio> pGpio = std::dynamic_pointer_cast<CGpio>(m_mainworker.GetHardware(atoi(hwdid.c_str())));
 					if (pGpio == nullptr)
 					{
 						return;
@@ -5075,7 +5243,7 @@ namespace http
 					}
 					devid = id;
 
-					CSysfsGpio* pSysfsGpio = dynamic_cast<CSysfsGpio*>(m_mainworker.GetHardware(atoi(hwdid.c_str())));
+					std::shared_ptr<CSysfsGpio> pSysfsGpio = std::dynamic_pointer_cast<CSysfsGpio>(m_mainworker.GetHardware(atoi(hwdid.c_str())));
 					if ((pSysfsGpio == nullptr) || (pSysfsGpio->HwdType != HTYPE_SysfsGpio))
 					{
 						return;
@@ -5109,7 +5277,7 @@ namespace http
 					unsigned long rID = 0;
 					if (pBaseHardware->HwdType == HTYPE_EnOceanESP2)
 					{
-						CEnOceanESP2* pEnoceanHardware = dynamic_cast<CEnOceanESP2*>(pBaseHardware);
+						CEnOceanESP2* pEnoceanHardware = dynamic_cast<CEnOceanESP2*>(pBaseHardware.get());
 						if (pEnoceanHardware->m_id_base == 0)
 						{
 							sprintf(szTmp, "%s: BaseID not found, is the hardware running?", pEnoceanHardware->m_Name.c_str());
@@ -5120,7 +5288,7 @@ namespace http
 					}
 					else if (pBaseHardware->HwdType == HTYPE_EnOceanESP3)
 					{
-						CEnOceanESP3* pEnoceanHardware = dynamic_cast<CEnOceanESP3*>(pBaseHardware);
+						CEnOceanESP3* pEnoceanHardware = dynamic_cast<CEnOceanESP3*>(pBaseHardware.get());
 						if (pEnoceanHardware->m_id_base == 0)
 						{
 							sprintf(szTmp, "%s: BaseID not found, is the hardware running?", pEnoceanHardware->m_Name.c_str());
@@ -5136,7 +5304,7 @@ namespace http
 					}
 					else if (pBaseHardware->HwdType == HTYPE_USBtinGateway)
 					{
-						USBtin* pUSBtinHardware = dynamic_cast<USBtin*>(pBaseHardware);
+						USBtin* pUSBtinHardware = dynamic_cast<USBtin*>(pBaseHardware.get());
 						rID = pUSBtinHardware->switch_id_base;
 						std::stringstream ssunitcode;
 						ssunitcode << iUnitTest;
@@ -5301,7 +5469,7 @@ namespace http
 					subtype = sTypeSmartwares;
 
 					// check if switch is unique
-					result = m_sql.safe_query("SELECT Name FROM DeviceStatus WHERE (HardwareID=='%q' AND DeviceID=='%q' AND Unit=='%q' AND Type==%d AND SubType==%d)",
+					result = m_sql.safe_query_readonly("SELECT Name FROM DeviceStatus WHERE (HardwareID=='%q' AND DeviceID=='%q' AND Unit=='%q' AND Type==%d AND SubType==%d)",
 						hwdid.c_str(), devid.c_str(), sunitcode.c_str(), dtype, subtype);
 					if (!result.empty())
 					{
@@ -5315,7 +5483,7 @@ namespace http
 					m_sql.m_bAcceptNewHardware = bActEnabledState;
 
 					// set name and switchtype
-					result = m_sql.safe_query("SELECT ID FROM DeviceStatus WHERE (HardwareID=='%q' AND DeviceID=='%q' AND Unit=='%q' AND Type==%d AND SubType==%d)",
+					result = m_sql.safe_query_readonly("SELECT ID FROM DeviceStatus WHERE (HardwareID=='%q' AND DeviceID=='%q' AND Unit=='%q' AND Type==%d AND SubType==%d)",
 						hwdid.c_str(), devid.c_str(), sunitcode.c_str(), dtype, subtype);
 					if (result.empty())
 					{
@@ -5552,7 +5720,7 @@ namespace http
 					}
 				}
 				// Check if switch is unique
-				result = m_sql.safe_query("SELECT Name FROM DeviceStatus WHERE (HardwareID=='%q' AND DeviceID=='%q' AND Unit=='%q' AND Type==%d AND SubType==%d)", hwdid.c_str(),
+				result = m_sql.safe_query_readonly("SELECT Name FROM DeviceStatus WHERE (HardwareID=='%q' AND DeviceID=='%q' AND Unit=='%q' AND Type==%d AND SubType==%d)", hwdid.c_str(),
 					devid.c_str(), sunitcode.c_str(), dtype, subtype);
 				if (!result.empty())
 				{
@@ -5577,7 +5745,7 @@ namespace http
 				m_sql.m_bAcceptNewHardware = bActEnabledState;
 
 				// set name and switchtype
-				result = m_sql.safe_query("SELECT ID FROM DeviceStatus WHERE (HardwareID=='%q' AND DeviceID=='%q' AND Unit=='%q' AND Type==%d AND SubType==%d)", hwdid.c_str(),
+				result = m_sql.safe_query_readonly("SELECT ID FROM DeviceStatus WHERE (HardwareID=='%q' AND DeviceID=='%q' AND Unit=='%q' AND Type==%d AND SubType==%d)", hwdid.c_str(),
 					devid.c_str(), sunitcode.c_str(), dtype, subtype);
 				if (result.empty())
 				{
@@ -5605,7 +5773,7 @@ namespace http
 					{
 						// this is a sub device for another light/switch
 						// first check if it is not already a sub device
-						result = m_sql.safe_query("SELECT ID FROM LightSubDevices WHERE (DeviceRowID=='%q') AND (ParentID =='%q')", ID.c_str(), maindeviceidx.c_str());
+						result = m_sql.safe_query_readonly("SELECT ID FROM LightSubDevices WHERE (DeviceRowID=='%q') AND (ParentID =='%q')", ID.c_str(), maindeviceidx.c_str());
 						if (result.empty())
 						{
 							// no it is not, add it
@@ -5629,7 +5797,7 @@ namespace http
 				if (idx.empty())
 					return;
 				// First get Device Type/SubType
-				result = m_sql.safe_query("SELECT Type, SubType, SwitchType FROM DeviceStatus WHERE (ID == '%q')", idx.c_str());
+				result = m_sql.safe_query_readonly("SELECT Type, SubType, SwitchType FROM DeviceStatus WHERE (ID == '%q')", idx.c_str());
 				if (result.empty())
 					return;
 
@@ -5664,11 +5832,11 @@ namespace http
 					{
 						std::string idx = request::findValue(&req, "idx");
 
-						result = m_sql.safe_query("SELECT HardwareID FROM DeviceStatus WHERE (ID=='%q')", idx.c_str());
+						result = m_sql.safe_query_readonly("SELECT HardwareID FROM DeviceStatus WHERE (ID=='%q')", idx.c_str());
 						if (!result.empty())
 						{
 							std::string hdwid = result[0][0];
-							CDomoticzHardwareBase* pBaseHardware = dynamic_cast<CDomoticzHardwareBase*>(m_mainworker.GetHardware(atoi(hdwid.c_str())));
+							std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(atoi(hdwid.c_str()));
 							if (pBaseHardware != nullptr)
 							{
 								_eHardwareTypes type = pBaseHardware->HwdType;
@@ -6220,8 +6388,8 @@ namespace http
 					{
 						unsigned long userID = m_users[iUser].ID;
 						//First get ID's in SharedDevices table
-						auto result1 = m_sql.safe_query("SELECT ID FROM SharedDevices WHERE (SharedUserID == '%lu') AND (DeviceRowID == '%q')", userID, idx1.c_str());
-						auto result2 = m_sql.safe_query("SELECT ID FROM SharedDevices WHERE (SharedUserID == '%lu') AND (DeviceRowID == '%q')", userID, idx2.c_str());
+						auto result1 = m_sql.safe_query_readonly("SELECT ID FROM SharedDevices WHERE (SharedUserID == '%lu') AND (DeviceRowID == '%q')", userID, idx1.c_str());
+						auto result2 = m_sql.safe_query_readonly("SELECT ID FROM SharedDevices WHERE (SharedUserID == '%lu') AND (DeviceRowID == '%q')", userID, idx2.c_str());
 						if (result1.empty() || result2.empty())
 						{
 							session.reply_status = reply::internal_server_error;
@@ -6231,13 +6399,13 @@ namespace http
 						idx2 = result2[0][0];
 
 						// get device order 1
-						result = m_sql.safe_query("SELECT [Order] FROM SharedDevices WHERE (ID == '%q')", idx1.c_str());
+						result = m_sql.safe_query_readonly("SELECT [Order] FROM SharedDevices WHERE (ID == '%q')", idx1.c_str());
 						if (result.empty())
 							return;
 						Order1 = result[0][0];
 
 						// get device order 2
-						result = m_sql.safe_query("SELECT [Order] FROM SharedDevices WHERE (ID == '%q')", idx2.c_str());
+						result = m_sql.safe_query_readonly("SELECT [Order] FROM SharedDevices WHERE (ID == '%q')", idx2.c_str());
 						if (result.empty())
 							return;
 						Order2 = result[0][0];
@@ -6258,13 +6426,13 @@ namespace http
 					}
 					else {
 						// get device order 1
-						result = m_sql.safe_query("SELECT [Order] FROM DeviceStatus WHERE (ID == '%q')", idx1.c_str());
+						result = m_sql.safe_query_readonly("SELECT [Order] FROM DeviceStatus WHERE (ID == '%q')", idx1.c_str());
 						if (result.empty())
 							return;
 						Order1 = result[0][0];
 
 						// get device order 2
-						result = m_sql.safe_query("SELECT [Order] FROM DeviceStatus WHERE (ID == '%q')", idx2.c_str());
+						result = m_sql.safe_query_readonly("SELECT [Order] FROM DeviceStatus WHERE (ID == '%q')", idx2.c_str());
 						if (result.empty())
 							return;
 						Order2 = result[0][0];
@@ -6288,13 +6456,13 @@ namespace http
 				{
 					// change order in a room
 					// get device order 1
-					result = m_sql.safe_query("SELECT [Order] FROM DeviceToPlansMap WHERE (DeviceRowID == '%q') AND (PlanID==%d)", idx1.c_str(), roomid);
+					result = m_sql.safe_query_readonly("SELECT [Order] FROM DeviceToPlansMap WHERE (DeviceRowID == '%q') AND (PlanID==%d)", idx1.c_str(), roomid);
 					if (result.empty())
 						return;
 					Order1 = result[0][0];
 
 					// get device order 2
-					result = m_sql.safe_query("SELECT [Order] FROM DeviceToPlansMap WHERE (DeviceRowID == '%q') AND (PlanID==%d)", idx2.c_str(), roomid);
+					result = m_sql.safe_query_readonly("SELECT [Order] FROM DeviceToPlansMap WHERE (DeviceRowID == '%q') AND (PlanID==%d)", idx2.c_str(), roomid);
 					if (result.empty())
 						return;
 					Order2 = result[0][0];
@@ -6331,13 +6499,13 @@ namespace http
 
 				std::string Order1, Order2;
 				// get device order 1
-				result = m_sql.safe_query("SELECT [Order] FROM Scenes WHERE (ID == '%q')", idx1.c_str());
+				result = m_sql.safe_query_readonly("SELECT [Order] FROM Scenes WHERE (ID == '%q')", idx1.c_str());
 				if (result.empty())
 					return;
 				Order1 = result[0][0];
 
 				// get device order 2
-				result = m_sql.safe_query("SELECT [Order] FROM Scenes WHERE (ID == '%q')", idx2.c_str());
+				result = m_sql.safe_query_readonly("SELECT [Order] FROM Scenes WHERE (ID == '%q')", idx2.c_str());
 				if (result.empty())
 					return;
 				Order2 = result[0][0];
@@ -6417,7 +6585,7 @@ namespace http
 				std::string sHashedUsername = base64_encode(username);
 
 				// Check for duplicate user name
-				result = m_sql.safe_query("SELECT ID FROM Users WHERE (Username == '%q')", sHashedUsername.c_str());
+				result = m_sql.safe_query_readonly("SELECT ID FROM Users WHERE (Username == '%q')", sHashedUsername.c_str());
 				if (!result.empty())
 				{
 					if (!(cparam == "updateuser" && result[0][0] == idx))
@@ -6439,7 +6607,7 @@ namespace http
 					root["title"] = "UpdateUser";
 
 					// Invalidate user's sessions if username or password has changed
-					result = m_sql.safe_query("SELECT Username, Password, Rights FROM Users WHERE (ID == '%q')", idx.c_str());
+					result = m_sql.safe_query_readonly("SELECT Username, Password, Rights FROM Users WHERE (ID == '%q')", idx.c_str());
 					if (result.size() == 1)
 					{
 						std::string sOldUsername = result[0][0];
@@ -6469,7 +6637,7 @@ namespace http
 					root["title"] = "DeleteUser";
 
 					// Remove user's sessions
-					result = m_sql.safe_query("SELECT Username, Rights FROM Users WHERE (ID == '%q')", idx.c_str());
+					result = m_sql.safe_query_readonly("SELECT Username, Rights FROM Users WHERE (ID == '%q')", idx.c_str());
 					if (result.size() == 1)
 					{
 						srights = result[0][1];
@@ -6501,7 +6669,7 @@ namespace http
 				{
 					root["title"] = "GetApplications";
 					std::vector<std::vector<std::string>> result;
-					result = m_sql.safe_query("SELECT ID, Active, Public, Applicationname, Secret, Pemfile, LastSeen FROM Applications ORDER BY ID ASC");
+					result = m_sql.safe_query_readonly("SELECT ID, Active, Public, Applicationname, Secret, Pemfile, LastSeen FROM Applications ORDER BY ID ASC");
 					if (!result.empty())
 					{
 						int ii = 0;
@@ -6543,7 +6711,7 @@ namespace http
 						return;
 					}
 					// Check for duplicate application name
-					result = m_sql.safe_query("SELECT ID FROM Applications WHERE (Applicationname == '%q')", applicationname.c_str());
+					result = m_sql.safe_query_readonly("SELECT ID FROM Applications WHERE (Applicationname == '%q')", applicationname.c_str());
 					if (!result.empty())
 					{
 						std::string oidx = result[0][0];
@@ -6582,7 +6750,7 @@ namespace http
 					}
 
 					// Remove Application
-					result = m_sql.safe_query("SELECT ID FROM Applications WHERE (ID == '%q')", idx.c_str());
+					result = m_sql.safe_query_readonly("SELECT ID FROM Applications WHERE (ID == '%q')", idx.c_str());
 					if (result.size() != 1)
 					{
 						session.reply_status = reply::bad_request;
@@ -6606,7 +6774,7 @@ namespace http
 				if (idx.empty())
 					return;
 				// First get Device Type/SubType
-				result = m_sql.safe_query("SELECT Type, SubType FROM DeviceStatus WHERE (ID == '%q')", idx.c_str());
+				result = m_sql.safe_query_readonly("SELECT Type, SubType FROM DeviceStatus WHERE (ID == '%q')", idx.c_str());
 				if (result.empty())
 					return;
 
@@ -6668,7 +6836,7 @@ namespace http
 				if (bReceivedSwitch)
 				{
 					// check if used
-					result = m_sql.safe_query("SELECT Name, Used, nValue FROM DeviceStatus WHERE (ID==%" PRIu64 ")", m_sql.m_LastSwitchRowID);
+					result = m_sql.safe_query_readonly("SELECT Name, Used, nValue FROM DeviceStatus WHERE (ID==%" PRIu64 ")", m_sql.m_LastSwitchRowID);
 					if (!result.empty())
 					{
 						root["status"] = "OK";
@@ -6853,7 +7021,7 @@ namespace http
 				if ((idx.empty()) || (switchcmd.empty()) || ((switchcmd == "Set Level") && (level.empty())))
 					return;
 
-				result = m_sql.safe_query("SELECT [Protected],[Name] FROM DeviceStatus WHERE (ID = '%q')", idx.c_str());
+				result = m_sql.safe_query_readonly("SELECT [Protected],[Name] FROM DeviceStatus WHERE (ID = '%q')", idx.c_str());
 				if (result.empty())
 				{
 					// Switch not found!
@@ -6931,7 +7099,7 @@ namespace http
 				if ((idx.empty()) || (switchcmd.empty()))
 					return;
 
-				result = m_sql.safe_query("SELECT [Protected] FROM Scenes WHERE (ID = '%q')", idx.c_str());
+				result = m_sql.safe_query_readonly("SELECT [Protected] FROM Scenes WHERE (ID = '%q')", idx.c_str());
 				if (result.empty())
 				{
 					// Scene/Group not found!
@@ -7650,9 +7818,9 @@ namespace http
 				bool bReturnUnused = atoi(request::findValue(&req, "unused").c_str()) != 0;
 
 				if (!bReturnUnused)
-					result = m_sql.safe_query("SELECT ID, Name, ScaleFactor FROM Floorplans ORDER BY [Name]");
+					result = m_sql.safe_query_readonly("SELECT ID, Name, ScaleFactor FROM Floorplans ORDER BY [Name]");
 				else
-					result = m_sql.safe_query("SELECT ID, Name, ScaleFactor FROM Floorplans WHERE ID NOT IN(SELECT FloorplanID FROM Plans)");
+					result = m_sql.safe_query_readonly("SELECT ID, Name, ScaleFactor FROM Floorplans WHERE ID NOT IN(SELECT FloorplanID FROM Plans)");
 				if (!result.empty())
 				{
 					int ii = 0;
@@ -7721,7 +7889,7 @@ namespace http
 
 				std::string aOrder, oID, oOrder;
 
-				result = m_sql.safe_query("SELECT [Order] FROM Floorplans WHERE (ID=='%q')", idx.c_str());
+				result = m_sql.safe_query_readonly("SELECT [Order] FROM Floorplans WHERE (ID=='%q')", idx.c_str());
 				if (result.empty())
 					return;
 				aOrder = result[0][0];
@@ -7729,7 +7897,7 @@ namespace http
 				if (!bGoUp)
 				{
 					// Get next device order
-					result = m_sql.safe_query("SELECT ID, [Order] FROM Floorplans WHERE ([Order]>'%q') ORDER BY [Order] ASC", aOrder.c_str());
+					result = m_sql.safe_query_readonly("SELECT ID, [Order] FROM Floorplans WHERE ([Order]>'%q') ORDER BY [Order] ASC", aOrder.c_str());
 					if (result.empty())
 						return;
 					oID = result[0][0];
@@ -7738,7 +7906,7 @@ namespace http
 				else
 				{
 					// Get previous device order
-					result = m_sql.safe_query("SELECT ID, [Order] FROM Floorplans WHERE ([Order]<'%q') ORDER BY [Order] DESC", aOrder.c_str());
+					result = m_sql.safe_query_readonly("SELECT ID, [Order] FROM Floorplans WHERE ([Order]<'%q') ORDER BY [Order] DESC", aOrder.c_str());
 					if (result.empty())
 						return;
 					oID = result[0][0];
@@ -7763,7 +7931,7 @@ namespace http
 				root["title"] = "GetUnusedFloorplanPlans";
 				int ii = 0;
 
-				result = m_sql.safe_query("SELECT ID, Name FROM Plans WHERE (FloorplanID==0) ORDER BY Name COLLATE NOCASE ASC");
+				result = m_sql.safe_query_readonly("SELECT ID, Name FROM Plans WHERE (FloorplanID==0) ORDER BY Name COLLATE NOCASE ASC");
 				if (!result.empty())
 				{
 					for (const auto& sd : result)
@@ -7783,7 +7951,7 @@ namespace http
 				root["status"] = "OK";
 				root["title"] = "GetFloorplanPlans";
 				int ii = 0;
-				result = m_sql.safe_query("SELECT ID, Name, Area FROM Plans WHERE (FloorplanID=='%q') ORDER BY Name COLLATE NOCASE ASC", idx.c_str());
+				result = m_sql.safe_query_readonly("SELECT ID, Name, Area FROM Plans WHERE (FloorplanID=='%q') ORDER BY Name COLLATE NOCASE ASC", idx.c_str());
 				if (!result.empty())
 				{
 					for (const auto& sd : result)
@@ -7911,10 +8079,16 @@ namespace http
 
 		void CWebServer::LoadUsers()
 		{
-			ClearUserPasswords();
+			if (g_bInJSonHandler)
+			{
+				m_bLoadUsersPending = true;
+				return;
+			}
+			boost::unique_lock<boost::shared_mutex> lock(m_webStateMutex);
+			DoClearUserPasswords();
 			// Add Users
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT ID, Active, Username, Password, Rights, TabsEnabled FROM Users");
+			result = m_sql.safe_query_readonly("SELECT ID, Active, Username, Password, Rights, TabsEnabled FROM Users");
 			if (!result.empty())
 			{
 				for (const auto& sd : result)
@@ -7936,7 +8110,7 @@ namespace http
 			}
 			// Add 'Applications' as User with special privilege URIGHTS_CLIENTID
 			result.clear();
-			result = m_sql.safe_query("SELECT ID, Active, Public, Applicationname, Secret, Pemfile FROM Applications");
+			result = m_sql.safe_query_readonly("SELECT ID, Active, Public, Applicationname, Secret, Pemfile FROM Applications");
 			if (!result.empty())
 			{
 				for (const auto& sd : result)
@@ -7957,13 +8131,14 @@ namespace http
 			}
 
 			m_mainworker.LoadSharedUsers();
+			ClearDeviceListCache();
 		}
 
 		void CWebServer::AddUser(const unsigned long ID, const std::string& username, const std::string& password, const int userrights, const int activetabs, const std::string& pemfile)
 		{
 			if (m_pWebEm == nullptr)
 				return;
-			std::vector<std::vector<std::string>> result = m_sql.safe_query("SELECT COUNT(*) FROM SharedDevices WHERE (SharedUserID == '%d')", ID);
+			std::vector<std::vector<std::string>> result = m_sql.safe_query_readonly("SELECT COUNT(*) FROM SharedDevices WHERE (SharedUserID == '%d')", ID);
 			if (result.empty())
 				return;
 
@@ -8057,6 +8232,12 @@ namespace http
 		}
 
 		void CWebServer::ClearUserPasswords()
+		{
+			boost::unique_lock<boost::shared_mutex> lock(m_webStateMutex);
+			DoClearUserPasswords();
+		}
+
+		void CWebServer::DoClearUserPasswords()
 		{
 			m_users.clear();
 			m_accesscodes.clear();
@@ -8125,87 +8306,90 @@ namespace http
 
 			try {
 
+				//stored at once, before the settings are applied
+				std::vector<_tPreferenceValue> preferences;
+
 				/* Start processing the simple ones */
 				/* -------------------------------- */
 
-				m_sql.UpdatePreferencesVar("DashboardType", atoi(request::findValue(&req, "DashboardType").c_str())); cntSettings++;
-				m_sql.UpdatePreferencesVar("MobileType", atoi(request::findValue(&req, "MobileType").c_str())); cntSettings++;
-				m_sql.UpdatePreferencesVar("ReleaseChannel", atoi(request::findValue(&req, "ReleaseChannel").c_str())); cntSettings++;
-				m_sql.UpdatePreferencesVar("LightHistoryDays", atoi(request::findValue(&req, "LightHistoryDays").c_str())); cntSettings++;
-				m_sql.UpdatePreferencesVar("5MinuteHistoryDays", atoi(request::findValue(&req, "ShortLogDays").c_str())); cntSettings++;
-				m_sql.UpdatePreferencesVar("ElectricVoltage", atoi(request::findValue(&req, "ElectricVoltage").c_str())); cntSettings++;
-				m_sql.UpdatePreferencesVar("CM113DisplayType", atoi(request::findValue(&req, "CM113DisplayType").c_str())); cntSettings++;
-				m_sql.UpdatePreferencesVar("MaxElectricPower", atoi(request::findValue(&req, "MaxElectricPower").c_str())); cntSettings++;
-				m_sql.UpdatePreferencesVar("DoorbellCommand", atoi(request::findValue(&req, "DoorbellCommand").c_str())); cntSettings++;
-				m_sql.UpdatePreferencesVar("SmartMeterType", atoi(request::findValue(&req, "SmartMeterType").c_str())); cntSettings++;
-				m_sql.UpdatePreferencesVar("SecOnDelay", atoi(request::findValue(&req, "SecOnDelay").c_str())); cntSettings++;
-				m_sql.UpdatePreferencesVar("FloorplanPopupDelay", atoi(request::findValue(&req, "FloorplanPopupDelay").c_str())); cntSettings++;
-				m_sql.UpdatePreferencesVar("FloorplanActiveOpacity", atoi(request::findValue(&req, "FloorplanActiveOpacity").c_str())); cntSettings++;
-				m_sql.UpdatePreferencesVar("FloorplanInactiveOpacity", atoi(request::findValue(&req, "FloorplanInactiveOpacity").c_str())); cntSettings++;
-				m_sql.UpdatePreferencesVar("OneWireSensorPollPeriod", atoi(request::findValue(&req, "OneWireSensorPollPeriod").c_str())); cntSettings++;
-				m_sql.UpdatePreferencesVar("OneWireSwitchPollPeriod", atoi(request::findValue(&req, "OneWireSwitchPollPeriod").c_str())); cntSettings++;
-
-				m_sql.UpdatePreferencesVar("UseAutoUpdate", (request::findValue(&req, "checkforupdates") == "on" ? 1 : 0)); cntSettings++;
-				m_sql.UpdatePreferencesVar("UseAutoBackup", (request::findValue(&req, "enableautobackup") == "on" ? 1 : 0)); cntSettings++;
-				m_sql.UpdatePreferencesVar("HideDisabledHardwareSensors", (request::findValue(&req, "HideDisabledHardwareSensors") == "on" ? 1 : 0)); cntSettings++;
-				m_sql.UpdatePreferencesVar("ShowUpdateEffect", (request::findValue(&req, "ShowUpdateEffect") == "on" ? 1 : 0)); cntSettings++;
-				m_sql.UpdatePreferencesVar("FloorplanFullscreenMode", (request::findValue(&req, "FloorplanFullscreenMode") == "on" ? 1 : 0)); cntSettings++;
-				m_sql.UpdatePreferencesVar("FloorplanAnimateZoom", (request::findValue(&req, "FloorplanAnimateZoom") == "on" ? 1 : 0)); cntSettings++;
-				m_sql.UpdatePreferencesVar("FloorplanShowSensorValues", (request::findValue(&req, "FloorplanShowSensorValues") == "on" ? 1 : 0)); cntSettings++;
-				m_sql.UpdatePreferencesVar("FloorplanShowSwitchValues", (request::findValue(&req, "FloorplanShowSwitchValues") == "on" ? 1 : 0)); cntSettings++;
-				m_sql.UpdatePreferencesVar("FloorplanShowSceneNames", (request::findValue(&req, "FloorplanShowSwitchValues") == "on" ? 1 : 0)); cntSettings++;
-				m_sql.UpdatePreferencesVar("IFTTTEnabled", (request::findValue(&req, "IFTTTEnabled") == "on" ? 1 : 0)); cntSettings++;
-
-				m_sql.UpdatePreferencesVar("Language", request::findValue(&req, "Language")); cntSettings++;
-				m_sql.UpdatePreferencesVar("DegreeDaysBaseTemperature", request::findValue(&req, "DegreeDaysBaseTemperature")); cntSettings++;
-
-				m_sql.UpdatePreferencesVar("FloorplanRoomColour", CURLEncode::URLDecode(request::findValue(&req, "FloorplanRoomColour"))); cntSettings++;
-				m_sql.UpdatePreferencesVar("IFTTTAPI", base64_encode(request::findValue(&req, "IFTTTAPI"))); cntSettings++;
-
-				m_sql.UpdatePreferencesVar("Title", (request::findValue(&req, "Title").empty()) ? "Domoticz" : request::findValue(&req, "Title")); cntSettings++;
+				preferences.push_back({ "DashboardType", atoi(request::findValue(&req, "DashboardType").c_str()), "" }); cntSettings++;
+				preferences.push_back({ "MobileType", atoi(request::findValue(&req, "MobileType").c_str()), "" }); cntSettings++;
+				preferences.push_back({ "ReleaseChannel", atoi(request::findValue(&req, "ReleaseChannel").c_str()), "" }); cntSettings++;
+				preferences.push_back({ "LightHistoryDays", atoi(request::findValue(&req, "LightHistoryDays").c_str()), "" }); cntSettings++;
+				preferences.push_back({ "5MinuteHistoryDays", atoi(request::findValue(&req, "ShortLogDays").c_str()), "" }); cntSettings++;
+				preferences.push_back({ "ElectricVoltage", atoi(request::findValue(&req, "ElectricVoltage").c_str()), "" }); cntSettings++;
+				preferences.push_back({ "CM113DisplayType", atoi(request::findValue(&req, "CM113DisplayType").c_str()), "" }); cntSettings++;
+				preferences.push_back({ "MaxElectricPower", atoi(request::findValue(&req, "MaxElectricPower").c_str()), "" }); cntSettings++;
+				preferences.push_back({ "DoorbellCommand", atoi(request::findValue(&req, "DoorbellCommand").c_str()), "" }); cntSettings++;
+				preferences.push_back({ "SmartMeterType", atoi(request::findValue(&req, "SmartMeterType").c_str()), "" }); cntSettings++;
+				preferences.push_back({ "SecOnDelay", atoi(request::findValue(&req, "SecOnDelay").c_str()), "" }); cntSettings++;
+				preferences.push_back({ "FloorplanPopupDelay", atoi(request::findValue(&req, "FloorplanPopupDelay").c_str()), "" }); cntSettings++;
+				preferences.push_back({ "FloorplanActiveOpacity", atoi(request::findValue(&req, "FloorplanActiveOpacity").c_str()), "" }); cntSettings++;
+				preferences.push_back({ "FloorplanInactiveOpacity", atoi(request::findValue(&req, "FloorplanInactiveOpacity").c_str()), "" }); cntSettings++;
+				preferences.push_back({ "OneWireSensorPollPeriod", atoi(request::findValue(&req, "OneWireSensorPollPeriod").c_str()), "" }); cntSettings++;
+				preferences.push_back({ "OneWireSwitchPollPeriod", atoi(request::findValue(&req, "OneWireSwitchPollPeriod").c_str()), "" }); cntSettings++;
+
+				preferences.push_back({ "UseAutoUpdate", (request::findValue(&req, "checkforupdates") == "on" ? 1 : 0), "" }); cntSettings++;
+				preferences.push_back({ "UseAutoBackup", (request::findValue(&req, "enableautobackup") == "on" ? 1 : 0), "" }); cntSettings++;
+				preferences.push_back({ "HideDisabledHardwareSensors", (request::findValue(&req, "HideDisabledHardwareSensors") == "on" ? 1 : 0), "" }); cntSettings++;
+				preferences.push_back({ "ShowUpdateEffect", (request::findValue(&req, "ShowUpdateEffect") == "on" ? 1 : 0), "" }); cntSettings++;
+				preferences.push_back({ "FloorplanFullscreenMode", (request::findValue(&req, "FloorplanFullscreenMode") == "on" ? 1 : 0), "" }); cntSettings++;
+				preferences.push_back({ "FloorplanAnimateZoom", (request::findValue(&req, "FloorplanAnimateZoom") == "on" ? 1 : 0), "" }); cntSettings++;
+				preferences.push_back({ "FloorplanShowSensorValues", (request::findValue(&req, "FloorplanShowSensorValues") == "on" ? 1 : 0), "" }); cntSettings++;
+				preferences.push_back({ "FloorplanShowSwitchValues", (request::findValue(&req, "FloorplanShowSwitchValues") == "on" ? 1 : 0), "" }); cntSettings++;
+				preferences.push_back({ "FloorplanShowSceneNames", (request::findValue(&req, "FloorplanShowSwitchValues") == "on" ? 1 : 0), "" }); cntSettings++;
+				preferences.push_back({ "IFTTTEnabled", (request::findValue(&req, "IFTTTEnabled") == "on" ? 1 : 0), "" }); cntSettings++;
+
+				preferences.push_back({ "Language", 0, request::findValue(&req, "Language") }); cntSettings++;
+				preferences.push_back({ "DegreeDaysBaseTemperature", 0, request::findValue(&req, "DegreeDaysBaseTemperature") }); cntSettings++;
+
+				preferences.push_back({ "FloorplanRoomColour", 0, CURLEncode::URLDecode(request::findValue(&req, "FloorplanRoomColour")) }); cntSettings++;
+				preferences.push_back({ "IFTTTAPI", 0, base64_encode(request::findValue(&req, "IFTTTAPI")) }); cntSettings++;
+
+				preferences.push_back({ "Title", 0, (request::findValue(&req, "Title").empty()) ? "Domoticz" : request::findValue(&req, "Title") }); cntSettings++;
 
 				/* More complex ones that need additional processing */
 				/* ------------------------------------------------- */
 
 				float CostEnergy = static_cast<float>(atof(request::findValue(&req, "CostEnergy").c_str()));
-				m_sql.UpdatePreferencesVar("CostEnergy", int(CostEnergy * 10000.0F)); cntSettings++;
+				preferences.push_back({ "CostEnergy", int(CostEnergy * 10000.0F), "" }); cntSettings++;
 				float CostEnergyT2 = static_cast<float>(atof(request::findValue(&req, "CostEnergyT2").c_str()));
-				m_sql.UpdatePreferencesVar("CostEnergyT2", int(CostEnergyT2 * 10000.0F)); cntSettings++;
+				preferences.push_back({ "CostEnergyT2", int(CostEnergyT2 * 10000.0F), "" }); cntSettings++;
 				float CostEnergyR1 = static_cast<float>(atof(request::findValue(&req, "CostEnergyR1").c_str()));
-				m_sql.UpdatePreferencesVar("CostEnergyR1", int(CostEnergyR1 * 10000.0F)); cntSettings++;
+				preferences.push_back({ "CostEnergyR1", int(CostEnergyR1 * 10000.0F), "" }); cntSettings++;
 				float CostEnergyR2 = static_cast<float>(atof(request::findValue(&req, "CostEnergyR2").c_str()));
-				m_sql.UpdatePreferencesVar("CostEnergyR2", int(CostEnergyR2 * 10000.0F)); cntSettings++;
+				preferences.push_back({ "CostEnergyR2", int(CostEnergyR2 * 10000.0F), "" }); cntSettings++;
 				float CostGas = static_cast<float>(atof(request::findValue(&req, "CostGas").c_str()));
-				m_sql.UpdatePreferencesVar("CostGas", int(CostGas * 10000.0F)); cntSettings++;
+				preferences.push_back({ "CostGas", int(CostGas * 10000.0F), "" }); cntSettings++;
 				float CostWater = static_cast<float>(atof(request::findValue(&req, "CostWater").c_str()));
-				m_sql.UpdatePreferencesVar("CostWater", int(CostWater * 10000.0F)); cntSettings++;
+				preferences.push_back({ "CostWater", int(CostWater * 10000.0F), "" }); cntSettings++;
 
 				int EnergyDivider = atoi(request::findValue(&req, "EnergyDivider").c_str());
 				if (EnergyDivider < 1)
 					EnergyDivider = 1000;
-				m_sql.UpdatePreferencesVar("MeterDividerEnergy", EnergyDivider); cntSettings++;
+				preferences.push_back({ "MeterDividerEnergy", EnergyDivider, "" }); cntSettings++;
 				int GasDivider = atoi(request::findValue(&req, "GasDivider").c_str());
 				if (GasDivider < 1)
 					GasDivider = 100;
-				m_sql.UpdatePreferencesVar("MeterDividerGas", GasDivider); cntSettings++;
+				preferences.push_back({ "MeterDividerGas", GasDivider, "" }); cntSettings++;
 				int WaterDivider = atoi(request::findValue(&req, "WaterDivider").c_str());
 				if (WaterDivider < 1)
 					WaterDivider = 100;
-				m_sql.UpdatePreferencesVar("MeterDividerWater", WaterDivider); cntSettings++;
+				preferences.push_back({ "MeterDividerWater", WaterDivider, "" }); cntSettings++;
 
 				int sensortimeout = atoi(request::findValue(&req, "SensorTimeout").c_str());
 				if (sensortimeout < 10)
 					sensortimeout = 10;
-				m_sql.UpdatePreferencesVar("SensorTimeout", sensortimeout); cntSettings++;
+				preferences.push_back({ "SensorTimeout", sensortimeout, "" }); cntSettings++;
 
 				std::string RaspCamParams = request::findValue(&req, "RaspCamParams");
 				if ((!RaspCamParams.empty()) && (IsArgumentSecure(RaspCamParams)))
-					m_sql.UpdatePreferencesVar("RaspCamParams", RaspCamParams);
+					preferences.push_back({ "RaspCamParams", 0, RaspCamParams });
 				cntSettings++;
 
 				std::string UVCParams = request::findValue(&req, "UVCParams");
 				if ((!UVCParams.empty()) && (IsArgumentSecure(UVCParams)))
-					m_sql.UpdatePreferencesVar("UVCParams", UVCParams);
+					preferences.push_back({ "UVCParams", 0, UVCParams });
 				cntSettings++;
 
 				/* Also update m_sql.variables */
@@ -8215,33 +8399,34 @@ namespace http
 				if (iShortLogInterval < 1)
 					iShortLogInterval = 5;
 				m_sql.m_ShortLogInterval = iShortLogInterval;
-				m_sql.UpdatePreferencesVar("ShortLogInterval", m_sql.m_ShortLogInterval); cntSettings++;
+				preferences.push_back({ "ShortLogInterval", m_sql.m_ShortLogInterval, "" }); cntSettings++;
 
 				m_sql.m_bShortLogAddOnlyNewValues = (request::findValue(&req, "ShortLogAddOnlyNewValues") == "on" ? 1 : 0);
-				m_sql.UpdatePreferencesVar("ShortLogAddOnlyNewValues", m_sql.m_bShortLogAddOnlyNewValues); cntSettings++;
+				preferences.push_back({ "ShortLogAddOnlyNewValues", m_sql.m_bShortLogAddOnlyNewValues, "" }); cntSettings++;
 
 				m_sql.m_bLogEventScriptTrigger = (request::findValue(&req, "LogEventScriptTrigger") == "on" ? 1 : 0);
-				m_sql.UpdatePreferencesVar("LogEventScriptTrigger", m_sql.m_bLogEventScriptTrigger); cntSettings++;
+				preferences.push_back({ "LogEventScriptTrigger", m_sql.m_bLogEventScriptTrigger, "" }); cntSettings++;
 
 				m_sql.m_bAllowWidgetOrdering = (request::findValue(&req, "AllowWidgetOrdering") == "on" ? 1 : 0);
-				m_sql.UpdatePreferencesVar("AllowWidgetOrdering", m_sql.m_bAllowWidgetOrdering); cntSettings++;
+				preferences.push_back({ "AllowWidgetOrdering", m_sql.m_bAllowWidgetOrdering, "" }); cntSettings++;
 
 				int iEnableNewHardware = (request::findValue(&req, "AcceptNewHardware") == "on" ? 1 : 0);
 				m_sql.m_bAcceptNewHardware = (iEnableNewHardware == 1);
-				m_sql.UpdatePreferencesVar("AcceptNewHardware", m_sql.m_bAcceptNewHardware); cntSettings++;
+				preferences.push_back({ "AcceptNewHardware", m_sql.m_bAcceptNewHardware, "" }); cntSettings++;
 
 				int nUnit = atoi(request::findValue(&req, "WindUnit").c_str());
 				m_sql.m_windunit = (_eWindUnit)nUnit;
-				m_sql.UpdatePreferencesVar("WindUnit", m_sql.m_windunit); cntSettings++;
+				preferences.push_back({ "WindUnit", m_sql.m_windunit, "" }); cntSettings++;
 
 				nUnit = atoi(request::findValue(&req, "TempUnit").c_str());
 				m_sql.m_tempunit = (_eTempUnit)nUnit;
-				m_sql.UpdatePreferencesVar("TempUnit", m_sql.m_tempunit); cntSettings++;
+				preferences.push_back({ "TempUnit", m_sql.m_tempunit, "" }); cntSettings++;
 
 				nUnit = atoi(request::findValue(&req, "WeightUnit").c_str());
 				m_sql.m_weightunit = (_eWeightUnit)nUnit;
-				m_sql.UpdatePreferencesVar("WeightUnit", m_sql.m_weightunit); cntSettings++;
+				preferences.push_back({ "WeightUnit", m_sql.m_weightunit, "" }); cntSettings++;
 
+				m_sql.UpdatePreferencesVars(preferences);
 				m_sql.SetUnitsAndScale();
 
 				/* Update Preferences and call other functions as well due to changes */
@@ -8468,9 +8653,39 @@ namespace http
 			std::string Mode2; // Used to flag DimmerType as relative for some old LimitLessLight type bulbs
 		} tHardwareList;
 
+		void CWebServer::GetJSonDevicesHeader(Json::Value& root, const time_t now)
+		{
+			root["ActTime"] = static_cast<int>(now);
+
+			if (!m_mainworker.m_LastSunriseSet.empty())
+			{
+				std::vector<std::string> strarray;
+				StringSplit(m_mainworker.m_LastSunriseSet, ";", strarray);
+				if (strarray.size() == 10)
+				{
+					struct tm tm1;
+					localtime_r(&now, &tm1);
+					char szTmp[80];
+					// strftime(szTmp, 80, "%b %d %Y %X", &tm1);
+					strftime(szTmp, 80, "%Y-%m-%d %X", &tm1);
+					root["ServerTime"] = szTmp;
+					root["Sunrise"] = strarray[0];
+					root["Sunset"] = strarray[1];
+					root["SunAtSouth"] = strarray[2];
+					root["CivTwilightStart"] = strarray[3];
+					root["CivTwilightEnd"] = strarray[4];
+					root["NautTwilightStart"] = strarray[5];
+					root["NautTwilightEnd"] = strarray[6];
+					root["AstrTwilightStart"] = strarray[7];
+					root["AstrTwilightEnd"] = strarray[8];
+					root["DayLength"] = strarray[9];
+				}
+			}
+		}
+
 		void CWebServer::GetJSonDevices(Json::Value& root, const std::string& rused, const std::string& rfilter, const std::string& order, const std::string& rowid, const std::string& planID,
 			const std::string& floorID, const bool bDisplayHidden, const bool bDisplayDisabled, const bool bFetchFavorites, const time_t LastUpdate,
-			const std::string& username, const std::string& hardwareid)
+			const std::string& username, const std::string& hardwareid, const std::set<uint64_t>* pDeviceFilter)
 		{
 			std::vector<std::vector<std::string>> result;
 
@@ -8487,7 +8702,7 @@ namespace http
 
 			// Get All Hardware ID's/Names, need them later
 			std::map<int, _tHardwareListInt> _hardwareNames;
-			result = m_sql.safe_query("SELECT ID, Name, Enabled, Type, Mode1, Mode2 FROM Hardware");
+			result = m_sql.safe_query_readonly("SELECT ID, Name, Enabled, Type, Mode1, Mode2 FROM Hardware");
 			if (!result.empty())
 			{
 				for (const auto& sd : result)
@@ -8515,34 +8730,25 @@ namespace http
 				}
 			}
 
-			root["ActTime"] = static_cast<int>(now);
+			GetJSonDevicesHeader(root, now);
 
 			char szTmp[300];
 
-			if (!m_mainworker.m_LastSunriseSet.empty())
+			char szOrderBy[50];
+			std::string szQuery;
+			// Only fetch the requested devices instead of filtering the complete list
+			std::string szDeviceFilter;
+			if (pDeviceFilter != nullptr)
 			{
-				std::vector<std::string> strarray;
-				StringSplit(m_mainworker.m_LastSunriseSet, ";", strarray);
-				if (strarray.size() == 10)
+				szDeviceFilter = " AND (A.ID IN (";
+				for (auto itt = pDeviceFilter->begin(); itt != pDeviceFilter->end(); ++itt)
 				{
-					// strftime(szTmp, 80, "%b %d %Y %X", &tm1);
-					strftime(szTmp, 80, "%Y-%m-%d %X", &tm1);
-					root["ServerTime"] = szTmp;
-					root["Sunrise"] = strarray[0];
-					root["Sunset"] = strarray[1];
-					root["SunAtSouth"] = strarray[2];
-					root["CivTwilightStart"] = strarray[3];
-					root["CivTwilightEnd"] = strarray[4];
-					root["NautTwilightStart"] = strarray[5];
-					root["NautTwilightEnd"] = strarray[6];
-					root["AstrTwilightStart"] = strarray[7];
-					root["AstrTwilightEnd"] = strarray[8];
-					root["DayLength"] = strarray[9];
+					if (itt != pDeviceFilter->begin())
+						szDeviceFilter += ',';
+					szDeviceFilter += std::to_string(*itt);
 				}
+				szDeviceFilter += "))";
 			}
-
-			char szOrderBy[50];
-			std::string szQuery;
 			bool isAlpha = true;
 			const std::string orderBy = order;
 			for (char i : orderBy)
@@ -8575,7 +8781,7 @@ namespace http
 				{
 					if (m_users[iUser].TotSensors > 0)
 					{
-						result = m_sql.safe_query("SELECT COUNT(*) FROM SharedDevices WHERE (SharedUserID == %lu)", m_users[iUser].ID);
+						result = m_sql.safe_query_readonly("SELECT COUNT(*) FROM SharedDevices WHERE (SharedUserID == %lu)", m_users[iUser].ID);
 						if (!result.empty())
 						{
 							totUserDevices = (unsigned int)std::stoi(result[0][0]);
@@ -8591,24 +8797,24 @@ namespace http
 			int ii = 0;
 			if (rfilter == "all")
 			{
-				if ((bShowScenes) && ((rused == "all") || (rused == "true")))
+				if ((bShowScenes) && ((rused == "all") || (rused == "true")) && (pDeviceFilter == nullptr))
 				{
 					// add scenes
 					if (!rowid.empty())
-						result = m_sql.safe_query("SELECT A.ID, A.Name, A.nValue, A.LastUpdate, A.Favorite, A.SceneType,"
+						result = m_sql.safe_query_readonly("SELECT A.ID, A.Name, A.nValue, A.LastUpdate, A.Favorite, A.SceneType,"
 							" A.Protected, B.XOffset, B.YOffset, B.PlanID, A.Description"
 							" FROM Scenes as A"
 							" LEFT OUTER JOIN DeviceToPlansMap as B ON (B.DeviceRowID==a.ID) AND (B.DevSceneType==1)"
 							" WHERE (A.ID=='%q')",
 							rowid.c_str());
 					else if ((!planID.empty()) && (planID != "0"))
-						result = m_sql.safe_query("SELECT A.ID, A.Name, A.nValue, A.LastUpdate, A.Favorite, A.SceneType,"
+						result = m_sql.safe_query_readonly("SELECT A.ID, A.Name, A.nValue, A.LastUpdate, A.Favorite, A.SceneType,"
 							" A.Protected, B.XOffset, B.YOffset, B.PlanID, A.Description"
 							" FROM Scenes as A, DeviceToPlansMap as B WHERE (B.PlanID=='%q')"
 							" AND (B.DeviceRowID==a.ID) AND (B.DevSceneType==1) ORDER BY B.[Order]",
 							planID.c_str());
 					else if ((!floorID.empty()) && (floorID != "0"))
-						result = m_sql.safe_query("SELECT A.ID, A.Name, A.nValue, A.LastUpdate, A.Favorite, A.SceneType,"
+						result = m_sql.safe_query_readonly("SELECT A.ID, A.Name, A.nValue, A.LastUpdate, A.Favorite, A.SceneType,"
 							" A.Protected, B.XOffset, B.YOffset, B.PlanID, A.Description"
 							" FROM Scenes as A, DeviceToPlansMap as B, Plans as C"
 							" WHERE (C.FloorplanID=='%q') AND (C.ID==B.PlanID) AND (B.DeviceRowID==a.ID)"
@@ -8724,7 +8930,7 @@ namespace http
 				if (!rowid.empty())
 				{
 					//_log.Log(LOG_STATUS, "Getting device with id: %s", rowid.c_str());
-					result = m_sql.safe_query("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used, A.Type, A.SubType,"
+					result = m_sql.safe_query_readonly("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used, A.Type, A.SubType,"
 						" A.SignalLevel, A.BatteryLevel, A.nValue, A.sValue,"
 						" A.LastUpdate, A.Favorite, A.SwitchType, A.HardwareID,"
 						" A.AddjValue, A.AddjMulti, A.AddjValue2, A.AddjMulti2,"
@@ -8736,7 +8942,7 @@ namespace http
 						rowid.c_str());
 				}
 				else if ((!planID.empty()) && (planID != "0"))
-					result = m_sql.safe_query("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
+					result = m_sql.safe_query_readonly("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
 						" A.Type, A.SubType, A.SignalLevel, A.BatteryLevel,"
 						" A.nValue, A.sValue, A.LastUpdate, A.Favorite,"
 						" A.SwitchType, A.HardwareID, A.AddjValue,"
@@ -8747,10 +8953,10 @@ namespace http
 						" A.Options, A.Color "
 						"FROM DeviceStatus as A, DeviceToPlansMap as B "
 						"WHERE (B.PlanID=='%q') AND (B.DeviceRowID==a.ID)"
-						" AND (B.DevSceneType==0) ORDER BY B.[Order]",
-						planID.c_str());
+						" AND (B.DevSceneType==0)%s ORDER BY B.[Order]",
+						planID.c_str(), szDeviceFilter.c_str());
 				else if ((!floorID.empty()) && (floorID != "0"))
-					result = m_sql.safe_query("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
+					result = m_sql.safe_query_readonly("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
 						" A.Type, A.SubType, A.SignalLevel, A.BatteryLevel,"
 						" A.nValue, A.sValue, A.LastUpdate, A.Favorite,"
 						" A.SwitchType, A.HardwareID, A.AddjValue,"
@@ -8762,19 +8968,19 @@ namespace http
 						"FROM DeviceStatus as A, DeviceToPlansMap as B,"
 						" Plans as C "
 						"WHERE (C.FloorplanID=='%q') AND (C.ID==B.PlanID)"
-						" AND (B.DeviceRowID==a.ID) AND (B.DevSceneType==0) "
+						" AND (B.DeviceRowID==a.ID) AND (B.DevSceneType==0)%s "
 						"ORDER BY B.[Order]",
-						floorID.c_str());
+						floorID.c_str(), szDeviceFilter.c_str());
 				else
 				{
 					if (!bDisplayHidden)
 					{
 						// Build a list of Hidden Devices
-						result = m_sql.safe_query("SELECT ID FROM Plans WHERE (Name=='$Hidden Devices')");
+						result = m_sql.safe_query_readonly("SELECT ID FROM Plans WHERE (Name=='$Hidden Devices')");
 						if (!result.empty())
 						{
 							std::string pID = result[0][0];
-							result = m_sql.safe_query("SELECT DeviceRowID FROM DeviceToPlansMap WHERE (PlanID=='%q') AND (DevSceneType==0)", pID.c_str());
+							result = m_sql.safe_query_readonly("SELECT DeviceRowID FROM DeviceToPlansMap WHERE (PlanID=='%q') AND (DevSceneType==0)", pID.c_str());
 							if (!result.empty())
 							{
 								for (const auto& r : result)
@@ -8804,8 +9010,9 @@ namespace http
 							" A.Options, A.Color "
 							"FROM DeviceStatus as A LEFT OUTER JOIN DeviceToPlansMap as B "
 							"ON (B.DeviceRowID==a.ID) AND (B.DevSceneType==0) "
-							"WHERE (A.HardwareID == %q) "
-							"ORDER BY ");
+							"WHERE (A.HardwareID == %q)");
+						szQuery += szDeviceFilter;
+						szQuery += " ORDER BY ";
 						szQuery += szOrderBy;
 						result = m_sql.safe_query(szQuery.c_str(), hardwareid.c_str(), order.c_str());
 					}
@@ -8820,7 +9027,9 @@ namespace http
 							" A.Options, A.Color "
 							"FROM DeviceStatus as A LEFT OUTER JOIN DeviceToPlansMap as B "
 							"ON (B.DeviceRowID==a.ID) AND (B.DevSceneType==0) "
-							"ORDER BY ");
+							"WHERE (1==1)");
+						szQuery += szDeviceFilter;
+						szQuery += " ORDER BY ";
 						szQuery += szOrderBy;
 						result = m_sql.safe_query(szQuery.c_str(), order.c_str());
 					}
@@ -8836,7 +9045,7 @@ namespace http
 				if (!rowid.empty())
 				{
 					//_log.Log(LOG_STATUS, "Getting device with id: %s for user %lu", rowid.c_str(), m_users[iUser].ID);
-					result = m_sql.safe_query("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
+					result = m_sql.safe_query_readonly("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
 						" A.Type, A.SubType, A.SignalLevel, A.BatteryLevel,"
 						" A.nValue, A.sValue, A.LastUpdate, B.Favorite,"
 						" A.SwitchType, A.HardwareID, A.AddjValue,"
@@ -8851,7 +9060,7 @@ namespace http
 						m_users[iUser].ID, rowid.c_str());
 				}
 				else if ((!planID.empty()) && (planID != "0"))
-					result = m_sql.safe_query("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
+					result = m_sql.safe_query_readonly("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
 						" A.Type, A.SubType, A.SignalLevel, A.BatteryLevel,"
 						" A.nValue, A.sValue, A.LastUpdate, B.Favorite,"
 						" A.SwitchType, A.HardwareID, A.AddjValue,"
@@ -8864,10 +9073,10 @@ namespace http
 						" DeviceToPlansMap as C "
 						"WHERE (C.PlanID=='%q') AND (C.DeviceRowID==a.ID)"
 						" AND (B.DeviceRowID==a.ID) "
-						"AND (B.SharedUserID==%lu) ORDER BY C.[Order]",
-						planID.c_str(), m_users[iUser].ID);
+						"AND (B.SharedUserID==%lu)%s ORDER BY C.[Order]",
+						planID.c_str(), m_users[iUser].ID, szDeviceFilter.c_str());
 				else if ((!floorID.empty()) && (floorID != "0"))
-					result = m_sql.safe_query("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
+					result = m_sql.safe_query_readonly("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
 						" A.Type, A.SubType, A.SignalLevel, A.BatteryLevel,"
 						" A.nValue, A.sValue, A.LastUpdate, B.Favorite,"
 						" A.SwitchType, A.HardwareID, A.AddjValue,"
@@ -8880,18 +9089,18 @@ namespace http
 						" DeviceToPlansMap as C, Plans as D "
 						"WHERE (D.FloorplanID=='%q') AND (D.ID==C.PlanID)"
 						" AND (C.DeviceRowID==a.ID) AND (B.DeviceRowID==a.ID)"
-						" AND (B.SharedUserID==%lu) ORDER BY C.[Order]",
-						floorID.c_str(), m_users[iUser].ID);
+						" AND (B.SharedUserID==%lu)%s ORDER BY C.[Order]",
+						floorID.c_str(), m_users[iUser].ID, szDeviceFilter.c_str());
 				else
 				{
 					if (!bDisplayHidden)
 					{
 						// Build a list of Hidden Devices
-						result = m_sql.safe_query("SELECT ID FROM Plans WHERE (Name=='$Hidden Devices')");
+						result = m_sql.safe_query_readonly("SELECT ID FROM Plans WHERE (Name=='$Hidden Devices')");
 						if (!result.empty())
 						{
 							std::string pID = result[0][0];
-							result = m_sql.safe_query("SELECT DeviceRowID FROM DeviceToPlansMap WHERE (PlanID=='%q')  AND (DevSceneType==0)", pID.c_str());
+							result = m_sql.safe_query_readonly("SELECT DeviceRowID FROM DeviceToPlansMap WHERE (PlanID=='%q')  AND (DevSceneType==0)", pID.c_str());
 							if (!result.empty())
 							{
 								for (const auto& r : result)
@@ -8924,7 +9133,9 @@ namespace http
 						"FROM DeviceStatus as A, SharedDevices as B "
 						"LEFT OUTER JOIN DeviceToPlansMap as C  ON (C.DeviceRowID==A.ID)"
 						"WHERE (B.DeviceRowID==A.ID)"
-						" AND (B.SharedUserID==%lu) ORDER BY ");
+						" AND (B.SharedUserID==%lu)");
+					szQuery += szDeviceFilter;
+					szQuery += " ORDER BY ";
 					szQuery += szOrderBy;
 					result = m_sql.safe_query(szQuery.c_str(), m_users[iUser].ID, order.c_str());
 				}
@@ -8937,6 +9148,9 @@ namespace http
 			{
 				try
 				{
+					if ((pDeviceFilter != nullptr) && (pDeviceFilter->find(std::stoull(sd[0])) == pDeviceFilter->end()))
+						continue;
+
 					unsigned char favorite = atoi(sd[12].c_str());
 					bool bIsInPlan = !planID.empty() && (planID != "0");
 
@@ -9130,7 +9344,7 @@ namespace http
 					root["result"][ii]["idx"] = sd[0];
 					root["result"][ii]["Protected"] = (iProtected != 0);
 
-					CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(hardwareID);
+					std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(hardwareID);
 					if (pHardware != nullptr)
 					{
 						if (pHardware->HwdType == HTYPE_SolarEdgeAPI)
@@ -9140,7 +9354,7 @@ namespace http
 						}
 						else if (pHardware->HwdType == HTYPE_Wunderground)
 						{
-							CWunderground* pWHardware = dynamic_cast<CWunderground*>(pHardware);
+							CWunderground* pWHardware = dynamic_cast<CWunderground*>(pHardware.get());
 							std::string forecast_url = pWHardware->GetForecastURL();
 							if (!forecast_url.empty())
 							{
@@ -9149,7 +9363,7 @@ namespace http
 						}
 						else if (pHardware->HwdType == HTYPE_DarkSky)
 						{
-							CDarkSky* pWHardware = dynamic_cast<CDarkSky*>(pHardware);
+							CDarkSky* pWHardware = dynamic_cast<CDarkSky*>(pHardware.get());
 							std::string forecast_url = pWHardware->GetForecastURL();
 							if (!forecast_url.empty())
 							{
@@ -9158,7 +9372,7 @@ namespace http
 						}
 						else if (pHardware->HwdType == HTYPE_VisualCrossing)
 						{
-							CVisualCrossing* pWHardware = dynamic_cast<CVisualCrossing*>(pHardware);
+							CVisualCrossing* pWHardware = dynamic_cast<CVisualCrossing*>(pHardware.get());
 							std::string forecast_url = pWHardware->GetForecastURL();
 							if (!forecast_url.empty())
 							{
@@ -9167,7 +9381,7 @@ namespace http
 						}
 						else if (pHardware->HwdType == HTYPE_AccuWeather)
 						{
-							CAccuWeather* pWHardware = dynamic_cast<CAccuWeather*>(pHardware);
+							CAccuWeather* pWHardware = dynamic_cast<CAccuWeather*>(pHardware.get());
 							std::string forecast_url = pWHardware->GetForecastURL();
 							if (!forecast_url.empty())
 							{
@@ -9176,7 +9390,7 @@ namespace http
 						}
 						else if (pHardware->HwdType == HTYPE_OpenWeatherMap)
 						{
-							COpenWeatherMap* pWHardware = dynamic_cast<COpenWeatherMap*>(pHardware);
+							COpenWeatherMap* pWHardware = dynamic_cast<COpenWeatherMap*>(pHardware.get());
 							std::string forecast_url = pWHardware->GetForecastURL();
 							if (!forecast_url.empty())
 							{
@@ -9185,7 +9399,7 @@ namespace http
 						}
 						else if (pHardware->HwdType == HTYPE_BuienRadar)
 						{
-							CBuienRadar* pWHardware = dynamic_cast<CBuienRadar*>(pHardware);
+							CBuienRadar* pWHardware = dynamic_cast<CBuienRadar*>(pHardware.get());
 							std::string forecast_url = pWHardware->GetForecastURL();
 							if (!forecast_url.empty())
 							{
@@ -9194,7 +9408,7 @@ namespace http
 						}
 						else if (pHardware->HwdType == HTYPE_Meteorologisk)
 						{
-							CMeteorologisk* pWHardware = dynamic_cast<CMeteorologisk*>(pHardware);
+							CMeteorologisk* pWHardware = dynamic_cast<CMeteorologisk*>(pHardware.get());
 							std::string forecast_url = pWHardware->GetForecastURL();
 							if (!forecast_url.empty())
 							{
@@ -9310,7 +9524,7 @@ namespace http
 						{
 							if (pHardware->HwdType == HTYPE_OpenZWave)
 							{
-								COpenZWave* pZWave = dynamic_cast<COpenZWave*>(pHardware);
+								COpenZWave* pZWave = dynamic_cast<COpenZWave*>(pHardware.get());
 								unsigned long ID;
 								std::stringstream s_strid;
 								s_strid << std::hex << sd[1];
@@ -9397,7 +9611,7 @@ namespace http
 
 						bool bIsSubDevice = false;
 						std::vector<std::vector<std::string>> resultSD;
-						resultSD = m_sql.safe_query("SELECT ID FROM LightSubDevices WHERE (DeviceRowID=='%q')", sd[0].c_str());
+						resultSD = m_sql.safe_query_readonly("SELECT ID FROM LightSubDevices WHERE (DeviceRowID=='%q')", sd[0].c_str());
 						bIsSubDevice = (!resultSD.empty());
 
 						root["result"][ii]["IsSubDevice"] = bIsSubDevice;
@@ -9764,10 +9978,7 @@ namespace http
 
 						_tTrendCalculator::_eTendencyType tstate = _tTrendCalculator::_eTendencyType::TENDENCY_UNKNOWN;
 						uint64_t tID = ((uint64_t)(hardwareID & 0x7FFFFFFF) << 32) | (devIdx & 0x7FFFFFFF);
-						if (m_mainworker.m_trend_calculator.find(tID) != m_mainworker.m_trend_calculator.end())
-						{
-							tstate = m_mainworker.m_trend_calculator[tID].m_state;
-						}
+						tstate = m_mainworker.GetTrendState(tID);
 						root["result"][ii]["trend"] = (int)tstate;
 					}
 					else if (dType == pTypeThermostat1)
@@ -9793,10 +10004,7 @@ namespace http
 						root["result"][ii]["HaveTimeout"] = bHaveTimeout;
 						_tTrendCalculator::_eTendencyType tstate = _tTrendCalculator::_eTendencyType::TENDENCY_UNKNOWN;
 						uint64_t tID = ((uint64_t)(hardwareID & 0x7FFFFFFF) << 32) | (devIdx & 0x7FFFFFFF);
-						if (m_mainworker.m_trend_calculator.find(tID) != m_mainworker.m_trend_calculator.end())
-						{
-							tstate = m_mainworker.m_trend_calculator[tID].m_state;
-						}
+						tstate = m_mainworker.GetTrendState(tID);
 						root["result"][ii]["trend"] = (int)tstate;
 					}
 					else if (dType == pTypeHUM)
@@ -9831,10 +10039,7 @@ namespace http
 
 							_tTrendCalculator::_eTendencyType tstate = _tTrendCalculator::_eTendencyType::TENDENCY_UNKNOWN;
 							uint64_t tID = ((uint64_t)(hardwareID & 0x7FFFFFFF) << 32) | (devIdx & 0x7FFFFFFF);
-							if (m_mainworker.m_trend_calculator.find(tID) != m_mainworker.m_trend_calculator.end())
-							{
-								tstate = m_mainworker.m_trend_calculator[tID].m_state;
-							}
+							tstate = m_mainworker.GetTrendState(tID);
 							root["result"][ii]["trend"] = (int)tstate;
 						}
 					}
@@ -9879,10 +10084,7 @@ namespace http
 
 							_tTrendCalculator::_eTendencyType tstate = _tTrendCalculator::_eTendencyType::TENDENCY_UNKNOWN;
 							uint64_t tID = ((uint64_t)(hardwareID & 0x7FFFFFFF) << 32) | (devIdx & 0x7FFFFFFF);
-							if (m_mainworker.m_trend_calculator.find(tID) != m_mainworker.m_trend_calculator.end())
-							{
-								tstate = m_mainworker.m_trend_calculator[tID].m_state;
-							}
+							tstate = m_mainworker.GetTrendState(tID);
 							root["result"][ii]["trend"] = (int)tstate;
 						}
 					}
@@ -9905,10 +10107,7 @@ namespace http
 
 							_tTrendCalculator::_eTendencyType tstate = _tTrendCalculator::_eTendencyType::TENDENCY_UNKNOWN;
 							uint64_t tID = ((uint64_t)(hardwareID & 0x7FFFFFFF) << 32) | (devIdx & 0x7FFFFFFF);
-							if (m_mainworker.m_trend_calculator.find(tID) != m_mainworker.m_trend_calculator.end())
-							{
-								tstate = m_mainworker.m_trend_calculator[tID].m_state;
-							}
+							tstate = m_mainworker.GetTrendState(tID);
 							root["result"][ii]["trend"] = (int)tstate;
 						}
 					}
@@ -9929,10 +10128,7 @@ namespace http
 
 								_tTrendCalculator::_eTendencyType tstate = _tTrendCalculator::_eTendencyType::TENDENCY_UNKNOWN;
 								uint64_t tID = ((uint64_t)(hardwareID & 0x7FFFFFFF) << 32) | (devIdx & 0x7FFFFFFF);
-								if (m_mainworker.m_trend_calculator.find(tID) != m_mainworker.m_trend_calculator.end())
-								{
-									tstate = m_mainworker.m_trend_calculator[tID].m_state;
-								}
+								tstate = m_mainworker.GetTrendState(tID);
 								root["result"][ii]["trend"] = (int)tstate;
 							}
 							else
@@ -9993,10 +10189,7 @@ namespace http
 
 								_tTrendCalculator::_eTendencyType tstate = _tTrendCalculator::_eTendencyType::TENDENCY_UNKNOWN;
 								uint64_t tID = ((uint64_t)(hardwareID & 0x7FFFFFFF) << 32) | (devIdx & 0x7FFFFFFF);
-								if (m_mainworker.m_trend_calculator.find(tID) != m_mainworker.m_trend_calculator.end())
-								{
-									tstate = m_mainworker.m_trend_calculator[tID].m_state;
-								}
+								tstate = m_mainworker.GetTrendState(tID);
 								root["result"][ii]["trend"] = (int)tstate;
 							}
 							root["result"][ii]["Data"] = sValue;
@@ -10017,30 +10210,32 @@ namespace http
 							sprintf(szDate, "%04d-%02d-%02d", ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday);
 
 							std::vector<std::vector<std::string>> result2;
+							_tTodayCounter counter;
+							bool bHaveToday;
 
 							if (dSubType == sTypeRAINWU || dSubType == sTypeRAINByRate)
 							{
-								result2 = m_sql.safe_query("SELECT Total, Rate FROM Rain WHERE (DeviceRowID='%q' AND Date>='%q') ORDER BY ROWID DESC LIMIT 1",
+								result2 = m_sql.safe_query_readonly("SELECT Total, Rate FROM Rain WHERE (DeviceRowID='%q' AND Date>='%q') ORDER BY ROWID DESC LIMIT 1",
 									sd[0].c_str(), szDate);
+								bHaveToday = !result2.empty();
 							}
 							else
 							{
-								result2 = m_sql.safe_query("SELECT MIN(Total), MAX(Total) FROM Rain WHERE (DeviceRowID='%q' AND Date>='%q')", sd[0].c_str(), szDate);
+								bHaveToday = m_sql.GetTodayCounter("Rain", std::stoull(sd[0]), counter);
 							}
 
-							if (!result2.empty())
+							if (bHaveToday)
 							{
 								double total_real = 0;
 								float rate = 0;
-								std::vector<std::string> sd2 = result2[0];
 
 								if (dSubType == sTypeRAINWU || dSubType == sTypeRAINByRate)
 								{
-									total_real = atof(sd2[0].c_str());
+									total_real = atof(result2[0][0].c_str());
 								}
 								else
 								{
-									double total_min = atof(sd2[0].c_str());
+									double total_min = counter.Min[0];
 									double total_max = atof(strarray[1].c_str());
 									total_real = total_max - total_min;
 								}
@@ -10048,7 +10243,7 @@ namespace http
 								total_real *= AddjMulti;
 								if (dSubType == sTypeRAINByRate)
 								{
-									rate = static_cast<float>(atof(sd2[1].c_str()) / 10000.0F);
+									rate = static_cast<float>(atof(result2[0][1].c_str()) / 10000.0F);
 								}
 								else
 								{
@@ -10091,7 +10286,7 @@ namespace http
 
 						std::vector<std::vector<std::string>> result2;
 						strcpy(szTmp, "0");
-						result2 = m_sql.safe_query("SELECT Value FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q') ORDER BY Date LIMIT 1", sd[0].c_str(), szDate);
+						result2 = m_sql.safe_query_readonly("SELECT Value FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q') ORDER BY Date LIMIT 1", sd[0].c_str(), szDate);
 						if (!result2.empty())
 						{
 							std::vector<std::string> sd2 = result2[0];
@@ -10191,21 +10386,12 @@ namespace http
 						double divider = m_sql.GetCounterDivider(int(metertype), int(dType), float(AddjValue2));
 
 						// get value of today
-						time_t now = mytime(nullptr);
-						struct tm ltime;
-						localtime_r(&now, &ltime);
-						char szDate[40];
-						sprintf(szDate, "%04d-%02d-%02d", ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday);
-
-						std::vector<std::vector<std::string>> result2;
 						strcpy(szTmp, "0");
-						result2 = m_sql.safe_query("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q')", sd[0].c_str(), szDate);
-						if (!result2.empty())
+						_tTodayCounter counter;
+						if (m_sql.GetTodayCounter("Meter", std::stoull(sd[0]), counter))
 						{
-							std::vector<std::string> sd2 = result2[0];
-
-							uint64_t total_min = std::stoull(sd2[0]);
-							uint64_t total_max = std::stoull(sd2[1]);
+							uint64_t total_min = static_cast<uint64_t>(counter.Min[0]);
+							uint64_t total_max = static_cast<uint64_t>(counter.Max[0]);
 							uint64_t total_real = total_max - total_min;
 
 							sprintf(szTmp, "%" PRIu64, total_real);
@@ -10391,24 +10577,14 @@ namespace http
 							root["result"][ii]["HaveTimeout"] = bHaveTimeout;
 
 							// get value of today
-							time_t now = mytime(nullptr);
-							struct tm ltime;
-							localtime_r(&now, &ltime);
-							char szDate[40];
-							sprintf(szDate, "%04d-%02d-%02d", ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday);
-
-							std::vector<std::vector<std::string>> result2;
 							strcpy(szTmp, "0");
-							result2 = m_sql.safe_query("SELECT MIN(Value1), MIN(Value2), MIN(Value5), MIN(Value6) FROM MultiMeter WHERE (DeviceRowID='%q' AND Date>='%q')",
-								sd[0].c_str(), szDate);
-							if (!result2.empty())
+							_tTodayCounter counter;
+							if (m_sql.GetTodayCounter("MultiMeter", std::stoull(sd[0]), counter))
 							{
-								std::vector<std::string> sd2 = result2[0];
-
-								uint64_t total_min_usage_1 = std::stoull(sd2[0]);
-								uint64_t total_min_deliv_1 = std::stoull(sd2[1]);
-								uint64_t total_min_usage_2 = std::stoull(sd2[2]);
-								uint64_t total_min_deliv_2 = std::stoull(sd2[3]);
+								uint64_t total_min_usage_1 = static_cast<uint64_t>(counter.Min[0]);
+								uint64_t total_min_deliv_1 = static_cast<uint64_t>(counter.Min[1]);
+								uint64_t total_min_usage_2 = static_cast<uint64_t>(counter.Min[4]);
+								uint64_t total_min_deliv_2 = static_cast<uint64_t>(counter.Min[5]);
 								uint64_t total_real_usage, total_real_deliv;
 
 								total_min_deliv_1 = (total_min_deliv_1 < 10) ? 0 : total_min_deliv_1;
@@ -10440,23 +10616,13 @@ namespace http
 						root["result"][ii]["SwitchTypeVal"] = MTYPE_GAS;
 
 						// get lowest value of today
-						time_t now = mytime(nullptr);
-						struct tm ltime;
-						localtime_r(&now, &ltime);
-						char szDate[40];
-						sprintf(szDate, "%04d-%02d-%02d", ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday);
-
-						std::vector<std::vector<std::string>> result2;
-
 						float divider = m_sql.GetCounterDivider(int(metertype), int(dType), float(AddjValue2));
 
 						strcpy(szTmp, "0");
-						result2 = m_sql.safe_query("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q')", sd[0].c_str(), szDate);
-						if (!result2.empty())
+						_tTodayCounter counter;
+						if (m_sql.GetTodayCounter("Meter", std::stoull(sd[0]), counter))
 						{
-							std::vector<std::string> sd2 = result2[0];
-
-							uint64_t total_min_gas = std::stoull(sd2[0]);
+							uint64_t total_min_gas = static_cast<uint64_t>(counter.Min[0]);
 							uint64_t gasactual;
 							try
 							{
@@ -10497,10 +10663,8 @@ namespace http
 						if (strarray.size() == 3)
 						{
 							// CM113
-							int displaytype = 0;
-							int voltage = 230;
-							m_sql.GetPreferencesVar("CM113DisplayType", displaytype);
-							m_sql.GetPreferencesVar("ElectricVoltage", voltage);
+							const int displaytype = m_sql.GetPreferencesInt("CM113DisplayType", 0);
+							const int voltage = m_sql.GetPreferencesInt("ElectricVoltage", 230);
 
 							double val1 = atof(strarray[0].c_str());
 							double val2 = atof(strarray[1].c_str());
@@ -10532,10 +10696,8 @@ namespace http
 						if (strarray.size() == 4)
 						{
 							// CM180i
-							int displaytype = 0;
-							int voltage = 230;
-							m_sql.GetPreferencesVar("CM113DisplayType", displaytype);
-							m_sql.GetPreferencesVar("ElectricVoltage", voltage);
+							const int displaytype = m_sql.GetPreferencesInt("CM113DisplayType", 0);
+							const int voltage = m_sql.GetPreferencesInt("ElectricVoltage", 230);
 
 							double total = atof(strarray[3].c_str());
 							if (displaytype == 0)
@@ -10574,8 +10736,8 @@ namespace http
 							std::vector<std::vector<std::string>> result2;
 							strcpy(szTmp, "0");
 							// get the first value of the day instead of the minimum value, because counter can also decrease
-							// result2 = m_sql.safe_query("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q')",
-							result2 = m_sql.safe_query("SELECT Value FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q') ORDER BY Date LIMIT 1", sd[0].c_str(), szDate);
+							// result2 = m_sql.safe_query_readonly("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q')",
+							result2 = m_sql.safe_query_readonly("SELECT Value FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q') ORDER BY Date LIMIT 1", sd[0].c_str(), szDate);
 							if (!result2.empty())
 							{
 								float divider = m_sql.GetCounterDivider(int(metertype), int(dType), float(AddjValue2));
@@ -10750,10 +10912,7 @@ namespace http
 							root["result"][ii]["Type"] = "temperature";
 							_tTrendCalculator::_eTendencyType tstate = _tTrendCalculator::_eTendencyType::TENDENCY_UNKNOWN;
 							uint64_t tID = ((uint64_t)(hardwareID & 0x7FFFFFFF) << 32) | (devIdx & 0x7FFFFFFF);
-							if (m_mainworker.m_trend_calculator.find(tID) != m_mainworker.m_trend_calculator.end())
-							{
-								tstate = m_mainworker.m_trend_calculator[tID].m_state;
-							}
+							tstate = m_mainworker.GetTrendState(tID);
 							root["result"][ii]["trend"] = (int)tstate;
 						}
 						else if (dSubType == sTypePercentage)
@@ -10905,7 +11064,7 @@ namespace http
 							{
 								if (pHardware->HwdType == HTYPE_OpenZWave)
 								{
-									COpenZWave* pZWave = dynamic_cast<COpenZWave*>(pHardware);
+									COpenZWave* pZWave = dynamic_cast<COpenZWave*>(pHardware.get());
 									unsigned long ID;
 									std::stringstream s_strid;
 									s_strid << std::hex << sd[1];
@@ -10950,7 +11109,7 @@ namespace http
 							{
 								if (pHardware->HwdType == HTYPE_OpenZWave)
 								{
-									COpenZWave* pZWave = dynamic_cast<COpenZWave*>(pHardware);
+									COpenZWave* pZWave = dynamic_cast<COpenZWave*>(pHardware.get());
 									unsigned long ID;
 									std::stringstream s_strid;
 									s_strid << std::hex << sd[1];
@@ -11020,7 +11179,7 @@ namespace http
 
 							std::vector<std::vector<std::string>> result2;
 							strcpy(szTmp, "0");
-							result2 = m_sql.safe_query("SELECT Value FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q') ORDER BY Date LIMIT 1", sd[0].c_str(), szDate);
+							result2 = m_sql.safe_query_readonly("SELECT Value FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q') ORDER BY Date LIMIT 1", sd[0].c_str(), szDate);
 							if (!result2.empty())
 							{
 								std::vector<std::string> sd2 = result2[0];
@@ -11264,21 +11423,12 @@ namespace http
 						case sTypeRego6XXCounter:
 						{
 							// get value of today
-							time_t now = mytime(nullptr);
-							struct tm ltime;
-							localtime_r(&now, &ltime);
-							char szDate[40];
-							sprintf(szDate, "%04d-%02d-%02d", ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday);
-
-							std::vector<std::vector<std::string>> result2;
 							strcpy(szTmp, "0");
-							result2 = m_sql.safe_query("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q')", sd[0].c_str(), szDate);
-							if (!result2.empty())
+							_tTodayCounter counter;
+							if (m_sql.GetTodayCounter("Meter", std::stoull(sd[0]), counter))
 							{
-								std::vector<std::string> sd2 = result2[0];
-
-								uint64_t total_min = std::stoull(sd2[0]);
-								uint64_t total_max = std::stoull(sd2[1]);
+								uint64_t total_min = static_cast<uint64_t>(counter.Min[0]);
+								uint64_t total_max = static_cast<uint64_t>(counter.Max[0]);
 								uint64_t total_real = total_max - total_min;
 
 								sprintf(szTmp, "%" PRIu64, total_real);
@@ -11297,7 +11447,7 @@ namespace http
 					{
 						if (pHardware->HwdType == HTYPE_PythonPlugin)
 						{
-							Plugins::CPlugin* pPlugin = (Plugins::CPlugin*)pHardware;
+							Plugins::CPlugin* pPlugin = (Plugins::CPlugin*)pHardware.get();
 							bHaveTimeout = pPlugin->HasNodeFailed(sd[1].c_str(), atoi(sd[2].c_str()));
 							root["result"][ii]["HaveTimeout"] = bHaveTimeout;
 						}
@@ -11582,7 +11732,7 @@ namespace http
 			bool bDisplayHidden = (sDisplayHidden == "1");
 
 			std::vector<std::vector<std::string>> result, result2;
-			result = m_sql.safe_query("SELECT ID, Name, [Order] FROM Plans ORDER BY [Order]");
+			result = m_sql.safe_query_readonly("SELECT ID, Name, [Order] FROM Plans ORDER BY [Order]");
 			if (!result.empty())
 			{
 				int ii = 0;
@@ -11599,7 +11749,7 @@ namespace http
 
 						unsigned int totDevices = 0;
 
-						result2 = m_sql.safe_query("SELECT COUNT(*) FROM DeviceToPlansMap WHERE (PlanID=='%q')", sd[0].c_str());
+						result2 = m_sql.safe_query_readonly("SELECT COUNT(*) FROM DeviceToPlansMap WHERE (PlanID=='%q')", sd[0].c_str());
 						if (!result2.empty())
 						{
 							totDevices = (unsigned int)atoi(result2[0][0].c_str());
@@ -11619,7 +11769,7 @@ namespace http
 
 			std::vector<std::vector<std::string>> result, result2, result3;
 
-			result = m_sql.safe_query("SELECT Key, nValue, sValue FROM Preferences WHERE Key LIKE 'Floorplan%%'");
+			result = m_sql.safe_query_readonly("SELECT Key, nValue, sValue FROM Preferences WHERE Key LIKE 'Floorplan%%'");
 			if (result.empty())
 				return;
 
@@ -11667,7 +11817,7 @@ namespace http
 				}
 			}
 
-			result2 = m_sql.safe_query("SELECT ID, Name, ScaleFactor, [Order] FROM Floorplans ORDER BY [Order]");
+			result2 = m_sql.safe_query_readonly("SELECT ID, Name, ScaleFactor, [Order] FROM Floorplans ORDER BY [Order]");
 			if (!result2.empty())
 			{
 				int ii = 0;
@@ -11682,7 +11832,7 @@ namespace http
 
 					unsigned int totPlans = 0;
 
-					result3 = m_sql.safe_query("SELECT COUNT(*) FROM Plans WHERE (FloorplanID=='%q')", sd[0].c_str());
+					result3 = m_sql.safe_query_readonly("SELECT COUNT(*) FROM Plans WHERE (FloorplanID=='%q')", sd[0].c_str());
 					if (!result3.empty())
 					{
 						totPlans = (unsigned int)atoi(result3[0][0].c_str());
@@ -11826,7 +11976,7 @@ namespace http
 #endif
 
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT ID, Name, Enabled, Type, Address, Port, SerialPort, Username, Password, Extra, Mode1, Mode2, Mode3, Mode4, Mode5, Mode6, DataTimeout, "
+			result = m_sql.safe_query_readonly("SELECT ID, Name, Enabled, Type, Address, Port, SerialPort, Username, Password, Extra, Mode1, Mode2, Mode3, Mode4, Mode5, Mode6, DataTimeout, "
 				"LogLevel FROM Hardware ORDER BY ID ASC");
 			if (!result.empty())
 			{
@@ -11868,13 +12018,13 @@ namespace http
 					root["result"][ii]["DataTimeout"] = atoi(sd[16].c_str());
 					root["result"][ii]["LogLevel"] = atoi(sd[17].c_str());
 
-					CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(atoi(sd[0].c_str()));
+					std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(atoi(sd[0].c_str()));
 					if (pHardware != nullptr)
 					{
 						if ((pHardware->HwdType == HTYPE_RFXtrx315) || (pHardware->HwdType == HTYPE_RFXtrx433) || (pHardware->HwdType == HTYPE_RFXtrx868) ||
 							(pHardware->HwdType == HTYPE_RFXLAN))
 						{
-							CRFXBase* pMyHardware = dynamic_cast<CRFXBase*>(pHardware);
+							CRFXBase* pMyHardware = dynamic_cast<CRFXBase*>(pHardware.get());
 							if (!pMyHardware->m_Version.empty())
 								root["result"][ii]["version"] = pMyHardware->m_Version;
 							else
@@ -11883,28 +12033,28 @@ namespace http
 						}
 						else if ((pHardware->HwdType == HTYPE_MySensorsUSB) || (pHardware->HwdType == HTYPE_MySensorsTCP) || (pHardware->HwdType == HTYPE_MySensorsMQTT))
 						{
-							MySensorsBase* pMyHardware = dynamic_cast<MySensorsBase*>(pHardware);
+							MySensorsBase* pMyHardware = dynamic_cast<MySensorsBase*>(pHardware.get());
 							root["result"][ii]["version"] = pMyHardware->GetGatewayVersion();
 						}
 						else if ((pHardware->HwdType == HTYPE_OpenThermGateway) || (pHardware->HwdType == HTYPE_OpenThermGatewayTCP))
 						{
-							OTGWBase* pMyHardware = dynamic_cast<OTGWBase*>(pHardware);
+							OTGWBase* pMyHardware = dynamic_cast<OTGWBase*>(pHardware.get());
 							root["result"][ii]["version"] = pMyHardware->m_Version;
 						}
 						else if ((pHardware->HwdType == HTYPE_RFLINKUSB) || (pHardware->HwdType == HTYPE_RFLINKTCP))
 						{
-							CRFLinkBase* pMyHardware = dynamic_cast<CRFLinkBase*>(pHardware);
+							CRFLinkBase* pMyHardware = dynamic_cast<CRFLinkBase*>(pHardware.get());
 							root["result"][ii]["version"] = pMyHardware->m_Version;
 						}
 						else if (pHardware->HwdType == HTYPE_EnphaseAPI)
 						{
-							EnphaseAPI* pMyHardware = dynamic_cast<EnphaseAPI*>(pHardware);
+							EnphaseAPI* pMyHardware = dynamic_cast<EnphaseAPI*>(pHardware.get());
 							root["result"][ii]["version"] = pMyHardware->m_szSoftwareVersion;
 						}
 #ifdef WITH_OPENZWAVE
 						else if (pHardware->HwdType == HTYPE_OpenZWave)
 						{ // Special case for openzwave (status for nodes queried)
-							COpenZWave* pOZWHardware = dynamic_cast<COpenZWave*>(pHardware);
+							COpenZWave* pOZWHardware = dynamic_cast<COpenZWave*>(pHardware.get());
 							root["result"][ii]["version"] = pOZWHardware->GetVersionLong();
 							root["result"][ii]["NodesQueried"] = (pOZWHardware->m_awakeNodesQueried || pOZWHardware->m_allNodesQueried);
 						}
@@ -11915,7 +12065,7 @@ namespace http
 			}
 		}
 
-		void CWebServer::RType_Devices(WebEmSession& session, const request& req, Json::Value& root)
+		void CWebServer::GetJSonDevicesPage(WebEmSession& session, const request& req, reply& rep)
 		{
 			std::string rfilter = request::findValue(&req, "filter");
 			std::string order = request::findValue(&req, "order");
@@ -11946,10 +12096,254 @@ namespace http
 				sstr >> LastUpdate;
 			}
 
+			Json::Value root;
 			root["status"] = "OK";
 			root["title"] = "Devices";
 			root["app_version"] = szAppVersion;
-			GetJSonDevices(root, rused, rfilter, order, rid, planid, floorid, bDisplayHidden, bDisabledDisabled, bFetchFavorites, LastUpdate, session.username, hwidx);
+
+			// Take the time before the version, every change after that version is at or after ActTime
+			time_t now = mytime(nullptr);
+			uint64_t Version = m_sql.GetDeviceListVersion();
+
+			std::string content;
+			std::string sETag;
+			if (!rid.empty())
+			{
+				// Single device, nothing to gain
+				GetJSonDevices(root, rused, rfilter, order, rid, planid, floorid, bDisplayHidden, bDisabledDisabled, bFetchFavorites, LastUpdate, session.username, hwidx);
+				content = root.toStyledString();
+			}
+			else
+			{
+				std::stringstream sstr;
+				sstr << rused << '|' << rfilter << '|' << order << '|' << planid << '|' << floorid << '|' << hwidx << '|' << bDisplayHidden << bDisabledDisabled
+				     << bFetchFavorites << '|' << session.username;
+				std::string sKey = sstr.str();
+
+				std::shared_ptr<const _tDeviceListCache> pCache;
+				uint64_t LastUpdateVersion = 0;
+				bool bHaveLastUpdateVersion = false;
+				{
+					std::lock_guard<std::mutex> l(m_device_list_cache_mutex);
+					auto itt = m_device_list_cache.find(sKey);
+					if (itt != m_device_list_cache.end())
+						pCache = itt->second;
+
+					if (LastUpdate != 0)
+					{
+						// Last version read before the second of LastUpdate, every change with a LastUpdate at or after it came later
+						auto itt2 = m_device_list_versions.lower_bound(LastUpdate);
+						if (itt2 != m_device_list_versions.begin())
+						{
+							--itt2;
+							LastUpdateVersion = itt2->second;
+							bHaveLastUpdateVersion = true;
+						}
+					}
+					m_device_list_versions.emplace(now, Version);
+					while ((!m_device_list_versions.empty()) && (m_device_list_versions.begin()->first < now - DEVICE_LIST_VERSION_HISTORY))
+						m_device_list_versions.erase(m_device_list_versions.begin());
+				}
+
+				if (LastUpdate != 0)
+				{
+					std::vector<uint64_t> ulIDs;
+					if ((bHaveLastUpdateVersion) && (m_sql.GetChangedDevices(LastUpdateVersion, ulIDs)))
+					{
+						if (ulIDs.empty())
+							GetJSonDevicesHeader(root, now);
+						else
+						{
+							std::set<uint64_t> changedIDs(ulIDs.begin(), ulIDs.end());
+							GetJSonDevices(root, rused, rfilter, order, "", planid, floorid, bDisplayHidden, bDisabledDisabled, bFetchFavorites, LastUpdate,
+								       session.username, hwidx, &changedIDs);
+						}
+					}
+					else
+						GetJSonDevices(root, rused, rfilter, order, "", planid, floorid, bDisplayHidden, bDisabledDisabled, bFetchFavorites, LastUpdate,
+							       session.username, hwidx);
+					content = root.toStyledString();
+				}
+				else
+				{
+					if ((pCache) && ((now < pCache->BuildTime) || (now - pCache->BuildTime >= DEVICE_LIST_CACHE_MAX_AGE)))
+						pCache = nullptr;
+
+					if ((pCache) && (pCache->Version != Version))
+					{
+						// Only render the devices that changed and replace their fragments
+						std::vector<uint64_t> ulIDs;
+						if (m_sql.GetChangedDevices(pCache->Version, ulIDs))
+						{
+							std::set<uint64_t> changedIDs(ulIDs.begin(), ulIDs.end());
+							Json::Value changed;
+							if (!changedIDs.empty())
+								GetJSonDevices(changed, rused, rfilter, order, "", planid, floorid, bDisplayHidden, bDisabledDisabled, bFetchFavorites, 0,
+									       session.username, hwidx, &changedIDs);
+
+							std::map<uint64_t, std::string> changedItems;
+							for (const auto& item : changed["result"])
+								changedItems[std::stoull(item["idx"].asString())] = JSonToRawString(item);
+
+							std::map<uint64_t, int64_t> changedOrders;
+							if (!changedItems.empty())
+								GetDeviceListOrders(&changedIDs, changedOrders);
+							std::map<int64_t, int> orderCount;
+							for (const auto& fragment : pCache->fragments)
+							{
+								if (!fragment.bIsScene)
+									orderCount[fragment.Order]++;
+							}
+
+							bool bMoved = false;
+							auto pNewCache = std::make_shared<_tDeviceListCache>();
+							pNewCache->Version = Version;
+							pNewCache->BuildTime = pCache->BuildTime;
+							for (const auto& fragment : pCache->fragments)
+							{
+								if ((!fragment.bIsScene) && (changedIDs.find(fragment.idx) != changedIDs.end()))
+								{
+									auto itt = changedItems.find(fragment.idx);
+									if (itt == changedItems.end())
+										continue; // no longer in this list
+									// A new [Order], or one shared with another device (the second sort column decides), can move it
+									auto ittOrder = changedOrders.find(fragment.idx);
+									int64_t Order = (ittOrder != changedOrders.end()) ? ittOrder->second : fragment.Order;
+									if ((Order != fragment.Order) || (orderCount[Order] > 1))
+										bMoved = true;
+									pNewCache->fragments.push_back({ fragment.idx, false, Order, std::move(itt->second) });
+									changedItems.erase(itt);
+								}
+								else
+									pNewCache->fragments.push_back(fragment);
+								pNewCache->ContentHash = pNewCache->ContentHash * 31 + std::hash<std::string>()(pNewCache->fragments.back().json);
+							}
+							// A device that was not in the list before can not be placed, rebuild
+							if ((changedItems.empty()) && (!bMoved))
+								pCache = pNewCache;
+							else
+								pCache = nullptr;
+						}
+						else
+							pCache = nullptr;
+					}
+
+					if (!pCache)
+					{
+						Json::Value devices;
+						GetJSonDevices(devices, rused, rfilter, order, "", planid, floorid, bDisplayHidden, bDisabledDisabled, bFetchFavorites, 0,
+							       session.username, hwidx);
+						pCache = BuildDeviceListCache(devices["result"], Version, now);
+					}
+
+					{
+						std::lock_guard<std::mutex> l(m_device_list_cache_mutex);
+						auto itt = m_device_list_cache.find(sKey);
+						if ((itt == m_device_list_cache.end()) && (m_device_list_cache.size() >= DEVICE_LIST_CACHE_MAX_ENTRIES))
+						{
+							auto ittOldest = m_device_list_cache.begin();
+							for (auto itt2 = m_device_list_cache.begin(); itt2 != m_device_list_cache.end(); ++itt2)
+							{
+								if (itt2->second->BuildTime < ittOldest->second->BuildTime)
+									ittOldest = itt2;
+							}
+							m_device_list_cache.erase(ittOldest);
+						}
+						// Do not replace a list built from newer data by another thread
+						if ((itt == m_device_list_cache.end()) || (itt->second->Version <= pCache->Version))
+							m_device_list_cache[sKey] = pCache;
+					}
+
+					sETag = std_format("\"%zx-%zx\"", pCache->ContentHash, std::hash<std::string>()(m_mainworker.m_LastSunriseSet));
+					const char* if_none_match = request::get_req_header(&req, "If-None-Match");
+					if ((if_none_match != nullptr) && (sETag == if_none_match))
+					{
+						rep.status = reply::not_modified;
+						rep.content.clear();
+						reply::add_header(&rep, "ETag", sETag);
+						return;
+					}
+
+					// Concatenate the cached fragments into the response
+					GetJSonDevicesHeader(root, now);
+					content = root.toStyledString();
+					if (!pCache->fragments.empty())
+					{
+						size_t pos = content.find_last_of('}');
+						std::string szResult = ",\n   \"result\" : [";
+						for (size_t ii = 0; ii < pCache->fragments.size(); ii++)
+						{
+							if (ii != 0)
+								szResult += ',';
+							szResult += pCache->fragments[ii].json;
+						}
+						szResult += "]\n";
+						content.insert(pos, szResult);
+					}
+				}
+			}
+
+			if (!sETag.empty())
+				reply::add_header(&rep, "ETag", sETag);
+			std::string jcallback = request::findValue(&req, "jsoncallback");
+			if (!jcallback.empty())
+			{
+				reply::set_content(&rep, "var data=" + content + '\n' + jcallback + "(data);");
+				return;
+			}
+			reply::set_content(&rep, content);
+		}
+
+		std::shared_ptr<const CWebServer::_tDeviceListCache> CWebServer::BuildDeviceListCache(const Json::Value& devices, const uint64_t Version, const time_t BuildTime)
+		{
+			auto pCache = std::make_shared<_tDeviceListCache>();
+			pCache->Version = Version;
+			pCache->BuildTime = BuildTime;
+			std::map<uint64_t, int64_t> orders;
+			GetDeviceListOrders(nullptr, orders);
+			for (const auto& item : devices)
+			{
+				_tDeviceListFragment fragment;
+				fragment.idx = std::stoull(item["idx"].asString());
+				std::string sType = item["Type"].asString();
+				fragment.bIsScene = ((sType == "Scene") || (sType == "Group"));
+				fragment.Order = 0;
+				if (!fragment.bIsScene)
+				{
+					auto itt = orders.find(fragment.idx);
+					if (itt != orders.end())
+						fragment.Order = itt->second;
+				}
+				fragment.json = JSonToRawString(item);
+				pCache->ContentHash = pCache->ContentHash * 31 + std::hash<std::string>()(fragment.json);
+				pCache->fragments.push_back(std::move(fragment));
+			}
+			return pCache;
+		}
+
+		void CWebServer::GetDeviceListOrders(const std::set<uint64_t>* pDeviceFilter, std::map<uint64_t, int64_t>& orders)
+		{
+			std::string szQuery = "SELECT ID, [Order] FROM DeviceStatus";
+			if (pDeviceFilter != nullptr)
+			{
+				szQuery += " WHERE (ID IN (";
+				for (auto itt = pDeviceFilter->begin(); itt != pDeviceFilter->end(); ++itt)
+				{
+					if (itt != pDeviceFilter->begin())
+						szQuery += ',';
+					szQuery += std::to_string(*itt);
+				}
+				szQuery += "))";
+			}
+			auto result = m_sql.safe_query_readonly("%s", szQuery.c_str());
+			for (const auto& sd : result)
+				orders[std::stoull(sd[0])] = std::stoll(sd[1]);
+		}
+
+		void CWebServer::ClearDeviceListCache()
+		{
+			std::lock_guard<std::mutex> l(m_device_list_cache_mutex);
+			m_device_list_cache.clear();
 		}
 
 		void CWebServer::RType_Users(WebEmSession& session, const request& req, Json::Value& root)
@@ -11961,7 +12355,7 @@ namespace http
 				return;
 
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT ID, Active, Username, Password, Rights, RemoteSharing, TabsEnabled FROM USERS ORDER BY ID ASC");
+			result = m_sql.safe_query_readonly("SELECT ID, Active, Username, Password, Rights, RemoteSharing, TabsEnabled FROM USERS ORDER BY ID ASC");
 			if (!result.empty())
 			{
 				int ii = 0;
@@ -11989,7 +12383,7 @@ namespace http
 				return;
 
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT ID, Active, Name, UUID, LastUpdate, DeviceType FROM MobileDevices ORDER BY Name COLLATE NOCASE ASC");
+			result = m_sql.safe_query_readonly("SELECT ID, Active, Name, UUID, LastUpdate, DeviceType FROM MobileDevices ORDER BY Name COLLATE NOCASE ASC");
 			if (!result.empty())
 			{
 				int ii = 0;
@@ -12052,7 +12446,7 @@ namespace http
 			root["title"] = "GetSceneActivations";
 
 			std::vector<std::vector<std::string>> result, result2;
-			result = m_sql.safe_query("SELECT Activators, SceneType FROM Scenes WHERE (ID==%q)", idx.c_str());
+			result = m_sql.safe_query_readonly("SELECT Activators, SceneType FROM Scenes WHERE (ID==%q)", idx.c_str());
 			if (result.empty())
 				return;
 			int ii = 0;
@@ -12075,7 +12469,7 @@ namespace http
 						sCode = atoi(arrayCode[1].c_str());
 					}
 
-					result2 = m_sql.safe_query("SELECT Name, [Type], SubType, SwitchType FROM DeviceStatus WHERE (ID==%q)", sID.c_str());
+					result2 = m_sql.safe_query_readonly("SELECT Name, [Type], SubType, SwitchType FROM DeviceStatus WHERE (ID==%q)", sID.c_str());
 					if (!result2.empty())
 					{
 						std::vector<std::string> sd = result2[0];
@@ -12122,7 +12516,7 @@ namespace http
 
 			// First check if we do not already have this device as activation code
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT Activators, SceneType FROM Scenes WHERE (ID==%q)", sceneidx.c_str());
+			result = m_sql.safe_query_readonly("SELECT Activators, SceneType FROM Scenes WHERE (ID==%q)", sceneidx.c_str());
 			if (result.empty())
 				return;
 			std::string Activators = result[0][0];
@@ -12181,7 +12575,7 @@ namespace http
 			root["title"] = "RemoveSceneCode";
 
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT Activators, SceneType FROM Scenes WHERE (ID==%q)", sceneidx.c_str());
+			result = m_sql.safe_query_readonly("SELECT Activators, SceneType FROM Scenes WHERE (ID==%q)", sceneidx.c_str());
 			if (result.empty())
 				return;
 			std::string Activators = result[0][0];
@@ -12273,7 +12667,7 @@ namespace http
 			root["title"] = "GetDevicesList";
 			int ii = 0;
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT ID, Name, Type, SubType FROM DeviceStatus WHERE (Used == 1) ORDER BY Name COLLATE NOCASE ASC");
+			result = m_sql.safe_query_readonly("SELECT ID, Name, Type, SubType FROM DeviceStatus WHERE (Used == 1) ORDER BY Name COLLATE NOCASE ASC");
 			if (!result.empty())
 			{
 				for (const auto& sd : result)
@@ -12484,7 +12878,7 @@ namespace http
 			{
 				// this is a sub device for another light/switch
 				// first check if it is not already a sub device
-				auto result = m_sql.safe_query("SELECT ID FROM LightSubDevices WHERE (DeviceRowID=='%q') AND (ParentID =='%q')", sIdx.c_str(), sMainDeviceIdx.c_str());
+				auto result = m_sql.safe_query_readonly("SELECT ID FROM LightSubDevices WHERE (DeviceRowID=='%q') AND (ParentID =='%q')", sIdx.c_str(), sMainDeviceIdx.c_str());
 				if (result.empty())
 				{
 					// no it is not, add it
@@ -12580,7 +12974,7 @@ namespace http
 			int iActive = (sactive == "1") ? 1 : 0;
 
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT ID, Name, DeviceType FROM MobileDevices WHERE (UUID=='%q')", suuid.c_str());
+			result = m_sql.safe_query_readonly("SELECT ID, Name, DeviceType FROM MobileDevices WHERE (UUID=='%q')", suuid.c_str());
 			if (result.empty())
 			{
 				// New
@@ -12635,7 +13029,7 @@ namespace http
 			if (suuid.empty())
 				return;
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT ID FROM MobileDevices WHERE (UUID=='%q')", suuid.c_str());
+			result = m_sql.safe_query_readonly("SELECT ID FROM MobileDevices WHERE (UUID=='%q')", suuid.c_str());
 			if (result.empty())
 				return;
 			m_sql.safe_query("DELETE FROM MobileDevices WHERE (UUID == '%q')", suuid.c_str());
@@ -12655,7 +13049,7 @@ namespace http
 			}
 
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT Type, SubType FROM DeviceStatus WHERE (ID==%" PRIu64 ")", idx);
+			result = m_sql.safe_query_readonly("SELECT Type, SubType FROM DeviceStatus WHERE (ID==%" PRIu64 ")", idx);
 			if (!result.empty())
 			{
 				int dType = atoi(result[0][0].c_str());
@@ -12664,15 +13058,15 @@ namespace http
 					//Allow a old Temperature device to be replaced by a new Temp+Hum or Temp+Hum+Baro
 					//Or a Temp+Hum to a Temp+Hum or Temp+Hum+Baro
 					if (dType == pTypeTEMP)
-						result = m_sql.safe_query("SELECT ID, Name, Type FROM DeviceStatus WHERE (Type=='%d') || (Type=='%d') || (Type=='%d') AND (ID!=%" PRIu64 ")", pTypeTEMP, pTypeTEMP_HUM, pTypeTEMP_HUM_BARO, idx);
+						result = m_sql.safe_query_readonly("SELECT ID, Name, Type FROM DeviceStatus WHERE (Type=='%d') || (Type=='%d') || (Type=='%d') AND (ID!=%" PRIu64 ")", pTypeTEMP, pTypeTEMP_HUM, pTypeTEMP_HUM_BARO, idx);
 					else if (dType == pTypeTEMP_HUM)
-						result = m_sql.safe_query("SELECT ID, Name, Type FROM DeviceStatus WHERE (Type=='%d') || (Type=='%d') AND (ID!=%" PRIu64 ")", pTypeTEMP_HUM, pTypeTEMP_HUM_BARO, idx);
+						result = m_sql.safe_query_readonly("SELECT ID, Name, Type FROM DeviceStatus WHERE (Type=='%d') || (Type=='%d') AND (ID!=%" PRIu64 ")", pTypeTEMP_HUM, pTypeTEMP_HUM_BARO, idx);
 					else
-						result = m_sql.safe_query("SELECT ID, Name, Type FROM DeviceStatus WHERE (Type=='%q') AND (ID!=%" PRIu64 ")", result[0][0].c_str(), idx);
+						result = m_sql.safe_query_readonly("SELECT ID, Name, Type FROM DeviceStatus WHERE (Type=='%q') AND (ID!=%" PRIu64 ")", result[0][0].c_str(), idx);
 				}
 				else
 				{
-					result = m_sql.safe_query("SELECT ID, Name FROM DeviceStatus WHERE (Type=='%q') AND (SubType=='%q') AND (ID!=%" PRIu64 ")", result[0][0].c_str(),
+					result = m_sql.safe_query_readonly("SELECT ID, Name FROM DeviceStatus WHERE (Type=='%q') AND (SubType=='%q') AND (ID!=%" PRIu64 ")", result[0][0].c_str(),
 						result[0][1].c_str(), idx);
 				}
 
@@ -12706,7 +13100,7 @@ namespace http
 			root["status"] = "OK";
 			root["title"] = "TransferDevice";
 
-			result = m_sql.safe_query("SELECT HardwareID, DeviceID, Unit, Type, SubType FROM DeviceStatus WHERE (ID == '%q')", newidx.c_str());
+			result = m_sql.safe_query_readonly("SELECT HardwareID, DeviceID, Unit, Type, SubType FROM DeviceStatus WHERE (ID == '%q')", newidx.c_str());
 			if (result.empty())
 				return;
 
@@ -12717,7 +13111,7 @@ namespace http
 			int subType = std::stoi(result[0].at(4));
 
 			//get last update date from old device
-			result = m_sql.safe_query("SELECT LastUpdate FROM DeviceStatus WHERE (ID == '%q')", sidx.c_str());
+			result = m_sql.safe_query_readonly("SELECT LastUpdate FROM DeviceStatus WHERE (ID == '%q')", sidx.c_str());
 			if (result.empty())
 				return;
 			std::string szLastOldDate = result[0][0];
@@ -12814,7 +13208,7 @@ namespace http
 			root["title"] = "GetSharedUserDevices";
 
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT DeviceRowID FROM SharedDevices WHERE (SharedUserID == '%q')", idx.c_str());
+			result = m_sql.safe_query_readonly("SELECT DeviceRowID FROM SharedDevices WHERE (SharedUserID == '%q')", idx.c_str());
 			if (!result.empty())
 			{
 				int ii = 0;
@@ -12865,7 +13259,7 @@ namespace http
 			if ((idx.empty()) || (sused.empty()))
 				return;
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT Type,SubType,HardwareID,CustomImage FROM DeviceStatus WHERE (ID == '%q')", idx.c_str());
+			result = m_sql.safe_query_readonly("SELECT Type,SubType,HardwareID,CustomImage FROM DeviceStatus WHERE (ID == '%q')", idx.c_str());
 			if (result.empty())
 				return;
 
@@ -13046,7 +13440,7 @@ namespace http
 #ifdef ENABLE_PYTHON
 				// check if HW is plugin
 				std::vector<std::vector<std::string>> result;
-				result = m_sql.safe_query("SELECT Type FROM Hardware WHERE (ID == %d)", HwdID);
+				result = m_sql.safe_query_readonly("SELECT Type FROM Hardware WHERE (ID == %d)", HwdID);
 				if (!result.empty())
 				{
 					_eHardwareTypes Type = (_eHardwareTypes)std::stoi(result[0][0]);
@@ -13131,7 +13525,7 @@ namespace http
 				{
 					// this is a sub device for another light/switch
 					// first check if it is not already a sub device
-					result = m_sql.safe_query("SELECT ID FROM LightSubDevices WHERE (DeviceRowID=='%q') AND (ParentID =='%q')", idx.c_str(), maindeviceidx.c_str());
+					result = m_sql.safe_query_readonly("SELECT ID FROM LightSubDevices WHERE (DeviceRowID=='%q') AND (ParentID =='%q')", idx.c_str(), maindeviceidx.c_str());
 					if (result.empty())
 					{
 						// no it is not, add it
@@ -13165,7 +13559,7 @@ namespace http
 			std::vector<std::vector<std::string>> result;
 			char szTmp[100];
 
-			result = m_sql.safe_query("SELECT Key, nValue, sValue FROM Preferences");
+			result = m_sql.safe_query_readonly("SELECT Key, nValue, sValue FROM Preferences");
 			if (result.empty())
 				return;
 			root["status"] = "OK";
@@ -13527,7 +13921,7 @@ namespace http
 			}
 			std::vector<std::vector<std::string>> result;
 			// First get Device Type/SubType
-			result = m_sql.safe_query("SELECT Type, SubType, SwitchType, Options FROM DeviceStatus WHERE (ID == %" PRIu64 ")", idx);
+			result = m_sql.safe_query_readonly("SELECT Type, SubType, SwitchType, Options FROM DeviceStatus WHERE (ID == %" PRIu64 ")", idx);
 			if (result.empty())
 				return;
 
@@ -13546,7 +13940,7 @@ namespace http
 			root["status"] = "OK";
 			root["title"] = "LightLog";
 
-			result = m_sql.safe_query("SELECT ROWID, nValue, sValue, User, Date FROM LightingLog WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date DESC", idx);
+			result = m_sql.safe_query_readonly("SELECT ROWID, nValue, sValue, User, Date FROM LightingLog WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date DESC", idx);
 			if (!result.empty())
 			{
 				std::map<std::string, std::string> selectorStatuses;
@@ -13651,7 +14045,7 @@ namespace http
 			root["status"] = "OK";
 			root["title"] = "TextLog";
 
-			result = m_sql.safe_query("SELECT ROWID, sValue, User, Date FROM LightingLog WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date DESC", idx);
+			result = m_sql.safe_query_readonly("SELECT ROWID, sValue, User, Date FROM LightingLog WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date DESC", idx);
 			if (!result.empty())
 			{
 				int ii = 0;
@@ -13678,7 +14072,7 @@ namespace http
 			root["status"] = "OK";
 			root["title"] = "SceneLog";
 
-			result = m_sql.safe_query("SELECT ROWID, nValue, User, Date FROM SceneLog WHERE (SceneRowID==%" PRIu64 ") ORDER BY Date DESC", idx);
+			result = m_sql.safe_query_readonly("SELECT ROWID, nValue, User, Date FROM SceneLog WHERE (SceneRowID==%" PRIu64 ") ORDER BY Date DESC", idx);
 			if (!result.empty())
 			{
 				int ii = 0;
@@ -13749,7 +14143,7 @@ namespace http
 			struct tm tm1;
 			localtime_r(&now, &tm1);
 
-			result = m_sql.safe_query("SELECT Type, SubType, SwitchType, AddjValue, AddjMulti, AddjValue2, Options FROM DeviceStatus WHERE (ID == %" PRIu64 ")", idx);
+			result = m_sql.safe_query_readonly("SELECT Type, SubType, SwitchType, AddjValue, AddjMulti, AddjValue2, Options FROM DeviceStatus WHERE (ID == %" PRIu64 ")", idx);
 			if (result.empty())
 				return;
 
@@ -13867,7 +14261,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Temperature, Chill, Humidity, Barometer, Date, SetPoint FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC",
+					result = m_sql.safe_query_readonly("SELECT Temperature, Chill, Humidity, Barometer, Date, SetPoint FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC",
 						dbasetable.c_str(), idx);
 					if (!result.empty())
 					{
@@ -13942,7 +14336,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Percentage, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+					result = m_sql.safe_query_readonly("SELECT Percentage, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
 					if (!result.empty())
 					{
 						int ii = 0;
@@ -13959,7 +14353,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Speed, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+					result = m_sql.safe_query_readonly("SELECT Speed, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
 					if (!result.empty())
 					{
 						int ii = 0;
@@ -13978,7 +14372,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value1, Value2, Value3, Value4, Value5, Value6, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC",
+						result = m_sql.safe_query_readonly("SELECT Value1, Value2, Value3, Value4, Value5, Value6, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC",
 							dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
@@ -14107,7 +14501,7 @@ namespace http
 											int day = ltime.tm_mday;
 											sprintf(szTmp, "%04d-%02d-%02d", year, mon, day);
 											std::vector<std::vector<std::string>> result2;
-											result2 = m_sql.safe_query(
+											result2 = m_sql.safe_query_readonly(
 												"SELECT Counter1, Counter2, Counter3, Counter4 FROM Multimeter_Calendar WHERE (DeviceRowID==%" PRIu64
 												") AND (Date=='%q')",
 												idx, szTmp);
@@ -14151,7 +14545,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_readonly("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
 							int ii = 0;
@@ -14168,7 +14562,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_readonly("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
 							int ii = 0;
@@ -14192,7 +14586,7 @@ namespace http
 						{
 							vdiv = 1000.0F;
 						}
-						result = m_sql.safe_query("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_readonly("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
 							int ii = 0;
@@ -14223,7 +14617,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_readonly("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
 							int ii = 0;
@@ -14240,7 +14634,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_readonly("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
 							int ii = 0;
@@ -14257,7 +14651,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_readonly("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
 							int ii = 0;
@@ -14275,7 +14669,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_readonly("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
 							int ii = 0;
@@ -14300,7 +14694,7 @@ namespace http
 
 						root["displaytype"] = displaytype;
 
-						result = m_sql.safe_query("SELECT Value1, Value2, Value3, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_readonly("SELECT Value1, Value2, Value3, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
 							int ii = 0;
@@ -14370,7 +14764,7 @@ namespace http
 
 						root["displaytype"] = displaytype;
 
-						result = m_sql.safe_query("SELECT Value1, Value2, Value3, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_readonly("SELECT Value1, Value2, Value3, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
 							int ii = 0;
@@ -14437,7 +14831,7 @@ namespace http
 
 						// First check if we had any usage in the short log, if not, its probably a meter without usage
 						bool bHaveUsage = true;
-						result = m_sql.safe_query("SELECT MIN([Usage]), MAX([Usage]) FROM %s WHERE (DeviceRowID==%" PRIu64 ")", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_readonly("SELECT MIN([Usage]), MAX([Usage]) FROM %s WHERE (DeviceRowID==%" PRIu64 ")", dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
 							int64_t minValue = std::stoll(result[0][0]);
@@ -14450,7 +14844,7 @@ namespace http
 						}
 
 						int ii = 0;
-						result = m_sql.safe_query("SELECT Value,[Usage], Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_readonly("SELECT Value,[Usage], Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
 
 						int method = 0;
 						std::string sMethod = request::findValue(&req, "method");
@@ -14618,13 +15012,13 @@ namespace http
 
 						if (bIsManagedCounter)
 						{
-							result = m_sql.safe_query("SELECT Usage, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+							result = m_sql.safe_query_readonly("SELECT Usage, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
 							bHaveFirstValue = true;
 							bHaveFirstRealValue = true;
 						}
 						else
 						{
-							result = m_sql.safe_query("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+							result = m_sql.safe_query_readonly("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
 						}
 
 						int method = 0;
@@ -14752,7 +15146,7 @@ namespace http
 											int day = ltime.tm_mday;
 											sprintf(szTmp, "%04d-%02d-%02d", year, mon, day);
 											std::vector<std::vector<std::string>> result2;
-											result2 = m_sql.safe_query(
+											result2 = m_sql.safe_query_readonly(
 												"SELECT Counter FROM %s_Calendar WHERE (DeviceRowID==%" PRIu64
 												") AND (Date=='%q')",
 												dbasetable.c_str(), idx, szTmp);
@@ -14888,7 +15282,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Level, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+					result = m_sql.safe_query_readonly("SELECT Level, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
 					if (!result.empty())
 					{
 						int ii = 0;
@@ -14912,7 +15306,7 @@ namespace http
 					float LastValue = -1;
 					std::string LastDate;
 
-					result = m_sql.safe_query("SELECT Total, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+					result = m_sql.safe_query_readonly("SELECT Total, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
 					if (!result.empty())
 					{
 						int ii = 0;
@@ -14940,7 +15334,7 @@ namespace http
 							LastDate = sd[1];
 						}
 						//Add last value
-						result = m_sql.safe_query("SELECT sValue, LastUpdate FROM DeviceStatus WHERE (ID==%" PRIu64 ")", idx);
+						result = m_sql.safe_query_readonly("SELECT sValue, LastUpdate FROM DeviceStatus WHERE (ID==%" PRIu64 ")", idx);
 						if (!result.empty())
 						{
 							std::string sValue = result[0][0];
@@ -14969,7 +15363,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Direction, Speed, Gust, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+					result = m_sql.safe_query_readonly("SELECT Direction, Speed, Gust, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
 					if (!result.empty())
 					{
 						int ii = 0;
@@ -15006,7 +15400,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Direction, Speed, Gust FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+					result = m_sql.safe_query_readonly("SELECT Direction, Speed, Gust FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
 					if (!result.empty())
 					{
 						std::map<int, int> _directions;
@@ -15262,7 +15656,7 @@ namespace http
 					getNoon(weekbefore, tm2, tm1.tm_year + 1900, tm1.tm_mon + 1, tm1.tm_mday - 7); // We only want the date
 					sprintf(szDateStart, "%04d-%02d-%02d", tm2.tm_year + 1900, tm2.tm_mon + 1, tm2.tm_mday);
 
-					result = m_sql.safe_query("SELECT Total, Rate, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+					result = m_sql.safe_query_readonly("SELECT Total, Rate, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 						dbasetable.c_str(), idx, szDateStart, szDateEnd);
 					int ii = 0;
 					if (!result.empty())
@@ -15280,12 +15674,12 @@ namespace http
 					// add today (have to calculate it)
 					if (dSubType == sTypeRAINWU || dSubType == sTypeRAINByRate)
 					{
-						result = m_sql.safe_query("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q') ORDER BY ROWID DESC LIMIT 1", idx,
+						result = m_sql.safe_query_readonly("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q') ORDER BY ROWID DESC LIMIT 1", idx,
 							szDateEnd);
 					}
 					else
 					{
-						result = m_sql.safe_query("SELECT MIN(Total), MAX(Total), MAX(Rate) FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
+						result = m_sql.safe_query_readonly("SELECT MIN(Total), MAX(Total), MAX(Rate) FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
 					}
 					if (!result.empty())
 					{
@@ -15332,7 +15726,7 @@ namespace http
 					int ii = 0;
 					if (dType == pTypeP1Power)
 					{
-						result = m_sql.safe_query("SELECT Value1,Value2,Value5,Value6,Date FROM %s WHERE (DeviceRowID==%" PRIu64
+						result = m_sql.safe_query_readonly("SELECT Value1,Value2,Value5,Value6,Date FROM %s WHERE (DeviceRowID==%" PRIu64
 							" AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 							dbasetable.c_str(), idx, szDateStart, szDateEnd);
 						if (!result.empty())
@@ -15374,7 +15768,7 @@ namespace http
 					}
 					else
 					{
-						result = m_sql.safe_query("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+						result = m_sql.safe_query_readonly("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 							dbasetable.c_str(), idx, szDateStart, szDateEnd);
 						if (!result.empty())
 						{
@@ -15413,7 +15807,7 @@ namespace http
 					// add today (have to calculate it)
 					if (dType == pTypeP1Power)
 					{
-						result = m_sql.safe_query("SELECT MIN(Value1), MAX(Value1), MIN(Value2), MAX(Value2),MIN(Value5), MAX(Value5), MIN(Value6), MAX(Value6) FROM "
+						result = m_sql.safe_query_readonly("SELECT MIN(Value1), MAX(Value1), MIN(Value2), MAX(Value2),MIN(Value5), MAX(Value5), MIN(Value6), MAX(Value6) FROM "
 							"MultiMeter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')",
 							idx, szDateEnd);
 						if (!result.empty())
@@ -15473,7 +15867,7 @@ namespace http
 					else if (!bIsManagedCounter)
 					{
 						// get the first value of the day
-						result = m_sql.safe_query("SELECT Value FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date ASC LIMIT 1", idx, szDateEnd);
+						result = m_sql.safe_query_readonly("SELECT Value FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date ASC LIMIT 1", idx, szDateEnd);
 						if (!result.empty())
 						{
 							std::vector<std::string> sd = result[0];
@@ -15483,7 +15877,7 @@ namespace http
 							int64_t total_real;
 
 							// get the last value of the day
-							result = m_sql.safe_query("SELECT Value FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date DESC LIMIT 1", idx, szDateEnd);
+							result = m_sql.safe_query_readonly("SELECT Value FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date DESC LIMIT 1", idx, szDateEnd);
 							if (!result.empty())
 							{
 								std::vector<std::string> sd = result[0];
@@ -15588,7 +15982,7 @@ namespace http
 					root["title"] = "Graph " + sensor + " " + srange;
 
 					// Actual Year
-					result = m_sql.safe_query("SELECT Temp_Min, Temp_Max, Chill_Min, Chill_Max,"
+					result = m_sql.safe_query_readonly("SELECT Temp_Min, Temp_Max, Chill_Min, Chill_Max,"
 						" Humidity, Barometer, Temp_Avg, Date, SetPoint_Min,"
 						" SetPoint_Max, SetPoint_Avg "
 						"FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q'"
@@ -15669,7 +16063,7 @@ namespace http
 						}
 					}
 					// add today (have to calculate it)
-					result = m_sql.safe_query("SELECT MIN(Temperature), MAX(Temperature),"
+					result = m_sql.safe_query_readonly("SELECT MIN(Temperature), MAX(Temperature),"
 						" MIN(Chill), MAX(Chill), AVG(Humidity),"
 						" AVG(Barometer), AVG(Temperature), MIN(SetPoint),"
 						" MAX(SetPoint), AVG(SetPoint) "
@@ -15740,7 +16134,7 @@ namespace http
 						ii++;
 					}
 					// Previous Year
-					result = m_sql.safe_query("SELECT Temp_Min, Temp_Max, Chill_Min, Chill_Max,"
+					result = m_sql.safe_query_readonly("SELECT Temp_Min, Temp_Max, Chill_Min, Chill_Max,"
 						" Humidity, Barometer, Temp_Avg, Date, SetPoint_Min,"
 						" SetPoint_Max, SetPoint_Avg "
 						"FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q'"
@@ -15826,7 +16220,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Percentage_Min, Percentage_Max, Percentage_Avg, Date FROM %s WHERE (DeviceRowID==%" PRIu64
+					result = m_sql.safe_query_readonly("SELECT Percentage_Min, Percentage_Max, Percentage_Avg, Date FROM %s WHERE (DeviceRowID==%" PRIu64
 						" AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 						dbasetable.c_str(), idx, szDateStart, szDateEnd);
 					int ii = 0;
@@ -15842,7 +16236,7 @@ namespace http
 						}
 					}
 					// add today (have to calculate it)
-					result = m_sql.safe_query("SELECT MIN(Percentage), MAX(Percentage), AVG(Percentage) FROM Percentage WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx,
+					result = m_sql.safe_query_readonly("SELECT MIN(Percentage), MAX(Percentage), AVG(Percentage) FROM Percentage WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx,
 						szDateEnd);
 					if (!result.empty())
 					{
@@ -15859,7 +16253,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Speed_Min, Speed_Max, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+					result = m_sql.safe_query_readonly("SELECT Speed_Min, Speed_Max, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 						dbasetable.c_str(), idx, szDateStart, szDateEnd);
 					int ii = 0;
 					if (!result.empty())
@@ -15873,7 +16267,7 @@ namespace http
 						}
 					}
 					// add today (have to calculate it)
-					result = m_sql.safe_query("SELECT MIN(Speed), MAX(Speed) FROM Fan WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
+					result = m_sql.safe_query_readonly("SELECT MIN(Speed), MAX(Speed) FROM Fan WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
 					if (!result.empty())
 					{
 						std::vector<std::string> sd = result[0];
@@ -15888,7 +16282,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Level, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC", dbasetable.c_str(),
+					result = m_sql.safe_query_readonly("SELECT Level, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC", dbasetable.c_str(),
 						idx, szDateStart, szDateEnd);
 					int ii = 0;
 					if (!result.empty())
@@ -15901,7 +16295,7 @@ namespace http
 						}
 					}
 					// add today (have to calculate it)
-					result = m_sql.safe_query("SELECT MAX(Level) FROM UV WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
+					result = m_sql.safe_query_readonly("SELECT MAX(Level) FROM UV WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
 					if (!result.empty())
 					{
 						std::vector<std::string> sd = result[0];
@@ -15911,7 +16305,7 @@ namespace http
 						ii++;
 					}
 					// Previous Year
-					result = m_sql.safe_query("SELECT Level, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC", dbasetable.c_str(),
+					result = m_sql.safe_query_readonly("SELECT Level, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC", dbasetable.c_str(),
 						idx, szDateStartPrev, szDateEndPrev);
 					if (!result.empty())
 					{
@@ -15929,7 +16323,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Total, Rate, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+					result = m_sql.safe_query_readonly("SELECT Total, Rate, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 						dbasetable.c_str(), idx, szDateStart, szDateEnd);
 					int ii = 0;
 					if (!result.empty())
@@ -15947,12 +16341,12 @@ namespace http
 					// add today (have to calculate it)
 					if (dSubType == sTypeRAINWU || dSubType == sTypeRAINByRate)
 					{
-						result = m_sql.safe_query("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q') ORDER BY ROWID DESC LIMIT 1", idx,
+						result = m_sql.safe_query_readonly("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q') ORDER BY ROWID DESC LIMIT 1", idx,
 							szDateEnd);
 					}
 					else
 					{
-						result = m_sql.safe_query("SELECT MIN(Total), MAX(Total), MAX(Rate) FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
+						result = m_sql.safe_query_readonly("SELECT MIN(Total), MAX(Total), MAX(Rate) FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
 					}
 					if (!result.empty())
 					{
@@ -15978,7 +16372,7 @@ namespace http
 						ii++;
 					}
 					// Previous Year
-					result = m_sql.safe_query("SELECT Total, Rate, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+					result = m_sql.safe_query_readonly("SELECT Total, Rate, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 						dbasetable.c_str(), idx, szDateStartPrev, szDateEndPrev);
 					if (!result.empty())
 					{
@@ -16005,7 +16399,7 @@ namespace http
 					// int nValue = 0;
 					std::string sValue; //Counter
 
-					result = m_sql.safe_query("SELECT sValue FROM DeviceStatus WHERE (ID==%" PRIu64 ")", idx);
+					result = m_sql.safe_query_readonly("SELECT sValue FROM DeviceStatus WHERE (ID==%" PRIu64 ")", idx);
 					if (!result.empty())
 					{
 						sValue = result[0][0];
@@ -16061,7 +16455,7 @@ namespace http
 						else
 						{
 							// Actual Year
-							result = m_sql.safe_query("SELECT Value1,Value2,Value5,Value6, Date,"
+							result = m_sql.safe_query_readonly("SELECT Value1,Value2,Value5,Value6, Date,"
 								" Counter1, Counter2, Counter3, Counter4 "
 								"FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q'"
 								" AND Date<='%q') ORDER BY Date ASC",
@@ -16147,7 +16541,7 @@ namespace http
 								}
 							}
 							// Previous Year
-							result = m_sql.safe_query("SELECT Value1,Value2,Value5,Value6, Date "
+							result = m_sql.safe_query_readonly("SELECT Value1,Value2,Value5,Value6, Date "
 								"FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 								dbasetable.c_str(), idx, szDateStartPrev, szDateEndPrev);
 							if (!result.empty())
@@ -16189,7 +16583,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value1,Value2,Value3,Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+						result = m_sql.safe_query_readonly("SELECT Value1,Value2,Value3,Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 							dbasetable.c_str(), idx, szDateStart, szDateEnd);
 						if (!result.empty())
 						{
@@ -16202,7 +16596,7 @@ namespace http
 								ii++;
 							}
 						}
-						result = m_sql.safe_query("SELECT Value2,Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+						result = m_sql.safe_query_readonly("SELECT Value2,Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 							dbasetable.c_str(), idx, szDateStartPrev, szDateEndPrev);
 						if (!result.empty())
 						{
@@ -16221,7 +16615,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value1,Value2, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+						result = m_sql.safe_query_readonly("SELECT Value1,Value2, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 							dbasetable.c_str(), idx, szDateStart, szDateEnd);
 						if (!result.empty())
 						{
@@ -16248,7 +16642,7 @@ namespace http
 							vdiv = 1000.0F;
 						}
 
-						result = m_sql.safe_query("SELECT Value1,Value2,Value3,Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+						result = m_sql.safe_query_readonly("SELECT Value1,Value2,Value3,Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 							dbasetable.c_str(), idx, szDateStart, szDateEnd);
 						if (!result.empty())
 						{
@@ -16307,7 +16701,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value1,Value2,Value3, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+						result = m_sql.safe_query_readonly("SELECT Value1,Value2,Value3, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 							dbasetable.c_str(), idx, szDateStart, szDateEnd);
 						if (!result.empty())
 						{
@@ -16326,7 +16720,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value1,Value2, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+						result = m_sql.safe_query_readonly("SELECT Value1,Value2, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 							dbasetable.c_str(), idx, szDateStart, szDateEnd);
 						if (!result.empty())
 						{
@@ -16346,7 +16740,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value1,Value2, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+						result = m_sql.safe_query_readonly("SELECT Value1,Value2, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 							dbasetable.c_str(), idx, szDateStart, szDateEnd);
 						if (!result.empty())
 						{
@@ -16361,7 +16755,7 @@ namespace http
 					}
 					else if (dType == pTypeCURRENT)
 					{
-						result = m_sql.safe_query("SELECT Value1,Value2,Value3,Value4,Value5,Value6, Date FROM %s WHERE (DeviceRowID==%" PRIu64
+						result = m_sql.safe_query_readonly("SELECT Value1,Value2,Value3,Value4,Value5,Value6, Date FROM %s WHERE (DeviceRowID==%" PRIu64
 							" AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 							dbasetable.c_str(), idx, szDateStart, szDateEnd);
 						if (!result.empty())
@@ -16445,7 +16839,7 @@ namespace http
 					}
 					else if (dType == pTypeCURRENTENERGY)
 					{
-						result = m_sql.safe_query("SELECT Value1,Value2,Value3,Value4,Value5,Value6, Date FROM %s WHERE (DeviceRowID==%" PRIu64
+						result = m_sql.safe_query_readonly("SELECT Value1,Value2,Value3,Value4,Value5,Value6, Date FROM %s WHERE (DeviceRowID==%" PRIu64
 							" AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 							dbasetable.c_str(), idx, szDateStart, szDateEnd);
 						if (!result.empty())
@@ -16673,7 +17067,7 @@ namespace http
 						{
 							// Actual Year
 							result =
-								m_sql.safe_query("SELECT Value, Date, Counter FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+								m_sql.safe_query_readonly("SELECT Value, Date, Counter FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 									dbasetable.c_str(), idx, szDateStart, szDateEnd);
 							if (!result.empty())
 							{
@@ -16730,7 +17124,7 @@ namespace http
 							}
 							// Past Year
 							result =
-								m_sql.safe_query("SELECT Value, Date, Counter FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+								m_sql.safe_query_readonly("SELECT Value, Date, Counter FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 									dbasetable.c_str(), idx, szDateStartPrev, szDateEndPrev);
 							if (!result.empty())
 							{
@@ -16792,7 +17186,7 @@ namespace http
 
 					if (dType == pTypeP1Power)
 					{
-						result = m_sql.safe_query("SELECT "
+						result = m_sql.safe_query_readonly("SELECT "
 							" MIN(Value1) as levering_laag_min,"
 							" MAX(Value1) as levering_laag_max,"
 							" MIN(Value2) as teruglevering_laag_min,"
@@ -16879,7 +17273,7 @@ namespace http
 					}
 					else if (dType == pTypeAirQuality)
 					{
-						result = m_sql.safe_query("SELECT MIN(Value), MAX(Value), AVG(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
+						result = m_sql.safe_query_readonly("SELECT MIN(Value), MAX(Value), AVG(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
 						if (!result.empty())
 						{
 							root["result"][ii]["d"] = szDateEnd;
@@ -16892,7 +17286,7 @@ namespace http
 					else if (((dType == pTypeGeneral) && ((dSubType == sTypeSoilMoisture) || (dSubType == sTypeLeafWetness))) ||
 						((dType == pTypeRFXSensor) && ((dSubType == sTypeRFXSensorAD) || (dSubType == sTypeRFXSensorVolt))))
 					{
-						result = m_sql.safe_query("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
+						result = m_sql.safe_query_readonly("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
 						if (!result.empty())
 						{
 							root["result"][ii]["d"] = szDateEnd;
@@ -16912,7 +17306,7 @@ namespace http
 							vdiv = 1000.0F;
 						}
 
-						result = m_sql.safe_query("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
+						result = m_sql.safe_query_readonly("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
 						if (!result.empty())
 						{
 							root["result"][ii]["d"] = szDateEnd;
@@ -16953,7 +17347,7 @@ namespace http
 					}
 					else if (dType == pTypeLux)
 					{
-						result = m_sql.safe_query("SELECT MIN(Value), MAX(Value), AVG(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
+						result = m_sql.safe_query_readonly("SELECT MIN(Value), MAX(Value), AVG(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
 						if (!result.empty())
 						{
 							root["result"][ii]["d"] = szDateEnd;
@@ -16965,7 +17359,7 @@ namespace http
 					}
 					else if (dType == pTypeWEIGHT)
 					{
-						result = m_sql.safe_query("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
+						result = m_sql.safe_query_readonly("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
 						if (!result.empty())
 						{
 							root["result"][ii]["d"] = szDateEnd;
@@ -16978,7 +17372,7 @@ namespace http
 					}
 					else if (dType == pTypeUsage)
 					{
-						result = m_sql.safe_query("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
+						result = m_sql.safe_query_readonly("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
 						if (!result.empty())
 						{
 							root["result"][ii]["d"] = szDateEnd;
@@ -17005,7 +17399,7 @@ namespace http
 								int64_t total_real;
 
 								// Get the last value
-								result = m_sql.safe_query("SELECT Value FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date DESC LIMIT 1", idx,
+								result = m_sql.safe_query_readonly("SELECT Value FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date DESC LIMIT 1", idx,
 									szDateEnd);
 								if (!result.empty())
 								{
@@ -17095,7 +17489,7 @@ namespace http
 
 					int ii = 0;
 
-					result = m_sql.safe_query("SELECT Direction, Speed_Min, Speed_Max, Gust_Min,"
+					result = m_sql.safe_query_readonly("SELECT Direction, Speed_Min, Speed_Max, Gust_Min,"
 						" Gust_Max, Date "
 						"FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q'"
 						" AND Date<='%q') ORDER BY Date ASC",
@@ -17129,7 +17523,7 @@ namespace http
 						}
 					}
 					// add today (have to calculate it)
-					result = m_sql.safe_query("SELECT AVG(Direction), MIN(Speed), MAX(Speed),"
+					result = m_sql.safe_query_readonly("SELECT AVG(Direction), MIN(Speed), MAX(Speed),"
 						" MIN(Gust), MAX(Gust) "
 						"FROM Wind WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date ASC",
 						idx, szDateEnd);
@@ -17161,7 +17555,7 @@ namespace http
 						ii++;
 					}
 					// Previous Year
-					result = m_sql.safe_query("SELECT Direction, Speed_Min, Speed_Max, Gust_Min,"
+					result = m_sql.safe_query_readonly("SELECT Direction, Speed_Min, Speed_Max, Gust_Min,"
 						" Gust_Max, Date "
 						"FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q'"
 						" AND Date<='%q') ORDER BY Date ASC",
@@ -17253,7 +17647,7 @@ namespace http
 					if (sgraphtype == "1")
 					{
 						// Need to get all values of the end date so 23:59:59 is appended to the date string
-						result = m_sql.safe_query("SELECT Temperature, Chill, Humidity, Barometer,"
+						result = m_sql.safe_query_readonly("SELECT Temperature, Chill, Humidity, Barometer,"
 							" Date, DewPoint, SetPoint "
 							"FROM Temperature WHERE (DeviceRowID==%" PRIu64 ""
 							" AND Date>='%q' AND Date<='%q 23:59:59') ORDER BY Date ASC",
@@ -17321,7 +17715,7 @@ namespace http
 					}
 					else
 					{
-						result = m_sql.safe_query("SELECT Temp_Min, Temp_Max, Chill_Min, Chill_Max,"
+						result = m_sql.safe_query_readonly("SELECT Temp_Min, Temp_Max, Chill_Min, Chill_Max,"
 							" Humidity, Barometer, Date, DewPoint, Temp_Avg,"
 							" SetPoint_Min, SetPoint_Max, SetPoint_Avg "
 							"FROM Temperature_Calendar "
@@ -17401,7 +17795,7 @@ namespace http
 						}
 
 						// add today (have to calculate it)
-						result = m_sql.safe_query("SELECT MIN(Temperature), MAX(Temperature),"
+						result = m_sql.safe_query_readonly("SELECT MIN(Temperature), MAX(Temperature),"
 							" MIN(Chill), MAX(Chill), AVG(Humidity),"
 							" AVG(Barometer), MIN(DewPoint), AVG(Temperature),"
 							" MIN(SetPoint), MAX(SetPoint), AVG(SetPoint) "
@@ -17480,7 +17874,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Level, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ""
+					result = m_sql.safe_query_readonly("SELECT Level, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ""
 						" AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 						dbasetable.c_str(), idx, szDateStart.c_str(), szDateEnd.c_str());
 					int ii = 0;
@@ -17494,7 +17888,7 @@ namespace http
 						}
 					}
 					// add today (have to calculate it)
-					result = m_sql.safe_query("SELECT MAX(Level) FROM UV WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd.c_str());
+					result = m_sql.safe_query_readonly("SELECT MAX(Level) FROM UV WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd.c_str());
 					if (!result.empty())
 					{
 						std::vector<std::string> sd = result[0];
@@ -17509,7 +17903,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Total, Rate, Date FROM %s "
+					result = m_sql.safe_query_readonly("SELECT Total, Rate, Date FROM %s "
 						"WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 						dbasetable.c_str(), idx, szDateStart.c_str(), szDateEnd.c_str());
 					int ii = 0;
@@ -17525,12 +17919,12 @@ namespace http
 					// add today (have to calculate it)
 					if (dSubType == sTypeRAINWU || dSubType == sTypeRAINByRate)
 					{
-						result = m_sql.safe_query("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY ROWID DESC LIMIT 1", idx,
+						result = m_sql.safe_query_readonly("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY ROWID DESC LIMIT 1", idx,
 							szDateEnd.c_str());
 					}
 					else
 					{
-						result = m_sql.safe_query("SELECT MIN(Total), MAX(Total), MAX(Rate) FROM Rain WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd.c_str());
+						result = m_sql.safe_query_readonly("SELECT MIN(Total), MAX(Total), MAX(Rate) FROM Rain WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd.c_str());
 					}
 					if (!result.empty())
 					{
@@ -17566,7 +17960,7 @@ namespace http
 					int ii = 0;
 					if (dType == pTypeP1Power)
 					{
-						result = m_sql.safe_query("SELECT Value1,Value2,Value5,Value6, Date "
+						result = m_sql.safe_query_readonly("SELECT Value1,Value2,Value5,Value6, Date "
 							"FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q'"
 							" AND Date<='%q') ORDER BY Date ASC",
 							dbasetable.c_str(), idx, szDateStart.c_str(), szDateEnd.c_str());
@@ -17601,7 +17995,7 @@ namespace http
 					}
 					else
 					{
-						result = m_sql.safe_query("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+						result = m_sql.safe_query_readonly("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 							dbasetable.c_str(), idx, szDateStart.c_str(), szDateEnd.c_str());
 						if (!result.empty())
 						{
@@ -17638,7 +18032,7 @@ namespace http
 					// add today (have to calculate it)
 					if (dType == pTypeP1Power)
 					{
-						result = m_sql.safe_query("SELECT MIN(Value1), MAX(Value1), MIN(Value2),"
+						result = m_sql.safe_query_readonly("SELECT MIN(Value1), MAX(Value1), MIN(Value2),"
 							" MAX(Value2),MIN(Value5), MAX(Value5),"
 							" MIN(Value6), MAX(Value6) "
 							"FROM MultiMeter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')",
@@ -17698,7 +18092,7 @@ namespace http
 							int64_t total_real;
 
 							// get the last value of the day
-							result = m_sql.safe_query("SELECT Value FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date DESC LIMIT 1", idx,
+							result = m_sql.safe_query_readonly("SELECT Value FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date DESC LIMIT 1", idx,
 								szDateEnd.c_str());
 							if (!result.empty())
 							{
@@ -17743,7 +18137,7 @@ namespace http
 
 					int ii = 0;
 
-					result = m_sql.safe_query("SELECT Direction, Speed_Min, Speed_Max, Gust_Min,"
+					result = m_sql.safe_query_readonly("SELECT Direction, Speed_Min, Speed_Max, Gust_Min,"
 						" Gust_Max, Date "
 						"FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q'"
 						" AND Date<='%q') ORDER BY Date ASC",
@@ -17777,7 +18171,7 @@ namespace http
 						}
 					}
 					// add today (have to calculate it)
-					result = m_sql.safe_query("SELECT AVG(Direction), MIN(Speed), MAX(Speed), MIN(Gust), MAX(Gust) FROM Wind WHERE (DeviceRowID==%" PRIu64
+					result = m_sql.safe_query_readonly("SELECT AVG(Direction), MIN(Speed), MAX(Speed), MIN(Gust), MAX(Gust) FROM Wind WHERE (DeviceRowID==%" PRIu64
 						" AND Date>='%q') ORDER BY Date ASC",
 						idx, szDateEnd.c_str());
 					if (!result.empty())
@@ -17994,7 +18388,7 @@ namespace http
 			else
 			{
 				std::vector<std::vector<std::string>> result;
-				result = m_sql.safe_query("SELECT SessionID, Username, AuthToken, ExpirationDate FROM UserSessions WHERE SessionID = '%q'", sessionId.c_str());
+				result = m_sql.safe_query_readonly("SELECT SessionID, Username, AuthToken, ExpirationDate FROM UserSessions WHERE SessionID = '%q'", sessionId.c_str());
 				if (!result.empty())
 				{
 					session.id = result[0][0];
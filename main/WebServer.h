@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <set>
 #include <string>
 #include "../webserver/cWebem.h"
 #include "../webserver/request.hpp"
@@ -93,7 +95,8 @@ class CWebServer : public session_store, public std::enable_shared_from_this<CWe
 	//JSon
 	void GetJSonDevices(Json::Value &root, const std::string &rused, const std::string &rfilter, const std::string &order, const std::string &rowid, const std::string &planID,
 			    const std::string &floorID, bool bDisplayHidden, bool bDisplayDisabled, bool bFetchFavorites, time_t LastUpdate, const std::string &username,
-			    const std::string &hardwareid = ""); // OTO
+			    const std::string &hardwareid = "", // OTO
+			    const std::set<uint64_t> *pDeviceFilter = nullptr); // only these DeviceStatus rows, no scenes
 
 	// SessionStore interface
 	WebEmStoredSession GetSession(const std::string &sessionId) override;
@@ -167,6 +170,7 @@ private:
 	void Cmd_SaveInfluxLinkConfig(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_GetInfluxLinkConfig(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_GetInfluxLinks(WebEmSession & session, const request& req, Json::Value &root);
+	void Cmd_GetInfluxLinkStats(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_SaveInfluxLink(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_DeleteInfluxLink(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_GetDevicesForInfluxLink(WebEmSession & session, const request& req, Json::Value &root);
@@ -194,6 +198,10 @@ private:
 	void Cmd_GetVersion(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_GetAuth(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_GetUptime(WebEmSession & session, const request& req, Json::Value &root);
+	void Cmd_GetSQLStats(WebEmSession & session, const request& req, Json::Value &root);
+	void Cmd_GetIoPoolStats(WebEmSession & session, const request& req, Json::Value &root);
+	void Cmd_GetLuaScriptStats(WebEmSession & session, const request& req, Json::Value &root);
+	void Cmd_GetRxQueueStats(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_GetActualHistory(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_GetNewHistory(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_GetConfig(WebEmSession& session, const request& req, Json::Value& root);
@@ -292,6 +300,7 @@ private:
 	void Cmd_BleBoxUpdateFirmware(WebEmSession & session, const request& req, Json::Value &root);
 
 	void Cmd_GetTimerPlans(WebEmSession & session, const request& req, Json::Value &root);
+	void Cmd_GetUpcomingTimers(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_AddTimerPlan(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_UpdateTimerPlan(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_DeleteTimerPlan(WebEmSession & session, const request& req, Json::Value &root);
@@ -317,7 +326,6 @@ private:
 	void RType_Settings(WebEmSession & session, const request& req, Json::Value &root);
 	void RType_Events(WebEmSession & session, const request& req, Json::Value &root);
 	void RType_Hardware(WebEmSession & session, const request& req, Json::Value &root);
-	void RType_Devices(WebEmSession & session, const request& req, Json::Value &root);
 	void RType_Cameras(WebEmSession& session, const request& req, Json::Value& root);
 	void RType_CamerasUser(WebEmSession& session, const request& req, Json::Value& root);
 	void RType_Users(WebEmSession & session, const request& req, Json::Value &root);
@@ -445,6 +453,40 @@ private:
 
 	std::vector<_tUserAccessCode> m_accesscodes;
 
+	//JSon handlers run concurrently on the webserver threads (shared),
+	//reloading the users and custom icons needs exclusive access
+	boost::shared_mutex m_webStateMutex;
+	//Reloads requested from within a JSon handler, done when the handler finished
+	std::atomic<bool> m_bLoadUsersPending{ false };
+	std::atomic<bool> m_bReloadIconsPending{ false };
+	void RunPendingReloads();
+	void DoClearUserPasswords();
+
+	//Device list (type=devices) served from serialized per device fragments,
+	//kept current with the change tracking of CSQLHelper
+	struct _tDeviceListFragment
+	{
+		uint64_t idx;
+		bool bIsScene;
+		int64_t Order; //DeviceStatus.[Order], a changed device that moves forces a rebuild
+		std::string json;
+	};
+	struct _tDeviceListCache
+	{
+		uint64_t Version = 0;
+		time_t BuildTime = 0;
+		size_t ContentHash = 0;
+		std::vector<_tDeviceListFragment> fragments;
+	};
+	std::mutex m_device_list_cache_mutex;
+	std::map<std::string, std::shared_ptr<const _tDeviceListCache>> m_device_list_cache;
+	//ActTime handed out -> device list version read before that time, to answer lastupdate polls
+	std::map<time_t, uint64_t> m_device_list_versions;
+	void GetJSonDevicesPage(WebEmSession &session, const request &req, reply &rep);
+	void GetJSonDevicesHeader(Json::Value &root, time_t now);
+	std::shared_ptr<const _tDeviceListCache> BuildDeviceListCache(const Json::Value &devices, uint64_t Version, time_t BuildTime);
+	void GetDeviceListOrders(const std::set<uint64_t> *pDeviceFilter, std::map<uint64_t, int64_t> &orders);
+	void ClearDeviceListCache();
 };
 
 	} // namespace server
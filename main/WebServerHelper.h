@@ -26,7 +26,7 @@ namespace http {
 			// called from OTGWBase()
 			void GetJSonDevices(Json::Value &root, const std::string &rused, const std::string &rfilter, const std::string &order, const std::string &rowid, const std::string &planID,
 					    const std::string &floorID, bool bDisplayHidden, bool bDisplayDisabled, bool bFetchFavorites, time_t LastUpdate, const std::string &username,
-					    const std::string &hardwareid = "");
+					    const std::string &hardwareid = "", const std::set<uint64_t> *pDeviceFilter = nullptr);
 			// called from CSQLHelper
 			void ReloadCustomSwitchIcons();
 			std::string our_listener_port;
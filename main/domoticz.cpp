@@ -28,6 +28,8 @@
 #include "Helper.h"
 #include "WebServerHelper.h"
 #include "SQLHelper.h"
+#include "IoContextPool.h"
+#include "TrafficCapture.h"
 #include "../notifications/NotificationHelper.h"
 #include "appversion.h"
 #include "localtime_r.h"
@@ -76,6 +78,7 @@ namespace
 #endif
 		"\t-webroot additional web root, useful with proxy servers (for example domoticz)\n"
 		"\t-nocache ask browser not to cache pages\n"
+		"\t-webthreads count (number of threads handling web requests per web server, default=4)\n"
 		"\t-startupdelay seconds (default=0)\n"
 		"\t-nowwwpwd (in case you forgot the web server username/password)\n"
 		"\t-wwwcompress mode (on = always compress [default], off = always decompress, static = no processing but try precompressed first)\n"
@@ -84,6 +87,13 @@ namespace
 #endif
 		"\t-noupdates do not use the internal update functionality\n"
 		"\t-dbase_disable_wal_mode\n"
+		"\t-dbase_readers count (number of read-only database connections in WAL mode, default=2, 0 to disable)\n"
+		"\t-dbase_writebehind interval_ms [max_rows] (batch device value updates, default=0 (disabled), max_rows=100)\n"
+		"\t-iothreads count (number of threads for TCP/serial/plugin connections, default=2)\n"
+		"\t-rxthreads count (number of threads decoding received device messages, 1 = single lane, default=4)\n"
+		"\t-rxqueuefull block|drop (when a received message or event queue is full, wait or drop the new message, default=block)\n"
+		"\t-capture file (record the data received by serial, TCP and MQTT hardware)\n"
+		"\t-replay file [speed] (replay a capture into an in-memory database and report, speed: 1, 10, ... or max, default=1)\n"
 #if defined WIN32
 		"\t-log file_path (for example D:\\domoticz.log)\n"
 		"\t-weblog file_path (for example D:\\domoticz_access.log)\n"
@@ -94,6 +104,7 @@ namespace
 		"\t-loglevel (combination of: all,normal,status,error,debug)\n"
 		"\t-debuglevel (combination of: all,normal,hardware,received,webserver,eventsystem,python,thread_id,sql,auth)\n"
 		"\t-notimestamps (do not prepend timestamps to logs; useful with syslog, etc.)\n"
+		"\t-logflush interval_ms (flush interval of the log file, errors are flushed directly, default=250)\n"
 		"\t-php_cgi_path (for example /usr/bin/php-cgi)\n"
 #ifndef WIN32
 		"\t-daemon (run as background daemon)\n"
@@ -158,12 +169,20 @@ std::string szPyVersion="None";
 int ActYear;
 time_t m_StartTime = time(nullptr);
 std::string journalMode="WAL";
+int dbaseReaders = 2;
+int dbaseWriteBehindInterval = 0;
+int dbaseWriteBehindRows = 100;
+int ioThreads = IOPOOL_DEFAULT_THREADS;
+int rxThreads = RXQUEUE_DEFAULT_LANES;
+queue_overflow_policy rxQueuePolicy = queue_overflow_policy::block;
 
 MainWorker m_mainworker;
 CLogger _log;
 http::server::CWebServerHelper m_webservers;
 CSQLHelper m_sql;
 CNotificationHelper m_notifications;
+CIoContextPool m_iopool;
+CTrafficCapture m_trafficcapture;
 
 std::string logfile;
 std::string weblogfile;
@@ -579,6 +598,9 @@ bool ParseConfigFile(const std::string &szConfigFile)
 		else if (szFlag == "notimestamps") {
 			_log.EnableLogTimestamps(!GetConfigBool(sLine));
 		}
+		else if (szFlag == "log_flush_interval") {
+			_log.SetFlushInterval(atoi(sLine.c_str()));
+		}
 #ifndef WIN32
 		else if (szFlag == "syslog") {
 			g_bUseSyslog = true;
@@ -591,6 +613,24 @@ bool ParseConfigFile(const std::string &szConfigFile)
 		else if ( (szFlag == "dbase_disable_wal_mode") && (GetConfigBool(sLine) ) )  {
 			journalMode = "DELETE";
 		}
+		else if (szFlag == "dbase_readers") {
+			dbaseReaders = atoi(sLine.c_str());
+		}
+		else if (szFlag == "dbase_writebehind_interval") {
+			dbaseWriteBehindInterval = atoi(sLine.c_str());
+		}
+		else if (szFlag == "dbase_writebehind_rows") {
+			dbaseWriteBehindRows = atoi(sLine.c_str());
+		}
+		else if (szFlag == "iothreads") {
+			ioThreads = atoi(sLine.c_str());
+		}
+		else if (szFlag == "rxthreads") {
+			rxThreads = atoi(sLine.c_str());
+		}
+		else if (szFlag == "rxqueuefull") {
+			rxQueuePolicy = (sLine == "drop") ? queue_overflow_policy::drop_newest : queue_overflow_policy::block;
+		}
 
 		else if (szFlag == "startup_delay") {
 			int DelaySeconds = atoi(sLine.c_str());
@@ -604,6 +644,12 @@ bool ParseConfigFile(const std::string &szConfigFile)
 			webserver_settings.php_cgi_path = sLine;
 #ifdef WWW_ENABLE_SSL
 			secure_webserver_settings.php_cgi_path = sLine;
+#endif
+		}
+		else if (szFlag == "webthreads") {
+			webserver_settings.threads = atoi(sLine.c_str());
+#ifdef WWW_ENABLE_SSL
+			secure_webserver_settings.threads = webserver_settings.threads;
 #endif
 		}
 		else if (szFlag == "vhostname") {
@@ -646,6 +692,7 @@ void DisplayAppVersion()
 
 time_t m_LastHeartbeat = 0;
 
+#ifndef DOMOTICZ_BENCHMARK // domoticzbench has its own main
 #if defined WIN32
 int WINAPI WinMain(_In_ HINSTANCE hInstance,_In_opt_ HINSTANCE hPrevInstance,_In_ LPSTR lpCmdLine,_In_ int nShowCmd)
 #else
@@ -703,6 +750,15 @@ int main(int argc, char**argv)
 		{
 			_log.EnableLogTimestamps(false);
 		}
+		if (cmdLine.HasSwitch("-logflush"))
+		{
+			if (cmdLine.GetArgumentCount("-logflush") != 1)
+			{
+				_log.Log(LOG_ERROR, "Please specify the log flush interval");
+				return 1;
+			}
+			_log.SetFlushInterval(atoi(cmdLine.GetSafeArgument("-logflush", 0, "250").c_str()));
+		}
 		if (cmdLine.HasSwitch("-log"))
 		{
 			if (cmdLine.GetArgumentCount("-log") != 1)
@@ -867,6 +923,15 @@ int main(int argc, char**argv)
 			}
 			webserver_settings.php_cgi_path = cmdLine.GetSafeArgument("-php_cgi_path", 0, "");
 		}
+		if (cmdLine.HasSwitch("-webthreads"))
+		{
+			if (cmdLine.GetArgumentCount("-webthreads") != 1)
+			{
+				_log.Log(LOG_ERROR, "Please specify the number of web server threads");
+				return 1;
+			}
+			webserver_settings.threads = atoi(cmdLine.GetSafeArgument("-webthreads", 0, "4").c_str());
+		}
 		if (cmdLine.HasSwitch("-wwwroot"))
 		{
 			if (cmdLine.GetArgumentCount("-wwwroot") != 1)
@@ -911,6 +976,7 @@ int main(int argc, char**argv)
 			// php_cgi_path has to be equal
 			secure_webserver_settings.php_cgi_path = webserver_settings.php_cgi_path;
 		}
+		secure_webserver_settings.threads = webserver_settings.threads;
 		if (cmdLine.HasSwitch("-sslcert"))
 		{
 			if (cmdLine.GetArgumentCount("-sslcert") != 1)
@@ -1029,6 +1095,34 @@ int main(int argc, char**argv)
 			dbasefile = cmdLine.GetSafeArgument("-dbase", 0, "domoticz.db");
 		}
 	}
+	if (cmdLine.HasSwitch("-capture"))
+	{
+		if (cmdLine.GetArgumentCount("-capture") != 1)
+		{
+			_log.Log(LOG_ERROR, "Please specify a capture file");
+			return 1;
+		}
+		if (!m_trafficcapture.StartCapture(cmdLine.GetSafeArgument("-capture", 0, "")))
+			return 1;
+	}
+	if (cmdLine.HasSwitch("-replay"))
+	{
+		if (cmdLine.GetArgumentCount("-replay") < 1)
+		{
+			_log.Log(LOG_ERROR, "Please specify a capture file to replay");
+			return 1;
+		}
+		double replaySpeed = 1.0;
+		if (cmdLine.GetArgumentCount("-replay") > 1)
+		{
+			std::string szSpeed = cmdLine.GetSafeArgument("-replay", 1, "1");
+			replaySpeed = (szSpeed == "max") ? 0 : atof(szSpeed.c_str());
+		}
+		if (!m_trafficcapture.LoadReplay(cmdLine.GetSafeArgument("-replay", 0, ""), replaySpeed))
+			return 1;
+		// the replay runs on an empty database, the real one is never touched
+		dbasefile = ":memory:";
+	}
 	m_sql.SetDatabaseName(dbasefile);
 
 	if (!bUseConfigFile) {
@@ -1039,6 +1133,68 @@ int main(int argc, char**argv)
 	}
 	m_sql.SetJournalMode(journalMode);
 
+	if (!bUseConfigFile) {
+		if (cmdLine.HasSwitch("-dbase_readers"))
+		{
+			if (cmdLine.GetArgumentCount("-dbase_readers") != 1)
+			{
+				_log.Log(LOG_ERROR, "Please specify the number of database readers");
+				return 1;
+			}
+			dbaseReaders = atoi(cmdLine.GetSafeArgument("-dbase_readers", 0, "2").c_str());
+		}
+	}
+	m_sql.SetReadConnections(dbaseReaders);
+
+	if (!bUseConfigFile) {
+		if (cmdLine.HasSwitch("-dbase_writebehind"))
+		{
+			if (cmdLine.GetArgumentCount("-dbase_writebehind") < 1)
+			{
+				_log.Log(LOG_ERROR, "Please specify a write-behind interval (ms)");
+				return 1;
+			}
+			dbaseWriteBehindInterval = atoi(cmdLine.GetSafeArgument("-dbase_writebehind", 0, "0").c_str());
+			if (cmdLine.GetArgumentCount("-dbase_writebehind") > 1)
+				dbaseWriteBehindRows = atoi(cmdLine.GetSafeArgument("-dbase_writebehind", 1, "100").c_str());
+		}
+	}
+	m_sql.SetDeviceStatusWriteBehind(dbaseWriteBehindInterval, dbaseWriteBehindRows);
+
+	if (!bUseConfigFile) {
+		if (cmdLine.HasSwitch("-iothreads"))
+		{
+			if (cmdLine.GetArgumentCount("-iothreads") != 1)
+			{
+				_log.Log(LOG_ERROR, "Please specify the number of io threads");
+				return 1;
+			}
+			ioThreads = atoi(cmdLine.GetSafeArgument("-iothreads", 0, "2").c_str());
+		}
+		if (cmdLine.HasSwitch("-rxthreads"))
+		{
+			if (cmdLine.GetArgumentCount("-rxthreads") != 1)
+			{
+				_log.Log(LOG_ERROR, "Please specify the number of rx threads");
+				return 1;
+			}
+			rxThreads = atoi(cmdLine.GetSafeArgument("-rxthreads", 0, "4").c_str());
+		}
+		if (cmdLine.HasSwitch("-rxqueuefull"))
+		{
+			std::string szPolicy = cmdLine.GetSafeArgument("-rxqueuefull", 0, "");
+			if ((szPolicy != "block") && (szPolicy != "drop"))
+			{
+				_log.Log(LOG_ERROR, "Please specify block or drop for the rx queue");
+				return 1;
+			}
+			rxQueuePolicy = (szPolicy == "drop") ? queue_overflow_policy::drop_newest : queue_overflow_policy::block;
+		}
+	}
+	m_iopool.SetThreadCount(ioThreads);
+	m_mainworker.SetRxLaneCount(rxThreads);
+	m_mainworker.SetRxQueueOverflowPolicy(rxQueuePolicy);
+
 	if (!bUseConfigFile) {
 		if (cmdLine.HasSwitch("-webroot"))
 		{
@@ -1152,6 +1308,8 @@ int main(int argc, char**argv)
 		syslog(LOG_INFO, "Domoticz running...");
 	}
 #endif
+	// after daemonization, the writer thread would not survive the fork
+	_log.StartWriter();
 
 	if (!g_bRunAsDaemon)
 	{
@@ -1177,8 +1335,10 @@ int main(int argc, char**argv)
 #endif
 	}
 
+	m_iopool.Start();
 	if (!m_mainworker.Start())
 	{
+		m_iopool.Stop();
 		return 1;
 	}
 
@@ -1229,6 +1389,7 @@ int main(int argc, char**argv)
 	{
 
 	}
+	m_iopool.Stop();
 #ifndef WIN32
 	if (g_bRunAsDaemon)
 	{
@@ -1246,6 +1407,8 @@ int main(int argc, char**argv)
 #endif
 	g_stop_watchdog = true;
 	thread_watchdog.join();
+	_log.StopWriter();
 	return 0;
 }
 
+#endif // DOMOTICZ_BENCHMARK
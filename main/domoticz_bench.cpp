@@ -0,0 +1,894 @@
+#include "stdafx.h"
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <inttypes.h>
+#include <boost/asio/ip/tcp.hpp>
+#include "CmdLine.h"
+#include "Helper.h"
+#include "Logger.h"
+#include "SQLHelper.h"
+#include "mainworker.h"
+#include "EventSystem.h"
+#include "WebServer.h"
+#include "RFXtrx.h"
+#include "json_helper.h"
+#include "../httpclient/HTTPClient.h"
+#include "concurrent_queue.h"
+#include "IoContextPool.h"
+#include "LuaStatePool.h"
+#include "dzVents.h"
+#include "mpsc_ring_queue.h"
+#include "../hardware/Dummy.h"
+#include "../hardware/P1MeterBase.h"
+
+extern "C" {
+#include <lua.h>
+#include <lauxlib.h>
+}
+
+// Micro benchmarks for the hot paths of Domoticz, linked against the full source set.
+// Every benchmark runs against an in-memory database, nothing is written to disk.
+// Results are written as JSON so runs can be compared between builds.
+
+constexpr const char *szHelp
+{
+	"Usage: domoticzbench\n"
+	"\t-iterations <count> (iterations per benchmark, default=10000)\n"
+	"\t-devices <count> (number of devices in the database, default=100)\n"
+	"\t-filter <name> (only run the benchmarks that contain this name)\n"
+	"\t-webport <port> (loopback port of the web server benchmark, default=18089)\n"
+	"\t-output <file> (write the results to a file instead of stdout)\n"
+	"\t-list (list the available benchmarks)\n"
+	"\t-verbose (log the Domoticz status messages)\n"
+	"\t-h (or --help or /?) display this help information\n"
+};
+
+#define BENCH_DEFAULT_ITERATIONS 10000
+#define BENCH_DEFAULT_DEVICES 100
+#define BENCH_QUEUE_PRODUCERS 4
+#define BENCH_DEFAULT_WEBPORT "18089"
+#define BENCH_WEB_CLIENTS 8
+#define BENCH_ASYNC_REQUESTS 8
+
+extern std::string szAppVersion;
+extern std::string szAppHash;
+extern std::string szAppDate;
+extern std::string szStartupFolder;
+extern std::string szWWWFolder;
+void GetAppVersion();
+
+namespace
+{
+	// A DSMR 5 telegram, as sent by most Dutch/Belgian smart meters
+	constexpr const char *szP1Telegram =
+		"/ISk5\\2MT382-1000\r\n"
+		"\r\n"
+		"1-3:0.2.8(50)\r\n"
+		"0-0:1.0.0(101209113020W)\r\n"
+		"0-0:96.1.1(4B384547303034303436333935353037)\r\n"
+		"1-0:1.8.1(123456.789*kWh)\r\n"
+		"1-0:1.8.2(123456.789*kWh)\r\n"
+		"1-0:2.8.1(123456.789*kWh)\r\n"
+		"1-0:2.8.2(123456.789*kWh)\r\n"
+		"0-0:96.14.0(0002)\r\n"
+		"1-0:1.7.0(01.193*kW)\r\n"
+		"1-0:2.7.0(00.000*kW)\r\n"
+		"0-0:96.7.21(00004)\r\n"
+		"0-0:96.7.9(00002)\r\n"
+		"1-0:32.32.0(00002)\r\n"
+		"1-0:32.36.0(00000)\r\n"
+		"1-0:32.7.0(220.1*V)\r\n"
+		"1-0:31.7.0(001*A)\r\n"
+		"1-0:21.7.0(01.111*kW)\r\n"
+		"1-0:22.7.0(00.000*kW)\r\n"
+		"0-1:24.1.0(003)\r\n"
+		"0-1:96.1.0(3232323241424344313233343536373839)\r\n"
+		"0-1:24.2.1(101209112500W)(12785.123*m3)\r\n"
+		"!EF2F\r\n";
+
+	// Parses telegrams without a serial port or socket, decoded values are not forwarded
+	class CBenchP1Meter : public P1MeterBase
+	{
+	      public:
+		explicit CBenchP1Meter(const int ID)
+		{
+			m_HwdID = ID;
+		}
+		bool WriteToHardware(const char * /*pdata*/, const unsigned char /*length*/) override
+		{
+			return true;
+		}
+		void Parse(const uint8_t *pData, const int length)
+		{
+			ParseP1Data(pData, length, true, 0);
+		}
+
+	      private:
+		bool StartHardware() override
+		{
+			return true;
+		}
+		bool StopHardware() override
+		{
+			return true;
+		}
+	};
+} // namespace
+
+class CBenchmark
+{
+      public:
+	CBenchmark(const int iterations, const int devices, const std::string &filter, const std::string &webport)
+		: m_iterations(iterations)
+		, m_devices(devices)
+		, m_filter(filter)
+		, m_webport(webport)
+	{
+	}
+
+	static std::vector<std::string> GetNames()
+	{
+		return { "sql_updatevalue", "rx_process", "p1_parse", "json_devices", "web_getdevices", "web_mix", "eventqueue", "concurrent_queue", "rfxnames", "lua_statepool", "dzvents_export", "http_async" };
+	}
+
+	bool Run()
+	{
+		m_sql.SetDatabaseName(":memory:");
+		if (!m_sql.OpenDatabase())
+		{
+			std::cerr << "Could not open the in-memory database!" << std::endl;
+			return false;
+		}
+		m_sql.safe_query("INSERT INTO Hardware (Name, Enabled, Type, Address, Port, Username, Password, Mode1, Mode2, Mode3, Mode4, Mode5, Mode6) VALUES ('Benchmark',1, %d,'',1,'','',0,0,0,0,0,0)",
+				 HTYPE_Dummy);
+		auto result = m_sql.safe_query("SELECT MAX(ID) FROM Hardware");
+		if (result.empty())
+			return false;
+		m_HwdID = std::stoi(result[0][0]);
+
+		if (Selected("sql_updatevalue"))
+			Bench_SQLUpdateValue();
+		if (Selected("rx_process"))
+			Bench_ProcessRXMessage();
+		if (Selected("p1_parse"))
+			Bench_P1Parse();
+		if (Selected("json_devices"))
+			Bench_JSonDevices();
+		if (Selected("web_getdevices"))
+			Bench_WebGetDevices();
+		if (Selected("web_mix"))
+			Bench_WebMix();
+		if (Selected("eventqueue"))
+			Bench_EventQueue();
+		if (Selected("concurrent_queue"))
+			Bench_ConcurrentQueue();
+		if (Selected("rfxnames"))
+			Bench_RFXNames();
+		if (Selected("lua_statepool"))
+			Bench_LuaStatePool();
+		if (Selected("dzvents_export"))
+			Bench_DzVentsExport();
+		//last, it stops the asynchronous requests
+		if (Selected("http_async"))
+			Bench_HTTPAsync();
+
+		m_sql.CloseDatabase();
+		return true;
+	}
+
+	Json::Value m_results{ Json::arrayValue };
+	int m_failed = 0; // benchmarks whose result check failed
+
+      private:
+	typedef std::chrono::steady_clock bench_clock;
+
+	bool Selected(const std::string &name)
+	{
+		return (m_filter.empty() || (name.find(m_filter) != std::string::npos));
+	}
+
+	// Times every call of func (a tenth of the iterations, at most 100, are run first as warm-up)
+	template <typename Func> void Measure(const std::string &name, Func &&func)
+	{
+		int warmup = std::min(m_iterations / 10, 100);
+		for (int ii = 0; ii < warmup; ii++)
+			func(ii);
+
+		std::vector<uint64_t> samples;
+		samples.reserve(m_iterations);
+		auto tstart = bench_clock::now();
+		for (int ii = 0; ii < m_iterations; ii++)
+		{
+			auto t0 = bench_clock::now();
+			func(warmup + ii);
+			samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - t0).count());
+		}
+		AddResult(name, m_iterations, bench_clock::now() - tstart, samples);
+	}
+
+	void AddResult(const std::string &name, const uint64_t operations, const bench_clock::duration elapsed, std::vector<uint64_t> &samples)
+	{
+		double total_ms = std::chrono::duration<double, std::milli>(elapsed).count();
+
+		Json::Value item;
+		item["name"] = name;
+		item["iterations"] = Json::UInt64(operations);
+		item["total_ms"] = total_ms;
+		item["ops_per_sec"] = (total_ms > 0) ? (double(operations) * 1000.0 / total_ms) : 0;
+		item["avg_us"] = (operations > 0) ? (total_ms * 1000.0 / double(operations)) : 0;
+		if (!samples.empty())
+		{
+			// latency distribution, throughput benchmarks have no per operation samples
+			std::sort(samples.begin(), samples.end());
+			auto percentile = [&samples](const size_t pct) { return double(samples[(samples.size() - 1) * pct / 100]) / 1000.0; };
+			item["min_us"] = double(samples.front()) / 1000.0;
+			item["p50_us"] = percentile(50);
+			item["p95_us"] = percentile(95);
+			item["p99_us"] = percentile(99);
+			item["max_us"] = double(samples.back()) / 1000.0;
+		}
+		m_results.append(item);
+		std::cerr << name << ": " << operations << " ops in " << total_ms << " ms" << std::endl;
+	}
+
+	// UpdateValue of temperature sensors, the first round creates the devices
+	void Bench_SQLUpdateValue()
+	{
+		Measure("sql_updatevalue", [this](const int ii) {
+			char szID[10];
+			sprintf(szID, "%04X", 0x1000 + (ii % m_devices));
+			std::string devname = "Temp";
+			std::string sValue = std_format("%.1f", 15.0F + float(ii % 100) / 10.0F);
+			m_sql.UpdateValue(m_HwdID, szID, 1, pTypeTEMP, sTypeTEMP1, 12, 255, sValue.c_str(), devname, false, "");
+		});
+	}
+
+	// Decoding of received RFXtrx frames, including the database update
+	void Bench_ProcessRXMessage()
+	{
+		CDummy hardware(m_HwdID);
+		hardware.HwdType = HTYPE_Dummy;
+		hardware.m_Name = "Benchmark";
+
+		Measure("rx_process", [this, &hardware](const int ii) {
+			int node = ii % m_devices;
+			RBUF tsen;
+			memset(&tsen, 0, sizeof(RBUF));
+			switch (ii % 3)
+			{
+				case 0:
+					tsen.TEMP.packetlength = sizeof(tsen.TEMP) - 1;
+					tsen.TEMP.packettype = pTypeTEMP;
+					tsen.TEMP.subtype = sTypeTEMP1;
+					tsen.TEMP.id1 = 0x20;
+					tsen.TEMP.id2 = static_cast<uint8_t>(node);
+					tsen.TEMP.temperatureh = 0;
+					tsen.TEMP.temperaturel = static_cast<uint8_t>(150 + (ii % 100));
+					tsen.TEMP.battery_level = 9;
+					tsen.TEMP.rssi = 12;
+					break;
+				case 1:
+					tsen.TEMP_HUM.packetlength = sizeof(tsen.TEMP_HUM) - 1;
+					tsen.TEMP_HUM.packettype = pTypeTEMP_HUM;
+					tsen.TEMP_HUM.subtype = sTypeTH1;
+					tsen.TEMP_HUM.id1 = 0x21;
+					tsen.TEMP_HUM.id2 = static_cast<uint8_t>(node);
+					tsen.TEMP_HUM.temperatureh = 0;
+					tsen.TEMP_HUM.temperaturel = static_cast<uint8_t>(150 + (ii % 100));
+					tsen.TEMP_HUM.humidity = static_cast<uint8_t>(40 + (ii % 40));
+					tsen.TEMP_HUM.humidity_status = 1;
+					tsen.TEMP_HUM.battery_level = 9;
+					tsen.TEMP_HUM.rssi = 12;
+					break;
+				default:
+					tsen.LIGHTING2.packetlength = sizeof(tsen.LIGHTING2) - 1;
+					tsen.LIGHTING2.packettype = pTypeLighting2;
+					tsen.LIGHTING2.subtype = sTypeAC;
+					tsen.LIGHTING2.id1 = 0x01;
+					tsen.LIGHTING2.id2 = 0x22;
+					tsen.LIGHTING2.id3 = 0x33;
+					tsen.LIGHTING2.id4 = static_cast<uint8_t>(node);
+					tsen.LIGHTING2.unitcode = 1;
+					tsen.LIGHTING2.cmnd = ((ii / 3) % 2 == 0) ? light2_sOn : light2_sOff;
+					tsen.LIGHTING2.level = 15;
+					tsen.LIGHTING2.rssi = 12;
+					break;
+			}
+			m_mainworker.ProcessRXMessage(&hardware, reinterpret_cast<const uint8_t *>(&tsen), nullptr, 255, "");
+		});
+	}
+
+	// Parsing of a complete P1 telegram, fed in chunks like a serial port would
+	void Bench_P1Parse()
+	{
+		CBenchP1Meter meter(m_HwdID);
+		const uint8_t *pData = reinterpret_cast<const uint8_t *>(szP1Telegram);
+		const int length = static_cast<int>(strlen(szP1Telegram));
+
+		Measure("p1_parse", [&meter, pData, length](const int /*ii*/) {
+			for (int pos = 0; pos < length; pos += 64)
+				meter.Parse(pData + pos, std::min(64, length - pos));
+		});
+	}
+
+	// Used temperature sensors for the device list benchmarks
+	void CreateDevices()
+	{
+		if (m_sql.safe_query("SELECT ID FROM DeviceStatus WHERE (HardwareID==%d) LIMIT 1", m_HwdID).empty())
+		{
+			for (int ii = 0; ii < m_devices; ii++)
+			{
+				char szID[10];
+				sprintf(szID, "%04X", 0x1000 + ii);
+				std::string devname = "Temp";
+				m_sql.UpdateValue(m_HwdID, szID, 1, pTypeTEMP, sTypeTEMP1, 12, 255, "20.5", devname, false, "");
+			}
+		}
+		m_sql.safe_query("UPDATE DeviceStatus SET Used=1 WHERE (HardwareID==%d)", m_HwdID);
+	}
+
+	// Rendering of the device list as the web interface requests it
+	void Bench_JSonDevices()
+	{
+		CreateDevices();
+
+		auto pWebServer = std::make_shared<http::server::CWebServer>();
+		Measure("json_devices", [&pWebServer](const int /*ii*/) {
+			Json::Value root;
+			pWebServer->GetJSonDevices(root, "true", "all", "Name", "", "", "", false, false, false, 0, "");
+			std::string response = JSonToRawString(root);
+		});
+	}
+
+	// A complete getdevices request over the loopback interface: connection, request parsing,
+	// authorization, rendering and the reply. The server only listens on 127.0.0.1 and
+	// considers every client trusted, so no login is needed.
+	void Bench_WebGetDevices()
+	{
+		CreateDevices();
+
+		auto pWebServer = StartWebServer("web_getdevices");
+		if (pWebServer == nullptr)
+			return;
+
+		const std::string szURL = "http://127.0.0.1:" + m_webport + "/json.htm?type=command&param=getdevices&filter=all&used=true&order=Name";
+		int failed = 0;
+		Measure("web_getdevices", [&szURL, &failed](const int /*ii*/) {
+			std::string response;
+			if ((!HTTPClient::GET(szURL, response)) || (response.find("\"Devices\"") == std::string::npos))
+				failed++;
+		});
+		pWebServer->StopServer();
+		if (failed != 0)
+			std::cerr << "web_getdevices: " << failed << " requests failed" << std::endl;
+	}
+
+	// Concurrent clients sending a mix of graph and switch requests, the latency of every
+	// request is sampled so a slow graph shows up in the p99 of the switch requests
+	void Bench_WebMix()
+	{
+		CreateDevices();
+		std::string devname = "Switch";
+		uint64_t switchIdx = m_sql.UpdateValue(m_HwdID, "00012233", 1, pTypeLighting2, sTypeAC, 12, 255, 0, "", devname, false, "");
+		m_sql.safe_query("UPDATE DeviceStatus SET Used=1 WHERE (ID==%" PRIu64 ")", switchIdx);
+		auto result = m_sql.safe_query("SELECT ID FROM DeviceStatus WHERE (HardwareID==%d) AND (Type==%d)", m_HwdID, pTypeTEMP);
+		if (result.empty())
+			return;
+		std::vector<std::string> sensors;
+		for (const auto &sd : result)
+			sensors.push_back(sd[0]);
+
+		// the switch commands are written to the dummy hardware
+		m_mainworker.AddDomoticzHardware(new CDummy(m_HwdID));
+
+		auto pWebServer = StartWebServer("web_mix");
+		if (pWebServer != nullptr)
+		{
+			const std::string szBase = "http://127.0.0.1:" + m_webport + "/json.htm?";
+			std::vector<std::vector<uint64_t>> samples(BENCH_WEB_CLIENTS);
+			std::atomic<int> failed{ 0 };
+			const int requests = std::max(m_iterations / BENCH_WEB_CLIENTS, 1);
+
+			auto tstart = bench_clock::now();
+			std::vector<std::thread> clients;
+			for (int ii = 0; ii < BENCH_WEB_CLIENTS; ii++)
+			{
+				clients.emplace_back([&, ii]() {
+					samples[ii].reserve(requests);
+					for (int jj = 0; jj < requests; jj++)
+					{
+						std::string szURL;
+						if (jj % 2 == 0)
+							szURL = szBase + "type=graph&sensor=temp&range=day&idx=" + sensors[(ii + jj) % sensors.size()];
+						else
+							szURL = szBase + "type=command&param=switchlight&switchcmd=" + (((jj / 2) % 2 == 0) ? "On" : "Off") + "&idx=" + std::to_string(switchIdx);
+						std::string response;
+						auto t0 = bench_clock::now();
+						if (!HTTPClient::GET(szURL, response))
+							failed++;
+						samples[ii].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - t0).count());
+					}
+				});
+			}
+			for (auto &client : clients)
+				client.join();
+
+			std::vector<uint64_t> allsamples;
+			for (const auto &client : samples)
+				allsamples.insert(allsamples.end(), client.begin(), client.end());
+			AddResult("web_mix", allsamples.size(), bench_clock::now() - tstart, allsamples);
+			pWebServer->StopServer();
+			if (failed != 0)
+				std::cerr << "web_mix: " << failed << " requests failed" << std::endl;
+		}
+		m_mainworker.RemoveDomoticzHardware(m_HwdID);
+	}
+
+	// Web server on the loopback interface that considers every client trusted
+	std::shared_ptr<http::server::CWebServer> StartWebServer(const std::string &name)
+	{
+		http::server::server_settings settings;
+		settings.listening_address = "127.0.0.1";
+		settings.listening_port = m_webport;
+		settings.www_root = szWWWFolder;
+		auto pWebServer = std::make_shared<http::server::CWebServer>();
+		if (!pWebServer->StartServer(settings, szWWWFolder, true))
+		{
+			std::cerr << name << ": could not start the web server on port " << m_webport << std::endl;
+			return nullptr;
+		}
+		return pWebServer;
+	}
+
+	// Several producers feeding the event system queue, drained in batches like the event thread does
+	void Bench_EventQueue()
+	{
+		mpsc_ring_queue<CEventSystem::_tEventQueue> queue{ 2048 };
+		const uint64_t total = uint64_t(m_iterations) * BENCH_QUEUE_PRODUCERS;
+
+		auto tstart = bench_clock::now();
+		std::vector<std::thread> producers;
+		for (int ii = 0; ii < BENCH_QUEUE_PRODUCERS; ii++)
+		{
+			producers.emplace_back([this, &queue, ii]() {
+				for (int jj = 0; jj < m_iterations; jj++)
+				{
+					CEventSystem::_tEventQueue item;
+					item.reason = CEventSystem::REASON_DEVICE;
+					item.id = uint64_t(ii) * m_iterations + jj;
+					item.devname = "Temp";
+					item.nValue = 0;
+					item.sValue = "20.5";
+					item.timeoutOccurred = false;
+					item.lastLevel = 0;
+					queue.push(std::move(item));
+				}
+			});
+		}
+		std::vector<CEventSystem::_tEventQueue> items;
+		uint64_t received = 0;
+		while (received < total)
+		{
+			items.clear();
+			received += queue.timed_wait_and_pop_all(items, std::chrono::milliseconds(100));
+		}
+		for (auto &producer : producers)
+			producer.join();
+
+		std::vector<uint64_t> samples;
+		AddResult("eventqueue", total, bench_clock::now() - tstart, samples);
+	}
+
+	// The same pattern on the mutex based queue that is used by the other workers
+	void Bench_ConcurrentQueue()
+	{
+		concurrent_queue<std::string> queue;
+		const uint64_t total = uint64_t(m_iterations) * BENCH_QUEUE_PRODUCERS;
+
+		auto tstart = bench_clock::now();
+		std::vector<std::thread> producers;
+		for (int ii = 0; ii < BENCH_QUEUE_PRODUCERS; ii++)
+		{
+			producers.emplace_back([this, &queue]() {
+				for (int jj = 0; jj < m_iterations; jj++)
+					queue.push("20.5");
+			});
+		}
+		std::string item;
+		uint64_t received = 0;
+		while (received < total)
+		{
+			if (queue.timed_wait_and_pop(item, std::chrono::milliseconds(100)))
+				received++;
+		}
+		for (auto &producer : producers)
+			producer.join();
+
+		std::vector<uint64_t> samples;
+		AddResult("concurrent_queue", total, bench_clock::now() - tstart, samples);
+	}
+
+	// Type, sub type, switch type and hardware descriptions, looked up for every device in the device list
+	void Bench_RFXNames()
+	{
+		static const unsigned char Types[][2] = {
+			{ pTypeTEMP, sTypeTEMP1 },
+			{ pTypeLighting2, sTypeAC },
+			{ pTypeGeneral, sTypeKwh },
+			{ pTypeP1Power, sTypeP1Power },
+			{ pTypeGeneralSwitch, sSwitchTypeV2Phoenix },
+			{ 0x01, 0x01 }, // unknown type
+		};
+		static const int HardwareTypes[] = { HTYPE_Dummy, HTYPE_MQTT, HTYPE_RFLINKMQTT, -1 };
+		const size_t lookups = (sizeof(Types) / sizeof(Types[0])) * 3 + (sizeof(HardwareTypes) / sizeof(HardwareTypes[0]));
+
+		size_t length = 0;
+		auto tstart = bench_clock::now();
+		for (int ii = 0; ii < m_iterations; ii++)
+		{
+			for (const auto &type : Types)
+			{
+				length += strlen(RFX_Type_Desc(type[0], 1));
+				length += strlen(RFX_Type_SubType_Desc(type[0], type[1]));
+				length += strlen(Switch_Type_Desc(static_cast<_eSwitchType>(type[1])));
+			}
+			for (const auto htype : HardwareTypes)
+				length += strlen(Hardware_Type_Desc(htype));
+		}
+		std::vector<uint64_t> samples;
+		AddResult("rfxnames", uint64_t(m_iterations) * lookups, bench_clock::now() - tstart, samples);
+		if (length == 0)
+			std::cerr << "rfxnames: no descriptions found" << std::endl;
+	}
+
+	// Acquire, run a script and release a pooled Lua state (the release resets the sandbox).
+	// A value the host stored with the state has to survive the resets, the script global not
+	void Bench_LuaStatePool()
+	{
+		CLuaStatePool pool;
+		lua_State *lua_state = pool.Acquire();
+		if (lua_state == nullptr)
+		{
+			std::cerr << "lua_statepool: could not create a Lua state" << std::endl;
+			m_failed++;
+			return;
+		}
+		lua_pushstring(lua_state, "host");
+		CLuaStatePool::SetHostValue(lua_state, "bench");
+		pool.Release(lua_state);
+
+		Measure("lua_statepool", [&pool](const int ii) {
+			lua_State *lua_state = pool.Acquire();
+			lua_pushinteger(lua_state, ii);
+			lua_setglobal(lua_state, "benchGlobal");
+			if (luaL_loadstring(lua_state, "debug.getregistry().benchField = benchGlobal") == 0)
+				lua_pcall(lua_state, 0, 0, 0);
+			pool.Release(lua_state);
+		});
+
+		lua_state = pool.Acquire();
+		CLuaStatePool::PushHostValue(lua_state, "bench");
+		const char *szValue = lua_tostring(lua_state, -1);
+		if ((szValue == nullptr) || (strcmp(szValue, "host") != 0))
+		{
+			std::cerr << "lua_statepool: the host value did not survive the release" << std::endl;
+			m_failed++;
+		}
+		lua_getglobal(lua_state, "benchGlobal");
+		lua_getfield(lua_state, LUA_REGISTRYINDEX, "benchField");
+		if ((!lua_isnil(lua_state, -1)) || (!lua_isnil(lua_state, -2)))
+		{
+			std::cerr << "lua_statepool: the sandbox was not reset" << std::endl;
+			m_failed++;
+		}
+		pool.Release(lua_state);
+	}
+
+	// Export of the device states to dzVents on a pooled state, nothing changed between the evaluations,
+	// so the device entries of the previous export have to be reused (the same Lua tables)
+	void Bench_DzVentsExport()
+	{
+		CreateDevices();
+		m_mainworker.m_eventsystem.GetCurrentStates();
+
+		std::vector<CEventSystem::_tEventQueue> items(1);
+		items[0].reason = CEventSystem::REASON_TIME;
+		items[0].id = 0;
+
+		CLuaStatePool pool;
+		lua_State *lua_state = pool.Acquire();
+		if (lua_state == nullptr)
+		{
+			std::cerr << "dzvents_export: could not create a Lua state" << std::endl;
+			m_failed++;
+			return;
+		}
+		CdzVents::GetInstance()->EvaluateDzVents(lua_state, items, 0);
+		lua_getglobal(lua_state, "domoticzData");
+		lua_rawgeti(lua_state, -1, 1);
+		const int entryRef = luaL_ref(lua_state, LUA_REGISTRYINDEX);
+		pool.Release(lua_state);
+
+		Measure("dzvents_export", [&pool, &items](const int /*ii*/) {
+			lua_State *lua_state = pool.Acquire();
+			CdzVents::GetInstance()->EvaluateDzVents(lua_state, items, 0);
+			pool.Release(lua_state);
+		});
+
+		lua_state = pool.Acquire();
+		CdzVents::GetInstance()->EvaluateDzVents(lua_state, items, 0);
+		lua_getglobal(lua_state, "domoticzData");
+		lua_rawgeti(lua_state, -1, 1);
+		lua_rawgeti(lua_state, LUA_REGISTRYINDEX, entryRef);
+		if ((!lua_istable(lua_state, -1)) || (!lua_rawequal(lua_state, -1, -2)))
+		{
+			std::cerr << "dzvents_export: the cached device entries were not reused" << std::endl;
+			m_failed++;
+		}
+		luaL_unref(lua_state, LUA_REGISTRYINDEX, entryRef);
+		pool.Release(lua_state);
+	}
+
+	// Asynchronous requests on the shared curl engine against the loopback web server, every
+	// request waits for its callback. The results have to match the blocking functions, a
+	// cancelled request is not called back and stopping the engine fails the running requests
+	void Bench_HTTPAsync()
+	{
+		auto pWebServer = StartWebServer("http_async");
+		if (pWebServer == nullptr)
+			return;
+		const std::string szBase = "http://127.0.0.1:" + m_webport;
+		const std::string szURL = szBase + "/json.htm?type=command&param=getversion";
+		const std::vector<std::string> ExtraHeaders;
+
+		// accepts connections but never answers, its requests keep running
+		boost::asio::io_service ios;
+		boost::asio::ip::tcp::acceptor acceptor(ios, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+		const std::string szSilentURL = "http://127.0.0.1:" + std::to_string(acceptor.local_endpoint().port()) + "/";
+
+		struct _tAsyncResult
+		{
+			int calls = 0;
+			bool bSuccess = false;
+			std::vector<unsigned char> response;
+			std::vector<std::string> vHeaderData;
+		};
+		std::mutex mutex;
+		std::condition_variable cond;
+		auto request = [&](const HTTPClient::_eHTTPmethod method, const std::string &url, const std::shared_ptr<_tAsyncResult> &result, const long TimeOut) {
+			return HTTPClient::AsyncRequest(method, url, "bench", ExtraHeaders,
+				[&mutex, &cond, result](const bool bSuccess, const std::vector<unsigned char> &response, const std::vector<std::string> &vHeaderData) {
+					std::lock_guard<std::mutex> l(mutex);
+					result->calls++;
+					result->bSuccess = bSuccess;
+					result->response = response;
+					result->vHeaderData = vHeaderData;
+					cond.notify_all();
+				}, TimeOut);
+		};
+		auto waitCalls = [&](const std::vector<std::shared_ptr<_tAsyncResult>> &results, const int seconds) {
+			std::unique_lock<std::mutex> l(mutex);
+			return cond.wait_for(l, std::chrono::seconds(seconds), [&results] {
+				return std::all_of(results.begin(), results.end(), [](const std::shared_ptr<_tAsyncResult> &result) { return (result->calls != 0); });
+			});
+		};
+		auto statusLine = [](const std::vector<std::string> &vHeaderData) { return (vHeaderData.empty()) ? std::string() : vHeaderData.front(); };
+
+		// the same result as the blocking functions (a GET fails on a HTTP error, a POST does not)
+		const std::vector<std::pair<HTTPClient::_eHTTPmethod, std::string>> cases = {
+			{ HTTPClient::HTTP_METHOD_GET, szURL },
+			{ HTTPClient::HTTP_METHOD_GET, szBase + "/bench_missing.htm" },
+			{ HTTPClient::HTTP_METHOD_POST, szBase + "/bench_missing.htm" },
+		};
+		uint64_t completedId = 0;
+		for (const auto &tcase : cases)
+		{
+			std::vector<unsigned char> response;
+			std::vector<std::string> vHeaderData;
+			bool bBlocking;
+			if (tcase.first == HTTPClient::HTTP_METHOD_GET)
+				bBlocking = HTTPClient::GETBinary(tcase.second, ExtraHeaders, response, vHeaderData);
+			else
+				bBlocking = HTTPClient::POSTBinary(tcase.second, "bench", ExtraHeaders, response, vHeaderData);
+			auto result = std::make_shared<_tAsyncResult>();
+			completedId = request(tcase.first, tcase.second, result, -1);
+			if ((completedId == 0) || (!waitCalls({ result }, 10)) || (result->bSuccess != bBlocking) || (statusLine(result->vHeaderData) != statusLine(vHeaderData)))
+			{
+				std::cerr << "http_async: " << ((tcase.first == HTTPClient::HTTP_METHOD_GET) ? "GET " : "POST ") << tcase.second << " differs from the blocking request" << std::endl;
+				m_failed++;
+			}
+		}
+		if ((completedId != 0) && (HTTPClient::Cancel(completedId)))
+		{
+			std::cerr << "http_async: a completed request was cancelled" << std::endl;
+			m_failed++;
+		}
+
+		int failed = 0;
+		Measure("http_async", [&](const int /*ii*/) {
+			auto result = std::make_shared<_tAsyncResult>();
+			if ((request(HTTPClient::HTTP_METHOD_GET, szURL, result, -1) == 0) || (!waitCalls({ result }, 10)) || (!result->bSuccess))
+				failed++;
+		});
+		if (failed != 0)
+			std::cerr << "http_async: " << failed << " requests failed" << std::endl;
+
+		// a cancelled request is never called back, also when it completes meanwhile
+		std::vector<std::shared_ptr<_tAsyncResult>> results;
+		std::vector<uint64_t> ids;
+		for (int ii = 0; ii < BENCH_ASYNC_REQUESTS * 2; ii++)
+		{
+			results.push_back(std::make_shared<_tAsyncResult>());
+			ids.push_back(request(HTTPClient::HTTP_METHOD_GET, (ii < BENCH_ASYNC_REQUESTS) ? szSilentURL : szURL, results.back(), 30));
+		}
+		sleep_milliseconds(200);
+		std::vector<bool> cancelled;
+		for (size_t ii = 0; ii < ids.size(); ii++)
+			cancelled.push_back((ids[ii] != 0) && (HTTPClient::Cancel(ids[ii])));
+		sleep_milliseconds(500);
+		{
+			std::lock_guard<std::mutex> l(mutex);
+			for (size_t ii = 0; ii < ids.size(); ii++)
+			{
+				bool bRunning = (ii < BENCH_ASYNC_REQUESTS);
+				if ((bRunning) ? ((!cancelled[ii]) || (results[ii]->calls != 0)) : (results[ii]->calls != ((cancelled[ii]) ? 0 : 1)))
+				{
+					std::cerr << "http_async: cancel of " << ((bRunning) ? "a running" : "a completing") << " request failed" << std::endl;
+					m_failed++;
+					break;
+				}
+			}
+		}
+
+		// stopping fails the running requests, like the blocking request that timed out
+		std::vector<unsigned char> response;
+		bool bBlocking = HTTPClient::GETBinary(szSilentURL, ExtraHeaders, response, 1);
+		results.clear();
+		for (int ii = 0; ii < BENCH_ASYNC_REQUESTS; ii++)
+		{
+			results.push_back(std::make_shared<_tAsyncResult>());
+			request(HTTPClient::HTTP_METHOD_GET, szSilentURL, results.back(), 30);
+		}
+		sleep_milliseconds(200);
+		auto tstart = bench_clock::now();
+		HTTPClient::Cleanup();
+		auto elapsed = bench_clock::now() - tstart;
+		{
+			std::lock_guard<std::mutex> l(mutex);
+			for (const auto &result : results)
+			{
+				if ((result->calls != 1) || (result->bSuccess != bBlocking))
+				{
+					std::cerr << "http_async: a running request was not failed once when stopping" << std::endl;
+					m_failed++;
+					break;
+				}
+			}
+		}
+		if (elapsed > std::chrono::seconds(5))
+		{
+			std::cerr << "http_async: stopping waited for the running requests" << std::endl;
+			m_failed++;
+		}
+		if (request(HTTPClient::HTTP_METHOD_GET, szURL, std::make_shared<_tAsyncResult>(), -1) != 0)
+		{
+			std::cerr << "http_async: a request was started after stopping" << std::endl;
+			m_failed++;
+		}
+		pWebServer->StopServer();
+	}
+
+	int m_iterations;
+	int m_devices;
+	std::string m_filter;
+	std::string m_webport;
+	int m_HwdID = 0;
+};
+
+int main(int argc, char **argv)
+{
+	CCmdLine cmdLine;
+	cmdLine.SplitLine(argc, argv);
+
+	if ((cmdLine.HasSwitch("-h")) || (cmdLine.HasSwitch("--help")) || (cmdLine.HasSwitch("/?")))
+	{
+		std::cout << szHelp;
+		return 0;
+	}
+	if (cmdLine.HasSwitch("-list"))
+	{
+		for (const auto &name : CBenchmark::GetNames())
+			std::cout << name << std::endl;
+		return 0;
+	}
+
+	int iterations = BENCH_DEFAULT_ITERATIONS;
+	if (cmdLine.HasSwitch("-iterations"))
+	{
+		if (cmdLine.GetArgumentCount("-iterations") != 1)
+		{
+			std::cerr << "Please specify the number of iterations" << std::endl;
+			return 1;
+		}
+		iterations = std::max(atoi(cmdLine.GetSafeArgument("-iterations", 0, "").c_str()), 1);
+	}
+	int devices = BENCH_DEFAULT_DEVICES;
+	if (cmdLine.HasSwitch("-devices"))
+	{
+		if (cmdLine.GetArgumentCount("-devices") != 1)
+		{
+			std::cerr << "Please specify the number of devices" << std::endl;
+			return 1;
+		}
+		devices = std::min(std::max(atoi(cmdLine.GetSafeArgument("-devices", 0, "").c_str()), 1), 255);
+	}
+	std::string filter;
+	if (cmdLine.HasSwitch("-filter"))
+	{
+		if (cmdLine.GetArgumentCount("-filter") != 1)
+		{
+			std::cerr << "Please specify a benchmark name" << std::endl;
+			return 1;
+		}
+		filter = cmdLine.GetSafeArgument("-filter", 0, "");
+	}
+	std::string webport = BENCH_DEFAULT_WEBPORT;
+	if (cmdLine.HasSwitch("-webport"))
+	{
+		if (cmdLine.GetArgumentCount("-webport") != 1)
+		{
+			std::cerr << "Please specify a port" << std::endl;
+			return 1;
+		}
+		webport = cmdLine.GetSafeArgument("-webport", 0, "");
+	}
+	std::string outputfile;
+	if (cmdLine.HasSwitch("-output"))
+	{
+		if (cmdLine.GetArgumentCount("-output") != 1)
+		{
+			std::cerr << "Please specify an output file" << std::endl;
+			return 1;
+		}
+		outputfile = cmdLine.GetSafeArgument("-output", 0, "");
+	}
+	if (!cmdLine.HasSwitch("-verbose"))
+		_log.SetLogFlags(LOG_ERROR);
+
+	GetAppVersion();
+
+	if (szWWWFolder.empty())
+		szWWWFolder = szStartupFolder + "www";
+
+	m_iopool.Start();
+	CBenchmark bench(iterations, devices, filter, webport);
+	bool bResult = bench.Run();
+	m_iopool.Stop();
+	if (!bResult)
+		return 1;
+
+	Json::Value root;
+	root["version"] = szAppVersion;
+	root["hash"] = szAppHash;
+	root["date"] = szAppDate;
+	root["iterations"] = iterations;
+	root["devices"] = devices;
+	root["results"] = bench.m_results;
+
+	std::string szOutput = JSonToFormatString(root);
+	int ret = (bench.m_failed == 0) ? 0 : 1;
+	if (outputfile.empty())
+	{
+		std::cout << szOutput << std::endl;
+		return ret;
+	}
+	std::ofstream outfile(outputfile.c_str(), std::ios::out | std::ios::trunc);
+	if (!outfile.is_open())
+	{
+		std::cerr << "Could not write to: " << outputfile << std::endl;
+		return 1;
+	}
+	outfile << szOutput << std::endl;
+	return ret;
+}
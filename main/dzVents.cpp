@@ -43,7 +43,6 @@ std::string CdzVents::GetVersion()
 void CdzVents::EvaluateDzVents(lua_State *lua_state, const std::vector<CEventSystem::_tEventQueue> &items, const int secStatus)
 {
 	// reroute print library to Domoticz logger
-	luaL_openlibs(lua_state);
 	lua_pushcfunction(lua_state, l_domoticz_print);
 	lua_setglobal(lua_state, "print");
 
@@ -854,8 +853,56 @@ void CdzVents::ExportHardwareData(CLuaTable &luaTable, int& index, const std::ve
 	;// to be implemented when hardware notification support is added
 }
 
+// The entry tables of the previous export are kept with the (pooled) Lua state as a host value
+// of the state pool, entries whose version did not change are reused instead of being built again.
+// Layout: [kind] = { [id] = entry }, [kind + EXPORT_VERSIONS] = { [id] = version }
+// and for devices [EXPORT_CHECKTIMES] = { [id] = lastUpdate as time_t }
+#define EXPORT_CACHE "dzVents_exportCache"
+enum _eExportCache
+{
+	EXPORT_DEVICES = 1,
+	EXPORT_SCENES,
+	EXPORT_VARIABLES,
+	EXPORT_VERSIONS = 3,
+	EXPORT_CHECKTIMES = 7
+};
+
+bool CdzVents::GetCachedEntry(lua_State *lua_state, const int cacheIdx, const int kind, const uint64_t id, const uint64_t version)
+{
+	if ((cacheIdx == 0) || (version == 0))
+		return false;
+	lua_rawgeti(lua_state, cacheIdx, kind + EXPORT_VERSIONS);
+	lua_rawgeti(lua_state, -1, (lua_Integer)id);
+	bool bFound = (!lua_isnil(lua_state, -1)) && ((uint64_t)lua_tointeger(lua_state, -1) == version);
+	lua_pop(lua_state, 2);
+	if (!bFound)
+		return false;
+	lua_rawgeti(lua_state, cacheIdx, kind);
+	lua_rawgeti(lua_state, -1, (lua_Integer)id);
+	lua_remove(lua_state, -2);
+	return true;
+}
+
+// Stores the entry on top of the stack in the new cache and appends it to the data table (pops the entry)
+void CdzVents::AddCachedEntry(lua_State *lua_state, const int dataIdx, const int index, const int cacheIdx, const int kind, const uint64_t id, const uint64_t version)
+{
+	lua_rawgeti(lua_state, cacheIdx, kind);
+	lua_pushvalue(lua_state, -2);
+	lua_rawseti(lua_state, -2, (lua_Integer)id);
+	lua_pop(lua_state, 1);
+
+	lua_rawgeti(lua_state, cacheIdx, kind + EXPORT_VERSIONS);
+	lua_pushinteger(lua_state, (lua_Integer)version);
+	lua_rawseti(lua_state, -2, (lua_Integer)id);
+	lua_pop(lua_state, 1);
+
+	lua_rawseti(lua_state, dataIdx, index);
+}
+
 void CdzVents::ExportDomoticzDataToLua(lua_State *lua_state, const std::vector<CEventSystem::_tEventQueue> &items)
 {
+	m_mainworker.m_eventsystem.RefreshJsonMaps();
+
 	boost::shared_lock<boost::shared_mutex> devicestatesMutexLock(m_mainworker.m_eventsystem.m_devicestatesMutex);
 	int index = 1;
 	time_t now = mytime(nullptr);
@@ -869,42 +916,69 @@ void CdzVents::ExportDomoticzDataToLua(lua_State *lua_state, const std::vector<C
 	struct tm ntime;
 	time_t checktime;
 
-	CLuaTable luaTable(lua_state, "domoticzData");
+	lua_createtable(lua_state, (int)m_mainworker.m_eventsystem.m_devicestates.size(), 0);
+	int dataIdx = lua_gettop(lua_state);
+
+	int oldCacheIdx = 0;
+	CLuaStatePool::PushHostValue(lua_state, EXPORT_CACHE);
+	if (lua_istable(lua_state, -1))
+		oldCacheIdx = lua_gettop(lua_state);
+	else
+		lua_pop(lua_state, 1);
+
+	// entries that are no longer exported drop out of the new cache
+	lua_createtable(lua_state, EXPORT_CHECKTIMES, 0);
+	int cacheIdx = lua_gettop(lua_state);
+	for (int ii = EXPORT_DEVICES; ii <= EXPORT_CHECKTIMES; ii++)
+	{
+		lua_newtable(lua_state);
+		lua_rawseti(lua_state, cacheIdx, ii);
+	}
 
 	// First export all the devices.
 	for (const auto &state : m_mainworker.m_eventsystem.m_devicestates)
 	{
-		CEventSystem::_tDeviceStatus sitem = state.second;
-		const char *dev_type = RFX_Type_Desc(sitem.devType, 1);
-		const char *sub_type = RFX_Type_SubType_Desc(sitem.devType, sitem.subType);
+		if (state.second.ID == 0)
+			continue;
 
-		bool triggerDevice = false;
+		const CEventSystem::_tEventQueue *pTrigger = nullptr;
 		for (const auto &item : items)
 		{
-			if (sitem.ID > 0 && sitem.ID == item.id && item.reason == m_mainworker.m_eventsystem.REASON_DEVICE)
+			if (state.second.ID == item.id && item.reason == m_mainworker.m_eventsystem.REASON_DEVICE)
+				pTrigger = &item;
+		}
+
+		if ((pTrigger == nullptr) && (GetCachedEntry(lua_state, oldCacheIdx, EXPORT_DEVICES, state.second.ID, state.second.version)))
+		{
+			lua_rawgeti(lua_state, oldCacheIdx, EXPORT_CHECKTIMES);
+			lua_rawgeti(lua_state, -1, (lua_Integer)state.second.ID);
+			checktime = (time_t)lua_tointeger(lua_state, -1);
+			lua_pop(lua_state, 2);
+
+			lua_pushboolean(lua_state, (now - checktime >= SensorTimeOut * 60));
+			lua_setfield(lua_state, -2, "timedOut");
+		}
+		else
+		{
+			CEventSystem::_tDeviceStatus sitem = state.second;
+			const char *dev_type = RFX_Type_Desc(sitem.devType, 1);
+			const char *sub_type = RFX_Type_SubType_Desc(sitem.devType, sitem.subType);
+
+			bool triggerDevice = (pTrigger != nullptr);
+			if (triggerDevice)
 			{
-				triggerDevice = true;
+				const CEventSystem::_tEventQueue &item = *pTrigger;
 				sitem.lastUpdate = item.lastUpdate;
 				sitem.lastLevel = item.lastLevel;
 				sitem.sValue = item.sValue;
 				sitem.nValueWording = item.nValueWording;
 				sitem.nValue = item.nValue;
-				if (!item.JsonMapString.empty())
-					sitem.JsonMapString = item.JsonMapString;
-				if (!item.JsonMapFloat.empty())
-					sitem.JsonMapFloat = item.JsonMapFloat;
-				if (!item.JsonMapInt.empty())
-					sitem.JsonMapInt = item.JsonMapInt;
-				if (!item.JsonMapBool.empty())
-					sitem.JsonMapBool = item.JsonMapBool;
 			}
-		}
 
-		ParseSQLdatetime(checktime, ntime, sitem.lastUpdate, tm1.tm_isdst);
-		bool timed_out = (now - checktime >= SensorTimeOut * 60);
-		if (sitem.ID > 0)
-		{
-			luaTable.OpenSubTableEntry(index, 1, 14);
+			ParseSQLdatetime(checktime, ntime, sitem.lastUpdate, tm1.tm_isdst);
+			bool timed_out = (now - checktime >= SensorTimeOut * 60);
+
+			CLuaTable luaTable(lua_state, "domoticzData", 1, 14);
 
 			luaTable.AddString("name", sitem.deviceName);
 			luaTable.AddBool("protected", (sitem.protection == 1) );
@@ -985,9 +1059,17 @@ void CdzVents::ExportDomoticzDataToLua(lua_State *lua_state, const std::vector<C
 			}
 
 			luaTable.CloseSubTableEntry();
-			luaTable.CloseSubTableEntry();
-			index++;
+			luaTable.Push();
 		}
+
+		lua_rawgeti(lua_state, cacheIdx, EXPORT_CHECKTIMES);
+		lua_pushinteger(lua_state, (lua_Integer)checktime);
+		lua_rawseti(lua_state, -2, (lua_Integer)state.second.ID);
+		lua_pop(lua_state, 1);
+
+		// a triggered entry has changed=true, it is built again on the next run
+		AddCachedEntry(lua_state, dataIdx, index, cacheIdx, EXPORT_DEVICES, state.second.ID, (pTrigger == nullptr) ? state.second.version : 0);
+		index++;
 	}
 
 	devicestatesMutexLock.unlock();
@@ -1011,35 +1093,39 @@ void CdzVents::ExportDomoticzDataToLua(lua_State *lua_state, const std::vector<C
 			}
 		}
 
-		luaTable.OpenSubTableEntry(index, 1, 7);
+		if ((triggerScene) || (!GetCachedEntry(lua_state, oldCacheIdx, EXPORT_SCENES, sgitem.ID, sgitem.version)))
+		{
+			CLuaTable luaTable(lua_state, "domoticzData", 1, 7);
 
-		luaTable.AddString("name", sgitem.scenesgroupName);
-		luaTable.AddInteger("id", sgitem.ID);
-		luaTable.AddString("description", sgitem.description);
-		luaTable.AddString("baseType", (sgitem.scenesgroupType == 0) ? "scene" : "group");
-		luaTable.AddBool("protected", (lua_Number)sgitem.protection == 1);
-		luaTable.AddString("lastUpdate", sgitem.lastUpdate);
-		luaTable.AddBool("changed", triggerScene);
+			luaTable.AddString("name", sgitem.scenesgroupName);
+			luaTable.AddInteger("id", sgitem.ID);
+			luaTable.AddString("description", sgitem.description);
+			luaTable.AddString("baseType", (sgitem.scenesgroupType == 0) ? "scene" : "group");
+			luaTable.AddBool("protected", (lua_Number)sgitem.protection == 1);
+			luaTable.AddString("lastUpdate", sgitem.lastUpdate);
+			luaTable.AddBool("changed", triggerScene);
 
-		luaTable.OpenSubTableEntry("data", 0, 0);
+			luaTable.OpenSubTableEntry("data", 0, 0);
 
-		luaTable.AddString("_state", sgitem.scenesgroupValue);
+			luaTable.AddString("_state", sgitem.scenesgroupValue);
 
-		luaTable.CloseSubTableEntry();
+			luaTable.CloseSubTableEntry();
 
-		luaTable.OpenSubTableEntry("deviceIDs", 0, 0);
-		if (!sgitem.memberID.empty())
-		{
-			int index = 1;
-			for (const auto &id : sgitem.memberID)
+			luaTable.OpenSubTableEntry("deviceIDs", 0, 0);
+			if (!sgitem.memberID.empty())
 			{
-				luaTable.AddInteger(index, id);
-				index++;
+				int index = 1;
+				for (const auto &id : sgitem.memberID)
+				{
+					luaTable.AddInteger(index, id);
+					index++;
+				}
 			}
-		}
 
-		luaTable.CloseSubTableEntry(); // device table
-		luaTable.CloseSubTableEntry(); // end entry
+			luaTable.CloseSubTableEntry(); // device table
+			luaTable.Push();
+		}
+		AddCachedEntry(lua_state, dataIdx, index, cacheIdx, EXPORT_SCENES, sgitem.ID, (triggerScene) ? 0 : sgitem.version);
 		index++;
 	}
 	scenesgroupsMutexLock.unlock();
@@ -1062,7 +1148,14 @@ void CdzVents::ExportDomoticzDataToLua(lua_State *lua_state, const std::vector<C
 			}
 		}
 
-		luaTable.OpenSubTableEntry(index, 1, 5);
+		if ((!triggerVar) && (GetCachedEntry(lua_state, oldCacheIdx, EXPORT_VARIABLES, uvitem.ID, uvitem.version)))
+		{
+			AddCachedEntry(lua_state, dataIdx, index, cacheIdx, EXPORT_VARIABLES, uvitem.ID, uvitem.version);
+			index++;
+			continue;
+		}
+
+		CLuaTable luaTable(lua_state, "domoticzData", 1, 5);
 
 		luaTable.AddString("name", uvitem.variableName);
 		luaTable.AddInteger("id", uvitem.ID);
@@ -1101,13 +1194,22 @@ void CdzVents::ExportDomoticzDataToLua(lua_State *lua_state, const std::vector<C
 
 		luaTable.AddString("variableType", vtype);
 
-		luaTable.CloseSubTableEntry(); // end entry
-
+		luaTable.Push();
+		AddCachedEntry(lua_state, dataIdx, index, cacheIdx, EXPORT_VARIABLES, uvitem.ID, (triggerVar) ? 0 : uvitem.version);
 		index++;
 	}
+	uservariablesMutexLock.unlock();
+
+	CLuaStatePool::SetHostValue(lua_state, EXPORT_CACHE);
+	if (oldCacheIdx != 0)
+		lua_pop(lua_state, 1);
+
+	// Cameras and hardware are not cached
+	int firstIndex = index;
+	CLuaTable luaTable(lua_state, "domoticzData");
 
 	// Now do the cameras.
-	result = m_sql.safe_query("SELECT ID, Name FROM Cameras where enabled = '1' ORDER BY ID ASC");
+	result = m_sql.safe_query_readonly("SELECT ID, Name FROM Cameras where enabled = '1' ORDER BY ID ASC");
 	if (!result.empty())
 	{
 		for (const auto &sd : result)
@@ -1123,7 +1225,7 @@ void CdzVents::ExportDomoticzDataToLua(lua_State *lua_state, const std::vector<C
 	}
 
 	// Now do the Hardware.
-	result = m_sql.safe_query("SELECT ID, Name, type FROM Hardware where enabled = '1' ORDER BY ID ASC");
+	result = m_sql.safe_query_readonly("SELECT ID, Name, type FROM Hardware where enabled = '1' ORDER BY ID ASC");
 	int HardwareTypeVal;
 
 	if (!result.empty())
@@ -1155,5 +1257,12 @@ void CdzVents::ExportDomoticzDataToLua(lua_State *lua_state, const std::vector<C
 
 	ExportHardwareData(luaTable, index, items);
 
-	luaTable.Publish();
+	luaTable.Push();
+	for (int ii = firstIndex; ii < index; ii++)
+	{
+		lua_rawgeti(lua_state, -1, ii);
+		lua_rawseti(lua_state, dataIdx, ii);
+	}
+	lua_pop(lua_state, 1);
+	lua_setglobal(lua_state, "domoticzData");
 }
@@ -50,6 +50,8 @@ private:
 	bool TriggerCustomEvent(lua_State *lua_state, const std::vector<_tLuaTableValues>& vLuaTable);
 	void ExportHardwareData(CLuaTable &luaTable, int& index, const std::vector<CEventSystem::_tEventQueue>& items);
 	void ExportDomoticzDataToLua(lua_State *lua_state, const std::vector<CEventSystem::_tEventQueue> &items);
+	bool GetCachedEntry(lua_State *lua_state, int cacheIdx, int kind, uint64_t id, uint64_t version);
+	void AddCachedEntry(lua_State *lua_state, int dataIdx, int index, int cacheIdx, int kind, uint64_t id, uint64_t version);
 	void IterateTable(lua_State *lua_state, const int tIndex, std::vector<_tLuaTableValues> &vLuaTable);
 	void SetGlobalVariables(lua_State *lua_state, const bool reasonTime, const int secStatus);
 	void ProcessHttpResponse(lua_State *lua_state, const std::vector<CEventSystem::_tEventQueue> &items);
@@ -6,6 +6,7 @@
 #include "Logger.h"
 #include "WebServerHelper.h"
 #include "SQLHelper.h"
+#include "TrafficCapture.h"
 #include "../push/FibaroPush.h"
 #include "../push/HttpPush.h"
 #include "../push/InfluxPush.h"
@@ -303,7 +304,8 @@ void MainWorker::AddAllDomoticzHardware()
 
 void MainWorker::StartDomoticzHardware()
 {
-	for (const auto &device : m_hardwaredevices)
+	std::shared_ptr<const _tHardwareRegistry> pRegistry = GetHardwareRegistry();
+	for (const auto &device : pRegistry->devices)
 		if (!device->IsStarted())
 			device->Start();
 }
@@ -312,12 +314,11 @@ void MainWorker::StopDomoticzHardware()
 {
 	// Separate the Stop() from the device removal from the vector.
 	// Some actions the hardware might take during stop (e.g updating a device) can cause deadlocks on the m_devicemutex
-	std::vector<CDomoticzHardwareBase*> OrgHardwaredevices;
+	std::vector<std::shared_ptr<CDomoticzHardwareBase>> OrgHardwaredevices;
 	{
 		std::lock_guard<std::mutex> l(m_devicemutex);
-		for (const auto &device : m_hardwaredevices)
-			OrgHardwaredevices.push_back(device);
-		m_hardwaredevices.clear();
+		OrgHardwaredevices.swap(m_hardwaredevices);
+		PublishHardwareRegistry();
 	}
 
 	for (auto &device : OrgHardwaredevices)
@@ -326,7 +327,7 @@ void MainWorker::StopDomoticzHardware()
 		m_pluginsystem.DeregisterPlugin(device->m_HwdID);
 #endif
 		device->Stop();
-		delete device;
+		device.reset();
 	}
 }
 
@@ -348,38 +349,40 @@ void MainWorker::GetAvailableWebThemes()
 
 void MainWorker::AddDomoticzHardware(CDomoticzHardwareBase* pHardware)
 {
-	int devidx = FindDomoticzHardware(pHardware->m_HwdID);
-	if (devidx != -1) //it is already there!, remove it
-		RemoveDomoticzHardware(m_hardwaredevices[devidx]);
+	if (GetHardware(pHardware->m_HwdID)) //it is already there!, remove it
+		RemoveDomoticzHardware(pHardware->m_HwdID);
 	std::lock_guard<std::mutex> l(m_devicemutex);
 	pHardware->sDecodeRXMessage.connect([this](auto hw, auto rx, auto name, auto battery, auto userName) { DecodeRXMessage(hw, rx, name, battery, userName); });
 	pHardware->sOnConnected.connect([this](auto hw) { OnHardwareConnected(hw); });
-	m_hardwaredevices.push_back(pHardware);
+	m_hardwaredevices.push_back(std::shared_ptr<CDomoticzHardwareBase>(pHardware));
+	PublishHardwareRegistry();
 }
 
 void MainWorker::RemoveDomoticzHardware(CDomoticzHardwareBase* pHardware)
 {
 	// Separate the Stop() from the device removal from the vector.
 	// Some actions the hardware might take during stop (e.g updating a device) can cause deadlocks on the m_devicemutex
-	CDomoticzHardwareBase *pOrgHardware = nullptr;
+	std::shared_ptr<CDomoticzHardwareBase> pOrgHardware;
 	{
 		std::lock_guard<std::mutex> l(m_devicemutex);
 		for (auto itt = m_hardwaredevices.begin(); itt != m_hardwaredevices.end(); ++itt)
 		{
-			pOrgHardware = *itt;
-			if (pOrgHardware == pHardware) {
+			if (itt->get() == pHardware) {
+				pOrgHardware = *itt;
 				m_hardwaredevices.erase(itt);
+				PublishHardwareRegistry();
 				break;
 			}
 		}
 	}
 
-	if (pOrgHardware == pHardware)
+	if (pOrgHardware)
 	{
 		try
 		{
 			pOrgHardware->Stop();
-			delete pOrgHardware;
+			// deleted here, or by the last holder of a reference (rx lane, registry snapshot)
+			pOrgHardware.reset();
 		}
 		catch (std::exception& e)
 		{
@@ -394,57 +397,48 @@ void MainWorker::RemoveDomoticzHardware(CDomoticzHardwareBase* pHardware)
 
 void MainWorker::RemoveDomoticzHardware(int HwdId)
 {
-	int dpos = FindDomoticzHardware(HwdId);
-	if (dpos == -1)
+	std::shared_ptr<CDomoticzHardwareBase> pHardware = GetHardware(HwdId);
+	if (!pHardware)
 		return;
 #ifdef ENABLE_PYTHON
 	m_pluginsystem.DeregisterPlugin(HwdId);
 #endif
-	RemoveDomoticzHardware(m_hardwaredevices[dpos]);
+	RemoveDomoticzHardware(pHardware.get());
 }
 
-int MainWorker::FindDomoticzHardware(int HwdId)
+void MainWorker::PublishHardwareRegistry()
 {
-	std::lock_guard<std::mutex> l(m_devicemutex);
-	int ii = 0;
+	std::shared_ptr<_tHardwareRegistry> pRegistry = std::make_shared<_tHardwareRegistry>();
+	pRegistry->devices = m_hardwaredevices;
 	for (const auto &device : m_hardwaredevices)
 	{
-		if (device->m_HwdID == HwdId)
-			return ii;
-		ii++;
+		pRegistry->byID[device->m_HwdID] = device;
+		pRegistry->byType.insert(std::make_pair((int)device->HwdType, device));
 	}
-	return -1;
+	std::atomic_store(&m_hardwareRegistry, std::shared_ptr<const _tHardwareRegistry>(pRegistry));
 }
 
-int MainWorker::FindDomoticzHardwareByType(const _eHardwareTypes HWType)
+std::shared_ptr<const MainWorker::_tHardwareRegistry> MainWorker::GetHardwareRegistry()
 {
-	std::lock_guard<std::mutex> l(m_devicemutex);
-	int ii = 0;
-	for (const auto &device : m_hardwaredevices)
-	{
-		if (device->HwdType == HWType)
-			return ii;
-		ii++;
-	}
-	return -1;
+	std::shared_ptr<const _tHardwareRegistry> pRegistry = std::atomic_load(&m_hardwareRegistry);
+	if (!pRegistry)
+		return std::make_shared<const _tHardwareRegistry>();
+	return pRegistry;
 }
 
-CDomoticzHardwareBase* MainWorker::GetHardware(int HwdId)
+std::shared_ptr<CDomoticzHardwareBase> MainWorker::GetHardware(int HwdId)
 {
-	std::lock_guard<std::mutex> l(m_devicemutex);
-	for (const auto &device : m_hardwaredevices)
-		if (device->m_HwdID == HwdId)
-			return device;
-
-	return nullptr;
+	std::shared_ptr<const _tHardwareRegistry> pRegistry = GetHardwareRegistry();
+	auto itt = pRegistry->byID.find(HwdId);
+	return (itt != pRegistry->byID.end()) ? itt->second : nullptr;
 }
 
-CDomoticzHardwareBase* MainWorker::GetHardwareByIDType(const std::string& HwdId, const _eHardwareTypes HWType)
+std::shared_ptr<CDomoticzHardwareBase> MainWorker::GetHardwareByIDType(const std::string& HwdId, const _eHardwareTypes HWType)
 {
 	if (HwdId.empty())
 		return nullptr;
 	int iHardwareID = atoi(HwdId.c_str());
-	CDomoticzHardwareBase* pHardware = m_mainworker.GetHardware(iHardwareID);
+	std::shared_ptr<CDomoticzHardwareBase> pHardware = GetHardware(iHardwareID);
 	if (pHardware == nullptr)
 		return nullptr;
 	if (pHardware->HwdType != HWType)
@@ -452,13 +446,11 @@ CDomoticzHardwareBase* MainWorker::GetHardwareByIDType(const std::string& HwdId,
 	return pHardware;
 }
 
-CDomoticzHardwareBase* MainWorker::GetHardwareByType(const _eHardwareTypes HWType)
+std::shared_ptr<CDomoticzHardwareBase> MainWorker::GetHardwareByType(const _eHardwareTypes HWType)
 {
-	std::lock_guard<std::mutex> l(m_devicemutex);
-	for (const auto &device : m_hardwaredevices)
-		if (device->HwdType == HWType)
-			return device;
-	return nullptr;
+	std::shared_ptr<const _tHardwareRegistry> pRegistry = GetHardwareRegistry();
+	auto itt = pRegistry->byType.find((int)HWType);
+	return (itt != pRegistry->byType.end()) ? itt->second : nullptr;
 }
 
 // sunset/sunrise
@@ -1116,6 +1108,15 @@ bool MainWorker::Start()
 	{
 		return false;
 	}
+	// a replay starts from an empty database with the recorded hardware
+	m_trafficcapture.RestoreHardware();
+	m_trafficcapture.RecordHardware();
+
+	for (int ii = 0; ii < m_rxLaneCount; ii++)
+	{
+		m_rxLanes.push_back(std::unique_ptr<_tRxLane>(new _tRxLane));
+		m_rxLanes.back()->queue.set_overflow_policy(m_rxQueuePolicy);
+	}
 
 	HTTPClient::SetUserAgent(GenerateUserAgent());
 	m_notifications.Init();
@@ -1189,25 +1190,39 @@ bool MainWorker::Start()
 
 	m_thread = std::make_shared<std::thread>([this] { Do_Work(); });
 	SetThreadName(m_thread->native_handle(), "MainWorker");
-	m_rxMessageThread = std::make_shared<std::thread>([this] { Do_Work_On_Rx_Messages(); });
-	SetThreadName(m_rxMessageThread->native_handle(), "MainWorkerRxMsg");
-	return (m_thread != nullptr) && (m_rxMessageThread != nullptr);
+	for (size_t ii = 0; ii < m_rxLanes.size(); ii++)
+	{
+		_tRxLane *pLane = m_rxLanes[ii].get();
+		pLane->thread = std::make_shared<std::thread>([this, pLane] { Do_Work_On_Rx_Messages(pLane); });
+		SetThreadName(pLane->thread->native_handle(), (m_rxLanes.size() == 1) ? "MainWorkerRxMsg" : std_format("MainWorkerRx%d", (int)ii).c_str());
+	}
+	if (m_rxLanes.size() > 1)
+		_log.Log(LOG_STATUS, "RxQueue: processing received messages on %d lanes", (int)m_rxLanes.size());
+	m_trafficcapture.StartPlayback();
+	return (m_thread != nullptr);
 }
 
 
 bool MainWorker::Stop()
 {
+	m_trafficcapture.Stop();
 	if (m_thread)
 	{
 		m_notificationsystem.NotifyWait(Notification::DZ_STOP, Notification::STATUS_INFO); // blocking call
 	}
 
-	if (m_rxMessageThread) {
-		// Stop RxMessage thread before hardware to avoid NULL pointer exception
+	if (!m_rxLanes.empty()) {
+		// Stop RxMessage threads before hardware to avoid NULL pointer exception
 		m_TaskRXMessage.RequestStop();
 		UnlockRxMessageQueue();
-		m_rxMessageThread->join();
-		m_rxMessageThread.reset();
+		for (auto &pLane : m_rxLanes)
+		{
+			if (pLane->thread)
+			{
+				pLane->thread->join();
+				pLane->thread.reset();
+			}
+		}
 	}
 	if (m_thread)
 	{
@@ -1528,14 +1543,18 @@ void MainWorker::ParseRFXLogFile()
 	int HWID = 999;
 	//m_sql.DeleteHardware("999");
 
-	RFXComTCP* pHardware = (RFXComTCP*)GetHardware(HWID);
-	if (pHardware == NULL)
+	// hold the hardware for as long as it is used, it can be removed from the list meanwhile
+	auto pHardware = std::dynamic_pointer_cast<RFXComTCP>(GetHardware(HWID));
+	if (pHardware == nullptr)
 	{
-		pHardware = new RFXComTCP(HWID, "127.0.0.1", 1234, CRFXBase::ATYPE_P1_DSMR_5);
-		//pHardware->sDecodeRXMessage.connect(boost::bind(&MainWorker::DecodeRXMessage, this, _1, _2, _3, _4, _5));
-		AddDomoticzHardware(pHardware);
-		pHardware->m_bEnableReceive = true;
-		pHardware->m_Name = pHardware->m_ShortName = "RFXCom debug";
+		RFXComTCP *pNewHardware = new RFXComTCP(HWID, "127.0.0.1", 1234, CRFXBase::ATYPE_P1_DSMR_5);
+		//pNewHardware->sDecodeRXMessage.connect(boost::bind(&MainWorker::DecodeRXMessage, this, _1, _2, _3, _4, _5));
+		pNewHardware->m_bEnableReceive = true;
+		pNewHardware->m_Name = pNewHardware->m_ShortName = "RFXCom debug";
+		AddDomoticzHardware(pNewHardware);
+		pHardware = std::dynamic_pointer_cast<RFXComTCP>(GetHardware(HWID));
+		if (pHardware == nullptr)
+			return;
 	}
 
 	unsigned char rxbuffer[600];
@@ -1735,12 +1754,12 @@ void MainWorker::Do_Work()
 				if (ltime.tm_hour == 4)
 				{
 					//Heal the OpenZWave network
-					std::lock_guard<std::mutex> l(m_devicemutex);
-					for (const auto &pHardware : m_hardwaredevices)
+					std::shared_ptr<const _tHardwareRegistry> pRegistry = GetHardwareRegistry();
+					for (const auto &pHardware : pRegistry->devices)
 					{
 						if (pHardware->HwdType == HTYPE_OpenZWave)
 						{
-							COpenZWave* pZWave = dynamic_cast<COpenZWave*>(pHardware);
+							COpenZWave* pZWave = dynamic_cast<COpenZWave*>(pHardware.get());
 							pZWave->NightlyNodeHeal();
 						}
 					}
@@ -1761,12 +1780,11 @@ void MainWorker::Do_Work()
 
 bool MainWorker::WriteToHardware(const int HwdID, const char* pdata, const uint8_t length)
 {
-	int hindex = FindDomoticzHardware(HwdID);
-
-	if (hindex == -1)
+	std::shared_ptr<CDomoticzHardwareBase> pHardware = GetHardware(HwdID);
+	if (pHardware == nullptr)
 		return false;
 
-	return m_hardwaredevices[hindex]->WriteToHardware(pdata, length);
+	return pHardware->WriteToHardware(pdata, length);
 }
 
 void MainWorker::WriteMessageStart()
@@ -1944,12 +1962,12 @@ uint64_t MainWorker::PerformRealActionFromDomoticzClient(const uint8_t* pRXComma
 		{
 			std::vector<std::string> sd = result[0];
 
-			CDomoticzHardwareBase* pHardware = GetHardware(atoi(sd[0].c_str()));
+			std::shared_ptr<CDomoticzHardwareBase> pHardware = GetHardware(atoi(sd[0].c_str()));
 			if (pHardware != nullptr)
 			{
 				if (pHardware->HwdType != HTYPE_Domoticz)
 				{
-					*pOriginalHardware = pHardware;
+					*pOriginalHardware = pHardware.get();
 					pHardware->WriteToHardware((const char*)pRXCommand, pRXCommand[0] + 1);
 					std::stringstream s_strid;
 					s_strid << std::dec << sd[1];
@@ -1986,26 +2004,72 @@ void MainWorker::PushRxMessage(const CDomoticzHardwareBase *pHardware, const uin
 	CheckAndPushRxMessage(pHardware, pRXCommand, defaultName, BatteryLevel, userName, false);
 }
 
-void MainWorker::PushAndWaitRxMessage(const CDomoticzHardwareBase *pHardware, const uint8_t *pRXCommand, const char *defaultName, const int BatteryLevel, const char *userName)
+bool MainWorker::PushAndWaitRxMessage(const CDomoticzHardwareBase *pHardware, const uint8_t *pRXCommand, const char *defaultName, const int BatteryLevel, const char *userName)
 {
 	// Check command, submit it and wait for it to be processed
-	CheckAndPushRxMessage(pHardware, pRXCommand, defaultName, BatteryLevel, userName, true);
+	return CheckAndPushRxMessage(pHardware, pRXCommand, defaultName, BatteryLevel, userName, true);
 }
 
-void MainWorker::CheckAndPushRxMessage(const CDomoticzHardwareBase *pHardware, const uint8_t *pRXCommand, const char *defaultName, const int BatteryLevel, const char *userName, const bool wait)
+void MainWorker::SetRxLaneCount(const int lanes)
+{
+	m_rxLaneCount = std::min(std::max(lanes, 1), RXQUEUE_MAX_LANES);
+}
+
+void MainWorker::SetRxQueueOverflowPolicy(const queue_overflow_policy policy)
+{
+	m_rxQueuePolicy = policy;
+	m_eventsystem.SetQueueOverflowPolicy(policy);
+}
+
+MainWorker::_tRxLane *MainWorker::GetRxLane(const int hardwareId)
+{
+	// The decoders keep state per hardware (and use the hardware object), so all
+	// messages of a hardware are processed by the same lane, one after the other
+	return m_rxLanes[static_cast<size_t>(hardwareId) % m_rxLanes.size()].get();
+}
+
+std::vector<_tRxLaneStats> MainWorker::GetRxLaneStats()
+{
+	std::vector<_tRxLaneStats> ret;
+	for (const auto &pLane : m_rxLanes)
+	{
+		queue_stats qstats = pLane->queue.get_stats();
+		_tRxLaneStats stats;
+		stats.depth = qstats.depth;
+		stats.high_water_mark = qstats.high_water_mark;
+		stats.dropped = qstats.dropped;
+		stats.processed = pLane->processed;
+		stats.total_wait_us = pLane->total_wait_us;
+		stats.total_us = pLane->total_us;
+		stats.max_us = pLane->max_us;
+		ret.push_back(stats);
+	}
+	return ret;
+}
+
+_tTrendCalculator::_eTendencyType MainWorker::GetTrendState(const uint64_t tID)
+{
+	std::lock_guard<std::mutex> l(m_calculator_mutex);
+	auto itt = m_trend_calculator.find(tID);
+	if (itt == m_trend_calculator.end())
+		return _tTrendCalculator::TENDENCY_UNKNOWN;
+	return itt->second.m_state;
+}
+
+bool MainWorker::CheckAndPushRxMessage(const CDomoticzHardwareBase *pHardware, const uint8_t *pRXCommand, const char *defaultName, const int BatteryLevel, const char *userName, const bool wait)
 {
 	if ((pHardware == nullptr) || (pRXCommand == nullptr))
 	{
 		_log.Log(LOG_ERROR, "RxQueue: cannot push message with undefined hardware (%s) or command (%s)",
 			 (pHardware == nullptr) ? "null" : "not null", (pRXCommand == nullptr) ? "null" : "not null");
-		return;
+		return false;
 	}
 	if (pHardware->m_HwdID < 1) {
 		_log.Log(LOG_ERROR, "RxQueue: cannot push message with invalid hardware id (id=%d, type=%d, name=%s)",
 			pHardware->m_HwdID,
 			pHardware->HwdType,
 			pHardware->m_Name.c_str());
-		return;
+		return false;
 	}
 
 	// Build queue item
@@ -2030,10 +2094,11 @@ void MainWorker::CheckAndPushRxMessage(const CDomoticzHardwareBase *pHardware, c
 	rxMessage.crc = crc_ccitt2();
 #endif
 
-	if (m_TaskRXMessage.IsStopRequested(0)) {
-		// Server is stopping
-		return;
+	if ((m_TaskRXMessage.IsStopRequested(0)) || (m_rxLanes.empty())) {
+		// Server is stopping (or not started yet)
+		return false;
 	}
+	_tRxLane *pLane = GetRxLane(pHardware->m_HwdID);
 
 	// Trigger
 	rxMessage.trigger = nullptr; // Should be initialized to NULL if trigger is no used
@@ -2051,30 +2116,48 @@ void MainWorker::CheckAndPushRxMessage(const CDomoticzHardwareBase *pHardware, c
 		pRXCommand[2]);
 #endif
 
-	// Push item to queue
-	m_rxMessageQueue.push(rxMessage);
+	// Push item to queue (the item is moved, keep what we need afterwards)
+	queue_element_trigger* pTrigger = rxMessage.trigger;
+#ifdef DEBUG_RXQUEUE
+	unsigned long rxMessageIdx = rxMessage.rxMessageIdx;
+#endif
+	rxMessage.queued = std::chrono::steady_clock::now();
+	rxMessage.origin = CTrafficCapture::GetOrigin();
+	if (!pLane->queue.push(std::move(rxMessage)))
+	{
+		// counted by the queue, reported by the lane thread
+		if (pTrigger != nullptr)
+		{
+			_log.Log(LOG_ERROR, "RxQueue: queue full, message of hardware %d (%s) not processed", pHardware->m_HwdID, pHardware->m_Name.c_str());
+			delete pTrigger;
+		}
+		return false;
+	}
 
-	if (rxMessage.trigger != nullptr)
+	bool bProcessed = true;
+	if (pTrigger != nullptr)
 	{
 #ifdef DEBUG_RXQUEUE
-		_log.Log(LOG_STATUS, "RxQueue: wait for rxMessage(%lu) to be processed...", rxMessage.rxMessageIdx);
+		_log.Log(LOG_STATUS, "RxQueue: wait for rxMessage(%lu) to be processed...", rxMessageIdx);
 #endif
-		while (!rxMessage.trigger->timed_wait(std::chrono::duration<int>(1))) {
+		while (!pTrigger->timed_wait(std::chrono::duration<int>(1))) {
 #ifdef DEBUG_RXQUEUE
-			_log.Log(LOG_STATUS, "RxQueue: wait 1s for rxMessage(%lu) to be processed...", rxMessage.rxMessageIdx);
+			_log.Log(LOG_STATUS, "RxQueue: wait 1s for rxMessage(%lu) to be processed...", rxMessageIdx);
 #endif
 			if (m_TaskRXMessage.IsStopRequested(0)) {
 				// Server is stopping
+				bProcessed = false;
 				break;
 			}
 		}
 #ifdef DEBUG_RXQUEUE
 		if (moreThanTimeout) {
-			_log.Log(LOG_STATUS, "RxQueue: rxMessage(%lu) processed", rxMessage.rxMessageIdx);
+			_log.Log(LOG_STATUS, "RxQueue: rxMessage(%lu) processed", rxMessageIdx);
 		}
 #endif
-		delete rxMessage.trigger;
+		delete pTrigger;
 	}
+	return bProcessed;
 }
 
 void MainWorker::UnlockRxMessageQueue()
@@ -2082,16 +2165,19 @@ void MainWorker::UnlockRxMessageQueue()
 #ifdef DEBUG_RXQUEUE
 	_log.Log(LOG_STATUS, "RxQueue: unlock queue using dummy message");
 #endif
-	// Push dummy message to unlock queue
-	_tRxQueueItem rxMessage;
-	rxMessage.rxMessageIdx = m_rxMessageIdx++;
-	rxMessage.hardwareId = -1;
-	rxMessage.trigger = nullptr;
-	rxMessage.BatteryLevel = 0;
-	m_rxMessageQueue.push(rxMessage);
+	// Push dummy message to unlock the queue of every lane
+	for (auto &pLane : m_rxLanes)
+	{
+		_tRxQueueItem rxMessage;
+		rxMessage.rxMessageIdx = m_rxMessageIdx++;
+		rxMessage.hardwareId = -1;
+		rxMessage.trigger = nullptr;
+		rxMessage.BatteryLevel = 0;
+		pLane->queue.push(std::move(rxMessage));
+	}
 }
 
-void MainWorker::Do_Work_On_Rx_Messages()
+void MainWorker::Do_Work_On_Rx_Messages(_tRxLane *pLane)
 {
 	_log.Log(LOG_STATUS, "RxQueue: queue worker started...");
 
@@ -2099,7 +2185,7 @@ void MainWorker::Do_Work_On_Rx_Messages()
 	{
 		// Wait and pop next message or timeout
 		_tRxQueueItem rxQItem;
-		bool hasPopped = m_rxMessageQueue.timed_wait_and_pop<std::chrono::duration<int> >(rxQItem, std::chrono::duration<int>(5));
+		bool hasPopped = pLane->queue.timed_wait_and_pop<std::chrono::duration<int> >(rxQItem, std::chrono::duration<int>(5));
 		// (if no message for 5 seconds, returns anyway to check m_TaskRXMessage.IsStopRequested)
 
 		if (!hasPopped) {
@@ -2109,6 +2195,12 @@ void MainWorker::Do_Work_On_Rx_Messages()
 #endif
 			continue;
 		}
+		uint64_t dropped = pLane->queue.get_stats().dropped;
+		if (dropped != pLane->reported_drops)
+		{
+			_log.Log(LOG_ERROR, "RxQueue: queue full, %lu messages dropped", (unsigned long)(dropped - pLane->reported_drops));
+			pLane->reported_drops = dropped;
+		}
 		if (rxQItem.hardwareId == -1) {
 			// dummy message
 #ifdef DEBUG_RXQUEUE
@@ -2124,7 +2216,9 @@ void MainWorker::Do_Work_On_Rx_Messages()
 			continue;
 		}
 
-		const CDomoticzHardwareBase* pHardware = GetHardware(rxQItem.hardwareId);
+		// keep the hardware alive while its message is processed
+		std::shared_ptr<CDomoticzHardwareBase> pHardwareRef = GetHardware(rxQItem.hardwareId);
+		const CDomoticzHardwareBase* pHardware = pHardwareRef.get();
 
 		// Check pointers
 		if (pHardware == nullptr)
@@ -2165,11 +2259,20 @@ void MainWorker::Do_Work_On_Rx_Messages()
 			pRXCommand[1],
 			pRXCommand[2]);
 #endif
+		auto tstart = std::chrono::steady_clock::now();
+		CTrafficCapture::SetOrigin(rxQItem.origin);
 		ProcessRXMessage(pHardware, pRXCommand, rxQItem.Name.c_str(), rxQItem.BatteryLevel, rxQItem.UserName.c_str());
+		CTrafficCapture::SetOrigin(std::chrono::steady_clock::time_point());
 		if (rxQItem.trigger != nullptr)
 		{
 			rxQItem.trigger->popped();
 		}
+		uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - tstart).count();
+		pLane->processed++;
+		pLane->total_wait_us += std::chrono::duration_cast<std::chrono::microseconds>(tstart - rxQItem.queued).count();
+		pLane->total_us += us;
+		if (us > pLane->max_us)
+			pLane->max_us = us;
 	}
 
 	_log.Log(LOG_STATUS, "RxQueue: queue worker stopped...");
@@ -3278,7 +3381,10 @@ void MainWorker::decode_Wind(const CDomoticzHardwareBase* pHardware, const tRBUF
 	//Apply user defined offset
 	dDirection = std::fmod(dDirection + AddjValue2, 360.0);
 
-	dDirection = m_wind_calculator[windID].AddValueAndReturnAvarage(dDirection);
+	{
+		std::lock_guard<std::mutex> l(m_calculator_mutex);
+		dDirection = m_wind_calculator[windID].AddValueAndReturnAvarage(dDirection);
+	}
 
 	std::string strDirection;
 	if (dDirection > 348.75 || dDirection < 11.26)
@@ -3332,7 +3438,10 @@ void MainWorker::decode_Wind(const CDomoticzHardwareBase* pHardware, const tRBUF
 		intSpeed = intGust;
 	}
 
-	m_wind_calculator[windID].SetSpeedGust(intSpeed, intGust);
+	{
+		std::lock_guard<std::mutex> l(m_calculator_mutex);
+		m_wind_calculator[windID].SetSpeedGust(intSpeed, intGust);
+	}
 
 	float temp = 0, chill = 0;
 	if (subType != sTypeWINDNoTempNoChill)
@@ -3402,7 +3511,10 @@ void MainWorker::decode_Wind(const CDomoticzHardwareBase* pHardware, const tRBUF
 	m_notifications.CheckAndHandleNotification(DevRowIdx, pHardware->m_HwdID, ID, procResult.DeviceName, Unit, devType, subType, cmnd, szTmp);
 
 	uint64_t tID = ((uint64_t)(pHardware->m_HwdID & 0x7FFFFFFF) << 32) | (DevRowIdx & 0x7FFFFFFF);
-	m_trend_calculator[tID].AddValueAndReturnTendency(static_cast<double>(chill), _tTrendCalculator::TAVERAGE_TEMP);
+	{
+		std::lock_guard<std::mutex> l(m_calculator_mutex);
+		m_trend_calculator[tID].AddValueAndReturnTendency(static_cast<double>(chill), _tTrendCalculator::TAVERAGE_TEMP);
+	}
 
 	if (_log.IsDebugLevelEnabled(DEBUG_RECEIVED))
 	{
@@ -3541,7 +3653,10 @@ void MainWorker::decode_Temp(const CDomoticzHardwareBase* pHardware, const tRBUF
 		return;
 
 	uint64_t tID = ((uint64_t)(pHardware->m_HwdID & 0x7FFFFFFF) << 32) | (DevRowIdx & 0x7FFFFFFF);
-	m_trend_calculator[tID].AddValueAndReturnTendency(static_cast<double>(temp), _tTrendCalculator::TAVERAGE_TEMP);
+	{
+		std::lock_guard<std::mutex> l(m_calculator_mutex);
+		m_trend_calculator[tID].AddValueAndReturnTendency(static_cast<double>(temp), _tTrendCalculator::TAVERAGE_TEMP);
+	}
 
 	bool bHandledNotification = false;
 	uint8_t humidity = 0;
@@ -3855,7 +3970,10 @@ void MainWorker::decode_TempHum(const CDomoticzHardwareBase* pHardware, const tR
 		return;
 
 	uint64_t tID = ((uint64_t)(pHardware->m_HwdID & 0x7FFFFFFF) << 32) | (DevRowIdx & 0x7FFFFFFF);
-	m_trend_calculator[tID].AddValueAndReturnTendency(static_cast<double>(temp), _tTrendCalculator::TAVERAGE_TEMP);
+	{
+		std::lock_guard<std::mutex> l(m_calculator_mutex);
+		m_trend_calculator[tID].AddValueAndReturnTendency(static_cast<double>(temp), _tTrendCalculator::TAVERAGE_TEMP);
+	}
 
 	m_notifications.CheckAndHandleNotification(DevRowIdx, pHardware->m_HwdID, ID, procResult.DeviceName, Unit, devType, subType, cmnd, szTmp);
 
@@ -4065,7 +4183,10 @@ void MainWorker::decode_TempHumBaro(const CDomoticzHardwareBase* pHardware, cons
 		return;
 
 	uint64_t tID = ((uint64_t)(pHardware->m_HwdID & 0x7FFFFFFF) << 32) | (DevRowIdx & 0x7FFFFFFF);
-	m_trend_calculator[tID].AddValueAndReturnTendency(static_cast<double>(temp), _tTrendCalculator::TAVERAGE_TEMP);
+	{
+		std::lock_guard<std::mutex> l(m_calculator_mutex);
+		m_trend_calculator[tID].AddValueAndReturnTendency(static_cast<double>(temp), _tTrendCalculator::TAVERAGE_TEMP);
+	}
 
 	//calculate Altitude
 	//float seaLevelPressure=101325.0f;
@@ -4201,7 +4322,10 @@ void MainWorker::decode_TempBaro(const CDomoticzHardwareBase* pHardware, const t
 		return;
 
 	uint64_t tID = ((uint64_t)(pHardware->m_HwdID & 0x7FFFFFFF) << 32) | (DevRowIdx & 0x7FFFFFFF);
-	m_trend_calculator[tID].AddValueAndReturnTendency(static_cast<double>(temp), _tTrendCalculator::TAVERAGE_TEMP);
+	{
+		std::lock_guard<std::mutex> l(m_calculator_mutex);
+		m_trend_calculator[tID].AddValueAndReturnTendency(static_cast<double>(temp), _tTrendCalculator::TAVERAGE_TEMP);
+	}
 
 	m_notifications.CheckAndHandleNotification(DevRowIdx, pHardware->m_HwdID, ID, procResult.DeviceName, Unit, devType, subType, cmnd, szTmp);
 
@@ -4305,7 +4429,10 @@ void MainWorker::decode_TempRain(const CDomoticzHardwareBase* pHardware, const t
 		return;
 
 	uint64_t tID = ((uint64_t)(pHardware->m_HwdID & 0x7FFFFFFF) << 32) | (DevRowIdx & 0x7FFFFFFF);
-	m_trend_calculator[tID].AddValueAndReturnTendency(static_cast<double>(temp), _tTrendCalculator::TAVERAGE_TEMP);
+	{
+		std::lock_guard<std::mutex> l(m_calculator_mutex);
+		m_trend_calculator[tID].AddValueAndReturnTendency(static_cast<double>(temp), _tTrendCalculator::TAVERAGE_TEMP);
+	}
 
 	sprintf(szTmp, "%.1f", temp);
 	uint64_t DevRowIdxTemp = m_sql.UpdateValue(pHardware->m_HwdID, ID.c_str(), Unit, pTypeTEMP, sTypeTEMP3, SignalLevel, BatteryLevel, cmnd, szTmp, procResult.DeviceName, true, procResult.Username.c_str());
@@ -11405,29 +11532,11 @@ bool MainWorker::GetSensorData(const uint64_t idx, int& nValue, std::string& sVa
 	{
 		float GasDivider = 1000.0F;
 		//get lowest value of today
-		time_t now = mytime(nullptr);
-		struct tm tm1;
-		localtime_r(&now, &tm1);
-
-		struct tm ltime;
-		ltime.tm_isdst = tm1.tm_isdst;
-		ltime.tm_hour = 0;
-		ltime.tm_min = 0;
-		ltime.tm_sec = 0;
-		ltime.tm_year = tm1.tm_year;
-		ltime.tm_mon = tm1.tm_mon;
-		ltime.tm_mday = tm1.tm_mday;
-
-		char szDate[40];
-		sprintf(szDate, "%04d-%02d-%02d", ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday);
-
-		std::vector<std::vector<std::string> > result2;
 		strcpy(szTmp, "0");
-		result2 = m_sql.safe_query("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q')", idx, szDate);
-		if (!result2.empty())
+		_tTodayCounter counter;
+		if (m_sql.GetTodayCounter("Meter", idx, counter))
 		{
-			std::vector<std::string> sd2 = result2[0];
-			uint64_t total_min_gas = std::stoull(sd2[0].c_str());
+			uint64_t total_min_gas = static_cast<uint64_t>(counter.Min[0]);
 			uint64_t gasactual = std::stoull(sValue);
 			uint64_t total_real_gas = gasactual - total_min_gas;
 			float musage = float(total_real_gas) / GasDivider;
@@ -11460,31 +11569,12 @@ bool MainWorker::GetSensorData(const uint64_t idx, int& nValue, std::string& sVa
 		//}
 
 		//get value of today
-		time_t now = mytime(nullptr);
-		struct tm tm1;
-		localtime_r(&now, &tm1);
-
-		struct tm ltime;
-		ltime.tm_isdst = tm1.tm_isdst;
-		ltime.tm_hour = 0;
-		ltime.tm_min = 0;
-		ltime.tm_sec = 0;
-		ltime.tm_year = tm1.tm_year;
-		ltime.tm_mon = tm1.tm_mon;
-		ltime.tm_mday = tm1.tm_mday;
-
-		char szDate[40];
-		sprintf(szDate, "%04d-%02d-%02d", ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday);
-
-		std::vector<std::vector<std::string> > result2;
 		strcpy(szTmp, "0");
-		result2 = m_sql.safe_query("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q')", idx, szDate);
-		if (!result2.empty())
+		_tTodayCounter counter;
+		if (m_sql.GetTodayCounter("Meter", idx, counter))
 		{
-			std::vector<std::string> sd2 = result2[0];
-
-			uint64_t total_min = std::stoull(sd2[0]);
-			uint64_t total_max = std::stoull(sd2[1]);
+			uint64_t total_min = static_cast<uint64_t>(counter.Min[0]);
+			uint64_t total_max = static_cast<uint64_t>(counter.Max[0]);
 			uint64_t total_real = total_max - total_min;
 			sprintf(szTmp, "%" PRIu64, total_real);
 
@@ -11535,15 +11625,12 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 	_log.Debug(DEBUG_NORM, "MAIN SwitchLightInt : switchcmd:%s level:%d HWid:%d  sd:%s %s %s %s %s %s", switchcmd.c_str(), level, HardwareID,
 		sd[0].c_str(), sd[1].c_str(), sd[2].c_str(), sd[3].c_str(), sd[4].c_str(), sd[5].c_str());
 
-	int hindex = FindDomoticzHardware(HardwareID);
-	if (hindex == -1)
+	std::shared_ptr<CDomoticzHardwareBase> pHardware = GetHardware(HardwareID);
+	if (pHardware == nullptr)
 	{
 		_log.Log(LOG_ERROR, "Switch command not send!, Hardware device disabled or not found!");
 		return false;
 	}
-	CDomoticzHardwareBase* pHardware = GetHardware(HardwareID);
-	if (pHardware == nullptr)
-		return false;
 
 	std::string deviceID = sd[1];
 	int Unit = atoi(sd[2].c_str());
@@ -11689,7 +11776,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 				switchcmd = "Set Color";
 			}
 		}
-		((Plugins::CPlugin*)m_hardwaredevices[hindex])->SendCommand(sd[1], Unit, switchcmd, level, color);
+		((Plugins::CPlugin*)pHardware.get())->SendCommand(sd[1], Unit, switchcmd, level, color);
 #endif
 		return true;
 	}
@@ -11700,7 +11787,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		{
 			switchcmd = "Set Color";
 		}
-		return ((MQTTAutoDiscover*)m_hardwaredevices[hindex])->SendSwitchCommand(sd[1], sd[9], Unit, switchcmd, level, color, User);
+		return ((MQTTAutoDiscover*)pHardware.get())->SendSwitchCommand(sd[1], sd[9], Unit, switchcmd, level, color, User);
 	}
 
 	switch (dType)
@@ -11711,7 +11798,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		lcmd.LIGHTING1.packetlength = sizeof(lcmd.LIGHTING1) - 1;
 		lcmd.LIGHTING1.packettype = dType;
 		lcmd.LIGHTING1.subtype = dSubType;
-		lcmd.LIGHTING1.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		lcmd.LIGHTING1.seqnbr = pHardware->m_SeqNr++;
 		lcmd.LIGHTING1.housecode = atoi(sd[1].c_str());
 		lcmd.LIGHTING1.unitcode = Unit;
 		lcmd.LIGHTING1.filler = 0;
@@ -11733,7 +11820,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 			return false;
 		if (!IsTesting) {
 			//send to internal for now (later we use the ACK)
-			PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 		}
 		return true;
 	}
@@ -11744,7 +11831,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		lcmd.LIGHTING2.packetlength = sizeof(lcmd.LIGHTING2) - 1;
 		lcmd.LIGHTING2.packettype = dType;
 		lcmd.LIGHTING2.subtype = dSubType;
-		lcmd.LIGHTING2.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		lcmd.LIGHTING2.seqnbr = pHardware->m_SeqNr++;
 		lcmd.LIGHTING2.id1 = ID1;
 		lcmd.LIGHTING2.id2 = ID2;
 		lcmd.LIGHTING2.id3 = ID3;
@@ -11798,7 +11885,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 
 		if ((pHardware->HwdType == HTYPE_EnOceanESP2) && (IsTesting) && (switchtype == STYPE_Dimmer))
 		{ // Special Teach-In for EnOcean ESP2 dimmers
-			CEnOceanESP2* pEnocean = dynamic_cast<CEnOceanESP2*>(pHardware);
+			CEnOceanESP2* pEnocean = dynamic_cast<CEnOceanESP2*>(pHardware.get());
 			pEnocean->SendDimmerTeachIn((const char*)&lcmd, sizeof(lcmd.LIGHTING1));
 		}
 		else if (switchtype != STYPE_Motion)
@@ -11809,7 +11896,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 
 		if (!IsTesting)
 		{ //send to internal for now (later we use the ACK)
-			PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 		}
 		return true;
 	}
@@ -11826,7 +11913,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		lcmd.LIGHTING4.packetlength = sizeof(lcmd.LIGHTING4) - 1;
 		lcmd.LIGHTING4.packettype = dType;
 		lcmd.LIGHTING4.subtype = dSubType;
-		lcmd.LIGHTING4.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		lcmd.LIGHTING4.seqnbr = pHardware->m_SeqNr++;
 		lcmd.LIGHTING4.cmd1 = ID2;
 		lcmd.LIGHTING4.cmd2 = ID3;
 		lcmd.LIGHTING4.cmd3 = ID4;
@@ -11846,7 +11933,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 				return false;
 			if (!IsTesting) {
 				//send to internal for now (later we use the ACK)
-				PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+				PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 			}
 			return true;
 		}
@@ -11859,7 +11946,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		lcmd.LIGHTING5.packetlength = sizeof(lcmd.LIGHTING5) - 1;
 		lcmd.LIGHTING5.packettype = dType;
 		lcmd.LIGHTING5.subtype = dSubType;
-		lcmd.LIGHTING5.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		lcmd.LIGHTING5.seqnbr = pHardware->m_SeqNr++;
 		lcmd.LIGHTING5.id1 = ID2;
 		lcmd.LIGHTING5.id2 = ID3;
 		lcmd.LIGHTING5.id3 = ID4;
@@ -11965,7 +12052,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		}
 		if (!IsTesting) {
 			//send to internal for now (later we use the ACK)
-			PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 		}
 		return true;
 	}
@@ -11976,13 +12063,13 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		lcmd.LIGHTING6.packetlength = sizeof(lcmd.LIGHTING6) - 1;
 		lcmd.LIGHTING6.packettype = dType;
 		lcmd.LIGHTING6.subtype = dSubType;
-		lcmd.LIGHTING6.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		lcmd.LIGHTING6.seqnbr = pHardware->m_SeqNr++;
 		lcmd.LIGHTING6.seqnbr2 = 0;
 		lcmd.LIGHTING6.id1 = ID2;
 		lcmd.LIGHTING6.id2 = ID3;
 		lcmd.LIGHTING6.groupcode = ID4;
 		lcmd.LIGHTING6.unitcode = Unit;
-		lcmd.LIGHTING6.cmndseqnbr = m_hardwaredevices[hindex]->m_SeqNr % 4;
+		lcmd.LIGHTING6.cmndseqnbr = pHardware->m_SeqNr % 4;
 		lcmd.LIGHTING6.filler = 0;
 		lcmd.LIGHTING6.rssi = 12;
 
@@ -11992,7 +12079,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 			return false;
 		if (!IsTesting) {
 			//send to internal for now (later we use the ACK)
-			PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 		}
 		return true;
 	}
@@ -12003,7 +12090,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		lcmd.FS20.packetlength = sizeof(lcmd.FS20) - 1;
 		lcmd.FS20.packettype = dType;
 		lcmd.FS20.subtype = dSubType;
-		lcmd.FS20.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		lcmd.FS20.seqnbr = pHardware->m_SeqNr++;
 		lcmd.FS20.hc1 = ID3;
 		lcmd.FS20.hc2 = ID4;
 		lcmd.FS20.addr = Unit;
@@ -12027,7 +12114,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 
 		if (!IsTesting) {
 			//send to internal for now (later we use the ACK)
-			PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 		}
 		return true;
 	}
@@ -12038,7 +12125,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		lcmd.HOMECONFORT.packetlength = sizeof(lcmd.HOMECONFORT) - 1;
 		lcmd.HOMECONFORT.packettype = dType;
 		lcmd.HOMECONFORT.subtype = dSubType;
-		lcmd.HOMECONFORT.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		lcmd.HOMECONFORT.seqnbr = pHardware->m_SeqNr++;
 		lcmd.HOMECONFORT.id1 = ID1;
 		lcmd.HOMECONFORT.id2 = ID2;
 		lcmd.HOMECONFORT.id3 = ID3;
@@ -12053,7 +12140,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 			return false;
 		if (!IsTesting) {
 			//send to internal for now (later we use the ACK)
-			PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 		}
 		return true;
 	}
@@ -12064,7 +12151,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		lcmd.FAN.packetlength = sizeof(lcmd.FAN) - 1;
 		lcmd.FAN.packettype = dType;
 		lcmd.FAN.subtype = dSubType;
-		lcmd.FAN.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		lcmd.FAN.seqnbr = pHardware->m_SeqNr++;
 		lcmd.FAN.id1 = ID2;
 		lcmd.FAN.id2 = ID3;
 		lcmd.FAN.id3 = ID4;
@@ -12077,7 +12164,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 			return false;
 		if (!IsTesting) {
 			//send to internal for now (later we use the ACK)
-			PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 		}
 		return true;
 	}
@@ -12107,7 +12194,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 			return false;
 		if (!IsTesting) {
 			//send to internal for now (later we use the ACK)
-			PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 		}
 		return true;
 	}
@@ -12118,7 +12205,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		lcmd.SECURITY1.packetlength = sizeof(lcmd.SECURITY1) - 1;
 		lcmd.SECURITY1.packettype = dType;
 		lcmd.SECURITY1.subtype = dSubType;
-		lcmd.SECURITY1.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		lcmd.SECURITY1.seqnbr = pHardware->m_SeqNr++;
 		lcmd.SECURITY1.battery_level = 9;
 		lcmd.SECURITY1.id1 = ID2;
 		lcmd.SECURITY1.id2 = ID3;
@@ -12139,7 +12226,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 				return false;
 			if (!IsTesting) {
 				//send to internal for now (later we use the ACK)
-				PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+				PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 			}
 		}
 		break;
@@ -12154,7 +12241,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 				return false;
 			if (!IsTesting) {
 				//send to internal for now (later we use the ACK)
-				PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+				PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 			}
 		}
 		break;
@@ -12183,7 +12270,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		lcmd.SECURITY2.packetlength = sizeof(lcmd.SECURITY2) - 1;
 		lcmd.SECURITY2.packettype = dType;
 		lcmd.SECURITY2.subtype = dSubType;
-		lcmd.SECURITY2.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		lcmd.SECURITY2.seqnbr = pHardware->m_SeqNr++;
 		lcmd.SECURITY2.id1 = kCodes[0];
 		lcmd.SECURITY2.id2 = kCodes[1];
 		lcmd.SECURITY2.id3 = kCodes[2];
@@ -12201,7 +12288,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 			return false;
 		if (!IsTesting) {
 			//send to internal for now (later we use the ACK)
-			PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 		}
 		return true;
 	}
@@ -12226,7 +12313,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		lcmd.HUNTER.packetlength = sizeof(lcmd.HUNTER) - 1;
 		lcmd.HUNTER.packettype = dType;
 		lcmd.HUNTER.subtype = dSubType;
-		lcmd.HUNTER.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		lcmd.HUNTER.seqnbr = pHardware->m_SeqNr++;
 		lcmd.HUNTER.id1 = kCodes[0];
 		lcmd.HUNTER.id2 = kCodes[1];
 		lcmd.HUNTER.id3 = kCodes[2];
@@ -12241,7 +12328,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 			return false;
 		if (!IsTesting) {
 			//send to internal for now (later we use the ACK)
-			PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 		}
 		return true;
 	}
@@ -12252,7 +12339,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		lcmd.CURTAIN1.packetlength = sizeof(lcmd.CURTAIN1) - 1;
 		lcmd.CURTAIN1.packettype = dType;
 		lcmd.CURTAIN1.subtype = dSubType;
-		lcmd.CURTAIN1.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		lcmd.CURTAIN1.seqnbr = pHardware->m_SeqNr++;
 		lcmd.CURTAIN1.housecode = atoi(sd[1].c_str());
 		lcmd.CURTAIN1.unitcode = Unit;
 		if (!GetLightCommand(dType, dSubType, switchtype, switchcmd, lcmd.CURTAIN1.cmnd, options))
@@ -12263,7 +12350,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 			return false;
 		if (!IsTesting) {
 			//send to internal for now (later we use the ACK)
-			PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 		}
 		return true;
 	}
@@ -12274,7 +12361,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		lcmd.BLINDS1.packetlength = sizeof(lcmd.BLINDS1) - 1;
 		lcmd.BLINDS1.packettype = dType;
 		lcmd.BLINDS1.subtype = dSubType;
-		lcmd.BLINDS1.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		lcmd.BLINDS1.seqnbr = pHardware->m_SeqNr++;
 		lcmd.BLINDS1.id1 = ID1;
 		lcmd.BLINDS1.id2 = ID2;
 		lcmd.BLINDS1.id3 = ID3;
@@ -12313,7 +12400,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 			return false;
 		if (!IsTesting) {
 			//send to internal for now (later we use the ACK)
-			PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 		}
 		return true;
 	}
@@ -12327,7 +12414,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		lcmd.RFY.id1 = ID2;
 		lcmd.RFY.id2 = ID3;
 		lcmd.RFY.id3 = ID4;
-		lcmd.RFY.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		lcmd.RFY.seqnbr = pHardware->m_SeqNr++;
 		lcmd.RFY.unitcode = Unit;
 
 		if (IsTesting)
@@ -12357,7 +12444,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 			return false;
 		if (!IsTesting) {
 			//send to internal for now (later we use the ACK)
-			PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 		}
 		return true;
 	}
@@ -12369,7 +12456,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		lcmd.CHIME.packetlength = sizeof(lcmd.CHIME) - 1;
 		lcmd.CHIME.packettype = dType;
 		lcmd.CHIME.subtype = dSubType;
-		lcmd.CHIME.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		lcmd.CHIME.seqnbr = pHardware->m_SeqNr++;
 		if (dSubType == sTypeByronBY)
 		{
 			lcmd.CHIME.id1 = ID2;
@@ -12388,7 +12475,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 			return false;
 		if (!IsTesting) {
 			//send to internal for now (later we use the ACK)
-			PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 		}
 		return true;
 	}
@@ -12401,7 +12488,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		lcmd.THERMOSTAT2.subtype = dSubType;
 		lcmd.THERMOSTAT2.unitcode = Unit;
 		lcmd.THERMOSTAT2.cmnd = Unit;
-		lcmd.THERMOSTAT2.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		lcmd.THERMOSTAT2.seqnbr = pHardware->m_SeqNr++;
 
 		if (!GetLightCommand(dType, dSubType, switchtype, switchcmd, lcmd.THERMOSTAT2.cmnd, options))
 			return false;
@@ -12412,7 +12499,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 			return false;
 		if (!IsTesting) {
 			//send to internal for now (later we use the ACK)
-			PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 		}
 		return true;
 	}
@@ -12426,7 +12513,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		lcmd.THERMOSTAT3.unitcode1 = ID2;
 		lcmd.THERMOSTAT3.unitcode2 = ID3;
 		lcmd.THERMOSTAT3.unitcode3 = ID4;
-		lcmd.THERMOSTAT3.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		lcmd.THERMOSTAT3.seqnbr = pHardware->m_SeqNr++;
 		if (!GetLightCommand(dType, dSubType, switchtype, switchcmd, lcmd.THERMOSTAT3.cmnd, options))
 			return false;
 		level = 15;
@@ -12436,7 +12523,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 			return false;
 		if (!IsTesting) {
 			//send to internal for now (later we use the ACK)
-			PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 		}
 		return true;
 	}
@@ -12452,7 +12539,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		lcmd.THERMOSTAT4.unitcode1 = ID2;
 		lcmd.THERMOSTAT4.unitcode2 = ID3;
 		lcmd.THERMOSTAT4.unitcode3 = ID4;
-		lcmd.THERMOSTAT4.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		lcmd.THERMOSTAT4.seqnbr = pHardware->m_SeqNr++;
 		if (!GetLightCommand(dType, dSubType, switchtype, switchcmd, lcmd.THERMOSTAT4.mode, options))
 		return false;
 		level = 15;
@@ -12462,7 +12549,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		return false;
 		if (!IsTesting) {
 		//send to internal for now (later we use the ACK)
-		PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, NULL, -1);
+		PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, NULL, -1);
 		}
 		*/
 		return true;
@@ -12477,14 +12564,14 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		lcmd.REMOTE.id = ID4;
 		lcmd.REMOTE.cmnd = Unit;
 		lcmd.REMOTE.cmndtype = 0;
-		lcmd.REMOTE.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		lcmd.REMOTE.seqnbr = pHardware->m_SeqNr++;
 		lcmd.REMOTE.toggle = 0;
 		lcmd.REMOTE.rssi = 12;
 		if (!WriteToHardware(HardwareID, (const char*)&lcmd, sizeof(lcmd.REMOTE)))
 			return false;
 		if (!IsTesting) {
 			//send to internal for now (later we use the ACK)
-			PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 		}
 		return true;
 	}
@@ -12507,7 +12594,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 			return false;
 		if (!IsTesting) {
 			//send to internal for now (later we use the ACK)
-			PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, User.c_str());
 		}
 		return true;
 	}
@@ -12518,7 +12605,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		lcmd.RADIATOR1.packetlength = sizeof(lcmd.RADIATOR1) - 1;
 		lcmd.RADIATOR1.packettype = pTypeRadiator1;
 		lcmd.RADIATOR1.subtype = sTypeSmartwares;
-		lcmd.RADIATOR1.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		lcmd.RADIATOR1.seqnbr = pHardware->m_SeqNr++;
 		lcmd.RADIATOR1.id1 = ID1;
 		lcmd.RADIATOR1.id2 = ID2;
 		lcmd.RADIATOR1.id3 = ID3;
@@ -12538,7 +12625,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		if (!IsTesting) {
 			//send to internal for now (later we use the ACK)
 			lcmd.RADIATOR1.subtype = sTypeSmartwaresSwitchRadiator;
-			PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t*)&lcmd, nullptr, -1, User.c_str());
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t*)&lcmd, nullptr, -1, User.c_str());
 		}
 		return true;
 	}
@@ -12548,7 +12635,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		_tGeneralSwitch gswitch;
 		gswitch.type = dType;
 		gswitch.subtype = dSubType;
-		gswitch.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+		gswitch.seqnbr = pHardware->m_SeqNr++;
 		gswitch.id = ID;
 		gswitch.unitcode = Unit;
 
@@ -12619,7 +12706,7 @@ bool MainWorker::SwitchLightInt(const std::vector<std::string>& sd, std::string
 		}
 		if (!IsTesting) {
 			//send to internal for now (later we use the ACK)
-			PushAndWaitRxMessage(m_hardwaredevices[hindex], (const uint8_t *)&gswitch, nullptr, -1, User.c_str());
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&gswitch, nullptr, -1, User.c_str());
 		}
 	}
 	return true;
@@ -12657,16 +12744,12 @@ bool MainWorker::SwitchEvoModal(const std::string& idx, const std::string& statu
 		return false;//FIXME not an error ... status = (already set)
 
 	int HardwareID = atoi(sd[0].c_str());
-	int hindex = FindDomoticzHardware(HardwareID);
-	if (hindex == -1)
-		return false;
-
 	//uint8_t Unit = atoi(sd[2].c_str());
 	//uint8_t dType = atoi(sd[3].c_str());
 	//uint8_t dSubType = atoi(sd[4].c_str());
 	//_eSwitchType switchtype = (_eSwitchType)atoi(sd[5].c_str());
 
-	CDomoticzHardwareBase* pHardware = GetHardware(HardwareID);
+	std::shared_ptr<CDomoticzHardwareBase> pHardware = GetHardware(HardwareID);
 	if (pHardware == nullptr)
 		return false;
 
@@ -12695,7 +12778,7 @@ bool MainWorker::SwitchEvoModal(const std::string& idx, const std::string& statu
 	WriteToHardware(HardwareID, (const char*)&tsen, sizeof(_tEVOHOME1));
 
 	//the latency on the scripted solution is quite bad so it's good to see the update happening...ideally this would go to an 'updating' status (also useful to update database if we ever use this as a pure virtual device)
-	PushRxMessage(pHardware, (const uint8_t *)&tsen, nullptr, 255, nullptr);
+	PushRxMessage(pHardware.get(), (const uint8_t *)&tsen, nullptr, 255, nullptr);
 	return true;
 }
 
@@ -12733,7 +12816,7 @@ bool MainWorker::SwitchLight(const uint64_t idx, const std::string& switchcmd, c
 
 	//std::string sOptions = sd[10].c_str();
 	// ----------- If needed convert to GeneralSwitch type (for o.a. RFlink) -----------
-	CDomoticzHardwareBase *pBaseHardware = m_mainworker.GetHardware(atoi(hwdid.c_str()));
+	std::shared_ptr<CDomoticzHardwareBase> pBaseHardware = m_mainworker.GetHardware(atoi(hwdid.c_str()));
 	if (pBaseHardware != nullptr)
 	{
 		if (pBaseHardware->HwdType == HTYPE_ZIBLUEUSB || pBaseHardware->HwdType == HTYPE_ZIBLUETCP)
@@ -12783,11 +12866,7 @@ bool MainWorker::SetSetPoint(const std::string& idx, const float TempValue, cons
 
 	std::vector<std::string> sd = result[0];
 	int HardwareID = atoi(sd[0].c_str());
-	int hindex = FindDomoticzHardware(HardwareID);
-	if (hindex == -1)
-		return false;
-
-	CDomoticzHardwareBase* pHardware = GetHardware(HardwareID);
+	std::shared_ptr<CDomoticzHardwareBase> pHardware = GetHardware(HardwareID);
 	if (pHardware == nullptr)
 		return false;
 
@@ -12842,7 +12921,7 @@ bool MainWorker::SetSetPoint(const std::string& idx, const float TempValue, cons
 			tsen.controllermode = atoi(sd[2].c_str());
 		}
 		//the latency on the scripted solution is quite bad so it's good to see the update happening...ideally this would go to an 'updating' status (also useful to update database if we ever use this as a pure virtual device)
-		PushAndWaitRxMessage(pHardware, (const uint8_t *)&tsen, nullptr, -1, nullptr);
+		PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&tsen, nullptr, -1, nullptr);
 	}
 	return true;
 }
@@ -12864,11 +12943,7 @@ bool MainWorker::SetSetPoint(const std::string& idx, const float TempValue)
 bool MainWorker::SetSetPointInt(const std::vector<std::string>& sd, const float TempValue)
 {
 	int HardwareID = atoi(sd[0].c_str());
-	int hindex = FindDomoticzHardware(HardwareID);
-	if (hindex == -1)
-		return false;
-
-	CDomoticzHardwareBase *pHardware = GetHardware(HardwareID);
+	std::shared_ptr<CDomoticzHardwareBase> pHardware = GetHardware(HardwareID);
 	if (pHardware == nullptr)
 		return false;
 
@@ -12929,62 +13004,62 @@ bool MainWorker::SetSetPointInt(const std::vector<std::string>& sd, const float
 	{
 		if (pHardware->HwdType == HTYPE_OpenThermGateway)
 		{
-			OTGWSerial* pGateway = dynamic_cast<OTGWSerial*>(pHardware);
+			OTGWSerial* pGateway = dynamic_cast<OTGWSerial*>(pHardware.get());
 			pGateway->SetSetpoint(ID4, TempValue);
 		}
 		else if (pHardware->HwdType == HTYPE_OpenThermGatewayTCP)
 		{
-			OTGWTCP* pGateway = dynamic_cast<OTGWTCP*>(pHardware);
+			OTGWTCP* pGateway = dynamic_cast<OTGWTCP*>(pHardware.get());
 			pGateway->SetSetpoint(ID4, TempValue);
 		}
 		else if (pHardware->HwdType == HTYPE_ICYTHERMOSTAT)
 		{
-			CICYThermostat* pGateway = dynamic_cast<CICYThermostat*>(pHardware);
+			CICYThermostat* pGateway = dynamic_cast<CICYThermostat*>(pHardware.get());
 			pGateway->SetSetpoint(ID4, TempValue);
 		}
 		else if (pHardware->HwdType == HTYPE_TOONTHERMOSTAT)
 		{
-			CToonThermostat* pGateway = dynamic_cast<CToonThermostat*>(pHardware);
+			CToonThermostat* pGateway = dynamic_cast<CToonThermostat*>(pHardware.get());
 			pGateway->SetSetpoint(ID4, TempValue);
 		}
 		else if (pHardware->HwdType == HTYPE_AtagOne)
 		{
-			CAtagOne* pGateway = dynamic_cast<CAtagOne*>(pHardware);
+			CAtagOne* pGateway = dynamic_cast<CAtagOne*>(pHardware.get());
 			pGateway->SetSetpoint(ID4, TempValue);
 		}
 		else if (pHardware->HwdType == HTYPE_NEST)
 		{
-			CNest* pGateway = dynamic_cast<CNest*>(pHardware);
+			CNest* pGateway = dynamic_cast<CNest*>(pHardware.get());
 			pGateway->SetSetpoint(ID4, TempValue);
 		}
 		else if (pHardware->HwdType == HTYPE_Nest_OAuthAPI)
 		{
-			CNestOAuthAPI* pGateway = dynamic_cast<CNestOAuthAPI*>(pHardware);
+			CNestOAuthAPI* pGateway = dynamic_cast<CNestOAuthAPI*>(pHardware.get());
 			pGateway->SetSetpoint(ID4, TempValue);
 		}
 		else if (pHardware->HwdType == HTYPE_ANNATHERMOSTAT)
 		{
-			CAnnaThermostat* pGateway = dynamic_cast<CAnnaThermostat*>(pHardware);
+			CAnnaThermostat* pGateway = dynamic_cast<CAnnaThermostat*>(pHardware.get());
 			pGateway->SetSetpoint(ID4, TempValue);
 		}
 		else if (pHardware->HwdType == HTYPE_THERMOSMART)
 		{
-			CThermosmart* pGateway = dynamic_cast<CThermosmart*>(pHardware);
+			CThermosmart* pGateway = dynamic_cast<CThermosmart*>(pHardware.get());
 			pGateway->SetSetpoint(ID4, TempValue);
 		}
 		else if (pHardware->HwdType == HTYPE_Tado)
 		{
-			CTado* pGateway = dynamic_cast<CTado*>(pHardware);
+			CTado* pGateway = dynamic_cast<CTado*>(pHardware.get());
 			pGateway->SetSetpoint(ID2, ID3, ID4, TempValue);
 		}
 		else if (pHardware->HwdType == HTYPE_Netatmo)
 		{
-			CNetatmo* pGateway = dynamic_cast<CNetatmo*>(pHardware);
+			CNetatmo* pGateway = dynamic_cast<CNetatmo*>(pHardware.get());
 			pGateway->SetSetpoint(ID, TempValue);
 		}
 		else if (pHardware->HwdType == HTYPE_NefitEastLAN)
 		{
-			CNefitEasy* pGateway = dynamic_cast<CNefitEasy*>(pHardware);
+			CNefitEasy* pGateway = dynamic_cast<CNefitEasy*>(pHardware.get());
 			pGateway->SetSetpoint(ID2, TempValue);
 		}
 		else if (pHardware->HwdType == HTYPE_EVOHOME_SCRIPT || pHardware->HwdType == HTYPE_EVOHOME_SERIAL || pHardware->HwdType == HTYPE_EVOHOME_WEB || pHardware->HwdType == HTYPE_EVOHOME_TCP)
@@ -12993,17 +13068,17 @@ bool MainWorker::SetSetPointInt(const std::vector<std::string>& sd, const float
 		}
 		else if (pHardware->HwdType == HTYPE_IntergasInComfortLAN2RF)
 		{
-			CInComfort* pGateway = dynamic_cast<CInComfort*>(pHardware);
+			CInComfort* pGateway = dynamic_cast<CInComfort*>(pHardware.get());
 			pGateway->SetSetpoint(ID4, TempValue);
 		}
 		else if (pHardware->HwdType == HTYPE_OpenWebNetTCP)
 		{
-			COpenWebNetTCP* pGateway = dynamic_cast<COpenWebNetTCP*>(pHardware);
+			COpenWebNetTCP* pGateway = dynamic_cast<COpenWebNetTCP*>(pHardware.get());
 			ret = pGateway->SetSetpoint(ID, TempValue);
 		}
 		else if (pHardware->HwdType == HTYPE_MQTTAutoDiscovery)
 		{
-			MQTTAutoDiscover *pGateway = dynamic_cast<MQTTAutoDiscover*>(pHardware);
+			MQTTAutoDiscover *pGateway = dynamic_cast<MQTTAutoDiscover*>(pHardware.get());
 			return pGateway->SetSetpoint(sd[1], TempValue);
 		}
 	}
@@ -13015,7 +13090,7 @@ bool MainWorker::SetSetPointInt(const std::vector<std::string>& sd, const float
 			lcmd.RADIATOR1.packetlength = sizeof(lcmd.RADIATOR1) - 1;
 			lcmd.RADIATOR1.packettype = dType;
 			lcmd.RADIATOR1.subtype = dSubType;
-			lcmd.RADIATOR1.seqnbr = m_hardwaredevices[hindex]->m_SeqNr++;
+			lcmd.RADIATOR1.seqnbr = pHardware->m_SeqNr++;
 			lcmd.RADIATOR1.id1 = ID1;
 			lcmd.RADIATOR1.id2 = ID2;
 			lcmd.RADIATOR1.id3 = ID3;
@@ -13033,7 +13108,7 @@ bool MainWorker::SetSetPointInt(const std::vector<std::string>& sd, const float
 			lcmd.RADIATOR1.tempPoint5 = (uint8_t)atoi(strarray[1].c_str());
 			if (!WriteToHardware(HardwareID, (const char*)&lcmd, sizeof(lcmd.RADIATOR1)))
 				return false;
-			PushAndWaitRxMessage(pHardware, (const uint8_t *)&lcmd, nullptr, -1, nullptr);
+			PushAndWaitRxMessage(pHardware.get(), (const uint8_t *)&lcmd, nullptr, -1, nullptr);
 			return true;
 		}
 		else
@@ -13045,7 +13120,7 @@ bool MainWorker::SetSetPointInt(const std::vector<std::string>& sd, const float
 	if (!ret)
 		return false;
 	//Also put it in the database, not all devices are awake (battery operated nodes)
-	PushAndWaitRxMessage(pHardware, (const uint8_t*)&tmeter, nullptr, -1, nullptr);
+	PushAndWaitRxMessage(pHardware.get(), (const uint8_t*)&tmeter, nullptr, -1, nullptr);
 	return true;
 }
 
@@ -13053,15 +13128,11 @@ bool MainWorker::SetClockInt(const std::vector<std::string>& sd, const std::stri
 {
 #ifdef WITH_OPENZWAVE
 	int HardwareID = atoi(sd[0].c_str());
-	int hindex = FindDomoticzHardware(HardwareID);
-	if (hindex == -1)
-		return false;
-
 	unsigned long ID;
 	std::stringstream s_strid;
 	s_strid << std::hex << sd[1];
 	s_strid >> ID;
-	CDomoticzHardwareBase* pHardware = GetHardware(HardwareID);
+	std::shared_ptr<CDomoticzHardwareBase> pHardware = GetHardware(HardwareID);
 	if (pHardware == nullptr)
 		return false;
 	if (pHardware->HwdType == HTYPE_OpenZWave)
@@ -13103,15 +13174,11 @@ bool MainWorker::SetZWaveThermostatModeInt(const std::vector<std::string>& sd, c
 {
 #ifdef WITH_OPENZWAVE
 	int HardwareID = atoi(sd[0].c_str());
-	int hindex = FindDomoticzHardware(HardwareID);
-	if (hindex == -1)
-		return false;
-
 	unsigned long ID;
 	std::stringstream s_strid;
 	s_strid << std::hex << sd[1];
 	s_strid >> ID;
-	CDomoticzHardwareBase* pHardware = GetHardware(HardwareID);
+	std::shared_ptr<CDomoticzHardwareBase> pHardware = GetHardware(HardwareID);
 	if (pHardware == nullptr)
 		return false;
 	if (pHardware->HwdType == HTYPE_OpenZWave)
@@ -13131,15 +13198,11 @@ bool MainWorker::SetZWaveThermostatFanModeInt(const std::vector<std::string>& sd
 {
 #ifdef WITH_OPENZWAVE
 	int HardwareID = atoi(sd[0].c_str());
-	int hindex = FindDomoticzHardware(HardwareID);
-	if (hindex == -1)
-		return false;
-
 	unsigned long ID;
 	std::stringstream s_strid;
 	s_strid << std::hex << sd[1];
 	s_strid >> ID;
-	CDomoticzHardwareBase* pHardware = GetHardware(HardwareID);
+	std::shared_ptr<CDomoticzHardwareBase> pHardware = GetHardware(HardwareID);
 	if (pHardware == nullptr)
 		return false;
 	if (pHardware->HwdType == HTYPE_OpenZWave)
@@ -13193,59 +13256,55 @@ bool MainWorker::SetThermostatState(const std::string& idx, const int newState)
 	if (result.empty())
 		return false;
 	int HardwareID = atoi(result[0][0].c_str());
-	int hindex = FindDomoticzHardware(HardwareID);
-	if (hindex == -1)
-		return false;
-
-	CDomoticzHardwareBase* pHardware = GetHardware(HardwareID);
+	std::shared_ptr<CDomoticzHardwareBase> pHardware = GetHardware(HardwareID);
 	if (pHardware == nullptr)
 		return false;
 	if (pHardware->HwdType == HTYPE_TOONTHERMOSTAT)
 	{
-		CToonThermostat* pGateway = dynamic_cast<CToonThermostat*>(pHardware);
+		CToonThermostat* pGateway = dynamic_cast<CToonThermostat*>(pHardware.get());
 		pGateway->SetProgramState(newState);
 		return true;
 	}
 	if (pHardware->HwdType == HTYPE_AtagOne)
 	{
-		//CAtagOne *pGateway = dynamic_cast<CAtagOne*>(pHardware);
+		//CAtagOne *pGateway = dynamic_cast<CAtagOne*>(pHardware.get());
 		//pGateway->SetProgramState(newState);
 		return true;
 	}
 	if (pHardware->HwdType == HTYPE_NEST)
 	{
-		CNest* pGateway = dynamic_cast<CNest*>(pHardware);
+		CNest* pGateway = dynamic_cast<CNest*>(pHardware.get());
 		pGateway->SetProgramState(newState);
 		return true;
 	}
 	if (pHardware->HwdType == HTYPE_Nest_OAuthAPI)
 	{
-		CNestOAuthAPI* pGateway = dynamic_cast<CNestOAuthAPI*>(pHardware);
+		CNestOAuthAPI* pGateway = dynamic_cast<CNestOAuthAPI*>(pHardware.get());
 		pGateway->SetProgramState(newState);
 		return true;
 	}
 	if (pHardware->HwdType == HTYPE_ANNATHERMOSTAT)
 	{
-		CAnnaThermostat* pGateway = dynamic_cast<CAnnaThermostat*>(pHardware);
+		CAnnaThermostat* pGateway = dynamic_cast<CAnnaThermostat*>(pHardware.get());
 		pGateway->SetProgramState(newState);
 		return true;
 	}
 	if (pHardware->HwdType == HTYPE_THERMOSMART)
 	{
-		//CThermosmart *pGateway = dynamic_cast<CThermosmart *>(pHardware);
+		//CThermosmart *pGateway = dynamic_cast<CThermosmart *>(pHardware.get());
 		//pGateway->SetProgramState(newState);
 		return true;
 	}
 	if (pHardware->HwdType == HTYPE_Netatmo)
 	{
-		CNetatmo* pGateway = dynamic_cast<CNetatmo*>(pHardware);
+		CNetatmo* pGateway = dynamic_cast<CNetatmo*>(pHardware.get());
 		int tIndex = atoi(idx.c_str());
 		pGateway->SetProgramState(tIndex, newState);
 		return true;
 	}
 	if (pHardware->HwdType == HTYPE_IntergasInComfortLAN2RF)
 	{
-		CInComfort* pGateway = dynamic_cast<CInComfort*>(pHardware);
+		CInComfort* pGateway = dynamic_cast<CInComfort*>(pHardware.get());
 		pGateway->SetProgramState(newState);
 		return true;
 	}
@@ -13617,8 +13676,8 @@ void MainWorker::SetInternalSecStatus(const std::string& User)
 		_log.Log(LOG_NORM, "(System) Domoticz Security Status");
 	}
 
-	CDomoticzHardwareBase* pHardware = GetHardwareByType(HTYPE_DomoticzInternal);
-	PushAndWaitRxMessage(pHardware, (const uint8_t*)&tsen, "Domoticz Security Panel", -1, User.c_str());
+	std::shared_ptr<CDomoticzHardwareBase> pHardware = GetHardwareByType(HTYPE_DomoticzInternal);
+	PushAndWaitRxMessage(pHardware.get(), (const uint8_t*)&tsen, "Domoticz Security Panel", -1, User.c_str());
 }
 
 void MainWorker::UpdateDomoticzSecurityStatus(const int iSecStatus, const std::string& User)
@@ -13731,7 +13790,8 @@ void MainWorker::HeartbeatCheck()
 	}
 
 	//Check hardware heartbeats
-	for (const auto &pHardware : m_hardwaredevices)
+	std::shared_ptr<const _tHardwareRegistry> pRegistry = GetHardwareRegistry();
+	for (const auto &pHardware : pRegistry->devices)
 	{
 		if (!pHardware->m_bSkipReceiveCheck)
 		{
@@ -13768,7 +13828,7 @@ void MainWorker::HeartbeatCheck()
 						|| (pHardware->HwdType == HTYPE_RFXtrx868)
 						)
 					{
-						const CRFXBase* pRFXBase = static_cast<CRFXBase*>(pHardware);
+						const CRFXBase* pRFXBase = static_cast<CRFXBase*>(pHardware.get());
 						if (pRFXBase->m_LastP1Received != 0)
 						{
 							diff = difftime(now, pRFXBase->m_LastP1Received);
@@ -13875,7 +13935,7 @@ bool MainWorker::UpdateDevice(const int HardwareID, const std::string &DeviceID,
 
 		float temp = 12345.0F;
 
-		CDomoticzHardwareBase *pHardware = GetHardware(HardwareID);
+		std::shared_ptr<CDomoticzHardwareBase> pHardware = GetHardware(HardwareID);
 		if (pHardware)
 		{
 			if (devType == pTypeLighting2)
@@ -13904,7 +13964,7 @@ bool MainWorker::UpdateDevice(const int HardwareID, const std::string &DeviceID,
 				lcmd.LIGHTING2.level = (uint8_t)atoi(sValue.c_str());
 				lcmd.LIGHTING2.filler = 0;
 				lcmd.LIGHTING2.rssi = signallevel;
-				DecodeRXMessage(pHardware, (const uint8_t *)&lcmd.LIGHTING2, nullptr, batterylevel, userName.c_str());
+				DecodeRXMessage(pHardware.get(), (const uint8_t *)&lcmd.LIGHTING2, nullptr, batterylevel, userName.c_str());
 				g_bUseEventTrigger = true;
 				return true;
 			}
@@ -13988,7 +14048,7 @@ bool MainWorker::UpdateDevice(const int HardwareID, const std::string &DeviceID,
 				uint8_t NodeID = (uint8_t)((ID & 0x0000FF00) >> 8);
 				uint8_t ChildID = (uint8_t)((ID & 0x000000FF));
 
-				MySensorsBase *pMySensorDevice = dynamic_cast<MySensorsBase *>(pHardware);
+				MySensorsBase *pMySensorDevice = dynamic_cast<MySensorsBase *>(pHardware.get());
 				pMySensorDevice->SendTextSensorValue(NodeID, ChildID, sValue);
 			}
 		}
@@ -13997,7 +14057,10 @@ bool MainWorker::UpdateDevice(const int HardwareID, const std::string &DeviceID,
 		if (temp != 12345.0F)
 		{
 			uint64_t tID = ((uint64_t)(HardwareID & 0x7FFFFFFF) << 32) | (devidx & 0x7FFFFFFF);
-			m_trend_calculator[tID].AddValueAndReturnTendency(static_cast<double>(temp), _tTrendCalculator::TAVERAGE_TEMP);
+			{
+				std::lock_guard<std::mutex> l(m_calculator_mutex);
+				m_trend_calculator[tID].AddValueAndReturnTendency(static_cast<double>(temp), _tTrendCalculator::TAVERAGE_TEMP);
+			}
 		}
 
 #ifdef ENABLE_PYTHON
@@ -7,17 +7,34 @@
 #include "NotificationSystem.h"
 #include "Camera.h"
 #include <deque>
+#include <unordered_map>
 #include "WindCalculation.h"
 #include "TrendCalculator.h"
 #include "StoppableTask.h"
 #include "../tcpserver/TCPServer.h"
 #include "concurrent_queue.h"
+#include "mpsc_ring_queue.h"
 #include "../webserver/server_settings.hpp"
 #include "../iamserver/iam_settings.hpp"
 #ifdef ENABLE_PYTHON
 #	include "../hardware/plugins/PluginManager.h"
 #endif
 
+#define RXQUEUE_DEFAULT_LANES 4
+#define RXQUEUE_MAX_LANES 32
+#define RXQUEUE_LANE_SIZE 4096
+
+struct _tRxLaneStats
+{
+	size_t depth;
+	size_t high_water_mark;
+	uint64_t processed;
+	uint64_t dropped;
+	uint64_t total_wait_us; // time spent in the queue
+	uint64_t total_us;	// time spent processing
+	uint64_t max_us;
+};
+
 class MainWorker : public StoppableTask
 {
 public:
@@ -33,11 +50,10 @@ public:
 	void AddDomoticzHardware(CDomoticzHardwareBase *pHardware);
 	void RemoveDomoticzHardware(CDomoticzHardwareBase *pHardware);
 	void RemoveDomoticzHardware(int HwdId);
-	int FindDomoticzHardware(int HwdId);
-	int FindDomoticzHardwareByType(_eHardwareTypes HWType);
-	CDomoticzHardwareBase* GetHardware(int HwdId);
-	CDomoticzHardwareBase *GetHardwareByIDType(const std::string &HwdId, _eHardwareTypes HWType);
-	CDomoticzHardwareBase *GetHardwareByType(_eHardwareTypes HWType);
+	//The returned reference keeps the hardware object alive while it is used, also when it is removed meanwhile
+	std::shared_ptr<CDomoticzHardwareBase> GetHardware(int HwdId);
+	std::shared_ptr<CDomoticzHardwareBase> GetHardwareByIDType(const std::string &HwdId, _eHardwareTypes HWType);
+	std::shared_ptr<CDomoticzHardwareBase> GetHardwareByType(_eHardwareTypes HWType);
 
 	void HeartbeatUpdate(const std::string &component, bool critical = true);
 	void HeartbeatRemove(const std::string &component);
@@ -52,7 +68,16 @@ public:
 	std::string GetSecureWebserverPort();
 #endif
 	void DecodeRXMessage(const CDomoticzHardwareBase *pHardware, const uint8_t *pRXCommand, const char *defaultName, int BatteryLevel, const char *userName);
-	void PushAndWaitRxMessage(const CDomoticzHardwareBase *pHardware, const uint8_t *pRXCommand, const char *defaultName, int BatteryLevel, const char *userName);
+	//Returns false when the message was not processed (queue full with the drop policy, or stopping)
+	bool PushAndWaitRxMessage(const CDomoticzHardwareBase *pHardware, const uint8_t *pRXCommand, const char *defaultName, int BatteryLevel, const char *userName);
+	//Decodes a message on the calling thread (the lanes call this for the queued messages)
+	void ProcessRXMessage(const CDomoticzHardwareBase *pHardware, const uint8_t *pRXCommand, const char *defaultName, int BatteryLevel,
+			      const char *userName); // battery level: 0-100, 255=no battery, -1 = don't set
+	//Number of threads decoding received messages (1 = everything in arrival order), set before Start
+	void SetRxLaneCount(int lanes);
+	//What a producer does when a lane or the event queue is full (default: wait), set before Start
+	void SetRxQueueOverflowPolicy(queue_overflow_policy policy);
+	std::vector<_tRxLaneStats> GetRxLaneStats();
 
 	bool SwitchLight(const std::string &idx, const std::string &switchcmd, const std::string &level, const std::string &color, const std::string &ooc, int ExtraDelay, const std::string &User);
 	bool SwitchLight(uint64_t idx, const std::string &switchcmd, int level, _tColor color, bool ooc, int ExtraDelay, const std::string &User);
@@ -127,8 +152,10 @@ public:
 	std::vector<int> m_SunRiseSetMins;
 	std::string m_DayLength;
 	std::vector<std::string> m_webthemes;
+	std::mutex m_calculator_mutex; // the calculators are updated from all rx lanes
 	std::map<uint16_t, _tWindCalculator> m_wind_calculator;
 	std::map<uint64_t, _tTrendCalculator> m_trend_calculator;
+	_tTrendCalculator::_eTendencyType GetTrendState(uint64_t tID);
 
 	time_t m_LastHeartbeat = 0;
 private:
@@ -162,7 +189,18 @@ private:
 	bool m_bStartHardware;
 	uint8_t m_hardwareStartCounter;
 
-	std::vector<CDomoticzHardwareBase*> m_hardwaredevices;
+	std::vector<std::shared_ptr<CDomoticzHardwareBase>> m_hardwaredevices; // protected by m_devicemutex
+	//Read-mostly snapshot of m_hardwaredevices, replaced as a whole when hardware is added or removed.
+	//A removed hardware is deleted when the last snapshot or reference to it is released.
+	struct _tHardwareRegistry
+	{
+		std::vector<std::shared_ptr<CDomoticzHardwareBase>> devices; // in the order they were added
+		std::unordered_map<int, std::shared_ptr<CDomoticzHardwareBase>> byID;
+		std::unordered_map<int, std::shared_ptr<CDomoticzHardwareBase>> byType; // first added hardware of a type
+	};
+	std::shared_ptr<const _tHardwareRegistry> m_hardwareRegistry;
+	std::shared_ptr<const _tHardwareRegistry> GetHardwareRegistry();
+	void PublishHardwareRegistry(); // call with m_devicemutex locked
 	http::server::server_settings m_webserver_settings;
 #ifdef WWW_ENABLE_SSL
 	http::server::ssl_server_settings m_secure_webserver_settings;
@@ -191,9 +229,7 @@ private:
 
 	// RxMessage queue resources
 	volatile unsigned long m_rxMessageIdx;
-	std::shared_ptr<std::thread> m_rxMessageThread;
 	StoppableTask m_TaskRXMessage;
-	void Do_Work_On_Rx_Messages();
 	struct _tRxQueueItem {
 		std::string Name;
 		int BatteryLevel;
@@ -203,13 +239,30 @@ private:
 		boost::uint16_t crc;
 		queue_element_trigger* trigger;
 		std::string UserName;
+		std::chrono::steady_clock::time_point queued;
+		std::chrono::steady_clock::time_point origin; // traffic replay, see CTrafficCapture::GetOrigin
+	};
+	//Messages are spread over the lanes by hardware, the messages of a hardware
+	//always use the same lane and are processed in order, never concurrently.
+	//A hardware thread waits for room in a full lane, unless the drop policy is configured
+	//(messages pushed by the lane thread itself are dropped and counted, it can not wait for itself)
+	struct _tRxLane {
+		mpsc_ring_queue<_tRxQueueItem> queue{ RXQUEUE_LANE_SIZE };
+		uint64_t reported_drops = 0; // lane thread only
+		std::shared_ptr<std::thread> thread;
+		std::atomic<uint64_t> processed{ 0 };
+		std::atomic<uint64_t> total_wait_us{ 0 };
+		std::atomic<uint64_t> total_us{ 0 };
+		std::atomic<uint64_t> max_us{ 0 };
 	};
-	concurrent_queue<_tRxQueueItem> m_rxMessageQueue;
+	int m_rxLaneCount = RXQUEUE_DEFAULT_LANES;
+	queue_overflow_policy m_rxQueuePolicy = queue_overflow_policy::block;
+	std::vector<std::unique_ptr<_tRxLane>> m_rxLanes;
+	_tRxLane *GetRxLane(int hardwareId);
+	void Do_Work_On_Rx_Messages(_tRxLane *pLane);
 	void UnlockRxMessageQueue();
 	void PushRxMessage(const CDomoticzHardwareBase *pHardware, const uint8_t *pRXCommand, const char *defaultName, int BatteryLevel, const char *userName);
-	void CheckAndPushRxMessage(const CDomoticzHardwareBase *pHardware, const uint8_t *pRXCommand, const char *defaultName, int BatteryLevel, const char *userName, bool wait);
-	void ProcessRXMessage(const CDomoticzHardwareBase *pHardware, const uint8_t *pRXCommand, const char *defaultName, int BatteryLevel,
-			      const char *userName); // battery level: 0-100, 255=no battery, -1 = don't set
+	bool CheckAndPushRxMessage(const CDomoticzHardwareBase *pHardware, const uint8_t *pRXCommand, const char *defaultName, int BatteryLevel, const char *userName, bool wait);
 
 	struct _tRxMessageProcessingResult {
 		std::string DeviceName;
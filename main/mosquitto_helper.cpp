@@ -4,6 +4,7 @@ Based on the work of Roger Light <roger@atchoo.org>
 #include "stdafx.h"
 #include "mosquitto_helper.h"
 #include "Logger.h"
+#include "TrafficCapture.h"
 
 #define UNUSED(A) (void)(A)
 
@@ -43,6 +44,8 @@ static void on_message_wrapper(struct mosquitto *mosq, void *userdata, const str
 {
 	class mosquittodz *m = (class mosquittodz *)userdata;
 	UNUSED(mosq);
+	if (m_trafficcapture.IsCapturing())
+		m_trafficcapture.Record(TRAFFIC_MQTT, m->m_source, message->topic, (const uint8_t *)message->payload, message->payloadlen);
 	m->on_message(message);
 }
 
@@ -213,39 +216,83 @@ void mosquittodz::clear_callbacks()
 
 int mosquittodz::connect(const char *host, int port, int keepalive)
 {
+	m_source = std::string(host) + ":" + std::to_string(port);
+	if (m_trafficcapture.IsReplaying())
+		return connect_replay();
 	return mosquitto_connect(m_mosq, host, port, keepalive);
 }
 
 int mosquittodz::connect(const char *host, int port, int keepalive, const char *bind_address)
 {
+	m_source = std::string(host) + ":" + std::to_string(port);
+	if (m_trafficcapture.IsReplaying())
+		return connect_replay();
 	return mosquitto_connect_bind(m_mosq, host, port, keepalive, bind_address);
 }
 
 int mosquittodz::connect_async(const char *host, int port, int keepalive)
 {
+	m_source = std::string(host) + ":" + std::to_string(port);
+	if (m_trafficcapture.IsReplaying())
+		return connect_replay();
 	return mosquitto_connect_async(m_mosq, host, port, keepalive);
 }
 
 int mosquittodz::connect_async(const char *host, int port, int keepalive, const char *bind_address)
 {
+	m_source = std::string(host) + ":" + std::to_string(port);
+	if (m_trafficcapture.IsReplaying())
+		return connect_replay();
 	return mosquitto_connect_bind_async(m_mosq, host, port, keepalive, bind_address);
 }
 
+int mosquittodz::connect_replay()
+{
+	m_bReplaying = true;
+	m_trafficcapture.RegisterReader(TRAFFIC_MQTT, m_source, this, [this](const std::string &topic, const std::string &data) {
+		struct mosquitto_message message;
+		memset(&message, 0, sizeof(message));
+		message.topic = const_cast<char *>(topic.c_str());
+		message.payload = const_cast<char *>(data.c_str());
+		message.payloadlen = static_cast<int>(data.size());
+		on_message(&message);
+	});
+	on_connect(MOSQ_ERR_SUCCESS);
+	return MOSQ_ERR_SUCCESS;
+}
+
 int mosquittodz::reconnect()
 {
+	if (m_bReplaying)
+		return MOSQ_ERR_SUCCESS;
 	return mosquitto_reconnect(m_mosq);
 }
 
 int mosquittodz::reconnect_async()
 {
+	if (m_bReplaying)
+		return MOSQ_ERR_SUCCESS;
 	return mosquitto_reconnect_async(m_mosq);
 }
 
 int mosquittodz::disconnect()
 {
+	if (m_bReplaying)
+	{
+		stop_replay();
+		return MOSQ_ERR_SUCCESS;
+	}
 	return mosquitto_disconnect(m_mosq);
 }
 
+void mosquittodz::stop_replay()
+{
+	if (!m_bReplaying)
+		return;
+	m_trafficcapture.UnregisterReader(this);
+	m_bReplaying = false;
+}
+
 int mosquittodz::socket()
 {
 	return mosquitto_socket(m_mosq);
@@ -268,6 +315,9 @@ int mosquittodz::username_pw_set(const char *username, const char *password)
 
 int mosquittodz::publish(int *mid, const char *topic, int payloadlen, const void *payload, int qos, bool retain)
 {
+	// nothing is sent during a replay
+	if (m_bReplaying)
+		return MOSQ_ERR_SUCCESS;
 	try
 	{
 		return mosquitto_publish(m_mosq, mid, topic, payloadlen, payload, qos, retain);
@@ -297,11 +347,15 @@ void mosquittodz::message_retry_set(unsigned int message_retry)
 
 int mosquittodz::subscribe(int *mid, const char *sub, int qos)
 {
+	if (m_bReplaying)
+		return MOSQ_ERR_SUCCESS;
 	return mosquitto_subscribe(m_mosq, mid, sub, qos);
 }
 
 int mosquittodz::unsubscribe(int *mid, const char *sub)
 {
+	if (m_bReplaying)
+		return MOSQ_ERR_SUCCESS;
 	return mosquitto_unsubscribe(m_mosq, mid, sub);
 }
 
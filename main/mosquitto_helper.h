@@ -8,6 +8,7 @@ based on the work of Roger Light <roger@atchoo.org>
 #define MOSQUITTO_HELPER_H
 
 #include <mosquitto.h>
+#include <string>
 
 namespace mosqdz {
 	const char* strerror(int mosq_errno);
@@ -36,6 +37,7 @@ namespace mosqdz {
 	class mosquittodz {
 	public:
 		struct mosquitto* m_mosq;
+		std::string m_source; // host:port, identifies the connection in a traffic capture
 	public:
 	  mosquittodz(const char *id = nullptr, bool clean_session = true);
 	  virtual ~mosquittodz();
@@ -53,6 +55,9 @@ namespace mosqdz {
 	  int reconnect();
 	  int reconnect_async();
 	  int disconnect();
+	  // stops the replay reader, to be called by the derived class before it is destroyed,
+	  // a replayed message would otherwise call on_message of a partly destroyed object
+	  void stop_replay();
 	  int publish(int *mid, const char *topic, int payloadlen = 0, const void *payload = nullptr, int qos = 0, bool retain = false);
 	  int subscribe(int *mid, const char *sub, int qos = 0);
 	  int unsubscribe(int *mid, const char *sub);
@@ -106,6 +111,11 @@ namespace mosqdz {
 	  virtual void on_error()
 	  {
 	  }
+
+	private:
+	  // registers as reader of a traffic replay instead of connecting to the broker
+	  int connect_replay();
+	  bool m_bReplaying = false;
 	};
 } // namespace mosqdz
 #endif
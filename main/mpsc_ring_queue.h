@@ -0,0 +1,302 @@
+/*
+ * mpsc_ring_queue.h
+ *
+ *  Bounded multi-producer, single-consumer queue on a lock free ring buffer.
+ *  Source: http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+ *
+ *  Elements are moved in and out of the ring, the mutex and condition variables
+ *  are only used to put the consumer (or a producer of a full queue) to sleep.
+ */
+#pragma once
+#ifndef MAIN_MPSC_RING_QUEUE_H_
+#define MAIN_MPSC_RING_QUEUE_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum class queue_overflow_policy {
+	block,		 // wait until the consumer made room
+	drop_oldest, // discard the oldest queued element
+	drop_newest	 // discard the element that is pushed
+};
+
+struct queue_stats {
+	size_t capacity;
+	size_t depth;
+	size_t high_water_mark;
+	uint64_t pushed;
+	uint64_t popped;
+	uint64_t dropped;
+	uint64_t blocked;
+};
+
+template<typename Data>
+class mpsc_ring_queue {
+private:
+	struct cell_t {
+		std::atomic<size_t> sequence;
+		Data data;
+	};
+
+	static size_t round_capacity(size_t capacity) {
+		size_t size = 2;
+		while (size < capacity)
+			size <<= 1;
+		return size;
+	}
+
+	std::unique_ptr<cell_t[]> the_buffer;
+	const size_t the_mask;
+	queue_overflow_policy the_policy;
+
+	//keep the producer and consumer positions on their own cache line
+	char pad0[64];
+	std::atomic<size_t> enqueue_pos;
+	char pad1[64];
+	std::atomic<size_t> dequeue_pos;
+	char pad2[64];
+
+	std::atomic<size_t> high_water_mark;
+	std::atomic<uint64_t> pushed;
+	std::atomic<uint64_t> popped;
+	std::atomic<uint64_t> dropped;
+	std::atomic<uint64_t> blocked;
+
+	mutable std::mutex the_mutex;
+	std::condition_variable not_empty;
+	std::condition_variable not_full;
+	std::atomic<bool> consumer_waiting;
+	std::atomic<int> producers_waiting;
+	std::atomic<std::thread::id> consumer_id;
+
+	bool try_enqueue(Data& data) {
+		cell_t* cell;
+		size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+		for (;;) {
+			cell = &the_buffer[pos & the_mask];
+			size_t seq = cell->sequence.load(std::memory_order_acquire);
+			intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+			if (dif == 0) {
+				if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (dif < 0)
+				return false; // full
+			else
+				pos = enqueue_pos.load(std::memory_order_relaxed);
+		}
+		cell->data = std::move(data);
+		cell->sequence.store(pos + 1, std::memory_order_release);
+
+		size_t depth = pos + 1 - dequeue_pos.load(std::memory_order_relaxed);
+		size_t hwm = high_water_mark.load(std::memory_order_relaxed);
+		while ((depth > hwm) && (!high_water_mark.compare_exchange_weak(hwm, depth, std::memory_order_relaxed)))
+			;
+		return true;
+	}
+
+	//also used by producers to make room with the drop_oldest policy
+	bool try_dequeue(Data& data) {
+		cell_t* cell;
+		size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+		for (;;) {
+			cell = &the_buffer[pos & the_mask];
+			size_t seq = cell->sequence.load(std::memory_order_acquire);
+			intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+			if (dif == 0) {
+				if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (dif < 0)
+				return false; // empty
+			else
+				pos = dequeue_pos.load(std::memory_order_relaxed);
+		}
+		data = std::move(cell->data);
+		cell->sequence.store(pos + the_mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	//the fences pair with the ones in the wait functions, so either the waiter sees the new
+	//element or the notifier sees the waiter
+	void notify_consumer() {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (consumer_waiting.load()) {
+			std::unique_lock<std::mutex> lock(the_mutex);
+			not_empty.notify_one();
+		}
+	}
+
+	void notify_producers() {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (producers_waiting.load() > 0) {
+			std::unique_lock<std::mutex> lock(the_mutex);
+			not_full.notify_all();
+		}
+	}
+
+	bool push_overflow(Data& data) {
+		switch (the_policy) {
+		case queue_overflow_policy::drop_newest:
+			dropped++;
+			return false;
+		case queue_overflow_policy::drop_oldest: {
+			Data oldest;
+			while (!try_enqueue(data)) {
+				if (try_dequeue(oldest))
+					dropped++;
+			}
+			return true;
+		}
+		default:
+			break;
+		}
+		//The consumer can not wait for itself
+		if (std::this_thread::get_id() == consumer_id.load()) {
+			dropped++;
+			return false;
+		}
+		blocked++;
+		std::unique_lock<std::mutex> lock(the_mutex);
+		producers_waiting++;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		while (!try_enqueue(data))
+			not_full.wait_for(lock, std::chrono::milliseconds(100));
+		producers_waiting--;
+		return true;
+	}
+
+	bool pop_one(Data& popped_value) {
+		if (!try_dequeue(popped_value))
+			return false;
+		popped++;
+		notify_producers();
+		return true;
+	}
+
+public:
+	explicit mpsc_ring_queue(size_t capacity = 1024, queue_overflow_policy policy = queue_overflow_policy::block)
+		: the_buffer(new cell_t[round_capacity(capacity)])
+		, the_mask(round_capacity(capacity) - 1)
+		, the_policy(policy)
+		, enqueue_pos(0)
+		, dequeue_pos(0)
+		, high_water_mark(0)
+		, pushed(0)
+		, popped(0)
+		, dropped(0)
+		, blocked(0)
+		, consumer_waiting(false)
+		, producers_waiting(0)
+		, consumer_id(std::thread::id()) {
+		for (size_t ii = 0; ii <= the_mask; ii++)
+			the_buffer[ii].sequence.store(ii, std::memory_order_relaxed);
+	}
+
+	mpsc_ring_queue(const mpsc_ring_queue&) = delete;
+	mpsc_ring_queue& operator=(const mpsc_ring_queue&) = delete;
+
+	void set_overflow_policy(queue_overflow_policy policy) {
+		the_policy = policy;
+	}
+
+	size_t capacity() const {
+		return the_mask + 1;
+	}
+
+	size_t size() const {
+		size_t tail = dequeue_pos.load(std::memory_order_relaxed);
+		size_t head = enqueue_pos.load(std::memory_order_relaxed);
+		return (head > tail) ? head - tail : 0;
+	}
+
+	bool empty() const {
+		return size() == 0;
+	}
+
+	void clear() {
+		Data data;
+		while (try_dequeue(data))
+			;
+		notify_producers();
+	}
+
+	//Returns false when the element was dropped because the queue is full
+	bool push(Data&& data) {
+		if (!try_enqueue(data)) {
+			if (!push_overflow(data))
+				return false;
+		}
+		pushed++;
+		notify_consumer();
+		return true;
+	}
+
+	bool try_pop(Data& popped_value) {
+		consumer_id.store(std::this_thread::get_id());
+		return pop_one(popped_value);
+	}
+
+	template<typename Duration>
+	bool timed_wait_and_pop(Data& popped_value, Duration const& wait_duration) {
+		consumer_id.store(std::this_thread::get_id());
+		if (pop_one(popped_value))
+			return true;
+		std::unique_lock<std::mutex> lock(the_mutex);
+		consumer_waiting = true;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		bool bPopped = not_empty.wait_for(lock, wait_duration, [&] { return try_dequeue(popped_value); });
+		consumer_waiting = false;
+		lock.unlock();
+		if (bPopped) {
+			popped++;
+			notify_producers();
+		}
+		return bPopped;
+	}
+
+	//Appends all queued elements, returns the number of elements added
+	size_t pop_all(std::vector<Data>& items) {
+		consumer_id.store(std::this_thread::get_id());
+		size_t count = 0;
+		Data data;
+		while (try_dequeue(data)) {
+			items.push_back(std::move(data));
+			count++;
+		}
+		if (count != 0) {
+			popped += count;
+			notify_producers();
+		}
+		return count;
+	}
+
+	template<typename Duration>
+	size_t timed_wait_and_pop_all(std::vector<Data>& items, Duration const& wait_duration) {
+		Data data;
+		if (!timed_wait_and_pop(data, wait_duration))
+			return 0;
+		items.push_back(std::move(data));
+		return 1 + pop_all(items);
+	}
+
+	queue_stats get_stats() const {
+		queue_stats stats;
+		stats.capacity = capacity();
+		stats.depth = size();
+		stats.high_water_mark = high_water_mark.load();
+		stats.pushed = pushed.load();
+		stats.popped = popped.load();
+		stats.dropped = dropped.load();
+		stats.blocked = blocked.load();
+		return stats;
+	}
+};
+
+#endif /* MAIN_MPSC_RING_QUEUE_H_ */
@@ -493,7 +493,7 @@ bool CNotificationHelper::CheckAndHandleNotification(const uint64_t DevRowIdx, c
 	}
 
 	std::string hName;
-	CDomoticzHardwareBase *pHardware = m_mainworker.GetHardware(HardwareID);
+	std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardware(HardwareID);
 	if (pHardware == nullptr)
 	{
 		hName = "";
@@ -1224,22 +1224,6 @@ bool CNotificationHelper::CheckAndHandleRainNotification(
 	//double AddjValue = atof(result[0][0].c_str());
 	double AddjMulti = atof(result[0][1].c_str());
 
-	char szDateEnd[40];
-
-	time_t now = mytime(nullptr);
-	struct tm tm1;
-	localtime_r(&now, &tm1);
-	struct tm ltime;
-	ltime.tm_isdst = tm1.tm_isdst;
-//GB3:	Use a midday hour to avoid a clash with possible DST jump
-	ltime.tm_hour=14;
-	ltime.tm_min = 0;
-	ltime.tm_sec = 0;
-	ltime.tm_year = tm1.tm_year;
-	ltime.tm_mon = tm1.tm_mon;
-	ltime.tm_mday = tm1.tm_mday;
-	sprintf(szDateEnd, "%04d-%02d-%02d", ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday);
-
 	if (subType == sTypeRAINWU || subType == sTypeRAINByRate)
 	{
 		//value is already total rain
@@ -1249,13 +1233,10 @@ bool CNotificationHelper::CheckAndHandleRainNotification(
 	}
 	else
 	{
-		result = m_sql.safe_query("SELECT MIN(Total) FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')",
-			Idx, szDateEnd);
-		if (!result.empty())
+		_tTodayCounter counter;
+		if (m_sql.GetTodayCounter("Rain", Idx, counter))
 		{
-			std::vector<std::string> sd = result[0];
-
-			float total_min = static_cast<float>(atof(sd[0].c_str()));
+			float total_min = static_cast<float>(counter.Min[0]);
 			float total_max = mvalue;
 			double total_real = total_max - total_min;
 			total_real *= AddjMulti;
@@ -29,8 +29,8 @@ bool CNotificationLogitechMediaServer::SendMessageImplementation(
 		sSubject = Subject;
 	}
 
-	CDomoticzHardwareBase *pHardware = m_mainworker.GetHardwareByType(HTYPE_LogitechMediaServer);
-	CLogitechMediaServer* pLMS = dynamic_cast<CLogitechMediaServer*>(pHardware);
+	std::shared_ptr<CDomoticzHardwareBase> pHardware = m_mainworker.GetHardwareByType(HTYPE_LogitechMediaServer);
+	CLogitechMediaServer* pLMS = dynamic_cast<CLogitechMediaServer*>(pHardware.get());
 
 	if (pHardware == nullptr)
 	{
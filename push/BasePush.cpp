@@ -901,7 +901,7 @@ void CBasePush::ReloadPushLinks(const PushType PType)
 	std::lock_guard<std::mutex> l(m_link_mutex);
 	m_pushlinks.clear();
 	std::vector<std::vector<std::string>> result;
-	result = m_sql.safe_query("SELECT A.DeviceRowID, A.DelimitedValue, B.ID, B.Name, B.Type, B.SubType, B.SwitchType "
+	result = m_sql.safe_query_readonly("SELECT A.DeviceRowID, A.DelimitedValue, B.ID, B.Name, B.Type, B.SubType, B.SwitchType "
 		"FROM PushLink as A, DeviceStatus as B "
 		"WHERE (A.PushType==%d AND A.Enabled==1 AND A.DeviceRowID == B.ID)",
 		PType);
@@ -948,7 +948,7 @@ namespace http {
 			root["status"] = "OK";
 			root["title"] = "GetDevicesListOnOff";
 			std::vector<std::vector<std::string> > result;
-			result = m_sql.safe_query("SELECT ID, Name, Type, SubType FROM DeviceStatus WHERE (Used == 1) ORDER BY Name COLLATE NOCASE ASC");
+			result = m_sql.safe_query_readonly("SELECT ID, Name, Type, SubType FROM DeviceStatus WHERE (Used == 1) ORDER BY Name COLLATE NOCASE ASC");
 			if (!result.empty())
 			{
 				int ii = 0;
@@ -12,11 +12,14 @@
 #include "../main/WebServer.h"
 #include "../webserver/Base64.h"
 #include "../webserver/cWebem.h"
+#include "../webserver/GZipHelper.h"
 #include "../main/localtime_r.h"
+#include <fstream>
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
 
 extern CInfluxPush m_influxpush;
+extern std::string szUserDataFolder;
 
 CInfluxPush::CInfluxPush()
 {
@@ -37,6 +40,7 @@ bool CInfluxPush::Start()
 	SetThreadName(m_thread->native_handle(), "InfluxPush");
 
 	m_sConnection = m_mainworker.sOnDeviceReceived.connect([this](auto id, auto idx, const auto &name, auto rx) { OnDeviceReceived(id, idx, name, rx); });
+	m_PreferencesSubscription = m_sql.SubscribePreferences("", [this](const std::string &Key, int nValue, const std::string & /*sValue*/) { OnPreferenceChanged(Key, nValue); });
 
 	return (m_thread != nullptr);
 }
@@ -45,6 +49,11 @@ void CInfluxPush::Stop()
 {
 	if (m_sConnection.connected())
 		m_sConnection.disconnect();
+	if (m_PreferencesSubscription != 0)
+	{
+		m_sql.UnsubscribePreferences(m_PreferencesSubscription);
+		m_PreferencesSubscription = 0;
+	}
 
 	if (m_thread)
 	{
@@ -54,6 +63,15 @@ void CInfluxPush::Stop()
 	}
 }
 
+//The batch settings are picked up by the worker without a restart of the link
+void CInfluxPush::OnPreferenceChanged(const std::string &Key, const int nValue)
+{
+	if (Key == "InfluxBatchSize")
+		m_BatchSize = std::max(nValue, 1);
+	else if (Key == "InfluxBatchAge")
+		m_BatchAge = std::max(nValue, 0);
+}
+
 void CInfluxPush::UpdateSettings()
 {
 	int fActive = 0;
@@ -79,6 +97,8 @@ void CInfluxPush::UpdateSettings()
 	{
 		m_bInfluxDebugActive = true;
 	}
+	m_BatchSize = std::max(m_sql.GetPreferencesInt("InfluxBatchSize", INFLUX_DEFAULT_BATCH_SIZE), 1);
+	m_BatchAge = std::max(m_sql.GetPreferencesInt("InfluxBatchAge", INFLUX_DEFAULT_BATCH_AGE), 0);
 	m_szURL = "";
 	if ((m_InfluxIP.empty()) || (m_InfluxPort == 0) || (m_InfluxDatabase.empty()))
 		return;
@@ -105,7 +125,7 @@ void CInfluxPush::UpdateSettings()
 		sURL << "org=" << m_InfluxUsername;
 		sURL << "&bucket=" << m_InfluxDatabase;
 	}
-	sURL << "&precision=s";
+	sURL << "&precision=ns";
 	m_szURL = sURL.str();
 }
 
@@ -122,14 +142,14 @@ void CInfluxPush::DoInfluxPush(const uint64_t DeviceRowIdx, const bool bForced)
 		return;
 
 	std::vector<std::vector<std::string>> result;
-	result = m_sql.safe_query(
+	result = m_sql.safe_query_readonly(
 		"SELECT A.DeviceRowID, A.DelimitedValue, B.ID, B.Type, B.SubType, B.nValue, B.sValue, A.TargetType, A.IncludeUnit, B.Name, B.SwitchType FROM PushLink as A, DeviceStatus as B "
 		"WHERE (A.PushType==%d AND A.DeviceRowID == '%" PRIu64 "' AND A.Enabled==1 AND A.DeviceRowID==B.ID)",
 		PushType::PUSHTYPE_INFLUXDB, DeviceRowIdx);
 	if (result.empty())
 		return;
 
-	time_t atime = mytime(nullptr);
+	const uint64_t atime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 	for (const auto &sd : result)
 	{
 		std::string sendValue;
@@ -167,7 +187,7 @@ void CInfluxPush::DoInfluxPush(const uint64_t DeviceRowIdx, const bool bForced)
 
 		_tPushItem pItem;
 		pItem.skey = szKey;
-		pItem.stimestamp = atime;
+		pItem.stimestamp_ns = atime;
 		pItem.svalue = sendValue;
 
 		if ((targetType == 0) && (!bForced))
@@ -182,84 +202,331 @@ void CInfluxPush::DoInfluxPush(const uint64_t DeviceRowIdx, const bool bForced)
 			m_PushedItems[szKey] = pItem;
 		}
 
-		std::lock_guard<std::mutex> l(m_background_task_mutex);
-		if (m_background_task_queue.size() < 50)
-			m_background_task_queue.push_back(pItem);
+		{
+			std::lock_guard<std::mutex> l(m_background_task_mutex);
+			if (m_background_task_queue.size() < INFLUX_QUEUE_MAX)
+			{
+				m_background_task_queue.push_back(pItem);
+				continue;
+			}
+		}
+		std::lock_guard<std::mutex> l(m_stats_mutex);
+		m_stats.DroppedPoints++;
 	}
 }
 
 void CInfluxPush::Do_Work()
 {
-	std::vector<_tPushItem> _items2do;
+	LoadSpool();
 
+	_tInfluxBatch batch;
 	while (!IsStopRequested(500))
 	{
-		{ // additional scope for lock (accessing size should be within lock too)
-			std::lock_guard<std::mutex> l(m_background_task_mutex);
-			if (m_background_task_queue.empty())
-				continue;
-			_items2do = m_background_task_queue;
-			m_background_task_queue.clear();
+		TakeQueuedItems(batch);
+		{
+			std::lock_guard<std::mutex> l(m_stats_mutex);
+			m_stats.BatchPoints = batch.points;
 		}
 
-		if (m_szURL.empty())
+		if ((!m_bLinkActive) || (m_szURL.empty()))
+		{
+			if (batch.points != 0)
+			{
+				std::lock_guard<std::mutex> l(m_stats_mutex);
+				m_stats.DroppedPoints += batch.points;
+			}
+			batch = _tInfluxBatch();
 			continue;
+		}
+
+		const auto now = std::chrono::steady_clock::now();
+		bool bServerAvailable = (now >= m_next_retry);
 
-		std::string sSendData;
+		//Older (spooled) points first
+		while ((bServerAvailable) && (!m_spool.empty()) && (!IsStopRequested(0)))
+			bServerAvailable = SendSpoolSegment();
 
-		for (const auto &item : _items2do)
+		if (batch.points == 0)
+			continue;
+		if ((batch.points < static_cast<uint64_t>(m_BatchSize)) && (now - batch.started < std::chrono::seconds(m_BatchAge.load())))
+			continue;
+		if (!bServerAvailable)
 		{
-			if (!sSendData.empty())
-				sSendData += '\n';
+			//the batch is full or old enough, do not keep it in memory while waiting for the server
+			SpoolBatch(batch);
+			continue;
+		}
+		if (PostLines(batch.lines, batch.points, batch.oldest_ns) == POST_RETRY)
+			SpoolBatch(batch);
+		batch = _tInfluxBatch();
+	}
 
-			std::stringstream sziData;
-			sziData << item.skey << " value=" << item.svalue;
-			if (m_bInfluxDebugActive)
-			{
-				_log.Log(LOG_NORM, "InfluxLink: value %s", sziData.str().c_str());
-			}
-			sziData << " " << item.stimestamp;
-			sSendData += sziData.str();
+	//Keep what was not delivered for the next start
+	TakeQueuedItems(batch);
+	if (batch.points != 0)
+		SpoolBatch(batch);
+}
+
+void CInfluxPush::TakeQueuedItems(_tInfluxBatch &batch)
+{
+	std::vector<_tPushItem> _items2do;
+	{
+		std::lock_guard<std::mutex> l(m_background_task_mutex);
+		if (m_background_task_queue.empty())
+			return;
+		_items2do.swap(m_background_task_queue);
+	}
+
+	if (batch.points == 0)
+	{
+		batch.started = std::chrono::steady_clock::now();
+		batch.oldest_ns = _items2do.front().stimestamp_ns;
+	}
+	for (const auto &item : _items2do)
+	{
+		std::stringstream sziData;
+		sziData << item.skey << " value=" << item.svalue;
+		if (m_bInfluxDebugActive)
+		{
+			_log.Log(LOG_NORM, "InfluxLink: value %s", sziData.str().c_str());
 		}
-		std::vector<std::string> ExtraHeaders;
-		std::string sResult;
-		if (m_bInfluxVersion2)
+		sziData << " " << item.stimestamp_ns;
+
+		if (!batch.lines.empty())
+			batch.lines += '\n';
+		batch.lines += sziData.str();
+		batch.points++;
+	}
+}
+
+CInfluxPush::_ePostResult CInfluxPush::PostLines(const std::string &lines, const uint64_t points, const uint64_t oldest_ns)
+{
+	std::vector<std::string> ExtraHeaders;
+	if (m_bInfluxVersion2)
+	{
+		ExtraHeaders.push_back("Authorization: Token " + base64_decode(m_InfluxPassword));
+	}
+	ExtraHeaders.push_back("Content-type: text/plain");
+
+	std::string sSendData;
+	CA2GZIP gzip((char *)lines.c_str(), (int)lines.size());
+	if ((gzip.pgzip != nullptr) && (gzip.Length > 0))
+	{
+		ExtraHeaders.push_back("Content-Encoding: gzip");
+		sSendData.assign(reinterpret_cast<const char *>(gzip.pgzip), gzip.Length);
+	}
+	else
+		sSendData = lines;
+
+	std::string sResult;
+	std::vector<std::string> vHeaderData;
+	const auto tstart = std::chrono::steady_clock::now();
+	bool bRet = HTTPClient::POST(m_szURL, sSendData, ExtraHeaders, sResult, vHeaderData, true, true);
+	const uint64_t post_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - tstart).count();
+
+	//the last status line counts (redirects)
+	int status = 0;
+	for (const auto &header : vHeaderData)
+	{
+		if (header.find("HTTP/") == 0)
+		{
+			size_t pos = header.find(' ');
+			if (pos != std::string::npos)
+				status = atoi(header.c_str() + pos + 1);
+		}
+	}
+
+	std::string szMessage;
+	if (!sResult.empty())
+	{
+		Json::Value root;
+		if ((ParseJSon(sResult, root)) && (root.isObject()))
 		{
-			ExtraHeaders.push_back("Authorization: Token " + base64_decode(m_InfluxPassword));
-			ExtraHeaders.push_back("Content-type: text/plain");
+			if (!root["message"].empty())
+				szMessage = root["message"].asString();
+			else if (!root["error"].empty())
+				szMessage = root["error"].asString();
 		}
+	}
+
+	_ePostResult result = POST_RETRY;
+	if ((bRet) && (status >= 200) && (status < 300))
+		result = POST_OK;
+	else if ((bRet) && ((status == 400) || (status == 413) || (status == 422)))
+	{
+		//the server will never accept these points
+		result = POST_REJECTED;
+	}
+
+	std::lock_guard<std::mutex> l(m_stats_mutex);
+	m_stats.LastPostMs = post_ms;
+	if (result == POST_OK)
+	{
+		const uint64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		m_stats.SentPoints += points;
+		m_stats.LastLatencyMs = (now_ns > oldest_ns) ? (now_ns - oldest_ns) / 1000000 : 0;
+		m_stats.MaxLatencyMs = std::max(m_stats.MaxLatencyMs, m_stats.LastLatencyMs);
+		m_stats.RetryIn = 0;
+		if (m_retry_delay != 0)
+			_log.Log(LOG_STATUS, "InfluxLink: Connection to InfluxDB server restored");
+		m_retry_delay = 0;
+		return result;
+	}
+
+	m_stats.FailedPosts++;
+	if (szMessage.empty())
+		szMessage = (status != 0) ? "HTTP status " + std::to_string(status) : "no response";
+	m_stats.LastError = szMessage;
+	if (result == POST_REJECTED)
+	{
+		m_stats.DroppedPoints += points;
+		_log.Log(LOG_ERROR, "InfluxLink: InfluxDB server rejected %" PRIu64 " points! (%s)", points, szMessage.c_str());
+		return result;
+	}
+
+	m_retry_delay = (m_retry_delay == 0) ? INFLUX_RETRY_MIN : std::min(m_retry_delay * 2, INFLUX_RETRY_MAX);
+	m_next_retry = std::chrono::steady_clock::now() + std::chrono::seconds(m_retry_delay);
+	m_stats.RetryIn = m_retry_delay;
+	_log.Log(LOG_ERROR, "InfluxLink: Error sending data to InfluxDB server! (%s, check address/port/database/username/password), retrying in %d seconds", szMessage.c_str(),
+		 m_retry_delay);
+	return result;
+}
+
+//Returns false when the server is not available
+bool CInfluxPush::SendSpoolSegment()
+{
+	const _tSpoolSegment segment = m_spool.front();
+	std::ifstream infile(segment.filename, std::ios::in | std::ios::binary);
+	std::string lines((std::istreambuf_iterator<char>(infile)), std::istreambuf_iterator<char>());
+	infile.close();
+
+	if ((!lines.empty()) && (PostLines(lines, segment.points, segment.oldest_ns) == POST_RETRY))
+		return false;
+	std::remove(segment.filename.c_str());
+	m_spool.pop_front();
+	UpdateSpoolStats();
+	return true;
+}
+
+void CInfluxPush::SpoolBatch(_tInfluxBatch &batch)
+{
+	char szName[40];
+	sprintf(szName, "%020" PRIu64 ".lp", m_spool_seq++);
+	_tSpoolSegment segment;
+	segment.filename = m_SpoolFolder + szName;
+	segment.points = batch.points;
+	segment.bytes = batch.lines.size();
+	segment.oldest_ns = batch.oldest_ns;
+
+	//a segment is only visible when it is complete
+	const std::string tmpname = segment.filename + ".tmp";
+	std::ofstream outfile(tmpname, std::ios::out | std::ios::binary | std::ios::trunc);
+	outfile << batch.lines;
+	outfile.close();
+	if ((!outfile) || (std::rename(tmpname.c_str(), segment.filename.c_str()) != 0))
+	{
+		std::remove(tmpname.c_str());
+		_log.Log(LOG_ERROR, "InfluxLink: Could not write spool file %s, %" PRIu64 " points lost!", segment.filename.c_str(), batch.points);
+		std::lock_guard<std::mutex> l(m_stats_mutex);
+		m_stats.DroppedPoints += batch.points;
+		batch = _tInfluxBatch();
+		return;
+	}
+	m_spool.push_back(segment);
+	batch = _tInfluxBatch();
+
+	//drop the oldest segments when the server is gone for too long
+	uint64_t spooled_bytes = 0;
+	for (const auto &itt : m_spool)
+		spooled_bytes += itt.bytes;
+	uint64_t dropped = 0;
+	while ((spooled_bytes > INFLUX_SPOOL_MAX_BYTES) && (m_spool.size() > 1))
+	{
+		std::remove(m_spool.front().filename.c_str());
+		spooled_bytes -= m_spool.front().bytes;
+		dropped += m_spool.front().points;
+		m_spool.pop_front();
+	}
+	if (dropped != 0)
+	{
+		_log.Log(LOG_ERROR, "InfluxLink: Spool full, dropped %" PRIu64 " oldest points!", dropped);
+		std::lock_guard<std::mutex> l(m_stats_mutex);
+		m_stats.DroppedPoints += dropped;
+	}
+	UpdateSpoolStats();
+}
+
+//Picks up the segments that were not delivered before the last stop
+void CInfluxPush::LoadSpool()
+{
+	m_SpoolFolder = szUserDataFolder + "influxspool/";
+	mkdir_deep(m_SpoolFolder.c_str(), 0755);
 
-		bool bRet = HTTPClient::POST(m_szURL, sSendData, ExtraHeaders, sResult, true, true);
-		if (!bRet)
+	std::vector<std::string> files;
+	DirectoryListing(files, m_SpoolFolder, false, true);
+	std::sort(files.begin(), files.end());
+
+	m_spool.clear();
+	for (const auto &file : files)
+	{
+		const std::string filename = m_SpoolFolder + file;
+		if ((file.size() < 4) || (file.compare(file.size() - 3, 3, ".lp") != 0))
 		{
-			_log.Log(LOG_ERROR, "InfluxLink: Error sending data to InfluxDB server! (check address/port/database/username/password)");
+			//incomplete segment
+			if ((file.size() > 4) && (file.compare(file.size() - 4, 4, ".tmp") == 0))
+				std::remove(filename.c_str());
+			continue;
 		}
-		else if (!sResult.empty())
+		std::ifstream infile(filename, std::ios::in | std::ios::binary);
+		std::string lines((std::istreambuf_iterator<char>(infile)), std::istreambuf_iterator<char>());
+		if (lines.empty())
 		{
-			Json::Value root;
-			bool ret = ParseJSon(sResult, root);
-			if (root.isObject())
-			{
-				if (!root["code"].empty())
-				{
-					std::string szCode = root["code"].asString();
-					bool bHaveError = false;
-					std::string szMessage;
-
-					if (szCode == "unauthorized")
-					{
-						bHaveError = true;
-						szMessage = root["message"].asString();
-					}
-
-					if (bHaveError)
-					{
-						_log.Log(LOG_ERROR, "InfluxLink: Error sending data to InfluxDB server! (%s)", szMessage.c_str());
-					}
-				}
-			}
+			std::remove(filename.c_str());
+			continue;
 		}
+		_tSpoolSegment segment;
+		segment.filename = filename;
+		segment.points = std::count(lines.begin(), lines.end(), '\n') + 1;
+		segment.bytes = lines.size();
+		//the timestamp is the last field of a line
+		const std::string firstline = lines.substr(0, lines.find('\n'));
+		segment.oldest_ns = std::strtoull(firstline.c_str() + firstline.rfind(' ') + 1, nullptr, 10);
+		m_spool.push_back(segment);
+		m_spool_seq = std::max<uint64_t>(m_spool_seq, std::strtoull(file.c_str(), nullptr, 10) + 1);
 	}
+	if (!m_spool.empty())
+		_log.Log(LOG_STATUS, "InfluxLink: %d spooled batches to send", static_cast<int>(m_spool.size()));
+	UpdateSpoolStats();
+}
+
+void CInfluxPush::UpdateSpoolStats()
+{
+	std::lock_guard<std::mutex> l(m_stats_mutex);
+	m_stats.SpooledSegments = m_spool.size();
+	m_stats.SpooledPoints = 0;
+	m_stats.SpooledBytes = 0;
+	for (const auto &segment : m_spool)
+	{
+		m_stats.SpooledPoints += segment.points;
+		m_stats.SpooledBytes += segment.bytes;
+	}
+}
+
+CInfluxPush::_tInfluxStats CInfluxPush::GetStats()
+{
+	_tInfluxStats stats;
+	{
+		std::lock_guard<std::mutex> l(m_stats_mutex);
+		stats = m_stats;
+		if (stats.RetryIn != 0)
+		{
+			auto remaining = std::chrono::duration_cast<std::chrono::seconds>(m_next_retry - std::chrono::steady_clock::now()).count();
+			stats.RetryIn = static_cast<int>(std::max<int64_t>(remaining, 0));
+		}
+	}
+	std::lock_guard<std::mutex> l(m_background_task_mutex);
+	stats.QueuedPoints = m_background_task_queue.size();
+	return stats;
 }
 
 // Webserver helpers
@@ -284,19 +551,29 @@ namespace http
 			std::string username = request::findValue(&req, "username");
 			std::string password = request::findValue(&req, "password");
 			std::string debugenabled = request::findValue(&req, "debugenabled");
+			std::string batchsize = request::findValue(&req, "batchsize");
+			std::string batchage = request::findValue(&req, "batchage");
 			if ((linkactive.empty()) || (remote.empty()) || (port.empty()) || (database.empty()) || (debugenabled.empty()))
 				return;
 			int ilinkactive = atoi(linkactive.c_str());
 			int idebugenabled = atoi(debugenabled.c_str());
-			m_sql.UpdatePreferencesVar("InfluxActive", ilinkactive);
-			m_sql.UpdatePreferencesVar("InfluxVersion2", atoi(isversion2.c_str()));
-			m_sql.UpdatePreferencesVar("InfluxIP", remote);
-			m_sql.UpdatePreferencesVar("InfluxPort", atoi(port.c_str()));
-			m_sql.UpdatePreferencesVar("InfluxPath", path);
-			m_sql.UpdatePreferencesVar("InfluxDatabase", database);
-			m_sql.UpdatePreferencesVar("InfluxUsername", username);
-			m_sql.UpdatePreferencesVar("InfluxPassword", base64_encode(password));
-			m_sql.UpdatePreferencesVar("InfluxDebug", idebugenabled);
+			std::vector<_tPreferenceValue> preferences = {
+				{ "InfluxActive", ilinkactive, "" },
+				{ "InfluxVersion2", atoi(isversion2.c_str()), "" },
+				{ "InfluxIP", 0, remote },
+				{ "InfluxPort", atoi(port.c_str()), "" },
+				{ "InfluxPath", 0, path },
+				{ "InfluxDatabase", 0, database },
+				{ "InfluxUsername", 0, username },
+				{ "InfluxPassword", 0, base64_encode(password) },
+				{ "InfluxDebug", idebugenabled, "" },
+			};
+			//the batch settings reach the worker through its preference subscription
+			if (!batchsize.empty())
+				preferences.push_back({ "InfluxBatchSize", atoi(batchsize.c_str()), "" });
+			if (!batchage.empty())
+				preferences.push_back({ "InfluxBatchAge", atoi(batchage.c_str()), "" });
+			m_sql.UpdatePreferencesVars(preferences);
 			m_influxpush.UpdateSettings();
 			root["status"] = "OK";
 			root["title"] = "SaveInfluxLinkConfig";
@@ -359,10 +636,36 @@ namespace http
 			{
 				root["InfluxDebug"] = 0;
 			}
+			root["InfluxBatchSize"] = m_sql.GetPreferencesInt("InfluxBatchSize", INFLUX_DEFAULT_BATCH_SIZE);
+			root["InfluxBatchAge"] = m_sql.GetPreferencesInt("InfluxBatchAge", INFLUX_DEFAULT_BATCH_AGE);
 			root["status"] = "OK";
 			root["title"] = "GetInfluxLinkConfig";
 		}
 
+		void CWebServer::Cmd_GetInfluxLinkStats(WebEmSession &session, const request &req, Json::Value &root)
+		{
+			if (session.rights != 2)
+			{
+				session.reply_status = reply::forbidden;
+				return; // Only admin user allowed
+			}
+			CInfluxPush::_tInfluxStats stats = m_influxpush.GetStats();
+			root["result"]["QueuedPoints"] = Json::UInt64(stats.QueuedPoints + stats.BatchPoints);
+			root["result"]["SpooledPoints"] = Json::UInt64(stats.SpooledPoints);
+			root["result"]["SpooledSegments"] = Json::UInt64(stats.SpooledSegments);
+			root["result"]["SpooledBytes"] = Json::UInt64(stats.SpooledBytes);
+			root["result"]["SentPoints"] = Json::UInt64(stats.SentPoints);
+			root["result"]["DroppedPoints"] = Json::UInt64(stats.DroppedPoints);
+			root["result"]["FailedPosts"] = Json::UInt64(stats.FailedPosts);
+			root["result"]["LastLatencyMs"] = Json::UInt64(stats.LastLatencyMs);
+			root["result"]["MaxLatencyMs"] = Json::UInt64(stats.MaxLatencyMs);
+			root["result"]["LastPostMs"] = Json::UInt64(stats.LastPostMs);
+			root["result"]["RetryIn"] = stats.RetryIn;
+			root["result"]["LastError"] = stats.LastError;
+			root["status"] = "OK";
+			root["title"] = "GetInfluxLinkStats";
+		}
+
 		void CWebServer::Cmd_GetInfluxLinks(WebEmSession &session, const request &req, Json::Value &root)
 		{
 			if (session.rights != 2)
@@ -371,7 +674,7 @@ namespace http
 				return; // Only admin user allowed
 			}
 			std::vector<std::vector<std::string>> result;
-			result = m_sql.safe_query("SELECT A.ID,A.DeviceRowID,A.Delimitedvalue,A.TargetType,A.TargetVariable,A.TargetDeviceID,A.TargetProperty,A.Enabled, B.Name, A.IncludeUnit, "
+			result = m_sql.safe_query_readonly("SELECT A.ID,A.DeviceRowID,A.Delimitedvalue,A.TargetType,A.TargetVariable,A.TargetDeviceID,A.TargetProperty,A.Enabled, B.Name, A.IncludeUnit, "
 						  "B.Type, B.SubType FROM PushLink as A, DeviceStatus as B WHERE (A.PushType==%d AND A.DeviceRowID==B.ID)",
 						  CBasePush::PushType::PUSHTYPE_INFLUXDB);
 			if (!result.empty())
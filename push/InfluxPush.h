@@ -1,27 +1,85 @@
 #pragma once
 #include "BasePush.h"
+#include <atomic>
+#include <chrono>
+#include <deque>
+
+//Points are posted in batches (gzip, nanosecond timestamps). A batch that could not be
+//delivered is written to a spool segment file, the segments are posted again (oldest first)
+//with an increasing delay until the server accepts them.
+#define INFLUX_QUEUE_MAX 10000
+#define INFLUX_DEFAULT_BATCH_SIZE 1000
+#define INFLUX_DEFAULT_BATCH_AGE 1 //seconds
+#define INFLUX_RETRY_MIN 1 //seconds
+#define INFLUX_RETRY_MAX 300
+#define INFLUX_SPOOL_MAX_BYTES (64 * 1024 * 1024)
 
 class CInfluxPush : public CBasePush
 {
 public:
+	struct _tInfluxStats
+	{
+		uint64_t QueuedPoints = 0;
+		uint64_t BatchPoints = 0;
+		uint64_t SpooledPoints = 0;
+		uint64_t SpooledSegments = 0;
+		uint64_t SpooledBytes = 0;
+		uint64_t SentPoints = 0;
+		uint64_t DroppedPoints = 0;
+		uint64_t FailedPosts = 0;
+		uint64_t LastLatencyMs = 0; //age of the oldest point of the last delivered batch
+		uint64_t MaxLatencyMs = 0;
+		uint64_t LastPostMs = 0;
+		int RetryIn = 0; //seconds, 0 when the server is available
+		std::string LastError;
+	};
+
 	CInfluxPush();
 	bool Start();
 	void Stop();
 	void UpdateSettings();
 	void DoInfluxPush(const uint64_t DeviceRowIdx, const bool bForced = false);
+	_tInfluxStats GetStats();
 private:
 	struct _tPushItem
 	{
 		std::string skey;
-		time_t stimestamp;
+		uint64_t stimestamp_ns;
 		std::string svalue;
 	};
+	struct _tInfluxBatch
+	{
+		std::string lines;
+		uint64_t points = 0;
+		uint64_t oldest_ns = 0;
+		std::chrono::steady_clock::time_point started;
+	};
+	struct _tSpoolSegment
+	{
+		std::string filename;
+		uint64_t points;
+		uint64_t bytes;
+		uint64_t oldest_ns;
+	};
+	enum _ePostResult
+	{
+		POST_OK,
+		POST_RETRY,
+		POST_REJECTED,
+	};
 	void OnDeviceReceived(int m_HwdID, uint64_t DeviceRowIdx, const std::string& DeviceName, const unsigned char* pRXCommand);
 
 	std::shared_ptr<std::thread> m_thread;
 	std::mutex m_background_task_mutex;
 	void Do_Work();
 
+	void TakeQueuedItems(_tInfluxBatch &batch);
+	_ePostResult PostLines(const std::string &lines, uint64_t points, uint64_t oldest_ns);
+	bool SendSpoolSegment();
+	void SpoolBatch(_tInfluxBatch &batch);
+	void LoadSpool();
+	void UpdateSpoolStats();
+
 	std::map<std::string, _tPushItem> m_PushedItems;
 	std::vector<_tPushItem> m_background_task_queue;
 	std::string m_szURL;
@@ -33,5 +91,20 @@ private:
 	std::string m_InfluxUsername;
 	std::string m_InfluxPassword;
 	bool m_bInfluxDebugActive{ false };
+	//changed through the preference subscription while the worker is running
+	std::atomic<int> m_BatchSize{ INFLUX_DEFAULT_BATCH_SIZE };
+	std::atomic<int> m_BatchAge{ INFLUX_DEFAULT_BATCH_AGE };
+	int m_PreferencesSubscription = 0;
+	void OnPreferenceChanged(const std::string &Key, int nValue);
+
+	//spool, only used by the worker thread
+	std::string m_SpoolFolder;
+	std::deque<_tSpoolSegment> m_spool;
+	uint64_t m_spool_seq = 0;
+	int m_retry_delay = 0;
+	std::chrono::steady_clock::time_point m_next_retry;
+
+	std::mutex m_stats_mutex;
+	_tInfluxStats m_stats;
 };
 extern CInfluxPush m_influxpush;
@@ -33,12 +33,7 @@ namespace http {
 			{
 				// WebSockets only do security during set up so keep pushing the expiry out to stop it being cleaned up
 				WebEmSession session;
-				auto itt = myWebem->m_sessions.find(sessionid);
-				if (itt != myWebem->m_sessions.end())
-				{
-					session = itt->second;
-				}
-				else
+				if (!myWebem->GetSession(sessionid, session))
 					// for outbound messages create a temporary session if required
 					// todo: Add the username and rights from the original connection
 					if (outbound)
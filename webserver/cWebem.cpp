@@ -13,6 +13,7 @@
 #include "sha1.hpp"
 #include "GZipHelper.h"
 #include <stdarg.h>
+#include <atomic>
 #include <fstream>
 #include <sstream>
 #include <cstdlib>
@@ -28,7 +29,7 @@
 
 #define websocket_protocol "domoticz"
 
-int m_failcounter = 0;
+std::atomic<int> m_failcounter{ 0 };
 
 namespace http {
 	namespace server {
@@ -905,12 +906,18 @@ namespace http {
 			wtmp.userrights = userrights;
 			wtmp.ActiveTabs = activetabs;
 			wtmp.TotSensors = 0;
-			m_userpasswords.push_back(wtmp);
+			std::unique_lock<std::mutex> lock(m_usersMutex);
+			auto userpasswords = std::make_shared<std::vector<_tWebUserPassword>>(*m_userpasswords);
+			userpasswords->push_back(wtmp);
+			m_userpasswords = userpasswords;
 		}
 
 		void cWebem::ClearUserPasswords()
 		{
-			m_userpasswords.clear();
+			{
+				std::unique_lock<std::mutex> lock(m_usersMutex);
+				m_userpasswords = std::make_shared<const std::vector<_tWebUserPassword>>();
+			}
 
 			std::unique_lock<std::mutex> lock(m_sessionsMutex);
 			m_sessions.clear(); //TODO : check if it is really necessary
@@ -1052,12 +1059,34 @@ namespace http {
 				}
 			}
 
-			m_localnetworks.push_back(ipnetwork);
+			std::unique_lock<std::mutex> lock(m_usersMutex);
+			auto localnetworks = std::make_shared<std::vector<_tIPNetwork>>(*m_localnetworks);
+			localnetworks->push_back(ipnetwork);
+			m_localnetworks = localnetworks;
 		}
 
 		void cWebem::ClearTrustedNetworks()
 		{
-			m_localnetworks.clear();
+			std::unique_lock<std::mutex> lock(m_usersMutex);
+			m_localnetworks = std::make_shared<const std::vector<_tIPNetwork>>();
+		}
+
+		std::shared_ptr<const std::vector<_tWebUserPassword>> cWebem::GetUserPasswords()
+		{
+			std::unique_lock<std::mutex> lock(m_usersMutex);
+			return m_userpasswords;
+		}
+
+		bool cWebem::HasUserPasswords()
+		{
+			std::unique_lock<std::mutex> lock(m_usersMutex);
+			return !m_userpasswords->empty();
+		}
+
+		std::shared_ptr<const std::vector<_tIPNetwork>> cWebem::GetTrustedNetworks()
+		{
+			std::unique_lock<std::mutex> lock(m_usersMutex);
+			return m_localnetworks;
 		}
 
 		void cWebem::SetDigistRealm(const std::string &realm)
@@ -1090,14 +1119,14 @@ namespace http {
 			return m_webRoot;
 		}
 
-		WebEmSession * cWebem::GetSession(const std::string & ssid)
+		bool cWebem::GetSession(const std::string & ssid, WebEmSession & session)
 		{
 			std::unique_lock<std::mutex> lock(m_sessionsMutex);
 			auto itt = m_sessions.find(ssid);
-			if (itt != m_sessions.end())
-				return &itt->second;
-
-			return nullptr;
+			if (itt == m_sessions.end())
+				return false;
+			session = itt->second;
+			return true;
 		}
 
 		void cWebem::AddSession(const WebEmSession & session)
@@ -1106,6 +1135,16 @@ namespace http {
 			m_sessions[session.id] = session;
 		}
 
+		bool cWebem::UpdateSession(const std::string &ssid, const std::function<void(WebEmSession &session)> &update)
+		{
+			std::unique_lock<std::mutex> lock(m_sessionsMutex);
+			auto itt = m_sessions.find(ssid);
+			if (itt == m_sessions.end())
+				return false;
+			update(itt->second);
+			return true;
+		}
+
 		void cWebem::RemoveSession(const WebEmSession & session)
 		{
 			RemoveSession(session.id);
@@ -1373,7 +1412,8 @@ namespace http {
 		bool cWebemRequestHandler::CheckUserAuthorization(std::string &user, struct ah *ah)
 		{
 			// Check if valid password has been provided for the user
-			for (const auto &my : myWebem->m_userpasswords)
+			auto userpasswords = myWebem->GetUserPasswords();
+			for (const auto &my : *userpasswords)
 			{
 				if (my.Username == ah->user && my.userrights != URIGHTS_CLIENTID)
 				{
@@ -1487,7 +1527,8 @@ namespace http {
 						std::string client_key_id;
 						bool clientispublic = false;
 						// Check if the audience has been registered as a User (type CLIENTID)
-						for (const auto &my : myWebem->m_userpasswords)
+						auto userpasswords = myWebem->GetUserPasswords();
+						for (const auto &my : *userpasswords)
 						{
 							if (my.Username == clientid)
 							{
@@ -1552,7 +1593,7 @@ namespace http {
 						}
 						// Step 5: See of the subject (intended user) is available and exists in the User table
 						std::string key_id = decodedJWT.get_key_id();
-						for (const auto &my : myWebem->m_userpasswords)
+						for (const auto &my : *userpasswords)
 						{
 							if (my.Username == JWTsubject)
 							{
@@ -1646,7 +1687,8 @@ namespace http {
 			}
 
 			// Check if valid password has been provided for the user
-			for (const auto &my : myWebem->m_userpasswords)
+			auto userpasswords = myWebem->GetUserPasswords();
+			for (const auto &my : *userpasswords)
 			{
 				if (my.Username == _ah.user)
 				{
@@ -1679,7 +1721,8 @@ namespace http {
 				hashedsecret = GenerateMD5Hash(clientsecret);
 			}
 			// Check if the clientID exists and we have a valid clientSecret for it (used when generating Tokens for registered clients)
-			for (const auto &my : myRequestHandler.Get_myWebem()->m_userpasswords)
+			auto userpasswords = myRequestHandler.Get_myWebem()->GetUserPasswords();
+			for (const auto &my : *userpasswords)
 			{
 				if (my.Username == clientid)
 				{
@@ -1764,7 +1807,8 @@ namespace http {
 		bool cWebemRequestHandler::AreWeInTrustedNetwork(const std::string &sHost)
 		{
 			//Are there any local networks to check against?
-			if (myWebem->m_localnetworks.empty())
+			auto localnetworks = myWebem->GetTrustedNetworks();
+			if (localnetworks->empty())
 				return false;
 
 			//Is the given 'host' a valid IP address?
@@ -1776,7 +1820,7 @@ namespace http {
 				return false;	// The IP address is not a valid IPv4 or IPv6 address
 			}
 
-			return std::any_of(myWebem->m_localnetworks.begin(), myWebem->m_localnetworks.end(),
+			return std::any_of(localnetworks->begin(), localnetworks->end(),
 					   [&](const _tIPNetwork &my) { return IsIPInRange(sHost, my, bIsIPv6); });
 		}
 
@@ -2128,13 +2172,14 @@ namespace http {
 			session.username = "";
 			session.auth_token = "";
 
-			if (myWebem->m_userpasswords.empty())
+			if (!myWebem->HasUserPasswords())
 			{
 				_log.Log(LOG_ERROR, "No (active) users in the system! There should be at least 1 active Admin user!");
 			}
 			else if (AreWeInTrustedNetwork(session.remote_host))
 			{
-				for (const auto &my : myWebem->m_userpasswords)
+				auto userpasswords = myWebem->GetUserPasswords();
+				for (const auto &my : *userpasswords)
 				{
 					if (my.userrights == URIGHTS_ADMIN) // we found an admin
 					{
@@ -2211,8 +2256,8 @@ namespace http {
 				{
 					if (!sSID.empty())
 					{
-						WebEmSession* oldSession = myWebem->GetSession(sSID);
-						if (oldSession == nullptr)
+						WebEmSession oldSession;
+						if (!myWebem->GetSession(sSID, oldSession))
 						{
 							session.id = sSID;
 							session.auth_token = sAuthToken;
@@ -2220,8 +2265,8 @@ namespace http {
 						}
 						else
 						{
-							session = *oldSession;
-							expired = (oldSession->expires < now);
+							session = oldSession;
+							expired = (oldSession.expires < now);
 						}
 					}
 					if (sSID.empty() || expired)
@@ -2231,8 +2276,9 @@ namespace http {
 
 				if (!(sSID.empty() || sAuthToken.empty() || szTime.empty()))
 				{
-					WebEmSession* oldSession = myWebem->GetSession(sSID);
-					if ((oldSession != nullptr) && (oldSession->expires < now))
+					WebEmSession oldSession;
+					bool bHaveSession = myWebem->GetSession(sSID, oldSession);
+					if (bHaveSession && (oldSession.expires < now))
 					{
 						// Check if session stored in memory is not expired (prevent from spoofing expiration time)
 						expired = true;
@@ -2241,7 +2287,7 @@ namespace http {
 					{
 						//expired session, remove session
 						m_failcounter = 0;
-						if (oldSession != nullptr)
+						if (bHaveSession)
 						{
 							// session exists (delete it from memory and database)
 							myWebem->RemoveSession(sSID);
@@ -2249,10 +2295,10 @@ namespace http {
 						}
 						return false;
 					}
-					if (oldSession != nullptr)
+					if (bHaveSession)
 					{
 						// session already exists
-						session = *oldSession;
+						session = oldSession;
 					}
 					else
 					{
@@ -2342,7 +2388,8 @@ namespace http {
 				bool sessionExpires = false;
 				session.username = storedSession.username;
 				session.expires = storedSession.expires;
-				for (const auto &my : myWebem->m_userpasswords)
+				auto userpasswords = myWebem->GetUserPasswords();
+				for (const auto &my : *userpasswords)
 				{
 					if (my.Username == session.username) // the user still exists
 					{
@@ -2362,8 +2409,8 @@ namespace http {
 					return false;
 				}
 
-				WebEmSession* oldSession = myWebem->GetSession(session.id);
-				if (oldSession == nullptr)
+				WebEmSession oldSession;
+				if (!myWebem->GetSession(session.id, oldSession))
 				{
 					_log.Debug(DEBUG_WEBSERVER, "[web:%s] CheckAuthToken(%s_%s_%s) : restore session", myWebem->GetPort().c_str(), session.id.c_str(), session.auth_token.c_str(), session.username.c_str());
 					myWebem->AddSession(session);
@@ -2567,7 +2614,7 @@ namespace http {
 					if (rep.status == reply::status_type::download_file)
 						return;
 
-					if (!rep.bIsGZIP)
+					if ((!rep.bIsGZIP) && (rep.status != reply::not_modified))
 					{
 						CompressWebOutput(req, rep);
 					}
@@ -2622,26 +2669,26 @@ namespace http {
 				)
 			{
 				// client is possibly a script that does not send cookies - see if we have the IP address registered as a session ID
-				WebEmSession* memSession = myWebem->GetSession(session.remote_host);
+				WebEmSession memSession;
 				time_t now = mytime(nullptr);
-				if (memSession != nullptr)
+				if (myWebem->GetSession(session.remote_host, memSession))
 				{
-					if (memSession->expires < now)
+					if (memSession.expires < now)
 					{
 						myWebem->RemoveSession(session.remote_host);
 					}
 					else
 					{
 						session.isnew = false;
-						if (memSession->expires - (SHORT_SESSION_TIMEOUT / 2) < now)
+						if (memSession.expires - (SHORT_SESSION_TIMEOUT / 2) < now)
 						{
-							memSession->expires = now + SHORT_SESSION_TIMEOUT;
-
 							// unsure about the point of the forced removal of 'live' sessions and restore from
 							// database but these 'fake' sessions are memory only and can't be restored that way.
-							// Should I do a RemoveSession() followed by a AddSession()?
 							// For now: keep 'timeout' in sync with 'expires'
-							memSession->timeout = memSession->expires;
+							myWebem->UpdateSession(memSession.id, [now](WebEmSession &stored) {
+								stored.expires = now + SHORT_SESSION_TIMEOUT;
+								stored.timeout = stored.expires;
+							});
 						}
 					}
 				}
@@ -2676,23 +2723,31 @@ namespace http {
 			else if (!session.id.empty())
 			{
 				// Renew session expiration and authentication token
-				WebEmSession* memSession = myWebem->GetSession(session.id);
-				if (memSession != nullptr)
+				WebEmSession memSession;
+				if (myWebem->GetSession(session.id, memSession))
 				{
 					time_t now = mytime(nullptr);
 					// Renew session expiration date if half of session duration has been exceeded ("dont remember me" sessions, 10 minutes)
-					if (memSession->expires - (SHORT_SESSION_TIMEOUT / 2) < now)
+					bool bRenew = false;
+					if (memSession.expires - (SHORT_SESSION_TIMEOUT / 2) < now)
 					{
-						memSession->expires = now + SHORT_SESSION_TIMEOUT;
-						memSession->auth_token = generateAuthToken(*memSession, req); // do it after expires to save it also
-						send_cookie(rep, *memSession);
+						memSession.expires = now + SHORT_SESSION_TIMEOUT;
+						bRenew = true;
 					}
 					// Renew session expiration date if half of session duration has been exceeded ("remember me" sessions, 30 days)
-					else if ((memSession->expires > SHORT_SESSION_TIMEOUT + now) && (memSession->expires - (LONG_SESSION_TIMEOUT / 2) < now))
+					else if ((memSession.expires > SHORT_SESSION_TIMEOUT + now) && (memSession.expires - (LONG_SESSION_TIMEOUT / 2) < now))
+					{
+						memSession.expires = now + LONG_SESSION_TIMEOUT;
+						bRenew = true;
+					}
+					if (bRenew)
 					{
-						memSession->expires = now + LONG_SESSION_TIMEOUT;
-						memSession->auth_token = generateAuthToken(*memSession, req); // do it after expires to save it also
-						send_cookie(rep, *memSession);
+						memSession.auth_token = generateAuthToken(memSession, req); // do it after expires to save it also
+						myWebem->UpdateSession(memSession.id, [&memSession](WebEmSession &stored) {
+							stored.expires = memSession.expires;
+							stored.auth_token = memSession.auth_token;
+						});
+						send_cookie(rep, memSession);
 					}
 				}
 			}
@@ -201,10 +201,13 @@ namespace http
 			bool findRealHostBehindProxies(const request &req, std::string &realhost);
 
 			void ClearUserPasswords();
-			std::vector<_tWebUserPassword> m_userpasswords;
+			//Snapshots, a reload replaces the lists while requests are handled on other threads.
+			//Keep the returned pointer while iterating.
+			std::shared_ptr<const std::vector<_tWebUserPassword>> GetUserPasswords();
+			bool HasUserPasswords();
 			void AddTrustedNetworks(std::string network);
 			void ClearTrustedNetworks();
-			std::vector<_tIPNetwork> m_localnetworks;
+			std::shared_ptr<const std::vector<_tIPNetwork>> GetTrustedNetworks();
 			void SetDigistRealm(const std::string &realm);
 			std::string m_DigistRealm;
 			void SetAllowPlainBasicAuth(const bool bAllow);
@@ -218,8 +221,10 @@ namespace http
 			std::string m_zippassword;
 			std::string GetPort();
 			std::string GetWebRoot();
-			WebEmSession *GetSession(const std::string &ssid);
+			bool GetSession(const std::string &ssid, WebEmSession &session);
 			void AddSession(const WebEmSession &session);
+			//Changes a stored session in place, returns false when there is no such session
+			bool UpdateSession(const std::string &ssid, const std::function<void(WebEmSession &session)> &update);
 			void RemoveSession(const WebEmSession &session);
 			void RemoveSession(const std::string &ssid);
 			std::vector<std::string> GetExpiredSessions();
@@ -264,6 +269,10 @@ namespace http
 			std::string m_webRoot;
 			/// sessions management
 			std::mutex m_sessionsMutex;
+			/// users and trusted networks
+			std::shared_ptr<const std::vector<_tWebUserPassword>> m_userpasswords = std::make_shared<const std::vector<_tWebUserPassword>>();
+			std::shared_ptr<const std::vector<_tIPNetwork>> m_localnetworks = std::make_shared<const std::vector<_tIPNetwork>>();
+			std::mutex m_usersMutex;
 			boost::asio::io_service m_io_service;
 			boost::asio::deadline_timer m_session_clean_timer;
 			std::shared_ptr<std::thread> m_io_service_thread;
@@ -25,6 +25,7 @@ namespace http {
 		// this is the constructor for plain connections
 		connection::connection(boost::asio::io_service &io_service, connection_manager &manager, request_handler &handler, int read_timeout)
 			: send_buffer_(nullptr)
+			, strand_(io_service)
 			, read_timeout_(read_timeout)
 			, read_timer_(io_service, boost::posix_time::seconds(read_timeout))
 			, default_abandoned_timeout_(20 * 60)
@@ -47,6 +48,7 @@ namespace http {
 		// this is the constructor for secure connections
 		connection::connection(boost::asio::io_service &io_service, connection_manager &manager, request_handler &handler, int read_timeout, boost::asio::ssl::context &context)
 			: send_buffer_(nullptr)
+			, strand_(io_service)
 			, read_timeout_(read_timeout)
 			, read_timer_(io_service, boost::posix_time::seconds(read_timeout))
 			, default_abandoned_timeout_(20 * 60)
@@ -85,6 +87,11 @@ namespace http {
 #endif
 
 		void connection::start()
+		{
+			boost::asio::dispatch(strand_, [self = shared_from_this()] { self->handle_start(); });
+		}
+
+		void connection::handle_start()
 		{
 			boost::system::error_code ec;
 			boost::asio::ip::tcp::endpoint remote_endpoint = socket().remote_endpoint(ec);
@@ -115,7 +122,7 @@ namespace http {
 #ifdef WWW_ENABLE_SSL
 				status_ = WAITING_HANDSHAKE;
 				// with ssl, we first need to complete the handshake before reading
-				sslsocket_->async_handshake(boost::asio::ssl::stream_base::server, [self = shared_from_this()](auto &&err) { self->handle_handshake(err); });
+				sslsocket_->async_handshake(boost::asio::ssl::stream_base::server, boost::asio::bind_executor(strand_, [self = shared_from_this()](auto &&err) { self->handle_handshake(err); }));
 #endif
 			}
 			else {
@@ -125,6 +132,11 @@ namespace http {
 		}
 
 		void connection::stop()
+		{
+			boost::asio::dispatch(strand_, [self = shared_from_this()] { self->handle_stop(); });
+		}
+
+		void connection::handle_stop()
 		{
 			switch (connection_type) {
 			case ConnectionType::connection_websocket:
@@ -209,12 +221,12 @@ namespace http {
 			if (secure_) {
 #ifdef WWW_ENABLE_SSL
 				// Perform secure read
-				sslsocket_->async_read_some(buf, [self = shared_from_this()](auto &&err, auto bytes) { self->handle_read(err, bytes); });
+				sslsocket_->async_read_some(buf, boost::asio::bind_executor(strand_, [self = shared_from_this()](auto &&err, auto bytes) { self->handle_read(err, bytes); }));
 #endif
 			}
 			else {
 				// Perform plain read
-				socket_->async_read_some(buf, [self = shared_from_this()](auto &&err, auto bytes) { self->handle_read(err, bytes); });
+				socket_->async_read_some(buf, boost::asio::bind_executor(strand_, [self = shared_from_this()](auto &&err, auto bytes) { self->handle_read(err, bytes); }));
 			}
 		}
 
@@ -228,17 +240,30 @@ namespace http {
 			write_buffer = buf;
 			if (secure_) {
 #ifdef WWW_ENABLE_SSL
-				boost::asio::async_write(*sslsocket_, boost::asio::buffer(write_buffer), [self = shared_from_this()](auto &&err, auto bytes) { self->handle_write(err, bytes); });
+				boost::asio::async_write(*sslsocket_, boost::asio::buffer(write_buffer), boost::asio::bind_executor(strand_, [self = shared_from_this()](auto &&err, auto bytes) { self->handle_write(err, bytes); }));
 #endif
 			}
 			else {
-				boost::asio::async_write(*socket_, boost::asio::buffer(write_buffer), [self = shared_from_this()](auto &&err, auto bytes) { self->handle_write(err, bytes); });
+				boost::asio::async_write(*socket_, boost::asio::buffer(write_buffer), boost::asio::bind_executor(strand_, [self = shared_from_this()](auto &&err, auto bytes) { self->handle_write(err, bytes); }));
 			}
 
 		}
 
 		void connection::WS_Write(const std::string& resp)
 		{
+			if (!strand_.running_in_this_thread())
+			{
+				// Pushed from another thread, continue on the strand of this connection
+				try
+				{
+					boost::asio::post(strand_, [self = shared_from_this(), resp] { self->WS_Write(resp); });
+				}
+				catch (std::bad_weak_ptr &)
+				{
+					// connection is being destroyed
+				}
+				return;
+			}
 			if (connection_type == ConnectionType::connection_websocket) {
 				MyWrite(CWebsocketFrame::Create(opcode_text, resp, false));
 			}
@@ -251,6 +276,19 @@ namespace http {
 
 		void connection::MyWrite(const std::string& buf)
 		{
+			if (!strand_.running_in_this_thread())
+			{
+				// Pushed from another thread, continue on the strand of this connection
+				try
+				{
+					boost::asio::post(strand_, [self = shared_from_this(), buf] { self->MyWrite(buf); });
+				}
+				catch (std::bad_weak_ptr &)
+				{
+					// connection is being destroyed
+				}
+				return;
+			}
 			switch (connection_type) {
 			case ConnectionType::connection_http:
 			case ConnectionType::connection_websocket:
@@ -282,12 +320,12 @@ namespace http {
 				if (secure_) {
 #ifdef WWW_ENABLE_SSL
 					boost::asio::async_write(*sslsocket_, boost::asio::buffer(*send_buffer_, bread),
-								 [self = shared_from_this()](auto &&err, auto bytes) { self->handle_write_file(err, bytes); });
+								 boost::asio::bind_executor(strand_, [self = shared_from_this()](auto &&err, auto bytes) { self->handle_write_file(err, bytes); }));
 #endif
 				}
 				else {
 					boost::asio::async_write(*socket_, boost::asio::buffer(*send_buffer_, bread),
-								 [self = shared_from_this()](auto &&err, auto bytes) { self->handle_write_file(err, bytes); });
+								 boost::asio::bind_executor(strand_, [self = shared_from_this()](auto &&err, auto bytes) { self->handle_write_file(err, bytes); }));
 				}
 				return;
 			}
@@ -339,11 +377,11 @@ namespace http {
 
 			if (secure_) {
 #ifdef WWW_ENABLE_SSL
-				boost::asio::async_write(*sslsocket_, boost::asio::buffer(write_buffer), [self = shared_from_this()](auto &&err, auto bytes) { self->handle_write_file(err, bytes); });
+				boost::asio::async_write(*sslsocket_, boost::asio::buffer(write_buffer), boost::asio::bind_executor(strand_, [self = shared_from_this()](auto &&err, auto bytes) { self->handle_write_file(err, bytes); }));
 #endif
 			}
 			else {
-				boost::asio::async_write(*socket_, boost::asio::buffer(write_buffer), [self = shared_from_this()](auto &&err, auto bytes) { self->handle_write_file(err, bytes); });
+				boost::asio::async_write(*socket_, boost::asio::buffer(write_buffer), boost::asio::bind_executor(strand_, [self = shared_from_this()](auto &&err, auto bytes) { self->handle_write_file(err, bytes); }));
 			}
 			return true;
 		}
@@ -602,7 +640,7 @@ namespace http {
 		// schedule read timeout timer
 		void connection::set_read_timeout() {
 			read_timer_.expires_from_now(boost::posix_time::seconds(read_timeout_));
-			read_timer_.async_wait([self = shared_from_this()](auto &&err) { self->handle_read_timeout(err); });
+			read_timer_.async_wait(boost::asio::bind_executor(strand_, [self = shared_from_this()](auto &&err) { self->handle_read_timeout(err); }));
 		}
 
 		/// simply cancel read timeout timer
@@ -645,7 +683,7 @@ namespace http {
 		/// schedule abandoned timeout timer
 		void connection::set_abandoned_timeout() {
 			abandoned_timer_.expires_from_now(boost::posix_time::seconds(default_abandoned_timeout_));
-			abandoned_timer_.async_wait([self = shared_from_this()](auto &&err) { self->handle_abandoned_timeout(err); });
+			abandoned_timer_.async_wait(boost::asio::bind_executor(strand_, [self = shared_from_this()](auto &&err) { self->handle_abandoned_timeout(err); }));
 		}
 
 		/// simply cancel abandoned timeout timer
@@ -65,6 +65,12 @@ namespace http {
 			/// Stop all asynchronous operations associated with the connection.
 			void stop();
 
+			/// All handlers of the connection run through this strand.
+			boost::asio::io_service::strand& get_strand()
+			{
+				return strand_;
+			}
+
 			// send packet over websocket
 			void WS_Write(const std::string& packet_data);
 			/// Add content to write buffer
@@ -77,6 +83,10 @@ namespace http {
 			void handle_abandoned_timeout(const boost::system::error_code& error);
 
 		private:
+			/// start() and stop() continue here on the strand
+			void handle_start();
+			void handle_stop();
+
 			/// Handle completion of a read operation.
 			void handle_read(const boost::system::error_code& e, std::size_t bytes_transferred);
 			void read_more();
@@ -111,6 +121,9 @@ namespace http {
 			/// Reschedule abandoned timeout timer
 			void reset_abandoned_timeout();
 
+			/// Serializes the handlers of this connection when the io_service is run by several threads.
+			boost::asio::io_service::strand strand_;
+
 			/// Socket for the (PLAIN) connection.
 			std::unique_ptr<boost::asio::ip::tcp::socket> socket_;
 			//Host EndPoints
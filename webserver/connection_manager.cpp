@@ -18,23 +18,35 @@ namespace server {
 
 	void connection_manager::start(const connection_ptr &c)
 	{
-		connections_.insert(c);
+		{
+			std::unique_lock<std::mutex> lock(connections_mutex_);
+			connections_.insert(c);
+		}
 		c->start();
 	}
 
 	void connection_manager::stop(const connection_ptr &c)
 	{
-		connections_.erase(c);
+		{
+			std::unique_lock<std::mutex> lock(connections_mutex_);
+			connections_.erase(c);
+		}
 		c->stop();
 	}
 
-void connection_manager::stop_all()
+void connection_manager::stop_all(const std::function<void()> &on_stopped)
 {
-	for (const auto &con : connections_)
+	std::set<connection_ptr> connections;
 	{
-		con->stop();
+		std::unique_lock<std::mutex> lock(connections_mutex_);
+		connections.swap(connections_);
+	}
+	// Each stop runs on the strand of its connection, the last one to finish releases the guard
+	std::shared_ptr<void> guard(nullptr, [on_stopped](void *) { on_stopped(); });
+	for (const auto &con : connections)
+	{
+		boost::asio::dispatch(con->get_strand(), [con, guard] { con->stop(); });
 	}
-	connections_.clear();
 }
 
 
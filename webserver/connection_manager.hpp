@@ -11,6 +11,8 @@
 #ifndef HTTP_CONNECTION_MANAGER_HPP
 #define HTTP_CONNECTION_MANAGER_HPP
 
+#include <functional>
+#include <mutex>
 #include <set>
 #include "../main/Noncopyable.h"
 #include "connection.hpp"
@@ -30,11 +32,12 @@ public:
   /// Stop the specified connection.
   void stop(const connection_ptr &c);
 
-  /// Stop all connections.
-  void stop_all();
+  /// Stop all connections, on_stopped is called once every connection has been stopped.
+  void stop_all(const std::function<void()> &on_stopped);
 private:
-  /// The managed connections.
+  /// The managed connections (started and stopped from several io threads).
   std::set<connection_ptr> connections_;
+  std::mutex connections_mutex_;
 };
 
 } // namespace server
@@ -15,6 +15,7 @@ namespace server {
 
 	server_base::server_base(const server_settings &settings, request_handler &user_request_handler)
 		: io_service_()
+		, strand_(io_service_)
 		, acceptor_(io_service_)
 		, request_handler_(user_request_handler)
 		, settings_(settings)
@@ -56,7 +57,7 @@ namespace server {
 		acceptor_.listen();
 
 		// start the accept thread
-		acceptor_.async_accept(new_connection_->socket(), accept_handler);
+		acceptor_.async_accept(new_connection_->socket(), boost::asio::bind_executor(strand_, accept_handler));
 	}
 
 void server_base::run() {
@@ -66,12 +67,16 @@ void server_base::run() {
 	// for new incoming connections.
 	try {
 		is_running = true;
-		heart_beat(boost::system::error_code());
+		boost::asio::dispatch(strand_, [this] { heart_beat(boost::system::error_code()); });
+		start_workers();
 		io_service_.run();
+		stop_workers();
 		is_running = false;
 	} catch (std::exception& e) {
 		_log.Log(LOG_ERROR, "[web:%s] exception occurred : '%s' (need to run again)", settings_.listening_port.c_str(), e.what());
 		is_running = false;
+		io_service_.stop();
+		stop_workers();
 		// Note: if acceptor is up everything is OK, we can call run() again
 		//       but if the exception has broken the acceptor we cannot stop/start it and the next run() will exit immediatly.
 		io_service_.reset(); // this call is needed before calling run() again
@@ -79,6 +84,8 @@ void server_base::run() {
 	} catch (...) {
 		_log.Log(LOG_ERROR, "[web:%s] unknown exception occurred (need to run again)", settings_.listening_port.c_str());
 		is_running = false;
+		io_service_.stop();
+		stop_workers();
 		// Note: if acceptor is up everything is OK, we can call run() again
 		//       but if the exception has broken the acceptor we cannot stop/start it and the next run() will exit immediatly.
 		io_service_.reset(); // this call is needed before calling run() again
@@ -86,6 +93,41 @@ void server_base::run() {
 	}
 }
 
+void server_base::start_workers() {
+	for (int ii = 1; ii < settings_.threads; ii++)
+	{
+		workers_.emplace_back([this] {
+			for (;;)
+			{
+				// An exception thrown by a handler only ends that handler, keep serving the other connections
+				try
+				{
+					io_service_.run();
+					break;
+				}
+				catch (std::exception &e)
+				{
+					_log.Log(LOG_ERROR, "[web:%s] exception occurred : '%s'", settings_.listening_port.c_str(), e.what());
+				}
+				catch (...)
+				{
+					_log.Log(LOG_ERROR, "[web:%s] unknown exception occurred", settings_.listening_port.c_str());
+				}
+			}
+		});
+		SetThreadName(workers_.back().native_handle(), "WebServerIO");
+	}
+}
+
+void server_base::stop_workers() {
+	for (auto &worker : workers_)
+	{
+		if (worker.joinable())
+			worker.join();
+	}
+	workers_.clear();
+}
+
 /// Ask the server to stop using asynchronous command
 void server_base::stop() {
 	if (is_running) {
@@ -93,10 +135,12 @@ void server_base::stop() {
 		// Rene, set is_running to false, because the following is an io_service call, which makes is_running
 		// never set to false whilst in the call itself
 		is_running = false;
-		io_service_.post([this] { handle_stop(); });
+		boost::asio::post(strand_, [this] { handle_stop(); });
 	} else {
 		// if io_service is not running then the post call will not be performed
 		handle_stop();
+		// neither will the stop of the connections, they are closed when they are destroyed
+		is_stop_complete = true;
 	}
 
 	// Wait for acceptor and connections to stop
@@ -126,8 +170,8 @@ void server_base::handle_stop() {
 	} catch (...) {
 		_log.Log(LOG_ERROR, "[web:%s] exception occurred while closing acceptor", settings_.listening_port.c_str());
 	}
-	connection_manager_.stop_all();
-	is_stop_complete = true;
+	// the connections are stopped on their own strand, the stop is complete when the last one is done
+	connection_manager_.stop_all([this] { is_stop_complete = true; });
 }
 
 void server_base::heart_beat(const boost::system::error_code& error)
@@ -138,7 +182,7 @@ void server_base::heart_beat(const boost::system::error_code& error)
 
 		// Schedule next heartbeat
 		m_heartbeat_timer.expires_from_now(std::chrono::seconds(4));
-		m_heartbeat_timer.async_wait([this](auto &&err) { heart_beat(err); });
+		m_heartbeat_timer.async_wait(boost::asio::bind_executor(strand_, [this](auto &&err) { heart_beat(err); }));
 	}
 }
 
@@ -161,7 +205,7 @@ void server::handle_accept(const boost::system::error_code& e) {
 		new_connection_.reset(new connection(io_service_,
 				connection_manager_, request_handler_, timeout_));
 		// listen for a subsequent request
-		acceptor_.async_accept(new_connection_->socket(), [this](auto &&err) { handle_accept(err); });
+		acceptor_.async_accept(new_connection_->socket(), boost::asio::bind_executor(strand_, [this](auto &&err) { handle_accept(err); }));
 	}
 }
 
@@ -317,7 +361,7 @@ void ssl_server::handle_accept(const boost::system::error_code& e) {
 		connection_manager_.start(new_connection_);
 		reinit_connection();
 		// listen for a subsequent request
-		acceptor_.async_accept(new_connection_->socket(), [this](auto &&err) { handle_accept(err); });
+		acceptor_.async_accept(new_connection_->socket(), boost::asio::bind_executor(strand_, [this](auto &&err) { handle_accept(err); }));
 	}
 }
 
@@ -8,7 +8,10 @@
 
 #include <boost/asio.hpp>
 #include <boost/asio/steady_timer.hpp>
+#include <atomic>
 #include <string>
+#include <thread>
+#include <vector>
 #include "../main/Noncopyable.h"
 #include "connection_manager.hpp"
 #include "request_handler.hpp"
@@ -31,7 +34,7 @@ namespace http
 			explicit server_base(const server_settings &settings, request_handler &user_request_handler);
 			virtual ~server_base() = default;
 
-			/// Run the server's io_service loop.
+			/// Run the server's io_service loop (on the calling thread and settings.threads - 1 worker threads).
 			void run();
 
 			/// Stop the server.
@@ -49,6 +52,9 @@ namespace http
 			/// The io_service used to perform asynchronous operations.
 			boost::asio::io_service io_service_;
 
+			/// Serializes the acceptor, heartbeat and stop handlers, connections have their own strand.
+			boost::asio::io_service::strand strand_;
+
 			/// Acceptor used to listen for incoming connections.
 			boost::asio::ip::tcp::acceptor acceptor_;
 
@@ -66,15 +72,20 @@ namespace http
 			int timeout_;
 
 			/// indicate if the server is running
-			bool is_running;
+			std::atomic<bool> is_running;
 
 			/// indicate if the server is stopped (acceptor and connections)
-			bool is_stop_complete;
+			std::atomic<bool> is_stop_complete;
 
 		      private:
 			/// Handle a request to stop the server.
 			void handle_stop();
 
+			/// Additional threads running io_service_
+			void start_workers();
+			void stop_workers();
+			std::vector<std::thread> workers_;
+
 			boost::asio::steady_timer m_heartbeat_timer;
 			void heart_beat(const boost::system::error_code &error);
 		};
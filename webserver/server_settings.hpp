@@ -41,6 +41,9 @@ public:
 		listening_port = get_valid_value(listening_port, settings.listening_port);
 		vhostname = get_valid_value(vhostname, settings.vhostname);
 		php_cgi_path = get_valid_value(php_cgi_path, settings.php_cgi_path);
+		if (settings.threads > 0) {
+			threads = settings.threads;
+		}
 		if (listening_port == "0") {
 			listening_port.clear();// server NOT enabled
 		}
@@ -53,6 +56,7 @@ public:
 			", listening_port='" + listening_port + "'" +
 			", vhostname='" + vhostname + "'" +
 			", php_cgi_path='" + php_cgi_path + "'" +
+			", threads=" + std::to_string(threads) +
 			"]'";
 	}
 
@@ -73,6 +77,8 @@ public:
 	std::string listening_port;
 
 	std::string php_cgi_path; //if not empty, php files are handled
+
+	int threads{ 4 }; //number of threads running the io_service of the server
 	//feature
 	//std::string fastcgi_php_server; (like nginx)
 private: